@@ -32,6 +32,7 @@ MCU_EXCLUDES = \
             drivers/serial_uart.c \
             drivers/serial_uart_init.c \
             drivers/serial_uart_pinconfig.c \
+            drivers/serial_uart_tx.c \
             drivers/rx/rx_xn297.c \
             drivers/display_ug2864hsweg01.c \
             telemetry/crsf.c \
@@ -53,6 +54,17 @@ LD_FLAGS    := \
               -Wl,--cref \
               -T$(LD_SCRIPT)
 
+# LOCKSTEP=yes runs in lockstep with the simulator or replays a log, see the SITL README
+ifeq ($(LOCKSTEP),yes)
+CFLAGS          += -DSIMULATOR_LOCKSTEP
+endif
+
+# GPROF=yes builds for gprof, the profile is written to gmon.out when the SITL is rebooted from the cli
+ifeq ($(GPROF),yes)
+CFLAGS          += -pg
+LD_FLAGS        += -pg
+endif
+
 ifneq ($(filter SITL_STATIC,$(OPTIONS)),)
 LD_FLAGS     += \
               -static \
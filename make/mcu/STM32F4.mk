@@ -170,10 +170,12 @@ MCU_COMMON_SRC = \
             drivers/bus_i2c_stm32f10x.c \
             drivers/bus_spi_stdperiph.c \
             drivers/dma_stm32f4xx.c \
+            drivers/dma_reqmap.c \
             drivers/inverter.c \
             drivers/light_ws2811strip_stdperiph.c \
             drivers/transponder_ir_io_stdperiph.c \
             drivers/pwm_output_dshot.c \
+            drivers/dshot_bitbang.c \
             drivers/serial_uart_init.c \
             drivers/serial_uart_stm32f4xx.c \
             drivers/system_stm32f4xx.c \
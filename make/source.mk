@@ -1,6 +1,9 @@
 COMMON_SRC = \
             build/build_config.c \
+            build/crash_trace.c \
             build/debug.c \
+            build/motor_timing.c \
+            build/profiler.c \
             build/version.c \
             $(TARGET_DIR_SRC) \
             main.c \
@@ -28,8 +31,10 @@ COMMON_SRC = \
             drivers/serial_pinconfig.c \
             drivers/serial_uart.c \
             drivers/serial_uart_pinconfig.c \
+            drivers/serial_uart_tx.c \
             drivers/sound_beeper.c \
             drivers/stack_check.c \
+            drivers/swi.c \
             drivers/system.c \
             drivers/timer_common.c \
             drivers/timer.c \
@@ -88,6 +93,7 @@ FC_SRC = \
             flight/mixer.c \
             flight/mixer_tricopter.c \
             flight/pid.c \
+            flight/rpm_filter.c \
             flight/servos.c \
             flight/servos_tricopter.c \
             interface/cli.c \
@@ -152,6 +158,7 @@ FC_SRC = \
             sensors/barometer.c \
             sensors/rangefinder.c \
             telemetry/telemetry.c \
+            telemetry/telemetry_scheduler.c \
             telemetry/crsf.c \
             telemetry/srxl.c \
             telemetry/frsky_hub.c \
@@ -231,6 +238,7 @@ SPEED_OPTIMISED_SRC := $(SPEED_OPTIMISED_SRC) \
             flight/imu.c \
             flight/mixer.c \
             flight/pid.c \
+            flight/rpm_filter.c \
             rx/ibus.c \
             rx/rx.c \
             rx/rx_spi.c \
@@ -325,7 +333,8 @@ SPEED_OPTIMISED_SRC := $(SPEED_OPTIMISED_SRC) \
             drivers/bus_spi_ll.c \
             drivers/max7456.c \
             drivers/pwm_output_dshot.c \
-            drivers/pwm_output_dshot_hal.c
+            drivers/pwm_output_dshot_hal.c \
+            drivers/dshot_bitbang.c
 endif #!F3
 endif #!F1
 
@@ -34,11 +34,13 @@
 
 #include "build/build_config.h"
 #include "build/debug.h"
+#include "build/motor_timing.h"
 #include "build/version.h"
 
 #include "common/axis.h"
 #include "common/encoding.h"
 #include "common/maths.h"
+#include "common/printf.h"
 #include "common/time.h"
 #include "common/utils.h"
 
@@ -49,6 +51,7 @@
 
 #include "drivers/compass/compass.h"
 #include "drivers/sensor.h"
+#include "drivers/swi.h"
 #include "drivers/time.h"
 
 #include "fc/config.h"
@@ -69,6 +72,8 @@
 
 #include "rx/rx.h"
 
+#include "scheduler/scheduler.h"
+
 #include "sensors/acceleration.h"
 #include "sensors/barometer.h"
 #include "sensors/battery.h"
@@ -84,13 +89,17 @@
 #define DEFAULT_BLACKBOX_DEVICE     BLACKBOX_DEVICE_SERIAL
 #endif
 
-PG_REGISTER_WITH_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig, PG_BLACKBOX_CONFIG, 1);
+PG_REGISTER_WITH_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig, PG_BLACKBOX_CONFIG, 7);
 
 PG_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig,
     .p_ratio = 32,
     .device = DEFAULT_BLACKBOX_DEVICE,
     .record_acc = 1,
-    .mode = BLACKBOX_MODE_NORMAL
+    .mode = BLACKBOX_MODE_NORMAL,
+    .field_rate_denom = { 1, 1, 1, 1, 1 },
+    .binary_header = 0,
+    .async = 0,
+    .adaptive_rate = 0
 );
 
 #define BLACKBOX_SHUTDOWN_TIMEOUT_MILLIS 200
@@ -257,7 +266,40 @@ static const blackboxSimpleFieldDefinition_t blackboxSlowFields[] = {
 
     {"failsafePhase",         -1, UNSIGNED, PREDICT(0),      ENCODING(TAG2_3S32)},
     {"rxSignalReceived",      -1, UNSIGNED, PREDICT(0),      ENCODING(TAG2_3S32)},
-    {"rxFlightChannelsValid", -1, UNSIGNED, PREDICT(0),      ENCODING(TAG2_3S32)}
+    {"rxFlightChannelsValid", -1, UNSIGNED, PREDICT(0),      ENCODING(TAG2_3S32)},
+#ifdef USE_RX_LINK_STATS
+    // frames and frame errors of the last complete second
+    {"rxLinkFrames",          -1, UNSIGNED, PREDICT(0),      ENCODING(UNSIGNED_VB)},
+    {"rxLinkErrors",          -1, UNSIGNED, PREDICT(0),      ENCODING(UNSIGNED_VB)},
+#endif
+};
+
+#ifdef USE_SCHEDULER_TRACE
+// Scheduler trace, one frame per task run
+static const blackboxSimpleFieldDefinition_t blackboxSchedulerTraceFields[] = {
+    {"traceTask",             -1, UNSIGNED, PREDICT(0),      ENCODING(UNSIGNED_VB)},
+    {"traceTime",             -1, UNSIGNED, PREDICT(0),      ENCODING(UNSIGNED_VB)},
+    {"traceDuration",         -1, UNSIGNED, PREDICT(0),      ENCODING(UNSIGNED_VB)},
+    {"traceLateness",         -1, SIGNED,   PREDICT(0),      ENCODING(SIGNED_VB)}
+};
+
+// Limits the log bandwidth taken by the trace, entries that could not be logged in time are skipped
+#define BLACKBOX_SCHEDULER_TRACE_FRAMES_PER_ITERATION 4
+#endif
+
+/*
+ * Every gyro sample, independent of the main frame rate. Each field is predicted from the previous 'R' frames written.
+ * At the gyro rate the gyro is sampled densely enough to be extrapolated, and the raw gyro is closest to the filtered
+ * one plus its recent noise, which is why the filtered gyro comes first.
+ */
+static const blackboxSimpleFieldDefinition_t blackboxGyroHighRateFields[] = {
+    {"time",                  -1, UNSIGNED, PREDICT(STRAIGHT_LINE), ENCODING(SIGNED_VB)},
+    {"gyroFilt",               0, SIGNED,   PREDICT(SECOND_ORDER),  ENCODING(SIGNED_VB)},
+    {"gyroFilt",               1, SIGNED,   PREDICT(SECOND_ORDER),  ENCODING(SIGNED_VB)},
+    {"gyroFilt",               2, SIGNED,   PREDICT(SECOND_ORDER),  ENCODING(SIGNED_VB)},
+    {"gyroRaw",                0, SIGNED,   PREDICT(GYRO_FILTERED), ENCODING(SIGNED_VB)},
+    {"gyroRaw",                1, SIGNED,   PREDICT(GYRO_FILTERED), ENCODING(SIGNED_VB)},
+    {"gyroRaw",                2, SIGNED,   PREDICT(GYRO_FILTERED), ENCODING(SIGNED_VB)}
 };
 
 typedef enum BlackboxState {
@@ -265,10 +307,13 @@ typedef enum BlackboxState {
     BLACKBOX_STATE_STOPPED,
     BLACKBOX_STATE_PREPARE_LOG_FILE,
     BLACKBOX_STATE_SEND_HEADER,
+    BLACKBOX_STATE_SEND_BINARY_HEADER,
     BLACKBOX_STATE_SEND_MAIN_FIELD_HEADER,
     BLACKBOX_STATE_SEND_GPS_H_HEADER,
     BLACKBOX_STATE_SEND_GPS_G_HEADER,
     BLACKBOX_STATE_SEND_SLOW_HEADER,
+    BLACKBOX_STATE_SEND_SCHEDULER_TRACE_HEADER,
+    BLACKBOX_STATE_SEND_GYRO_HIGH_RATE_HEADER,
     BLACKBOX_STATE_SEND_SYSINFO,
     BLACKBOX_STATE_PAUSED,
     BLACKBOX_STATE_RUNNING,
@@ -321,6 +366,10 @@ typedef struct blackboxSlowState_s {
     uint8_t failsafePhase;
     bool rxSignalReceived;
     bool rxFlightChannelsValid;
+#ifdef USE_RX_LINK_STATS
+    uint16_t rxLinkFrames;
+    uint16_t rxLinkErrors;
+#endif
 } __attribute__((__packed__)) blackboxSlowState_t; // We pack this struct so that padding doesn't interfere with memcmp()
 
 //From rc_controls.c
@@ -360,6 +409,84 @@ STATIC_UNIT_TESTED int16_t blackboxPInterval = 0;
 STATIC_UNIT_TESTED int32_t blackboxSInterval = 0;
 STATIC_UNIT_TESTED int32_t blackboxSlowFrameIterationTimer;
 static bool blackboxLoggedAnyFrames;
+#ifdef USE_SCHEDULER_TRACE
+static uint32_t blackboxSchedulerTraceSequence; // next scheduler trace entry to log
+#endif
+static uint16_t blackboxMainFrameIndex; // main frames written since the last I frame
+
+/*
+ * With blackbox_adaptive_rate the P interval is stepped by powers of two, between the configured one and the
+ * I interval, to keep the log below the throughput the device sustains. The throughput is what the device took in a
+ * window in which it refused writes. A slower rate is tried again after a run of windows without drops, the run
+ * needed doubles each time the faster rate fails.
+ */
+#define BLACKBOX_ADAPTIVE_RATE_WINDOW_MS            1000
+#define BLACKBOX_ADAPTIVE_RATE_MARGIN_PERCENT       80  // share of the throughput the log may use
+#define BLACKBOX_ADAPTIVE_RATE_RECOVER_WINDOWS      5
+#define BLACKBOX_ADAPTIVE_RATE_RECOVER_WINDOWS_MAX  60
+
+static int16_t blackboxPIntervalConfigured;
+static volatile int16_t blackboxPIntervalTarget; // taken up by the iteration timers at the next I frame
+static int16_t blackboxPIntervalLogged;
+static struct {
+    bool started;
+    bool probing;               // the current rate was raised in the last window
+    uint8_t cleanWindows;
+    uint8_t recoverWindows;
+    timeMs_t windowStartMs;
+    uint32_t bytesWritten;
+    uint32_t bytesDropped;
+    uint32_t throughput;        // bytes per second
+} blackboxAdaptiveRate;
+
+static void blackboxAdaptiveRateReset(void)
+{
+    blackboxPInterval = blackboxPIntervalConfigured;
+    blackboxPIntervalTarget = blackboxPIntervalConfigured;
+    blackboxPIntervalLogged = blackboxPIntervalConfigured;
+    memset(&blackboxAdaptiveRate, 0, sizeof(blackboxAdaptiveRate));
+    blackboxAdaptiveRate.recoverWindows = BLACKBOX_ADAPTIVE_RATE_RECOVER_WINDOWS;
+}
+static gyroSampleReader_t blackboxGyroSampleReader;
+static struct {
+    uint32_t time[2];
+    int32_t gyroFilt[3][XYZ_AXIS_COUNT];
+    int32_t gyroNoise[3][XYZ_AXIS_COUNT]; // raw minus filtered gyro
+} blackboxGyroHighRateHistory; // values of the last 'R' frames written, newest first
+
+#ifdef USE_BLACKBOX_ASYNC
+/*
+ * With blackbox_async the PID loop only copies the main state of each due frame into this queue, the encoding
+ * and device I/O is done by TASK_BLACKBOX. The PID loop is the only writer of the head, the task the only writer
+ * of the tail. When the task falls behind, frames are dropped until the next I frame so that every P frame
+ * written is predicted from the frame that precedes it in the log.
+ */
+#define BLACKBOX_ASYNC_QUEUE_SIZE 16 // must be a power of 2
+
+typedef struct blackboxQueuedFrame_s {
+    blackboxMainState_t state;
+    bool intraframe;
+    int16_t pInterval; // P interval that follows an I frame
+} blackboxQueuedFrame_t;
+
+static blackboxQueuedFrame_t blackboxAsyncQueue[BLACKBOX_ASYNC_QUEUE_SIZE];
+static volatile uint32_t blackboxAsyncQueueHead;
+static volatile uint32_t blackboxAsyncQueueTail;
+static volatile bool blackboxAsyncSynced; // an I frame has been queued since the log was (re)started or frames were dropped
+
+static bool blackboxAsyncEnabled(void)
+{
+    return blackboxConfig()->async;
+}
+
+static void blackboxAsyncReset(void)
+{
+    blackboxAsyncSynced = false;
+    blackboxAsyncQueueTail = blackboxAsyncQueueHead;
+}
+#else
+#define blackboxAsyncEnabled() false
+#endif
 
 /*
  * We store voltages in I-frames relative to this, which was the voltage when the blackbox was activated.
@@ -494,14 +621,25 @@ static void blackboxSetState(BlackboxState newState)
     case BLACKBOX_STATE_SEND_GPS_G_HEADER:
     case BLACKBOX_STATE_SEND_GPS_H_HEADER:
     case BLACKBOX_STATE_SEND_SLOW_HEADER:
+    case BLACKBOX_STATE_SEND_SCHEDULER_TRACE_HEADER:
+    case BLACKBOX_STATE_SEND_GYRO_HIGH_RATE_HEADER:
         xmitState.headerIndex = 0;
         xmitState.u.fieldIndex = -1;
         break;
     case BLACKBOX_STATE_SEND_SYSINFO:
+    case BLACKBOX_STATE_SEND_BINARY_HEADER:
         xmitState.headerIndex = 0;
         break;
     case BLACKBOX_STATE_RUNNING:
         blackboxSlowFrameIterationTimer = blackboxSInterval; //Force a slow frame to be written on the first iteration
+#ifdef USE_SCHEDULER_TRACE
+        blackboxSchedulerTraceSequence = schedulerTraceSequence();
+#endif
+        gyroSampleReaderInit(&blackboxGyroSampleReader, gyroSampleRing());
+        memset(&blackboxGyroHighRateHistory, 0, sizeof(blackboxGyroHighRateHistory));
+#ifdef USE_BLACKBOX_ASYNC
+        blackboxAsyncReset();
+#endif
         break;
     case BLACKBOX_STATE_SHUTTING_DOWN:
         xmitState.u.startTime = millis();
@@ -516,8 +654,11 @@ static void writeIntraframe(void)
 {
     blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
 
+    blackboxFrameBufferMarkFrame(BLACKBOX_FRAME_INTRA);
     blackboxWrite('I');
 
+    blackboxMainFrameIndex = 0;
+
     blackboxWriteUnsignedVB(blackboxIteration);
     blackboxWriteUnsignedVB(blackboxCurrent->time);
 
@@ -626,13 +767,63 @@ static void blackboxWriteMainStateArrayUsingAveragePredictor(int arrOffsetInHist
     }
 }
 
+static bool blackboxFieldGroupIsDue(blackboxFieldGroup_e group)
+{
+    const uint8_t denom = blackboxConfig()->field_rate_denom[group];
+
+    return denom <= 1 || blackboxMainFrameIndex % denom == 0;
+}
+
+static void blackboxHoldMainStateArrayAtAveragePredictor(int arrOffsetInHistory, int count)
+{
+    int16_t *curr  = (int16_t*) ((char*) (blackboxHistory[0]) + arrOffsetInHistory);
+    const int16_t *prev1 = (int16_t*) ((char*) (blackboxHistory[1]) + arrOffsetInHistory);
+    const int16_t *prev2 = (int16_t*) ((char*) (blackboxHistory[2]) + arrOffsetInHistory);
+
+    for (int i = 0; i < count; i++) {
+        curr[i] = (prev1[i] + prev2[i]) / 2;
+    }
+}
+
+/*
+ * Field groups that are not due in this P frame take the value their P frame predictor expects, so they are
+ * written as a zero delta and the decoder reconstructs exactly the value we keep in the history.
+ */
+static void blackboxHoldFieldGroups(void)
+{
+    blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
+    const blackboxMainState_t *blackboxLast = blackboxHistory[1];
+
+    if (!blackboxFieldGroupIsDue(BLACKBOX_FIELD_GROUP_PID)) {
+        memcpy(blackboxCurrent->axisPID_P, blackboxLast->axisPID_P, sizeof(blackboxCurrent->axisPID_P));
+        memcpy(blackboxCurrent->axisPID_I, blackboxLast->axisPID_I, sizeof(blackboxCurrent->axisPID_I));
+        memcpy(blackboxCurrent->axisPID_D, blackboxLast->axisPID_D, sizeof(blackboxCurrent->axisPID_D));
+    }
+    if (!blackboxFieldGroupIsDue(BLACKBOX_FIELD_GROUP_RC)) {
+        memcpy(blackboxCurrent->rcCommand, blackboxLast->rcCommand, sizeof(blackboxCurrent->rcCommand));
+    }
+    if (!blackboxFieldGroupIsDue(BLACKBOX_FIELD_GROUP_ACC)) {
+        blackboxHoldMainStateArrayAtAveragePredictor(offsetof(blackboxMainState_t, accADC), XYZ_AXIS_COUNT);
+    }
+    if (!blackboxFieldGroupIsDue(BLACKBOX_FIELD_GROUP_DEBUG)) {
+        blackboxHoldMainStateArrayAtAveragePredictor(offsetof(blackboxMainState_t, debug), DEBUG16_VALUE_COUNT);
+    }
+    if (!blackboxFieldGroupIsDue(BLACKBOX_FIELD_GROUP_MOTOR)) {
+        blackboxHoldMainStateArrayAtAveragePredictor(offsetof(blackboxMainState_t, motor), getMotorCount());
+    }
+}
+
 static void writeInterframe(void)
 {
     blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
     blackboxMainState_t *blackboxLast = blackboxHistory[1];
 
+    blackboxFrameBufferMarkFrame(BLACKBOX_FRAME_INTER);
     blackboxWrite('P');
 
+    blackboxMainFrameIndex++;
+    blackboxHoldFieldGroups();
+
     //No need to store iteration count since its delta is always 1
 
     /*
@@ -737,6 +928,7 @@ static void writeSlowFrame(void)
 {
     int32_t values[3];
 
+    blackboxFrameBufferMarkFrame(BLACKBOX_FRAME_SLOW);
     blackboxWrite('S');
 
     blackboxWriteUnsignedVB(slowHistory.flightModeFlags);
@@ -750,6 +942,11 @@ static void writeSlowFrame(void)
     values[2] = slowHistory.rxFlightChannelsValid ? 1 : 0;
     blackboxWriteTag2_3S32(values);
 
+#ifdef USE_RX_LINK_STATS
+    blackboxWriteUnsignedVB(slowHistory.rxLinkFrames);
+    blackboxWriteUnsignedVB(slowHistory.rxLinkErrors);
+#endif
+
     blackboxSlowFrameIterationTimer = 0;
 }
 
@@ -763,6 +960,16 @@ static void loadSlowState(blackboxSlowState_t *slow)
     slow->failsafePhase = failsafePhase();
     slow->rxSignalReceived = rxIsReceivingSignal();
     slow->rxFlightChannelsValid = rxAreFlightChannelsValid();
+#ifdef USE_RX_LINK_STATS
+    rxLinkStats_t linkStats;
+    if (rxGetLinkStats(&linkStats, 0)) {
+        slow->rxLinkFrames = linkStats.frames;
+        slow->rxLinkErrors = linkStats.droppedFrames + linkStats.failsafeFrames + linkStats.crcErrors;
+    } else {
+        slow->rxLinkFrames = 0;
+        slow->rxLinkErrors = 0;
+    }
+#endif
 }
 
 /**
@@ -797,6 +1004,68 @@ STATIC_UNIT_TESTED bool writeSlowFrameIfNeeded(void)
     return shouldWrite;
 }
 
+#ifdef USE_SCHEDULER_TRACE
+static void writeSchedulerTraceFrames(void)
+{
+    if (schedulerTraceSequence() - blackboxSchedulerTraceSequence > SCHEDULER_TRACE_SIZE) {
+        // fell behind, carry on with the oldest entry still available
+        blackboxSchedulerTraceSequence = schedulerTraceSequence() - SCHEDULER_TRACE_SIZE;
+    }
+
+    schedulerTraceEntry_t entry;
+    for (int i = 0; i < BLACKBOX_SCHEDULER_TRACE_FRAMES_PER_ITERATION && schedulerTraceRead(blackboxSchedulerTraceSequence, &entry); i++) {
+        blackboxWrite('T');
+        blackboxWriteUnsignedVB(entry.taskId);
+        blackboxWriteUnsignedVB(entry.startedAt);
+        blackboxWriteUnsignedVB(entry.executionTime);
+        blackboxWriteSignedVB(entry.lateness);
+        blackboxSchedulerTraceSequence++;
+    }
+}
+#endif
+
+static int32_t blackboxPredictSecondOrder(const int32_t history[3][XYZ_AXIS_COUNT], int axis)
+{
+    return 3 * history[0][axis] - 3 * history[1][axis] + history[2][axis];
+}
+
+static void blackboxGyroHighRateHistoryPush(int32_t history[3][XYZ_AXIS_COUNT], int axis, int32_t value)
+{
+    history[2][axis] = history[1][axis];
+    history[1][axis] = history[0][axis];
+    history[0][axis] = value;
+}
+
+static void writeGyroHighRateFrames(void)
+{
+    gyroSample_t samples[4];
+    unsigned count;
+
+    // Limited by the size of the gyro sample ring, samples that were overwritten before this iteration are lost
+    while ((count = gyroSampleRead(&blackboxGyroSampleReader, samples, ARRAYLEN(samples))) > 0) {
+        for (unsigned i = 0; i < count; i++) {
+            const gyroSample_t *sample = &samples[i];
+
+            blackboxWrite('R');
+            blackboxWriteSignedVB((int32_t)(sample->timeUs - 2 * blackboxGyroHighRateHistory.time[0] + blackboxGyroHighRateHistory.time[1]));
+            blackboxGyroHighRateHistory.time[1] = blackboxGyroHighRateHistory.time[0];
+            blackboxGyroHighRateHistory.time[0] = sample->timeUs;
+
+            int32_t filtered[XYZ_AXIS_COUNT];
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                filtered[axis] = lrintf(sample->filtered[axis]);
+                blackboxWriteSignedVB(filtered[axis] - blackboxPredictSecondOrder((const int32_t (*)[XYZ_AXIS_COUNT])blackboxGyroHighRateHistory.gyroFilt, axis));
+                blackboxGyroHighRateHistoryPush(blackboxGyroHighRateHistory.gyroFilt, axis, filtered[axis]);
+            }
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                const int32_t noise = lrintf(sample->raw[axis]) - filtered[axis];
+                blackboxWriteSignedVB(noise - blackboxPredictSecondOrder((const int32_t (*)[XYZ_AXIS_COUNT])blackboxGyroHighRateHistory.gyroNoise, axis));
+                blackboxGyroHighRateHistoryPush(blackboxGyroHighRateHistory.gyroNoise, axis, noise);
+            }
+        }
+    }
+}
+
 void blackboxValidateConfig(void)
 {
     // If we've chosen an unsupported device, change the device to serial
@@ -806,6 +1075,9 @@ void blackboxValidateConfig(void)
 #endif
 #ifdef USE_SDCARD
     case BLACKBOX_DEVICE_SDCARD:
+#endif
+#ifdef USE_BLACKBOX_VCP
+    case BLACKBOX_DEVICE_VCP:
 #endif
     case BLACKBOX_DEVICE_SERIAL:
         // Device supported, leave the setting alone
@@ -845,6 +1117,8 @@ static void blackboxStart(void)
 
     vbatReference = getBatteryVoltageLatest();
 
+    blackboxAdaptiveRateReset();
+
     //No need to clear the content of blackboxHistoryRing since our first frame will be an intra which overwrites it
 
     /*
@@ -868,23 +1142,42 @@ static void blackboxStart(void)
     blackboxSetState(BLACKBOX_STATE_PREPARE_LOG_FILE);
 }
 
+static void blackboxLogStatsEvent(void)
+{
+    blackboxDeviceStats_t stats;
+    blackboxDeviceGetStats(&stats);
+
+    flightLogEvent_logStats_t eventData;
+    eventData.intraframesDropped = stats.framesDropped[BLACKBOX_FRAME_INTRA];
+    eventData.interframesDropped = stats.framesDropped[BLACKBOX_FRAME_INTER];
+    eventData.slowFramesDropped = stats.framesDropped[BLACKBOX_FRAME_SLOW];
+    eventData.bytesDropped = stats.bytesDropped;
+    eventData.stallTimeMs = stats.stallTimeMs;
+    eventData.bytesPerSecond = stats.bytesPerSecond;
+    blackboxLogEvent(FLIGHT_LOG_EVENT_LOG_STATS, (flightLogEventData_t *)&eventData);
+}
+
 /**
  * Begin Blackbox shutdown.
  */
 void blackboxFinish(void)
 {
-    switch (blackboxState) {
-    case BLACKBOX_STATE_DISABLED:
-    case BLACKBOX_STATE_STOPPED:
-    case BLACKBOX_STATE_SHUTTING_DOWN:
-        // We're already stopped/shutting down
-        break;
-    case BLACKBOX_STATE_RUNNING:
-    case BLACKBOX_STATE_PAUSED:
-        blackboxLogEvent(FLIGHT_LOG_EVENT_LOG_END, NULL);
-        FALLTHROUGH;
-    default:
-        blackboxSetState(BLACKBOX_STATE_SHUTTING_DOWN);
+    // a disarm from a background task must not interleave its events with the frames of a preemptive PID loop
+    SWI_ATOMIC_BLOCK {
+        switch (blackboxState) {
+        case BLACKBOX_STATE_DISABLED:
+        case BLACKBOX_STATE_STOPPED:
+        case BLACKBOX_STATE_SHUTTING_DOWN:
+            // We're already stopped/shutting down
+            break;
+        case BLACKBOX_STATE_RUNNING:
+        case BLACKBOX_STATE_PAUSED:
+            blackboxLogStatsEvent();
+            blackboxLogEvent(FLIGHT_LOG_EVENT_LOG_END, NULL);
+            FALLTHROUGH;
+        default:
+            blackboxSetState(BLACKBOX_STATE_SHUTTING_DOWN);
+        }
     }
 }
 
@@ -902,6 +1195,11 @@ static void startInTestMode(void)
                 return; // When in test mode, we cannot share the MSP and serial logger port!
             }
         }
+#ifdef USE_BLACKBOX_VCP
+        if (blackboxConfig()->device == BLACKBOX_DEVICE_VCP) {
+            return; // Logging takes MSP off the VCP, so only do it while armed
+        }
+#endif
         blackboxStart();
         startedLoggingInTestMode = true;
     }
@@ -979,13 +1277,11 @@ static void writeGPSFrame(timeUs_t currentTimeUs)
 #endif
 
 /**
- * Fill the current state of the blackbox using values read from the flight controller
+ * Fill the given blackbox state using values read from the flight controller
  */
-static void loadMainState(timeUs_t currentTimeUs)
+static void loadMainState(blackboxMainState_t *blackboxCurrent, timeUs_t currentTimeUs)
 {
 #ifndef UNIT_TEST
-    blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
-
     blackboxCurrent->time = currentTimeUs;
 
     for (int i = 0; i < XYZ_AXIS_COUNT; i++) {
@@ -1031,6 +1327,7 @@ static void loadMainState(timeUs_t currentTimeUs)
     blackboxCurrent->servo[5] = servo[5];
 #endif
 #else
+    UNUSED(blackboxCurrent);
     UNUSED(currentTimeUs);
 #endif // UNIT_TEST
 }
@@ -1203,6 +1500,12 @@ static bool blackboxWriteSysinfo(void)
         BLACKBOX_PRINT_HEADER_LINE("I interval", "%d",                      blackboxIInterval);
         BLACKBOX_PRINT_HEADER_LINE("P interval", "%d",                      blackboxPInterval);
         BLACKBOX_PRINT_HEADER_LINE("P ratio", "%d",                         blackboxConfig()->p_ratio);
+        // in blackboxFieldGroup_e order: pid, rc, acc, debug, motor
+        BLACKBOX_PRINT_HEADER_LINE("field_rate_denom", "%d,%d,%d,%d,%d",    blackboxConfig()->field_rate_denom[BLACKBOX_FIELD_GROUP_PID],
+                                                                            blackboxConfig()->field_rate_denom[BLACKBOX_FIELD_GROUP_RC],
+                                                                            blackboxConfig()->field_rate_denom[BLACKBOX_FIELD_GROUP_ACC],
+                                                                            blackboxConfig()->field_rate_denom[BLACKBOX_FIELD_GROUP_DEBUG],
+                                                                            blackboxConfig()->field_rate_denom[BLACKBOX_FIELD_GROUP_MOTOR]);
         BLACKBOX_PRINT_HEADER_LINE("minthrottle", "%d",                     motorConfig()->minthrottle);
         BLACKBOX_PRINT_HEADER_LINE("maxthrottle", "%d",                     motorConfig()->maxthrottle);
         BLACKBOX_PRINT_HEADER_LINE("gyro_scale","0x%x",                     castFloatBytesToInt(1.0f));
@@ -1230,7 +1533,7 @@ static bool blackboxWriteSysinfo(void)
 
         BLACKBOX_PRINT_HEADER_LINE("looptime", "%d",                        gyro.targetLooptime);
         BLACKBOX_PRINT_HEADER_LINE("gyro_sync_denom", "%d",                 gyroConfig()->gyro_sync_denom);
-        BLACKBOX_PRINT_HEADER_LINE("pid_process_denom", "%d",               pidConfig()->pid_process_denom);
+        BLACKBOX_PRINT_HEADER_LINE("pid_process_denom", "%d",               pidGetProcessDenom());
         BLACKBOX_PRINT_HEADER_LINE("thr_mid", "%d",                         currentControlRateProfile->thrMid8);
         BLACKBOX_PRINT_HEADER_LINE("thr_expo", "%d",                        currentControlRateProfile->thrExpo8);
         BLACKBOX_PRINT_HEADER_LINE("tpa_rate", "%d",                        currentControlRateProfile->dynThrPID);
@@ -1278,6 +1581,9 @@ static bool blackboxWriteSysinfo(void)
         BLACKBOX_PRINT_HEADER_LINE("yaw_lowpass_hz", "%d",                  currentPidProfile->yaw_lowpass_hz);
         BLACKBOX_PRINT_HEADER_LINE("dterm_notch_hz", "%d",                  currentPidProfile->dterm_notch_hz);
         BLACKBOX_PRINT_HEADER_LINE("dterm_notch_cutoff", "%d",              currentPidProfile->dterm_notch_cutoff);
+#ifdef USE_GYRO_DATA_ANALYSE
+        BLACKBOX_PRINT_HEADER_LINE("dterm_dyn_notch", "%d",                 currentPidProfile->dterm_dyn_notch);
+#endif
         BLACKBOX_PRINT_HEADER_LINE("iterm_windup", "%d",                    currentPidProfile->itermWindupPointPercent);
         BLACKBOX_PRINT_HEADER_LINE("vbat_pid_gain", "%d",                   currentPidProfile->vbatPidCompensation);
         BLACKBOX_PRINT_HEADER_LINE("pidAtMinThrottle", "%d",                currentPidProfile->pidAtMinThrottle);
@@ -1321,6 +1627,18 @@ static bool blackboxWriteSysinfo(void)
         BLACKBOX_PRINT_HEADER_LINE("motor_pwm_protocol", "%d",              motorConfig()->dev.motorPwmProtocol);
         BLACKBOX_PRINT_HEADER_LINE("motor_pwm_rate", "%d",                  motorConfig()->dev.motorPwmRate);
         BLACKBOX_PRINT_HEADER_LINE("dshot_idle_value", "%d",                motorConfig()->digitalIdleOffsetValue);
+#ifdef USE_MOTOR_TIMING
+        // median and 99th percentile bucket bounds in 0.1us
+        BLACKBOX_PRINT_HEADER_LINE("motor_output_latency", "%d,%d",         motorTimingPercentile(MOTOR_TIMING_GYRO_TO_OUTPUT, 500),
+                                                                            motorTimingPercentile(MOTOR_TIMING_GYRO_TO_OUTPUT, 990));
+        BLACKBOX_PRINT_HEADER_LINE("motor_output_jitter", "%d,%d",          motorTimingPercentile(MOTOR_TIMING_OUTPUT_JITTER, 500),
+                                                                            motorTimingPercentile(MOTOR_TIMING_OUTPUT_JITTER, 990));
+        // in us
+        BLACKBOX_PRINT_HEADER_LINE("rx_setpoint_latency", "%d,%d",          motorTimingPercentile(MOTOR_TIMING_RX_TO_SETPOINT, 500),
+                                                                            motorTimingPercentile(MOTOR_TIMING_RX_TO_SETPOINT, 990));
+        BLACKBOX_PRINT_HEADER_LINE("rx_motor_latency", "%d,%d",             motorTimingPercentile(MOTOR_TIMING_RX_TO_OUTPUT, 500),
+                                                                            motorTimingPercentile(MOTOR_TIMING_RX_TO_OUTPUT, 990));
+#endif
         BLACKBOX_PRINT_HEADER_LINE("debug_mode", "%d",                      systemConfig()->debug_mode);
         BLACKBOX_PRINT_HEADER_LINE("features", "%d",                        featureConfig()->enabledFeatures);
 
@@ -1346,10 +1664,266 @@ static bool blackboxWriteSysinfo(void)
     return false;
 }
 
+/*
+ * Binary header, replaces the field definitions and system information lines when binary_header is set.
+ *
+ * After the usual product and data version lines, a few identification lines are still written as text, ending with
+ * "H Header format:binary,<version>". Records of the form
+ *
+ *     uint8_t type, uint16_t length, uint8_t payload[length]    (little-endian)
+ *
+ * follow directly, terminated by a record of type BLACKBOX_BINARY_RECORD_END. Log frames start after that.
+ */
+#define BLACKBOX_BINARY_HEADER_VERSION 1
+
+typedef enum {
+    BLACKBOX_BINARY_RECORD_END = 0,
+    BLACKBOX_BINARY_RECORD_SYSINFO,     // blackboxBinarySysinfo_t
+    BLACKBOX_BINARY_RECORD_PG,          // uint16_t pgn, uint8_t version, then the PG as stored in RAM
+    BLACKBOX_BINARY_RECORD_FIELD        // frame char, one byte per "signed/predictor/encoding" header, name index, name
+} blackboxBinaryRecordType_e;
+
+#define BLACKBOX_BINARY_RECORD_HEADER_SIZE 3
+
+typedef struct blackboxBinarySysinfo_s {
+    uint16_t iInterval;
+    uint16_t pInterval;
+    uint16_t pRatio;
+    uint32_t gyroLooptime;
+    uint32_t pidLooptime;
+    uint16_t motorOutputLow;
+    uint16_t motorOutputHigh;
+    uint16_t acc1G;
+    uint16_t vbatReference;
+    uint8_t pidProfileIndex;
+    uint8_t rateProfileIndex;
+} PG_PACKED blackboxBinarySysinfo_t;
+
+#ifndef UNIT_TEST
+// PGs dumped in the binary header, PGs that are not compiled in are skipped
+static const pgn_t blackboxBinaryHeaderPgs[] = {
+    PG_SYSTEM_CONFIG,
+    PG_FEATURE_CONFIG,
+    PG_PILOT_CONFIG,
+    PG_BLACKBOX_CONFIG,
+    PG_MOTOR_CONFIG,
+    PG_MIXER_CONFIG,
+    PG_ARMING_CONFIG,
+    PG_GYRO_CONFIG,
+    PG_ACCELEROMETER_CONFIG,
+    PG_BATTERY_CONFIG,
+    PG_RX_CONFIG,
+    PG_PID_CONFIG,
+    PG_PID_PROFILE,
+    PG_CONTROL_RATE_PROFILES,
+};
+
+typedef struct blackboxBinaryFieldTable_s {
+    char frameChar;
+    char deltaFrameChar;
+    const void *fields;
+    size_t fieldStride;
+    int fieldCount;
+    const uint8_t *conditions;  // NULL if every field is always logged
+} blackboxBinaryFieldTable_t;
+
+#define BLACKBOX_BINARY_FIELD_TABLE(frame, delta, defs, conds) \
+    { frame, delta, defs, sizeof(defs[0]), ARRAYLEN(defs), conds }
+
+static const blackboxBinaryFieldTable_t blackboxBinaryFieldTables[] = {
+    BLACKBOX_BINARY_FIELD_TABLE('I', 'P', blackboxMainFields, &blackboxMainFields[0].condition),
+#ifdef USE_GPS
+    BLACKBOX_BINARY_FIELD_TABLE('H', 0, blackboxGpsHFields, NULL),
+    BLACKBOX_BINARY_FIELD_TABLE('G', 0, blackboxGpsGFields, &blackboxGpsGFields[0].condition),
+#endif
+    BLACKBOX_BINARY_FIELD_TABLE('S', 0, blackboxSlowFields, NULL),
+#ifdef USE_SCHEDULER_TRACE
+    BLACKBOX_BINARY_FIELD_TABLE('T', 0, blackboxSchedulerTraceFields, NULL),
+#endif
+    BLACKBOX_BINARY_FIELD_TABLE('R', 0, blackboxGyroHighRateFields, NULL),
+};
+
+#define BLACKBOX_BINARY_FIRST_PG_RECORD     5
+#define BLACKBOX_BINARY_FIRST_FIELD_RECORD  (BLACKBOX_BINARY_FIRST_PG_RECORD + ARRAYLEN(blackboxBinaryHeaderPgs))
+
+// The record being written, the part that is not already in memory is assembled in prefix
+static struct {
+    uint8_t prefix[96];
+    const uint8_t *body;
+    uint16_t prefixLength;
+    uint16_t bodyLength;
+    uint16_t offset;            // bytes of prefix and body written so far
+    uint8_t table;              // position of the next field record
+    uint16_t field;
+} blackboxBinaryRecord;
+
+static int blackboxBinaryRecordStart(blackboxBinaryRecordType_e type, uint16_t length)
+{
+    blackboxBinaryRecord.prefix[0] = type;
+    blackboxBinaryRecord.prefix[1] = length & 0xFF;
+    blackboxBinaryRecord.prefix[2] = length >> 8;
+
+    return BLACKBOX_BINARY_RECORD_HEADER_SIZE;
+}
+
+static bool blackboxBinaryLoadFieldRecord(void)
+{
+    while (blackboxBinaryRecord.table < ARRAYLEN(blackboxBinaryFieldTables)) {
+        const blackboxBinaryFieldTable_t *table = &blackboxBinaryFieldTables[blackboxBinaryRecord.table];
+        const int field = blackboxBinaryRecord.field++;
+
+        if (field >= table->fieldCount) {
+            blackboxBinaryRecord.table++;
+            blackboxBinaryRecord.field = 0;
+            continue;
+        }
+        if (table->conditions && !testBlackboxCondition(table->conditions[table->fieldStride * field])) {
+            continue;
+        }
+
+        const blackboxFieldDefinition_t *def = (const blackboxFieldDefinition_t *)((const char *)table->fields + table->fieldStride * field);
+        const int attributeCount = (table->deltaFrameChar ? BLACKBOX_DELTA_FIELD_HEADER_COUNT : BLACKBOX_SIMPLE_FIELD_HEADER_COUNT) - 1;
+        const int nameLength = MIN(strlen(def->name), sizeof(blackboxBinaryRecord.prefix) - BLACKBOX_BINARY_RECORD_HEADER_SIZE - attributeCount - 2);
+
+        uint8_t *pos = blackboxBinaryRecord.prefix + blackboxBinaryRecordStart(BLACKBOX_BINARY_RECORD_FIELD, 2 + attributeCount + nameLength);
+        *pos++ = table->frameChar;
+        memcpy(pos, def->arr, attributeCount);
+        pos += attributeCount;
+        *pos++ = def->fieldNameIndex;
+        memcpy(pos, def->name, nameLength);
+        blackboxBinaryRecord.prefixLength = pos + nameLength - blackboxBinaryRecord.prefix;
+        return true;
+    }
+
+    return false;
+}
+
+// Prepares the record with the given index, returns false when there are no records left
+static bool blackboxBinaryLoadRecord(uint32_t index)
+{
+    blackboxBinaryRecord.body = NULL;
+    blackboxBinaryRecord.bodyLength = 0;
+    blackboxBinaryRecord.offset = 0;
+
+    char *text = (char *)blackboxBinaryRecord.prefix;
+    char buf[FORMATTED_DATE_TIME_BUFSIZE];
+
+    switch (index) {
+    case 0:
+        blackboxBinaryRecord.prefixLength = tfp_sprintf(text, "H Firmware revision:%s %s (%s) %s\n", FC_FIRMWARE_NAME, FC_VERSION_STRING, shortGitRevision, targetName);
+        return true;
+    case 1:
+        blackboxBinaryRecord.prefixLength = tfp_sprintf(text, "H Firmware date:%s %s\n", buildDate, buildTime);
+        return true;
+    case 2:
+        blackboxBinaryRecord.prefixLength = tfp_sprintf(text, "H Log start datetime:%s\n", blackboxGetStartDateTime(buf));
+        return true;
+    case 3:
+        blackboxBinaryRecord.prefixLength = tfp_sprintf(text, "H Header format:binary,%d\n", BLACKBOX_BINARY_HEADER_VERSION);
+        return true;
+    case 4: {
+        const blackboxBinarySysinfo_t sysinfo = {
+            .iInterval = blackboxIInterval,
+            .pInterval = blackboxPInterval,
+            .pRatio = blackboxConfig()->p_ratio,
+            .gyroLooptime = gyro.targetLooptime,
+            .pidLooptime = targetPidLooptime,
+            .motorOutputLow = lrintf(motorOutputLow),
+            .motorOutputHigh = lrintf(motorOutputHigh),
+            .acc1G = acc.dev.acc_1G,
+            .vbatReference = vbatReference,
+            .pidProfileIndex = getCurrentPidProfileIndex(),
+            .rateProfileIndex = getCurrentControlRateProfileIndex(),
+        };
+        const int headerSize = blackboxBinaryRecordStart(BLACKBOX_BINARY_RECORD_SYSINFO, sizeof(sysinfo));
+        memcpy(blackboxBinaryRecord.prefix + headerSize, &sysinfo, sizeof(sysinfo));
+        blackboxBinaryRecord.prefixLength = headerSize + sizeof(sysinfo);
+        return true;
+    }
+    default:
+        break;
+    }
+
+    if (index < BLACKBOX_BINARY_FIRST_FIELD_RECORD) {
+        const pgRegistry_t *reg = pgFind(blackboxBinaryHeaderPgs[index - BLACKBOX_BINARY_FIRST_PG_RECORD]);
+        if (!reg) {
+            blackboxBinaryRecord.prefixLength = 0;
+            return true;
+        }
+        const pgn_t pgn = pgN(reg);
+        const int headerSize = blackboxBinaryRecordStart(BLACKBOX_BINARY_RECORD_PG, 3 + pgSize(reg));
+        blackboxBinaryRecord.prefix[headerSize] = pgn & 0xFF;
+        blackboxBinaryRecord.prefix[headerSize + 1] = pgn >> 8;
+        blackboxBinaryRecord.prefix[headerSize + 2] = pgVersion(reg);
+        blackboxBinaryRecord.prefixLength = headerSize + 3;
+        blackboxBinaryRecord.body = reg->address;
+        blackboxBinaryRecord.bodyLength = pgSize(reg);
+        return true;
+    }
+
+    if (index == BLACKBOX_BINARY_FIRST_FIELD_RECORD) {
+        blackboxBinaryRecord.table = 0;
+        blackboxBinaryRecord.field = 0;
+    }
+    if (blackboxBinaryLoadFieldRecord()) {
+        return true;
+    }
+
+    if (blackboxBinaryRecord.table == ARRAYLEN(blackboxBinaryFieldTables)) {
+        // mark the end record as sent once it has been loaded
+        blackboxBinaryRecord.table++;
+        blackboxBinaryRecord.prefixLength = blackboxBinaryRecordStart(BLACKBOX_BINARY_RECORD_END, 0);
+        return true;
+    }
+
+    return false;
+}
+#endif // UNIT_TEST
+
+/**
+ * Transmit a portion of the binary header, as much as the header budget allows. Call the first time with
+ * xmitState.headerIndex == 0. Returns true iff transmission is complete, otherwise call again later to continue.
+ */
+static bool blackboxWriteBinaryHeader(void)
+{
+#ifndef UNIT_TEST
+    if (xmitState.headerIndex == 0) {
+        if (!blackboxBinaryLoadRecord(0)) {
+            return true;
+        }
+        xmitState.headerIndex = 1;
+    }
+
+    while (blackboxHeaderBudget > 0) {
+        const uint16_t recordLength = blackboxBinaryRecord.prefixLength + blackboxBinaryRecord.bodyLength;
+
+        if (blackboxBinaryRecord.offset >= recordLength) {
+            if (!blackboxBinaryLoadRecord(xmitState.headerIndex)) {
+                return true;
+            }
+            xmitState.headerIndex++;
+            continue;
+        }
+
+        const uint16_t offset = blackboxBinaryRecord.offset++;
+        if (offset < blackboxBinaryRecord.prefixLength) {
+            blackboxWrite(blackboxBinaryRecord.prefix[offset]);
+        } else {
+            blackboxWrite(blackboxBinaryRecord.body[offset - blackboxBinaryRecord.prefixLength]);
+        }
+        blackboxHeaderBudget--;
+    }
+
+    return false;
+#else
+    return true;
+#endif // UNIT_TEST
+}
+
 /**
  * Write the given event to the log immediately
  */
-void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
+static void blackboxWriteEvent(FlightLogEvent event, flightLogEventData_t *data)
 {
     // Only allow events to be logged after headers have been written
     if (!(blackboxState == BLACKBOX_STATE_RUNNING || blackboxState == BLACKBOX_STATE_PAUSED)) {
@@ -1382,6 +1956,22 @@ void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
         blackboxWriteUnsignedVB(data->loggingResume.logIteration);
         blackboxWriteUnsignedVB(data->loggingResume.currentTime);
         break;
+    case FLIGHT_LOG_EVENT_PID_RATE_CHANGE:
+        blackboxWriteUnsignedVB(data->pidRateChange.pidProcessDenom);
+        blackboxWriteUnsignedVB(data->pidRateChange.pidLooptime);
+        break;
+    case FLIGHT_LOG_EVENT_LOG_RATE_CHANGE:
+        blackboxWriteUnsignedVB(data->logRateChange.pInterval);
+        blackboxWriteUnsignedVB(data->logRateChange.bytesPerSecond);
+        break;
+    case FLIGHT_LOG_EVENT_LOG_STATS:
+        blackboxWriteUnsignedVB(data->logStats.intraframesDropped);
+        blackboxWriteUnsignedVB(data->logStats.interframesDropped);
+        blackboxWriteUnsignedVB(data->logStats.slowFramesDropped);
+        blackboxWriteUnsignedVB(data->logStats.bytesDropped);
+        blackboxWriteUnsignedVB(data->logStats.stallTimeMs);
+        blackboxWriteUnsignedVB(data->logStats.bytesPerSecond);
+        break;
     case FLIGHT_LOG_EVENT_LOG_END:
         blackboxWriteString("End of log");
         blackboxWrite(0);
@@ -1389,6 +1979,14 @@ void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
     }
 }
 
+// Events are logged from background tasks as well as from the PID loop, which may preempt them
+void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
+{
+    SWI_ATOMIC_BLOCK {
+        blackboxWriteEvent(event, data);
+    }
+}
+
 /* If an arming beep has played since it was last logged, write the time of the arming beep to the log as a synchronization point */
 static void blackboxCheckAndLogArmingBeep(void)
 {
@@ -1452,16 +2050,94 @@ STATIC_UNIT_TESTED void blackboxAdvanceIterationTimers(void)
         blackboxLoopIndex = 0;
         blackboxIFrameIndex++;
         blackboxPFrameIndex = 0;
+        // the P interval only changes at an I frame, which the decoder can resynchronise on
+        blackboxPInterval = blackboxPIntervalTarget;
     } else if (++blackboxPFrameIndex >= blackboxPInterval) {
         blackboxPFrameIndex = 0;
     }
 }
 
-// Called once every FC loop in order to log the current state
-STATIC_UNIT_TESTED void blackboxLogIteration(timeUs_t currentTimeUs)
+/*
+ * Sets the P interval for the next window from the bytes the device took and refused in this one, see
+ * blackboxAdaptiveRate.
+ */
+STATIC_UNIT_TESTED int16_t blackboxAdaptiveRateStep(uint32_t bytesWritten, uint32_t bytesDropped, timeMs_t windowMs)
 {
-    // Write a keyframe every blackboxIInterval frames so we can resynchronise upon missing frames
-    if (blackboxShouldLogIFrame()) {
+    int16_t pInterval = blackboxPIntervalTarget;
+
+    if (bytesDropped) {
+        blackboxAdaptiveRate.cleanWindows = 0;
+        if (blackboxAdaptiveRate.probing) {
+            blackboxAdaptiveRate.recoverWindows = MIN(blackboxAdaptiveRate.recoverWindows * 2, BLACKBOX_ADAPTIVE_RATE_RECOVER_WINDOWS_MAX);
+            blackboxAdaptiveRate.probing = false;
+        }
+        if (bytesWritten == 0) {
+            // a stalled device tells nothing about its throughput
+            return blackboxPIntervalTarget;
+        }
+
+        blackboxAdaptiveRate.throughput = (uint64_t)bytesWritten * 1000 / windowMs;
+        const uint32_t budget = blackboxAdaptiveRate.throughput / 100 * BLACKBOX_ADAPTIVE_RATE_MARGIN_PERCENT;
+        // Most of the log is main frames, so take its size to scale with their rate
+        uint32_t demand = (uint64_t)(bytesWritten + bytesDropped) * 1000 / windowMs;
+        while (demand > budget && pInterval * 2 <= blackboxIInterval) {
+            pInterval *= 2;
+            demand /= 2;
+        }
+    } else {
+        if (blackboxAdaptiveRate.probing) {
+            blackboxAdaptiveRate.recoverWindows = BLACKBOX_ADAPTIVE_RATE_RECOVER_WINDOWS;
+            blackboxAdaptiveRate.probing = false;
+        }
+        if (pInterval > blackboxPIntervalConfigured && ++blackboxAdaptiveRate.cleanWindows >= blackboxAdaptiveRate.recoverWindows) {
+            blackboxAdaptiveRate.cleanWindows = 0;
+            blackboxAdaptiveRate.probing = true;
+            pInterval = MAX(pInterval / 2, blackboxPIntervalConfigured);
+        }
+    }
+
+    blackboxPIntervalTarget = pInterval;
+    return pInterval;
+}
+
+static void blackboxAdaptRate(void)
+{
+    const timeMs_t nowMs = millis();
+
+    if (blackboxAdaptiveRate.started && cmp32(nowMs, blackboxAdaptiveRate.windowStartMs) < BLACKBOX_ADAPTIVE_RATE_WINDOW_MS) {
+        return;
+    }
+
+    blackboxDeviceStats_t stats;
+    blackboxDeviceGetStats(&stats);
+
+    if (blackboxAdaptiveRate.started) {
+        blackboxAdaptiveRateStep(stats.bytesWritten - blackboxAdaptiveRate.bytesWritten,
+            stats.bytesDropped - blackboxAdaptiveRate.bytesDropped, nowMs - blackboxAdaptiveRate.windowStartMs);
+    }
+
+    blackboxAdaptiveRate.started = true;
+    blackboxAdaptiveRate.windowStartMs = nowMs;
+    blackboxAdaptiveRate.bytesWritten = stats.bytesWritten;
+    blackboxAdaptiveRate.bytesDropped = stats.bytesDropped;
+}
+
+// Called before an I frame, pInterval is the P interval that follows it
+static void blackboxLogRateChangeIfNeeded(int16_t pInterval)
+{
+    if (pInterval != blackboxPIntervalLogged) {
+        flightLogEvent_logRateChange_t eventData;
+        eventData.pInterval = pInterval;
+        eventData.bytesPerSecond = blackboxAdaptiveRate.throughput;
+        blackboxLogEvent(FLIGHT_LOG_EVENT_LOG_RATE_CHANGE, (flightLogEventData_t *)&eventData);
+        blackboxPIntervalLogged = pInterval;
+    }
+}
+
+// Write the main frame whose state has been loaded into blackboxHistory[0]
+static void blackboxLogMainFrame(bool intraframe)
+{
+    if (intraframe) {
         /*
          * Don't log a slow frame if the slow data didn't change ("I" frames are already large enough without adding
          * an additional item to write at the same time). Unless we're *only* logging "I" frames, then we have no choice.
@@ -1470,45 +2146,149 @@ STATIC_UNIT_TESTED void blackboxLogIteration(timeUs_t currentTimeUs)
             writeSlowFrameIfNeeded();
         }
 
-        loadMainState(currentTimeUs);
         writeIntraframe();
+    } else {
+        /*
+         * We assume that slow frames are only interesting in that they aid the interpretation of the main data stream.
+         * So only log slow frames during loop iterations where we log a main frame.
+         */
+        writeSlowFrameIfNeeded();
+
+        writeInterframe();
+    }
+#ifdef USE_SCHEDULER_TRACE
+    if (blackboxConfig()->record_scheduler_trace) {
+        writeSchedulerTraceFrames();
+    }
+#endif
+}
+
+#ifdef USE_GPS
+static void blackboxLogGpsFrames(timeUs_t currentTimeUs)
+{
+    if (feature(FEATURE_GPS)) {
+        if (blackboxShouldLogGpsHomeFrame()) {
+            writeGPSHomeFrame();
+            writeGPSFrame(currentTimeUs);
+        } else if (gpsSol.numSat != gpsHistory.GPS_numSat
+                || gpsSol.llh.lat != gpsHistory.GPS_coord[LAT]
+                || gpsSol.llh.lon != gpsHistory.GPS_coord[LON]) {
+            //We could check for velocity changes as well but I doubt it changes independent of position
+            writeGPSFrame(currentTimeUs);
+        }
+    }
+}
+#endif
+
+static void blackboxLogIterationEnd(void)
+{
+    // The high rate gyro frames are written on every iteration, whatever the main frame rate
+    if (blackboxConfig()->record_gyro_high_rate) {
+        writeGyroHighRateFrames();
+    }
+
+    if (blackboxConfig()->adaptive_rate && blackboxPIntervalConfigured) {
+        blackboxAdaptRate();
+    }
+
+    //Flush every iteration so that our runtime variance is minimized
+    blackboxDeviceFlush();
+}
+
+// Called once every FC loop in order to log the current state
+STATIC_UNIT_TESTED void blackboxLogIteration(timeUs_t currentTimeUs)
+{
+    // Write a keyframe every blackboxIInterval frames so we can resynchronise upon missing frames
+    if (blackboxShouldLogIFrame()) {
+        blackboxLogRateChangeIfNeeded(blackboxPInterval);
+        loadMainState(blackboxHistory[0], currentTimeUs);
+        blackboxLogMainFrame(true);
     } else {
         blackboxCheckAndLogArmingBeep();
         blackboxCheckAndLogFlightMode(); // Check for FlightMode status change event
 
         if (blackboxShouldLogPFrame()) {
-            /*
-             * We assume that slow frames are only interesting in that they aid the interpretation of the main data stream.
-             * So only log slow frames during loop iterations where we log a main frame.
-             */
-            writeSlowFrameIfNeeded();
-
-            loadMainState(currentTimeUs);
-            writeInterframe();
+            loadMainState(blackboxHistory[0], currentTimeUs);
+            blackboxLogMainFrame(false);
         }
 #ifdef USE_GPS
-        if (feature(FEATURE_GPS)) {
-            if (blackboxShouldLogGpsHomeFrame()) {
-                writeGPSHomeFrame();
-                writeGPSFrame(currentTimeUs);
-            } else if (gpsSol.numSat != gpsHistory.GPS_numSat
-                    || gpsSol.llh.lat != gpsHistory.GPS_coord[LAT]
-                    || gpsSol.llh.lon != gpsHistory.GPS_coord[LON]) {
-                //We could check for velocity changes as well but I doubt it changes independent of position
-                writeGPSFrame(currentTimeUs);
+        blackboxLogGpsFrames(currentTimeUs);
+#endif
+    }
+
+    blackboxLogIterationEnd();
+}
+
+#ifdef USE_BLACKBOX_ASYNC
+// Called from the PID loop, queues the main state if a frame is due on this iteration
+static void blackboxAsyncCaptureIteration(timeUs_t currentTimeUs)
+{
+    const BlackboxState state = blackboxState;
+
+    if (state == BLACKBOX_STATE_RUNNING) {
+        const bool intraframe = blackboxShouldLogIFrame();
+
+        if (!intraframe && !blackboxAsyncSynced) {
+            if (blackboxShouldLogPFrame()) {
+                // P frames can't be decoded until the next I frame brings the history back
+                blackboxDeviceCountDroppedFrame(BLACKBOX_FRAME_INTER);
+            }
+        } else if (intraframe || blackboxShouldLogPFrame()) {
+            const uint32_t head = blackboxAsyncQueueHead;
+
+            if (head - blackboxAsyncQueueTail < BLACKBOX_ASYNC_QUEUE_SIZE) {
+                blackboxQueuedFrame_t *frame = &blackboxAsyncQueue[head & (BLACKBOX_ASYNC_QUEUE_SIZE - 1)];
+
+                loadMainState(&frame->state, currentTimeUs);
+                frame->intraframe = intraframe;
+                frame->pInterval = blackboxPInterval;
+                __asm__ volatile ("" ::: "memory");
+                blackboxAsyncQueueHead = head + 1;
+                blackboxAsyncSynced = true;
+            } else {
+                blackboxDeviceCountDroppedFrame(intraframe ? BLACKBOX_FRAME_INTRA : BLACKBOX_FRAME_INTER);
+                blackboxAsyncSynced = false;
             }
         }
-#endif
     }
 
-    //Flush every iteration so that our runtime variance is minimized
-    blackboxDeviceFlush();
+    if (state == BLACKBOX_STATE_RUNNING || state == BLACKBOX_STATE_PAUSED) {
+        // Keep the logging timers ticking so our log iteration continues to advance
+        blackboxAdvanceIterationTimers();
+    }
 }
 
-/**
- * Call each flight loop iteration to perform blackbox logging.
- */
-void blackboxUpdate(timeUs_t currentTimeUs)
+// Called from TASK_BLACKBOX, writes all the frames queued by the PID loop
+static void blackboxAsyncLogQueuedIterations(timeUs_t currentTimeUs)
+{
+    blackboxCheckAndLogArmingBeep();
+    blackboxCheckAndLogFlightMode(); // Check for FlightMode status change event
+
+    uint32_t tail = blackboxAsyncQueueTail;
+    while (tail != blackboxAsyncQueueHead) {
+        const blackboxQueuedFrame_t *frame = &blackboxAsyncQueue[tail & (BLACKBOX_ASYNC_QUEUE_SIZE - 1)];
+        const bool intraframe = frame->intraframe;
+
+        if (intraframe) {
+            blackboxLogRateChangeIfNeeded(frame->pInterval);
+        }
+        memcpy(blackboxHistory[0], &frame->state, sizeof(blackboxMainState_t));
+        blackboxAsyncQueueTail = ++tail;
+
+        blackboxLogMainFrame(intraframe);
+    }
+
+#ifdef USE_GPS
+    blackboxLogGpsFrames(currentTimeUs);
+#else
+    UNUSED(currentTimeUs);
+#endif
+
+    blackboxLogIterationEnd();
+}
+#endif
+
+static void blackboxUpdateState(timeUs_t currentTimeUs)
 {
     switch (blackboxState) {
     case BLACKBOX_STATE_STOPPED:
@@ -1535,18 +2315,27 @@ void blackboxUpdate(timeUs_t currentTimeUs)
          * Once the UART has had time to init, transmit the header in chunks so we don't overflow its transmit
          * buffer, overflow the OpenLog's buffer, or keep the main loop busy for too long.
          */
-        if (millis() > xmitState.u.startTime + 100) {
+        if (millis() > xmitState.u.startTime + 100
+            || (blackboxConfig()->binary_header && blackboxConfig()->device != BLACKBOX_DEVICE_SERIAL)) {
             if (blackboxDeviceReserveBufferSpace(BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION) == BLACKBOX_RESERVE_SUCCESS) {
                 for (int i = 0; i < BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION && blackboxHeader[xmitState.headerIndex] != '\0'; i++, xmitState.headerIndex++) {
                     blackboxWrite(blackboxHeader[xmitState.headerIndex]);
                     blackboxHeaderBudget--;
                 }
                 if (blackboxHeader[xmitState.headerIndex] == '\0') {
-                    blackboxSetState(BLACKBOX_STATE_SEND_MAIN_FIELD_HEADER);
+                    blackboxSetState(blackboxConfig()->binary_header ? BLACKBOX_STATE_SEND_BINARY_HEADER : BLACKBOX_STATE_SEND_MAIN_FIELD_HEADER);
                 }
             }
         }
         break;
+    case BLACKBOX_STATE_SEND_BINARY_HEADER:
+        blackboxReplenishHeaderBudget();
+        //On entry of this state, xmitState.headerIndex is 0
+
+        if (blackboxWriteBinaryHeader() && blackboxDeviceFlushForce()) {
+            blackboxSetState(BLACKBOX_STATE_RUNNING);
+        }
+        break;
     case BLACKBOX_STATE_SEND_MAIN_FIELD_HEADER:
         blackboxReplenishHeaderBudget();
         //On entry of this state, xmitState.headerIndex is 0 and xmitState.u.fieldIndex is -1
@@ -1583,6 +2372,30 @@ void blackboxUpdate(timeUs_t currentTimeUs)
         //On entry of this state, xmitState.headerIndex is 0 and xmitState.u.fieldIndex is -1
         if (!sendFieldDefinition('S', 0, blackboxSlowFields, blackboxSlowFields + 1, ARRAYLEN(blackboxSlowFields),
                 NULL, NULL)) {
+#ifdef USE_SCHEDULER_TRACE
+            if (blackboxConfig()->record_scheduler_trace) {
+                blackboxSetState(BLACKBOX_STATE_SEND_SCHEDULER_TRACE_HEADER);
+            } else
+#endif
+                blackboxSetState(BLACKBOX_STATE_SEND_GYRO_HIGH_RATE_HEADER);
+        }
+        break;
+#ifdef USE_SCHEDULER_TRACE
+    case BLACKBOX_STATE_SEND_SCHEDULER_TRACE_HEADER:
+        blackboxReplenishHeaderBudget();
+        //On entry of this state, xmitState.headerIndex is 0 and xmitState.u.fieldIndex is -1
+        if (!sendFieldDefinition('T', 0, blackboxSchedulerTraceFields, blackboxSchedulerTraceFields + 1, ARRAYLEN(blackboxSchedulerTraceFields),
+                NULL, NULL)) {
+            blackboxSetState(BLACKBOX_STATE_SEND_GYRO_HIGH_RATE_HEADER);
+        }
+        break;
+#endif
+    case BLACKBOX_STATE_SEND_GYRO_HIGH_RATE_HEADER:
+        blackboxReplenishHeaderBudget();
+        //On entry of this state, xmitState.headerIndex is 0 and xmitState.u.fieldIndex is -1
+        if (!blackboxConfig()->record_gyro_high_rate
+                || !sendFieldDefinition('R', 0, blackboxGyroHighRateFields, blackboxGyroHighRateFields + 1, ARRAYLEN(blackboxGyroHighRateFields),
+                NULL, NULL)) {
             blackboxSetState(BLACKBOX_STATE_SEND_SYSINFO);
         }
         break;
@@ -1604,7 +2417,8 @@ void blackboxUpdate(timeUs_t currentTimeUs)
         break;
     case BLACKBOX_STATE_PAUSED:
         // Only allow resume to occur during an I-frame iteration, so that we have an "I" base to work from
-        if (IS_RC_MODE_ACTIVE(BOXBLACKBOX) && blackboxShouldLogIFrame()) {
+        // (when async the PID loop waits for the next I-frame itself)
+        if (IS_RC_MODE_ACTIVE(BOXBLACKBOX) && (blackboxAsyncEnabled() || blackboxShouldLogIFrame())) {
             // Write a log entry so the decoder is aware that our large time/iteration skip is intended
             flightLogEvent_loggingResume_t resume;
 
@@ -1614,10 +2428,14 @@ void blackboxUpdate(timeUs_t currentTimeUs)
             blackboxLogEvent(FLIGHT_LOG_EVENT_LOGGING_RESUME, (flightLogEventData_t *) &resume);
             blackboxSetState(BLACKBOX_STATE_RUNNING);
 
-            blackboxLogIteration(currentTimeUs);
+            if (!blackboxAsyncEnabled()) {
+                blackboxLogIteration(currentTimeUs);
+            }
         }
         // Keep the logging timers ticking so our log iteration continues to advance
-        blackboxAdvanceIterationTimers();
+        if (!blackboxAsyncEnabled()) {
+            blackboxAdvanceIterationTimers();
+        }
         break;
     case BLACKBOX_STATE_RUNNING:
         // On entry to this state, blackboxIteration, blackboxPFrameIndex and blackboxIFrameIndex are reset to 0
@@ -1625,9 +2443,18 @@ void blackboxUpdate(timeUs_t currentTimeUs)
         if (blackboxModeActivationConditionPresent && !IS_RC_MODE_ACTIVE(BOXBLACKBOX) && !startedLoggingInTestMode) {
             blackboxSetState(BLACKBOX_STATE_PAUSED);
         } else {
-            blackboxLogIteration(currentTimeUs);
+#ifdef USE_BLACKBOX_ASYNC
+            if (blackboxAsyncEnabled()) {
+                blackboxAsyncLogQueuedIterations(currentTimeUs);
+            } else
+#endif
+            {
+                blackboxLogIteration(currentTimeUs);
+            }
+        }
+        if (!blackboxAsyncEnabled()) {
+            blackboxAdvanceIterationTimers();
         }
-        blackboxAdvanceIterationTimers();
         break;
     case BLACKBOX_STATE_SHUTTING_DOWN:
         //On entry of this state, startTime is set
@@ -1708,6 +2535,30 @@ void blackboxUpdate(timeUs_t currentTimeUs)
     }
 }
 
+/**
+ * Call each flight loop iteration to perform blackbox logging.
+ */
+void blackboxUpdate(timeUs_t currentTimeUs)
+{
+#ifdef USE_BLACKBOX_ASYNC
+    if (blackboxAsyncEnabled()) {
+        blackboxAsyncCaptureIteration(currentTimeUs);
+        return;
+    }
+#endif
+    blackboxUpdateState(currentTimeUs);
+}
+
+#ifdef USE_BLACKBOX_ASYNC
+/**
+ * Called by TASK_BLACKBOX to encode and write the frames queued by blackboxUpdate() when blackbox_async is set.
+ */
+void blackboxAsyncUpdate(timeUs_t currentTimeUs)
+{
+    blackboxUpdateState(currentTimeUs);
+}
+#endif
+
 int blackboxCalculatePDenom(int rateNum, int rateDenom)
 {
     return blackboxIInterval * rateNum / rateDenom;
@@ -1745,6 +2596,8 @@ void blackboxInit(void)
     } else {
         blackboxPInterval = blackboxIInterval /  blackboxConfig()->p_ratio;
     }
+    blackboxPIntervalConfigured = blackboxPInterval;
+    blackboxAdaptiveRateReset();
     if (blackboxConfig()->device) {
         blackboxSetState(BLACKBOX_STATE_STOPPED);
     } else {
@@ -33,7 +33,10 @@ typedef enum BlackboxDevice {
 #ifdef USE_SDCARD
     BLACKBOX_DEVICE_SDCARD = 2,
 #endif
-    BLACKBOX_DEVICE_SERIAL = 3
+    BLACKBOX_DEVICE_SERIAL = 3,
+#ifdef USE_BLACKBOX_VCP
+    BLACKBOX_DEVICE_VCP = 4
+#endif
 } BlackboxDevice_e;
 
 typedef enum BlackboxMode {
@@ -47,14 +50,33 @@ typedef enum FlightLogEvent {
     FLIGHT_LOG_EVENT_INFLIGHT_ADJUSTMENT = 13,
     FLIGHT_LOG_EVENT_LOGGING_RESUME = 14,
     FLIGHT_LOG_EVENT_FLIGHTMODE = 30, // Add new event type for flight mode status.
+    FLIGHT_LOG_EVENT_PID_RATE_CHANGE = 31,
+    FLIGHT_LOG_EVENT_LOG_STATS = 32, // Frames and bytes the device couldn't take, written just before the log end
+    FLIGHT_LOG_EVENT_LOG_RATE_CHANGE = 33, // New P interval chosen by blackbox_adaptive_rate, takes effect from the next I frame
     FLIGHT_LOG_EVENT_LOG_END = 255
 } FlightLogEvent;
 
+// Groups of main frame fields that can be logged at a fraction of the main frame rate
+typedef enum {
+    BLACKBOX_FIELD_GROUP_PID = 0,
+    BLACKBOX_FIELD_GROUP_RC,
+    BLACKBOX_FIELD_GROUP_ACC,
+    BLACKBOX_FIELD_GROUP_DEBUG,
+    BLACKBOX_FIELD_GROUP_MOTOR,
+    BLACKBOX_FIELD_GROUP_COUNT
+} blackboxFieldGroup_e;
+
 typedef struct blackboxConfig_s {
     uint16_t p_ratio; // I-frame interval / P-frame interval
     uint8_t device;
     uint8_t record_acc;
     uint8_t mode;
+    uint8_t record_scheduler_trace;
+    uint8_t record_gyro_high_rate;      // log every gyro sample in 'R' frames alongside the main frames
+    uint8_t field_rate_denom[BLACKBOX_FIELD_GROUP_COUNT]; // a group is updated on every nth main frame, see blackboxFieldGroup_e
+    uint8_t binary_header;              // write the configuration and field definitions as one binary block
+    uint8_t async;                      // encode and write frames from TASK_BLACKBOX instead of the PID loop
+    uint8_t adaptive_rate;              // lower the P frame rate while the device can't keep up, raise it again when it can
 } blackboxConfig_t;
 
 PG_DECLARE(blackboxConfig_t, blackboxConfig);
@@ -64,6 +86,9 @@ void blackboxLogEvent(FlightLogEvent event, union flightLogEventData_u *data);
 
 void blackboxInit(void);
 void blackboxUpdate(timeUs_t currentTimeUs);
+#ifdef USE_BLACKBOX_ASYNC
+void blackboxAsyncUpdate(timeUs_t currentTimeUs);
+#endif
 void blackboxSetStartDateTime(const char *dateTime, timeMs_t timeNowMs);
 int blackboxCalculatePDenom(int rateNum, int rateDenom);
 uint8_t blackboxGetRateDenom(void);
@@ -79,5 +104,6 @@ STATIC_UNIT_TESTED bool writeSlowFrameIfNeeded(void);
 // Called once every FC loop in order to keep track of how many FC loop iterations have passed
 STATIC_UNIT_TESTED void blackboxAdvanceIterationTimers(void);
 extern int32_t blackboxSInterval;
+STATIC_UNIT_TESTED int16_t blackboxAdaptiveRateStep(uint32_t bytesWritten, uint32_t bytesDropped, timeMs_t windowMs);
 extern int32_t blackboxSlowFrameIterationTimer;
 #endif
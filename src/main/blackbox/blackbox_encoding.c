@@ -32,6 +32,7 @@
 #include "blackbox_io.h"
 
 #include "common/encoding.h"
+#include "common/maths.h"
 #include "common/printf.h"
 
 
@@ -127,13 +128,56 @@ void blackboxWriteS16(int16_t value)
     blackboxWrite((value >> 8) & 0xFF);
 }
 
+/*
+ * Fold a signed value onto the magnitude of its two's complement form, so that value lies in [-2^n, 2^n) exactly
+ * when the folded value is below 2^n. The width of a group of fields can then be found by OR-ing the folded values.
+ */
+static inline uint32_t blackboxFoldSigned(int32_t value)
+{
+    return (uint32_t)(value ^ (value >> 31));
+}
+
+// Number of significant bits in a folded value, a value of 0 is given 1 bit
+static inline int blackboxFoldedBits(uint32_t folded)
+{
+    return 32 - __builtin_clz(folded | 1);
+}
+
+/*
+ * Write the 32 bit variant shared by the 2 bit tag encoders: a field selector in the low 6 bits of the tag byte
+ * followed by each field in 1, 2, 3 or 4 little-endian bytes.
+ *
+ * Selector2 field possibilities
+ * 0 - 8 bits
+ * 1 - 16 bits
+ * 2 - 24 bits
+ * 3 - 32 bits
+ */
+static void blackboxWriteTag2_3S32Fields(int selector, const int32_t *values)
+{
+    // A field takes (bits + sign bit) rounded up to whole bytes, i.e. bits / 8 + 1 bytes
+    const int bytes0 = blackboxFoldedBits(blackboxFoldSigned(values[0])) >> 3;
+    const int bytes1 = blackboxFoldedBits(blackboxFoldSigned(values[1])) >> 3;
+    const int bytes2 = blackboxFoldedBits(blackboxFoldSigned(values[2])) >> 3;
+
+    //Write the selectors, the first field is in the low bits
+    blackboxWrite((selector << 6) | (bytes2 << 4) | (bytes1 << 2) | bytes0);
+
+    //And now the values according to the selectors we picked for them
+    const int byteCount[3] = { bytes0, bytes1, bytes2 };
+    for (int x = 0; x < 3; x++) {
+        const uint32_t value = values[x];
+        for (int i = 0; i <= byteCount[x]; i++) {
+            blackboxWrite(value >> (i * 8));
+        }
+    }
+}
+
 /**
  * Write a 2 bit tag followed by 3 signed fields of 2, 4, 6 or 32 bits
  */
 void blackboxWriteTag2_3S32(int32_t *values)
 {
-    static const int NUM_FIELDS = 3;
-
     //Need to be enums rather than const ints if we want to switch on them (due to being C)
     enum {
         BITS_2  = 0,
@@ -142,15 +186,6 @@ void blackboxWriteTag2_3S32(int32_t *values)
         BITS_32 = 3
     };
 
-    enum {
-        BYTES_1  = 0,
-        BYTES_2  = 1,
-        BYTES_3  = 2,
-        BYTES_4  = 3
-    };
-
-    int selector = BITS_2, selector2;
-
     /*
      * Find out how many bits the largest value requires to encode, and use it to choose one of the packing schemes
      * below:
@@ -162,24 +197,11 @@ void blackboxWriteTag2_3S32(int32_t *values)
      * 6 bits per field  ss11 1111 0022 2222 0033 3333
      * 32 bits per field sstt tttt followed by fields of various byte counts
      */
-    for (int x = 0; x < NUM_FIELDS; x++) {
-        //Require more than 6 bits?
-        if (values[x] >= 32 || values[x] < -32) {
-            selector = BITS_32;
-            break;
-        }
+    const uint32_t folded = blackboxFoldSigned(values[0]) | blackboxFoldSigned(values[1]) | blackboxFoldSigned(values[2]);
 
-        //Require more than 4 bits?
-        if (values[x] >= 8 || values[x] < -8) {
-             if (selector < BITS_6) {
-                 selector = BITS_6;
-             }
-        } else if (values[x] >= 2 || values[x] < -2) { //Require more than 2 bits?
-            if (selector < BITS_4) {
-                selector = BITS_4;
-            }
-        }
-    }
+    // Indexed by the significant bits of the widest field
+    static const uint8_t selectorForBits[7] = { BITS_2, BITS_2, BITS_4, BITS_4, BITS_6, BITS_6, BITS_32 };
+    const int selector = selectorForBits[MIN(blackboxFoldedBits(folded), 6)];
 
     switch (selector) {
     case BITS_2:
@@ -195,58 +217,7 @@ void blackboxWriteTag2_3S32(int32_t *values)
         blackboxWrite((uint8_t)values[2]);
         break;
     case BITS_32:
-        /*
-         * Do another round to compute a selector for each field, assuming that they are at least 8 bits each
-         *
-         * Selector2 field possibilities
-         * 0 - 8 bits
-         * 1 - 16 bits
-         * 2 - 24 bits
-         * 3 - 32 bits
-         */
-        selector2 = 0;
-
-        //Encode in reverse order so the first field is in the low bits:
-        for (int x = NUM_FIELDS - 1; x >= 0; x--) {
-            selector2 <<= 2;
-
-            if (values[x] < 128 && values[x] >= -128) {
-                selector2 |= BYTES_1;
-            } else if (values[x] < 32768 && values[x] >= -32768) {
-                selector2 |= BYTES_2;
-            } else if (values[x] < 8388608 && values[x] >= -8388608) {
-                selector2 |= BYTES_3;
-            } else {
-                selector2 |= BYTES_4;
-            }
-        }
-
-        //Write the selectors
-        blackboxWrite((selector << 6) | selector2);
-
-        //And now the values according to the selectors we picked for them
-        for (int x = 0; x < NUM_FIELDS; x++, selector2 >>= 2) {
-            switch (selector2 & 0x03) {
-            case BYTES_1:
-                blackboxWrite(values[x]);
-                break;
-            case BYTES_2:
-                blackboxWrite(values[x]);
-                blackboxWrite(values[x] >> 8);
-                break;
-            case BYTES_3:
-                blackboxWrite(values[x]);
-                blackboxWrite(values[x] >> 8);
-                blackboxWrite(values[x] >> 16);
-                break;
-            case BYTES_4:
-                blackboxWrite(values[x]);
-                blackboxWrite(values[x] >> 8);
-                blackboxWrite(values[x] >> 16);
-                blackboxWrite(values[x] >> 24);
-                break;
-            }
-        }
+        blackboxWriteTag2_3S32Fields(selector, values);
         break;
     }
 }
@@ -256,7 +227,6 @@ void blackboxWriteTag2_3S32(int32_t *values)
  */
 int blackboxWriteTag2_3SVariable(int32_t *values)
 {
-    static const int FIELD_COUNT = 3;
     enum {
         BITS_2  = 0,
         BITS_554  = 1,
@@ -264,14 +234,6 @@ int blackboxWriteTag2_3SVariable(int32_t *values)
         BITS_32 = 3
     };
 
-    enum {
-        BYTES_1  = 0,
-        BYTES_2  = 1,
-        BYTES_3  = 2,
-        BYTES_4  = 3
-    };
-
-
     /*
      * Find out how many bits the largest value requires to encode, and use it to choose one of the packing schemes
      * below:
@@ -284,7 +246,6 @@ int blackboxWriteTag2_3SVariable(int32_t *values)
      * 32 bits per field sstt tttt followed by fields of various byte counts
      */
     int selector = BITS_2;
-    int selector2 = 0;
     // Require more than 877 bits?
     if (values[0] >= 256 || values[0] < -256
             || values[1] >= 128 || values[1] < -128
@@ -318,58 +279,8 @@ int blackboxWriteTag2_3SVariable(int32_t *values)
         blackboxWrite(((values[1] & 0x01) << 7) | (values[2] & 0x7F));
         break;
     case BITS_32:
-        /*
-         * Do another round to compute a selector for each field, assuming that they are at least 8 bits each
-         *
-         * Selector2 field possibilities
-         * 0 - 8 bits
-         * 1 - 16 bits
-         * 2 - 24 bits
-         * 3 - 32 bits
-         */
-        selector2 = 0;
-        //Encode in reverse order so the first field is in the low bits:
-        for (int x = FIELD_COUNT - 1; x >= 0; x--) {
-            selector2 <<= 2;
-
-            if (values[x] < 128 && values[x] >= -128) {
-                selector2 |= BYTES_1;
-            } else if (values[x] < 32768 && values[x] >= -32768) {
-                selector2 |= BYTES_2;
-            } else if (values[x] < 8388608 && values[x] >= -8388608) {
-                selector2 |= BYTES_3;
-            } else {
-                selector2 |= BYTES_4;
-            }
-        }
-
-        //Write the selectors
-        blackboxWrite((selector << 6) | selector2);
-
-        //And now the values according to the selectors we picked for them
-        for (int x = 0; x < FIELD_COUNT; x++, selector2 >>= 2) {
-            switch (selector2 & 0x03) {
-            case BYTES_1:
-                blackboxWrite(values[x]);
-                break;
-            case BYTES_2:
-                blackboxWrite(values[x]);
-                blackboxWrite(values[x] >> 8);
-                break;
-            case BYTES_3:
-                blackboxWrite(values[x]);
-                blackboxWrite(values[x] >> 8);
-                blackboxWrite(values[x] >> 16);
-                break;
-            case BYTES_4:
-                blackboxWrite(values[x]);
-                blackboxWrite(values[x] >> 8);
-                blackboxWrite(values[x] >> 16);
-                blackboxWrite(values[x] >> 24);
-                break;
-            }
-        }
-    break;
+        blackboxWriteTag2_3S32Fields(selector, values);
+        break;
     }
     return selector;
 }
@@ -379,7 +290,6 @@ int blackboxWriteTag2_3SVariable(int32_t *values)
  */
 void blackboxWriteTag8_4S16(int32_t *values)
 {
-
     //Need to be enums rather than const ints if we want to switch on them (due to being C)
     enum {
         FIELD_ZERO  = 0,
@@ -388,70 +298,39 @@ void blackboxWriteTag8_4S16(int32_t *values)
         FIELD_16BIT = 3
     };
 
+    // Field type and field width in bits, indexed by the significant bits of a non-zero folded value
+    static const uint8_t fieldForBits[9] = {
+        FIELD_4BIT, FIELD_4BIT, FIELD_4BIT, FIELD_4BIT, FIELD_8BIT, FIELD_8BIT, FIELD_8BIT, FIELD_8BIT, FIELD_16BIT
+    };
+    static const uint8_t fieldWidth[4] = { 0, 4, 8, 16 };
+
     uint8_t selector = 0;
-    //Encode in reverse order so the first field is in the low bits:
-    for (int x = 3; x >= 0; x--) {
-        selector <<= 2;
-
-        if (values[x] == 0) {
-            selector |= FIELD_ZERO;
-        } else if (values[x] < 8 && values[x] >= -8) {
-            selector |= FIELD_4BIT;
-        } else if (values[x] < 128 && values[x] >= -128) {
-            selector |= FIELD_8BIT;
-        } else {
-            selector |= FIELD_16BIT;
-        }
+    int field[4];
+    for (int x = 0; x < 4; x++) {
+        field[x] = values[x] == 0 ? FIELD_ZERO : fieldForBits[MIN(blackboxFoldedBits(blackboxFoldSigned(values[x])), 8)];
+        //The first field is in the low bits
+        selector |= field[x] << (x * 2);
     }
 
     blackboxWrite(selector);
 
-    int nibbleIndex = 0;
-    uint8_t buffer = 0;
-    for (int x = 0; x < 4; x++, selector >>= 2) {
-        switch (selector & 0x03) {
-        case FIELD_ZERO:
-            //No-op
-            break;
-        case FIELD_4BIT:
-            if (nibbleIndex == 0) {
-                //We fill high-bits first
-                buffer = values[x] << 4;
-                nibbleIndex = 1;
-            } else {
-                blackboxWrite(buffer | (values[x] & 0x0F));
-                nibbleIndex = 0;
-            }
-            break;
-        case FIELD_8BIT:
-            if (nibbleIndex == 0) {
-                blackboxWrite(values[x]);
-            } else {
-                //Write the high bits of the value first (mask to avoid sign extension)
-                blackboxWrite(buffer | ((values[x] >> 4) & 0x0F));
-                //Now put the leftover low bits into the top of the next buffer entry
-                buffer = values[x] << 4;
-            }
-            break;
-        case FIELD_16BIT:
-            if (nibbleIndex == 0) {
-                //Write high byte first
-                blackboxWrite(values[x] >> 8);
-                blackboxWrite(values[x]);
-            } else {
-                //First write the highest 4 bits
-                blackboxWrite(buffer | ((values[x] >> 12) & 0x0F));
-                // Then the middle 8
-                blackboxWrite(values[x] >> 4);
-                //Only the smallest 4 bits are still left to write
-                buffer = values[x] << 4;
-            }
-            break;
+    // The fields are packed most significant bit first, so a 4 bit field leaves half a byte for the next field
+    uint32_t buffer = 0;
+    int bufferBits = 0;
+    for (int x = 0; x < 4; x++) {
+        const int width = fieldWidth[field[x]];
+
+        buffer = (buffer << width) | ((uint32_t)values[x] & ((1 << width) - 1));
+        bufferBits += width;
+
+        while (bufferBits >= 8) {
+            bufferBits -= 8;
+            blackboxWrite(buffer >> bufferBits);
         }
     }
     //Anything left over to write?
-    if (nibbleIndex == 1) {
-        blackboxWrite(buffer);
+    if (bufferBits) {
+        blackboxWrite(buffer << 4);
     }
 }
 
@@ -463,33 +342,29 @@ void blackboxWriteTag8_4S16(int32_t *values)
  */
 void blackboxWriteTag8_8SVB(int32_t *values, int valueCount)
 {
-    uint8_t header;
-
-    if (valueCount > 0) {
-        //If we're only writing one field then we can skip the header
-        if (valueCount == 1) {
-            blackboxWriteSignedVB(values[0]);
-        } else {
-            //First write a one-byte header that marks which fields are non-zero
-            header = 0;
-
-            // First field should be in low bits of header
-            for (int i = valueCount - 1; i >= 0; i--) {
-                header <<= 1;
-
-                if (values[i] != 0) {
-                    header |= 0x01;
-                }
-            }
-
-            blackboxWrite(header);
-
-            for (int i = 0; i < valueCount; i++) {
-                if (values[i] != 0) {
-                    blackboxWriteSignedVB(values[i]);
-                }
-            }
-        }
+    if (valueCount <= 0) {
+        return;
+    }
+
+    //If we're only writing one field then we can skip the header
+    if (valueCount == 1) {
+        blackboxWriteSignedVB(values[0]);
+        return;
+    }
+
+    //First write a one-byte header that marks which fields are non-zero, the first field in the low bits
+    uint8_t header = 0;
+    for (int i = 0; i < valueCount; i++) {
+        header |= (values[i] != 0) << i;
+    }
+
+    blackboxWrite(header);
+
+    // Only visit the fields that are marked in the header
+    while (header) {
+        const int i = __builtin_ctz(header);
+        blackboxWriteSignedVB(values[i]);
+        header &= header - 1;
     }
 }
 
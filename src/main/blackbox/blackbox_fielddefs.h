@@ -89,7 +89,14 @@ typedef enum FlightLogFieldPredictor {
     FLIGHT_LOG_FIELD_PREDICTOR_LAST_MAIN_FRAME_TIME = 10,
 
     //Predict that this field is the minimum motor output
-    FLIGHT_LOG_FIELD_PREDICTOR_MINMOTOR       = 11
+    FLIGHT_LOG_FIELD_PREDICTOR_MINMOTOR       = 11,
+
+    //Predict that this field continues the parabola through the last three history items (3 * p1 - 3 * p2 + p3):
+    FLIGHT_LOG_FIELD_PREDICTOR_SECOND_ORDER   = 12,
+
+    //Predict the filtered gyro of the same axis decoded earlier in this frame, plus the SECOND_ORDER
+    //prediction of the difference between this field and that filtered gyro:
+    FLIGHT_LOG_FIELD_PREDICTOR_GYRO_FILTERED  = 13
 
 } FlightLogFieldPredictor;
 
@@ -130,6 +137,25 @@ typedef struct flightLogEvent_loggingResume_s {
     uint32_t currentTime;
 } flightLogEvent_loggingResume_t;
 
+typedef struct flightLogEvent_pidRateChange_s {
+    uint8_t pidProcessDenom;
+    uint32_t pidLooptime;
+} flightLogEvent_pidRateChange_t;
+
+typedef struct flightLogEvent_logRateChange_s {
+    uint16_t pInterval;
+    uint32_t bytesPerSecond;    // device throughput the new rate was chosen for
+} flightLogEvent_logRateChange_t;
+
+typedef struct flightLogEvent_logStats_s {
+    uint32_t intraframesDropped;
+    uint32_t interframesDropped;
+    uint32_t slowFramesDropped;
+    uint32_t bytesDropped;
+    uint32_t stallTimeMs;
+    uint32_t bytesPerSecond;
+} flightLogEvent_logStats_t;
+
 #define FLIGHT_LOG_EVENT_INFLIGHT_ADJUSTMENT_FUNCTION_FLOAT_VALUE_FLAG 128
 
 typedef union flightLogEventData_u {
@@ -137,6 +163,9 @@ typedef union flightLogEventData_u {
     flightLogEvent_flightMode_t flightMode; // New event data
     flightLogEvent_inflightAdjustment_t inflightAdjustment;
     flightLogEvent_loggingResume_t loggingResume;
+    flightLogEvent_pidRateChange_t pidRateChange;
+    flightLogEvent_logStats_t logStats;
+    flightLogEvent_logRateChange_t logRateChange;
 } flightLogEventData_t;
 
 typedef struct flightLogEvent_s {
@@ -33,6 +33,8 @@
 
 #include "common/maths.h"
 
+#include "drivers/time.h"
+
 #include "flight/pid.h"
 
 #include "io/asyncfatfs/asyncfatfs.h"
@@ -52,6 +54,21 @@ int32_t blackboxHeaderBudget;
 static serialPort_t *blackboxPort = NULL;
 static portSharing_e blackboxPortSharing;
 
+/*
+ * Frames are assembled here and handed to the device in one write, rather than paying the device dispatch and
+ * per-byte device call for every byte of every field.
+ */
+static uint8_t blackboxFrameBuffer[BLACKBOX_FRAME_BUFFER_SIZE];
+static uint8_t *blackboxFrameBufferPos = blackboxFrameBuffer;
+
+static timeMs_t blackboxLogStartTimeMs;
+
+// Frames started in the frame buffer since the last commit, they share the fate of that commit
+static uint8_t blackboxPendingFrames[BLACKBOX_FRAME_TYPE_COUNT];
+static blackboxDeviceStats_t blackboxStats;
+static timeMs_t blackboxStallStartMs;
+static bool blackboxStalled;
+
 #ifdef USE_SDCARD
 
 static struct {
@@ -83,24 +100,124 @@ void blackboxOpen(void)
     }
 }
 
-void blackboxWrite(uint8_t value)
+static void blackboxDeviceResetStats(void)
+{
+    memset(&blackboxStats, 0, sizeof(blackboxStats));
+    memset(blackboxPendingFrames, 0, sizeof(blackboxPendingFrames));
+    blackboxStalled = false;
+    blackboxLogStartTimeMs = millis();
+}
+
+static void blackboxDeviceAccountCommit(int length, bool accepted)
+{
+    if (accepted) {
+        blackboxStats.bytesWritten += length;
+        if (blackboxStalled) {
+            blackboxStats.stallTimeMs += millis() - blackboxStallStartMs;
+            blackboxStalled = false;
+        }
+    } else {
+        blackboxStats.bytesDropped += length;
+        if (!blackboxStalled) {
+            blackboxStallStartMs = millis();
+            blackboxStalled = true;
+        }
+    }
+
+    uint32_t *frames = accepted ? blackboxStats.framesWritten : blackboxStats.framesDropped;
+    for (int i = 0; i < BLACKBOX_FRAME_TYPE_COUNT; i++) {
+        frames[i] += blackboxPendingFrames[i];
+        blackboxPendingFrames[i] = 0;
+    }
+}
+
+/**
+ * Hand the bytes assembled in the frame buffer to the blackbox device.
+ *
+ * A write the device can't take in full is dropped and counted in the log statistics, the decoder resynchronises on
+ * the next I frame.
+ */
+void blackboxFrameBufferCommit(void)
 {
+    const int length = blackboxFrameBufferPos - blackboxFrameBuffer;
+    bool accepted = true;
+
+    if (length == 0) {
+        return;
+    }
+
     switch (blackboxConfig()->device) {
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
-        flashfsWriteByte(value); // Write byte asynchronously
+        {
+            const uint32_t offset = flashfsGetOffset();
+            flashfsWrite(blackboxFrameBuffer, length, false); // Write asynchronously
+            // flashfs silently discards what doesn't fit in its buffer
+            accepted = flashfsGetOffset() - offset == (uint32_t)length;
+        }
         break;
 #endif
 #ifdef USE_SDCARD
     case BLACKBOX_DEVICE_SDCARD:
-        afatfs_fputc(blackboxSDCard.logFile, value);
+        // Short writes happen when the buffers fill up
+        accepted = afatfs_fwrite(blackboxSDCard.logFile, blackboxFrameBuffer, length) == (uint32_t)length;
         break;
+#endif
+#ifdef USE_BLACKBOX_VCP
+    case BLACKBOX_DEVICE_VCP:
+        // The VCP blocks when its buffer is full, drop the whole write instead and resync on the next I frame
 #endif
     case BLACKBOX_DEVICE_SERIAL:
     default:
-        serialWrite(blackboxPort, value);
+        // The UART overwrites its ring when full which corrupts the frames already queued, drop this write instead
+        accepted = serialTxBytesFree(blackboxPort) >= (uint32_t)length;
+        if (accepted) {
+            serialWriteBuf(blackboxPort, blackboxFrameBuffer, length);
+        }
         break;
     }
+
+    blackboxDeviceAccountCommit(length, accepted);
+
+    blackboxFrameBufferPos = blackboxFrameBuffer;
+}
+
+/**
+ * Note the start of a frame of the given type in the frame buffer, it is counted as written or dropped along with
+ * the commit that carries it.
+ */
+void blackboxFrameBufferMarkFrame(blackboxFrameType_e type)
+{
+    blackboxPendingFrames[type]++;
+}
+
+/**
+ * Count a frame that was skipped before it reached the frame buffer.
+ */
+void blackboxDeviceCountDroppedFrame(blackboxFrameType_e type)
+{
+    blackboxStats.framesDropped[type]++;
+}
+
+void blackboxDeviceGetStats(blackboxDeviceStats_t *stats)
+{
+    *stats = blackboxStats;
+
+    const timeMs_t now = millis();
+    if (blackboxStalled) {
+        stats->stallTimeMs += now - blackboxStallStartMs;
+    }
+    stats->durationMs = now - blackboxLogStartTimeMs;
+    stats->bytesPerSecond = stats->durationMs ? (uint64_t)stats->bytesWritten * 1000 / stats->durationMs : 0;
+}
+
+void blackboxWrite(uint8_t value)
+{
+    if (blackboxFrameBufferPos >= blackboxFrameBuffer + BLACKBOX_FRAME_BUFFER_SIZE) {
+        blackboxFrameBufferCommit();
+    }
+
+    *blackboxFrameBufferPos++ = value;
 }
 
 // Print the null-terminated string 's' to the blackbox device and return the number of bytes written
@@ -109,6 +226,9 @@ int blackboxWriteString(const char *s)
     int length;
     const uint8_t *pos;
 
+    // Keep the device stream in order with the bytes that are still being assembled
+    blackboxFrameBufferCommit();
+
     switch (blackboxConfig()->device) {
 
 #ifdef USE_FLASHFS
@@ -125,6 +245,13 @@ int blackboxWriteString(const char *s)
         break;
 #endif // USE_SDCARD
 
+#ifdef USE_BLACKBOX_VCP
+    case BLACKBOX_DEVICE_VCP:
+        length = strlen(s);
+        serialWriteBuf(blackboxPort, (const uint8_t*) s, length);
+        break;
+#endif
+
     case BLACKBOX_DEVICE_SERIAL:
     default:
         pos = (uint8_t*) s;
@@ -147,6 +274,8 @@ int blackboxWriteString(const char *s)
  */
 void blackboxDeviceFlush(void)
 {
+    blackboxFrameBufferCommit();
+
     switch (blackboxConfig()->device) {
 #ifdef USE_FLASHFS
         /*
@@ -170,8 +299,13 @@ void blackboxDeviceFlush(void)
  */
 bool blackboxDeviceFlushForce(void)
 {
+    blackboxFrameBufferCommit();
+
     switch (blackboxConfig()->device) {
     case BLACKBOX_DEVICE_SERIAL:
+#ifdef USE_BLACKBOX_VCP
+    case BLACKBOX_DEVICE_VCP:
+#endif
         // Nothing to speed up flushing on serial, as serial is continuously being drained out of its buffer
         return isSerialTransmitBufferEmpty(blackboxPort);
 
@@ -198,6 +332,8 @@ bool blackboxDeviceFlushForce(void)
  */
 bool blackboxDeviceOpen(void)
 {
+    blackboxFrameBufferPos = blackboxFrameBuffer;
+
     switch (blackboxConfig()->device) {
     case BLACKBOX_DEVICE_SERIAL:
         {
@@ -257,13 +393,38 @@ bool blackboxDeviceOpen(void)
             return blackboxPort != NULL;
         }
         break;
+#ifdef USE_BLACKBOX_VCP
+    case BLACKBOX_DEVICE_VCP:
+        {
+            serialPortUsage_t *vcpUsage = findSerialPortUsageByIdentifier(SERIAL_PORT_USB_VCP);
+
+            if (!vcpUsage) {
+                return false;
+            }
+
+            // The VCP normally carries MSP, take it over for the length of the log and give it back on close
+            if (vcpUsage->serialPort) {
+                mspSerialReleasePortIfAllocated(vcpUsage->serialPort);
+            }
+
+            blackboxPort = openSerialPort(SERIAL_PORT_USB_VCP, FUNCTION_BLACKBOX, NULL, NULL, baudRates[BAUD_115200],
+                BLACKBOX_SERIAL_PORT_MODE, SERIAL_NOT_INVERTED);
+
+            // The host drains the VCP as fast as the bus allows, there is no logger buffer to protect
+            blackboxMaxHeaderBytesPerIteration = BLACKBOX_MAX_ACCUMULATED_HEADER_BUDGET;
+
+            return blackboxPort != NULL;
+        }
+        break;
+#endif // USE_BLACKBOX_VCP
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
         if (flashfsGetSize() == 0 || isBlackboxDeviceFull()) {
             return false;
         }
 
-        blackboxMaxHeaderBytesPerIteration = BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION;
+        // the binary header is short enough to go out in a few large writes
+        blackboxMaxHeaderBytesPerIteration = blackboxConfig()->binary_header ? BLACKBOX_MAX_ACCUMULATED_HEADER_BUDGET : BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION;
 
         return true;
         break;
@@ -274,7 +435,8 @@ bool blackboxDeviceOpen(void)
             return false;
         }
 
-        blackboxMaxHeaderBytesPerIteration = BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION;
+        // the binary header is short enough to go out in a few large writes
+        blackboxMaxHeaderBytesPerIteration = blackboxConfig()->binary_header ? BLACKBOX_MAX_ACCUMULATED_HEADER_BUDGET : BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION;
 
         return true;
         break;
@@ -322,6 +484,8 @@ bool isBlackboxErased(void)
  */
 void blackboxDeviceClose(void)
 {
+    blackboxFrameBufferCommit();
+
     switch (blackboxConfig()->device) {
     case BLACKBOX_DEVICE_SERIAL:
         // Can immediately close without attempting to flush any remaining data.
@@ -337,6 +501,14 @@ void blackboxDeviceClose(void)
             mspSerialAllocatePorts();
         }
         break;
+#ifdef USE_BLACKBOX_VCP
+    case BLACKBOX_DEVICE_VCP:
+        closeSerialPort(blackboxPort);
+        blackboxPort = NULL;
+
+        mspSerialAllocatePorts();
+        break;
+#endif
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
         // Some flash device, e.g., NAND devices, require explicit close to flush internally buffered data.
@@ -473,7 +645,13 @@ static bool blackboxSDCardBeginLog(void)
  */
 bool blackboxDeviceBeginLog(void)
 {
+    blackboxDeviceResetStats();
+
     switch (blackboxConfig()->device) {
+#ifdef USE_FLASHFS
+    case BLACKBOX_DEVICE_FLASH:
+        return flashfsLogIndexBegin();
+#endif // USE_FLASHFS
 #ifdef USE_SDCARD
     case BLACKBOX_DEVICE_SDCARD:
         return blackboxSDCardBeginLog();
@@ -493,11 +671,17 @@ bool blackboxDeviceBeginLog(void)
  */
 bool blackboxDeviceEndLog(bool retainLog)
 {
-#ifndef USE_SDCARD
+#if !defined(USE_SDCARD) && !defined(USE_FLASHFS)
     UNUSED(retainLog);
 #endif
 
+    blackboxFrameBufferCommit();
+
     switch (blackboxConfig()->device) {
+#ifdef USE_FLASHFS
+    case BLACKBOX_DEVICE_FLASH:
+        return flashfsLogIndexEnd(millis() - blackboxLogStartTimeMs, retainLog ? 0 : FLASHFS_LOG_INDEX_FLAG_DISCARDED);
+#endif // USE_FLASHFS
 #ifdef USE_SDCARD
     case BLACKBOX_DEVICE_SDCARD:
         // Keep retrying until the close operation queues
@@ -521,6 +705,9 @@ bool isBlackboxDeviceFull(void)
 {
     switch (blackboxConfig()->device) {
     case BLACKBOX_DEVICE_SERIAL:
+#ifdef USE_BLACKBOX_VCP
+    case BLACKBOX_DEVICE_VCP:
+#endif
         return false;
 
 #ifdef USE_FLASHFS
@@ -554,8 +741,13 @@ void blackboxReplenishHeaderBudget(void)
 {
     int32_t freeSpace;
 
+    blackboxFrameBufferCommit();
+
     switch (blackboxConfig()->device) {
     case BLACKBOX_DEVICE_SERIAL:
+#ifdef USE_BLACKBOX_VCP
+    case BLACKBOX_DEVICE_VCP:
+#endif
         freeSpace = serialTxBytesFree(blackboxPort);
         break;
 #ifdef USE_FLASHFS
@@ -594,6 +786,9 @@ void blackboxReplenishHeaderBudget(void)
  */
 blackboxBufferReserveStatus_e blackboxDeviceReserveBufferSpace(int32_t bytes)
 {
+    // Space is reserved on the device, so anything still in the frame buffer has to be accounted for there first
+    blackboxFrameBufferCommit();
+
     if (bytes <= blackboxHeaderBudget) {
         return BLACKBOX_RESERVE_SUCCESS;
     }
@@ -610,6 +805,11 @@ blackboxBufferReserveStatus_e blackboxDeviceReserveBufferSpace(int32_t bytes)
         }
         return BLACKBOX_RESERVE_TEMPORARY_FAILURE;
 
+#ifdef USE_BLACKBOX_VCP
+    case BLACKBOX_DEVICE_VCP:
+        return BLACKBOX_RESERVE_TEMPORARY_FAILURE;
+#endif
+
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
         if (bytes > (int32_t) flashfsGetWriteBufferSize()) {
@@ -38,11 +38,36 @@ typedef enum {
  */
 #define BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION 64
 
+// Bytes assembled before they are handed to the device, a full buffer is committed early
+#define BLACKBOX_FRAME_BUFFER_SIZE 256
+
+typedef enum {
+    BLACKBOX_FRAME_INTRA = 0,
+    BLACKBOX_FRAME_INTER,
+    BLACKBOX_FRAME_SLOW,
+    BLACKBOX_FRAME_TYPE_COUNT
+} blackboxFrameType_e;
+
+// Accounting for the current log, frames and bytes are counted as the device accepts or rejects them
+typedef struct blackboxDeviceStats_s {
+    uint32_t framesWritten[BLACKBOX_FRAME_TYPE_COUNT];
+    uint32_t framesDropped[BLACKBOX_FRAME_TYPE_COUNT];
+    uint32_t bytesWritten;
+    uint32_t bytesDropped;
+    uint32_t stallTimeMs;       // time spent with the device refusing writes
+    uint32_t durationMs;
+    uint32_t bytesPerSecond;    // sustained over the whole log
+} blackboxDeviceStats_t;
+
 extern int32_t blackboxHeaderBudget;
 
 void blackboxOpen(void);
 void blackboxWrite(uint8_t value);
+void blackboxFrameBufferCommit(void);
 int blackboxWriteString(const char *s);
+void blackboxFrameBufferMarkFrame(blackboxFrameType_e type);
+void blackboxDeviceCountDroppedFrame(blackboxFrameType_e type);
+void blackboxDeviceGetStats(blackboxDeviceStats_t *stats);
 
 void blackboxDeviceFlush(void);
 bool blackboxDeviceFlushForce(void);
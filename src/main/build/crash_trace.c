@@ -0,0 +1,101 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_CRASH_TRACE
+
+#include "build/crash_trace.h"
+
+#include "drivers/system.h"
+
+#include "scheduler/scheduler.h"
+
+/*
+ * The scheduler trace and the fault registers are kept in RAM that is not cleared on a reset. On the
+ * next boot they are copied into the report and the trace starts again, so the last task runs before
+ * a fault, a watchdog reset or a brown-out with the RAM still intact can be read after the reboot.
+ * The magic number depends on the task count, so a trace left by other firmware is not taken.
+ */
+#define CRASH_TRACE_MAGIC (0xc7a5e000 | TASK_COUNT)
+
+typedef struct crashTracePersistent_s {
+    uint32_t magic;
+    bool faulted;
+    crashTraceFault_t fault;
+} crashTracePersistent_t;
+
+static PERSISTENT crashTracePersistent_t crashTracePersistent;
+
+static crashTraceReport_t crashTraceReport;
+static bool crashTraceReportValid;
+
+// called after systemInit(), which reads the reset flags, and before the scheduler runs a task
+void crashTraceInit(void)
+{
+    if (crashTracePersistent.magic == CRASH_TRACE_MAGIC) {
+        crashTraceReport.resetFlags = cachedRccCsrValue;
+        crashTraceReport.faulted = crashTracePersistent.faulted;
+        crashTraceReport.fault = crashTracePersistent.fault;
+
+        const uint32_t nextSequence = schedulerTraceSequence();
+        const uint32_t oldestSequence = nextSequence > SCHEDULER_TRACE_SIZE ? nextSequence - SCHEDULER_TRACE_SIZE : 0;
+        uint8_t count = 0;
+        for (uint32_t sequence = oldestSequence; sequence != nextSequence; sequence++) {
+            if (schedulerTraceRead(sequence, &crashTraceReport.entries[count]) && crashTraceReport.entries[count].taskId < TASK_COUNT) {
+                count++;
+            }
+        }
+        crashTraceReport.entryCount = count;
+        crashTraceReportValid = true;
+    }
+
+    schedulerTraceClear();
+    memset(&crashTracePersistent, 0, sizeof(crashTracePersistent));
+    crashTracePersistent.magic = CRASH_TRACE_MAGIC;
+}
+
+// exceptionFrame are the registers stacked on exception entry: r0-r3, r12, lr, pc, psr
+void crashTraceFault(const uint32_t *exceptionFrame)
+{
+    crashTraceFault_t *fault = &crashTracePersistent.fault;
+
+    fault->pc = exceptionFrame[6];
+    fault->lr = exceptionFrame[5];
+    fault->psr = exceptionFrame[7];
+    fault->cfsr = SCB->CFSR;
+    fault->hfsr = SCB->HFSR;
+    fault->mmfar = SCB->MMFAR;
+    fault->bfar = SCB->BFAR;
+    fault->taskId = schedulerCurrentTaskId();
+    crashTracePersistent.faulted = true;
+}
+
+// NULL when the previous run left no trace, as after a power on
+const crashTraceReport_t *crashTraceGetReport(void)
+{
+    return crashTraceReportValid ? &crashTraceReport : NULL;
+}
+
+#endif
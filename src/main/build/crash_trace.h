@@ -0,0 +1,57 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#include "scheduler/scheduler.h"
+
+#ifdef USE_CRASH_TRACE
+
+// core registers and fault status on a hard fault
+typedef struct crashTraceFault_s {
+    uint32_t pc;
+    uint32_t lr;
+    uint32_t psr;
+    uint32_t cfsr;
+    uint32_t hfsr;
+    uint32_t mmfar;
+    uint32_t bfar;
+    uint8_t taskId;             // task running when the fault was taken, TASK_NONE if none
+} crashTraceFault_t;
+
+// what the previous run left in RAM before its reset
+typedef struct crashTraceReport_s {
+    uint32_t resetFlags;        // RCC->CSR of the reset that ended it
+    bool faulted;
+    crashTraceFault_t fault;
+    uint8_t entryCount;
+    schedulerTraceEntry_t entries[SCHEDULER_TRACE_SIZE]; // oldest first
+} crashTraceReport_t;
+
+void crashTraceInit(void);
+void crashTraceFault(const uint32_t *exceptionFrame);
+const crashTraceReport_t *crashTraceGetReport(void);
+
+#endif
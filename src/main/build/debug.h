@@ -25,6 +25,8 @@ extern int16_t debug[DEBUG16_VALUE_COUNT];
 extern uint8_t debugMode;
 
 #define DEBUG_SET(mode, index, value) {if (debugMode == (mode)) {debug[(index)] = (value);}}
+// for hot paths built with and without debug output, enabled is a compile time constant that removes the test
+#define DEBUG_SET_IF(enabled, mode, index, value) {if ((enabled) && debugMode == (mode)) {debug[(index)] = (value);}}
 
 #define DEBUG_SECTION_TIMES
 
@@ -92,6 +94,8 @@ typedef enum {
     DEBUG_RC_SMOOTHING,
     DEBUG_RX_SIGNAL_LOSS,
     DEBUG_RC_SMOOTHING_RATE,
+    DEBUG_RPM_FILTER,
+    DEBUG_IDLE_SLEEP,
     DEBUG_COUNT
 } debugType_e;
 
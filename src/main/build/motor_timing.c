@@ -0,0 +1,336 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_MOTOR_TIMING
+
+#include "build/atomic.h"
+#include "build/motor_timing.h"
+#include "build/profiler.h"
+
+#include "common/maths.h"
+#include "common/time.h"
+
+#include "drivers/nvic.h"
+#include "drivers/time.h"
+
+#include "fc/runtime_config.h"
+
+#include "sensors/gyro.h"
+
+#define MOTOR_TIMING_TEST_IMPULSE_DPS   100.0f
+#define MOTOR_TIMING_TEST_INTERVAL_US   20000   // between the impulses, for the last one to have passed the filters
+#define MOTOR_TIMING_TEST_TIMEOUT_US    10000
+
+typedef enum {
+    MOTOR_TIMING_TEST_IDLE = 0,
+    MOTOR_TIMING_TEST_INJECTED,
+    MOTOR_TIMING_TEST_PID_DONE,
+    MOTOR_TIMING_TEST_MIXER_DONE,
+    MOTOR_TIMING_TEST_OUTPUT_STARTED,
+} motorTimingTestStage_e;
+
+static motorTimingHistogram_t motorTimingHistograms[MOTOR_TIMING_HISTOGRAM_COUNT];
+
+static uint32_t cyclesPerTenthUs;
+static uint32_t outputStartCycles;
+static uint32_t lastOutputInterval;
+static bool outputStarted;
+static volatile uint8_t pendingTransfers;
+static timeUs_t rxFrameUs;              // RX frame whose setpoints have not reached the motors yet
+
+static motorTimingHistogram_t motorTimingTestHistograms[MOTOR_TIMING_TEST_HISTOGRAM_COUNT];
+static motorTimingTestStatus_t testStatus;
+static volatile uint8_t testStage;
+static uint32_t testImpulseCycles;
+static uint32_t testStageCycles;
+static bool testImpulseCancelPending;
+
+// the cycle counter is started by profilerInit()
+void motorTimingInit(void)
+{
+    cyclesPerTenthUs = MAX(SystemCoreClock / 10000000, 1U);
+
+    motorTimingReset();
+}
+
+static FAST_CODE void histogramAdd(motorTimingHistogram_t *histogram, uint32_t value)
+{
+    const int index = value == 0 ? 0 : MIN(32 - __builtin_clz(value), MOTOR_TIMING_BUCKET_COUNT - 1);
+    if (histogram->bucket[index] == UINT16_MAX) {
+        for (int i = 0; i < MOTOR_TIMING_BUCKET_COUNT; i++) {
+            histogram->bucket[i] >>= 1;
+        }
+    }
+    histogram->bucket[index]++;
+}
+
+static FAST_CODE void motorTimingAdd(motorTimingHistogram_e id, uint32_t value)
+{
+    histogramAdd(&motorTimingHistograms[id], value);
+}
+
+static FAST_CODE void motorTimingTestAdvance(motorTimingTestHistogram_e id)
+{
+    const uint32_t cycles = profilerCycles();
+    histogramAdd(&motorTimingTestHistograms[id], (cycles - testStageCycles) / cyclesPerTenthUs);
+    testStageCycles = cycles;
+    testStage++;
+}
+
+// called right before the motor DMA is enabled, transferCount is the number of transfer complete interrupts to expect
+FAST_CODE void motorTimingOutputStart(uint8_t transferCount)
+{
+    const uint32_t cycles = profilerCycles();
+
+    const timeUs_t nowUs = micros();
+
+    const timeDelta_t gyroToOutputUs = cmpTimeUs(nowUs, gyroGetSampleTimeUs());
+    if (gyroToOutputUs >= 0) {
+        motorTimingAdd(MOTOR_TIMING_GYRO_TO_OUTPUT, gyroToOutputUs * 10);
+    }
+
+    if (rxFrameUs) {
+        const timeDelta_t rxToOutputUs = cmpTimeUs(nowUs, rxFrameUs);
+        if (rxToOutputUs >= 0) {
+            motorTimingAdd(MOTOR_TIMING_RX_TO_OUTPUT, rxToOutputUs);
+        }
+        rxFrameUs = 0;
+    }
+
+    if (outputStarted) {
+        const uint32_t interval = cycles - outputStartCycles;
+        if (lastOutputInterval) {
+            motorTimingAdd(MOTOR_TIMING_OUTPUT_JITTER, abs((int32_t)(interval - lastOutputInterval)) / cyclesPerTenthUs);
+        }
+        lastOutputInterval = interval;
+    }
+
+    if (testStage == MOTOR_TIMING_TEST_MIXER_DONE) {
+        motorTimingTestAdvance(MOTOR_TIMING_TEST_MIXER_TO_OUTPUT);
+    }
+
+    outputStartCycles = cycles;
+    outputStarted = true;
+    pendingTransfers = transferCount;
+}
+
+// called from the motor DMA transfer complete interrupt
+FAST_CODE void motorTimingOutputComplete(void)
+{
+    if (pendingTransfers && --pendingTransfers == 0) {
+        const uint32_t cycles = profilerCycles();
+        motorTimingAdd(MOTOR_TIMING_OUTPUT_DURATION, (cycles - outputStartCycles) / cyclesPerTenthUs);
+
+        if (testStage == MOTOR_TIMING_TEST_OUTPUT_STARTED) {
+            histogramAdd(&motorTimingTestHistograms[MOTOR_TIMING_TEST_OUTPUT_DURATION], (cycles - testStageCycles) / cyclesPerTenthUs);
+            histogramAdd(&motorTimingTestHistograms[MOTOR_TIMING_TEST_TOTAL], (cycles - testImpulseCycles) / cyclesPerTenthUs);
+            testStage = MOTOR_TIMING_TEST_IDLE;
+            testStatus.completed++;
+            testStatus.runsLeft--;
+        }
+    }
+}
+
+// called when the setpoints have been calculated from new RC data, frameUs is the time the last byte of its frame was
+// received, 0 if the RC data did not come from a new frame
+FAST_CODE void motorTimingRxSetpoint(timeUs_t frameUs)
+{
+    if (!frameUs) {
+        return;
+    }
+    const timeDelta_t rxToSetpointUs = cmpTimeUs(micros(), frameUs);
+    if (rxToSetpointUs >= 0) {
+        motorTimingAdd(MOTOR_TIMING_RX_TO_SETPOINT, rxToSetpointUs);
+        rxFrameUs = frameUs;
+    }
+}
+
+// the histograms are filled from the PID loop and the DMA interrupt, so they are copied with interrupts off
+bool motorTimingGetHistogram(motorTimingHistogram_e id, motorTimingHistogram_t *histogram)
+{
+    if (id >= MOTOR_TIMING_HISTOGRAM_COUNT) {
+        return false;
+    }
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        *histogram = motorTimingHistograms[id];
+    }
+    return true;
+}
+
+static uint32_t histogramPercentile(const motorTimingHistogram_t *histogram, unsigned permille)
+{
+    uint32_t total = 0;
+    for (int i = 0; i < MOTOR_TIMING_BUCKET_COUNT; i++) {
+        total += histogram->bucket[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    const uint32_t threshold = (total * permille + 999) / 1000;
+    uint32_t count = 0;
+    int index = 0;
+    for (; index < MOTOR_TIMING_BUCKET_COUNT - 1; index++) {
+        count += histogram->bucket[index];
+        if (count >= threshold) {
+            break;
+        }
+    }
+    return (1 << index) - 1;
+}
+
+/*
+ * Returns the upper bound, in the unit of the histogram, of the bucket containing the given percentile (in 1/1000ths)
+ */
+uint32_t motorTimingPercentile(motorTimingHistogram_e id, unsigned permille)
+{
+    motorTimingHistogram_t histogram;
+    if (!motorTimingGetHistogram(id, &histogram)) {
+        return 0;
+    }
+    return histogramPercentile(&histogram, permille);
+}
+
+void motorTimingReset(void)
+{
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        memset(motorTimingHistograms, 0, sizeof(motorTimingHistograms));
+        outputStarted = false;
+        lastOutputInterval = 0;
+        pendingTransfers = 0;
+        rxFrameUs = 0;
+    }
+}
+
+
+/*
+ * Bench latency test: while disarmed, an impulse is added to the board roll rate of an aligned gyro sample every
+ * MOTOR_TIMING_TEST_INTERVAL_US and followed through the PID controller and mixer to the motor DMA that
+ * sends its result. Motors are not armed, so the impulse only changes what would have been sent.
+ */
+bool motorTimingTestStart(uint16_t runs)
+{
+    if (ARMING_FLAG(ARMED)) {
+        return false;
+    }
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        memset(motorTimingTestHistograms, 0, sizeof(motorTimingTestHistograms));
+        memset(&testStatus, 0, sizeof(testStatus));
+        testStage = MOTOR_TIMING_TEST_IDLE;
+        // the first impulse goes into the next sample
+        testImpulseCycles = profilerCycles() - MOTOR_TIMING_TEST_INTERVAL_US * cyclesPerTenthUs * 10;
+        testStatus.runsLeft = runs;
+    }
+    return true;
+}
+
+void motorTimingTestGetStatus(motorTimingTestStatus_t *status)
+{
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        *status = testStatus;
+    }
+}
+
+bool motorTimingTestGetHistogram(motorTimingTestHistogram_e id, motorTimingHistogram_t *histogram)
+{
+    if (id >= MOTOR_TIMING_TEST_HISTOGRAM_COUNT) {
+        return false;
+    }
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        *histogram = motorTimingTestHistograms[id];
+    }
+    return true;
+}
+
+uint32_t motorTimingTestPercentile(motorTimingTestHistogram_e id, unsigned permille)
+{
+    motorTimingHistogram_t histogram;
+    if (!motorTimingTestGetHistogram(id, &histogram)) {
+        return 0;
+    }
+    return histogramPercentile(&histogram, permille);
+}
+
+// Called with every aligned sample of the gyro in use, returns the deg/s to add to its board roll rate. Every impulse is
+// cancelled by the opposite one in the next sample, so the attitude estimate does not drift during the test.
+FAST_CODE float motorTimingTestImpulse(void)
+{
+    if (testImpulseCancelPending) {
+        testImpulseCancelPending = false;
+        return -MOTOR_TIMING_TEST_IMPULSE_DPS;
+    }
+    if (!testStatus.runsLeft) {
+        return 0.0f;
+    }
+
+    const uint32_t cycles = profilerCycles();
+    const uint32_t cyclesPerUs = cyclesPerTenthUs * 10;
+
+    if (testStage != MOTOR_TIMING_TEST_IDLE) {
+        if (cycles - testImpulseCycles > MOTOR_TIMING_TEST_TIMEOUT_US * cyclesPerUs) {
+            ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+                // the motor DMA interrupt may have completed the run meanwhile
+                if (testStage != MOTOR_TIMING_TEST_IDLE) {
+                    testStage = MOTOR_TIMING_TEST_IDLE;
+                    testStatus.timedOut++;
+                    testStatus.runsLeft--;
+                }
+            }
+        }
+        return 0.0f;
+    }
+
+    if (ARMING_FLAG(ARMED)) {
+        testStatus.runsLeft = 0;
+        return 0.0f;
+    }
+    if (cycles - testImpulseCycles < MOTOR_TIMING_TEST_INTERVAL_US * cyclesPerUs) {
+        return 0.0f;
+    }
+
+    testImpulseCycles = cycles;
+    testStageCycles = cycles;
+    testStage = MOTOR_TIMING_TEST_INJECTED;
+    testImpulseCancelPending = true;
+
+    return MOTOR_TIMING_TEST_IMPULSE_DPS;
+}
+
+FAST_CODE void motorTimingTestPidDone(void)
+{
+    if (testStage == MOTOR_TIMING_TEST_INJECTED) {
+        motorTimingTestAdvance(MOTOR_TIMING_TEST_GYRO_TO_PID);
+    }
+}
+
+FAST_CODE void motorTimingTestMixerDone(void)
+{
+    if (testStage == MOTOR_TIMING_TEST_PID_DONE) {
+        motorTimingTestAdvance(MOTOR_TIMING_TEST_PID_TO_MIXER);
+    }
+}
+
+#endif
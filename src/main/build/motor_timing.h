@@ -0,0 +1,82 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#include "common/time.h"
+
+#define MOTOR_TIMING_BUCKET_COUNT 16
+
+// the ids are part of MSP_MOTOR_TIMING, new histograms are only added at the end
+typedef enum {
+    MOTOR_TIMING_GYRO_TO_OUTPUT = 0,    // gyro sample to the start of the motor DMA
+    MOTOR_TIMING_OUTPUT_JITTER,         // change of the interval between two motor updates
+    MOTOR_TIMING_OUTPUT_DURATION,       // start of the motor DMA to the last transfer complete
+    MOTOR_TIMING_RX_TO_SETPOINT,        // last byte of an RX frame to the setpoints calculated from it, in 1us
+    MOTOR_TIMING_RX_TO_OUTPUT,          // last byte of an RX frame to the start of the first motor DMA after its setpoints, in 1us
+    MOTOR_TIMING_HISTOGRAM_COUNT
+} motorTimingHistogram_e;
+
+// log2 bucketed histogram in 0.1us units (1us for the RX ones), bucket n (n > 0) counts values in [2^(n-1), 2^n - 1]
+// all buckets are halved when one of them saturates, so percentiles are over a decaying window
+typedef struct motorTimingHistogram_s {
+    uint16_t bucket[MOTOR_TIMING_BUCKET_COUNT];
+} motorTimingHistogram_t;
+
+// stages of the bench latency test, in 0.1us, the ids are part of MSP_MOTOR_TIMING_TEST
+typedef enum {
+    MOTOR_TIMING_TEST_GYRO_TO_PID = 0,      // impulse added to a gyro sample to the end of the PID controller run that saw it
+    MOTOR_TIMING_TEST_PID_TO_MIXER,         // to the end of the mixer run after it
+    MOTOR_TIMING_TEST_MIXER_TO_OUTPUT,      // to the start of the motor DMA after it
+    MOTOR_TIMING_TEST_OUTPUT_DURATION,      // to the last transfer complete of that motor DMA
+    MOTOR_TIMING_TEST_TOTAL,                // impulse to the last transfer complete
+    MOTOR_TIMING_TEST_HISTOGRAM_COUNT
+} motorTimingTestHistogram_e;
+
+typedef struct motorTimingTestStatus_s {
+    uint16_t runsLeft;
+    uint16_t completed;
+    uint16_t timedOut;                      // runs that did not reach a motor DMA transfer complete
+} motorTimingTestStatus_t;
+
+#ifdef USE_MOTOR_TIMING
+
+void motorTimingInit(void);
+void motorTimingOutputStart(uint8_t transferCount);
+void motorTimingOutputComplete(void);
+void motorTimingRxSetpoint(timeUs_t frameUs);
+bool motorTimingGetHistogram(motorTimingHistogram_e id, motorTimingHistogram_t *histogram);
+uint32_t motorTimingPercentile(motorTimingHistogram_e id, unsigned permille);
+void motorTimingReset(void);
+
+bool motorTimingTestStart(uint16_t runs);
+void motorTimingTestGetStatus(motorTimingTestStatus_t *status);
+bool motorTimingTestGetHistogram(motorTimingTestHistogram_e id, motorTimingHistogram_t *histogram);
+uint32_t motorTimingTestPercentile(motorTimingTestHistogram_e id, unsigned permille);
+float motorTimingTestImpulse(void);
+void motorTimingTestPidDone(void);
+void motorTimingTestMixerDone(void);
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_PROFILER
+
+#include "build/profiler.h"
+
+#include "common/maths.h"
+
+#if defined(SIMULATOR_BUILD)
+// the SITL PID loop only runs in the main thread
+#define PROFILER_ATOMIC_BLOCK
+#else
+#include "build/atomic.h"
+
+#include "drivers/nvic.h"
+
+#define PROFILER_ATOMIC_BLOCK ATOMIC_BLOCK(NVIC_PRIO_MAX)
+#endif
+
+static profilerStats_t profilerStats[PROFILER_PROBE_COUNT];
+
+// the cycle counter is started by cycleCounterInit(), micros() is based on it
+void profilerInit(void)
+{
+    profilerReset();
+}
+
+FAST_CODE void profilerRecord(profilerProbe_e probe, uint32_t cycles)
+{
+    profilerStats_t *stats = &profilerStats[probe];
+    if (cycles < stats->minCycles) {
+        stats->minCycles = cycles;
+    }
+    if (cycles > stats->maxCycles) {
+        stats->maxCycles = cycles;
+    }
+    stats->totalCycles += cycles;
+    stats->count++;
+#ifdef USE_PROFILER_HISTOGRAMS
+    stats->histogram[cycles == 0 ? 0 : MIN(32 - __builtin_clz(cycles), PROFILER_HISTOGRAM_BUCKET_COUNT - 1)]++;
+#endif
+}
+
+// the PID loop may record from an interrupt, so the stats are copied with interrupts off
+bool profilerGetStats(profilerProbe_e probe, profilerStats_t *stats)
+{
+    if (probe >= PROFILER_PROBE_COUNT) {
+        return false;
+    }
+    PROFILER_ATOMIC_BLOCK {
+        *stats = profilerStats[probe];
+    }
+    return true;
+}
+
+void profilerReset(void)
+{
+    PROFILER_ATOMIC_BLOCK {
+        memset(profilerStats, 0, sizeof(profilerStats));
+        for (int probe = 0; probe < PROFILER_PROBE_COUNT; probe++) {
+            profilerStats[probe].minCycles = UINT32_MAX;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+// the ids are part of MSP_PROFILER, new probes are only added at the end
+typedef enum {
+    PROFILER_GYRO_UPDATE = 0,
+    PROFILER_GYRO_READ,
+    PROFILER_GYRO_RPM_FILTER,
+    PROFILER_GYRO_DYN_NOTCH,
+    PROFILER_GYRO_STATIC_FILTERS,
+    PROFILER_GYRO_ANALYSE,
+    PROFILER_PID_CONTROLLER,
+    PROFILER_MIX_TABLE,
+    PROFILER_WRITE_MOTORS,
+    PROFILER_BLACKBOX_UPDATE,
+    PROFILER_PROBE_COUNT
+} profilerProbe_e;
+
+#ifdef USE_PROFILER_HISTOGRAMS
+// bucket n counts the runs of less than 2^n cycles that did not fit into a lower bucket
+#define PROFILER_HISTOGRAM_BUCKET_COUNT 24
+#endif
+
+typedef struct profilerStats_s {
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+#ifdef USE_PROFILER_HISTOGRAMS
+    uint32_t histogram[PROFILER_HISTOGRAM_BUCKET_COUNT];
+#endif
+} profilerStats_t;
+
+#ifdef USE_PROFILER
+
+#if defined(UNIT_TEST)
+// the tests drive the cycle counter
+#define PROFILER_CLOCK_HZ SystemCoreClock
+
+uint32_t profilerCycles(void);
+#elif defined(SIMULATOR_BUILD)
+// there is no cycle counter on the host, the probes count nanoseconds
+#define PROFILER_CLOCK_HZ 1000000000
+
+static inline uint32_t profilerCycles(void)
+{
+    return nanos64_real();
+}
+#else
+#define PROFILER_CLOCK_HZ SystemCoreClock
+
+static inline uint32_t profilerCycles(void)
+{
+    return DWT->CYCCNT;
+}
+#endif
+
+void profilerInit(void);
+void profilerRecord(profilerProbe_e probe, uint32_t cycles);
+bool profilerGetStats(profilerProbe_e probe, profilerStats_t *stats);
+void profilerReset(void);
+
+// times the code between PROFILER_BEGIN and PROFILER_END in the same block
+#define PROFILER_BEGIN(probe) const uint32_t profilerStart_##probe = profilerCycles()
+#define PROFILER_END(probe) profilerRecord(probe, profilerCycles() - profilerStart_##probe)
+
+// a stage that is spread over a loop, the spans are added up and recorded once after the loop,
+// a stage that did not run in the loop is not recorded
+#define PROFILER_SPAN_DECLARE(probe) uint32_t profilerSpan_##probe = 0
+#define PROFILER_SPAN_BEGIN(probe) const uint32_t profilerSpanStart_##probe = profilerCycles()
+#define PROFILER_SPAN_END(probe) profilerSpan_##probe += profilerCycles() - profilerSpanStart_##probe
+#define PROFILER_SPAN_RECORD(probe) {if (profilerSpan_##probe) {profilerRecord(probe, profilerSpan_##probe);}}
+
+#else
+
+#define PROFILER_BEGIN(probe)
+#define PROFILER_END(probe)
+#define PROFILER_SPAN_DECLARE(probe)
+#define PROFILER_SPAN_BEGIN(probe)
+#define PROFILER_SPAN_END(probe)
+#define PROFILER_SPAN_RECORD(probe)
+
+#endif
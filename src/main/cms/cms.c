@@ -69,6 +69,8 @@
 
 #include "rx/rx.h"
 
+#include "scheduler/scheduler.h"
+
 #ifdef USE_USB_CDC_HID
 #include "sensors/battery.h"
 #include "pg/usb.h"
@@ -328,6 +330,24 @@ static void cmsPadToSize(char *buf, int size)
 #endif
 }
 
+#define CMS_DRAW_BUFFER_LEN 12
+
+// The value last written on each row, polled values are only written again when they changed.
+// Cleared with the screen.
+#define CMS_VALUE_CACHE_ROWS 16
+
+typedef struct cmsValueCache_s {
+    uint8_t colpos;
+    char value[CMS_DRAW_BUFFER_LEN + 1];
+} cmsValueCache_t;
+
+static cmsValueCache_t cmsValueCache[CMS_VALUE_CACHE_ROWS];
+
+static void cmsValueCacheReset(void)
+{
+    memset(cmsValueCache, 0, sizeof(cmsValueCache));
+}
+
 static int cmsDrawMenuItemValue(displayPort_t *pDisplay, char *buff, uint8_t row, uint8_t maxSize)
 {
     int colpos;
@@ -339,13 +359,22 @@ static int cmsDrawMenuItemValue(displayPort_t *pDisplay, char *buff, uint8_t row
 #else
     colpos = smallScreen ? rightMenuColumn - maxSize : rightMenuColumn;
 #endif
+
+    if (row < CMS_VALUE_CACHE_ROWS && maxSize <= CMS_DRAW_BUFFER_LEN) {
+        cmsValueCache_t *cache = &cmsValueCache[row];
+        if (cache->colpos == colpos && strcmp(cache->value, buff) == 0) {
+            return 0;
+        }
+        cache->colpos = colpos;
+        strcpy(cache->value, buff);
+    }
+
     cnt = displayWrite(pDisplay, colpos, row, buff);
     return cnt;
 }
 
 static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
 {
-    #define CMS_DRAW_BUFFER_LEN 12
     #define CMS_NUM_FIELD_LEN 5
 
     char buff[CMS_DRAW_BUFFER_LEN +1]; // Make room for null terminator.
@@ -499,6 +528,18 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
     return cnt;
 }
 
+// Stops drawing the menu when the scheduler runs short of time, the rest is drawn in the next slot
+#define CMS_ENTRY_DRAW_TIME_US 30
+
+static bool cmsDrawTimeExhausted(void)
+{
+    if (schedulerGetRemainingTimeUs() < CMS_ENTRY_DRAW_TIME_US) {
+        schedulerYield();
+        return true;
+    }
+    return false;
+}
+
 static void cmsDrawMenu(displayPort_t *pDisplay, uint32_t currentTimeUs)
 {
     if (!pageTop)
@@ -525,6 +566,7 @@ static void cmsDrawMenu(displayPort_t *pDisplay, uint32_t currentTimeUs)
             SET_PRINTLABEL(p);
             SET_PRINTVALUE(p);
         }
+        cmsValueCacheReset();
         pDisplay->cleared = false;
     } else if (drawPolled) {
         for (p = pageTop ; p <= pageTop + pageMaxRow ; p++) {
@@ -556,6 +598,7 @@ static void cmsDrawMenu(displayPort_t *pDisplay, uint32_t currentTimeUs)
         return;
 
     // Print text labels
+    // Entries still flagged for printing when running out of room or time are printed on the next call.
     for (i = 0, p = pageTop; i < maxMenuItems && p->type != OME_END; i++, p++) {
         if (IS_PRINTLABEL(p)) {
             uint8_t coloff = leftMenuColumn;
@@ -564,6 +607,8 @@ static void cmsDrawMenu(displayPort_t *pDisplay, uint32_t currentTimeUs)
             CLR_PRINTLABEL(p);
             if (room < 30)
                 return;
+            if (cmsDrawTimeExhausted())
+                return;
         }
 
     // Print values
@@ -575,6 +620,8 @@ static void cmsDrawMenu(displayPort_t *pDisplay, uint32_t currentTimeUs)
             room -= cmsDrawMenuEntry(pDisplay, p, top + i * linesPerMenuItem);
             if (room < 30)
                 return;
+            if (cmsDrawTimeExhausted())
+                return;
         }
     }
 }
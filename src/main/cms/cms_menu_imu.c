@@ -43,6 +43,7 @@
 
 #include "fc/config.h"
 #include "fc/controlrate_profile.h"
+#include "fc/fc_rc.h"
 #include "fc/rc_controls.h"
 #include "fc/runtime_config.h"
 
@@ -138,7 +139,7 @@ static long cmsx_PidWriteback(const OSD_Entry *self)
         pidProfile->pid[i].I = tempPid[i][1];
         pidProfile->pid[i].D = tempPid[i][2];
     }
-    pidInitConfig(currentPidProfile);
+    pidPrepareProfile(currentPidProfile);
 
     return 0;
 }
@@ -189,6 +190,8 @@ static long cmsx_RateProfileWriteback(const OSD_Entry *self)
     UNUSED(self);
 
     memcpy(controlRateProfilesMutable(rateProfileIndex), &rateProfile, sizeof(controlRateConfig_t));
+    // the rate curve lookup tables are built from the profile
+    initRcProcessing();
 
     return 0;
 }
@@ -270,7 +273,7 @@ static long cmsx_profileOtherOnExit(const OSD_Entry *self)
     pidProfile_t *pidProfile = pidProfilesMutable(pidProfileIndex);
     pidProfile->dtermSetpointWeight = cmsx_dtermSetpointWeight;
     pidProfile->setpointRelaxRatio = cmsx_setpointRelaxRatio;
-    pidInitConfig(currentPidProfile);
+    pidPrepareProfile(currentPidProfile);
 
     pidProfile->pid[PID_LEVEL].P = cmsx_angleStrength;
     pidProfile->pid[PID_LEVEL].I = cmsx_horizonStrength;
@@ -67,6 +67,44 @@ FAST_CODE float pt1FilterApply(pt1Filter_t *filter, float input)
     return filter->state;
 }
 
+// Kalman filter with adaptive measurement noise
+
+// k is the PT1 gain the filter settles to when the measured noise variance equals noiseVariance,
+// cleaner input raises the gain towards 1 and noisier input lowers it
+void kalmanFilterInit(kalmanFilter_t *filter, float k, float noiseVariance)
+{
+    memset(filter, 0, sizeof(kalmanFilter_t));
+    // steady state of k = p / (p + r) for a random walk
+    filter->q = noiseVariance * k * k / (1.0f - k);
+    filter->p = filter->q;
+}
+
+FAST_CODE float kalmanFilterApply(kalmanFilter_t *filter, float input)
+{
+    // the differences remove the slowly changing signal, white noise doubles in variance when differenced
+    const float delta = input - filter->lastInput;
+    filter->lastInput = input;
+    filter->deltaSquaredSum += delta * delta - filter->deltaSquared[filter->windowIndex];
+    filter->deltaSquared[filter->windowIndex] = delta * delta;
+    filter->windowIndex = (filter->windowIndex + 1) & (KALMAN_FILTER_WINDOW - 1);
+    if (filter->windowIndex == 0) {
+        // the running sum picks up rounding errors, so it is summed afresh once per window
+        float deltaSquaredSum = 0;
+        for (int i = 0; i < KALMAN_FILTER_WINDOW; i++) {
+            deltaSquaredSum += filter->deltaSquared[i];
+        }
+        filter->deltaSquaredSum = deltaSquaredSum;
+    }
+    const float r = MAX(filter->deltaSquaredSum, 0.0f) * (0.5f / KALMAN_FILTER_WINDOW);
+
+    filter->p += filter->q;
+    const float k = filter->p / (filter->p + r);
+    filter->x += k * (input - filter->x);
+    filter->p *= 1.0f - k;
+
+    return filter->x;
+}
+
 // Slew filter with limit
 
 void slewFilterInit(slewFilter_t *filter, float slewLimit, float threshold)
@@ -172,6 +210,34 @@ FAST_CODE void biquadFilterUpdate(biquadFilter_t *filter, float filterFreq, uint
     filter->y2 = y2;
 }
 
+/*
+ * Retunes a notch for dynamic filtering, leaving the filter state untouched.
+ * The frequency is below Nyquist, so only one of sine and cosine needs evaluating,
+ * the other follows with a square root. The coefficients need a single division.
+ */
+FAST_CODE void biquadFilterUpdateNotch(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate, float Q)
+{
+    const float omega = 2.0f * M_PI_FLOAT * filterFreq * refreshRate * 0.000001f;
+    float sn, cs;
+    if (omega > 0.25f * M_PI_FLOAT && omega < 0.75f * M_PI_FLOAT) {
+        // the sine is evaluated where the result is small, so the square root keeps full precision
+        cs = sin_table(0.5f * M_PI_FLOAT - omega);
+        sn = sqrtf(1.0f - cs * cs);
+    } else {
+        sn = sin_table(omega);
+        const float cosMagnitude = sqrtf(MAX(1.0f - sn * sn, 0.0f));
+        cs = (omega > 0.5f * M_PI_FLOAT) ? -cosMagnitude : cosMagnitude;
+    }
+    const float alpha = sn / (2.0f * Q);
+
+    const float a0Reciprocal = 1.0f / (1.0f + alpha);
+    filter->b0 = a0Reciprocal;
+    filter->b1 = -2.0f * cs * a0Reciprocal;
+    filter->b2 = a0Reciprocal;
+    filter->a1 = filter->b1;
+    filter->a2 = (1.0f - alpha) * a0Reciprocal;
+}
+
 FAST_CODE void biquadFilterUpdateLPF(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate)
 {
     biquadFilterUpdate(filter, filterFreq, refreshRate, BIQUAD_Q, FILTER_LPF);
@@ -203,6 +269,235 @@ FAST_CODE float biquadFilterApply(biquadFilter_t *filter, float input)
     return result;
 }
 
+// Filter chains
+
+void filterChainInit(filterChain_t *chain)
+{
+    memset(chain, 0, sizeof(filterChain_t));
+}
+
+// Adds a filter set up for use with applyFn, stages using nullFilterApply are left out.
+// PT1 stages are always applied after the biquads, which does not change the response of the chain.
+// Returns false if the chain has no room for the filter or cannot apply this kind of filter.
+bool filterChainAdd(filterChain_t *chain, filterApplyFnPtr applyFn, void *filter)
+{
+    if (applyFn == (filterApplyFnPtr)biquadFilterApplyDF1) {
+        chain->biquadDF1 = filter;
+    } else if (applyFn == (filterApplyFnPtr)biquadFilterApply && chain->biquadCount < FILTER_CHAIN_MAX_BIQUAD) {
+        chain->biquad[chain->biquadCount++] = filter;
+    } else if (applyFn == (filterApplyFnPtr)pt1FilterApply && chain->pt1Count < FILTER_CHAIN_MAX_PT1) {
+        chain->pt1[chain->pt1Count++] = filter;
+    } else if (applyFn != nullFilterApply) {
+        return false;
+    }
+    return true;
+}
+
+// one apply function per combination of stages, the constant loop counts let the compiler unroll and inline every stage
+#define FILTER_CHAIN_APPLY_FN(df1, biquads, pt1s) \
+static FAST_CODE float filterChainApply_##df1##_##biquads##_##pt1s(const filterChain_t *chain, float input) \
+{ \
+    UNUSED(chain); \
+    if (df1) { \
+        input = biquadFilterApplyDF1(chain->biquadDF1, input); \
+    } \
+    for (int i = 0; i < biquads; i++) { \
+        input = biquadFilterApply(chain->biquad[i], input); \
+    } \
+    for (int i = 0; i < pt1s; i++) { \
+        input = pt1FilterApply(chain->pt1[i], input); \
+    } \
+    return input; \
+}
+
+#define FILTER_CHAIN_APPLY_FNS_PT1(df1, biquads) \
+    FILTER_CHAIN_APPLY_FN(df1, biquads, 0) \
+    FILTER_CHAIN_APPLY_FN(df1, biquads, 1) \
+    FILTER_CHAIN_APPLY_FN(df1, biquads, 2)
+
+#define FILTER_CHAIN_APPLY_FNS(df1) \
+    FILTER_CHAIN_APPLY_FNS_PT1(df1, 0) \
+    FILTER_CHAIN_APPLY_FNS_PT1(df1, 1) \
+    FILTER_CHAIN_APPLY_FNS_PT1(df1, 2) \
+    FILTER_CHAIN_APPLY_FNS_PT1(df1, 3) \
+    FILTER_CHAIN_APPLY_FNS_PT1(df1, 4)
+
+FILTER_CHAIN_APPLY_FNS(0)
+FILTER_CHAIN_APPLY_FNS(1)
+
+#define FILTER_CHAIN_APPLY_FN_ENTRIES_PT1(df1, biquads) \
+    { filterChainApply_##df1##_##biquads##_0, filterChainApply_##df1##_##biquads##_1, filterChainApply_##df1##_##biquads##_2 }
+
+#define FILTER_CHAIN_APPLY_FN_ENTRIES(df1) \
+    { \
+        FILTER_CHAIN_APPLY_FN_ENTRIES_PT1(df1, 0), \
+        FILTER_CHAIN_APPLY_FN_ENTRIES_PT1(df1, 1), \
+        FILTER_CHAIN_APPLY_FN_ENTRIES_PT1(df1, 2), \
+        FILTER_CHAIN_APPLY_FN_ENTRIES_PT1(df1, 3), \
+        FILTER_CHAIN_APPLY_FN_ENTRIES_PT1(df1, 4), \
+    }
+
+static const filterChainApplyFnPtr filterChainApplyFns[2][FILTER_CHAIN_MAX_BIQUAD + 1][FILTER_CHAIN_MAX_PT1 + 1] = {
+    FILTER_CHAIN_APPLY_FN_ENTRIES(0),
+    FILTER_CHAIN_APPLY_FN_ENTRIES(1),
+};
+
+filterChainApplyFnPtr filterChainGetApplyFn(const filterChain_t *chain)
+{
+    return filterChainApplyFns[chain->biquadDF1 ? 1 : 0][chain->biquadCount][chain->pt1Count];
+}
+
+void biquadFilterBankInit(biquadFilterBank_t *bank)
+{
+    memset(bank, 0, sizeof(biquadFilterBank_t));
+}
+
+static bool biquadFilterBankAddStage(biquadFilterBank_t *bank, float b0, float b1, float b2, float a1, float a2)
+{
+    if (bank->stageCount >= BIQUAD_FILTER_BANK_MAX_STAGES) {
+        return false;
+    }
+
+    biquadFilterBankStage_t *stage = &bank->stage[bank->stageCount++];
+    memset(stage, 0, sizeof(biquadFilterBankStage_t));
+    stage->b0 = b0;
+    stage->b1 = b1;
+    stage->b2 = b2;
+    stage->a1 = a1;
+    stage->a2 = a2;
+    return true;
+}
+
+// takes the coefficients of an initialised biquad, the same filter is then applied to every axis
+bool biquadFilterBankAddBiquad(biquadFilterBank_t *bank, const biquadFilter_t *filter)
+{
+    return biquadFilterBankAddStage(bank, filter->b0, filter->b1, filter->b2, filter->a1, filter->a2);
+}
+
+// a PT1 is a biquad with y[n] = k * x[n] + (1 - k) * y[n-1]
+bool biquadFilterBankAddPt1(biquadFilterBank_t *bank, float k)
+{
+    return biquadFilterBankAddStage(bank, k, 0.0f, 0.0f, k - 1.0f, 0.0f);
+}
+
+// filters data[0..2] in place, Direct form 2 transposed like biquadFilterApply()
+FAST_CODE void biquadFilterBankApply(biquadFilterBank_t *bank, float *data)
+{
+    float x = data[0];
+    float y = data[1];
+    float z = data[2];
+
+    for (int i = 0; i < bank->stageCount; i++) {
+        biquadFilterBankStage_t *stage = &bank->stage[i];
+        const float b0 = stage->b0;
+        const float b1 = stage->b1;
+        const float b2 = stage->b2;
+        const float a1 = stage->a1;
+        const float a2 = stage->a2;
+
+        const float rx = b0 * x + stage->x1[0];
+        const float ry = b0 * y + stage->x1[1];
+        const float rz = b0 * z + stage->x1[2];
+
+        stage->x1[0] = b1 * x - a1 * rx + stage->x2[0];
+        stage->x1[1] = b1 * y - a1 * ry + stage->x2[1];
+        stage->x1[2] = b1 * z - a1 * rz + stage->x2[2];
+
+        stage->x2[0] = b2 * x - a2 * rx;
+        stage->x2[1] = b2 * y - a2 * ry;
+        stage->x2[2] = b2 * z - a2 * rz;
+
+        x = rx;
+        y = ry;
+        z = rz;
+    }
+
+    data[0] = x;
+    data[1] = y;
+    data[2] = z;
+}
+
+// takes the coefficients of a built float bank, so both banks always describe the same filters
+void biquadFilterFixedBankInit(biquadFilterFixedBank_t *fixedBank, const biquadFilterBank_t *bank)
+{
+    const float coeffScale = 1 << FIXED_FILTER_COEFF_BITS;
+
+    memset(fixedBank, 0, sizeof(biquadFilterFixedBank_t));
+    fixedBank->stageCount = bank->stageCount;
+    for (int i = 0; i < bank->stageCount; i++) {
+        const biquadFilterBankStage_t *stage = &bank->stage[i];
+        biquadFilterFixedBankStage_t *fixedStage = &fixedBank->stage[i];
+        fixedStage->b0 = lrintf(stage->b0 * coeffScale);
+        fixedStage->b1 = lrintf(stage->b1 * coeffScale);
+        fixedStage->b2 = lrintf(stage->b2 * coeffScale);
+        fixedStage->a1 = lrintf(stage->a1 * coeffScale);
+        fixedStage->a2 = lrintf(stage->a2 * coeffScale);
+    }
+}
+
+// filters data[0..2] in place, data is in Q FIXED_FILTER_DATA_BITS and the 64 bit sums map to a single multiply accumulate on Cortex-M3
+FAST_CODE void biquadFilterFixedBankApply(biquadFilterFixedBank_t *bank, int32_t *data)
+{
+    for (int i = 0; i < bank->stageCount; i++) {
+        biquadFilterFixedBankStage_t *stage = &bank->stage[i];
+        for (int axis = 0; axis < BIQUAD_FILTER_BANK_AXIS_COUNT; axis++) {
+            const int32_t input = data[axis];
+            int64_t acc = (int64_t)stage->b0 * input;
+            acc += (int64_t)stage->b1 * stage->x1[axis];
+            acc += (int64_t)stage->b2 * stage->x2[axis];
+            acc -= (int64_t)stage->a1 * stage->y1[axis];
+            acc -= (int64_t)stage->a2 * stage->y2[axis];
+            const int32_t result = (acc + (1 << (FIXED_FILTER_COEFF_BITS - 1))) >> FIXED_FILTER_COEFF_BITS;
+
+            stage->x2[axis] = stage->x1[axis];
+            stage->x1[axis] = input;
+            stage->y2[axis] = stage->y1[axis];
+            stage->y1[axis] = result;
+            data[axis] = result;
+        }
+    }
+}
+
+// CIC decimator
+
+void cicDecimatorInit(cicDecimator_t *filter, uint8_t ratio)
+{
+    memset(filter, 0, sizeof(cicDecimator_t));
+    filter->ratio = constrain(ratio, 1, CIC_DECIMATOR_MAX_RATIO);
+    filter->gain = 1;
+    for (int i = 0; i < CIC_DECIMATOR_ORDER; i++) {
+        filter->gain *= filter->ratio;
+    }
+}
+
+// Feeds one 16 bit input sample, every ratio samples the decimated output is set and true returned.
+// The integrators are allowed to wrap, modular arithmetic still gives the exact comb output.
+FAST_CODE bool cicDecimatorApply(cicDecimator_t *filter, int32_t input, int32_t *output)
+{
+    uint32_t x = (uint32_t)input;
+    for (int i = 0; i < CIC_DECIMATOR_ORDER; i++) {
+        filter->integrator[i] += x;
+        x = filter->integrator[i];
+    }
+
+    if (++filter->phase < filter->ratio) {
+        return false;
+    }
+    filter->phase = 0;
+
+    for (int i = 0; i < CIC_DECIMATOR_ORDER; i++) {
+        const uint32_t y = x - filter->combDelay[i];
+        filter->combDelay[i] = x;
+        x = y;
+    }
+
+    // remove the DC gain of ratio^order, rounding to nearest
+    const int32_t sum = (int32_t)x;
+    const int32_t halfGain = filter->gain / 2;
+    *output = (sum + (sum >= 0 ? halfGain : -halfGain)) / filter->gain;
+    return true;
+}
+
 void laggedMovingAverageInit(laggedMovingAverage_t *filter, uint16_t windowSize, float *buf)
 {
     filter->movingWindowIndex = 0;
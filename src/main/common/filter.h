@@ -41,6 +41,68 @@ typedef struct biquadFilter_s {
     float x1, x2, y1, y2;
 } biquadFilter_t;
 
+#define BIQUAD_FILTER_BANK_AXIS_COUNT  3
+#define BIQUAD_FILTER_BANK_MAX_STAGES  4
+
+/* a cascade of biquad sections applied to three axes at once. Every stage
+ * has a single set of coefficients shared by all axes, the per axis state
+ * is kept side by side so a stage is applied to all axes in one pass */
+typedef struct biquadFilterBankStage_s {
+    float b0, b1, b2, a1, a2;
+    float x1[BIQUAD_FILTER_BANK_AXIS_COUNT];
+    float x2[BIQUAD_FILTER_BANK_AXIS_COUNT];
+} biquadFilterBankStage_t;
+
+typedef struct biquadFilterBank_s {
+    uint8_t stageCount;
+    biquadFilterBankStage_t stage[BIQUAD_FILTER_BANK_MAX_STAGES];
+} biquadFilterBank_t;
+
+#define FIXED_FILTER_COEFF_BITS 29  // Q2.29, covers the |coefficient| < 4 of any stable biquad
+#define FIXED_FILTER_DATA_BITS  8   // Q23.8, 16 bit gyro data leaves headroom for the notch gain
+
+/* integer version of the filter bank for targets without an FPU, the stages
+ * are Direct form 1 so rounding in the feedback path stays below one LSB */
+typedef struct biquadFilterFixedBankStage_s {
+    int32_t b0, b1, b2, a1, a2;
+    int32_t x1[BIQUAD_FILTER_BANK_AXIS_COUNT];
+    int32_t x2[BIQUAD_FILTER_BANK_AXIS_COUNT];
+    int32_t y1[BIQUAD_FILTER_BANK_AXIS_COUNT];
+    int32_t y2[BIQUAD_FILTER_BANK_AXIS_COUNT];
+} biquadFilterFixedBankStage_t;
+
+typedef struct biquadFilterFixedBank_s {
+    uint8_t stageCount;
+    biquadFilterFixedBankStage_t stage[BIQUAD_FILTER_BANK_MAX_STAGES];
+} biquadFilterFixedBank_t;
+
+#define CIC_DECIMATOR_ORDER     3
+#define CIC_DECIMATOR_MAX_RATIO 16
+
+/* integer cascaded integrator comb filter, the integrators run at the input
+ * rate and the combs once every ratio samples */
+typedef struct cicDecimator_s {
+    uint32_t integrator[CIC_DECIMATOR_ORDER];
+    uint32_t combDelay[CIC_DECIMATOR_ORDER];
+    int32_t gain;
+    uint8_t ratio;
+    uint8_t phase;
+} cicDecimator_t;
+
+#define KALMAN_FILTER_WINDOW 16  // must be a power of two
+
+/* scalar Kalman filter for a random walk, the measurement noise is estimated
+ * from the variance of the sample to sample differences over a short window */
+typedef struct kalmanFilter_s {
+    float x;    // state estimate
+    float p;    // estimate covariance
+    float q;    // process noise
+    float lastInput;
+    float deltaSquaredSum;
+    float deltaSquared[KALMAN_FILTER_WINDOW];
+    uint8_t windowIndex;
+} kalmanFilter_t;
+
 typedef struct laggedMovingAverage_s {
     uint16_t movingWindowIndex;
     uint16_t windowSize;
@@ -52,6 +114,7 @@ typedef struct laggedMovingAverage_s {
 typedef enum {
     FILTER_PT1 = 0,
     FILTER_BIQUAD,
+    FILTER_KALMAN,
 } lowpassFilterType_e;
 
 typedef enum {
@@ -62,17 +125,48 @@ typedef enum {
 
 typedef float (*filterApplyFnPtr)(filter_t *filter, float input);
 
+#define FILTER_CHAIN_MAX_BIQUAD 4
+#define FILTER_CHAIN_MAX_PT1    2
+
+/* the active stages of a filter chain, in the order they are applied:
+ * the DF1 biquad (if any), the DF2 biquads, then the PT1s */
+typedef struct filterChain_s {
+    biquadFilter_t *biquadDF1;
+    biquadFilter_t *biquad[FILTER_CHAIN_MAX_BIQUAD];
+    pt1Filter_t *pt1[FILTER_CHAIN_MAX_PT1];
+    uint8_t biquadCount;
+    uint8_t pt1Count;
+} filterChain_t;
+
+typedef float (*filterChainApplyFnPtr)(const filterChain_t *chain, float input);
+
 float nullFilterApply(filter_t *filter, float input);
 
 void biquadFilterInitLPF(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate);
 void biquadFilterInit(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate, float Q, biquadFilterType_e filterType);
 void biquadFilterUpdate(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate, float Q, biquadFilterType_e filterType);
 void biquadFilterUpdateLPF(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate);
+void biquadFilterUpdateNotch(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate, float Q);
 
 float biquadFilterApplyDF1(biquadFilter_t *filter, float input);
 float biquadFilterApply(biquadFilter_t *filter, float input);
 float filterGetNotchQ(float centerFreq, float cutoffFreq);
 
+void filterChainInit(filterChain_t *chain);
+bool filterChainAdd(filterChain_t *chain, filterApplyFnPtr applyFn, void *filter);
+filterChainApplyFnPtr filterChainGetApplyFn(const filterChain_t *chain);
+
+void biquadFilterBankInit(biquadFilterBank_t *bank);
+bool biquadFilterBankAddBiquad(biquadFilterBank_t *bank, const biquadFilter_t *filter);
+bool biquadFilterBankAddPt1(biquadFilterBank_t *bank, float k);
+void biquadFilterBankApply(biquadFilterBank_t *bank, float *data);
+
+void biquadFilterFixedBankInit(biquadFilterFixedBank_t *fixedBank, const biquadFilterBank_t *bank);
+void biquadFilterFixedBankApply(biquadFilterFixedBank_t *bank, int32_t *data);
+
+void cicDecimatorInit(cicDecimator_t *filter, uint8_t ratio);
+bool cicDecimatorApply(cicDecimator_t *filter, int32_t input, int32_t *output);
+
 void laggedMovingAverageInit(laggedMovingAverage_t *filter, uint16_t windowSize, float *buf);
 float laggedMovingAverageUpdate(laggedMovingAverage_t *filter, float input);
 
@@ -81,5 +175,8 @@ void pt1FilterInit(pt1Filter_t *filter, float k);
 void pt1FilterUpdateCutoff(pt1Filter_t *filter, float k);
 float pt1FilterApply(pt1Filter_t *filter, float input);
 
+void kalmanFilterInit(kalmanFilter_t *filter, float k, float noiseVariance);
+float kalmanFilterApply(kalmanFilter_t *filter, float input);
+
 void slewFilterInit(slewFilter_t *filter, float slewLimit, float threshold);
 float slewFilterApply(slewFilter_t *filter, float input);
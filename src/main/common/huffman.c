@@ -30,77 +30,61 @@
 
 int huffmanEncodeBuf(uint8_t *outBuf, int outBufLen, const uint8_t *inBuf, int inLen, const huffmanTable_t *huffmanTable)
 {
-    int ret = 0;
-
-    uint8_t *outByte = outBuf;
-    *outByte = 0;
-    uint8_t outBit = 0x80;
-
-    for (int ii = 0; ii < inLen; ++ii) {
-        const int huffCodeLen = huffmanTable[*inBuf].codeLen;
-        const uint16_t huffCode = huffmanTable[*inBuf].code;
-        ++inBuf;
-        uint16_t testBit = 0x8000;
-
-        for (int jj = 0; jj < huffCodeLen; ++jj) {
-            if (huffCode & testBit) {
-                *outByte |= outBit;
-            }
-
-            testBit >>= 1;
-            outBit >>= 1;
-            if (outBit == 0) {
-                outBit = 0x80;
-                ++outByte;
-                *outByte = 0;
-                ++ret;
-            }
-
-            if (ret >= outBufLen && ii < inLen - 1 && jj < huffCodeLen - 1) {
-                return -1;
-            }
-        }
+    huffmanState_t state = {
+        .bytesWritten = 0,
+        .outByte = outBuf,
+        .outBufLen = outBufLen,
+        .outBit = 0x80,
+    };
+    *outBuf = 0;
+
+    if (huffmanEncodeBufStreaming(&state, inBuf, inLen, huffmanTable) == -1) {
+        return -1;
     }
-    if (outBit != 0x80) {
+    if (state.outBit != 0x80) {
         // ensure last character in output buffer is counted
-        ++ret;
+        ++state.bytesWritten;
     }
-    return ret;
+    return state.bytesWritten;
 }
 
 int huffmanEncodeBufStreaming(huffmanState_t *state, const uint8_t *inBuf, int inLen, const huffmanTable_t *huffmanTable)
 {
-    uint8_t *savedOutBytePtr = state->outByte;
-    uint8_t savedOutByte = *savedOutBytePtr;
+    uint8_t *outByte = state->outByte;
+    int bytesWritten = state->bytesWritten;
+    const uint8_t savedOutByte = *outByte;
 
-    for (const uint8_t *pos = inBuf, *end = inBuf + inLen; pos < end; ++pos) {
-        const int huffCodeLen = huffmanTable[*pos].codeLen;
-        const uint16_t huffCode = huffmanTable[*pos].code;
-        uint16_t testBit = 0x8000;
+    // Bits not written out yet, left aligned and starting with those of the partial output byte.
+    // The codes in the table are left aligned too, so each is merged in with a single shift.
+    uint32_t bits = (uint32_t)savedOutByte << 24;
+    int bitCount = __builtin_clz(state->outBit) - 24;
 
-        for (int jj = 0; jj < huffCodeLen; ++jj) {
-            if (huffCode & testBit) {
-                *state->outByte |= state->outBit;
-            }
+    for (const uint8_t *pos = inBuf, *end = inBuf + inLen; pos < end; ++pos) {
+        const huffmanTable_t *entry = &huffmanTable[*pos];
+        bits |= (uint32_t)entry->code << (16 - bitCount);
+        bitCount += entry->codeLen;
 
-            testBit >>= 1;
-            state->outBit >>= 1;
-            if (state->outBit == 0) {
-                state->outBit = 0x80;
-                ++state->outByte;
-                *state->outByte = 0;
-                ++state->bytesWritten;
-            }
+        // a code is at most 16 bits long, so this writes at most two bytes
+        while (bitCount >= 8) {
+            *outByte++ = bits >> 24;
+            bits <<= 8;
+            bitCount -= 8;
+            ++bytesWritten;
 
             // if buffer is filled and we haven't finished compressing
-            if (state->bytesWritten >= state->outBufLen && (pos < end - 1 || jj < huffCodeLen - 1)) {
-                // restore savedOutByte
-                *savedOutBytePtr = savedOutByte;
+            if (bytesWritten >= state->outBufLen && (pos < end - 1 || bitCount > 0)) {
+                // leave the state and the partial byte as they were before this call
+                *state->outByte = savedOutByte;
                 return -1;
             }
         }
     }
 
+    *outByte = bits >> 24;
+    state->outByte = outByte;
+    state->bytesWritten = bytesWritten;
+    state->outBit = 0x80 >> bitCount;
+
     return 0;
 }
 
@@ -44,4 +44,6 @@ struct huffmanInfo_s {
 #define HUFFMAN_INFO_SIZE sizeof(struct huffmanInfo_s)
 
 int huffmanEncodeBuf(uint8_t *outBuf, int outBufLen, const uint8_t *inBuf, int inLen, const huffmanTable_t *huffmanTable);
+// Appends the codes of inBuf to the output described by state. Returns -1, and leaves the state
+// unchanged, when they do not fit into the outBufLen bytes of the output.
 int huffmanEncodeBufStreaming(huffmanState_t *state, const uint8_t *inBuf, int inLen, const huffmanTable_t *huffmanTable);
@@ -18,9 +18,12 @@
  * If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <math.h>
 
+#include "platform.h"
+
 #include "axis.h"
 #include "maths.h"
 
@@ -60,6 +63,51 @@ float cos_approx(float x)
     return sin_approx(x + (0.5f * M_PIf));
 }
 
+#ifdef USE_TRIG_TABLE
+#define TRIG_TABLE_QUARTER_LENGTH 256
+
+// a quarter sine wave, the entry past the end lets the last segment interpolate
+// to the peak without a range check
+static FAST_RAM_ZERO_INIT float sinTable[TRIG_TABLE_QUARTER_LENGTH + 2];
+
+void trigTableInit(void)
+{
+    for (int i = 0; i <= TRIG_TABLE_QUARTER_LENGTH; i++) {
+        sinTable[i] = sinf(i * (0.5f * M_PIf) / TRIG_TABLE_QUARTER_LENGTH);
+    }
+    sinTable[TRIG_TABLE_QUARTER_LENGTH + 1] = sinTable[TRIG_TABLE_QUARTER_LENGTH];
+}
+
+// sin_table maximum absolute error = 5.2e-06
+float sin_table(float x)
+{
+    int32_t xint = x;
+    if (xint < -32 || xint > 32) return 0.0f;                               // Stop here on error input (5 * 360 Deg)
+
+    float quarterTurns = x * (2.0f / M_PIf);
+    const bool negative = quarterTurns < 0;
+    if (negative) {
+        quarterTurns = -quarterTurns;
+    }
+    const int quarter = quarterTurns;
+    const float fraction = quarterTurns - quarter;
+
+    // the sine falls back towards zero in the second and fourth quarter, and is negative in the second half turn
+    const float position = ((quarter & 1) ? 1.0f - fraction : fraction) * TRIG_TABLE_QUARTER_LENGTH;
+    const int index = position;
+    float value = sinTable[index] + (position - index) * (sinTable[index + 1] - sinTable[index]);
+    if (((quarter & 2) != 0) != negative) {
+        value = -value;
+    }
+    return value;
+}
+
+float cos_table(float x)
+{
+    return sin_table(x + (0.5f * M_PIf));
+}
+#endif // USE_TRIG_TABLE
+
 // Initial implementation by Crashpilot1000 (https://github.com/Crashpilot1000/HarakiriWebstore1/blob/396715f73c6fcf859e0db0f34e12fe44bace6483/src/mw.c#L1292)
 // Polynomial coefficients by Andor (http://www.dsprelated.com/showthread/comp.dsp/21872-1.php) optimized by Ledvinap to save one multiplication
 // Max absolute error 0,000027 degree
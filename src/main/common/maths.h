@@ -138,6 +138,18 @@ float pow_approx(float a, float b);
 #define pow_approx(a, b)    powf(b, a)
 #endif
 
+// Interpolated quarter wave table, for sine and cosine evaluated every PID loop.
+// Without it they fall back to the approximations above.
+#ifdef USE_TRIG_TABLE
+void trigTableInit(void);
+float sin_table(float x);
+float cos_table(float x);
+#else
+#define trigTableInit()
+#define sin_table(x)    sin_approx(x)
+#define cos_table(x)    cos_approx(x)
+#endif
+
 void arraySubInt32(int32_t *dest, int32_t *array1, int32_t *array2, int count);
 
 int16_t qPercent(fix12_t q);
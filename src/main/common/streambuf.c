@@ -35,18 +35,45 @@ void sbufWriteU8(sbuf_t *dst, uint8_t val)
     *dst->ptr++ = val;
 }
 
+// The stream is little endian. On a little endian CPU the multi-byte accessors copy the value as a whole, memcpy()
+// compiles to a single unaligned load or store on the Cortex-M3 and up (and on the SITL host).
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define SBUF_NATIVE_LITTLE_ENDIAN
+#endif
+
 void sbufWriteU16(sbuf_t *dst, uint16_t val)
 {
+#ifdef SBUF_NATIVE_LITTLE_ENDIAN
+    memcpy(dst->ptr, &val, sizeof(val));
+    dst->ptr += sizeof(val);
+#else
     sbufWriteU8(dst, val >> 0);
     sbufWriteU8(dst, val >> 8);
+#endif
 }
 
 void sbufWriteU32(sbuf_t *dst, uint32_t val)
 {
+#ifdef SBUF_NATIVE_LITTLE_ENDIAN
+    memcpy(dst->ptr, &val, sizeof(val));
+    dst->ptr += sizeof(val);
+#else
     sbufWriteU8(dst, val >> 0);
     sbufWriteU8(dst, val >> 8);
     sbufWriteU8(dst, val >> 16);
     sbufWriteU8(dst, val >> 24);
+#endif
+}
+
+void sbufWriteU16Array(sbuf_t *dst, const uint16_t *data, int count)
+{
+#ifdef SBUF_NATIVE_LITTLE_ENDIAN
+    sbufWriteData(dst, data, count * sizeof(*data));
+#else
+    for (int i = 0; i < count; i++) {
+        sbufWriteU16(dst, data[i]);
+    }
+#endif
 }
 
 void sbufWriteU16BigEndian(sbuf_t *dst, uint16_t val)
@@ -94,21 +121,43 @@ uint8_t sbufReadU8(sbuf_t *src)
 uint16_t sbufReadU16(sbuf_t *src)
 {
     uint16_t ret;
+#ifdef SBUF_NATIVE_LITTLE_ENDIAN
+    memcpy(&ret, src->ptr, sizeof(ret));
+    src->ptr += sizeof(ret);
+#else
     ret = sbufReadU8(src);
     ret |= sbufReadU8(src) << 8;
+#endif
     return ret;
 }
 
 uint32_t sbufReadU32(sbuf_t *src)
 {
     uint32_t ret;
+#ifdef SBUF_NATIVE_LITTLE_ENDIAN
+    memcpy(&ret, src->ptr, sizeof(ret));
+    src->ptr += sizeof(ret);
+#else
     ret = sbufReadU8(src);
     ret |= sbufReadU8(src) <<  8;
     ret |= sbufReadU8(src) << 16;
     ret |= sbufReadU8(src) << 24;
+#endif
     return ret;
 }
 
+void sbufReadU16Array(sbuf_t *src, uint16_t *data, int count)
+{
+#ifdef SBUF_NATIVE_LITTLE_ENDIAN
+    memcpy(data, src->ptr, count * sizeof(*data));
+    src->ptr += count * sizeof(*data);
+#else
+    for (int i = 0; i < count; i++) {
+        data[i] = sbufReadU16(src);
+    }
+#endif
+}
+
 void sbufReadData(sbuf_t *src, void *data, int len)
 {
     memcpy(data, src->ptr, len);
@@ -55,8 +55,105 @@ void li2a(long num, char *bf)
 
 #endif
 
+// two digit groups, so a single division by 100 yields two characters
+static const char decimalDigitPairs[200] = {
+    '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+    '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+    '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+    '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+    '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+    '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+    '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+    '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+    '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+    '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9',
+};
+
+// Writes the decimal digits of num to the end of the 10 characters before end, returns the first one.
+// The divisions are by the constant 100, which the compiler turns into a multiply and a shift.
+static char *ui2aDecimalDigits(uint32_t num, char *end)
+{
+    char *p = end;
+    while (num >= 100) {
+        const uint32_t quotient = num / 100;
+        const char *pair = &decimalDigitPairs[(num - quotient * 100) * 2];
+        *--p = pair[1];
+        *--p = pair[0];
+        num = quotient;
+    }
+    if (num >= 10) {
+        *--p = decimalDigitPairs[num * 2 + 1];
+        *--p = decimalDigitPairs[num * 2];
+    } else {
+        *--p = '0' + num;
+    }
+    return p;
+}
+
+int ui2aDecimal(uint32_t num, char *bf)
+{
+    char digits[10];
+    char *end = digits + sizeof(digits);
+    const char *p = ui2aDecimalDigits(num, end);
+    const int length = end - p;
+    memcpy(bf, p, length);
+    bf[length] = 0;
+    return length;
+}
+
+int i2aDecimal(int32_t num, char *bf)
+{
+    if (num < 0) {
+        *bf = '-';
+        return ui2aDecimal(-(uint32_t)num, bf + 1) + 1;
+    }
+    return ui2aDecimal(num, bf);
+}
+
+char *i2aPadded(int32_t num, int width, char pad, char *bf)
+{
+    char digits[11];
+    char *end = digits + sizeof(digits);
+    char *p = ui2aDecimalDigits(num < 0 ? -(uint32_t)num : (uint32_t)num, end);
+    if (num < 0) {
+        if (pad == '0') {
+            *bf++ = '-';
+            --width;
+        } else {
+            *--p = '-';
+        }
+    }
+    const int length = end - p;
+    for (int i = length; i < width; i++) {
+        *bf++ = pad;
+    }
+    memcpy(bf, p, length);
+    bf += length;
+    *bf = 0;
+    return bf;
+}
+
 void ui2a(unsigned int num, unsigned int base, int uc, char *bf)
 {
+    if (base == 10) {
+        ui2aDecimal(num, bf);
+        return;
+    }
+
+    if (base == 16) {
+        // one digit per nibble, starting with the highest that is set
+        const char *hexDigits = uc ? "0123456789ABCDEF" : "0123456789abcdef";
+        int shift = 0;
+        while (shift < (int)(sizeof(num) * 8 - 4) && (num >> (shift + 4))) {
+            shift += 4;
+        }
+        for (; shift >= 0; shift -= 4) {
+            *bf++ = hexDigits[(num >> shift) & 0xf];
+        }
+        *bf = 0;
+        return;
+    }
+
     unsigned int d = 1;
 
     while (num / d >= base)
@@ -75,11 +172,7 @@ void ui2a(unsigned int num, unsigned int base, int uc, char *bf)
 
 void i2a(int num, char *bf)
 {
-    if (num < 0) {
-        num = -num;
-        *bf++ = '-';
-    }
-    ui2a(num, 10, 0, bf);
+    i2aDecimal(num, bf);
 }
 
 int a2d(char ch)
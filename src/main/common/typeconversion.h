@@ -20,12 +20,21 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #define FTOA_BUFFER_LENGTH 11
 
 void uli2a(unsigned long int num, unsigned int base, int uc, char *bf);
 void li2a(long num, char *bf);
 void ui2a(unsigned int num, unsigned int base, int uc, char *bf);
 void i2a(int num, char *bf);
+// Decimal conversions for the output paths that format many numbers, like the OSD and the CLI.
+// They return the number of characters written, bf is NUL terminated.
+int ui2aDecimal(uint32_t num, char *bf);
+int i2aDecimal(int32_t num, char *bf);
+// num right aligned in at least width characters, like "%5d" with pad ' ' or "%05d" with pad '0'.
+// Returns the terminating NUL, so the next characters can be appended from there.
+char *i2aPadded(int32_t num, int width, char pad, char *bf);
 char a2i(char ch, const char **src, int base, int *nump);
 char *ftoa(float x, char *floatString);
 float fastA2F(const char *p);
@@ -27,6 +27,7 @@
 #include "build/build_config.h"
 
 #include "common/crc.h"
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "config/config_eeprom.h"
@@ -51,6 +52,10 @@ typedef enum {
 #define CR_CLASSIFICATION_MASK  (0x3)
 #define CRC_START_VALUE         0xFFFF
 #define CRC_CHECK_VALUE         0x1D0F  // pre-calculated value of CRC that includes the CRC itself
+#define CR_SIZE_ERASED          0xFFFF  // size of a record in erased flash, nothing was stored from here on
+
+// The streamer pads each write to a whole flash word
+#define EEPROM_ALIGN(p)         (&__config_start + (((p) - &__config_start + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1)))
 
 // Header for the saved copy.
 typedef struct {
@@ -106,20 +111,10 @@ bool isEEPROMVersionValid(void)
     return true;
 }
 
-// Scan the EEPROM config. Returns true if the config is valid.
-bool isEEPROMStructureValid(void)
+// Scan a run of records at p up to its footer and CRC, with crc covering what precedes the run.
+// Returns the end of the run, or NULL if it isn't valid.
+static const uint8_t *scanEEPROMRecords(const uint8_t *p, uint16_t crc)
 {
-    const uint8_t *p = &__config_start;
-    const configHeader_t *header = (const configHeader_t *)p;
-
-    if (header->magic_be != 0xBE) {
-        return false;
-    }
-
-    uint16_t crc = CRC_START_VALUE;
-    crc = crc16_ccitt_update(crc, header, sizeof(*header));
-    p += sizeof(*header);
-
     for (;;) {
         const configRecord_t *record = (const configRecord_t *)p;
 
@@ -130,7 +125,7 @@ bool isEEPROMStructureValid(void)
         if (p + record->size >= &__config_end
             || record->size < sizeof(*record)) {
             // Too big or too small.
-            return false;
+            return NULL;
         }
 
         crc = crc16_ccitt_update(crc, p, record->size);
@@ -145,12 +140,48 @@ bool isEEPROMStructureValid(void)
     // include stored CRC in the CRC calculation
     const uint16_t *storedCrc = (const uint16_t *)p;
     crc = crc16_ccitt_update(crc, storedCrc, sizeof(*storedCrc));
-    p += sizeof(storedCrc);
+    p += sizeof(*storedCrc);
+
+    // CRC has the property that if the CRC itself is included in the calculation the resulting CRC will have constant value
+    if (crc != CRC_CHECK_VALUE) {
+        return NULL;
+    }
+
+    return EEPROM_ALIGN(p);
+}
+
+// Scan the EEPROM config. Returns true if the config is valid.
+bool isEEPROMStructureValid(void)
+{
+    const uint8_t *p = &__config_start;
+    const configHeader_t *header = (const configHeader_t *)p;
+
+    if (header->magic_be != 0xBE) {
+        return false;
+    }
+
+    uint16_t crc = CRC_START_VALUE;
+    crc = crc16_ccitt_update(crc, header, sizeof(*header));
+    p = scanEEPROMRecords(p + sizeof(*header), crc);
+    if (!p) {
+        return false;
+    }
+
+#ifdef USE_EEPROM_APPEND
+    // Records saved since the last full write follow as runs of their own, each with its own CRC. A run that was cut
+    // short by a reset is dropped along with anything after it, the next save will then rewrite the whole config.
+    while (p + sizeof(configRecord_t) < &__config_end && ((const configRecord_t *)p)->size != CR_SIZE_ERASED) {
+        const uint8_t *runEnd = scanEEPROMRecords(p, CRC_START_VALUE);
+        if (!runEnd) {
+            break;
+        }
+        p = runEnd;
+    }
+#endif
 
     eepromConfigSize = p - &__config_start;
 
-    // CRC has the property that if the CRC itself is included in the calculation the resulting CRC will have constant value
-    return crc == CRC_CHECK_VALUE;
+    return true;
 }
 
 uint16_t getEEPROMConfigSize(void)
@@ -158,37 +189,80 @@ uint16_t getEEPROMConfigSize(void)
     return eepromConfigSize;
 }
 
-// find config record for reg + classification (profile info) in EEPROM
+static bool isRecordFor(const configRecord_t *record, const pgRegistry_t *reg, configRecordFlags_e classification)
+{
+    return pgN(reg) == record->pgn && (record->flags & CR_CLASSIFICATION_MASK) == classification;
+}
+
+// find the most recently saved config record for reg + classification (profile info) between from and to in EEPROM
 // return NULL when record is not found
-// this function assumes that EEPROM content is valid
-static const configRecord_t *findEEPROM(const pgRegistry_t *reg, configRecordFlags_e classification)
+// this function assumes that EEPROM content is valid, as checked by isEEPROMStructureValid()
+static const configRecord_t *findEEPROMBetween(const pgRegistry_t *reg, configRecordFlags_e classification, const uint8_t *from, const uint8_t *to)
 {
-    const uint8_t *p = &__config_start;
-    p += sizeof(configHeader_t);             // skip header
-    while (true) {
+    const configRecord_t *found = NULL;
+    const uint8_t *p = from;
+    while (p < to) {
         const configRecord_t *record = (const configRecord_t *)p;
-        if (record->size == 0
-            || p + record->size >= &__config_end
+        if (record->size == 0) {
+            // end of a run, skip the footer and CRC to the next one
+            p = EEPROM_ALIGN(p + sizeof(configFooter_t) + sizeof(uint16_t));
+            continue;
+        }
+        if (p + record->size >= &__config_end
             || record->size < sizeof(*record))
             break;
-        if (pgN(reg) == record->pgn
-            && (record->flags & CR_CLASSIFICATION_MASK) == classification)
-            return record;
+        if (isRecordFor(record, reg, classification))
+            found = record; // later runs supersede earlier ones
+        p += record->size;
+    }
+    return found;
+}
+
+static const configRecord_t *findEEPROM(const pgRegistry_t *reg, configRecordFlags_e classification)
+{
+    return findEEPROMBetween(reg, classification, &__config_start + sizeof(configHeader_t), &__config_start + eepromConfigSize);
+}
+
+// Returns the end of the run of records at p, past its footer and CRC, or where the records stop making sense
+static const uint8_t *skipEEPROMRecords(const uint8_t *p)
+{
+    for (;;) {
+        const configRecord_t *record = (const configRecord_t *)p;
+        if (record->size == 0) {
+            return EEPROM_ALIGN(p + sizeof(configFooter_t) + sizeof(uint16_t));
+        }
+        if (p + record->size >= &__config_end
+            || record->size < sizeof(*record)) {
+            return p;
+        }
         p += record->size;
     }
-    // record not found
-    return NULL;
 }
 
 // Initialize all PG records from EEPROM.
-// This functions processes all PGs sequentially, scanning EEPROM for each one. This is suboptimal,
-//   but each PG is loaded/initialized exactly once and in defined order.
+// This functions processes all PGs sequentially, so each PG is loaded/initialized exactly once and in defined order.
+// A full write stores the PGs in registry order, so the records are followed along with the registry and only PGs
+// that were added or moved since need a search. Any records appended since the full write supersede its records.
 bool loadEEPROM(void)
 {
     bool success = true;
 
+    const uint8_t *p = &__config_start + sizeof(configHeader_t);
+    const uint8_t *appended = skipEEPROMRecords(p);
+    const uint8_t *end = &__config_start + eepromConfigSize;
+
     PG_FOREACH(reg) {
-        const configRecord_t *rec = findEEPROM(reg, CR_CLASSICATION_SYSTEM);
+        const configRecord_t *rec = (const configRecord_t *)p;
+        if (p < appended && rec->size != 0 && isRecordFor(rec, reg, CR_CLASSICATION_SYSTEM)) {
+            p += rec->size;
+        } else {
+            rec = findEEPROMBetween(reg, CR_CLASSICATION_SYSTEM, &__config_start + sizeof(configHeader_t), appended);
+        }
+        const configRecord_t *appendedRec = findEEPROMBetween(reg, CR_CLASSICATION_SYSTEM, appended, end);
+        if (appendedRec) {
+            rec = appendedRec;
+        }
+
         if (rec) {
             // config from EEPROM is available, use it to initialize PG. pgLoad will handle version mismatch
             if (!pgLoad(reg, rec->pg, rec->size - offsetof(configRecord_t, pg), rec->version)) {
@@ -204,22 +278,30 @@ bool loadEEPROM(void)
     return success;
 }
 
-static bool writeSettingsToEEPROM(void)
+// A PG needs saving when EEPROM has no copy of it at its current version, or the copy differs
+static bool isRecordChanged(const pgRegistry_t *reg)
 {
-    config_streamer_t streamer;
-    config_streamer_init(&streamer);
+    const configRecord_t *rec = findEEPROM(reg, CR_CLASSICATION_SYSTEM);
+    return !rec
+        || rec->version != pgVersion(reg)
+        || rec->size != sizeof(configRecord_t) + pgSize(reg)
+        || memcmp(rec->pg, reg->address, pgSize(reg)) != 0;
+}
 
-    config_streamer_start(&streamer, (uintptr_t)&__config_start, &__config_end - &__config_start);
+typedef void (*configWriteFnPtr)(void *context, const uint8_t *data, uint32_t size);
 
-    configHeader_t header = {
-        .eepromConfigVersion =  EEPROM_CONF_VERSION,
-        .magic_be =             0xBE,
-    };
+static void streamerWrite(void *context, const uint8_t *data, uint32_t size)
+{
+    config_streamer_write(context, data, size);
+}
 
-    config_streamer_write(&streamer, (uint8_t *)&header, sizeof(header));
-    uint16_t crc = CRC_START_VALUE;
-    crc = crc16_ccitt_update(crc, (uint8_t *)&header, sizeof(header));
+static void writeRecordsFooterAndCrc(configWriteFnPtr write, void *context, uint16_t crc, bool changedOnly)
+{
     PG_FOREACH(reg) {
+        if (changedOnly && !isRecordChanged(reg)) {
+            continue;
+        }
+
         const uint16_t regSize = pgSize(reg);
         configRecord_t record = {
             .size = sizeof(configRecord_t) + regSize,
@@ -229,9 +311,9 @@ static bool writeSettingsToEEPROM(void)
         };
 
         record.flags |= CR_CLASSICATION_SYSTEM;
-        config_streamer_write(&streamer, (uint8_t *)&record, sizeof(record));
+        write(context, (uint8_t *)&record, sizeof(record));
         crc = crc16_ccitt_update(crc, (uint8_t *)&record, sizeof(record));
-        config_streamer_write(&streamer, reg->address, regSize);
+        write(context, reg->address, regSize);
         crc = crc16_ccitt_update(crc, reg->address, regSize);
     }
 
@@ -239,13 +321,85 @@ static bool writeSettingsToEEPROM(void)
         .terminator = 0,
     };
 
-    config_streamer_write(&streamer, (uint8_t *)&footer, sizeof(footer));
+    write(context, (uint8_t *)&footer, sizeof(footer));
     crc = crc16_ccitt_update(crc, (uint8_t *)&footer, sizeof(footer));
 
     // include inverted CRC in big endian format in the CRC
     const uint16_t invertedBigEndianCrc = ~(((crc & 0xFF) << 8) | (crc >> 8));
-    config_streamer_write(&streamer, (uint8_t *)&invertedBigEndianCrc, sizeof(crc));
+    write(context, (uint8_t *)&invertedBigEndianCrc, sizeof(crc));
+}
 
+static uint16_t writeHeader(configWriteFnPtr write, void *context)
+{
+    configHeader_t header = {
+        .eepromConfigVersion =  EEPROM_CONF_VERSION,
+        .magic_be =             0xBE,
+    };
+
+    write(context, (uint8_t *)&header, sizeof(header));
+    return crc16_ccitt_update(CRC_START_VALUE, (uint8_t *)&header, sizeof(header));
+}
+
+#ifdef USE_EEPROM_APPEND
+// Append the PGs that differ from their stored copy after the records already in EEPROM, without erasing it.
+// Returns false when they don't fit or didn't make it, and the whole config has to be written instead.
+static bool appendChangedSettingsToEEPROM(void)
+{
+    if (!isEEPROMVersionValid() || !isEEPROMStructureValid()) {
+        return false;
+    }
+
+    int appendSize = sizeof(configFooter_t) + sizeof(uint16_t);
+    bool anyChanged = false;
+    PG_FOREACH(reg) {
+        if (isRecordChanged(reg)) {
+            appendSize += sizeof(configRecord_t) + pgSize(reg);
+            anyChanged = true;
+        }
+    }
+
+    if (!anyChanged) {
+        return true;
+    }
+
+    // Program only flash that is still erased
+    const uint8_t *start = &__config_start + eepromConfigSize;
+    const uint8_t *end = EEPROM_ALIGN(start + appendSize);
+    if (end >= &__config_end) {
+        return false;
+    }
+    for (const uint32_t *w = (const uint32_t *)start; w < (const uint32_t *)end; w++) {
+        if (*w != 0xFFFFFFFF) {
+            return false;
+        }
+    }
+
+    config_streamer_t streamer;
+    config_streamer_init(&streamer);
+
+    config_streamer_start(&streamer, (uintptr_t)start, end - start);
+    writeRecordsFooterAndCrc(streamerWrite, &streamer, CRC_START_VALUE, true);
+    config_streamer_flush(&streamer);
+
+    return config_streamer_finish(&streamer) == 0
+        && isEEPROMStructureValid()
+        && &__config_start + eepromConfigSize == end;
+}
+#endif
+
+#ifdef USE_CONFIG_SNAPSHOT
+static void abandonConfigSnapshotImport(void);
+#endif
+
+static bool writeSettingsToEEPROM(void)
+{
+    config_streamer_t streamer;
+    config_streamer_init(&streamer);
+
+    config_streamer_start(&streamer, (uintptr_t)&__config_start, &__config_end - &__config_start);
+
+    const uint16_t crc = writeHeader(streamerWrite, &streamer);
+    writeRecordsFooterAndCrc(streamerWrite, &streamer, crc, false);
     config_streamer_flush(&streamer);
 
     const bool success = config_streamer_finish(&streamer) == 0;
@@ -256,6 +410,16 @@ static bool writeSettingsToEEPROM(void)
 void writeConfigToEEPROM(void)
 {
     bool success = false;
+#ifdef USE_CONFIG_SNAPSHOT
+    abandonConfigSnapshotImport();
+#endif
+#ifdef USE_EEPROM_APPEND
+    // Erasing the sector stalls the MCU for hundreds of milliseconds, so only do it once the appended changes have
+    // filled it up
+    if (appendChangedSettingsToEEPROM()) {
+        return;
+    }
+#endif
     // write it
     for (int attempt = 0; attempt < 3 && !success; attempt++) {
         if (writeSettingsToEEPROM()) {
@@ -270,3 +434,194 @@ void writeConfigToEEPROM(void)
     // Flash write failed - just die now
     failureMode(FAILURE_FLASH_WRITE_FAILED);
 }
+
+#ifdef USE_CONFIG_SNAPSHOT
+typedef struct configSnapshotWindow_s {
+    uint8_t *dst;
+    int offset;
+    int length;
+    int at;
+} configSnapshotWindow_t;
+
+static void snapshotWrite(void *context, const uint8_t *data, uint32_t size)
+{
+    configSnapshotWindow_t *window = context;
+
+    // copy the part of data that falls into the window
+    const int start = MAX(window->at, window->offset);
+    const int end = MIN(window->at + (int)size, window->offset + window->length);
+    if (start < end) {
+        memcpy(window->dst + start - window->offset, data + start - window->at, end - start);
+    }
+    window->at += size;
+}
+
+// Serialize the current config in the layout written to EEPROM, and copy up to length bytes of it from offset to dst.
+// Returns the size of the whole snapshot.
+int getConfigSnapshot(uint8_t *dst, int offset, int length)
+{
+    configSnapshotWindow_t window = {
+        .dst = dst,
+        .offset = offset,
+        .length = length,
+        .at = 0,
+    };
+
+    const uint16_t crc = writeHeader(snapshotWrite, &window);
+    writeRecordsFooterAndCrc(snapshotWrite, &window, crc, false);
+
+    return window.at;
+}
+
+typedef enum {
+    SNAPSHOT_IMPORT_HEADER,
+    SNAPSHOT_IMPORT_RECORD,
+    SNAPSHOT_IMPORT_PG,
+    SNAPSHOT_IMPORT_CRC,
+    SNAPSHOT_IMPORT_FAILED,
+} snapshotImportState_e;
+
+// The snapshot has the layout of a full write, so it is streamed into the EEPROM as it arrives, each PG into its
+// own record. Only the framing and the CRC are checked on the way, the records are taken up by loadEEPROM().
+static struct {
+    snapshotImportState_e state;
+    uint16_t offset;        // of the next byte expected
+    uint16_t crc;
+    union {
+        configHeader_t header;
+        configRecord_t record;
+        uint8_t bytes[sizeof(configRecord_t)];
+    } buf;
+    uint8_t bufAt;
+    uint16_t pgAt;
+    bool streaming;         // the EEPROM has been written to since the import started
+    config_streamer_t streamer;
+} snapshotImport;
+
+static configSnapshotImport_e importSnapshotByte(uint8_t c)
+{
+    snapshotImport.crc = crc16_ccitt(snapshotImport.crc, c);
+
+    switch (snapshotImport.state) {
+    case SNAPSHOT_IMPORT_HEADER:
+        snapshotImport.buf.bytes[snapshotImport.bufAt++] = c;
+        if (snapshotImport.bufAt == sizeof(configHeader_t)) {
+            if (snapshotImport.buf.header.eepromConfigVersion != EEPROM_CONF_VERSION || snapshotImport.buf.header.magic_be != 0xBE) {
+                return CONFIG_SNAPSHOT_IMPORT_FAILED;
+            }
+            snapshotImport.state = SNAPSHOT_IMPORT_RECORD;
+            snapshotImport.bufAt = 0;
+        }
+        break;
+
+    case SNAPSHOT_IMPORT_RECORD:
+        snapshotImport.buf.bytes[snapshotImport.bufAt++] = c;
+        if (snapshotImport.bufAt == sizeof(configFooter_t) && snapshotImport.buf.record.size == 0) {
+            snapshotImport.state = SNAPSHOT_IMPORT_CRC;
+            snapshotImport.bufAt = 0;
+        } else if (snapshotImport.bufAt == sizeof(configRecord_t)) {
+            const configRecord_t *record = &snapshotImport.buf.record;
+            if (record->size < sizeof(*record)) {
+                return CONFIG_SNAPSHOT_IMPORT_FAILED;
+            }
+            snapshotImport.pgAt = 0;
+            snapshotImport.bufAt = 0;
+            snapshotImport.state = record->size > sizeof(*record) ? SNAPSHOT_IMPORT_PG : SNAPSHOT_IMPORT_RECORD;
+        }
+        break;
+
+    case SNAPSHOT_IMPORT_PG:
+        if (++snapshotImport.pgAt == snapshotImport.buf.record.size - sizeof(configRecord_t)) {
+            snapshotImport.state = SNAPSHOT_IMPORT_RECORD;
+        }
+        break;
+
+    case SNAPSHOT_IMPORT_CRC:
+        if (++snapshotImport.bufAt == sizeof(uint16_t)) {
+            snapshotImport.state = SNAPSHOT_IMPORT_FAILED;
+            return snapshotImport.crc == CRC_CHECK_VALUE ? CONFIG_SNAPSHOT_IMPORT_DONE : CONFIG_SNAPSHOT_IMPORT_FAILED;
+        }
+        break;
+
+    case SNAPSHOT_IMPORT_FAILED:
+        return CONFIG_SNAPSHOT_IMPORT_FAILED;
+    }
+
+    return CONFIG_SNAPSHOT_IMPORT_MORE;
+}
+
+// Ends the import. If the EEPROM was written to, the live config, which the import never touched, is saved over it.
+static configSnapshotImport_e failConfigSnapshotImport(void)
+{
+    snapshotImport.state = SNAPSHOT_IMPORT_FAILED;
+    if (snapshotImport.streaming) {
+        config_streamer_finish(&snapshotImport.streamer);
+        snapshotImport.streaming = false;
+        writeConfigToEEPROM();
+    }
+    return CONFIG_SNAPSHOT_IMPORT_FAILED;
+}
+
+// Import the next part of a snapshot from getConfigSnapshot(), parts must come in order starting from offset 0. Only
+// allowed while disarmed. The parts are written to the EEPROM as they arrive, the live config stays as it is. Once the
+// whole snapshot arrived with a valid CRC the caller loads it with readEEPROM(), which also activates it. A reset
+// before then leaves an unfinished EEPROM like a save cut short would, and the defaults are loaded.
+configSnapshotImport_e importConfigSnapshot(int offset, const uint8_t *data, int length)
+{
+    if (offset == 0) {
+        if (snapshotImport.streaming) {
+            // an import that was given up on, its part in the EEPROM is put right first
+            failConfigSnapshotImport();
+        }
+        memset(&snapshotImport, 0, sizeof(snapshotImport));
+        snapshotImport.state = SNAPSHOT_IMPORT_HEADER;
+        snapshotImport.crc = CRC_START_VALUE;
+    } else if (offset != snapshotImport.offset || snapshotImport.state == SNAPSHOT_IMPORT_FAILED) {
+        return failConfigSnapshotImport();
+    }
+
+    configSnapshotImport_e result = CONFIG_SNAPSHOT_IMPORT_MORE;
+    int i = 0;
+    while (i < length && result == CONFIG_SNAPSHOT_IMPORT_MORE) {
+        result = importSnapshotByte(data[i++]);
+    }
+    snapshotImport.offset = offset + length;
+
+    if (result == CONFIG_SNAPSHOT_IMPORT_FAILED) {
+        // a header that does not match fails before anything is written
+        return failConfigSnapshotImport();
+    }
+
+    if (!snapshotImport.streaming) {
+        config_streamer_init(&snapshotImport.streamer);
+        config_streamer_start(&snapshotImport.streamer, (uintptr_t)&__config_start, &__config_end - &__config_start);
+        snapshotImport.streaming = true;
+    }
+    config_streamer_write(&snapshotImport.streamer, data, i);
+    if (config_streamer_status(&snapshotImport.streamer) != 0) {
+        return failConfigSnapshotImport();
+    }
+
+    if (result == CONFIG_SNAPSHOT_IMPORT_DONE) {
+        config_streamer_flush(&snapshotImport.streamer);
+        const bool written = config_streamer_finish(&snapshotImport.streamer) == 0;
+        snapshotImport.streaming = false;
+        if (!written || !isEEPROMVersionValid() || !isEEPROMStructureValid()) {
+            snapshotImport.streaming = true;    // still has to be put right
+            return failConfigSnapshotImport();
+        }
+    }
+
+    return result;
+}
+
+// A save in the middle of an import replaces what the import had written so far
+static void abandonConfigSnapshotImport(void)
+{
+    if (snapshotImport.streaming) {
+        config_streamer_finish(&snapshotImport.streamer);
+        snapshotImport.streaming = false;
+    }
+    snapshotImport.state = SNAPSHOT_IMPORT_FAILED;
+}
+#endif
@@ -30,3 +30,12 @@ bool isEEPROMStructureValid(void);
 bool loadEEPROM(void);
 void writeConfigToEEPROM(void);
 uint16_t getEEPROMConfigSize(void);
+
+typedef enum {
+    CONFIG_SNAPSHOT_IMPORT_MORE,
+    CONFIG_SNAPSHOT_IMPORT_DONE,
+    CONFIG_SNAPSHOT_IMPORT_FAILED,
+} configSnapshotImport_e;
+
+int getConfigSnapshot(uint8_t *dst, int offset, int length);
+configSnapshotImport_e importConfigSnapshot(int offset, const uint8_t *data, int length);
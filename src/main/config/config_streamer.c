@@ -75,6 +75,7 @@ void config_streamer_start(config_streamer_t *c, uintptr_t base, int size)
 {
     // base must start at FLASH_PAGE_SIZE boundary
     c->address = base;
+    c->end = base + size;
     c->size = size;
     if (!c->unlocked) {
 #if defined(STM32F7)
@@ -225,13 +226,42 @@ static uint32_t getFLASHSectorForEEPROM(void)
 }
 #endif
 
+// Erased flash reads as all ones
+static bool isFlashErased(uintptr_t address, uintptr_t end)
+{
+    for (const uint32_t *w = (const uint32_t *)address; w < (const uint32_t *)end; w++) {
+        if (*w != 0xFFFFFFFF) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// A page only has to be erased if what the streamer can write of it isn't blank already
+static bool needsErase(const config_streamer_t *c)
+{
+    if (c->address % FLASH_PAGE_SIZE != 0) {
+        return false;
+    }
+
+    const uintptr_t pageEnd = c->address + FLASH_PAGE_SIZE;
+
+    return !isFlashErased(c->address, c->end < pageEnd ? c->end : pageEnd);
+}
+
+/*
+ * Programs one word. The STM32F4 and F7 can program 64 bits at once only with an external programming voltage,
+ * so 32 bits is the widest at the 3.3V of a flight controller. Words that are all ones are left alone, the flash
+ * already reads like that where the streamer writes, and skipping them saves their programming time.
+ */
 static int write_word(config_streamer_t *c, uint32_t value)
 {
     if (c->err != 0) {
         return c->err;
     }
 #if defined(STM32F7)
-    if (c->address % FLASH_PAGE_SIZE == 0) {
+    if (needsErase(c)) {
         FLASH_EraseInitTypeDef EraseInitStruct = {
             .TypeErase     = FLASH_TYPEERASE_SECTORS,
             .VoltageRange  = FLASH_VOLTAGE_RANGE_3, // 2.7-3.6V
@@ -244,12 +274,14 @@ static int write_word(config_streamer_t *c, uint32_t value)
             return -1;
         }
     }
-    const HAL_StatusTypeDef status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, c->address, value);
-    if (status != HAL_OK) {
-        return -2;
+    if (value != 0xFFFFFFFF) {
+        const HAL_StatusTypeDef status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, c->address, value);
+        if (status != HAL_OK) {
+            return -2;
+        }
     }
 #else
-    if (c->address % FLASH_PAGE_SIZE == 0) {
+    if (needsErase(c)) {
 #if defined(STM32F4)
         const FLASH_Status status = FLASH_EraseSector(getFLASHSectorForEEPROM(), VoltageRange_3); //0x08080000 to 0x080A0000
 #else
@@ -259,9 +291,11 @@ static int write_word(config_streamer_t *c, uint32_t value)
             return -1;
         }
     }
-    const FLASH_Status status = FLASH_ProgramWord(c->address, value);
-    if (status != FLASH_COMPLETE) {
-        return -2;
+    if (value != 0xFFFFFFFF) {
+        const FLASH_Status status = FLASH_ProgramWord(c->address, value);
+        if (status != FLASH_COMPLETE) {
+            return -2;
+        }
     }
 #endif
     c->address += sizeof(value);
@@ -28,6 +28,7 @@
 
 typedef struct config_streamer_s {
     uintptr_t address;
+    uintptr_t end;
     int size;
     union {
         uint8_t b[4];
@@ -46,6 +46,8 @@
 #define GYRO_32KHZ_HARDWARE_LPF_NORMAL       0
 #define GYRO_32KHZ_HARDWARE_LPF_EXPERIMENTAL 1
 
+#define GYRO_FIFO_MAX_SAMPLES 16   // most samples taken from the FIFO in one read
+
 typedef enum {
     GYRO_RATE_1_kHz,
     GYRO_RATE_1100_Hz,
@@ -71,6 +73,19 @@ typedef struct gyroDev_s {
     int32_t gyroADCRawPrevious[XYZ_AXIS_COUNT];
     int16_t gyroADCRaw[XYZ_AXIS_COUNT];
     int16_t temperature;
+    uint32_t sampleTimeUs;                                  // time of the last sample, drivers that know when it was taken overwrite the read time
+#ifdef USE_GYRO_FIFO
+    sensorGyroReadFuncPtr fifoReadFn;                         // burst read of the FIFO, NULL if unsupported or not enabled
+    int16_t gyroADCRawFifo[GYRO_FIFO_MAX_SAMPLES][XYZ_AXIS_COUNT];  // samples from the last FIFO read, oldest first
+    uint8_t fifoSampleCount;
+#endif
+#ifdef USE_ACC_BURST_READ
+    int32_t accADCRawSum[XYZ_AXIS_COUNT];                   // accel samples taken along with the gyro, summed until the accel is read
+    uint8_t accSampleCount;
+    bool accBurstRead;                                      // gyro reads include the accel registers
+    int16_t temperatureRaw;                                 // temperature register of the last burst read
+    bool temperatureRawValid;
+#endif
     mpuConfiguration_t mpuConfiguration;
     mpuDetectionResult_t mpuDetectionResult;
     sensor_align_e gyroAlign;
@@ -18,6 +18,7 @@
  * If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -35,10 +36,13 @@
 #include "drivers/bus.h"
 #include "drivers/bus_i2c.h"
 #include "drivers/bus_spi.h"
+#include "drivers/dma.h"
+#include "drivers/dma_reqmap.h"
 #include "drivers/exti.h"
 #include "drivers/io.h"
 #include "drivers/nvic.h"
 #include "drivers/sensor.h"
+#include "drivers/swi.h"
 #include "drivers/system.h"
 #include "drivers/time.h"
 
@@ -48,6 +52,7 @@
 #include "drivers/accgyro/accgyro_mpu6500.h"
 #include "drivers/accgyro/accgyro_spi_bmi160.h"
 #include "drivers/accgyro/accgyro_spi_icm20649.h"
+#include "drivers/accgyro/gyro_sync.h"
 #include "drivers/accgyro/accgyro_spi_icm20689.h"
 #include "drivers/accgyro/accgyro_spi_mpu6000.h"
 #include "drivers/accgyro/accgyro_spi_mpu6500.h"
@@ -102,6 +107,336 @@ static void mpu6050FindRevision(gyroDev_t *gyro)
 }
 #endif
 
+#ifdef USE_ACC_BURST_READ
+/*
+ * Accelerometer samples taken with the gyro
+ *
+ * Once the accelerometer is read from an SPI gyro using mpuGyroReadSPI() or the DMA reads,
+ * every gyro read also takes the accel registers in the same transfer and sums them in the
+ * gyroDev. mpuAccRead() then returns the average of the samples since its previous call
+ * instead of reading the bus itself.
+ */
+#define MPU_ACC_BURST_COUNT         2
+#define MPU_ACC_BURST_MAX_SAMPLES   64  // the sum restarts if the accelerometer isn't read for this long
+
+static gyroDev_t *mpuAccBurstGyro[MPU_ACC_BURST_COUNT];
+
+static bool mpuReadTemperatureBurst(gyroDev_t *gyro, int16_t *temperature);
+
+static void mpuAccBurstRegister(gyroDev_t *gyro)
+{
+    if (gyro->bus.bustype != BUSTYPE_SPI) {
+        return;
+    }
+    if (!gyro->temperatureFn) {
+        gyro->temperatureFn = mpuReadTemperatureBurst;
+    }
+    for (unsigned i = 0; i < MPU_ACC_BURST_COUNT; i++) {
+        if (!mpuAccBurstGyro[i] || mpuAccBurstGyro[i] == gyro) {
+            mpuAccBurstGyro[i] = gyro;
+            return;
+        }
+    }
+}
+
+static gyroDev_t *mpuAccBurstFindByBus(const busDevice_t *bus)
+{
+    if (bus->bustype != BUSTYPE_SPI) {
+        return NULL;
+    }
+    for (unsigned i = 0; i < MPU_ACC_BURST_COUNT; i++) {
+        if (mpuAccBurstGyro[i] && bus->busdev_u.spi.csnPin == mpuAccBurstGyro[i]->bus.busdev_u.spi.csnPin) {
+            return mpuAccBurstGyro[i];
+        }
+    }
+    return NULL;
+}
+
+static FAST_CODE void mpuAccBurstAccumulate(gyroDev_t *gyro, const uint8_t *data)
+{
+    if (gyro->accSampleCount >= MPU_ACC_BURST_MAX_SAMPLES) {
+        gyro->accADCRawSum[X] = gyro->accADCRawSum[Y] = gyro->accADCRawSum[Z] = 0;
+        gyro->accSampleCount = 0;
+    }
+    gyro->accADCRawSum[X] += (int16_t)((data[0] << 8) | data[1]);
+    gyro->accADCRawSum[Y] += (int16_t)((data[2] << 8) | data[3]);
+    gyro->accADCRawSum[Z] += (int16_t)((data[4] << 8) | data[5]);
+    gyro->accSampleCount++;
+    gyro->temperatureRaw = (int16_t)((data[6] << 8) | data[7]);
+    gyro->temperatureRawValid = true;
+}
+#endif // USE_ACC_BURST_READ
+
+#ifdef USE_GYRO_SPI_DMA
+/*
+ * DMA gyro reads
+ *
+ * The data ready interrupt starts a DMA transfer of the accel, temperature and gyro registers
+ * into one of two buffers. When the transfer completes the buffers are swapped and data ready
+ * is signalled, so the read functions just decode the latest complete sample without
+ * touching the bus. Transfers are started from interrupt context, so when another driver
+ * holds the bus claim the transfer is queued and starts on its release. Only the first gyro
+ * found uses DMA, a second gyro on the target reads the registers as before.
+ */
+#define MPU_SPI_DMA_TRANSFER_SIZE   15  // register address, 6 bytes accel, 2 bytes temperature, 6 bytes gyro
+#define MPU_SPI_DMA_ACCEL_OFFSET    1
+#define MPU_SPI_DMA_GYRO_OFFSET     9
+
+typedef struct mpuSpiDmaStreams_s {
+    DMA_Stream_TypeDef *rxStream;
+    uint32_t rxChannel;
+    DMA_Stream_TypeDef *txStream;
+    uint32_t txChannel;
+} mpuSpiDmaStreams_t;
+
+static const mpuSpiDmaStreams_t mpuSpiDmaStreams[] = {
+    { GYRO_SPI_DMA_RX_STREAM, GYRO_SPI_DMA_RX_CHANNEL, GYRO_SPI_DMA_TX_STREAM, GYRO_SPI_DMA_TX_CHANNEL },
+};
+
+#define MPU_SPI_DMA_COUNT ARRAYLEN(mpuSpiDmaStreams)
+
+typedef struct mpuSpiDma_s {
+    gyroDev_t *gyro;
+    mpuSpiDmaStreams_t streams;
+    dmaChannelDescriptor_t *rxDescriptor;
+    dmaChannelDescriptor_t *txDescriptor;
+    uint8_t rxBuffer[2][MPU_SPI_DMA_TRANSFER_SIZE];
+    uint32_t sampleTimeUs[2];       // data ready time of the sample in each buffer
+    volatile uint8_t readyIndex;    // buffer holding the latest complete sample
+    volatile uint8_t writeIndex;    // buffer being written by the transfer in progress
+    volatile bool transferInProgress;
+    volatile uint32_t completedCount;   // transfers completed, 0 until the first sample
+    uint32_t gyroReadCount;         // completedCount of the sample the gyro read function took last
+} mpuSpiDma_t;
+
+static mpuSpiDma_t mpuSpiDma[MPU_SPI_DMA_COUNT];
+// only ever read by the DMA, so all transfers share it
+static uint8_t mpuSpiDmaTxBuffer[MPU_SPI_DMA_TRANSFER_SIZE] = { MPU_RA_ACCEL_XOUT_H | 0x80 };
+
+#define MPU_SPI_DMA_FLAGS (DMA_IT_TCIF | DMA_IT_HTIF | DMA_IT_TEIF | DMA_IT_DMEIF | DMA_IT_FEIF)
+
+static FAST_CODE mpuSpiDma_t *mpuSpiDmaFind(const gyroDev_t *gyro)
+{
+    for (unsigned i = 0; i < MPU_SPI_DMA_COUNT; i++) {
+        if (mpuSpiDma[i].gyro == gyro) {
+            return &mpuSpiDma[i];
+        }
+    }
+    return NULL;
+}
+
+static FAST_CODE void mpuSpiDmaStartQueued(uint32_t index);
+
+static FAST_CODE void mpuSpiDmaStart(mpuSpiDma_t *dma)
+{
+    if (dma->transferInProgress) {
+        // previous sample is still being read, skip this one
+        return;
+    }
+
+    SPI_TypeDef *instance = dma->gyro->bus.busdev_u.spi.instance;
+    if (!spiBusClaimOrQueue(instance, mpuSpiDmaStartQueued, dma - mpuSpiDma)) {
+        // another transfer has the bus, this one goes first once it is released
+        return;
+    }
+    spiBusUseReadClock(&dma->gyro->bus);
+    const uint8_t writeIndex = dma->readyIndex ^ 1;
+
+    // both streams disable themselves when a transfer completes, so they can be reprogrammed directly
+    DMA_CLEAR_FLAG(dma->rxDescriptor, MPU_SPI_DMA_FLAGS);
+    DMA_CLEAR_FLAG(dma->txDescriptor, MPU_SPI_DMA_FLAGS);
+    DMA_MemoryTargetConfig(dma->streams.rxStream, (uint32_t)dma->rxBuffer[writeIndex], DMA_Memory_0);
+    DMA_SetCurrDataCounter(dma->streams.rxStream, MPU_SPI_DMA_TRANSFER_SIZE);
+    DMA_SetCurrDataCounter(dma->streams.txStream, MPU_SPI_DMA_TRANSFER_SIZE);
+
+    dma->sampleTimeUs[writeIndex] = micros();
+    dma->writeIndex = writeIndex;
+    dma->transferInProgress = true;
+
+    IOLo(dma->gyro->bus.busdev_u.spi.csnPin);
+    DMA_Cmd(dma->streams.rxStream, ENABLE);
+    DMA_Cmd(dma->streams.txStream, ENABLE);
+    SPI_I2S_DMACmd(instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+}
+
+static FAST_CODE void mpuSpiDmaStartQueued(uint32_t index)
+{
+    mpuSpiDmaStart(&mpuSpiDma[index]);
+}
+
+static FAST_CODE void mpuSpiDmaIrqHandler(dmaChannelDescriptor_t *descriptor)
+{
+    mpuSpiDma_t *dma = &mpuSpiDma[descriptor->userParam];
+    SPI_TypeDef *instance = dma->gyro->bus.busdev_u.spi.instance;
+
+    if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TCIF)) {
+        DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
+
+        // the last byte has been received, so the bus is idle
+        SPI_I2S_DMACmd(instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+        IOHi(dma->gyro->bus.busdev_u.spi.csnPin);
+
+        dma->readyIndex = dma->writeIndex;
+        dma->completedCount++;
+        dma->transferInProgress = false;
+        spiBusRelease(instance);
+
+        gyroSyncDataReady(dma->gyro);
+    }
+
+    if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TEIF)) {
+        DMA_CLEAR_FLAG(descriptor, DMA_IT_TEIF);
+
+        // drop the sample, the next data ready interrupt starts over
+        DMA_Cmd(dma->streams.txStream, DISABLE);
+        DMA_Cmd(dma->streams.rxStream, DISABLE);
+        SPI_I2S_DMACmd(instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+        IOHi(dma->gyro->bus.busdev_u.spi.csnPin);
+        dma->transferInProgress = false;
+        spiBusRelease(instance);
+    }
+}
+
+// Copies the latest complete sample. Once another transfer completes the one after it writes
+// into the buffer being copied, so the copy is retried until no transfer completed meanwhile.
+static FAST_CODE uint32_t mpuSpiDmaCopySample(const mpuSpiDma_t *dma, uint8_t *sample, uint32_t *sampleTimeUs)
+{
+    uint32_t completedCount;
+    do {
+        completedCount = dma->completedCount;
+        const uint8_t readyIndex = dma->readyIndex;
+        __atomic_signal_fence(__ATOMIC_ACQUIRE);
+        memcpy(sample, dma->rxBuffer[readyIndex], MPU_SPI_DMA_TRANSFER_SIZE);
+        *sampleTimeUs = dma->sampleTimeUs[readyIndex];
+        __atomic_signal_fence(__ATOMIC_ACQUIRE);
+    } while (completedCount != dma->completedCount);
+    return completedCount;
+}
+
+static FAST_CODE bool mpuGyroReadSPIDMA(gyroDev_t *gyro)
+{
+    mpuSpiDma_t *dma = mpuSpiDmaFind(gyro);
+    if (dma->completedCount == dma->gyroReadCount) {
+        // every sample is only taken once
+        return false;
+    }
+
+    uint8_t sample[MPU_SPI_DMA_TRANSFER_SIZE];
+    dma->gyroReadCount = mpuSpiDmaCopySample(dma, sample, &gyro->sampleTimeUs);
+    const uint8_t *data = &sample[MPU_SPI_DMA_GYRO_OFFSET];
+    gyro->gyroADCRaw[X] = (int16_t)((data[0] << 8) | data[1]);
+    gyro->gyroADCRaw[Y] = (int16_t)((data[2] << 8) | data[3]);
+    gyro->gyroADCRaw[Z] = (int16_t)((data[4] << 8) | data[5]);
+#ifdef USE_ACC_BURST_READ
+    if (gyro->accBurstRead) {
+        mpuAccBurstAccumulate(gyro, &sample[MPU_SPI_DMA_ACCEL_OFFSET]);
+    }
+#endif
+
+    return true;
+}
+
+static const mpuSpiDma_t *mpuSpiDmaFindByBus(const busDevice_t *bus)
+{
+    if (bus->bustype != BUSTYPE_SPI) {
+        return NULL;
+    }
+    for (unsigned i = 0; i < MPU_SPI_DMA_COUNT; i++) {
+        if (mpuSpiDma[i].gyro && bus->busdev_u.spi.csnPin == mpuSpiDma[i].gyro->bus.busdev_u.spi.csnPin) {
+            return &mpuSpiDma[i];
+        }
+    }
+    return NULL;
+}
+
+// Call at the end of the gyro init function, once the device registers are no longer written
+bool mpuGyroSpiDmaInit(gyroDev_t *gyro)
+{
+    if (gyro->bus.bustype != BUSTYPE_SPI || gyro->mpuIntExtiTag == IO_TAG_NONE) {
+        // transfers are started by the data ready interrupt
+        return false;
+    }
+#ifdef USE_GYRO_FIFO
+    if (gyro->fifoReadFn) {
+        // no data ready interrupt in FIFO mode
+        return false;
+    }
+#endif
+
+    mpuSpiDma_t *dma = mpuSpiDmaFind(NULL);
+    if (!dma) {
+        return false;
+    }
+
+    const int index = dma - mpuSpiDma;
+    mpuSpiDmaStreams_t streams = mpuSpiDmaStreams[index];
+#ifdef USE_DMA_SPEC
+    // the target's streams come first, else any pair of the bus that is still free
+    const SPIDevice spiDevice = spiDeviceByInstance(gyro->bus.busdev_u.spi.instance);
+    const dmaChannelSpec_t *rxSpec = dmaAllocate(DMA_PERIPH_SPI_RX, spiDevice, streams.rxStream, OWNER_MPU_DMA, RESOURCE_INDEX(index));
+    const dmaChannelSpec_t *txSpec = rxSpec ? dmaAllocate(DMA_PERIPH_SPI_TX, spiDevice, streams.txStream, OWNER_MPU_DMA, RESOURCE_INDEX(index)) : NULL;
+    if (!txSpec) {
+        if (rxSpec) {
+            dmaInit(dmaGetIdentifier(rxSpec->ref), OWNER_FREE, 0);
+        }
+        return false;
+    }
+    streams.rxStream = rxSpec->ref;
+    streams.rxChannel = rxSpec->channel;
+    streams.txStream = txSpec->ref;
+    streams.txChannel = txSpec->channel;
+    const dmaIdentifier_e rxIdentifier = dmaGetIdentifier(streams.rxStream);
+    const dmaIdentifier_e txIdentifier = dmaGetIdentifier(streams.txStream);
+#else
+    const dmaIdentifier_e rxIdentifier = dmaGetIdentifier(streams.rxStream);
+    const dmaIdentifier_e txIdentifier = dmaGetIdentifier(streams.txStream);
+    if (dmaGetOwner(rxIdentifier) != OWNER_FREE || dmaGetOwner(txIdentifier) != OWNER_FREE) {
+        return false;
+    }
+
+    dmaInit(rxIdentifier, OWNER_MPU_DMA, RESOURCE_INDEX(index));
+    dmaInit(txIdentifier, OWNER_MPU_DMA, RESOURCE_INDEX(index));
+#endif
+
+    memset(&mpuSpiDmaTxBuffer[1], 0xFF, MPU_SPI_DMA_TRANSFER_SIZE - 1);
+
+    DMA_InitTypeDef DMA_InitStructure;
+    DMA_StructInit(&DMA_InitStructure);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)(&(gyro->bus.busdev_u.spi.instance->DR));
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_BufferSize = MPU_SPI_DMA_TRANSFER_SIZE;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+
+    DMA_DeInit(streams.rxStream);
+    DMA_InitStructure.DMA_Channel = streams.rxChannel;
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)dma->rxBuffer[0];
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+    DMA_Init(streams.rxStream, &DMA_InitStructure);
+    DMA_ITConfig(streams.rxStream, DMA_IT_TC | DMA_IT_TE, ENABLE);
+
+    DMA_DeInit(streams.txStream);
+    DMA_InitStructure.DMA_Channel = streams.txChannel;
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)mpuSpiDmaTxBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+    DMA_Init(streams.txStream, &DMA_InitStructure);
+
+    dma->streams = streams;
+    dma->rxDescriptor = dmaGetDescriptorByIdentifier(rxIdentifier);
+    dma->txDescriptor = dmaGetDescriptorByIdentifier(txIdentifier);
+    dmaSetHandler(rxIdentifier, mpuSpiDmaIrqHandler, NVIC_PRIO_MPU_DMA, index);
+
+    // the data ready interrupt starts using DMA as soon as the gyro is set
+    gyro->readFn = mpuGyroReadSPIDMA;
+    dma->gyro = gyro;
+
+    return true;
+}
+#endif // USE_GYRO_SPI_DMA
+
 /*
  * Gyro interrupt service routine
  */
@@ -115,7 +450,16 @@ static void mpuIntExtiHandler(extiCallbackRec_t *cb)
     lastCalledAtUs = nowUs;
 #endif
     gyroDev_t *gyro = container_of(cb, gyroDev_t, exti);
-    gyro->dataReady = true;
+#ifdef USE_GYRO_SPI_DMA
+    mpuSpiDma_t *dma = mpuSpiDmaFind(gyro);
+    if (dma) {
+        // data ready is signalled from the DMA interrupt once the sample is in memory
+        mpuSpiDmaStart(dma);
+    } else
+#endif
+    {
+        gyroSyncDataReady(gyro);
+    }
 #ifdef DEBUG_MPU_DATA_READY_INTERRUPT
     const uint32_t now2Us = micros();
     debug[1] = (uint16_t)(now2Us - nowUs);
@@ -154,6 +498,57 @@ static void mpuIntExtiInit(gyroDev_t *gyro)
 
 bool mpuAccRead(accDev_t *acc)
 {
+#ifdef USE_ACC_BURST_READ
+    gyroDev_t *gyro = mpuAccBurstFindByBus(&acc->bus);
+#ifdef USE_GYRO_SPI_DMA
+    const bool burstSupported = gyro && (gyro->readFn == mpuGyroReadSPI || gyro->readFn == mpuGyroReadSPIDMA);
+#else
+    const bool burstSupported = gyro && gyro->readFn == mpuGyroReadSPI;
+#endif
+    if (burstSupported) {
+        if (gyro->accBurstRead) {
+            // the gyro reads accumulate from the PID loop, which can preempt this task
+            int32_t sum[XYZ_AXIS_COUNT];
+            int sampleCount;
+            SWI_ATOMIC_BLOCK {
+                sampleCount = gyro->accSampleCount;
+                for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                    sum[axis] = gyro->accADCRawSum[axis];
+                    gyro->accADCRawSum[axis] = 0;
+                }
+                gyro->accSampleCount = 0;
+            }
+            if (sampleCount == 0) {
+                return false;
+            }
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                acc->ADCRaw[axis] = sum[axis] / sampleCount;
+            }
+            return true;
+        }
+        // from now on the gyro reads take the accelerometer samples as well
+        gyro->accBurstRead = true;
+    }
+#endif
+
+#ifdef USE_GYRO_SPI_DMA
+    const mpuSpiDma_t *dma = mpuSpiDmaFindByBus(&acc->bus);
+    if (dma) {
+        // the accelerometer registers come with every gyro sample
+        if (dma->completedCount == 0) {
+            return false;
+        }
+        uint8_t sample[MPU_SPI_DMA_TRANSFER_SIZE];
+        uint32_t sampleTimeUs;
+        mpuSpiDmaCopySample(dma, sample, &sampleTimeUs);
+        const uint8_t *data = &sample[MPU_SPI_DMA_ACCEL_OFFSET];
+        acc->ADCRaw[X] = (int16_t)((data[0] << 8) | data[1]);
+        acc->ADCRaw[Y] = (int16_t)((data[2] << 8) | data[3]);
+        acc->ADCRaw[Z] = (int16_t)((data[4] << 8) | data[5]);
+        return true;
+    }
+#endif
+
     uint8_t data[6];
 
     const bool ack = busReadRegisterBuffer(&acc->bus, MPU_RA_ACCEL_XOUT_H, data, 6);
@@ -168,6 +563,57 @@ bool mpuAccRead(accDev_t *acc)
     return true;
 }
 
+#ifdef USE_ACC_BURST_READ
+// the temperature scale and offset differ between the sensor families
+static bool mpuTemperatureFromRaw(const gyroDev_t *gyro, int16_t raw, int16_t *temperature)
+{
+    switch (gyro->mpuDetectionResult.sensor) {
+    case MPU_60x0:
+    case MPU_60x0_SPI:
+        *temperature = lrintf(raw / 340.0f + 36.53f);
+        return true;
+    case MPU_65xx_I2C:
+    case MPU_65xx_SPI:
+    case MPU_9250_SPI:
+    case ICM_20649_SPI:
+        *temperature = lrintf(raw / 333.87f + 21.0f);
+        return true;
+    case ICM_20601_SPI:
+    case ICM_20602_SPI:
+    case ICM_20608_SPI:
+    case ICM_20689_SPI:
+        *temperature = lrintf(raw / 326.8f + 25.0f);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The temperature registers come with the burst and DMA reads. They are taken from the last sample
+// rather than read from the bus, so this is safe to call from a task that the gyro loop can preempt.
+static bool mpuReadTemperatureBurst(gyroDev_t *gyro, int16_t *temperature)
+{
+#ifdef USE_GYRO_SPI_DMA
+    const mpuSpiDma_t *dma = mpuSpiDmaFind(gyro);
+    if (dma) {
+        if (dma->completedCount == 0) {
+            return false;
+        }
+        uint8_t sample[MPU_SPI_DMA_TRANSFER_SIZE];
+        uint32_t sampleTimeUs;
+        mpuSpiDmaCopySample(dma, sample, &sampleTimeUs);
+        const uint8_t *data = &sample[MPU_SPI_DMA_ACCEL_OFFSET + 6];
+        return mpuTemperatureFromRaw(gyro, (int16_t)((data[0] << 8) | data[1]), temperature);
+    }
+#endif
+    if (!gyro->temperatureRawValid) {
+        // the burst reads only start with the first accelerometer read
+        return false;
+    }
+    return mpuTemperatureFromRaw(gyro, gyro->temperatureRaw, temperature);
+}
+#endif
+
 bool mpuGyroRead(gyroDev_t *gyro)
 {
     uint8_t data[6];
@@ -186,6 +632,25 @@ bool mpuGyroRead(gyroDev_t *gyro)
 
 bool mpuGyroReadSPI(gyroDev_t *gyro)
 {
+#ifdef USE_ACC_BURST_READ
+    if (gyro->accBurstRead) {
+        // accel, temperature and gyro registers in one transfer
+        static const uint8_t burstToSend[15] = {MPU_RA_ACCEL_XOUT_H | 0x80, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+        uint8_t burst[15];
+
+        if (!spiBusTransfer(&gyro->bus, burstToSend, burst, 15)) {
+            return false;
+        }
+
+        mpuAccBurstAccumulate(gyro, &burst[1]);
+        gyro->gyroADCRaw[X] = (int16_t)((burst[9] << 8) | burst[10]);
+        gyro->gyroADCRaw[Y] = (int16_t)((burst[11] << 8) | burst[12]);
+        gyro->gyroADCRaw[Z] = (int16_t)((burst[13] << 8) | burst[14]);
+
+        return true;
+    }
+#endif
+
     static const uint8_t dataToSend[7] = {MPU_RA_GYRO_XOUT_H | 0x80, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
     uint8_t data[7];
 
@@ -201,10 +666,87 @@ bool mpuGyroReadSPI(gyroDev_t *gyro)
     return true;
 }
 
+#ifdef USE_GYRO_FIFO
+#define MPU_FIFO_EN_GYRO_XYZ        0x70    // XG_FIFO_EN | YG_FIFO_EN | ZG_FIFO_EN
+#define MPU_USER_CTRL_FIFO_EN       0x40
+#define MPU_USER_CTRL_I2C_IF_DIS    0x10
+#define MPU_USER_CTRL_FIFO_RESET    0x04
+#define MPU_FIFO_SAMPLE_SIZE        6
+// FIFO contents are stale if this many samples have queued up, they are discarded
+#define MPU_FIFO_RESET_SAMPLES      (GYRO_FIFO_MAX_SAMPLES * 4)
+
+static void mpuGyroFifoReset(gyroDev_t *gyro)
+{
+    spiBusWriteRegister(&gyro->bus, MPU_RA_USER_CTRL, MPU_USER_CTRL_I2C_IF_DIS | MPU_USER_CTRL_FIFO_RESET);
+    spiBusWriteRegister(&gyro->bus, MPU_RA_USER_CTRL, MPU_USER_CTRL_I2C_IF_DIS | MPU_USER_CTRL_FIFO_EN);
+}
+
+// Queues every gyro sample in the FIFO. Call with the SPI clock set for register writes.
+void mpuGyroFifoInit(gyroDev_t *gyro)
+{
+    if (!gyro->fifoReadFn) {
+        return;
+    }
+
+    // the gyro task runs on its own timing and reads everything queued since the last read,
+    // so there is no data ready interrupt for every sample
+    spiBusWriteRegister(&gyro->bus, MPU_RA_INT_ENABLE, 0x00);
+    delayMicroseconds(15);
+    spiBusWriteRegister(&gyro->bus, MPU_RA_FIFO_EN, MPU_FIFO_EN_GYRO_XYZ);
+    delayMicroseconds(15);
+    mpuGyroFifoReset(gyro);
+    delayMicroseconds(15);
+
+    gyro->fifoSampleCount = 0;
+    gyro->readFn = gyro->fifoReadFn;
+}
+
+FAST_CODE bool mpuGyroReadFifoSPI(gyroDev_t *gyro)
+{
+    uint8_t data[GYRO_FIFO_MAX_SAMPLES * MPU_FIFO_SAMPLE_SIZE];
+
+    if (!spiBusReadRegisterBuffer(&gyro->bus, MPU_RA_FIFO_COUNTH, data, 2)) {
+        return false;
+    }
+    int sampleCount = ((data[0] << 8) | data[1]) / MPU_FIFO_SAMPLE_SIZE;
+    if (sampleCount == 0) {
+        return false;
+    }
+    if (sampleCount >= MPU_FIFO_RESET_SAMPLES) {
+        mpuGyroFifoReset(gyro);
+        return false;
+    }
+    // anything left over is read next time
+    sampleCount = MIN(sampleCount, GYRO_FIFO_MAX_SAMPLES);
+
+    if (!spiBusReadRegisterBuffer(&gyro->bus, MPU_RA_FIFO_R_W, data, sampleCount * MPU_FIFO_SAMPLE_SIZE)) {
+        return false;
+    }
+
+    const uint8_t *sample = data;
+    for (int i = 0; i < sampleCount; i++) {
+        gyro->gyroADCRawFifo[i][X] = (int16_t)((sample[0] << 8) | sample[1]);
+        gyro->gyroADCRawFifo[i][Y] = (int16_t)((sample[2] << 8) | sample[3]);
+        gyro->gyroADCRawFifo[i][Z] = (int16_t)((sample[4] << 8) | sample[5]);
+        sample += MPU_FIFO_SAMPLE_SIZE;
+    }
+    gyro->fifoSampleCount = sampleCount;
+
+    return true;
+}
+#endif // USE_GYRO_FIFO
+
 #ifdef USE_SPI
-static bool detectSPISensorsAndUpdateDetectionResult(gyroDev_t *gyro)
+// with a cached sensor only the detectors that can report it are run, the bus setup is kept as is
+static inline bool mpuSpiDetectorWanted(mpuSensor_e cachedSensor, uint32_t detectableSensors)
+{
+    return cachedSensor == MPU_NONE || (detectableSensors & BIT(cachedSensor));
+}
+
+static bool detectSPISensorsAndUpdateDetectionResult(gyroDev_t *gyro, mpuSensor_e cachedSensor)
 {
     UNUSED(gyro); // since there are FCs which have gyro on I2C but other devices on SPI
+    UNUSED(cachedSensor);
 
     uint8_t sensor = MPU_NONE;
     UNUSED(sensor);
@@ -218,7 +760,7 @@ static bool detectSPISensorsAndUpdateDetectionResult(gyroDev_t *gyro)
 #ifdef MPU6000_CS_PIN
     gyro->bus.busdev_u.spi.csnPin = gyro->bus.busdev_u.spi.csnPin == IO_NONE ? IOGetByTag(IO_TAG(MPU6000_CS_PIN)) : gyro->bus.busdev_u.spi.csnPin;
 #endif
-    sensor = mpu6000SpiDetect(&gyro->bus);
+    sensor = mpuSpiDetectorWanted(cachedSensor, BIT(MPU_60x0_SPI)) ? mpu6000SpiDetect(&gyro->bus) : MPU_NONE;
     if (sensor != MPU_NONE) {
         gyro->mpuDetectionResult.sensor = sensor;
         return true;
@@ -232,7 +774,7 @@ static bool detectSPISensorsAndUpdateDetectionResult(gyroDev_t *gyro)
 #ifdef MPU6500_CS_PIN
     gyro->bus.busdev_u.spi.csnPin = gyro->bus.busdev_u.spi.csnPin == IO_NONE ? IOGetByTag(IO_TAG(MPU6500_CS_PIN)) : gyro->bus.busdev_u.spi.csnPin;
 #endif
-    sensor = mpu6500SpiDetect(&gyro->bus);
+    sensor = mpuSpiDetectorWanted(cachedSensor, BIT(MPU_65xx_SPI) | BIT(MPU_9250_SPI) | BIT(ICM_20601_SPI) | BIT(ICM_20602_SPI) | BIT(ICM_20608_SPI)) ? mpu6500SpiDetect(&gyro->bus) : MPU_NONE;
     // some targets using MPU_9250_SPI, ICM_20608_SPI or ICM_20602_SPI state sensor is MPU_65xx_SPI
     if (sensor != MPU_NONE) {
         gyro->mpuDetectionResult.sensor = sensor;
@@ -247,7 +789,7 @@ static bool detectSPISensorsAndUpdateDetectionResult(gyroDev_t *gyro)
 #ifdef MPU9250_CS_PIN
     gyro->bus.busdev_u.spi.csnPin = gyro->bus.busdev_u.spi.csnPin == IO_NONE ? IOGetByTag(IO_TAG(MPU9250_CS_PIN)) : gyro->bus.busdev_u.spi.csnPin;
 #endif
-    sensor = mpu9250SpiDetect(&gyro->bus);
+    sensor = mpuSpiDetectorWanted(cachedSensor, BIT(MPU_9250_SPI)) ? mpu9250SpiDetect(&gyro->bus) : MPU_NONE;
     if (sensor != MPU_NONE) {
         gyro->mpuDetectionResult.sensor = sensor;
         gyro->mpuConfiguration.resetFn = mpu9250SpiResetGyro;
@@ -262,7 +804,7 @@ static bool detectSPISensorsAndUpdateDetectionResult(gyroDev_t *gyro)
 #ifdef ICM20649_CS_PIN
     gyro->bus.busdev_u.spi.csnPin = gyro->bus.busdev_u.spi.csnPin == IO_NONE ? IOGetByTag(IO_TAG(ICM20649_CS_PIN)) : gyro->bus.busdev_u.spi.csnPin;
 #endif
-    sensor = icm20649SpiDetect(&gyro->bus);
+    sensor = mpuSpiDetectorWanted(cachedSensor, BIT(ICM_20649_SPI)) ? icm20649SpiDetect(&gyro->bus) : MPU_NONE;
     if (sensor != MPU_NONE) {
         gyro->mpuDetectionResult.sensor = sensor;
         return true;
@@ -276,7 +818,7 @@ static bool detectSPISensorsAndUpdateDetectionResult(gyroDev_t *gyro)
 #ifdef ICM20689_CS_PIN
     gyro->bus.busdev_u.spi.csnPin = gyro->bus.busdev_u.spi.csnPin == IO_NONE ? IOGetByTag(IO_TAG(ICM20689_CS_PIN)) : gyro->bus.busdev_u.spi.csnPin;
 #endif
-    sensor = icm20689SpiDetect(&gyro->bus);
+    sensor = mpuSpiDetectorWanted(cachedSensor, BIT(ICM_20601_SPI) | BIT(ICM_20602_SPI) | BIT(ICM_20608_SPI) | BIT(ICM_20689_SPI)) ? icm20689SpiDetect(&gyro->bus) : MPU_NONE;
     // icm20689SpiDetect detects ICM20602 and ICM20689
     if (sensor != MPU_NONE) {
         gyro->mpuDetectionResult.sensor = sensor;
@@ -291,7 +833,7 @@ static bool detectSPISensorsAndUpdateDetectionResult(gyroDev_t *gyro)
 #ifdef BMI160_CS_PIN
     gyro->bus.busdev_u.spi.csnPin = gyro->bus.busdev_u.spi.csnPin == IO_NONE ? IOGetByTag(IO_TAG(BMI160_CS_PIN)) : gyro->bus.busdev_u.spi.csnPin;
 #endif
-    sensor = bmi160Detect(&gyro->bus);
+    sensor = mpuSpiDetectorWanted(cachedSensor, BIT(BMI_160_SPI)) ? bmi160Detect(&gyro->bus) : MPU_NONE;
     if (sensor != MPU_NONE) {
         gyro->mpuDetectionResult.sensor = sensor;
         return true;
@@ -302,8 +844,10 @@ static bool detectSPISensorsAndUpdateDetectionResult(gyroDev_t *gyro)
 }
 #endif
 
-void mpuDetect(gyroDev_t *gyro)
+void mpuDetect(gyroDev_t *gyro, mpuSensor_e cachedSensor)
 {
+    UNUSED(cachedSensor);
+
     // MPU datasheet specifies 30ms.
     delay(35);
 
@@ -344,7 +888,11 @@ void mpuDetect(gyroDev_t *gyro)
 
 #ifdef USE_SPI
     gyro->bus.bustype = BUSTYPE_SPI;
-    detectSPISensorsAndUpdateDetectionResult(gyro);
+    // a failed probe is slow, so try the sensor found last time before probing for all of them
+    if (cachedSensor != MPU_NONE && detectSPISensorsAndUpdateDetectionResult(gyro, cachedSensor)) {
+        return;
+    }
+    detectSPISensorsAndUpdateDetectionResult(gyro, MPU_NONE);
 #endif
 }
 
@@ -355,6 +903,9 @@ void mpuGyroInit(gyroDev_t *gyro)
 #else
     UNUSED(gyro);
 #endif
+#ifdef USE_ACC_BURST_READ
+    mpuAccBurstRegister(gyro);
+#endif
 }
 
 uint8_t mpuGyroDLPF(gyroDev_t *gyro)
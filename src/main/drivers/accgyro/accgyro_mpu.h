@@ -213,7 +213,14 @@ struct gyroDev_s;
 void mpuGyroInit(struct gyroDev_s *gyro);
 bool mpuGyroRead(struct gyroDev_s *gyro);
 bool mpuGyroReadSPI(struct gyroDev_s *gyro);
-void mpuDetect(struct gyroDev_s *gyro);
+#ifdef USE_GYRO_SPI_DMA
+bool mpuGyroSpiDmaInit(struct gyroDev_s *gyro);
+#endif
+#ifdef USE_GYRO_FIFO
+bool mpuGyroReadFifoSPI(struct gyroDev_s *gyro);
+void mpuGyroFifoInit(struct gyroDev_s *gyro);
+#endif
+void mpuDetect(struct gyroDev_s *gyro, mpuSensor_e cachedSensor);
 uint8_t mpuGyroDLPF(struct gyroDev_s *gyro);
 uint8_t mpuGyroFCHOICE(struct gyroDev_s *gyro);
 uint8_t mpuGyroReadRegister(const busDevice_t *bus, uint8_t reg);
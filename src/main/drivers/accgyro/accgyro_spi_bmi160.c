@@ -48,6 +48,7 @@
 
 #include "accgyro.h"
 #include "accgyro_spi_bmi160.h"
+#include "gyro_sync.h"
 
 
 /* BMI160 Registers */
@@ -245,7 +246,7 @@ extiCallbackRec_t bmi160IntCallbackRec;
 void bmi160ExtiHandler(extiCallbackRec_t *cb)
 {
     gyroDev_t *gyro = container_of(cb, gyroDev_t, exti);
-    gyro->dataReady = true;
+    gyroSyncDataReady(gyro);
 }
 
 static void bmi160IntExtiInit(gyroDev_t *gyro)
@@ -153,7 +153,16 @@ void icm20689GyroInit(gyroDev_t *gyro)
     spiBusWriteRegister(&gyro->bus, MPU_RA_INT_ENABLE, 0x01); // RAW_RDY_EN interrupt enable
 #endif
 
+#ifdef USE_GYRO_FIFO
+    mpuGyroFifoInit(gyro);
+#endif
+
+    spiBusSetDivisors(&gyro->bus, SPI_CLOCK_STANDARD, SPI_CLOCK_INITIALIZATON);
     spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_STANDARD);
+
+#ifdef USE_GYRO_SPI_DMA
+    mpuGyroSpiDmaInit(gyro);
+#endif
 }
 
 bool icm20689SpiGyroDetect(gyroDev_t *gyro)
@@ -170,6 +179,9 @@ bool icm20689SpiGyroDetect(gyroDev_t *gyro)
 
     gyro->initFn = icm20689GyroInit;
     gyro->readFn = mpuGyroReadSPI;
+#ifdef USE_GYRO_FIFO
+    gyro->fifoReadFn = mpuGyroReadFifoSPI;
+#endif
 
     // 16.4 dps/lsb scalefactor
     gyro->scale = 1.0f / 16.4f;
@@ -111,6 +111,10 @@ void mpu6000SpiGyroInit(gyroDev_t *gyro)
     spiBusWriteRegister(&gyro->bus, MPU6000_CONFIG, mpuGyroDLPF(gyro));
     delayMicroseconds(1);
 
+#ifdef USE_GYRO_FIFO
+    mpuGyroFifoInit(gyro);
+#endif
+
     spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_FAST);  // 18 MHz SPI clock
 
     mpuGyroRead(gyro);
@@ -118,6 +122,10 @@ void mpu6000SpiGyroInit(gyroDev_t *gyro)
     if (((int8_t)gyro->gyroADCRaw[1]) == -1 && ((int8_t)gyro->gyroADCRaw[0]) == -1) {
         failureMode(FAILURE_GYRO_INIT_FAILED);
     }
+
+#ifdef USE_GYRO_SPI_DMA
+    mpuGyroSpiDmaInit(gyro);
+#endif
 }
 
 void mpu6000SpiAccInit(accDev_t *acc)
@@ -221,6 +229,8 @@ static void mpu6000AccAndGyroInit(gyroDev_t *gyro)
     delayMicroseconds(15);
 #endif
 
+    // registers are specified up to 1MHz, sensor and interrupt registers are read at up to 20MHz
+    spiBusSetDivisors(&gyro->bus, SPI_CLOCK_FAST, SPI_CLOCK_INITIALIZATON);
     spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_FAST);
     delayMicroseconds(1);
 
@@ -247,6 +257,9 @@ bool mpu6000SpiGyroDetect(gyroDev_t *gyro)
 
     gyro->initFn = mpu6000SpiGyroInit;
     gyro->readFn = mpuGyroReadSPI;
+#ifdef USE_GYRO_FIFO
+    gyro->fifoReadFn = mpuGyroReadFifoSPI;
+#endif
     // 16.4 dps/lsb scalefactor
     gyro->scale = 1.0f / 16.4f;
 
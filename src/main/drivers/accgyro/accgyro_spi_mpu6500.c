@@ -96,8 +96,18 @@ void mpu6500SpiGyroInit(gyroDev_t *gyro)
     spiBusWriteRegister(&gyro->bus, MPU_RA_USER_CTRL, MPU6500_BIT_I2C_IF_DIS);
     delay(100);
 
+#ifdef USE_GYRO_FIFO
+    mpuGyroFifoInit(gyro);
+#endif
+
+    // registers are specified up to 1MHz, sensor and interrupt registers are read at up to 20MHz
+    spiBusSetDivisors(&gyro->bus, SPI_CLOCK_FAST, SPI_CLOCK_SLOW);
     spiSetDivisor(gyro->bus.busdev_u.spi.instance, SPI_CLOCK_FAST);
     delayMicroseconds(1);
+
+#ifdef USE_GYRO_SPI_DMA
+    mpuGyroSpiDmaInit(gyro);
+#endif
 }
 
 bool mpu6500SpiAccDetect(accDev_t *acc)
@@ -134,6 +144,9 @@ bool mpu6500SpiGyroDetect(gyroDev_t *gyro)
 
     gyro->initFn = mpu6500SpiGyroInit;
     gyro->readFn = mpuGyroReadSPI;
+#ifdef USE_GYRO_FIFO
+    gyro->fifoReadFn = mpuGyroReadFifoSPI;
+#endif
 
     // 16.4 dps/lsb scalefactor
     gyro->scale = 1.0f / 16.4f;
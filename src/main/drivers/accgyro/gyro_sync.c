@@ -34,6 +34,28 @@
 #include "drivers/accgyro/accgyro.h"
 #include "drivers/accgyro/gyro_sync.h"
 
+#ifdef USE_PREEMPTIVE_PID_LOOP
+static gyroDataReadyCallbackFnPtr dataReadyCallback;
+static const gyroDev_t *dataReadyCallbackGyro;
+
+void gyroSyncSetDataReadyCallback(const gyroDev_t *gyro, gyroDataReadyCallbackFnPtr callback)
+{
+    dataReadyCallback = NULL;
+    dataReadyCallbackGyro = gyro;
+    dataReadyCallback = callback;
+}
+#endif
+
+// Called from the data ready interrupt handler of the gyro driver
+FAST_CODE void gyroSyncDataReady(gyroDev_t *gyro)
+{
+    gyro->dataReady = true;
+#ifdef USE_PREEMPTIVE_PID_LOOP
+    if (dataReadyCallback && gyro == dataReadyCallbackGyro) {
+        dataReadyCallback();
+    }
+#endif
+}
 
 bool gyroSyncCheckUpdate(gyroDev_t *gyro)
 {
@@ -86,7 +108,12 @@ uint32_t gyroSetSampleRate(gyroDev_t *gyro, uint8_t lpf, uint8_t gyroSyncDenomin
     }
 
     // calculate gyro divider and targetLooptime (expected cycleTime)
+#ifdef USE_GYRO_FIFO
+    // in FIFO mode the sensor keeps every sample, the decimation happens when the FIFO is read
+    gyro->mpuDividerDrops  = gyro->fifoReadFn ? 0 : gyroSyncDenominator - 1;
+#else
     gyro->mpuDividerDrops  = gyroSyncDenominator - 1;
+#endif
     const uint32_t targetLooptime = (uint32_t)(gyroSyncDenominator * gyroSamplePeriod);
     return targetLooptime;
 }
@@ -29,5 +29,9 @@
 
 #include "drivers/accgyro/accgyro.h"
 
+typedef void (*gyroDataReadyCallbackFnPtr)(void);
+
 bool gyroSyncCheckUpdate(gyroDev_t *gyro);
+void gyroSyncDataReady(gyroDev_t *gyro);
+void gyroSyncSetDataReadyCallback(const gyroDev_t *gyro, gyroDataReadyCallbackFnPtr callback);
 uint32_t gyroSetSampleRate(gyroDev_t *gyro, uint8_t lpf, uint8_t gyroSyncDenominator, bool gyro_use_32khz);
@@ -39,7 +39,8 @@
 //#define DEBUG_ADC_CHANNELS
 
 adcOperatingConfig_t adcOperatingConfig[ADC_CHANNEL_COUNT];
-volatile uint16_t adcValues[ADC_CHANNEL_COUNT];
+DMA_RAM volatile uint16_t adcValues[ADC_CHANNEL_COUNT * ADC_OVERSAMPLE_COUNT];
+uint8_t adcScanChannelCount = 0;
 
 #ifdef USE_ADC_INTERNAL
 uint16_t adcTSCAL1;
@@ -82,23 +83,33 @@ ADCDevice adcDeviceByInstance(ADC_TypeDef *instance)
     return ADCINVALID;
 }
 
+// Average of the last ADC_OVERSAMPLE_COUNT conversions of a scan slot
+static uint16_t adcAverageValue(uint8_t dmaIndex)
+{
+    uint32_t sum = 0;
+    for (int scan = 0; scan < ADC_OVERSAMPLE_COUNT; scan++) {
+        sum += adcValues[scan * adcScanChannelCount + dmaIndex];
+    }
+    return sum / ADC_OVERSAMPLE_COUNT;
+}
+
 uint16_t adcGetChannel(uint8_t channel)
 {
 #ifdef DEBUG_ADC_CHANNELS
     if (adcOperatingConfig[0].enabled) {
-        debug[0] = adcValues[adcOperatingConfig[0].dmaIndex];
+        debug[0] = adcAverageValue(adcOperatingConfig[0].dmaIndex);
     }
     if (adcOperatingConfig[1].enabled) {
-        debug[1] = adcValues[adcOperatingConfig[1].dmaIndex];
+        debug[1] = adcAverageValue(adcOperatingConfig[1].dmaIndex);
     }
     if (adcOperatingConfig[2].enabled) {
-        debug[2] = adcValues[adcOperatingConfig[2].dmaIndex];
+        debug[2] = adcAverageValue(adcOperatingConfig[2].dmaIndex);
     }
     if (adcOperatingConfig[3].enabled) {
-        debug[3] = adcValues[adcOperatingConfig[3].dmaIndex];
+        debug[3] = adcAverageValue(adcOperatingConfig[3].dmaIndex);
     }
 #endif
-    return adcValues[adcOperatingConfig[channel].dmaIndex];
+    return adcAverageValue(adcOperatingConfig[channel].dmaIndex);
 }
 
 // Verify a pin designated by tag has connection to an ADC instance designated by device
@@ -50,6 +50,12 @@ typedef struct adcTagMap_s {
 #define ADC_DEVICES_34  ((1 << ADCDEV_3)|(1 << ADCDEV_4))
 #define ADC_DEVICES_123 ((1 << ADCDEV_1)|(1 << ADCDEV_2)|(1 << ADCDEV_3))
 
+// Number of consecutive scans held in the circular DMA buffer and
+// averaged by adcGetChannel()
+#ifndef ADC_OVERSAMPLE_COUNT
+#define ADC_OVERSAMPLE_COUNT 8
+#endif
+
 typedef struct adcDevice_s {
     ADC_TypeDef* ADCx;
     rccPeriphTag_t rccADC;
@@ -68,7 +74,8 @@ typedef struct adcDevice_s {
 extern const adcDevice_t adcHardware[];
 extern const adcTagMap_t adcTagMap[ADC_TAG_MAP_COUNT];
 extern adcOperatingConfig_t adcOperatingConfig[ADC_CHANNEL_COUNT];
-extern volatile uint16_t adcValues[ADC_CHANNEL_COUNT];
+extern volatile uint16_t adcValues[ADC_CHANNEL_COUNT * ADC_OVERSAMPLE_COUNT];
+extern uint8_t adcScanChannelCount;
 
 uint8_t adcChannelByTag(ioTag_t ioTag);
 ADCDevice adcDeviceByInstance(ADC_TypeDef *instance);
@@ -35,6 +35,7 @@
 #include "io_impl.h"
 #include "rcc.h"
 #include "dma.h"
+#include "dma_reqmap.h"
 
 #include "drivers/sensor.h"
 
@@ -231,6 +232,8 @@ void adcInit(const adcConfig_t *config)
         adcOperatingConfig[i].enabled = true;
     }
 
+    adcScanChannelCount = configuredAdcChannels;
+
 #ifndef USE_ADC_INTERNAL
     if (!adcActive) {
         return;
@@ -279,7 +282,14 @@ void adcInit(const adcConfig_t *config)
     ADC_Cmd(adc.ADCx, ENABLE);
 
 
-    dmaInit(dmaGetIdentifier(adc.DMAy_Streamx), OWNER_ADC, 0);
+    // the target's stream comes first, the ADC keeps to it anyway if both its streams are taken
+    const dmaChannelSpec_t *dmaSpec = dmaAllocate(DMA_PERIPH_ADC, device, adc.DMAy_Streamx, OWNER_ADC, 0);
+    if (dmaSpec) {
+        adc.DMAy_Streamx = dmaSpec->ref;
+        adc.channel = dmaSpec->channel;
+    } else {
+        dmaInit(dmaGetIdentifier(adc.DMAy_Streamx), OWNER_ADC, 0);
+    }
 
     DMA_DeInit(adc.DMAy_Streamx);
 
@@ -290,9 +300,9 @@ void adcInit(const adcConfig_t *config)
     DMA_InitStructure.DMA_Channel = adc.channel;
     DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)adcValues;
     DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
-    DMA_InitStructure.DMA_BufferSize = configuredAdcChannels;
+    DMA_InitStructure.DMA_BufferSize = configuredAdcChannels * ADC_OVERSAMPLE_COUNT;
     DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
-    DMA_InitStructure.DMA_MemoryInc = configuredAdcChannels > 1 ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
     DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
     DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
     DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
@@ -35,6 +35,8 @@ typedef struct baroDev_s {
     baroOpFuncPtr get_ut;
     baroOpFuncPtr start_up;
     baroOpFuncPtr get_up;
+    baroOpFuncPtr read_ut;                                                   // optional, starts a non-blocking read that get_ut then decodes
+    baroOpFuncPtr read_up;                                                   // optional, starts a non-blocking read that get_up then decodes
     baroCalculateFuncPtr calculate;
 } baroDev_t;
 
@@ -64,6 +64,7 @@ int32_t bmp280_ut = 0;
 static void bmp280_start_ut(baroDev_t *baro);
 static void bmp280_get_ut(baroDev_t *baro);
 static void bmp280_start_up(baroDev_t *baro);
+static void bmp280_read_up(baroDev_t *baro);
 static void bmp280_get_up(baroDev_t *baro);
 
 STATIC_UNIT_TESTED void bmp280_calculate(int32_t *pressure, int32_t *temperature);
@@ -130,6 +131,7 @@ bool bmp280Detect(baroDev_t *baro)
     baro->start_ut = bmp280_start_ut;
     // only _up part is executed, and gets both temperature and pressure
     baro->start_up = bmp280_start_up;
+    baro->read_up = bmp280_read_up;
     baro->get_up = bmp280_get_up;
     baro->up_delay = ((T_INIT_MAX + T_MEASURE_PER_OSRS_MAX * (((1 << BMP280_TEMPERATURE_OSR) >> 1) + ((1 << BMP280_PRESSURE_OSR) >> 1)) + (BMP280_PRESSURE_OSR ? T_SETUP_PRESSURE_MAX : 0) + 15) / 16) * 1000;
     baro->calculate = bmp280_calculate;
@@ -156,12 +158,26 @@ static void bmp280_start_up(baroDev_t *baro)
     busWriteRegister(&baro->busdev, BMP280_CTRL_MEAS_REG, BMP280_MODE);
 }
 
+// filled by a non-blocking read, so it must outlive the call that starts it
+static uint8_t bmp280_data[BMP280_DATA_FRAME_SIZE];
+static busTransfer_t bmp280_transfer;
+
+static void bmp280_read_up(baroDev_t *baro)
+{
+    // read data from sensor
+    busReadRegisterBufferStart(&baro->busdev, BMP280_PRESSURE_MSB_REG, bmp280_data, BMP280_DATA_FRAME_SIZE, &bmp280_transfer);
+}
+
 static void bmp280_get_up(baroDev_t *baro)
 {
-    uint8_t data[BMP280_DATA_FRAME_SIZE];
+    bool error;
 
-    // read data from sensor
-    busReadRegisterBuffer(&baro->busdev, BMP280_PRESSURE_MSB_REG, data, BMP280_DATA_FRAME_SIZE);
+    // keep the previous sample if the read has not completed
+    if (!busTransferDone(&baro->busdev, &bmp280_transfer, &error) || error) {
+        return;
+    }
+
+    const uint8_t *data = bmp280_data;
     bmp280_up = (int32_t)((((uint32_t)(data[0])) << 12) | (((uint32_t)(data[1])) << 4) | ((uint32_t)data[2] >> 4));
     bmp280_ut = (int32_t)((((uint32_t)(data[3])) << 12) | (((uint32_t)(data[4])) << 4) | ((uint32_t)data[5] >> 4));
 }
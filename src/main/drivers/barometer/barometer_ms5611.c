@@ -52,7 +52,10 @@
 static void ms5611_reset(busDevice_t *busdev);
 static uint16_t ms5611_prom(busDevice_t *busdev, int8_t coef_num);
 STATIC_UNIT_TESTED int8_t ms5611_crc(uint16_t *prom);
-static uint32_t ms5611_read_adc(busDevice_t *busdev);
+static void ms5611_read_adc_start(busDevice_t *busdev);
+static bool ms5611_read_adc_complete(busDevice_t *busdev, uint32_t *value);
+static void ms5611_read_ut(baroDev_t *baro);
+static void ms5611_read_up(baroDev_t *baro);
 static void ms5611_start_ut(baroDev_t *baro);
 static void ms5611_get_ut(baroDev_t *baro);
 static void ms5611_start_up(baroDev_t *baro);
@@ -126,8 +129,10 @@ bool ms5611Detect(baroDev_t *baro)
     baro->ut_delay = 10000;
     baro->up_delay = 10000;
     baro->start_ut = ms5611_start_ut;
+    baro->read_ut = ms5611_read_ut;
     baro->get_ut = ms5611_get_ut;
     baro->start_up = ms5611_start_up;
+    baro->read_up = ms5611_read_up;
     baro->get_up = ms5611_get_up;
     baro->calculate = ms5611_calculate;
 
@@ -189,13 +194,30 @@ STATIC_UNIT_TESTED int8_t ms5611_crc(uint16_t *prom)
     return -1;
 }
 
-static uint32_t ms5611_read_adc(busDevice_t *busdev)
+// filled by a non-blocking read, so it must outlive the call that starts it
+static uint8_t ms5611_adc_rxbuf[3];
+static busTransfer_t ms5611_adc_transfer;
+
+static void ms5611_read_adc_start(busDevice_t *busdev)
+{
+    busReadRegisterBufferStart(busdev, CMD_ADC_READ, ms5611_adc_rxbuf, 3, &ms5611_adc_transfer); // read ADC
+}
+
+static bool ms5611_read_adc_complete(busDevice_t *busdev, uint32_t *value)
 {
-    uint8_t rxbuf[3];
+    bool error;
+
+    if (!busTransferDone(busdev, &ms5611_adc_transfer, &error) || error) {
+        return false;
+    }
 
-    busReadRegisterBuffer(busdev, CMD_ADC_READ, rxbuf, 3); // read ADC
+    *value = (ms5611_adc_rxbuf[0] << 16) | (ms5611_adc_rxbuf[1] << 8) | ms5611_adc_rxbuf[2];
+    return true;
+}
 
-    return (rxbuf[0] << 16) | (rxbuf[1] << 8) | rxbuf[2];
+static void ms5611_read_ut(baroDev_t *baro)
+{
+    ms5611_read_adc_start(&baro->busdev);
 }
 
 static void ms5611_start_ut(baroDev_t *baro)
@@ -205,7 +227,13 @@ static void ms5611_start_ut(baroDev_t *baro)
 
 static void ms5611_get_ut(baroDev_t *baro)
 {
-    ms5611_ut = ms5611_read_adc(&baro->busdev);
+    // keep the previous sample if the read has not completed
+    ms5611_read_adc_complete(&baro->busdev, &ms5611_ut);
+}
+
+static void ms5611_read_up(baroDev_t *baro)
+{
+    ms5611_read_adc_start(&baro->busdev);
 }
 
 static void ms5611_start_up(baroDev_t *baro)
@@ -215,7 +243,7 @@ static void ms5611_start_up(baroDev_t *baro)
 
 static void ms5611_get_up(baroDev_t *baro)
 {
-    ms5611_up = ms5611_read_adc(&baro->busdev);
+    ms5611_read_adc_complete(&baro->busdev, &ms5611_up);
 }
 
 STATIC_UNIT_TESTED void ms5611_calculate(int32_t *pressure, int32_t *temperature)
@@ -68,6 +68,55 @@ bool busReadRegisterBuffer(const busDevice_t *busdev, uint8_t reg, uint8_t *data
     }
 }
 
+// Completes before returning on SPI, the data is only valid once busTransferDone() returns true for the transfer
+bool busReadRegisterBufferStart(const busDevice_t *busdev, uint8_t reg, uint8_t *data, uint8_t length, busTransfer_t *transfer)
+{
+#if !defined(USE_SPI) && !defined(USE_I2C)
+    UNUSED(reg);
+    UNUSED(data);
+    UNUSED(length);
+#endif
+    bool ok;
+
+    switch (busdev->bustype) {
+#ifdef USE_SPI
+    case BUSTYPE_SPI:
+        ok = spiBusReadRegisterBuffer(busdev, reg | 0x80, data, length);
+        break;
+#endif
+#ifdef USE_I2C
+    case BUSTYPE_I2C:
+        ok = i2cBusReadRegisterBufferStart(busdev, reg, data, length, &transfer->id);
+        break;
+#endif
+    default:
+        ok = false;
+        break;
+    }
+
+    transfer->failed = !ok;
+    return ok;
+}
+
+// An I2C bus can be shared, so this checks the completion of this device's transfer rather than whether the bus is idle
+bool busTransferDone(const busDevice_t *busdev, const busTransfer_t *transfer, bool *error)
+{
+    if (transfer->failed) {
+        *error = true;
+        return true;
+    }
+
+    switch (busdev->bustype) {
+#ifdef USE_I2C
+    case BUSTYPE_I2C:
+        return i2cBusTransferDone(busdev, transfer->id, error);
+#endif
+    default:
+        *error = false;
+        return true;
+    }
+}
+
 uint8_t busReadRegister(const busDevice_t *busdev, uint8_t reg)
 {
 #if !defined(USE_SPI) && !defined(USE_I2C)
@@ -41,6 +41,8 @@ typedef struct busDevice_s {
             SPI_HandleTypeDef* handle; // cached here for efficiency
 #endif
             IO_t csnPin;
+            uint16_t readDivisor;  // clock for register reads and data bursts, 0 keeps the bus clock
+            uint16_t writeDivisor; // clock for register writes, 0 keeps the bus clock
         } spi;
         struct deviceI2C_s {
             I2CDevice device;
@@ -60,3 +62,11 @@ void targetBusInit(void);
 bool busWriteRegister(const busDevice_t *bus, uint8_t reg, uint8_t data);
 bool busReadRegisterBuffer(const busDevice_t *bus, uint8_t reg, uint8_t *data, uint8_t length);
 uint8_t busReadRegister(const busDevice_t *bus, uint8_t reg);
+// A non-blocking read started by busReadRegisterBufferStart(), kept by the device until busTransferDone()
+typedef struct busTransfer_s {
+    i2cTransferId_t id;
+    bool failed;        // to start
+} busTransfer_t;
+
+bool busReadRegisterBufferStart(const busDevice_t *bus, uint8_t reg, uint8_t *data, uint8_t length, busTransfer_t *transfer);
+bool busTransferDone(const busDevice_t *bus, const busTransfer_t *transfer, bool *error);
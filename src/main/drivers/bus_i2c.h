@@ -62,4 +62,13 @@ bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_,
 bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t data);
 bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t len, uint8_t* buf);
 
+// Non-blocking variants, these only wait for a previous transfer on the bus to finish. The id of the transfer is
+// returned in *id (may be NULL), the buffer must stay valid until i2cTransferDone() reports that transfer complete.
+// The id tells the transfers of the devices sharing a bus apart, the bus being idle doesn't mean a given one is done.
+typedef uint32_t i2cTransferId_t;
+
+bool i2cWriteBufferStart(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data, i2cTransferId_t *id);
+bool i2cReadBufferStart(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t* buf, i2cTransferId_t *id);
+bool i2cTransferDone(I2CDevice device, i2cTransferId_t id, bool *error);
+
 uint16_t i2cGetErrorCounter(void);
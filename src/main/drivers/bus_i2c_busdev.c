@@ -45,4 +45,14 @@ uint8_t i2cBusReadRegister(const busDevice_t *busdev, uint8_t reg)
     i2cRead(busdev->busdev_u.i2c.device, busdev->busdev_u.i2c.address, reg, 1, &data);
     return data;
 }
+
+bool i2cBusReadRegisterBufferStart(const busDevice_t *busdev, uint8_t reg, uint8_t *data, uint8_t length, i2cTransferId_t *id)
+{
+    return i2cReadBufferStart(busdev->busdev_u.i2c.device, busdev->busdev_u.i2c.address, reg, length, data, id);
+}
+
+bool i2cBusTransferDone(const busDevice_t *busdev, i2cTransferId_t id, bool *error)
+{
+    return i2cTransferDone(busdev->busdev_u.i2c.device, id, error);
+}
 #endif
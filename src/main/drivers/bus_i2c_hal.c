@@ -37,6 +37,9 @@
 
 #define CLOCKSPEED 800000    // i2c clockspeed 400kHz default (conform specs), 800kHz  and  1200kHz (Betaflight default)
 
+// Time allowed for a running non-blocking transfer to finish, a full OLED line takes a few milliseconds
+#define I2C_DEFAULT_TIMEOUT_MS 10
+
 // Number of bits in I2C protocol phase
 #define LEN_ADDR 7
 #define LEN_RW 1
@@ -163,18 +166,63 @@ static bool i2cHandleHardwareFailure(I2CDevice device)
     return false;
 }
 
-bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data)
+static I2C_HandleTypeDef *i2cGetHandle(I2CDevice device)
 {
     if (device == I2CINVALID || device > I2CDEV_COUNT) {
-        return false;
+        return NULL;
     }
 
     I2C_HandleTypeDef *pHandle = &i2cDevice[device].handle;
 
     if (!pHandle->Instance) {
+        return NULL;
+    }
+
+    return pHandle;
+}
+
+// A previous non-blocking transfer may still be running, the HAL rejects new ones until it is done
+static bool i2cWaitForReady(I2C_HandleTypeDef *pHandle)
+{
+    const uint32_t tickstart = HAL_GetTick();
+
+    while (HAL_I2C_GetState(pHandle) != HAL_I2C_STATE_READY) {
+        if (HAL_GetTick() - tickstart > I2C_DEFAULT_TIMEOUT_MS) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Waits for the previous transfer and keeps its result for its owner, then numbers the next one
+static bool i2cBeginTransfer(I2CDevice device, I2C_HandleTypeDef *pHandle, i2cTransferId_t *id)
+{
+    i2cDevice_t *pDev = &i2cDevice[device];
+
+    const bool ready = i2cWaitForReady(pHandle);
+    pDev->previousTransferFailed = !ready || HAL_I2C_GetError(pHandle) != HAL_I2C_ERROR_NONE;
+    pDev->transferId++;
+    if (id) {
+        *id = pDev->transferId;
+    }
+    pDev->transferStartedAt = HAL_GetTick();
+
+    return ready;
+}
+
+bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data)
+{
+    I2C_HandleTypeDef *pHandle = i2cGetHandle(device);
+
+    if (!pHandle) {
         return false;
     }
 
+    if (!i2cBeginTransfer(device, pHandle, NULL)) {
+        return i2cHandleHardwareFailure(device);
+    }
+
     HAL_StatusTypeDef status;
 
     if (reg_ == 0xFF)
@@ -195,14 +243,14 @@ bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t data)
 
 bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t* buf)
 {
-    if (device == I2CINVALID || device > I2CDEV_COUNT) {
+    I2C_HandleTypeDef *pHandle = i2cGetHandle(device);
+
+    if (!pHandle) {
         return false;
     }
 
-    I2C_HandleTypeDef *pHandle = &i2cDevice[device].handle;
-
-    if (!pHandle->Instance) {
-        return false;
+    if (!i2cBeginTransfer(device, pHandle, NULL)) {
+        return i2cHandleHardwareFailure(device);
     }
 
     HAL_StatusTypeDef status;
@@ -218,6 +266,86 @@ bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t
     return true;
 }
 
+bool i2cWriteBufferStart(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data, i2cTransferId_t *id)
+{
+    I2C_HandleTypeDef *pHandle = i2cGetHandle(device);
+
+    if (!pHandle) {
+        return false;
+    }
+
+    if (!i2cBeginTransfer(device, pHandle, id)) {
+        return i2cHandleHardwareFailure(device);
+    }
+
+    HAL_StatusTypeDef status;
+
+    if (reg_ == 0xFF)
+        status = HAL_I2C_Master_Transmit_IT(pHandle, addr_ << 1, data, len_);
+    else
+        status = HAL_I2C_Mem_Write_IT(pHandle, addr_ << 1, reg_, I2C_MEMADD_SIZE_8BIT, data, len_);
+
+    if (status != HAL_OK)
+        return i2cHandleHardwareFailure(device);
+
+    return true;
+}
+
+bool i2cReadBufferStart(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t* buf, i2cTransferId_t *id)
+{
+    I2C_HandleTypeDef *pHandle = i2cGetHandle(device);
+
+    if (!pHandle) {
+        return false;
+    }
+
+    if (!i2cBeginTransfer(device, pHandle, id)) {
+        return i2cHandleHardwareFailure(device);
+    }
+
+    HAL_StatusTypeDef status;
+
+    if (reg_ == 0xFF)
+        status = HAL_I2C_Master_Receive_IT(pHandle, addr_ << 1, buf, len);
+    else
+        status = HAL_I2C_Mem_Read_IT(pHandle, addr_ << 1, reg_, I2C_MEMADD_SIZE_8BIT, buf, len);
+
+    if (status != HAL_OK)
+        return i2cHandleHardwareFailure(device);
+
+    return true;
+}
+
+bool i2cTransferDone(I2CDevice device, i2cTransferId_t id, bool *error)
+{
+    I2C_HandleTypeDef *pHandle = i2cGetHandle(device);
+
+    if (!pHandle) {
+        *error = true;
+        return true;
+    }
+
+    const i2cDevice_t *pDev = &i2cDevice[device];
+
+    if (id != pDev->transferId) {
+        // another device has started a transfer since, which waited for this one to finish
+        *error = id != pDev->transferId - 1 || pDev->previousTransferFailed;
+        return true;
+    }
+
+    if (HAL_I2C_GetState(pHandle) != HAL_I2C_STATE_READY) {
+        if (HAL_GetTick() - pDev->transferStartedAt <= I2C_DEFAULT_TIMEOUT_MS) {
+            return false;
+        }
+        i2cHandleHardwareFailure(device);
+        *error = true;
+        return true;
+    }
+
+    *error = HAL_I2C_GetError(pHandle) != HAL_I2C_ERROR_NONE;
+    return true;
+}
+
 void i2cInit(I2CDevice device)
 {
     if (device == I2CINVALID) {
@@ -22,8 +22,10 @@
 
 #include "platform.h"
 
+#include "drivers/bus_i2c.h"
 #include "drivers/io_types.h"
 #include "drivers/rcc_types.h"
+#include "drivers/time.h"
 
 #define I2C_SHORT_TIMEOUT            ((uint32_t)0x1000)
 #define I2C_LONG_TIMEOUT             ((uint32_t)(10 * I2C_SHORT_TIMEOUT))
@@ -71,6 +73,7 @@ typedef struct i2cState_s {
     volatile uint8_t reading;
     volatile uint8_t* write_p;
     volatile uint8_t* read_p;
+    timeUs_t startedAtUs;
 } i2cState_t;
 #endif
 
@@ -86,12 +89,18 @@ typedef struct i2cDevice_s {
     bool overClock;
     bool pullUp;
 
+    // Transfers are numbered as they start. A transfer only starts once the previous one is done, so only the result
+    // of the latest one and of the one before it need to be kept for i2cTransferDone().
+    i2cTransferId_t transferId;
+    bool previousTransferFailed;
+
     // MCU/Driver dependent member follows
 #if defined(STM32F1) || defined(STM32F4)
     i2cState_t state;
 #endif
 #ifdef USE_HAL_DRIVER
     I2C_HandleTypeDef handle;
+    uint32_t transferStartedAt;     // HAL tick
 #endif
 } i2cDevice_t;
 
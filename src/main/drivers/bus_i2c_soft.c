@@ -261,6 +261,43 @@ bool i2cRead(I2CDevice device, uint8_t addr, uint8_t reg, uint8_t len, uint8_t *
     return true;
 }
 
+// The bus is bit-banged, the non-blocking variants complete before they return
+static i2cTransferId_t i2cTransferId = 0;
+static bool i2cTransferFailed = false;
+static bool i2cPreviousTransferFailed = false;
+
+static bool i2cTransferCompleted(bool ok, i2cTransferId_t *id)
+{
+    i2cPreviousTransferFailed = i2cTransferFailed;
+    i2cTransferFailed = !ok;
+    i2cTransferId++;
+    if (id) {
+        *id = i2cTransferId;
+    }
+    return ok;
+}
+
+bool i2cWriteBufferStart(I2CDevice device, uint8_t addr, uint8_t reg, uint8_t len, uint8_t *data, i2cTransferId_t *id)
+{
+    return i2cTransferCompleted(i2cWriteBuffer(device, addr, reg, len, data), id);
+}
+
+bool i2cReadBufferStart(I2CDevice device, uint8_t addr, uint8_t reg, uint8_t len, uint8_t *buf, i2cTransferId_t *id)
+{
+    return i2cTransferCompleted(i2cRead(device, addr, reg, len, buf), id);
+}
+
+bool i2cTransferDone(I2CDevice device, i2cTransferId_t id, bool *error)
+{
+    UNUSED(device);
+    if (id == i2cTransferId) {
+        *error = i2cTransferFailed;
+    } else {
+        *error = id != i2cTransferId - 1 || i2cPreviousTransferFailed;
+    }
+    return true;
+}
+
 uint16_t i2cGetErrorCounter(void)
 {
     return i2cErrorCount;
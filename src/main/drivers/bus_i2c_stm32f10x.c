@@ -161,7 +161,25 @@ static bool i2cHandleHardwareFailure(I2CDevice device)
     return false;
 }
 
-bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data)
+// Transfers are interrupt driven, allow twice the byte time at 400kHz plus the addressing
+#define I2C_TRANSFER_TIMEOUT_US(bytes) (100 + (bytes) * 50)
+
+static bool i2cWaitForCompletion(I2CDevice device)
+{
+    i2cState_t *state = &i2cDevice[device].state;
+    const timeUs_t startTimeUs = micros();
+    const timeDelta_t timeoutUs = I2C_TRANSFER_TIMEOUT_US(state->bytes);
+
+    while (state->busy) {
+        if (cmpTimeUs(micros(), startTimeUs) > timeoutUs) {
+            return i2cHandleHardwareFailure(device);
+        }
+    }
+
+    return !(state->error);
+}
+
+static bool i2cStartTransfer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data, bool reading, i2cTransferId_t *id)
 {
     if (device == I2CINVALID || device > I2CDEV_COUNT) {
         return false;
@@ -173,18 +191,28 @@ bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_,
         return false;
     }
 
-    i2cState_t *state = &i2cDevice[device].state;
+    i2cDevice_t *pDev = &i2cDevice[device];
+    i2cState_t *state = &pDev->state;
+
+    // a previous non-blocking transfer may still be using the bus, its result is kept for its owner
+    pDev->previousTransferFailed = state->busy ? !i2cWaitForCompletion(device) : state->error;
+    pDev->transferId++;
+    if (id) {
+        *id = pDev->transferId;
+    }
+
     uint32_t timeout = I2C_DEFAULT_TIMEOUT;
 
     state->addr = addr_ << 1;
     state->reg = reg_;
-    state->writing = 1;
-    state->reading = 0;
+    state->writing = !reading;
+    state->reading = reading;
     state->write_p = data;
     state->read_p = data;
     state->bytes = len_;
     state->busy = 1;
     state->error = false;
+    state->startedAtUs = micros();
 
     if (!(I2Cx->CR2 & I2C_IT_EVT)) {                                    // if we are restarting the driver
         if (!(I2Cx->CR1 & I2C_CR1_START)) {                             // ensure sending a start
@@ -196,60 +224,61 @@ bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_,
         I2C_ITConfig(I2Cx, I2C_IT_EVT | I2C_IT_ERR, ENABLE);            // allow the interrupts to fire off again
     }
 
-    timeout = I2C_DEFAULT_TIMEOUT;
-    while (state->busy && --timeout > 0) {; }
-    if (timeout == 0)
-        return i2cHandleHardwareFailure(device);
+    return true;
+}
 
-    return !(state->error);
+bool i2cWriteBufferStart(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data, i2cTransferId_t *id)
+{
+    return i2cStartTransfer(device, addr_, reg_, len_, data, false, id);
 }
 
-bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t data)
+bool i2cReadBufferStart(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t* buf, i2cTransferId_t *id)
 {
-    return i2cWriteBuffer(device, addr_, reg_, 1, &data);
+    return i2cStartTransfer(device, addr_, reg_, len, buf, true, id);
 }
 
-bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t* buf)
+bool i2cTransferDone(I2CDevice device, i2cTransferId_t id, bool *error)
 {
     if (device == I2CINVALID || device > I2CDEV_COUNT) {
-        return false;
+        *error = true;
+        return true;
     }
 
-    I2C_TypeDef *I2Cx = i2cDevice[device].reg;
+    const i2cDevice_t *pDev = &i2cDevice[device];
+    const i2cState_t *state = &pDev->state;
 
-    if (!I2Cx) {
-        return false;
+    if (id != pDev->transferId) {
+        // another device has started a transfer since, which waited for this one to finish
+        *error = id != pDev->transferId - 1 || pDev->previousTransferFailed;
+        return true;
     }
 
-    i2cState_t *state = &i2cDevice[device].state;
-    uint32_t timeout = I2C_DEFAULT_TIMEOUT;
-
-    state->addr = addr_ << 1;
-    state->reg = reg_;
-    state->writing = 0;
-    state->reading = 1;
-    state->read_p = buf;
-    state->write_p = buf;
-    state->bytes = len;
-    state->busy = 1;
-    state->error = false;
-
-    if (!(I2Cx->CR2 & I2C_IT_EVT)) {                                    // if we are restarting the driver
-        if (!(I2Cx->CR1 & I2C_CR1_START)) {                             // ensure sending a start
-            while (I2Cx->CR1 & I2C_CR1_STOP && --timeout > 0) {; }     // wait for any stop to finish sending
-            if (timeout == 0)
-                return i2cHandleHardwareFailure(device);
-            I2C_GenerateSTART(I2Cx, ENABLE);                            // send the start for the new job
+    if (state->busy) {
+        if (cmpTimeUs(micros(), state->startedAtUs) <= I2C_TRANSFER_TIMEOUT_US(state->bytes)) {
+            return false;
         }
-        I2C_ITConfig(I2Cx, I2C_IT_EVT | I2C_IT_ERR, ENABLE);            // allow the interrupts to fire off again
+        i2cHandleHardwareFailure(device);
+        *error = true;
+        return true;
     }
 
-    timeout = I2C_DEFAULT_TIMEOUT;
-    while (state->busy && --timeout > 0) {; }
-    if (timeout == 0)
-        return i2cHandleHardwareFailure(device);
+    *error = state->error;
+    return true;
+}
 
-    return !(state->error);
+bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len_, uint8_t *data)
+{
+    return i2cStartTransfer(device, addr_, reg_, len_, data, false, NULL) && i2cWaitForCompletion(device);
+}
+
+bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t data)
+{
+    return i2cWriteBuffer(device, addr_, reg_, 1, &data);
+}
+
+bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg_, uint8_t len, uint8_t* buf)
+{
+    return i2cStartTransfer(device, addr_, reg_, len, buf, true, NULL) && i2cWaitForCompletion(device);
 }
 
 static void i2c_er_handler(I2CDevice device) {
@@ -130,7 +130,7 @@ uint16_t i2cGetErrorCounter(void)
     return i2cErrorCount;
 }
 
-bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t data)
+bool i2cWriteBuffer(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t len, uint8_t *data)
 {
     if (device == I2CINVALID || device > I2CDEV_COUNT) {
         return false;
@@ -176,18 +176,22 @@ bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t data)
     }
 
     /* Configure slave address, nbytes, reload, end mode and start or stop generation */
-    I2C_TransferHandling(I2Cx, addr_, 1, I2C_AutoEnd_Mode, I2C_No_StartStop);
+    I2C_TransferHandling(I2Cx, addr_, len, I2C_AutoEnd_Mode, I2C_No_StartStop);
 
-    /* Wait until TXIS flag is set */
-    i2cTimeout = I2C_LONG_TIMEOUT;
-    while (I2C_GetFlagStatus(I2Cx, I2C_ISR_TXIS) == RESET) {
-        if ((i2cTimeout--) == 0) {
-            return i2cTimeoutUserCallback();
+    while (len) {
+        /* Wait until TXIS flag is set */
+        i2cTimeout = I2C_LONG_TIMEOUT;
+        while (I2C_GetFlagStatus(I2Cx, I2C_ISR_TXIS) == RESET) {
+            if ((i2cTimeout--) == 0) {
+                return i2cTimeoutUserCallback();
+            }
         }
-    }
 
-    /* Write data to TXDR */
-    I2C_SendData(I2Cx, data);
+        /* Write data to TXDR */
+        I2C_SendData(I2Cx, *data);
+        data++;
+        len--;
+    }
 
     /* Wait until STOPF flag is set */
     i2cTimeout = I2C_LONG_TIMEOUT;
@@ -203,6 +207,11 @@ bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t data)
     return true;
 }
 
+bool i2cWrite(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t data)
+{
+    return i2cWriteBuffer(device, addr_, reg, 1, &data);
+}
+
 bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t len, uint8_t* buf)
 {
     if (device == I2CINVALID || device > I2CDEV_COUNT) {
@@ -284,4 +293,43 @@ bool i2cRead(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t len, uint8_t*
     return true;
 }
 
+// The transfers are polled, the non-blocking variants complete before they return
+static bool i2cTransferFailed[I2CDEV_COUNT];
+
+static bool i2cTransferCompleted(I2CDevice device, bool ok, i2cTransferId_t *id)
+{
+    if (device != I2CINVALID && device < I2CDEV_COUNT) {
+        i2cDevice_t *pDev = &i2cDevice[device];
+        pDev->previousTransferFailed = i2cTransferFailed[device];
+        i2cTransferFailed[device] = !ok;
+        pDev->transferId++;
+        if (id) {
+            *id = pDev->transferId;
+        }
+    }
+    return ok;
+}
+
+bool i2cWriteBufferStart(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t len, uint8_t *data, i2cTransferId_t *id)
+{
+    return i2cTransferCompleted(device, i2cWriteBuffer(device, addr_, reg, len, data), id);
+}
+
+bool i2cReadBufferStart(I2CDevice device, uint8_t addr_, uint8_t reg, uint8_t len, uint8_t* buf, i2cTransferId_t *id)
+{
+    return i2cTransferCompleted(device, i2cRead(device, addr_, reg, len, buf), id);
+}
+
+bool i2cTransferDone(I2CDevice device, i2cTransferId_t id, bool *error)
+{
+    if (device == I2CINVALID || device >= I2CDEV_COUNT) {
+        *error = true;
+    } else if (id == i2cDevice[device].transferId) {
+        *error = i2cTransferFailed[device];
+    } else {
+        *error = id != i2cDevice[device].transferId - 1 || i2cDevice[device].previousTransferFailed;
+    }
+    return true;
+}
+
 #endif
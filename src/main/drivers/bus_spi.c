@@ -26,12 +26,18 @@
 
 #ifdef USE_SPI
 
+#include "build/atomic.h"
+
+#include "common/maths.h"
+
 #include "drivers/bus.h"
 #include "drivers/bus_spi.h"
 #include "drivers/bus_spi_impl.h"
 #include "drivers/exti.h"
 #include "drivers/io.h"
+#include "drivers/nvic.h"
 #include "drivers/rcc.h"
+#include "drivers/time.h"
 
 spiDevice_t spiDevice[SPIDEV_COUNT];
 
@@ -69,8 +75,49 @@ SPI_TypeDef *spiInstanceByDevice(SPIDevice device)
     return spiDevice[device].dev;
 }
 
+#ifdef USE_OVERCLOCK
+static uint32_t spiApb1ClockHz;
+static uint32_t spiApb2ClockHz;
+static uint32_t spiStockApb2ClockHz;   // APB2 clock at the stock core clock, the dividers are chosen for it
+
+static void spiInitBusClocks(void)
+{
+#ifdef USE_HAL_DRIVER
+    spiApb1ClockHz = HAL_RCC_GetPCLK1Freq();
+    spiApb2ClockHz = HAL_RCC_GetPCLK2Freq();
+#else
+    RCC_ClocksTypeDef clocks;
+    RCC_GetClocksFreq(&clocks);
+    spiApb1ClockHz = clocks.PCLK1_Frequency;
+    spiApb2ClockHz = clocks.PCLK2_Frequency;
+#endif
+    // the APB prescalers are the same at every overclock level
+    spiStockApb2ClockHz = (uint64_t)spiApb2ClockHz * SystemCoreClockStock() / SystemCoreClock;
+}
+
+// The SPI clock dividers are chosen for APB2 at the stock core clock. The divider actually set is
+// worked out from the clock of the bus the device is on, as the smallest power of two that keeps
+// the device at or below the SPI clock it would get at the stock core clock. That also covers
+// SPI2 and SPI3, which are on the slower APB1.
+uint16_t spiOverclockDivisor(SPI_TypeDef *instance, uint16_t divisor)
+{
+    const uint32_t busClockHz = (instance == SPI2 || instance == SPI3) ? spiApb1ClockHz : spiApb2ClockHz;
+    const uint32_t maxSpiClockHz = spiStockApb2ClockHz / MAX(divisor, 1);
+
+    uint16_t busDivisor = 2;
+    while (busDivisor < SPI_CLOCK_INITIALIZATON && busClockHz / busDivisor > maxSpiClockHz) {
+        busDivisor <<= 1;
+    }
+    return busDivisor;
+}
+#endif
+
 bool spiInit(SPIDevice device)
 {
+#ifdef USE_OVERCLOCK
+    spiInitBusClocks();
+#endif
+
     switch (device) {
     case SPIINVALID:
         return false;
@@ -116,11 +163,143 @@ uint32_t spiTimeoutUserCallback(SPI_TypeDef *instance)
     return spiDevice[device].errorCount;
 }
 
-bool spiBusTransfer(const busDevice_t *bus, const uint8_t *txData, uint8_t *rxData, int length)
+#ifdef USE_SPI_BUS_CLAIM
+/*
+ * Bus claims
+ *
+ * DMA transfers run on after the call that started them, so every transaction on a bus
+ * with DMA users holds a claim on it from chip select low to high. Blocking transactions
+ * wait for the bus. A transfer started from interrupt context, like a gyro read on data
+ * ready, cannot wait; it queues itself instead and is started by the release of the
+ * current claim, ahead of any transaction still waiting in task context. The MAX7456
+ * and the SD card drivers don't claim, so they still need a bus of their own.
+ */
+#define SPI_BUS_CLAIM_TIMEOUT_US 1000   // longer than a DMA flash page at the slowest clock
+
+bool spiBusClaim(SPI_TypeDef *instance)
+{
+    const SPIDevice device = spiDeviceByInstance(instance);
+    if (device == SPIINVALID) {
+        return false;
+    }
+
+    bool claimed = false;
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        if (!spiDevice[device].claimed) {
+            spiDevice[device].claimed = true;
+            claimed = true;
+        }
+    }
+    return claimed;
+}
+
+// Returns false, without the claim, if the bus stayed busy for longer than any transfer takes
+bool spiBusClaimWait(SPI_TypeDef *instance)
+{
+    const timeUs_t startUs = micros();
+    while (!spiBusClaim(instance)) {
+        if (cmpTimeUs(micros(), startUs) > SPI_BUS_CLAIM_TIMEOUT_US) {
+            spiTimeoutUserCallback(instance);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Claims the bus, or has callback called by the next release. Only one transfer can wait per bus.
+bool spiBusClaimOrQueue(SPI_TypeDef *instance, spiBusReleaseCallbackFn *callback, uint32_t arg)
+{
+    const SPIDevice device = spiDeviceByInstance(instance);
+    if (device == SPIINVALID) {
+        return false;
+    }
+
+    bool claimed = false;
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        if (!spiDevice[device].claimed) {
+            spiDevice[device].claimed = true;
+            claimed = true;
+        } else {
+            spiDevice[device].releaseCallback = callback;
+            spiDevice[device].releaseCallbackArg = arg;
+        }
+    }
+    return claimed;
+}
+
+void spiBusRelease(SPI_TypeDef *instance)
 {
+    const SPIDevice device = spiDeviceByInstance(instance);
+    if (device == SPIINVALID) {
+        return;
+    }
+
+    spiBusReleaseCallbackFn *callback;
+    uint32_t arg;
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        spiDevice[device].claimed = false;
+        callback = spiDevice[device].releaseCallback;
+        arg = spiDevice[device].releaseCallbackArg;
+        spiDevice[device].releaseCallback = NULL;
+    }
+
+    if (callback) {
+        callback(arg);
+    }
+}
+#endif // USE_SPI_BUS_CLAIM
+
+// Only touches the prescaler if the bus is not clocked at the divisor already, so that a device
+// switching between its read and write clocks costs a compare per transaction
+static void spiBusSetDivisorIfChanged(const busDevice_t *bus, uint16_t divisor)
+{
+    if (!divisor) {
+        return;
+    }
+    const SPIDevice device = spiDeviceByInstance(bus->busdev_u.spi.instance);
+    if (device != SPIINVALID && spiDevice[device].divisor != divisor) {
+        spiSetDivisor(bus->busdev_u.spi.instance, divisor);
+    }
+}
+
+// For transfers started outside of the blocking functions, DMA reads, once the bus is claimed
+void spiBusUseReadClock(const busDevice_t *bus)
+{
+    spiBusSetDivisorIfChanged(bus, bus->busdev_u.spi.readDivisor);
+}
+
+// Starts a blocking transaction at the given clock, returns true if a bus claim has to be released at the end
+static bool spiBusBegin(const busDevice_t *bus, uint16_t divisor)
+{
+#ifdef USE_SPI_BUS_CLAIM
+    const bool claimed = spiBusClaimWait(bus->busdev_u.spi.instance);
+#else
+    const bool claimed = false;
+#endif
+    spiBusSetDivisorIfChanged(bus, divisor);
     IOLo(bus->busdev_u.spi.csnPin);
-    spiTransfer(bus->busdev_u.spi.instance, txData, rxData, length);
+    return claimed;
+}
+
+static void spiBusEnd(const busDevice_t *bus, bool claimed)
+{
     IOHi(bus->busdev_u.spi.csnPin);
+#ifdef USE_SPI_BUS_CLAIM
+    if (claimed) {
+        spiBusRelease(bus->busdev_u.spi.instance);
+    }
+#else
+    UNUSED(claimed);
+#endif
+}
+
+bool spiBusTransfer(const busDevice_t *bus, const uint8_t *txData, uint8_t *rxData, int length)
+{
+    // a register device transfer is a read if the register address has the read bit set
+    const bool read = !txData || (txData[0] & 0x80);
+    const bool claimed = spiBusBegin(bus, read ? bus->busdev_u.spi.readDivisor : bus->busdev_u.spi.writeDivisor);
+    spiTransfer(bus->busdev_u.spi.instance, txData, rxData, length);
+    spiBusEnd(bus, claimed);
     return true;
 }
 
@@ -143,20 +322,20 @@ void spiResetErrorCounter(SPI_TypeDef *instance)
 
 bool spiBusWriteRegister(const busDevice_t *bus, uint8_t reg, uint8_t data)
 {
-    IOLo(bus->busdev_u.spi.csnPin);
+    const bool claimed = spiBusBegin(bus, bus->busdev_u.spi.writeDivisor);
     spiTransferByte(bus->busdev_u.spi.instance, reg);
     spiTransferByte(bus->busdev_u.spi.instance, data);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusEnd(bus, claimed);
 
     return true;
 }
 
 bool spiBusReadRegisterBuffer(const busDevice_t *bus, uint8_t reg, uint8_t *data, uint8_t length)
 {
-    IOLo(bus->busdev_u.spi.csnPin);
+    const bool claimed = spiBusBegin(bus, bus->busdev_u.spi.readDivisor);
     spiTransferByte(bus->busdev_u.spi.instance, reg | 0x80); // read transaction
     spiTransfer(bus->busdev_u.spi.instance, NULL, data, length);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusEnd(bus, claimed);
 
     return true;
 }
@@ -164,10 +343,10 @@ bool spiBusReadRegisterBuffer(const busDevice_t *bus, uint8_t reg, uint8_t *data
 uint8_t spiBusReadRegister(const busDevice_t *bus, uint8_t reg)
 {
     uint8_t data;
-    IOLo(bus->busdev_u.spi.csnPin);
+    const bool claimed = spiBusBegin(bus, bus->busdev_u.spi.readDivisor);
     spiTransferByte(bus->busdev_u.spi.instance, reg | 0x80); // read transaction
     spiTransfer(bus->busdev_u.spi.instance, NULL, &data, 1);
-    IOHi(bus->busdev_u.spi.csnPin);
+    spiBusEnd(bus, claimed);
 
     return data;
 }
@@ -177,4 +356,13 @@ void spiBusSetInstance(busDevice_t *bus, SPI_TypeDef *instance)
     bus->bustype = BUSTYPE_SPI;
     bus->busdev_u.spi.instance = instance;
 }
+
+// Sets the clocks the bus runs at for this device from then on, reads and writes separately so that
+// sensor data can be read at the fastest clock the chip allows while its registers are written at
+// the slow one. A divisor of 0 leaves the clock as it is for that direction.
+void spiBusSetDivisors(busDevice_t *bus, uint16_t readDivisor, uint16_t writeDivisor)
+{
+    bus->busdev_u.spi.readDivisor = readDivisor;
+    bus->busdev_u.spi.writeDivisor = writeDivisor;
+}
 #endif
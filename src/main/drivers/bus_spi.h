@@ -102,6 +102,9 @@ void spiPreInit(void);
 
 bool spiInit(SPIDevice device);
 void spiSetDivisor(SPI_TypeDef *instance, uint16_t divisor);
+#ifdef USE_OVERCLOCK
+uint16_t spiOverclockDivisor(SPI_TypeDef *instance, uint16_t divisor);
+#endif
 uint8_t spiTransferByte(SPI_TypeDef *instance, uint8_t data);
 bool spiIsBusBusy(SPI_TypeDef *instance);
 
@@ -114,10 +117,21 @@ SPI_TypeDef *spiInstanceByDevice(SPIDevice device);
 
 bool spiBusTransfer(const busDevice_t *bus, const uint8_t *txData, uint8_t *rxData, int length);
 
+#ifdef USE_SPI_BUS_CLAIM
+typedef void spiBusReleaseCallbackFn(uint32_t arg);
+
+bool spiBusClaim(SPI_TypeDef *instance);
+bool spiBusClaimWait(SPI_TypeDef *instance);
+bool spiBusClaimOrQueue(SPI_TypeDef *instance, spiBusReleaseCallbackFn *callback, uint32_t arg);
+void spiBusRelease(SPI_TypeDef *instance);
+#endif
+
 bool spiBusWriteRegister(const busDevice_t *bus, uint8_t reg, uint8_t data);
 bool spiBusReadRegisterBuffer(const busDevice_t *bus, uint8_t reg, uint8_t *data, uint8_t length);
 uint8_t spiBusReadRegister(const busDevice_t *bus, uint8_t reg);
 void spiBusSetInstance(busDevice_t *bus, SPI_TypeDef *instance);
+void spiBusSetDivisors(busDevice_t *bus, uint16_t readDivisor, uint16_t writeDivisor);
+void spiBusUseReadClock(const busDevice_t *bus);
 
 struct spiPinConfig_s;
 void spiPinConfigure(const struct spiPinConfig_s *pConfig);
@@ -65,6 +65,12 @@ typedef struct SPIDevice_s {
     rccPeriphTag_t rcc;
     volatile uint16_t errorCount;
     bool leadingEdge;
+    uint16_t divisor;   // last divisor set, 0 until the first spiSetDivisor()
+#ifdef USE_SPI_BUS_CLAIM
+    volatile bool claimed;
+    spiBusReleaseCallbackFn *releaseCallback;   // waiting transfer, started when the bus is released
+    uint32_t releaseCallbackArg;
+#endif
 #if defined(USE_HAL_DRIVER)
     SPI_HandleTypeDef hspi;
     DMA_HandleTypeDef hdma;
@@ -174,9 +174,17 @@ bool spiTransfer(SPI_TypeDef *instance, const uint8_t *txData, uint8_t *rxData,
 
 void spiSetDivisor(SPI_TypeDef *instance, uint16_t divisor)
 {
+    const SPIDevice device = spiDeviceByInstance(instance);
+    if (device != SPIINVALID) {
+        spiDevice[device].divisor = divisor;
+    }
+
 #define BR_BITS ((BIT(5) | BIT(4) | BIT(3)))
 
-#if !(defined(STM32F1) || defined(STM32F3))
+#ifdef USE_OVERCLOCK
+    // worked out from the running bus clocks, SPI2 and SPI3 included
+    divisor = spiOverclockDivisor(instance, divisor);
+#elif !(defined(STM32F1) || defined(STM32F3))
     // SPI2 and SPI3 are on APB1/AHB1 which PCLK is half that of APB2/AHB2.
 
     if (instance == SPI2 || instance == SPI3) {
@@ -201,23 +201,34 @@ static void hmc5883SpiInit(busDevice_t *busdev)
 }
 #endif
 
+// The data is read without blocking, each call decodes the read started by the previous one and starts the next
+static uint8_t hmc5883lBuf[6];
+static busTransfer_t hmc5883lTransfer;
+static bool hmc5883lReadPending = false;
+
 static bool hmc5883lRead(magDev_t *mag, int16_t *magData)
 {
-    uint8_t buf[6];
-
     busDevice_t *busdev = &mag->busdev;
-
-    bool ack = busReadRegisterBuffer(busdev, HMC58X3_REG_DATA, buf, 6);
-
-    if (!ack) {
-        return false;
+    const uint8_t *buf = hmc5883lBuf;
+    bool ack = false;
+    bool error;
+
+    if (hmc5883lReadPending) {
+        if (!busTransferDone(busdev, &hmc5883lTransfer, &error)) {
+            return false;
+        }
+
+        ack = !error;
+        if (ack) {
+            magData[X] = (int16_t)(buf[0] << 8 | buf[1]);
+            magData[Z] = (int16_t)(buf[2] << 8 | buf[3]);
+            magData[Y] = (int16_t)(buf[4] << 8 | buf[5]);
+        }
     }
 
-    magData[X] = (int16_t)(buf[0] << 8 | buf[1]);
-    magData[Z] = (int16_t)(buf[2] << 8 | buf[3]);
-    magData[Y] = (int16_t)(buf[4] << 8 | buf[5]);
+    hmc5883lReadPending = busReadRegisterBufferStart(busdev, HMC58X3_REG_DATA, hmc5883lBuf, 6, &hmc5883lTransfer);
 
-    return true;
+    return ack;
 }
 
 static bool hmc5883lInit(magDev_t *mag)
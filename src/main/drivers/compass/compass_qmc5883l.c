@@ -89,34 +89,43 @@ static bool qmc5883lInit(magDev_t *magDev)
     return true;
 }
 
-static bool qmc5883lRead(magDev_t *magDev, int16_t *magData)
-{
-    uint8_t status;
-    uint8_t buf[6];
+// The data registers are followed by the status register, so one transfer reads both. It is read without
+// blocking, each call decodes the read started by the previous one and starts the next.
+#define QMC5883L_READ_LENGTH (QMC5883L_REG_STATUS - QMC5883L_REG_DATA_OUTPUT_X + 1)
 
-    // set magData to zero for case of failed read
-    magData[X] = 0;
-    magData[Y] = 0;
-    magData[Z] = 0;
+static uint8_t qmc5883lBuf[QMC5883L_READ_LENGTH];
+static busTransfer_t qmc5883lTransfer;
+static bool qmc5883lReadPending = false;
 
+static bool qmc5883lRead(magDev_t *magDev, int16_t *magData)
+{
     busDevice_t *busdev = &magDev->busdev;
+    const uint8_t *buf = qmc5883lBuf;
+    bool ack = false;
+    bool error;
 
-    bool ack = busReadRegisterBuffer(busdev, QMC5883L_REG_STATUS, &status, 1);
-
-    if (!ack || (status & 0x04) == 0) {
-        return false;
-    }
+    if (qmc5883lReadPending) {
+        if (!busTransferDone(busdev, &qmc5883lTransfer, &error)) {
+            return false;
+        }
 
-    ack = busReadRegisterBuffer(busdev, QMC5883L_REG_DATA_OUTPUT_X, buf, 6);
-    if (!ack) {
-        return false;
+        const uint8_t status = buf[QMC5883L_REG_STATUS - QMC5883L_REG_DATA_OUTPUT_X];
+        ack = !error && (status & 0x04) != 0;
+        if (ack) {
+            magData[X] = (int16_t)(buf[1] << 8 | buf[0]);
+            magData[Y] = (int16_t)(buf[3] << 8 | buf[2]);
+            magData[Z] = (int16_t)(buf[5] << 8 | buf[4]);
+        } else {
+            // set magData to zero for case of failed read
+            magData[X] = 0;
+            magData[Y] = 0;
+            magData[Z] = 0;
+        }
     }
 
-    magData[X] = (int16_t)(buf[1] << 8 | buf[0]);
-    magData[Y] = (int16_t)(buf[3] << 8 | buf[2]);
-    magData[Z] = (int16_t)(buf[5] << 8 | buf[4]);
+    qmc5883lReadPending = busReadRegisterBufferStart(busdev, QMC5883L_REG_DATA_OUTPUT_X, qmc5883lBuf, QMC5883L_READ_LENGTH, &qmc5883lTransfer);
 
-    return true;
+    return ack;
 }
 
 bool qmc5883lDetect(magDev_t *magDev)
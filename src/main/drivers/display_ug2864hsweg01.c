@@ -20,6 +20,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "platform.h"
 
@@ -189,9 +190,31 @@ static bool i2c_OLED_send_cmdarray(busDevice_t *bus, const uint8_t *commands, si
     return true;
 }
 
-static bool i2c_OLED_send_byte(busDevice_t *bus, uint8_t val)
+// Display data is sent with non-blocking transfers, alternating between two buffers so that
+// the next one is filled while the previous one is still on the bus.
+#define OLED_DATA_BUFFER_SIZE SCREEN_WIDTH
+
+static uint8_t oledDataBuffer[2][OLED_DATA_BUFFER_SIZE];
+static uint8_t oledDataBufferIndex = 0;
+
+static uint8_t *i2c_OLED_data_buffer(void)
+{
+    return oledDataBuffer[oledDataBufferIndex];
+}
+
+static bool i2c_OLED_send_data(busDevice_t *bus, uint8_t *data, uint8_t len)
 {
-    return i2cWrite(bus->busdev_u.i2c.device, bus->busdev_u.i2c.address, 0x40, val);
+    oledDataBufferIndex ^= 1;
+    return i2cWriteBufferStart(bus->busdev_u.i2c.device, bus->busdev_u.i2c.address, 0x40, len, data, NULL);
+}
+
+static uint8_t *i2c_OLED_render_char(uint8_t *dst, unsigned char ascii)
+{
+    for (int i = 0; i < FONT_WIDTH; i++) {
+        *dst++ = multiWiiFont[ascii - 32][i] ^ CHAR_FORMAT;  // apply
+    }
+    *dst++ = CHAR_FORMAT;    // the gap
+    return dst;
 }
 
 void i2c_OLED_clear_display_quick(busDevice_t *bus)
@@ -205,8 +228,10 @@ void i2c_OLED_clear_display_quick(busDevice_t *bus)
 
     i2c_OLED_send_cmdarray(bus, i2c_OLED_cmd_clear_display_quick, ARRAYLEN(i2c_OLED_cmd_clear_display_quick));
 
-    for (uint16_t i = 0; i < 1024; i++) {      // fill the display's RAM with graphic... 128*64 pixel picture
-        i2c_OLED_send_byte(bus, 0x00);  // clear
+    for (uint16_t i = 0; i < 1024; i += OLED_DATA_BUFFER_SIZE) {      // fill the display's RAM with graphic... 128*64 pixel picture
+        uint8_t *buffer = i2c_OLED_data_buffer();
+        memset(buffer, 0x00, OLED_DATA_BUFFER_SIZE);  // clear
+        i2c_OLED_send_data(bus, buffer, OLED_DATA_BUFFER_SIZE);
     }
 }
 
@@ -250,22 +275,22 @@ void i2c_OLED_set_line(busDevice_t *bus, uint8_t row)
 
 void i2c_OLED_send_char(busDevice_t *bus, unsigned char ascii)
 {
-    unsigned char i;
-    uint8_t buffer;
-    for (i = 0; i < 5; i++) {
-        buffer = multiWiiFont[ascii - 32][i];
-        buffer ^= CHAR_FORMAT;  // apply
-        i2c_OLED_send_byte(bus, buffer);
-    }
-    i2c_OLED_send_byte(bus, CHAR_FORMAT);    // the gap
+    uint8_t *buffer = i2c_OLED_data_buffer();
+    const uint8_t *end = i2c_OLED_render_char(buffer, ascii);
+    i2c_OLED_send_data(bus, buffer, end - buffer);
 }
 
 void i2c_OLED_send_string(busDevice_t *bus, const char *string)
 {
-    // Sends a string of chars until null terminator
+    // Sends a string of chars until null terminator, a screen line per transfer
     while (*string) {
-        i2c_OLED_send_char(bus, *string);
-        string++;
+        uint8_t *buffer = i2c_OLED_data_buffer();
+        uint8_t *end = buffer;
+        while (*string && end - buffer <= OLED_DATA_BUFFER_SIZE - CHARACTER_WIDTH_TOTAL) {
+            end = i2c_OLED_render_char(end, *string);
+            string++;
+        }
+        i2c_OLED_send_data(bus, buffer, end - buffer);
     }
 }
 
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "resource.h"
+#include "drivers/stack_check.h"
 
 struct dmaChannelDescriptor_s;
 typedef void (*dmaCallbackHandlerFuncPtr)(struct dmaChannelDescriptor_s *channelDescriptor);
@@ -40,6 +41,8 @@ typedef struct dmaChannelDescriptor_s {
     resourceOwner_e             owner;
     uint8_t                     resourceIndex;
     uint32_t                    completeFlag;
+    resourceOwner_e             conflictOwner;      // previous owner of a stream claimed twice
+    uint8_t                     conflictResourceIndex;
 } dmaChannelDescriptor_t;
 
 #if defined(STM32F7)
@@ -93,6 +96,7 @@ typedef enum {
 
 #define DEFINE_DMA_IRQ_HANDLER(d, s, i) void DMA ## d ## _Stream ## s ## _IRQHandler(void) {\
                                                                 const uint8_t index = DMA_IDENTIFIER_TO_INDEX(i); \
+                                                                STACK_CHECK_ISR(STACK_ISR_DMA); \
                                                                 if (dmaDescriptors[index].irqHandlerCallback)\
                                                                     dmaDescriptors[index].irqHandlerCallback(&dmaDescriptors[index]);\
                                                             }
@@ -154,6 +158,7 @@ typedef enum {
 
 #define DEFINE_DMA_IRQ_HANDLER(d, c, i) void DMA ## d ## _Channel ## c ## _IRQHandler(void) {\
                                                                         const uint8_t index = DMA_IDENTIFIER_TO_INDEX(i); \
+                                                                        STACK_CHECK_ISR(STACK_ISR_DMA); \
                                                                         if (dmaDescriptors[index].irqHandlerCallback)\
                                                                             dmaDescriptors[index].irqHandlerCallback(&dmaDescriptors[index]);\
                                                                     }
@@ -175,4 +180,6 @@ void dmaSetHandler(dmaIdentifier_e identifier, dmaCallbackHandlerFuncPtr callbac
 
 resourceOwner_e dmaGetOwner(dmaIdentifier_e identifier);
 uint8_t dmaGetResourceIndex(dmaIdentifier_e identifier);
+resourceOwner_e dmaGetConflictOwner(dmaIdentifier_e identifier);
+uint8_t dmaGetConflictResourceIndex(dmaIdentifier_e identifier);
 dmaChannelDescriptor_t* dmaGetDescriptorByIdentifier(const dmaIdentifier_e identifier);
@@ -0,0 +1,163 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#ifdef USE_DMA_SPEC
+
+#include "drivers/adc.h"
+#include "drivers/bus_spi.h"
+#include "drivers/dma.h"
+#include "drivers/dma_reqmap.h"
+#include "drivers/serial.h"
+#include "drivers/serial_uart.h"
+#include "drivers/timer.h"
+
+typedef struct dmaPeripheralMapping_s {
+    dmaPeripheral_e device;
+    uint8_t index;
+    dmaChannelSpec_t channelSpec[MAX_PERIPHERAL_DMA_OPTIONS];
+} dmaPeripheralMapping_t;
+
+#define DMA(d, s, c) { DMA ## d ## _Stream ## s, DMA_Channel_ ## c }
+
+// the stream and channel options of each DMA request, from the request mapping tables in the reference manual
+static const dmaPeripheralMapping_t dmaPeripheralMapping[] = {
+    { DMA_PERIPH_SPI_TX,  SPIDEV_1,  { DMA(2, 3, 3), DMA(2, 5, 3) } },
+    { DMA_PERIPH_SPI_RX,  SPIDEV_1,  { DMA(2, 0, 3), DMA(2, 2, 3) } },
+    { DMA_PERIPH_SPI_TX,  SPIDEV_2,  { DMA(1, 4, 0) } },
+    { DMA_PERIPH_SPI_RX,  SPIDEV_2,  { DMA(1, 3, 0) } },
+    { DMA_PERIPH_SPI_TX,  SPIDEV_3,  { DMA(1, 5, 0), DMA(1, 7, 0) } },
+    { DMA_PERIPH_SPI_RX,  SPIDEV_3,  { DMA(1, 0, 0), DMA(1, 2, 0) } },
+#if defined(STM32F411xE) || defined(STM32F446xx)
+    { DMA_PERIPH_SPI_TX,  SPIDEV_4,  { DMA(2, 1, 4), DMA(2, 4, 5) } },
+    { DMA_PERIPH_SPI_RX,  SPIDEV_4,  { DMA(2, 0, 4), DMA(2, 3, 5) } },
+#endif
+
+    { DMA_PERIPH_ADC,     ADCDEV_1,  { DMA(2, 0, 0), DMA(2, 4, 0) } },
+    { DMA_PERIPH_ADC,     ADCDEV_2,  { DMA(2, 2, 1), DMA(2, 3, 1) } },
+    { DMA_PERIPH_ADC,     ADCDEV_3,  { DMA(2, 0, 2), DMA(2, 1, 2) } },
+
+    { DMA_PERIPH_UART_TX, UARTDEV_1, { DMA(2, 7, 4) } },
+    { DMA_PERIPH_UART_RX, UARTDEV_1, { DMA(2, 5, 4), DMA(2, 2, 4) } },
+    { DMA_PERIPH_UART_TX, UARTDEV_2, { DMA(1, 6, 4) } },
+    { DMA_PERIPH_UART_RX, UARTDEV_2, { DMA(1, 5, 4) } },
+    { DMA_PERIPH_UART_TX, UARTDEV_3, { DMA(1, 3, 4), DMA(1, 4, 7) } },
+    { DMA_PERIPH_UART_RX, UARTDEV_3, { DMA(1, 1, 4) } },
+    { DMA_PERIPH_UART_TX, UARTDEV_4, { DMA(1, 4, 4) } },
+    { DMA_PERIPH_UART_RX, UARTDEV_4, { DMA(1, 2, 4) } },
+    { DMA_PERIPH_UART_TX, UARTDEV_5, { DMA(1, 7, 4) } },
+    { DMA_PERIPH_UART_RX, UARTDEV_5, { DMA(1, 0, 4) } },
+    { DMA_PERIPH_UART_TX, UARTDEV_6, { DMA(2, 6, 5), DMA(2, 7, 5) } },
+    { DMA_PERIPH_UART_RX, UARTDEV_6, { DMA(2, 1, 5), DMA(2, 2, 5) } },
+};
+
+#define DMA_ALLOCATION_FAILURE_COUNT 8
+
+static dmaAllocationFailure_t dmaAllocationFailures[DMA_ALLOCATION_FAILURE_COUNT];
+static unsigned dmaAllocationFailureCount;
+
+const dmaChannelSpec_t *dmaGetChannelSpec(dmaPeripheral_e device, uint8_t index, uint8_t opt)
+{
+    if (opt >= MAX_PERIPHERAL_DMA_OPTIONS) {
+        return NULL;
+    }
+    for (unsigned i = 0; i < ARRAYLEN(dmaPeripheralMapping); i++) {
+        const dmaPeripheralMapping_t *mapping = &dmaPeripheralMapping[i];
+        if (mapping->device == device && mapping->index == index) {
+            return mapping->channelSpec[opt].ref ? &mapping->channelSpec[opt] : NULL;
+        }
+    }
+    return NULL;
+}
+
+// the timer channels have a single fixed stream each, so the other peripherals keep out of their way
+static bool dmaStreamUsedByTimer(const DMA_Stream_TypeDef *stream)
+{
+#if defined(USE_DSHOT) || defined(USE_LED_STRIP) || defined(USE_TRANSPONDER)
+    for (unsigned i = 0; i < USABLE_TIMER_CHANNEL_COUNT; i++) {
+        if (timerHardware[i].dmaRef == stream || timerHardware[i].dmaTimUPRef == stream) {
+            return true;
+        }
+    }
+#else
+    UNUSED(stream);
+#endif
+    return false;
+}
+
+static bool dmaStreamAvailable(const DMA_Stream_TypeDef *stream, resourceOwner_e owner, uint8_t resourceIndex)
+{
+    const dmaIdentifier_e identifier = dmaGetIdentifier(stream);
+    const resourceOwner_e currentOwner = dmaGetOwner(identifier);
+    return currentOwner == OWNER_FREE || (currentOwner == owner && dmaGetResourceIndex(identifier) == resourceIndex);
+}
+
+// a peripheral may ask again when it is reinitialised, it is listed once
+static void dmaAllocationFailed(resourceOwner_e owner, uint8_t resourceIndex)
+{
+    for (unsigned i = 0; i < dmaAllocationFailureCount; i++) {
+        if (dmaAllocationFailures[i].owner == owner && dmaAllocationFailures[i].resourceIndex == resourceIndex) {
+            return;
+        }
+    }
+    if (dmaAllocationFailureCount < DMA_ALLOCATION_FAILURE_COUNT) {
+        dmaAllocationFailures[dmaAllocationFailureCount].owner = owner;
+        dmaAllocationFailures[dmaAllocationFailureCount].resourceIndex = resourceIndex;
+        dmaAllocationFailureCount++;
+    }
+}
+
+/*
+ * Claims a stream for a DMA request of a peripheral. The stream the target selected comes first, then
+ * the free streams that no timer channel of the target uses. A stream named in the timer table is never
+ * taken otherwise, even while still free: DShot, LED strip and transponder claim theirs later with
+ * dmaInit() and would take it over without an error. Returns NULL if no stream is left, the peripheral
+ * has to do without DMA then.
+ */
+const dmaChannelSpec_t *dmaAllocate(dmaPeripheral_e device, uint8_t index, const DMA_Stream_TypeDef *preferred, resourceOwner_e owner, uint8_t resourceIndex)
+{
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint8_t opt = 0; opt < MAX_PERIPHERAL_DMA_OPTIONS; opt++) {
+            const dmaChannelSpec_t *spec = dmaGetChannelSpec(device, index, opt);
+            if (!spec || (pass == 0 && spec->ref != preferred) || (pass == 1 && dmaStreamUsedByTimer(spec->ref))) {
+                continue;
+            }
+            if (dmaStreamAvailable(spec->ref, owner, resourceIndex)) {
+                dmaInit(dmaGetIdentifier(spec->ref), owner, resourceIndex);
+                return spec;
+            }
+        }
+    }
+
+    dmaAllocationFailed(owner, resourceIndex);
+    return NULL;
+}
+
+// the requests that found no free stream, NULL past the last one
+const dmaAllocationFailure_t *dmaGetAllocationFailure(unsigned failureIndex)
+{
+    return failureIndex < dmaAllocationFailureCount ? &dmaAllocationFailures[failureIndex] : NULL;
+}
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "platform.h"
+
+#include "drivers/dma.h"
+#include "drivers/resource.h"
+
+#ifdef USE_DMA_SPEC
+
+typedef enum {
+    DMA_PERIPH_SPI_TX,
+    DMA_PERIPH_SPI_RX,
+    DMA_PERIPH_ADC,
+    DMA_PERIPH_UART_TX,
+    DMA_PERIPH_UART_RX,
+} dmaPeripheral_e;
+
+typedef struct dmaChannelSpec_s {
+    DMA_Stream_TypeDef *ref;
+    uint32_t channel;
+} dmaChannelSpec_t;
+
+#define MAX_PERIPHERAL_DMA_OPTIONS 2
+
+typedef struct dmaAllocationFailure_s {
+    resourceOwner_e owner;
+    uint8_t resourceIndex;
+} dmaAllocationFailure_t;
+
+const dmaChannelSpec_t *dmaGetChannelSpec(dmaPeripheral_e device, uint8_t index, uint8_t opt);
+const dmaChannelSpec_t *dmaAllocate(dmaPeripheral_e device, uint8_t index, const DMA_Stream_TypeDef *preferred, resourceOwner_e owner, uint8_t resourceIndex);
+const dmaAllocationFailure_t *dmaGetAllocationFailure(unsigned failureIndex);
+
+#endif
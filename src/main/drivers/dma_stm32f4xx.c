@@ -76,8 +76,14 @@ void dmaInit(dmaIdentifier_e identifier, resourceOwner_e owner, uint8_t resource
 {
     const int index = DMA_IDENTIFIER_TO_INDEX(identifier);
     RCC_AHB1PeriphClockCmd(DMA_RCC(dmaDescriptors[index].dma), ENABLE);
-    dmaDescriptors[index].owner = owner;
-    dmaDescriptors[index].resourceIndex = resourceIndex;
+    dmaChannelDescriptor_t *descriptor = &dmaDescriptors[index];
+    if (owner != OWNER_FREE && descriptor->owner != OWNER_FREE && (descriptor->owner != owner || descriptor->resourceIndex != resourceIndex)) {
+        // the new owner takes the stream over, the previous one is kept to be reported
+        descriptor->conflictOwner = descriptor->owner;
+        descriptor->conflictResourceIndex = descriptor->resourceIndex;
+    }
+    descriptor->owner = owner;
+    descriptor->resourceIndex = resourceIndex;
 }
 
 #define RETURN_TCIF_FLAG(s, n) if (s == DMA1_Stream ## n || s == DMA2_Stream ## n) return DMA_IT_TCIF ## n
@@ -123,6 +129,16 @@ uint8_t dmaGetResourceIndex(dmaIdentifier_e identifier)
     return dmaDescriptors[DMA_IDENTIFIER_TO_INDEX(identifier)].resourceIndex;
 }
 
+resourceOwner_e dmaGetConflictOwner(dmaIdentifier_e identifier)
+{
+    return dmaDescriptors[DMA_IDENTIFIER_TO_INDEX(identifier)].conflictOwner;
+}
+
+uint8_t dmaGetConflictResourceIndex(dmaIdentifier_e identifier)
+{
+    return dmaDescriptors[DMA_IDENTIFIER_TO_INDEX(identifier)].conflictResourceIndex;
+}
+
 dmaIdentifier_e dmaGetIdentifier(const DMA_Stream_TypeDef* stream)
 {
     for (int i = 0; i < DMA_LAST_HANDLER; i++) {
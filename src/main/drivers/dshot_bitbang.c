@@ -0,0 +1,346 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * DShot without a timer channel per motor: the packets of all motors on a GPIO port are
+ * interleaved into one buffer of BSRR words, which a single DMA stream writes to the port,
+ * paced by a compare channel of one timer. Every bit takes three phases, all lines go
+ * active, the lines sending a zero go idle, then all lines go idle.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "platform.h"
+
+#ifdef USE_DSHOT_BITBANG
+
+#include "build/motor_timing.h"
+
+#include "common/utils.h"
+
+#include "drivers/dma.h"
+#include "drivers/dshot_bitbang.h"
+#include "drivers/io.h"
+#include "drivers/io_impl.h"
+#include "drivers/nvic.h"
+#include "drivers/rcc.h"
+#include "drivers/timer.h"
+
+#define DSHOT_BITBANG_PHASES        3
+#define DSHOT_BITBANG_BUFFER_SIZE   (16 * DSHOT_BITBANG_PHASES)
+#define DSHOT_BITBANG_MAX_PORTS     4   // one per compare channel of the pacer timer
+
+typedef struct bbPacerChannel_s {
+    uint16_t channel;
+    DMA_Stream_TypeDef *dmaStream;
+    uint32_t dmaChannel;
+} bbPacerChannel_t;
+
+typedef struct bbPacer_s {
+    TIM_TypeDef *tim;
+    bbPacerChannel_t channels[DSHOT_BITBANG_MAX_PORTS];
+} bbPacer_t;
+
+// the GPIOs are only reachable from DMA2, so the pacer must be an APB2 timer
+static const bbPacer_t bbPacers[] = {
+#ifdef TIM8
+    { TIM8, {
+        { TIM_Channel_1, DMA2_Stream2, DMA_Channel_7 },
+        { TIM_Channel_2, DMA2_Stream3, DMA_Channel_7 },
+        { TIM_Channel_3, DMA2_Stream4, DMA_Channel_7 },
+        { TIM_Channel_4, DMA2_Stream7, DMA_Channel_7 },
+    } },
+#endif
+    { TIM1, {
+        { TIM_Channel_1, DMA2_Stream1, DMA_Channel_6 },
+        { TIM_Channel_2, DMA2_Stream2, DMA_Channel_6 },
+        { TIM_Channel_3, DMA2_Stream6, DMA_Channel_6 },
+        { TIM_Channel_4, DMA2_Stream4, DMA_Channel_6 },
+    } },
+};
+
+typedef struct bbPort_s {
+    GPIO_TypeDef *gpio;
+    const bbPacerChannel_t *pacerChannel;
+    uint16_t timerDmaSource;
+    uint32_t buffer[DSHOT_BITBANG_BUFFER_SIZE];
+} bbPort_t;
+
+typedef struct bbMotor_s {
+    bbPort_t *port;
+    uint32_t dataMask;      // BSRR bits that end the pulse of a zero early
+} bbMotor_t;
+
+FAST_RAM_ZERO_INIT bool useDshotBitbang = false;
+
+static const bbPacer_t *bbPacer;
+static uint16_t bbTimerDmaSources;
+static uint8_t bbPortCount;
+static bbPort_t bbPorts[DSHOT_BITBANG_MAX_PORTS];
+static bbMotor_t bbMotors[MAX_SUPPORTED_MOTORS];
+
+static bool bbPacerChannelIsFree(const bbPacerChannel_t *pacerChannel)
+{
+    return dmaGetOwner(dmaGetIdentifier(pacerChannel->dmaStream)) == OWNER_FREE;
+}
+
+static bool bbPacerUsedByMotors(const bbPacer_t *pacer, const motorDevConfig_t *motorConfig, uint8_t motorCount)
+{
+    for (int i = 0; i < motorCount; i++) {
+        const timerHardware_t *timerHardware = timerGetByTag(motorConfig->ioTags[i]);
+        if (timerHardware && timerHardware->tim == pacer->tim) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool bbIsMotorPin(ioTag_t tag, const motorDevConfig_t *motorConfig, uint8_t motorCount)
+{
+    for (int i = 0; i < motorCount; i++) {
+        if (motorConfig->ioTags[i] == tag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The pacer takes over the time base of the whole timer, so it must not carry
+// anything but motors and unused pins, such as PWM or PPM inputs, servos or the LED strip
+static bool bbPacerSharesTimer(const bbPacer_t *pacer, const motorDevConfig_t *motorConfig, uint8_t motorCount)
+{
+    for (int i = 0; i < USABLE_TIMER_CHANNEL_COUNT; i++) {
+        const timerHardware_t *timerHardware = &timerHardware[i];
+        if (timerHardware->tim == pacer->tim && (timerHardware->usageFlags & ~TIM_USE_MOTOR)
+            && !bbIsMotorPin(timerHardware->tag, motorConfig, motorCount)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A timer that drives motor pins is free once those are bitbanged, so those are tried first
+static const bbPacer_t *bbFindPacer(const motorDevConfig_t *motorConfig, uint8_t motorCount, uint8_t portCount)
+{
+    for (int pass = 0; pass < 2; pass++) {
+        for (unsigned i = 0; i < ARRAYLEN(bbPacers); i++) {
+            const bbPacer_t *pacer = &bbPacers[i];
+            if (bbPacerUsedByMotors(pacer, motorConfig, motorCount) != (pass == 0)
+                || bbPacerSharesTimer(pacer, motorConfig, motorCount)) {
+                continue;
+            }
+            int freeChannels = 0;
+            for (int j = 0; j < DSHOT_BITBANG_MAX_PORTS; j++) {
+                if (bbPacerChannelIsFree(&pacer->channels[j])) {
+                    freeChannels++;
+                }
+            }
+            if (freeChannels >= portCount) {
+                return pacer;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void bbDmaIrqHandler(dmaChannelDescriptor_t *descriptor)
+{
+    if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TCIF)) {
+        const bbPort_t *port = &bbPorts[descriptor->userParam];
+        TIM_DMACmd(bbPacer->tim, port->timerDmaSource, DISABLE);
+        DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
+#ifdef USE_MOTOR_TIMING
+        motorTimingOutputComplete();
+#endif
+    }
+}
+
+static void bbPortInit(bbPort_t *port, uint8_t portIndex)
+{
+    DMA_Stream_TypeDef *dmaStream = port->pacerChannel->dmaStream;
+    const dmaIdentifier_e dmaIdentifier = dmaGetIdentifier(dmaStream);
+
+    dmaInit(dmaIdentifier, OWNER_MOTOR, RESOURCE_INDEX(portIndex));
+    dmaSetHandler(dmaIdentifier, bbDmaIrqHandler, NVIC_BUILD_PRIORITY(1, 2), portIndex);
+
+    DMA_InitTypeDef DMA_InitStructure;
+    DMA_Cmd(dmaStream, DISABLE);
+    DMA_DeInit(dmaStream);
+    DMA_StructInit(&DMA_InitStructure);
+    DMA_InitStructure.DMA_Channel = port->pacerChannel->dmaChannel;
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&port->gpio->BSRRL;
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)port->buffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+    DMA_InitStructure.DMA_BufferSize = DSHOT_BITBANG_BUFFER_SIZE;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+    // direct mode, so every request writes the port straight away
+    DMA_InitStructure.DMA_FIFOMode = DMA_FIFOMode_Disable;
+    DMA_InitStructure.DMA_MemoryBurst = DMA_MemoryBurst_Single;
+    DMA_InitStructure.DMA_PeripheralBurst = DMA_PeripheralBurst_Single;
+    DMA_Init(dmaStream, &DMA_InitStructure);
+    DMA_ITConfig(dmaStream, DMA_IT_TC, ENABLE);
+
+    port->timerDmaSource = timerDmaSource(port->pacerChannel->channel);
+    bbTimerDmaSources |= port->timerDmaSource;
+
+    TIM_OCInitTypeDef TIM_OCInitStructure;
+    TIM_OCStructInit(&TIM_OCInitStructure);
+    TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_Timing;
+    TIM_OCInitStructure.TIM_Pulse = 1;
+    timerOCInit(bbPacer->tim, port->pacerChannel->channel, &TIM_OCInitStructure);
+}
+
+static void bbPacerInit(motorPwmProtocolTypes_e pwmProtocolType)
+{
+    TIM_TypeDef *tim = bbPacer->tim;
+    const uint32_t bitRate = getDshotHz(pwmProtocolType) / (MOTOR_BITLENGTH + 1);
+
+    RCC_ClockCmd(timerRCC(tim), ENABLE);
+    TIM_Cmd(tim, DISABLE);
+
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+    TIM_TimeBaseStructInit(&TIM_TimeBaseStructure);
+    TIM_TimeBaseStructure.TIM_Prescaler = 0;
+    TIM_TimeBaseStructure.TIM_Period = lrintf((float)timerClock(tim) / (bitRate * DSHOT_BITBANG_PHASES)) - 1;
+    TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseInit(tim, &TIM_TimeBaseStructure);
+}
+
+bool dshotBitbangInit(const motorDevConfig_t *motorConfig, uint8_t motorCount)
+{
+    GPIO_TypeDef *gpios[DSHOT_BITBANG_MAX_PORTS];
+    uint8_t portCount = 0;
+
+    for (int i = 0; i < motorCount; i++) {
+        const IO_t io = IOGetByTag(motorConfig->ioTags[i]);
+        if (!io) {
+            return false;
+        }
+        GPIO_TypeDef *gpio = IO_GPIO(io);
+        int portIndex = 0;
+        while (portIndex < portCount && gpios[portIndex] != gpio) {
+            portIndex++;
+        }
+        if (portIndex == portCount) {
+            if (portCount == DSHOT_BITBANG_MAX_PORTS) {
+                return false;
+            }
+            gpios[portCount++] = gpio;
+        }
+    }
+
+    bbPacer = bbFindPacer(motorConfig, motorCount, portCount);
+    if (!bbPacer) {
+        return false;
+    }
+
+    bbPacerInit(motorConfig->motorPwmProtocol);
+
+    const bbPacerChannel_t *pacerChannel = bbPacer->channels;
+    for (int portIndex = 0; portIndex < portCount; portIndex++) {
+        while (!bbPacerChannelIsFree(pacerChannel)) {
+            pacerChannel++;
+        }
+        bbPort_t *port = &bbPorts[portIndex];
+        port->gpio = gpios[portIndex];
+        port->pacerChannel = pacerChannel++;
+        bbPortInit(port, portIndex);
+    }
+    bbPortCount = portCount;
+
+    for (int i = 0; i < motorCount; i++) {
+        const IO_t io = IOGetByTag(motorConfig->ioTags[i]);
+        const timerHardware_t *timerHardware = timerGetByTag(motorConfig->ioTags[i]);
+        const bool inverted = motorConfig->motorPwmInversion ^ (timerHardware && (timerHardware->output & TIMER_OUTPUT_INVERTED));
+        const uint32_t pin = IO_Pin(io);
+
+        bbMotor_t *motor = &bbMotors[i];
+        int portIndex = 0;
+        while (bbPorts[portIndex].gpio != IO_GPIO(io)) {
+            portIndex++;
+        }
+        motor->port = &bbPorts[portIndex];
+
+        // the line goes active at the start of a bit, idle after the first phase for a zero and after the second for a one
+        const uint32_t activeMask = inverted ? pin << 16 : pin;
+        const uint32_t idleMask = inverted ? pin : pin << 16;
+        motor->dataMask = idleMask;
+        for (int bit = 0; bit < 16; bit++) {
+            motor->port->buffer[bit * DSHOT_BITBANG_PHASES] |= activeMask;
+            motor->port->buffer[bit * DSHOT_BITBANG_PHASES + 2] |= idleMask;
+        }
+
+        IOInit(io, OWNER_MOTOR, RESOURCE_INDEX(i));
+        if (inverted) {
+            IOHi(io);
+        } else {
+            IOLo(io);
+        }
+        IOConfigGPIO(io, IO_CONFIG(GPIO_Mode_OUT, GPIO_Speed_50MHz, GPIO_OType_PP, inverted ? GPIO_PuPd_UP : GPIO_PuPd_DOWN));
+    }
+
+    TIM_Cmd(bbPacer->tim, ENABLE);
+
+    useDshotBitbang = true;
+
+    return true;
+}
+
+FAST_CODE void dshotBitbangLoadPacket(uint8_t motorIndex, uint16_t packet)
+{
+    const bbMotor_t *motor = &bbMotors[motorIndex];
+    uint32_t *buffer = &motor->port->buffer[1];
+
+    for (int i = 0; i < 16; i++) {
+        if (packet & 0x8000) {  // MSB first
+            buffer[i * DSHOT_BITBANG_PHASES] &= ~motor->dataMask;
+        } else {
+            buffer[i * DSHOT_BITBANG_PHASES] |= motor->dataMask;
+        }
+        packet <<= 1;
+    }
+}
+
+FAST_CODE void dshotBitbangUpdateStart(void)
+{
+#ifdef USE_MOTOR_TIMING
+    // one transfer complete per port
+    motorTimingOutputStart(bbPortCount);
+#endif
+
+    for (int i = 0; i < bbPortCount; i++) {
+        DMA_Stream_TypeDef *dmaStream = bbPorts[i].pacerChannel->dmaStream;
+        DMA_SetCurrDataCounter(dmaStream, DSHOT_BITBANG_BUFFER_SIZE);
+        DMA_Cmd(dmaStream, ENABLE);
+    }
+
+    TIM_SetCounter(bbPacer->tim, 0);
+    TIM_DMACmd(bbPacer->tim, bbTimerDmaSources, ENABLE);
+}
+
+#endif
@@ -29,6 +29,7 @@
 #include "drivers/nvic.h"
 #include "io_impl.h"
 #include "drivers/exti.h"
+#include "drivers/stack_check.h"
 
 typedef struct {
     extiCallbackRec_t* handler;
@@ -208,6 +209,8 @@ void EXTI_IRQHandler(void)
 {
     uint32_t exti_active = EXTI->IMR & EXTI->PR;
 
+    STACK_CHECK_ISR(STACK_ISR_EXTI);
+
     while (exti_active) {
         unsigned idx = 31 - __builtin_clz(exti_active);
         uint32_t mask = 1 << idx;
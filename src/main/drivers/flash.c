@@ -89,6 +89,9 @@ bool flashInit(const flashConfig_t *flashConfig)
 
 #ifdef USE_FLASH_M25P16
     if (m25p16_detect(&flashDevice, chipID)) {
+#ifdef USE_FLASH_SPI_DMA
+        m25p16_spiDmaInit(&flashDevice);
+#endif
         return true;
     }
 #endif
@@ -109,6 +112,16 @@ bool flashIsReady(void)
     return flashDevice.vTable->isReady(&flashDevice);
 }
 
+// True if nothing at all is going on, isReady() may already accept the next page program before that
+bool flashIsIdle(void)
+{
+    if (flashDevice.vTable->isIdle) {
+        return flashDevice.vTable->isIdle(&flashDevice);
+    }
+
+    return flashDevice.vTable->isReady(&flashDevice);
+}
+
 bool flashWaitForReady(uint32_t timeoutMillis)
 {
     return flashDevice.vTable->waitForReady(&flashDevice, timeoutMillis);
@@ -151,7 +164,9 @@ int flashReadBytes(uint32_t address, uint8_t *buffer, int length)
 
 void flashFlush(void)
 {
-    flashDevice.vTable->flush(&flashDevice);
+    if (flashDevice.vTable->flush) {
+        flashDevice.vTable->flush(&flashDevice);
+    }
 }
 
 static const flashGeometry_t noFlashGeometry = {
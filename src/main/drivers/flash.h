@@ -48,6 +48,7 @@ typedef struct flashGeometry_s {
 bool flashInit(const flashConfig_t *flashConfig);
 
 bool flashIsReady(void);
+bool flashIsIdle(void);
 bool flashWaitForReady(uint32_t timeoutMillis);
 void flashEraseSector(uint32_t address);
 void flashEraseCompletely(void);
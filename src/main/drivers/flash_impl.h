@@ -42,6 +42,7 @@ typedef struct flashDevice_s {
 
 typedef struct flashVTable_s {
     bool (*isReady)(flashDevice_t *fdevice);
+    bool (*isIdle)(flashDevice_t *fdevice);
     bool (*waitForReady)(flashDevice_t *fdevice, uint32_t timeoutMillis);
     void (*eraseSector)(flashDevice_t *fdevice, uint32_t address);
     void (*eraseCompletely)(flashDevice_t *fdevice);
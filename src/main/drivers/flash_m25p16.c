@@ -20,6 +20,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "platform.h"
 
@@ -27,10 +28,16 @@
 
 #ifdef USE_FLASH_M25P16
 
+#include "common/maths.h"
+
 #include "drivers/bus_spi.h"
+#include "drivers/dma.h"
+#include "drivers/dma_reqmap.h"
 #include "drivers/flash.h"
 #include "drivers/flash_impl.h"
 #include "drivers/io.h"
+#include "drivers/nvic.h"
+#include "drivers/resource.h"
 #include "drivers/time.h"
 
 #include "pg/flash.h"
@@ -79,14 +86,32 @@ STATIC_ASSERT(M25P16_PAGESIZE < FLASH_MAX_PAGE_SIZE, M25P16_PAGESIZE_too_small);
 
 const flashVTable_t m25p16_vTable;
 
+#ifdef USE_SPI_BUS_CLAIM
+// transactions on the chip never overlap, so one flag covers every chip select
+static volatile bool m25p16BusClaimed = false;
+#endif
+
+#ifdef USE_FLASH_SPI_DMA
+static void m25p16_readAheadInvalidate(void);
+#endif
+
 static void m25p16_disable(busDevice_t *bus)
 {
     IOHi(bus->busdev_u.spi.csnPin);
     __NOP();
+#ifdef USE_SPI_BUS_CLAIM
+    if (m25p16BusClaimed) {
+        m25p16BusClaimed = false;
+        spiBusRelease(bus->busdev_u.spi.instance);
+    }
+#endif
 }
 
 static void m25p16_enable(busDevice_t *bus)
 {
+#ifdef USE_SPI_BUS_CLAIM
+    m25p16BusClaimed = spiBusClaimWait(bus->busdev_u.spi.instance);
+#endif
     __NOP();
     IOLo(bus->busdev_u.spi.csnPin);
 }
@@ -118,6 +143,11 @@ static void m25p16_writeEnable(flashDevice_t *fdevice)
 {
     m25p16_performOneByteCommand(fdevice->busdev, M25P16_INSTRUCTION_WRITE_ENABLE);
 
+#ifdef USE_FLASH_SPI_DMA
+    // whatever was read ahead may be about to change
+    m25p16_readAheadInvalidate();
+#endif
+
     // Assume that we're about to do some writing, so the device is just about to become busy
     fdevice->couldBeBusy = true;
 }
@@ -132,7 +162,7 @@ static uint8_t m25p16_readStatus(busDevice_t *bus)
     return in[1];
 }
 
-static bool m25p16_isReady(flashDevice_t *fdevice)
+static bool m25p16_isChipReady(flashDevice_t *fdevice)
 {
     // If couldBeBusy is false, don't bother to poll the flash chip for its status
     fdevice->couldBeBusy = fdevice->couldBeBusy && ((m25p16_readStatus(fdevice->busdev) & M25P16_STATUS_FLAG_WRITE_IN_PROGRESS) != 0);
@@ -140,10 +170,168 @@ static bool m25p16_isReady(flashDevice_t *fdevice)
     return !fdevice->couldBeBusy;
 }
 
+#ifdef USE_FLASH_SPI_DMA
+/*
+ * DMA page programs
+ *
+ * The data of a page program is copied into one of two buffers, behind the command and
+ * address bytes, and clocked out by DMA. While one page is sent and programmed the next is
+ * collected in the other buffer. It goes out on the first poll that finds the chip done, so
+ * pageProgramFinish() and isReady() never wait for the bus or the chip. The bus stays claimed
+ * until the transfer completes, so it can be shared with the gyro and other claiming drivers.
+ *
+ * The same streams read ahead: after each read the next chunk of the same length is fetched
+ * into the read-ahead buffer, so a sequential reader like a log download gets it from RAM
+ * while the chip is busy with the chunk after it.
+ */
+#define M25P16_DMA_HEADER_SIZE  5   // command and 4 byte address
+#define M25P16_READ_AHEAD_SIZE  1024
+
+typedef struct m25p16DmaBuffer_s {
+    uint8_t data[M25P16_DMA_HEADER_SIZE + M25P16_PAGESIZE];
+    uint16_t length;                // command, address and page data collected so far
+} m25p16DmaBuffer_t;
+
+typedef struct m25p16ReadAhead_s {
+    // the received command and address bytes land in front of the data
+    uint8_t data[M25P16_DMA_HEADER_SIZE + M25P16_READ_AHEAD_SIZE];
+    uint32_t address;
+    uint16_t length;                // 0 if nothing valid has been read ahead
+} m25p16ReadAhead_t;
+
+typedef struct m25p16Dma_s {
+    flashDevice_t *fdevice;
+    dmaChannelDescriptor_t *rxDescriptor;
+    dmaChannelDescriptor_t *txDescriptor;
+    m25p16DmaBuffer_t buffer[2];
+    volatile int8_t sendIndex;      // buffer the DMA is sending, -1 while the bus is idle
+    int8_t pendingIndex;            // finished page waiting for the chip, -1 if none
+    int8_t fillIndex;               // page between pageProgramBegin() and pageProgramFinish()
+    bool programming;               // the last thing started on the chip was a page program
+    volatile bool reading;          // the DMA is filling the read-ahead buffer
+    m25p16ReadAhead_t readAhead;
+} m25p16Dma_t;
+
+static m25p16Dma_t m25p16Dma = { .sendIndex = -1, .pendingIndex = -1, .fillIndex = -1 };
+// only ever written by the DMA
+static uint8_t m25p16DmaRxDummy;
+
+#define M25P16_DMA_FLAGS (DMA_IT_TCIF | DMA_IT_HTIF | DMA_IT_TEIF | DMA_IT_DMEIF | DMA_IT_FEIF)
+
+static bool m25p16_isDmaDevice(const flashDevice_t *fdevice)
+{
+    return fdevice == m25p16Dma.fdevice;
+}
+
+static void m25p16_dmaStart(flashDevice_t *fdevice, int index)
+{
+    const m25p16DmaBuffer_t *buffer = &m25p16Dma.buffer[index];
+    const uint8_t *txData = &buffer->data[fdevice->isLargeFlash ? 0 : 1];
+    const uint16_t length = buffer->length - (fdevice->isLargeFlash ? 0 : 1);
+
+    m25p16_writeEnable(fdevice);
+
+    DMA_Stream_TypeDef *rxStream = m25p16Dma.rxDescriptor->ref;
+    DMA_Stream_TypeDef *txStream = m25p16Dma.txDescriptor->ref;
+    DMA_CLEAR_FLAG(m25p16Dma.rxDescriptor, M25P16_DMA_FLAGS);
+    DMA_CLEAR_FLAG(m25p16Dma.txDescriptor, M25P16_DMA_FLAGS);
+    // a read ahead leaves the RX stream filling its buffer
+    rxStream->CR &= ~DMA_SxCR_MINC;
+    DMA_MemoryTargetConfig(rxStream, (uint32_t)&m25p16DmaRxDummy, DMA_Memory_0);
+    DMA_MemoryTargetConfig(txStream, (uint32_t)txData, DMA_Memory_0);
+    DMA_SetCurrDataCounter(rxStream, length);
+    DMA_SetCurrDataCounter(txStream, length);
+
+    m25p16Dma.sendIndex = index;
+    m25p16Dma.programming = true;
+
+    m25p16_enable(fdevice->busdev);
+    DMA_Cmd(rxStream, ENABLE);
+    DMA_Cmd(txStream, ENABLE);
+    SPI_I2S_DMACmd(fdevice->busdev->busdev_u.spi.instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+}
+
+static void m25p16_dmaIrqHandler(dmaChannelDescriptor_t *descriptor)
+{
+    busDevice_t *bus = m25p16Dma.fdevice->busdev;
+
+    if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TCIF)) {
+        DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
+
+        // the last byte has been received, so the bus is idle and the chip starts programming
+        SPI_I2S_DMACmd(bus->busdev_u.spi.instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+        m25p16_disable(bus);
+        m25p16Dma.sendIndex = -1;
+        m25p16Dma.reading = false;
+    }
+
+    if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TEIF)) {
+        DMA_CLEAR_FLAG(descriptor, DMA_IT_TEIF);
+
+        // the page is lost, the chip will reject the partial command once chip select goes high
+        DMA_Cmd(m25p16Dma.txDescriptor->ref, DISABLE);
+        DMA_Cmd(m25p16Dma.rxDescriptor->ref, DISABLE);
+        SPI_I2S_DMACmd(bus->busdev_u.spi.instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+        m25p16_disable(bus);
+        m25p16Dma.sendIndex = -1;
+        if (m25p16Dma.reading) {
+            m25p16Dma.readAhead.length = 0;
+            m25p16Dma.reading = false;
+        }
+    }
+}
+
+/**
+ * Moves the DMA page programs along, sending a waiting page once the chip is done with the last one.
+ *
+ * Returns true if the bus and the chip are idle and no page is waiting.
+ */
+static bool m25p16_dmaPoll(flashDevice_t *fdevice)
+{
+    if (m25p16Dma.sendIndex >= 0 || m25p16Dma.reading || !m25p16_isChipReady(fdevice)) {
+        return false;
+    }
+
+    if (m25p16Dma.pendingIndex >= 0) {
+        m25p16_dmaStart(fdevice, m25p16Dma.pendingIndex);
+        m25p16Dma.pendingIndex = -1;
+        return false;
+    }
+
+    m25p16Dma.programming = false;
+    return true;
+}
+#endif // USE_FLASH_SPI_DMA
+
+// Ready for the next page program, or idle for anything else
+static bool m25p16_isReady(flashDevice_t *fdevice)
+{
+#ifdef USE_FLASH_SPI_DMA
+    if (m25p16_isDmaDevice(fdevice)) {
+        // while one page is programmed the next can be collected, but an erase has to finish first
+        return m25p16_dmaPoll(fdevice) || (m25p16Dma.programming && m25p16Dma.pendingIndex < 0);
+    }
+#endif
+
+    return m25p16_isChipReady(fdevice);
+}
+
+// Waits until the bus and the chip are idle
+static bool m25p16_isIdle(flashDevice_t *fdevice)
+{
+#ifdef USE_FLASH_SPI_DMA
+    if (m25p16_isDmaDevice(fdevice)) {
+        return m25p16_dmaPoll(fdevice);
+    }
+#endif
+
+    return m25p16_isChipReady(fdevice);
+}
+
 static bool m25p16_waitForReady(flashDevice_t *fdevice, uint32_t timeoutMillis)
 {
     uint32_t time = millis();
-    while (!m25p16_isReady(fdevice)) {
+    while (!m25p16_isIdle(fdevice)) {
         if (millis() - time > timeoutMillis) {
             return false;
         }
@@ -249,13 +437,45 @@ static void m25p16_eraseCompletely(flashDevice_t *fdevice)
 
 static void m25p16_pageProgramBegin(flashDevice_t *fdevice, uint32_t address)
 {
-    UNUSED(fdevice);
-
     fdevice->currentWriteAddress = address;
+
+#ifdef USE_FLASH_SPI_DMA
+    if (m25p16_isDmaDevice(fdevice)) {
+        // both buffers are taken until the waiting page has been sent
+        const uint32_t time = millis();
+        while (m25p16Dma.pendingIndex >= 0 && millis() - time <= DEFAULT_TIMEOUT_MILLIS) {
+            m25p16_dmaPoll(fdevice);
+        }
+        if (m25p16Dma.pendingIndex >= 0) {
+            m25p16Dma.fillIndex = -1;
+            return;
+        }
+
+        m25p16Dma.fillIndex = m25p16Dma.sendIndex == 0 ? 1 : 0;
+        m25p16DmaBuffer_t *buffer = &m25p16Dma.buffer[m25p16Dma.fillIndex];
+        // short addresses leave the first byte unused, so the data starts at the same offset
+        buffer->data[fdevice->isLargeFlash ? 0 : 1] = M25P16_INSTRUCTION_PAGE_PROGRAM;
+        m25p16_setCommandAddress(&buffer->data[fdevice->isLargeFlash ? 1 : 2], address, fdevice->isLargeFlash);
+        buffer->length = M25P16_DMA_HEADER_SIZE;
+    }
+#endif
 }
 
 static void m25p16_pageProgramContinue(flashDevice_t *fdevice, const uint8_t *data, int length)
 {
+#ifdef USE_FLASH_SPI_DMA
+    if (m25p16_isDmaDevice(fdevice)) {
+        if (m25p16Dma.fillIndex >= 0) {
+            m25p16DmaBuffer_t *buffer = &m25p16Dma.buffer[m25p16Dma.fillIndex];
+            length = MIN(length, (int)sizeof(buffer->data) - buffer->length);
+            memcpy(&buffer->data[buffer->length], data, length);
+            buffer->length += length;
+        }
+        fdevice->currentWriteAddress += length;
+        return;
+    }
+#endif
+
     uint8_t command[5] = { M25P16_INSTRUCTION_PAGE_PROGRAM };
 
     m25p16_setCommandAddress(&command[1], fdevice->currentWriteAddress, fdevice->isLargeFlash);
@@ -277,7 +497,15 @@ static void m25p16_pageProgramContinue(flashDevice_t *fdevice, const uint8_t *da
 
 static void m25p16_pageProgramFinish(flashDevice_t *fdevice)
 {
+#ifdef USE_FLASH_SPI_DMA
+    if (m25p16_isDmaDevice(fdevice) && m25p16Dma.fillIndex >= 0) {
+        m25p16Dma.pendingIndex = m25p16Dma.fillIndex;
+        m25p16Dma.fillIndex = -1;
+        m25p16_dmaPoll(fdevice);
+    }
+#else
     UNUSED(fdevice);
+#endif
 }
 
 /**
@@ -304,6 +532,78 @@ static void m25p16_pageProgram(flashDevice_t *fdevice, uint32_t address, const u
     m25p16_pageProgramFinish(fdevice);
 }
 
+static void m25p16_readBlocking(flashDevice_t *fdevice, uint32_t address, uint8_t *buffer, int length)
+{
+    uint8_t command[5] = { M25P16_INSTRUCTION_READ_BYTES };
+
+    m25p16_setCommandAddress(&command[1], address, fdevice->isLargeFlash);
+
+    m25p16_enable(fdevice->busdev);
+
+    spiTransfer(fdevice->busdev->busdev_u.spi.instance, command, NULL, fdevice->isLargeFlash ? 5 : 4);
+    spiTransfer(fdevice->busdev->busdev_u.spi.instance, NULL, buffer, length);
+
+    m25p16_disable(fdevice->busdev);
+}
+
+#ifdef USE_FLASH_SPI_DMA
+static void m25p16_readAheadInvalidate(void)
+{
+    m25p16Dma.readAhead.length = 0;
+}
+
+// Copies what the read-ahead holds of the start of the request, the bus has to be idle
+static int m25p16_readAheadCopy(uint32_t address, uint8_t *buffer, int length)
+{
+    const m25p16ReadAhead_t *readAhead = &m25p16Dma.readAhead;
+
+    if (address < readAhead->address || address >= readAhead->address + readAhead->length) {
+        return 0;
+    }
+
+    const int count = MIN(length, (int)(readAhead->address + readAhead->length - address));
+    memcpy(buffer, &readAhead->data[M25P16_DMA_HEADER_SIZE + address - readAhead->address], count);
+
+    return count;
+}
+
+// Starts reading up to `length` bytes at `address` into the read-ahead buffer, the bus has to be idle
+static void m25p16_readAheadStart(flashDevice_t *fdevice, uint32_t address, int length)
+{
+    m25p16ReadAhead_t *readAhead = &m25p16Dma.readAhead;
+
+    if (address >= fdevice->geometry.totalSize) {
+        return;
+    }
+
+    readAhead->address = address;
+    readAhead->length = MIN(MIN(length, M25P16_READ_AHEAD_SIZE), (int)(fdevice->geometry.totalSize - address));
+
+    // the command goes out of the same buffer the reply comes into, each byte is sent before it is overwritten
+    const int offset = fdevice->isLargeFlash ? 0 : 1;
+    readAhead->data[offset] = M25P16_INSTRUCTION_READ_BYTES;
+    m25p16_setCommandAddress(&readAhead->data[offset + 1], address, fdevice->isLargeFlash);
+    const uint16_t transferLength = M25P16_DMA_HEADER_SIZE - offset + readAhead->length;
+
+    DMA_Stream_TypeDef *rxStream = m25p16Dma.rxDescriptor->ref;
+    DMA_Stream_TypeDef *txStream = m25p16Dma.txDescriptor->ref;
+    DMA_CLEAR_FLAG(m25p16Dma.rxDescriptor, M25P16_DMA_FLAGS);
+    DMA_CLEAR_FLAG(m25p16Dma.txDescriptor, M25P16_DMA_FLAGS);
+    rxStream->CR |= DMA_SxCR_MINC;
+    DMA_MemoryTargetConfig(rxStream, (uint32_t)&readAhead->data[offset], DMA_Memory_0);
+    DMA_MemoryTargetConfig(txStream, (uint32_t)&readAhead->data[offset], DMA_Memory_0);
+    DMA_SetCurrDataCounter(rxStream, transferLength);
+    DMA_SetCurrDataCounter(txStream, transferLength);
+
+    m25p16Dma.reading = true;
+
+    m25p16_enable(fdevice->busdev);
+    DMA_Cmd(rxStream, ENABLE);
+    DMA_Cmd(txStream, ENABLE);
+    SPI_I2S_DMACmd(fdevice->busdev->busdev_u.spi.instance, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+}
+#endif
+
 /**
  * Read `length` bytes into the provided `buffer` from the flash starting from the given `address` (which need not lie
  * on a page boundary).
@@ -314,24 +614,43 @@ static void m25p16_pageProgram(flashDevice_t *fdevice, uint32_t address, const u
  */
 static int m25p16_readBytes(flashDevice_t *fdevice, uint32_t address, uint8_t *buffer, int length)
 {
-    uint8_t command[5] = { M25P16_INSTRUCTION_READ_BYTES };
-
-    m25p16_setCommandAddress(&command[1], address, fdevice->isLargeFlash);
-
     if (!m25p16_waitForReady(fdevice, DEFAULT_TIMEOUT_MILLIS)) {
         return 0;
     }
 
-    m25p16_enable(fdevice->busdev);
+#ifdef USE_FLASH_SPI_DMA
+    if (m25p16_isDmaDevice(fdevice)) {
+        const int cached = m25p16_readAheadCopy(address, buffer, length);
+        if (cached < length) {
+            m25p16_readBlocking(fdevice, address + cached, buffer + cached, length - cached);
+        }
 
-    spiTransfer(fdevice->busdev->busdev_u.spi.instance, command, NULL, fdevice->isLargeFlash ? 5 : 4);
-    spiTransfer(fdevice->busdev->busdev_u.spi.instance, NULL, buffer, length);
+        // a sequential reader asks for the next chunk while this one is sent
+        m25p16_readAheadStart(fdevice, address + length, length);
 
-    m25p16_disable(fdevice->busdev);
+        return length;
+    }
+#endif
+
+    m25p16_readBlocking(fdevice, address, buffer, length);
 
     return length;
 }
 
+/**
+ * Waits until every page program handed to the driver has been sent to the chip.
+ */
+static void m25p16_flush(flashDevice_t *fdevice)
+{
+#ifdef USE_FLASH_SPI_DMA
+    if (m25p16_isDmaDevice(fdevice)) {
+        m25p16_waitForReady(fdevice, 2 * DEFAULT_TIMEOUT_MILLIS);
+    }
+#else
+    UNUSED(fdevice);
+#endif
+}
+
 /**
  * Fetch information about the detected flash chip layout.
  *
@@ -344,6 +663,7 @@ static const flashGeometry_t* m25p16_getGeometry(flashDevice_t *fdevice)
 
 const flashVTable_t m25p16_vTable = {
     .isReady = m25p16_isReady,
+    .isIdle = m25p16_isIdle,
     .waitForReady = m25p16_waitForReady,
     .eraseSector = m25p16_eraseSector,
     .eraseCompletely = m25p16_eraseCompletely,
@@ -351,7 +671,83 @@ const flashVTable_t m25p16_vTable = {
     .pageProgramContinue = m25p16_pageProgramContinue,
     .pageProgramFinish = m25p16_pageProgramFinish,
     .pageProgram = m25p16_pageProgram,
+    .flush = m25p16_flush,
     .readBytes = m25p16_readBytes,
     .getGeometry = m25p16_getGeometry,
 };
+
+#ifdef USE_FLASH_SPI_DMA
+// Switches the page programs of a detected chip over to DMA, the target selects the streams
+bool m25p16_spiDmaInit(flashDevice_t *fdevice)
+{
+    if (fdevice->vTable != &m25p16_vTable || fdevice->busdev->bustype != BUSTYPE_SPI || m25p16Dma.fdevice) {
+        return false;
+    }
+
+    DMA_Stream_TypeDef *rxStream = FLASH_SPI_DMA_RX_STREAM;
+    DMA_Stream_TypeDef *txStream = FLASH_SPI_DMA_TX_STREAM;
+    uint32_t rxChannel = FLASH_SPI_DMA_RX_CHANNEL;
+    uint32_t txChannel = FLASH_SPI_DMA_TX_CHANNEL;
+#ifdef USE_DMA_SPEC
+    const SPIDevice spiDevice = spiDeviceByInstance(fdevice->busdev->busdev_u.spi.instance);
+    const dmaChannelSpec_t *rxSpec = dmaAllocate(DMA_PERIPH_SPI_RX, spiDevice, rxStream, OWNER_FLASH_DMA, 0);
+    const dmaChannelSpec_t *txSpec = rxSpec ? dmaAllocate(DMA_PERIPH_SPI_TX, spiDevice, txStream, OWNER_FLASH_DMA, 0) : NULL;
+    if (!txSpec) {
+        if (rxSpec) {
+            dmaInit(dmaGetIdentifier(rxSpec->ref), OWNER_FREE, 0);
+        }
+        return false;
+    }
+    rxStream = rxSpec->ref;
+    rxChannel = rxSpec->channel;
+    txStream = txSpec->ref;
+    txChannel = txSpec->channel;
+    const dmaIdentifier_e rxIdentifier = dmaGetIdentifier(rxStream);
+    const dmaIdentifier_e txIdentifier = dmaGetIdentifier(txStream);
+#else
+    const dmaIdentifier_e rxIdentifier = dmaGetIdentifier(rxStream);
+    const dmaIdentifier_e txIdentifier = dmaGetIdentifier(txStream);
+    if (dmaGetOwner(rxIdentifier) != OWNER_FREE || dmaGetOwner(txIdentifier) != OWNER_FREE) {
+        return false;
+    }
+
+    dmaInit(rxIdentifier, OWNER_FLASH_DMA, 0);
+    dmaInit(txIdentifier, OWNER_FLASH_DMA, 0);
+#endif
+
+    DMA_InitTypeDef DMA_InitStructure;
+    DMA_StructInit(&DMA_InitStructure);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)(&(fdevice->busdev->busdev_u.spi.instance->DR));
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_BufferSize = M25P16_DMA_HEADER_SIZE + M25P16_PAGESIZE;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+
+    // the received bytes are of no interest, but they mark the end of the transfer
+    DMA_DeInit(rxStream);
+    DMA_InitStructure.DMA_Channel = rxChannel;
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)&m25p16DmaRxDummy;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Disable;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+    DMA_Init(rxStream, &DMA_InitStructure);
+    DMA_ITConfig(rxStream, DMA_IT_TC | DMA_IT_TE, ENABLE);
+
+    DMA_DeInit(txStream);
+    DMA_InitStructure.DMA_Channel = txChannel;
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)m25p16Dma.buffer[0].data;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+    DMA_Init(txStream, &DMA_InitStructure);
+
+    m25p16Dma.rxDescriptor = dmaGetDescriptorByIdentifier(rxIdentifier);
+    m25p16Dma.txDescriptor = dmaGetDescriptorByIdentifier(txIdentifier);
+    dmaSetHandler(rxIdentifier, m25p16_dmaIrqHandler, NVIC_PRIO_FLASH_DMA, 0);
+
+    m25p16Dma.fdevice = fdevice;
+
+    return true;
+}
+#endif
 #endif
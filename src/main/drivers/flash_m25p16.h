@@ -25,3 +25,4 @@
 #define JEDEC_ID_WINBOND_W25Q256       0xEF4019
 
 bool m25p16_detect(flashDevice_t *fdevice, uint32_t chipID);
+bool m25p16_spiDmaInit(flashDevice_t *fdevice);
@@ -21,7 +21,10 @@
 /*
  * Winbond W25M series stacked die flash driver.
  * Handles homogeneous stack of identical dies by calling die drivers.
- * 
+ *
+ * In interleaved mode consecutive pages alternate between the dies, so one die
+ * can be programmed while the previous page program is still running on the other.
+ *
  * Author: jflyper
  */
 
@@ -58,6 +61,9 @@ static flashDevice_t dieDevice[MAX_DIE_COUNT];
 
 static int dieCount;
 static uint32_t dieSize;
+static uint32_t diePageSize;
+static bool interleaved;
+static int nextWriteDie;
 
 static void w25m_dieSelect(busDevice_t *busdev, int die)
 {
@@ -74,9 +80,52 @@ static void w25m_dieSelect(busDevice_t *busdev, int die)
     activeDie = die;
 }
 
+static int w25m_dieForAddress(uint32_t address)
+{
+    if (interleaved) {
+        return (address / diePageSize) % dieCount;
+    }
+
+    return address / dieSize;
+}
+
+static uint32_t w25m_dieAddress(uint32_t address)
+{
+    if (interleaved) {
+        return (address / diePageSize / dieCount) * diePageSize + address % diePageSize;
+    }
+
+    return address % dieSize;
+}
+
+static bool w25m_dieIsReady(flashDevice_t *fdevice, int die)
+{
+    if (!dieDevice[die].couldBeBusy) {
+        return true;
+    }
+
+    w25m_dieSelect(fdevice->busdev, die);
+
+    return dieDevice[die].vTable->isReady(&dieDevice[die]);
+}
+
+static bool w25m_isIdle(flashDevice_t *fdevice)
+{
+    for (int die = 0 ; die < dieCount ; die++) {
+        if (!w25m_dieIsReady(fdevice, die)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 static bool w25m_isReady(flashDevice_t *fdevice)
 {
-    UNUSED(fdevice);
+    if (interleaved) {
+        // Only the die that takes the next page has to be free, the other may still be programming
+        return w25m_dieIsReady(fdevice, nextWriteDie);
+    }
 
     for (int die = 0 ; die < dieCount ; die++) {
         if (dieDevice[die].couldBeBusy) {
@@ -93,7 +142,7 @@ static bool w25m_isReady(flashDevice_t *fdevice)
 static bool w25m_waitForReady(flashDevice_t *fdevice, uint32_t timeoutMillis)
 {
     uint32_t time = millis();
-    while (!w25m_isReady(fdevice)) {
+    while (!w25m_isIdle(fdevice)) {
         if (millis() - time > timeoutMillis) {
             return false;
         }
@@ -128,10 +177,17 @@ bool w25m_detect(flashDevice_t *fdevice, uint32_t chipID)
         return false;
     }
 
+    interleaved = flashConfig()->dieInterleave;
+    nextWriteDie = 0;
+
+    // An interleaved sector is made of the same sector on every die
+    const int sectorDies = interleaved ? dieCount : 1;
+
     fdevice->geometry.sectors = dieDevice[0].geometry.sectors;
-    fdevice->geometry.sectorSize = dieDevice[0].geometry.sectorSize;
-    fdevice->geometry.pagesPerSector = dieDevice[0].geometry.pagesPerSector;
+    fdevice->geometry.sectorSize = dieDevice[0].geometry.sectorSize * sectorDies;
+    fdevice->geometry.pagesPerSector = dieDevice[0].geometry.pagesPerSector * sectorDies;
     fdevice->geometry.pageSize = dieDevice[0].geometry.pageSize;
+    diePageSize = dieDevice[0].geometry.pageSize;
     dieSize = dieDevice[0].geometry.totalSize;
     fdevice->geometry.totalSize = dieSize * dieCount;
     fdevice->vTable = &w25m_vTable;
@@ -141,6 +197,16 @@ bool w25m_detect(flashDevice_t *fdevice, uint32_t chipID)
 
 void w25m_eraseSector(flashDevice_t *fdevice, uint32_t address)
 {
+    if (interleaved) {
+        const uint32_t dieAddress = w25m_dieAddress(address);
+
+        for (int dieNumber = 0 ; dieNumber < dieCount ; dieNumber++) {
+            w25m_dieSelect(fdevice->busdev, dieNumber);
+            dieDevice[dieNumber].vTable->eraseSector(&dieDevice[dieNumber], dieAddress);
+        }
+        return;
+    }
+
     int dieNumber = address / dieSize;
 
     w25m_dieSelect(fdevice->busdev, dieNumber);
@@ -163,9 +229,9 @@ void w25m_pageProgramBegin(flashDevice_t *fdevice, uint32_t address)
 {
     UNUSED(fdevice);
 
-    currentWriteDie = address / dieSize;
+    currentWriteDie = w25m_dieForAddress(address);
     w25m_dieSelect(fdevice->busdev, currentWriteDie);
-    currentWriteAddress = address % dieSize;
+    currentWriteAddress = w25m_dieAddress(address);
     dieDevice[currentWriteDie].vTable->pageProgramBegin(&dieDevice[currentWriteDie], currentWriteAddress);
 }
 
@@ -181,6 +247,8 @@ void w25m_pageProgramFinish(flashDevice_t *fdevice)
     UNUSED(fdevice);
 
     dieDevice[currentWriteDie].vTable->pageProgramFinish(&dieDevice[currentWriteDie]);
+
+    nextWriteDie = interleaved ? (currentWriteDie + 1) % dieCount : currentWriteDie;
 }
 
 void w25m_pageProgram(flashDevice_t *fdevice, uint32_t address, const uint8_t *data, int length)
@@ -198,13 +266,17 @@ int w25m_readBytes(flashDevice_t *fdevice, uint32_t address, uint8_t *buffer, in
     int tlen; // transfer length for a round
     int rbytes;
 
-    // Divide a read that spans multiple dies into two.
-    // The loop is executed twice at the most for decent 'length'.
+    // Divide a read that spans multiple dies into one transfer per die.
+    // Unless interleaved, the loop is executed twice at the most for decent 'length'.
 
     for (rlen = length; rlen; rlen -= tlen) {
-        int dieNumber = address / dieSize;
-        uint32_t dieAddress = address % dieSize;
-        tlen = MIN(dieAddress + rlen, dieSize) - dieAddress;
+        int dieNumber = w25m_dieForAddress(address);
+        uint32_t dieAddress = w25m_dieAddress(address);
+        if (interleaved) {
+            tlen = MIN(diePageSize - address % diePageSize, (uint32_t)rlen);
+        } else {
+            tlen = MIN(dieAddress + rlen, dieSize) - dieAddress;
+        }
 
         w25m_dieSelect(fdevice->busdev, dieNumber);
 
@@ -227,6 +299,7 @@ const flashGeometry_t* w25m_getGeometry(flashDevice_t *fdevice)
 
 static const flashVTable_t w25m_vTable = {
     .isReady = w25m_isReady,
+    .isIdle = w25m_isIdle,
     .waitForReady = w25m_waitForReady,
     .eraseSector = w25m_eraseSector,
     .eraseCompletely = w25m_eraseCompletely,
@@ -42,13 +42,7 @@
 #include "drivers/io.h"
 #include "light_ws2811strip.h"
 
-#if defined(STM32F1) || defined(STM32F3)
-uint8_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
-#elif defined(STM32F7)
-FAST_RAM_ZERO_INIT uint32_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
-#else
-uint32_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
-#endif
+DMA_RAM ledStripDMAValue_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
 
 volatile uint8_t ws2811LedDataTransferInProgress = 0;
 
@@ -57,6 +51,16 @@ uint16_t BIT_COMPARE_0 = 0;
 
 static hsvColor_t ledColorBuffer[WS2811_LED_STRIP_LENGTH];
 
+// The colours currently encoded in the DMA buffer, only LEDs that differ are encoded again
+static hsvColor_t ledColorEncoded[WS2811_LED_STRIP_LENGTH];
+static bool ledColorEncodedValid = false;
+static ledStripFormatRGB_e ledColorEncodedFormat;
+
+// Compare values of the 4 bits of each nibble, MSB first, for the bit compare values they were built from
+static ledStripDMAValue_t nibblePulses[16][4];
+static uint16_t nibblePulsesCompare0 = 0;
+static uint16_t nibblePulsesCompare1 = 0;
+
 void setLedHsv(uint16_t index, const hsvColor_t *color)
 {
     ledColorBuffer[index] = *color;
@@ -96,6 +100,7 @@ void setStripColors(const hsvColor_t *colors)
 void ws2811LedStripInit(ioTag_t ioTag)
 {
     memset(ledStripDMABuffer, 0, sizeof(ledStripDMABuffer));
+    ledColorEncodedValid = false;
     ws2811LedStripHardwareInit(ioTag);
 
     const hsvColor_t hsv_white = { 0, 255, 255 };
@@ -112,6 +117,17 @@ bool isWS2811LedStripReady(void)
 STATIC_UNIT_TESTED uint16_t dmaBufferOffset;
 static int16_t ledIndex;
 
+static void buildNibblePulses(void)
+{
+    for (int nibble = 0; nibble < 16; nibble++) {
+        for (int bit = 0; bit < 4; bit++) {
+            nibblePulses[nibble][bit] = (nibble & (0x08 >> bit)) ? BIT_COMPARE_1 : BIT_COMPARE_0;
+        }
+    }
+    nibblePulsesCompare0 = BIT_COMPARE_0;
+    nibblePulsesCompare1 = BIT_COMPARE_1;
+}
+
 #define USE_FAST_DMA_BUFFER_IMPL
 #ifdef USE_FAST_DMA_BUFFER_IMPL
 
@@ -130,9 +146,12 @@ STATIC_UNIT_TESTED void fastUpdateLEDDMABuffer(ledStripFormatRGB_e ledFormat, rg
         break;
     }
 
-    for (int8_t index = 23; index >= 0; index--) {
-        ledStripDMABuffer[dmaBufferOffset++] = (packed_colour & (1 << index)) ? BIT_COMPARE_1 : BIT_COMPARE_0;
+    ledStripDMAValue_t *dst = &ledStripDMABuffer[dmaBufferOffset];
+    for (int shift = WS2811_BITS_PER_LED - 4; shift >= 0; shift -= 4) {
+        memcpy(dst, nibblePulses[(packed_colour >> shift) & 0x0f], sizeof(nibblePulses[0]));
+        dst += 4;
     }
+    dmaBufferOffset += WS2811_BITS_PER_LED;
 }
 #else
 STATIC_UNIT_TESTED void updateLEDDMABuffer(uint8_t componentValue)
@@ -157,6 +176,7 @@ STATIC_UNIT_TESTED void updateLEDDMABuffer(uint8_t componentValue)
 /*
  * This method is non-blocking unless an existing LED update is in progress.
  * it does not wait until all the LEDs have been updated, that happens in the background.
+ * The LEDs latch their colour, so nothing is sent when no LED changed since the last update.
  */
 void ws2811UpdateStrip(ledStripFormatRGB_e ledFormat)
 {
@@ -167,6 +187,18 @@ void ws2811UpdateStrip(ledStripFormatRGB_e ledFormat)
         return;
     }
 
+    if (nibblePulsesCompare0 != BIT_COMPARE_0 || nibblePulsesCompare1 != BIT_COMPARE_1) {
+        buildNibblePulses();
+        ledColorEncodedValid = false;
+    }
+    if (ledColorEncodedFormat != ledFormat) {
+        ledColorEncodedFormat = ledFormat;
+        ledColorEncodedValid = false;
+    }
+
+    const bool frameSent = ledColorEncodedValid;
+    bool frameChanged = false;
+
     dmaBufferOffset = 0;                // reset buffer memory index
     ledIndex = 0;                       // reset led index
 
@@ -174,7 +206,19 @@ void ws2811UpdateStrip(ledStripFormatRGB_e ledFormat)
     // correct pulse widths according to color values
     while (ledIndex < WS2811_LED_STRIP_LENGTH)
     {
-        rgb24 = hsvToRgb24(&ledColorBuffer[ledIndex]);
+        const hsvColor_t *hsv = &ledColorBuffer[ledIndex];
+        hsvColor_t *encoded = &ledColorEncoded[ledIndex];
+
+        if (ledColorEncodedValid && hsv->h == encoded->h && hsv->s == encoded->s && hsv->v == encoded->v) {
+            // the DMA buffer still holds this colour
+            dmaBufferOffset += WS2811_BITS_PER_LED;
+            ledIndex++;
+            continue;
+        }
+        *encoded = *hsv;
+        frameChanged = true;
+
+        rgb24 = hsvToRgb24(hsv);
 
 #ifdef USE_FAST_DMA_BUFFER_IMPL
         fastUpdateLEDDMABuffer(ledFormat, rgb24);
@@ -197,6 +241,11 @@ void ws2811UpdateStrip(ledStripFormatRGB_e ledFormat)
 
         ledIndex++;
     }
+    ledColorEncodedValid = true;
+
+    if (frameSent && !frameChanged) {
+        return;
+    }
 
     ws2811LedDataTransferInProgress = 1;
     ws2811LedStripDMAEnable();
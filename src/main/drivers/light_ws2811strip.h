@@ -54,10 +54,12 @@ void setStripColors(const hsvColor_t *colors);
 bool isWS2811LedStripReady(void);
 
 #if defined(STM32F1) || defined(STM32F3)
-extern uint8_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
+typedef uint8_t ledStripDMAValue_t;
 #else
-extern uint32_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
+typedef uint32_t ledStripDMAValue_t;
 #endif
+
+extern ledStripDMAValue_t ledStripDMABuffer[WS2811_DMA_BUFFER_SIZE];
 extern volatile uint8_t ws2811LedDataTransferInProgress;
 
 extern uint16_t BIT_COMPARE_1;
@@ -28,6 +28,8 @@
 
 #include "build/debug.h"
 
+#include "common/maths.h"
+
 #include "pg/max7456.h"
 #include "pg/pg.h"
 #include "pg/pg_ids.h"
@@ -207,6 +209,13 @@ static uint8_t shadowBuffer[VIDEO_BUFFER_CHARS_PAL];
 //Max chars to update in one idle
 
 #define MAX_CHARS2UPDATE    100
+
+// Runs of changed chars are written in auto-increment mode: the address and the mode switch
+// cost 6 bytes and ending the run 4 more, then each char costs 2 bytes instead of 6.
+// A few unchanged chars inside a run are cheaper to write again than starting another run.
+#define MAX7456_RUN_OVERHEAD_BYTES  10
+#define MAX7456_RUN_MIN_CHARS       3
+#define MAX7456_RUN_MAX_GAP         4
 #ifdef MAX7456_DMA_CHANNEL_TX
 volatile bool dmaTransactionInProgress = false;
 #endif
@@ -223,9 +232,23 @@ static uint8_t  vosRegValue; // VOS (Vertical offset register) value
 static bool max7456Lock         = false;
 static bool fontIsLoading       = false;
 
+#define MAX7456_NVM_QUEUE_LENGTH 4
+
+typedef struct max7456NvmChar_s {
+    uint8_t address;
+    uint8_t data[MAX7456_NVM_CHAR_BYTES];
+} max7456NvmChar_t;
+
+static max7456NvmChar_t nvmQueue[MAX7456_NVM_QUEUE_LENGTH];
+static uint8_t nvmQueueHead = 0;
+static uint8_t nvmQueueCount = 0;
+static bool nvmWriteInProgress = false;
+static uint16_t nvmCharsWritten = 0;
+
 static uint8_t max7456DeviceType;
 
 static void max7456DrawScreenSlow(void);
+static void max7456ProcessNvm(void);
 
 static uint8_t max7456Send(uint8_t add, uint8_t data)
 {
@@ -242,7 +265,7 @@ static void max7456SendDma(void* tx_buffer, void* rx_buffer, uint16_t buffer_siz
 #else
     UNUSED(rx_buffer);
 #endif
-    while (dmaTransactionInProgress); // Wait for prev DMA transaction
+    // max7456DrawScreen() does not start a transaction while the previous one is in progress
 
     DMA_DeInit(MAX7456_DMA_CHANNEL_TX);
 #ifdef MAX7456_DMA_CHANNEL_RX
@@ -456,7 +479,8 @@ void max7456Init(const max7456Config_t *max7456Config, const vcdProfile_t *pVcdP
         break;
 
     case MAX7456_CLOCK_CONFIG_OC:
-        max7456SpiClock = (cpuOverclock && (max7456DeviceType == MAX7456_DEVICE_TYPE_MAX)) ? MAX7456_SPI_CLK * 2 : MAX7456_SPI_CLK;
+        // spiSetDivisor() already keeps the bus at the stock clock rate when the core is overclocked
+        max7456SpiClock = MAX7456_SPI_CLK;
         break;
 
     case MAX7456_CLOCK_CONFIG_FULL:
@@ -618,11 +642,42 @@ void max7456ReInitIfRequired(void)
     //------------   end of (re)init-------------------------------------
 }
 
+// Length of the run of chars to send starting at the changed char at pos, 0 when it is not worth a run
+static int max7456ChangedRunLength(int pos)
+{
+    int end = pos;
+    int gap = 0;
+
+    // END_STRING would end auto-increment mode, it is always sent on its own
+    for (int i = pos; i < maxScreenSize && screenBuffer[i] != END_STRING; i++) {
+        if (screenBuffer[i] != shadowBuffer[i]) {
+            end = i + 1;
+            gap = 0;
+        } else if (++gap > MAX7456_RUN_MAX_GAP) {
+            break;
+        }
+    }
+
+    return end - pos >= MAX7456_RUN_MIN_CHARS ? end - pos : 0;
+}
+
 void max7456DrawScreen(void)
 {
     static uint16_t pos = 0;
 
-    if (!max7456Lock && !fontIsLoading) {
+#ifdef MAX7456_DMA_CHANNEL_TX
+    // the previous chunk is still going out, the SPI bus is free again once it completes
+    if (dmaTransactionInProgress) {
+        return;
+    }
+#endif
+
+    if (!max7456Lock && fontIsLoading) {
+        // the display stays off while a font is uploaded, program the queued characters instead
+        max7456Lock = true;
+        max7456ProcessNvm();
+        max7456Lock = false;
+    } else if (!max7456Lock) {
 
         // (Re)Initialize MAX7456 at startup or stall is detected.
 
@@ -630,9 +685,37 @@ void max7456DrawScreen(void)
 
         max7456ReInitIfRequired();
 
+        // one chunk per call so other devices get the SPI bus in between
         int buff_len = 0;
-        for (int k = 0; k < MAX_CHARS2UPDATE; k++) {
-            if (screenBuffer[pos] != shadowBuffer[pos]) {
+        while (pos < maxScreenSize) {
+            if (screenBuffer[pos] == shadowBuffer[pos]) {
+                pos++;
+                continue;
+            }
+
+            int runLength = max7456ChangedRunLength(pos);
+            if (runLength) {
+                runLength = MIN(runLength, ((int)sizeof(spiBuff) - buff_len - MAX7456_RUN_OVERHEAD_BYTES) / 2);
+            }
+
+            if (runLength >= MAX7456_RUN_MIN_CHARS) {
+                spiBuff[buff_len++] = MAX7456ADD_DMAH;
+                spiBuff[buff_len++] = pos >> 8;
+                spiBuff[buff_len++] = MAX7456ADD_DMAL;
+                spiBuff[buff_len++] = pos & 0xff;
+                spiBuff[buff_len++] = MAX7456ADD_DMM;
+                spiBuff[buff_len++] = displayMemoryModeReg | 1;
+                for (int i = 0; i < runLength; i++) {
+                    spiBuff[buff_len++] = MAX7456ADD_DMDI;
+                    spiBuff[buff_len++] = screenBuffer[pos];
+                    shadowBuffer[pos] = screenBuffer[pos];
+                    pos++;
+                }
+                spiBuff[buff_len++] = MAX7456ADD_DMDI;
+                spiBuff[buff_len++] = END_STRING;
+                spiBuff[buff_len++] = MAX7456ADD_DMM;
+                spiBuff[buff_len++] = displayMemoryModeReg;
+            } else if (buff_len + 6 <= (int)sizeof(spiBuff)) {
                 spiBuff[buff_len++] = MAX7456ADD_DMAH;
                 spiBuff[buff_len++] = pos >> 8;
                 spiBuff[buff_len++] = MAX7456ADD_DMAL;
@@ -640,14 +723,17 @@ void max7456DrawScreen(void)
                 spiBuff[buff_len++] = MAX7456ADD_DMDI;
                 spiBuff[buff_len++] = screenBuffer[pos];
                 shadowBuffer[pos] = screenBuffer[pos];
-            }
-
-            if (++pos >= maxScreenSize) {
-                pos = 0;
+                pos++;
+            } else {
+                // chunk is full, carry on from here next time
                 break;
             }
         }
 
+        if (pos >= maxScreenSize) {
+            pos = 0;
+        }
+
         if (buff_len) {
 #ifdef MAX7456_DMA_CHANNEL_TX
             max7456SendDma(spiBuff, NULL, buff_len);
@@ -718,44 +804,87 @@ void max7456RefreshAll(void)
     }
 }
 
-void max7456WriteNvm(uint8_t char_address, const uint8_t *font_data)
+// Programming a character into NVM takes ~12ms. Characters are queued and programmed from
+// max7456DrawScreen(), so uploading a font no longer stalls the caller for each character.
+static void max7456ProcessNvm(void)
 {
-#ifdef MAX7456_DMA_CHANNEL_TX
-    while (dmaTransactionInProgress);
-#endif
-    while (max7456Lock);
-    max7456Lock = true;
-
     __spiBusTransactionBegin(busdev);
-    // disable display
-    fontIsLoading = true;
-    max7456Send(MAX7456ADD_VM0, 0);
 
-    max7456Send(MAX7456ADD_CMAH, char_address); // set start address high
+    if (nvmWriteInProgress) {
+        // Wait until bit 5 in the status register returns to 0
+        if ((max7456Send(MAX7456ADD_STAT, 0x00) & STAT_NVR_BUSY) != 0x00) {
+            __spiBusTransactionEnd(busdev);
+            return;
+        }
+        nvmWriteInProgress = false;
+        nvmCharsWritten++;
+    }
+
+    if (nvmQueueCount) {
+        const max7456NvmChar_t *nvmChar = &nvmQueue[nvmQueueHead];
+
+        max7456Send(MAX7456ADD_CMAH, nvmChar->address); // set start address high
 
-    for (int x = 0; x < 54; x++) {
-        max7456Send(MAX7456ADD_CMAL, x); //set start address low
-        max7456Send(MAX7456ADD_CMDI, font_data[x]);
+        for (int x = 0; x < MAX7456_NVM_CHAR_BYTES; x++) {
+            max7456Send(MAX7456ADD_CMAL, x); //set start address low
+            max7456Send(MAX7456ADD_CMDI, nvmChar->data[x]);
+        }
 #ifdef LED0_TOGGLE
         LED0_TOGGLE;
 #else
         LED1_TOGGLE;
 #endif
+
+        // Transfer 54 bytes from shadow ram to NVM
+        max7456Send(MAX7456ADD_CMM, WRITE_NVR);
+        nvmWriteInProgress = true;
+
+        nvmQueueHead = (nvmQueueHead + 1) % MAX7456_NVM_QUEUE_LENGTH;
+        nvmQueueCount--;
     }
 
-    // Transfer 54 bytes from shadow ram to NVM
+    __spiBusTransactionEnd(busdev);
+}
 
-    max7456Send(MAX7456ADD_CMM, WRITE_NVR);
+void max7456WriteNvm(uint8_t char_address, const uint8_t *font_data)
+{
+#ifdef MAX7456_DMA_CHANNEL_TX
+    while (dmaTransactionInProgress);
+#endif
+    while (max7456Lock);
+    max7456Lock = true;
 
-    // Wait until bit 5 in the status register returns to 0 (12ms)
+    if (!fontIsLoading) {
+        // disable display
+        fontIsLoading = true;
+        __spiBusTransactionBegin(busdev);
+        max7456Send(MAX7456ADD_VM0, 0);
+        __spiBusTransactionEnd(busdev);
+    }
 
-    while ((max7456Send(MAX7456ADD_STAT, 0x00) & STAT_NVR_BUSY) != 0x00);
+    // when characters arrive faster than they can be programmed, wait for a free slot
+    while (nvmQueueCount == MAX7456_NVM_QUEUE_LENGTH) {
+        max7456ProcessNvm();
+    }
 
-    __spiBusTransactionEnd(busdev);
+    max7456NvmChar_t *nvmChar = &nvmQueue[(nvmQueueHead + nvmQueueCount) % MAX7456_NVM_QUEUE_LENGTH];
+    nvmChar->address = char_address;
+    memcpy(nvmChar->data, font_data, MAX7456_NVM_CHAR_BYTES);
+    nvmQueueCount++;
 
     max7456Lock = false;
 }
 
+uint8_t max7456NvmCharsPending(void)
+{
+    return nvmQueueCount + (nvmWriteInProgress ? 1 : 0);
+}
+
+uint16_t max7456NvmCharsWritten(void)
+{
+    return nvmCharsWritten;
+}
+
 #ifdef MAX7456_NRST_PIN
 static IO_t max7456ResetPin        = IO_NONE;
 #endif
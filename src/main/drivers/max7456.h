@@ -26,6 +26,8 @@
 #define VIDEO_LINES_NTSC          13
 #define VIDEO_LINES_PAL           16
 
+#define MAX7456_NVM_CHAR_BYTES    54
+
 extern uint16_t maxScreenSize;
 
 struct vcdProfile_s;
@@ -36,6 +38,8 @@ void    max7456Invert(bool invert);
 void    max7456Brightness(uint8_t black, uint8_t white);
 void    max7456DrawScreen(void);
 void    max7456WriteNvm(uint8_t char_address, const uint8_t *font_data);
+uint8_t max7456NvmCharsPending(void);
+uint16_t max7456NvmCharsWritten(void);
 uint8_t max7456GetRowsCount(void);
 void    max7456Write(uint8_t x, uint8_t y, const char *buff);
 void    max7456WriteChar(uint8_t x, uint8_t y, uint8_t c);
@@ -30,6 +30,8 @@
 #include "pwm_output.h"
 #include "timer.h"
 #include "drivers/pwm_output.h"
+#include "drivers/swi.h"
+#include "drivers/dshot_bitbang.h"
 
 static FAST_RAM_ZERO_INIT pwmWriteFn *pwmWrite;
 static FAST_RAM_ZERO_INIT pwmOutputPort_t motors[MAX_SUPPORTED_MOTORS];
@@ -41,6 +43,7 @@ FAST_RAM_ZERO_INIT loadDmaBufferFn *loadDmaBuffer;
 #define DSHOT_COMMAND_DELAY_US 1000
 #define DSHOT_ESCINFO_DELAY_US 12000
 #define DSHOT_BEEP_DELAY_US 100000
+#define DSHOT_MAX_COMMANDS 3
 
 typedef struct dshotCommandControl_s {
     timeUs_t nextCommandAtUs;
@@ -50,7 +53,10 @@ typedef struct dshotCommandControl_s {
     uint8_t command[MAX_SUPPORTED_MOTORS];
 } dshotCommandControl_t;
 
-static dshotCommandControl_t dshotCommandControl;
+// FIFO of pending commands, the one at the tail is being sent
+static dshotCommandControl_t commandQueue[DSHOT_MAX_COMMANDS + 1];
+static uint8_t commandQueueHead;
+static uint8_t commandQueueTail;
 #endif
 
 #ifdef USE_SERVOS
@@ -67,6 +73,9 @@ static bool isDshot = false;
 #ifdef USE_DSHOT_DMAR
 FAST_RAM_ZERO_INIT bool useBurstDshot = false;
 #endif
+#ifdef USE_DSHOT_TELEMETRY
+FAST_RAM_ZERO_INIT bool useDshotTelemetry = false;
+#endif
 
 static void pwmOCConfig(TIM_TypeDef *tim, uint8_t channel, uint16_t value, uint8_t output)
 {
@@ -157,11 +166,27 @@ static FAST_CODE void pwmWriteDshot(uint8_t index, float value)
     pwmWriteDshotInt(index, lrintf(value));
 }
 
+#define DSHOT_NIBBLE(n, bit) (((n) & (0x8 >> (bit))) ? MOTOR_BIT_1 : MOTOR_BIT_0)
+#define DSHOT_NIBBLE_PULSES(n) { DSHOT_NIBBLE(n, 0), DSHOT_NIBBLE(n, 1), DSHOT_NIBBLE(n, 2), DSHOT_NIBBLE(n, 3) }
+
+// compare values for the four bits of each nibble, MSB first
+static const uint8_t dshotNibblePulses[16][4] = {
+    DSHOT_NIBBLE_PULSES(0x0), DSHOT_NIBBLE_PULSES(0x1), DSHOT_NIBBLE_PULSES(0x2), DSHOT_NIBBLE_PULSES(0x3),
+    DSHOT_NIBBLE_PULSES(0x4), DSHOT_NIBBLE_PULSES(0x5), DSHOT_NIBBLE_PULSES(0x6), DSHOT_NIBBLE_PULSES(0x7),
+    DSHOT_NIBBLE_PULSES(0x8), DSHOT_NIBBLE_PULSES(0x9), DSHOT_NIBBLE_PULSES(0xa), DSHOT_NIBBLE_PULSES(0xb),
+    DSHOT_NIBBLE_PULSES(0xc), DSHOT_NIBBLE_PULSES(0xd), DSHOT_NIBBLE_PULSES(0xe), DSHOT_NIBBLE_PULSES(0xf),
+};
+
 static FAST_CODE uint8_t loadDmaBufferDshot(uint32_t *dmaBuffer, int stride, uint16_t packet)
 {
-    for (int i = 0; i < 16; i++) {
-        dmaBuffer[i * stride] = (packet & 0x8000) ? MOTOR_BIT_1 : MOTOR_BIT_0;  // MSB first
-        packet <<= 1;
+    for (int i = 0; i < 4; i++) {
+        const uint8_t *pulses = dshotNibblePulses[packet >> 12];  // Most significant nibble first
+        dmaBuffer[0] = pulses[0];
+        dmaBuffer[stride] = pulses[1];
+        dmaBuffer[2 * stride] = pulses[2];
+        dmaBuffer[3 * stride] = pulses[3];
+        dmaBuffer += 4 * stride;
+        packet <<= 4;
     }
 
     return DSHOT_DMA_BUFFER_SIZE;
@@ -284,11 +309,36 @@ void motorDevInit(const motorDevConfig_t *motorConfig, uint16_t idlePulse, uint8
         if (motorConfig->useBurstDshot) {
             useBurstDshot = true;
         }
+#endif
+#ifdef USE_DSHOT_TELEMETRY
+        // replies are captured per channel, which burst mode does not support
+        useDshotTelemetry = motorConfig->useDshotTelemetry && !useBurstDshot;
+#endif
+#ifdef USE_DSHOT_BITBANG
+        // falls back to the timer outputs if the ports can not be paced
+        if (motorConfig->useDshotBitbang && dshotBitbangInit(motorConfig, motorCount)) {
+#ifdef USE_DSHOT_DMAR
+            useBurstDshot = false;
+#endif
+#ifdef USE_DSHOT_TELEMETRY
+            useDshotTelemetry = false;
+#endif
+        }
 #endif
         break;
 #endif
     }
 
+#ifdef USE_DSHOT_TELEMETRY
+    for (int motorIndex = 0; useDshotTelemetry && motorIndex < MAX_SUPPORTED_MOTORS && motorIndex < motorCount; motorIndex++) {
+        const timerHardware_t *timerHardware = timerGetByTag(motorConfig->ioTags[motorIndex]);
+        // input capture is not available on the complementary outputs
+        if (timerHardware && (timerHardware->output & TIMER_OUTPUT_N_CHANNEL)) {
+            useDshotTelemetry = false;
+        }
+    }
+#endif
+
     if (!isDshot) {
         pwmWrite = &pwmWriteStandard;
         pwmCompleteWrite = useUnsyncedPwm ? &pwmCompleteWriteUnused : &pwmCompleteOneshotMotorUpdate;
@@ -296,6 +346,17 @@ void motorDevInit(const motorDevConfig_t *motorConfig, uint16_t idlePulse, uint8
 
     for (int motorIndex = 0; motorIndex < MAX_SUPPORTED_MOTORS && motorIndex < motorCount; motorIndex++) {
         const ioTag_t tag = motorConfig->ioTags[motorIndex];
+
+#ifdef USE_DSHOT_BITBANG
+        if (useDshotBitbang) {
+            // the pins have been set up as plain outputs and need no timer
+            motors[motorIndex].io = IOGetByTag(tag);
+            getMotorDmaOutput(motorIndex)->configured = true;
+            motors[motorIndex].enabled = true;
+            continue;
+        }
+#endif
+
         const timerHardware_t *timerHardware = timerGetByTag(tag);
 
         if (timerHardware == NULL) {
@@ -403,19 +464,48 @@ bool allMotorsAreIdle(uint8_t motorCount)
 
 FAST_CODE bool pwmDshotCommandIsQueued(void)
 {
-    return dshotCommandControl.nextCommandAtUs;
+    return commandQueueHead != commandQueueTail;
+}
+
+static FAST_CODE dshotCommandControl_t *dshotCommandGetCurrent(void)
+{
+    return &commandQueue[commandQueueTail];
 }
 
 FAST_CODE bool pwmDshotCommandIsProcessing(void)
 {
-    return dshotCommandControl.nextCommandAtUs && !dshotCommandControl.waitingForIdle && dshotCommandControl.repeats > 0;
+    if (!pwmDshotCommandIsQueued()) {
+        return false;
+    }
+    const dshotCommandControl_t *command = dshotCommandGetCurrent();
+    return !command->waitingForIdle && command->repeats > 0;
+}
+
+static bool dshotCommandQueueUpdate(void)
+{
+    if (pwmDshotCommandIsQueued()) {
+        commandQueueTail = (commandQueueTail + 1) % (DSHOT_MAX_COMMANDS + 1);
+        return pwmDshotCommandIsQueued();
+    }
+    return false;
+}
+
+static dshotCommandControl_t *addCommand(void)
+{
+    const uint8_t newHead = (commandQueueHead + 1) % (DSHOT_MAX_COMMANDS + 1);
+    if (newHead == commandQueueTail) {
+        return NULL;
+    }
+    dshotCommandControl_t *control = &commandQueue[commandQueueHead];
+    commandQueueHead = newHead;
+    return control;
 }
 
 void pwmWriteDshotCommand(uint8_t index, uint8_t motorCount, uint8_t command, bool blocking)
 {
     timeUs_t timeNowUs = micros();
 
-    if (!isMotorProtocolDshot() || (command > DSHOT_MAX_COMMAND) || pwmDshotCommandIsQueued()) {
+    if (!isMotorProtocolDshot() || (command > DSHOT_MAX_COMMAND)) {
         return;
     }
 
@@ -444,6 +534,11 @@ void pwmWriteDshotCommand(uint8_t index, uint8_t motorCount, uint8_t command, bo
     }
 
     if (blocking) {
+        // only for the CLI, which has the motors disabled so the queue is not drained
+        if (pwmDshotCommandIsQueued()) {
+            return;
+        }
+
         delayMicroseconds(DSHOT_INITIAL_DELAY_US - DSHOT_COMMAND_DELAY_US);
         for (; repeats; repeats--) {
             delayMicroseconds(DSHOT_COMMAND_DELAY_US);
@@ -460,56 +555,73 @@ void pwmWriteDshotCommand(uint8_t index, uint8_t motorCount, uint8_t command, bo
         }
         delayMicroseconds(delayAfterCommandUs);
     } else {
-        dshotCommandControl.repeats = repeats;
-        dshotCommandControl.nextCommandAtUs = timeNowUs + DSHOT_INITIAL_DELAY_US;
-        dshotCommandControl.delayAfterCommandUs = delayAfterCommandUs;
-        for (unsigned i = 0; i < motorCount; i++) {
-            if (index == i || index == ALL_MOTORS) {
-                dshotCommandControl.command[i] = command;
-            } else {
-                dshotCommandControl.command[i] = command;
+        // the PID loop sends the queued commands, a preemptive one must not find a command that is only half filled in
+        SWI_ATOMIC_BLOCK {
+            const bool isFirstCommand = !pwmDshotCommandIsQueued();
+            dshotCommandControl_t *commandControl = addCommand();
+            if (!commandControl) {
+                return;
             }
-        }
 
-        dshotCommandControl.waitingForIdle = !allMotorsAreIdle(motorCount);
+            commandControl->repeats = repeats;
+            commandControl->delayAfterCommandUs = delayAfterCommandUs;
+            for (unsigned i = 0; i < motorCount; i++) {
+                if (index == i || index == ALL_MOTORS) {
+                    commandControl->command[i] = command;
+                } else {
+                    commandControl->command[i] = DSHOT_CMD_MOTOR_STOP;
+                }
+            }
+
+            // commands queued behind another one are started when it finishes
+            if (isFirstCommand) {
+                commandControl->nextCommandAtUs = timeNowUs + DSHOT_INITIAL_DELAY_US;
+                commandControl->waitingForIdle = !allMotorsAreIdle(motorCount);
+            }
+        }
     }
 }
 
 uint8_t pwmGetDshotCommand(uint8_t index)
 {
-    return dshotCommandControl.command[index];
+    return dshotCommandGetCurrent()->command[index];
 }
 
 FAST_CODE_NOINLINE bool pwmDshotCommandOutputIsEnabled(uint8_t motorCount)
 {
     timeUs_t timeNowUs = micros();
 
-    if (dshotCommandControl.waitingForIdle) {
+    dshotCommandControl_t *command = dshotCommandGetCurrent();
+
+    if (command->waitingForIdle) {
         if (allMotorsAreIdle(motorCount)) {
-            dshotCommandControl.nextCommandAtUs = timeNowUs + DSHOT_INITIAL_DELAY_US;
-            dshotCommandControl.waitingForIdle = false;
+            command->nextCommandAtUs = timeNowUs + DSHOT_INITIAL_DELAY_US;
+            command->waitingForIdle = false;
         }
 
         // Send normal motor output while waiting for motors to go idle
         return true;
     }
 
-    if (cmpTimeUs(timeNowUs, dshotCommandControl.nextCommandAtUs) < 0) {
+    if (cmpTimeUs(timeNowUs, command->nextCommandAtUs) < 0) {
         //Skip motor update because it isn't time yet for a new command
         return false;
-    }   
-  
+    }
+
     //Timed motor update happening with dshot command
-    if (dshotCommandControl.repeats > 0) {
-        dshotCommandControl.repeats--;
+    if (command->repeats > 0) {
+        command->repeats--;
 
-        if (dshotCommandControl.repeats > 0) {
-            dshotCommandControl.nextCommandAtUs = timeNowUs + DSHOT_COMMAND_DELAY_US;
+        if (command->repeats > 0) {
+            command->nextCommandAtUs = timeNowUs + DSHOT_COMMAND_DELAY_US;
         } else {
-            dshotCommandControl.nextCommandAtUs = timeNowUs + dshotCommandControl.delayAfterCommandUs;
+            command->nextCommandAtUs = timeNowUs + command->delayAfterCommandUs;
         }
-    } else {
-        dshotCommandControl.nextCommandAtUs = 0;
+    } else if (dshotCommandQueueUpdate()) {
+        // the delay after the previous command has passed, start the next one
+        command = dshotCommandGetCurrent();
+        command->nextCommandAtUs = timeNowUs + DSHOT_COMMAND_DELAY_US;
+        command->waitingForIdle = !allMotorsAreIdle(motorCount);
     }
 
     return true;
@@ -517,22 +629,92 @@ FAST_CODE_NOINLINE bool pwmDshotCommandOutputIsEnabled(uint8_t motorCount)
 
 FAST_CODE uint16_t prepareDshotPacket(motorDmaOutput_t *const motor)
 {
-    uint16_t packet = (motor->value << 1) | (motor->requestTelemetry ? 1 : 0);
-    motor->requestTelemetry = false;    // reset telemetry request to make sure it's triggered only once in a row
-
-    // compute checksum
-    int csum = 0;
-    int csum_data = packet;
-    for (int i = 0; i < 3; i++) {
-        csum ^=  csum_data;   // xor data by nibbles
-        csum_data >>= 4;
+    // test and clear in one go, the ESC sensor receive ISR can set the request any time
+    // and a request set between a separate read and reset would be lost until the timeout
+    const bool requestTelemetry = __atomic_exchange_n(&motor->requestTelemetry, false, __ATOMIC_RELAXED);
+    uint16_t packet = (motor->value << 1) | (requestTelemetry ? 1 : 0);
+
+    // compute checksum, xor data by nibbles
+    int csum = packet ^ (packet >> 4) ^ (packet >> 8);
+#ifdef USE_DSHOT_TELEMETRY
+    // the ESC only replies to packets with an inverted checksum
+    if (useDshotTelemetry) {
+        csum = ~csum;
     }
+#endif
     csum &= 0xf;
     // append checksum
     packet = (packet << 4) | csum;
 
     return packet;
 }
+
+#ifdef USE_DSHOT_TELEMETRY
+/*
+ * Decode the reply of a bidirectional DShot ESC from the timer counts of its edges.
+ * The timer runs at the DShot bit clock, so each 5/4 rate reply bit lasts 16 counts.
+ * Every edge marks a 1 in a 21 bit GCR word, giving 16 bits of period exponent,
+ * mantissa and checksum. Returns the eRPM in units of 100.
+ */
+FAST_CODE uint16_t decodeDshotTelemetryPacket(const uint32_t *buffer, uint8_t count)
+{
+    static const uint8_t gcrDecode[32] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 9, 10, 11, 0, 13, 14, 15,
+        0, 0, 2, 3, 0, 5, 6, 7, 0, 0, 8, 1, 0, 4, 12, 0
+    };
+
+    if (count < 2) {
+        return DSHOT_TELEMETRY_INVALID;
+    }
+
+    uint32_t value = 0;
+    int bits = 0;
+    for (int i = 1; i <= count && bits < 21; i++) {
+        int len;
+        if (i < count) {
+            const uint16_t counts = (uint16_t)(buffer[i] - buffer[i - 1]);
+            len = (counts + 8) / 16;
+            if (len < 1 || bits + len > 21) {
+                return DSHOT_TELEMETRY_INVALID;
+            }
+        } else {
+            // the line stays idle after the last edge
+            len = 21 - bits;
+        }
+        value <<= len;
+        value |= 1 << (len - 1);
+        bits += len;
+    }
+    if (bits != 21) {
+        return DSHOT_TELEMETRY_INVALID;
+    }
+
+    uint32_t decoded = 0;
+    for (int nibble = 0; nibble < 4; nibble++) {
+        decoded |= gcrDecode[(value >> (nibble * 5)) & 0x1f] << (nibble * 4);
+    }
+
+    uint32_t csum = decoded;
+    csum = csum ^ (csum >> 8);
+    csum = csum ^ (csum >> 4);
+    if ((csum & 0xf) != 0xf) {
+        return DSHOT_TELEMETRY_INVALID;
+    }
+
+    decoded >>= 4;
+    if (decoded == 0x0fff) {
+        // longest period the ESC can report, the motor is stopped
+        return 0;
+    }
+    // period in us, 9 bit mantissa shifted by a 3 bit exponent
+    const uint32_t periodUs = (decoded & 0x01ff) << ((decoded & 0x0e00) >> 9);
+    if (!periodUs) {
+        return DSHOT_TELEMETRY_INVALID;
+    }
+
+    return (1000000 * 60 / 100 + periodUs / 2) / periodUs;
+}
+#endif
 #endif
 
 #ifdef USE_SERVOS
@@ -567,8 +749,41 @@ void servoDevInit(const servoDevConfig_t *servoConfig)
             /* flag failure and disable ability to arm */
             break;
         }
-        pwmOutConfig(&servos[servoIndex].channel, timer, PWM_TIMER_1MHZ, PWM_TIMER_1MHZ / servoConfig->servoPwmRate, servoConfig->servoCenterPulse, 0);
+        // a timer that also drives motors keeps running free, restarting it would cut the motor pulses
+        bool servoSync = servoConfig->servoSync;
+        for (int i = 0; i < MAX_SUPPORTED_MOTORS; i++) {
+            if (motors[i].enabled && motors[i].channel.tim == timer->tim) {
+                servoSync = false;
+                break;
+            }
+        }
+
+        uint32_t period = PWM_TIMER_1MHZ / servoConfig->servoPwmRate;
+        if (servoSync) {
+            // the PID loop restarts the timer, the longer period only keeps it from
+            // putting out an extra pulse when a restart comes in a bit late
+            period = MIN(2 * period, 0xFFFFU);
+        }
+        pwmOutConfig(&servos[servoIndex].channel, timer, PWM_TIMER_1MHZ, period, servoConfig->servoCenterPulse, 0);
         servos[servoIndex].enabled = true;
+
+        servos[servoIndex].forceOverflow = servoSync;
+        for (int i = 0; i < servoIndex; i++) {
+            if (servos[i].channel.tim == servos[servoIndex].channel.tim) {
+                servos[servoIndex].forceOverflow = false;
+                break;
+            }
+        }
+    }
+}
+
+// Restart the servo timers, the new compare values are loaded and the pulses start right away
+void pwmCompleteServoUpdate(void)
+{
+    for (int servoIndex = 0; servoIndex < MAX_SUPPORTED_SERVOS; servoIndex++) {
+        if (servos[servoIndex].forceOverflow) {
+            timerForceOverflow(servos[servoIndex].channel.tim);
+        }
     }
 }
 
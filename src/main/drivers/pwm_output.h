@@ -110,6 +110,17 @@ typedef enum {
 #define DSHOT_DMA_BUFFER_SIZE   18 /* resolution + frame reset (2us) */
 #define PROSHOT_DMA_BUFFER_SIZE 6  /* resolution + frame reset (2us) */
 
+#ifdef USE_DSHOT_TELEMETRY
+#define DSHOT_TELEMETRY_INPUT_LEN   32      // edge timestamps captured per reply, a 21 bit reply has at most 21 edges
+#define DSHOT_TELEMETRY_INVALID     0xffff  // returned by the decoder for a missing or corrupt reply
+
+typedef struct dshotTelemetryData_s {
+    uint16_t erpm;          // 100 erpm, the same unit as escSensorData_t.rpm
+    uint16_t errorCount;    // replies that were missing or failed the checksum
+    uint8_t dataAge;        // motor updates since the last valid reply
+} dshotTelemetryData_t;
+#endif
+
 typedef struct {
     TIM_TypeDef *timer;
 #if defined(USE_DSHOT) && defined(USE_DSHOT_DMAR)
@@ -122,6 +133,9 @@ typedef struct {
     uint32_t dmaBurstBuffer[DSHOT_DMA_BUFFER_SIZE * 4];
 #endif
     uint16_t timerDmaSources;
+#ifdef USE_DSHOT_TELEMETRY
+    uint16_t outputPeriod;  // auto reload value while sending, the timer free runs while capturing replies
+#endif
 } motorDmaTimer_t;
 
 typedef struct {
@@ -139,6 +153,13 @@ typedef struct {
 #else
     uint8_t dmaBuffer[DSHOT_DMA_BUFFER_SIZE];
 #endif
+#ifdef USE_DSHOT_TELEMETRY
+    uint8_t output;
+    volatile bool isInput;                  // the channel is capturing the reply to the last packet
+    DMA_InitTypeDef dmaInitStruct;          // output configuration, restored after each reply
+    uint32_t dmaInputBuffer[DSHOT_TELEMETRY_INPUT_LEN];
+    dshotTelemetryData_t telemetry;
+#endif
 } motorDmaOutput_t;
 
 motorDmaOutput_t *getMotorDmaOutput(uint8_t index);
@@ -168,21 +189,28 @@ typedef struct motorDevConfig_s {
     uint8_t  motorPwmInversion;             // Active-High vs Active-Low. Useful for brushed FCs converted for brushless operation
     uint8_t  useUnsyncedPwm;
     uint8_t  useBurstDshot;
+    uint8_t  useDshotTelemetry;             // bidirectional DShot, the ESC replies to each packet with its eRPM
+    uint8_t  useDshotBitbang;               // DShot on plain GPIO, one DMA stream per port paced by one timer
     ioTag_t  ioTags[MAX_SUPPORTED_MOTORS];
 } motorDevConfig_t;
 
 extern bool useBurstDshot;
+#ifdef USE_DSHOT_TELEMETRY
+extern bool useDshotTelemetry;
+#endif
 
 void motorDevInit(const motorDevConfig_t *motorDevConfig, uint16_t idlePulse, uint8_t motorCount);
 
 typedef struct servoDevConfig_s {
     // PWM values, in milliseconds, common range is 1000-2000 (1ms to 2ms)
     uint16_t servoCenterPulse;              // This is the value for servos when they should be in the middle. e.g. 1500.
-    uint16_t servoPwmRate;                  // The update rate of servo outputs (50-498Hz)
+    uint16_t servoPwmRate;                  // The update rate of servo outputs (50-560Hz)
     ioTag_t  ioTags[MAX_SUPPORTED_SERVOS];
+    uint8_t  servoSync;                     // Start the servo pulses from the PID loop instead of a free running timer
 } servoDevConfig_t;
 
 void servoDevInit(const servoDevConfig_t *servoDevConfig);
+void pwmCompleteServoUpdate(void);
 
 void pwmServoConfig(const struct timerHardware_s *timerHardware, uint8_t servoIndex, uint16_t servoPwmRate, uint16_t servoCenterPulse);
 
@@ -207,6 +235,12 @@ bool pwmDshotCommandIsProcessing(void);
 uint8_t pwmGetDshotCommand(uint8_t index);
 bool pwmDshotCommandOutputIsEnabled(uint8_t motorCount);
 
+#ifdef USE_DSHOT_TELEMETRY
+uint16_t decodeDshotTelemetryPacket(const uint32_t *buffer, uint8_t count);
+bool isDshotTelemetryActive(void);
+const dshotTelemetryData_t *getDshotTelemetryData(uint8_t motorIndex);
+#endif
+
 #endif
 
 #ifdef USE_BEEPER
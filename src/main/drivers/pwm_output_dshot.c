@@ -27,6 +27,7 @@
 #ifdef USE_DSHOT
 
 #include "build/debug.h"
+#include "build/motor_timing.h"
 
 #include "drivers/io.h"
 #include "timer.h"
@@ -40,10 +41,11 @@
 #include "drivers/time.h"
 #include "dma.h"
 #include "rcc.h"
+#include "dshot_bitbang.h"
 
 static uint8_t dmaMotorTimerCount = 0;
 static motorDmaTimer_t dmaMotorTimers[MAX_DMA_TIMERS];
-static motorDmaOutput_t dmaMotors[MAX_SUPPORTED_MOTORS];
+static DMA_RAM motorDmaOutput_t dmaMotors[MAX_SUPPORTED_MOTORS];
 
 motorDmaOutput_t *getMotorDmaOutput(uint8_t index)
 {
@@ -61,6 +63,115 @@ uint8_t getTimerIndex(TIM_TypeDef *timer)
     return dmaMotorTimerCount - 1;
 }
 
+static void pwmDshotOutputChannelInit(const timerHardware_t *timerHardware, uint8_t output)
+{
+    TIM_TypeDef *timer = timerHardware->tim;
+    TIM_OCInitTypeDef TIM_OCInitStructure;
+
+    TIM_OCStructInit(&TIM_OCInitStructure);
+    TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_PWM1;
+    if (output & TIMER_OUTPUT_N_CHANNEL) {
+        TIM_OCInitStructure.TIM_OutputNState = TIM_OutputNState_Enable;
+        TIM_OCInitStructure.TIM_OCNIdleState = TIM_OCNIdleState_Reset;
+        TIM_OCInitStructure.TIM_OCNPolarity = (output & TIMER_OUTPUT_INVERTED) ? TIM_OCNPolarity_Low : TIM_OCNPolarity_High;
+    } else {
+        TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Enable;
+        TIM_OCInitStructure.TIM_OCIdleState = TIM_OCIdleState_Set;
+        TIM_OCInitStructure.TIM_OCPolarity =  (output & TIMER_OUTPUT_INVERTED) ? TIM_OCPolarity_Low : TIM_OCPolarity_High;
+    }
+    TIM_OCInitStructure.TIM_Pulse = 0;
+
+    timerOCInit(timer, timerHardware->channel, &TIM_OCInitStructure);
+    timerOCPreloadConfig(timer, timerHardware->channel, TIM_OCPreload_Enable);
+
+    if (output & TIMER_OUTPUT_N_CHANNEL) {
+        TIM_CCxNCmd(timer, timerHardware->channel, TIM_CCxN_Enable);
+    } else {
+        TIM_CCxCmd(timer, timerHardware->channel, TIM_CCx_Enable);
+    }
+}
+
+#ifdef USE_DSHOT_TELEMETRY
+bool isDshotTelemetryActive(void)
+{
+    return useDshotTelemetry;
+}
+
+const dshotTelemetryData_t *getDshotTelemetryData(uint8_t motorIndex)
+{
+    return &dmaMotors[motorIndex].telemetry;
+}
+
+/*
+ * Called once the packet is sent, captures the edges of the reply by DMA while the line is released
+ */
+static void pwmDshotSetDirectionInput(motorDmaOutput_t *const motor)
+{
+    const timerHardware_t *timerHardware = motor->timerHardware;
+    TIM_TypeDef *timer = timerHardware->tim;
+
+    // let the timer free run, so the reply can be timed from the edge timestamps
+    TIM_ARRPreloadConfig(timer, DISABLE);
+    TIM_SetAutoreload(timer, 0xffff);
+
+    TIM_ICInitTypeDef TIM_ICInitStructure;
+    TIM_ICStructInit(&TIM_ICInitStructure);
+    TIM_ICInitStructure.TIM_Channel = timerHardware->channel;
+    TIM_ICInitStructure.TIM_ICPolarity = TIM_ICPolarity_BothEdge;
+    TIM_ICInitStructure.TIM_ICSelection = TIM_ICSelection_DirectTI;
+    TIM_ICInitStructure.TIM_ICPrescaler = TIM_ICPSC_DIV1;
+    TIM_ICInitStructure.TIM_ICFilter = 2;
+    TIM_ICInit(timer, &TIM_ICInitStructure);
+
+    DMA_InitTypeDef DMA_InitStructure = motor->dmaInitStruct;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)motor->dmaInputBuffer;
+    DMA_InitStructure.DMA_BufferSize = DSHOT_TELEMETRY_INPUT_LEN;
+    // without the transfer complete interrupt, the number of edges is read back before the next packet
+    DMA_DeInit(timerHardware->dmaRef);
+    DMA_Init(timerHardware->dmaRef, &DMA_InitStructure);
+    DMA_Cmd(timerHardware->dmaRef, ENABLE);
+    TIM_DMACmd(timer, motor->timerDmaSource, ENABLE);
+
+    motor->isInput = true;
+}
+
+/*
+ * Decodes the captured reply and restores the output configuration for the next packet
+ */
+static FAST_CODE void pwmDshotProcessTelemetry(motorDmaOutput_t *const motor)
+{
+    const timerHardware_t *timerHardware = motor->timerHardware;
+    TIM_TypeDef *timer = timerHardware->tim;
+
+    TIM_DMACmd(timer, motor->timerDmaSource, DISABLE);
+    DMA_Cmd(timerHardware->dmaRef, DISABLE);
+
+    const uint8_t edgeCount = DSHOT_TELEMETRY_INPUT_LEN - DMA_GetCurrDataCounter(timerHardware->dmaRef);
+    const uint16_t erpm = decodeDshotTelemetryPacket(motor->dmaInputBuffer, edgeCount);
+    if (erpm != DSHOT_TELEMETRY_INVALID) {
+        motor->telemetry.erpm = erpm;
+        motor->telemetry.dataAge = 0;
+    } else {
+        motor->telemetry.errorCount++;
+        if (motor->telemetry.dataAge < UINT8_MAX) {
+            motor->telemetry.dataAge++;
+        }
+    }
+
+    TIM_SetAutoreload(timer, motor->timer->outputPeriod);
+    TIM_SetCounter(timer, 0);
+    TIM_ARRPreloadConfig(timer, ENABLE);
+    pwmDshotOutputChannelInit(timerHardware, motor->output);
+
+    DMA_DeInit(timerHardware->dmaRef);
+    DMA_Init(timerHardware->dmaRef, &motor->dmaInitStruct);
+    DMA_ITConfig(timerHardware->dmaRef, DMA_IT_TC, ENABLE);
+
+    motor->isInput = false;
+}
+#endif
+
 void pwmWriteDshotInt(uint8_t index, uint16_t value)
 {
     motorDmaOutput_t *const motor = &dmaMotors[index];
@@ -69,6 +180,12 @@ void pwmWriteDshotInt(uint8_t index, uint16_t value)
         return;
     }
 
+#ifdef USE_DSHOT_TELEMETRY
+    if (motor->isInput) {
+        pwmDshotProcessTelemetry(motor);
+    }
+#endif
+
     /*If there is a command ready to go overwrite the value and send that instead*/
     if (pwmDshotCommandIsProcessing()) {
         value = pwmGetDshotCommand(index);
@@ -80,6 +197,14 @@ void pwmWriteDshotInt(uint8_t index, uint16_t value)
     motor->value = value;
 
     uint16_t packet = prepareDshotPacket(motor);
+
+#ifdef USE_DSHOT_BITBANG
+    if (useDshotBitbang) {
+        dshotBitbangLoadPacket(index, packet);
+        return;
+    }
+#endif
+
     uint8_t bufferSize;
 
 #ifdef USE_DSHOT_DMAR
@@ -107,12 +232,26 @@ void pwmCompleteDshotMotorUpdate(uint8_t motorCount)
         }
     }
 
+#ifdef USE_DSHOT_BITBANG
+    if (useDshotBitbang) {
+        dshotBitbangUpdateStart();
+        return;
+    }
+#endif
+
+#ifdef USE_MOTOR_TIMING
+#ifdef USE_DSHOT_DMAR
+    motorTimingOutputStart(useBurstDshot ? dmaMotorTimerCount : motorCount);
+#else
+    motorTimingOutputStart(motorCount);
+#endif
+#endif
+
     for (int i = 0; i < dmaMotorTimerCount; i++) {
 #ifdef USE_DSHOT_DMAR
         if (useBurstDshot) {
             DMA_SetCurrDataCounter(dmaMotorTimers[i].dmaBurstRef, dmaMotorTimers[i].dmaBurstLength);
             DMA_Cmd(dmaMotorTimers[i].dmaBurstRef, ENABLE);
-            TIM_DMAConfig(dmaMotorTimers[i].timer, TIM_DMABase_CCR1, TIM_DMABurstLength_4Transfers);
             TIM_DMACmd(dmaMotorTimers[i].timer, TIM_DMA_Update, ENABLE);
         } else
 #endif
@@ -141,6 +280,16 @@ static void motor_DMA_IRQHandler(dmaChannelDescriptor_t *descriptor)
         }
 
         DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
+
+#ifdef USE_MOTOR_TIMING
+        motorTimingOutputComplete();
+#endif
+
+#ifdef USE_DSHOT_TELEMETRY
+        if (useDshotTelemetry) {
+            pwmDshotSetDirectionInput(motor);
+        }
+#endif
     }
 }
 
@@ -167,7 +316,6 @@ void pwmDshotMotorHardwareConfig(const timerHardware_t *timerHardware, uint8_t m
         return;
     }
 
-    TIM_OCInitTypeDef TIM_OCInitStructure;
     DMA_InitTypeDef DMA_InitStructure;
 
     motorDmaOutput_t * const motor = &dmaMotors[motorIndex];
@@ -183,6 +331,14 @@ void pwmDshotMotorHardwareConfig(const timerHardware_t *timerHardware, uint8_t m
     const uint8_t timerIndex = getTimerIndex(timer);
     const bool configureTimer = (timerIndex == dmaMotorTimerCount-1);
 
+#ifdef USE_DSHOT_TELEMETRY
+    if (useDshotTelemetry) {
+        // bidirectional DShot idles high, with the ESC pulling the line low to reply
+        output ^= TIMER_OUTPUT_INVERTED;
+    }
+    motor->output = output;
+#endif
+
     IOConfigGPIOAF(motorIO, IO_CONFIG(GPIO_Mode_AF, GPIO_Speed_50MHz, GPIO_OType_PP, GPIO_PuPd_UP), timerHardware->alternateFunction);
 
     if (configureTimer) {
@@ -200,27 +356,7 @@ void pwmDshotMotorHardwareConfig(const timerHardware_t *timerHardware, uint8_t m
         TIM_TimeBaseInit(timer, &TIM_TimeBaseStructure);
     }
 
-    TIM_OCStructInit(&TIM_OCInitStructure);
-    TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_PWM1;
-    if (output & TIMER_OUTPUT_N_CHANNEL) {
-        TIM_OCInitStructure.TIM_OutputNState = TIM_OutputNState_Enable;
-        TIM_OCInitStructure.TIM_OCNIdleState = TIM_OCNIdleState_Reset;
-        TIM_OCInitStructure.TIM_OCNPolarity = (output & TIMER_OUTPUT_INVERTED) ? TIM_OCNPolarity_Low : TIM_OCNPolarity_High;
-    } else {
-        TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Enable;
-        TIM_OCInitStructure.TIM_OCIdleState = TIM_OCIdleState_Set;
-        TIM_OCInitStructure.TIM_OCPolarity =  (output & TIMER_OUTPUT_INVERTED) ? TIM_OCPolarity_Low : TIM_OCPolarity_High;
-    }
-    TIM_OCInitStructure.TIM_Pulse = 0;
-
-    timerOCInit(timer, timerHardware->channel, &TIM_OCInitStructure);
-    timerOCPreloadConfig(timer, timerHardware->channel, TIM_OCPreload_Enable);
-
-    if (output & TIMER_OUTPUT_N_CHANNEL) {
-        TIM_CCxNCmd(timer, timerHardware->channel, TIM_CCxN_Enable);
-    } else {
-        TIM_CCxCmd(timer, timerHardware->channel, TIM_CCx_Enable);
-    }
+    pwmDshotOutputChannelInit(timerHardware, output);
 
     if (configureTimer) {
         TIM_CtrlPWMOutputs(timer, ENABLE);
@@ -229,6 +365,9 @@ void pwmDshotMotorHardwareConfig(const timerHardware_t *timerHardware, uint8_t m
     }
 
     motor->timer = &dmaMotorTimers[timerIndex];
+#ifdef USE_DSHOT_TELEMETRY
+    motor->timer->outputPeriod = pwmProtocolType == PWM_TYPE_PROSHOT1000 ? MOTOR_NIBBLE_LENGTH_PROSHOT : MOTOR_BITLENGTH;
+#endif
 
 #ifdef USE_DSHOT_DMAR
     if (useBurstDshot) {
@@ -254,6 +393,9 @@ void pwmDshotMotorHardwareConfig(const timerHardware_t *timerHardware, uint8_t m
         dmaInit(timerHardware->dmaTimUPIrqHandler, OWNER_TIMUP, timerGetTIMNumber(timerHardware->tim));
         dmaSetHandler(timerHardware->dmaTimUPIrqHandler, motor_DMA_IRQHandler, NVIC_BUILD_PRIORITY(1, 2), motorIndex);
 
+        // nothing else touches the burst registers, so set them up once instead of on every update
+        TIM_DMAConfig(timer, TIM_DMABase_CCR1, TIM_DMABurstLength_4Transfers);
+
 #if defined(STM32F3)
         DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)motor->timer->dmaBurstBuffer;
         DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
@@ -307,6 +449,9 @@ void pwmDshotMotorHardwareConfig(const timerHardware_t *timerHardware, uint8_t m
 
     DMA_Init(dmaRef, &DMA_InitStructure);
     DMA_ITConfig(dmaRef, DMA_IT_TC, ENABLE);
+#ifdef USE_DSHOT_TELEMETRY
+    motor->dmaInitStruct = DMA_InitStructure;
+#endif
 
     motor->configured = true;
 }
@@ -26,6 +26,8 @@
 
 #ifdef USE_DSHOT
 
+#include "build/motor_timing.h"
+
 #include "drivers/io.h"
 #include "timer.h"
 #include "pwm_output.h"
@@ -36,7 +38,7 @@
 
 static FAST_RAM_ZERO_INIT uint8_t dmaMotorTimerCount = 0;
 static FAST_RAM_ZERO_INIT motorDmaTimer_t dmaMotorTimers[MAX_DMA_TIMERS];
-static FAST_RAM_ZERO_INIT motorDmaOutput_t dmaMotors[MAX_SUPPORTED_MOTORS];
+static DMA_RAM motorDmaOutput_t dmaMotors[MAX_SUPPORTED_MOTORS];
 
 motorDmaOutput_t *getMotorDmaOutput(uint8_t index)
 {
@@ -100,14 +102,20 @@ FAST_CODE void pwmCompleteDshotMotorUpdate(uint8_t motorCount)
         }
     }
 
+#ifdef USE_MOTOR_TIMING
+#ifdef USE_DSHOT_DMAR
+    motorTimingOutputStart(useBurstDshot ? dmaMotorTimerCount : motorCount);
+#else
+    motorTimingOutputStart(motorCount);
+#endif
+#endif
+
     for (int i = 0; i < dmaMotorTimerCount; i++) {
 #ifdef USE_DSHOT_DMAR
         if (useBurstDshot) {
             LL_EX_DMA_SetDataLength(dmaMotorTimers[i].dmaBurstRef, dmaMotorTimers[i].dmaBurstLength);
             LL_EX_DMA_EnableStream(dmaMotorTimers[i].dmaBurstRef);
 
-            /* configure the DMA Burst Mode */
-            LL_TIM_ConfigDMABurst(dmaMotorTimers[i].timer, LL_TIM_DMABURST_BASEADDR_CCR1, LL_TIM_DMABURST_LENGTH_4TRANSFERS);
             /* Enable the TIM DMA Request */
             LL_TIM_EnableDMAReq_UPDATE(dmaMotorTimers[i].timer);
         } else
@@ -139,6 +147,10 @@ static void motor_DMA_IRQHandler(dmaChannelDescriptor_t* descriptor)
         }
 
         DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
+
+#ifdef USE_MOTOR_TIMING
+        motorTimingOutputComplete();
+#endif
     }
 }
 
@@ -249,6 +261,9 @@ void pwmDshotMotorHardwareConfig(const timerHardware_t *timerHardware, uint8_t m
         dmaInit(timerHardware->dmaTimUPIrqHandler, OWNER_TIMUP, timerGetTIMNumber(timerHardware->tim));
         dmaSetHandler(timerHardware->dmaTimUPIrqHandler, motor_DMA_IRQHandler, NVIC_BUILD_PRIORITY(1, 2), motorIndex);
 
+        /* configure the DMA Burst Mode once, nothing else touches it */
+        LL_TIM_ConfigDMABurst(timer, LL_TIM_DMABURST_BASEADDR_CCR1, LL_TIM_DMABURST_LENGTH_4TRANSFERS);
+
         dma_init.Channel = timerHardware->dmaTimUPChannel;
         dma_init.MemoryOrM2MDstAddress = (uint32_t)motor->timer->dmaBurstBuffer;
         dma_init.FIFOThreshold = LL_DMA_FIFOTHRESHOLD_FULL;
@@ -54,8 +54,10 @@
  */
 
 static volatile timeDelta_t hcsr04SonarPulseTravelTime = 0;
-static volatile timeMs_t lastMeasurementReceivedAt;
-static volatile int32_t lastCalculatedDistance = RANGEFINDER_OUT_OF_RANGE;
+static volatile bool hcsr04EchoReceived = false;
+static int32_t lastCalculatedDistance = RANGEFINDER_OUT_OF_RANGE;
+static bool newDistanceAvailable = false;
+static bool echoPending = false;
 static timeMs_t lastMeasurementStartedAt = 0;
 
 #ifdef USE_EXTI
@@ -71,13 +73,15 @@ void hcsr04_extiHandler(extiCallbackRec_t* cb)
     static timeUs_t timing_start;
     UNUSED(cb);
 
+    // both edges are timed here, so the pulse width doesn't depend on when the task runs
+    const timeUs_t now = micros();
     if (IORead(echoIO) != 0) {
-        timing_start = micros();
+        timing_start = now;
     } else {
-        const timeUs_t timing_stop = micros();
-        if (timing_stop > timing_start) {
-            lastMeasurementReceivedAt = millis();
-            hcsr04SonarPulseTravelTime = timing_stop - timing_start;
+        const timeDelta_t travelTime = cmpTimeUs(now, timing_start);
+        if (travelTime > 0) {
+            hcsr04SonarPulseTravelTime = travelTime;
+            hcsr04EchoReceived = true;
         }
     }
 }
@@ -110,16 +114,17 @@ void hcsr04_start_reading(void)
 #endif
 }
 
+/*
+ * Picks up the echo as soon as the interrupt has timed it and fires the next ping once the
+ * previous one had time to die down, so the ping rate doesn't depend on the task period.
+ */
 void hcsr04_update(rangefinderDev_t *dev)
 {
     UNUSED(dev);
     const timeMs_t timeNowMs = millis();
 
-    // the firing interval of the trigger signal should be greater than 60ms
-    // to avoid interference between consecutive measurements
-    if (timeNowMs > lastMeasurementStartedAt + HCSR04_MinimumFiringIntervalMs) {
-        // We should have a valid measurement within 60ms of trigger
-        if ((lastMeasurementReceivedAt - lastMeasurementStartedAt) <= HCSR04_MinimumFiringIntervalMs) {
+    if (echoPending) {
+        if (hcsr04EchoReceived) {
             // The speed of sound is 340 m/s or approx. 29 microseconds per centimeter.
             // The ping travels out and back, so to find the distance of the
             // object we take half of the distance traveled.
@@ -129,24 +134,37 @@ void hcsr04_update(rangefinderDev_t *dev)
             if (lastCalculatedDistance > HCSR04_MAX_RANGE_CM) {
                 lastCalculatedDistance = RANGEFINDER_OUT_OF_RANGE;
             }
-        }
-        else {
+            newDistanceAvailable = true;
+            echoPending = false;
+        } else if (timeNowMs - lastMeasurementStartedAt > HCSR04_MinimumFiringIntervalMs) {
             // No measurement within reasonable time - indicate failure
             lastCalculatedDistance = RANGEFINDER_HARDWARE_FAILURE;
+            newDistanceAvailable = true;
+            echoPending = false;
         }
+    }
 
-        // Trigger a new measurement
+    // the firing interval of the trigger signal should be greater than 60ms
+    // to avoid interference between consecutive measurements
+    if (!echoPending && timeNowMs - lastMeasurementStartedAt > HCSR04_MinimumFiringIntervalMs) {
+        hcsr04EchoReceived = false;
         lastMeasurementStartedAt = timeNowMs;
+        echoPending = true;
         hcsr04_start_reading();
     }
 }
 
 /**
  * Get the distance that was measured by the last pulse, in centimeters.
+ * Each measurement is reported once, RANGEFINDER_NO_NEW_DATA until the next one is complete.
  */
 int32_t hcsr04_get_distance(rangefinderDev_t *dev)
 {
     UNUSED(dev);
+    if (!newDistanceAvailable) {
+        return RANGEFINDER_NO_NEW_DATA;
+    }
+    newDistanceAvailable = false;
     return lastCalculatedDistance;
 }
 
@@ -25,7 +25,7 @@
 #include "drivers/rangefinder/rangefinder.h"
 #include "sensors/battery.h"
 
-#define RANGEFINDER_HCSR04_TASK_PERIOD_MS 70
+#define RANGEFINDER_HCSR04_TASK_PERIOD_MS 10  // the driver paces the pings itself, this is how soon an echo is picked up
 
 typedef struct sonarConfig_s {
     ioTag_t triggerTag;
@@ -76,4 +76,6 @@ const char * const ownerNames[OWNER_TOTAL_COUNT] = {
     "USB_MSC_PIN",
     "SPI_PREINIT_IPU",
     "SPI_PREINIT_OPU",
+    "MPU_DMA",
+    "FLASH_DMA",
 };
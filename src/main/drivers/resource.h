@@ -76,6 +76,8 @@ typedef enum {
     OWNER_USB_MSC_PIN,
     OWNER_SPI_PREINIT_IPU,
     OWNER_SPI_PREINIT_OPU,
+    OWNER_MPU_DMA,
+    OWNER_FLASH_DMA,
     OWNER_TOTAL_COUNT
 } resourceOwner_e;
 
@@ -31,19 +31,32 @@
 
 #include "build/build_config.h"
 
+#include "common/utils.h"
+
 #include "drivers/bus_spi.h"
+#include "drivers/exti.h"
 #include "drivers/io.h"
 #include "drivers/io_impl.h"
+#include "drivers/nvic.h"
 #include "drivers/rcc.h"
 #include "drivers/system.h"
+#include "drivers/time.h"
 
 #include "pg/rx_spi.h"
 
+#include "scheduler/scheduler.h"
+
 #include "rx_spi.h"
 
 static busDevice_t rxSpiDevice;
 static busDevice_t *busdev = &rxSpiDevice;
 
+#ifdef USE_EXTI
+static extiCallbackRec_t rxSpiExtiCallbackRec;
+static bool extiConfigured = false;
+static volatile timeUs_t lastExtiTimeUs;
+#endif
+
 #define DISABLE_RX()    {IOHi(busdev->busdev_u.spi.csnPin);}
 #define ENABLE_RX()     {IOLo(busdev->busdev_u.spi.csnPin);}
 
@@ -119,4 +132,48 @@ uint8_t rxSpiReadCommandMulti(uint8_t command, uint8_t commandData, uint8_t *ret
     DISABLE_RX();
     return ret;
 }
+
+#ifdef USE_EXTI
+static void rxSpiExtiHandler(extiCallbackRec_t *cb)
+{
+    UNUSED(cb);
+
+    lastExtiTimeUs = microsISR();
+#ifdef USE_TASK_SIGNAL
+    // the packet is read by TASK_RX, so have it run straight away rather than when it is next polled
+    schedulerSignalTask(TASK_RX);
+#endif
+}
+
+// Puts the radio's packet received line on an interrupt, the pin must already be initialised as an input.
+// Returns false if the target has no EXTI on the pin, the protocol then falls back to the polling time.
+bool rxSpiExtiInit(IO_t extiPin)
+{
+    if (!extiPin) {
+        return false;
+    }
+
+    EXTIHandlerInit(&rxSpiExtiCallbackRec, rxSpiExtiHandler);
+#if defined(STM32F7)
+    EXTIConfig(extiPin, &rxSpiExtiCallbackRec, NVIC_PRIO_RX_SPI_INT_EXTI, IO_CONFIG(GPIO_MODE_INPUT, 0, GPIO_NOPULL));
+#else
+    EXTIConfig(extiPin, &rxSpiExtiCallbackRec, NVIC_PRIO_RX_SPI_INT_EXTI, EXTI_Trigger_Rising);
+#endif
+    EXTIEnable(extiPin, true);
+    extiConfigured = true;
+
+    return true;
+}
+
+bool rxSpiExtiConfigured(void)
+{
+    return extiConfigured;
+}
+
+// time the packet received line last went active
+timeUs_t rxSpiGetLastExtiTimeUs(void)
+{
+    return lastExtiTimeUs;
+}
+#endif
 #endif
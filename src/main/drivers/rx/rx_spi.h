@@ -22,6 +22,10 @@
 
 #include <stdint.h>
 
+#include "common/time.h"
+
+#include "drivers/io_types.h"
+
 #define RX_SPI_MAX_PAYLOAD_SIZE 32
 
 struct rxSpiConfig_s;
@@ -33,3 +37,9 @@ uint8_t rxSpiWriteCommand(uint8_t command, uint8_t data);
 uint8_t rxSpiWriteCommandMulti(uint8_t command, const uint8_t *data, uint8_t length);
 uint8_t rxSpiReadCommand(uint8_t command, uint8_t commandData);
 uint8_t rxSpiReadCommandMulti(uint8_t command, uint8_t commandData, uint8_t *retData, uint8_t length);
+
+#ifdef USE_EXTI
+bool rxSpiExtiInit(IO_t extiPin);
+bool rxSpiExtiConfigured(void);
+timeUs_t rxSpiGetLastExtiTimeUs(void);
+#endif
@@ -68,7 +68,8 @@ typedef enum {
     SDCARD_STATE_SENDING_WRITE,
     SDCARD_STATE_WAITING_FOR_WRITE,
     SDCARD_STATE_WRITING_MULTIPLE_BLOCKS,
-    SDCARD_STATE_STOPPING_MULTIPLE_BLOCK_WRITE
+    SDCARD_STATE_STOPPING_MULTIPLE_BLOCK_WRITE,
+    SDCARD_STATE_READING_MULTIPLE_BLOCKS
 } sdcardState_e;
 
 typedef struct sdcard_t {
@@ -95,6 +96,9 @@ typedef struct sdcard_t {
     uint32_t multiWriteNextBlock;
     uint32_t multiWriteBlocksRemain;
 
+    uint32_t multiReadNextBlock;
+    bool multiReadInProgress; // The block being read in SDCARD_STATE_READING is part of a multi-block read
+
     sdcardState_e state;
 
     sdcardMetadata_t metadata;
@@ -637,7 +641,8 @@ static bool sdcard_setBlockLength(uint32_t blockLen)
  */
 static bool sdcard_isReady(void)
 {
-    return sdcard.state == SDCARD_STATE_READY || sdcard.state == SDCARD_STATE_WRITING_MULTIPLE_BLOCKS;
+    return sdcard.state == SDCARD_STATE_READY || sdcard.state == SDCARD_STATE_WRITING_MULTIPLE_BLOCKS
+        || sdcard.state == SDCARD_STATE_READING_MULTIPLE_BLOCKS;
 }
 
 /**
@@ -671,6 +676,45 @@ static sdcardOperationStatus_e sdcard_endWriteBlocks(void)
     }
 }
 
+/**
+ * Send the stop-transmission command to complete a multi-block read, discarding whatever block the card had begun
+ * to send.
+ *
+ * Returns true if the card is now in the SDCARD_STATE_READY state, or false if it failed to stop and has been reset.
+ */
+static bool sdcard_endReadBlocks(void)
+{
+    const uint8_t command[6] = {
+        0x40 | SDCARD_COMMAND_STOP_TRANSMISSION,
+        0, 0, 0, 0,
+        0x61 // CRC for CMD12 with a 0 argument
+    };
+    uint8_t status = 0xFF;
+
+    // The card will be streaming the next data block at us, so we can't wait for it to go idle before sending
+    spiTransfer(sdcard.instance, command, NULL, sizeof(command));
+
+    // The byte following CMD12 is a stuff byte, then the R1 response which always has its top bit clear
+    spiTransferByte(sdcard.instance, 0xFF);
+
+    for (int i = 0; i < SDCARD_MAXIMUM_BYTE_DELAY_FOR_CMD_REPLY && (status & 0x80); i++) {
+        status = spiTransferByte(sdcard.instance, 0xFF);
+    }
+
+    // The card may hold the line low (busy) for a little while after the response
+    bool stopped = status == 0 && sdcard_waitForIdle(SDCARD_MAXIMUM_BYTE_DELAY_FOR_CMD_REPLY);
+
+    sdcard_deselect();
+
+    if (stopped) {
+        sdcard.state = SDCARD_STATE_READY;
+    } else {
+        sdcard_reset();
+    }
+
+    return stopped;
+}
+
 /**
  * Call periodically for the SD card to perform in-progress transfers.
  *
@@ -897,9 +941,15 @@ bool sdcard_poll(void)
         case SDCARD_STATE_READING:
             switch (sdcard_receiveDataBlock(sdcard.pendingOperation.buffer, SDCARD_BLOCK_SIZE)) {
                 case SDCARD_RECEIVE_SUCCESS:
-                    sdcard_deselect();
+                    if (sdcard.multiReadInProgress) {
+                        // Leave the card selected, it'll begin preparing the following block for us
+                        sdcard.multiReadNextBlock++;
+                        sdcard.state = SDCARD_STATE_READING_MULTIPLE_BLOCKS;
+                    } else {
+                        sdcard_deselect();
 
-                    sdcard.state = SDCARD_STATE_READY;
+                        sdcard.state = SDCARD_STATE_READY;
+                    }
                     sdcard.failureCount = 0; // Assume the card is good if it can complete a read
 
 #ifdef SDCARD_PROFILING
@@ -1009,6 +1059,13 @@ sdcardOperationStatus_e sdcard_writeBlock(uint32_t blockIndex, uint8_t *buffer,
 
             // We're continuing a multi-block write
         break;
+        case SDCARD_STATE_READING_MULTIPLE_BLOCKS:
+            if (sdcard_endReadBlocks()) {
+                goto doMore;
+            } else {
+                return SDCARD_OPERATION_FAILURE;
+            }
+        break;
         case SDCARD_STATE_READY:
             // We're not continuing a multi-block write so we need to send a single-block write command
             sdcard_select();
@@ -1063,6 +1120,10 @@ sdcardOperationStatus_e sdcard_beginWriteBlocks(uint32_t blockIndex, uint32_t bl
             } else if (sdcard_endWriteBlocks() != SDCARD_OPERATION_SUCCESS) {
                 return SDCARD_OPERATION_BUSY;
             } // Else we've completed the previous multi-block write and can fall through to start the new one
+        } else if (sdcard.state == SDCARD_STATE_READING_MULTIPLE_BLOCKS) {
+            if (!sdcard_endReadBlocks()) {
+                return SDCARD_OPERATION_FAILURE;
+            }
         } else {
             return SDCARD_OPERATION_BUSY;
         }
@@ -1103,20 +1164,37 @@ sdcardOperationStatus_e sdcard_beginWriteBlocks(uint32_t blockIndex, uint32_t bl
  */
 bool sdcard_readBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData)
 {
+#ifdef SDCARD_PROFILING
+    sdcard.pendingOperation.profileStartTime = micros();
+#endif
+
     if (sdcard.state != SDCARD_STATE_READY) {
         if (sdcard.state == SDCARD_STATE_WRITING_MULTIPLE_BLOCKS) {
             if (sdcard_endWriteBlocks() != SDCARD_OPERATION_SUCCESS) {
                 return false;
             }
+        } else if (sdcard.state == SDCARD_STATE_READING_MULTIPLE_BLOCKS) {
+            if (blockIndex == sdcard.multiReadNextBlock) {
+                // Continue the multi-block read, the block is already on its way so no command is needed
+                sdcard.pendingOperation.buffer = buffer;
+                sdcard.pendingOperation.blockIndex = blockIndex;
+                sdcard.pendingOperation.callback = callback;
+                sdcard.pendingOperation.callbackData = callbackData;
+
+                sdcard.multiReadInProgress = true;
+                sdcard.state = SDCARD_STATE_READING;
+
+                sdcard.operationStartTime = millis();
+
+                return true;
+            } else if (!sdcard_endReadBlocks()) {
+                return false;
+            }
         } else {
             return false;
         }
     }
 
-#ifdef SDCARD_PROFILING
-    sdcard.pendingOperation.profileStartTime = micros();
-#endif
-
     sdcard_select();
 
     // Standard size cards use byte addressing, high capacity cards use block addressing
@@ -1128,6 +1206,7 @@ bool sdcard_readBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationComp
         sdcard.pendingOperation.callback = callback;
         sdcard.pendingOperation.callbackData = callbackData;
 
+        sdcard.multiReadInProgress = false;
         sdcard.state = SDCARD_STATE_READING;
 
         sdcard.operationStartTime = millis();
@@ -1142,6 +1221,55 @@ bool sdcard_readBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationComp
     }
 }
 
+/**
+ * Begin reading a series of consecutive blocks beginning at the given block index. The card streams the blocks to us
+ * back to back, so reading them with sdcard_readBlock() avoids a command round trip per block, and the card can
+ * prepare the next block while we are busy with the previous one.
+ *
+ * The read stays open until a non-consecutive block is read or a block is written, so it's okay to begin a long read
+ * and abandon it part way.
+ *
+ * Returns:
+ *     SDCARD_OPERATION_SUCCESS     - Multi-block read has begun
+ *     SDCARD_OPERATION_BUSY        - The card is already busy and cannot begin the read
+ *     SDCARD_OPERATION_FAILURE     - A fatal error occured, card will be reset
+ */
+sdcardOperationStatus_e sdcard_beginReadBlocks(uint32_t blockIndex)
+{
+    if (sdcard.state != SDCARD_STATE_READY) {
+        if (sdcard.state == SDCARD_STATE_READING_MULTIPLE_BLOCKS) {
+            if (blockIndex == sdcard.multiReadNextBlock) {
+                // Assume that the caller wants to continue the multi-block read they already have in progress!
+                return SDCARD_OPERATION_SUCCESS;
+            } else if (!sdcard_endReadBlocks()) {
+                return SDCARD_OPERATION_FAILURE;
+            }
+        } else if (sdcard.state == SDCARD_STATE_WRITING_MULTIPLE_BLOCKS) {
+            if (sdcard_endWriteBlocks() != SDCARD_OPERATION_SUCCESS) {
+                return SDCARD_OPERATION_BUSY;
+            }
+        } else {
+            return SDCARD_OPERATION_BUSY;
+        }
+    }
+
+    sdcard_select();
+
+    if (sdcard_sendCommand(SDCARD_COMMAND_READ_MULTIPLE_BLOCK, sdcard.highCapacity ? blockIndex : blockIndex * SDCARD_BLOCK_SIZE) == 0) {
+        sdcard.state = SDCARD_STATE_READING_MULTIPLE_BLOCKS;
+        sdcard.multiReadNextBlock = blockIndex;
+
+        // Leave the card selected
+        return SDCARD_OPERATION_SUCCESS;
+    } else {
+        sdcard_deselect();
+
+        sdcard_reset();
+
+        return SDCARD_OPERATION_FAILURE;
+    }
+}
+
 /**
  * Returns true if the SD card has successfully completed its startup procedures.
  */
@@ -60,6 +60,7 @@ typedef void(*sdcard_profilerCallback_c)(sdcardBlockOperation_e operation, uint3
 void sdcard_init(const sdcardConfig_t *config);
 
 bool sdcard_readBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData);
+sdcardOperationStatus_e sdcard_beginReadBlocks(uint32_t blockIndex);
 
 sdcardOperationStatus_e sdcard_beginWriteBlocks(uint32_t blockIndex, uint32_t blockCount);
 sdcardOperationStatus_e sdcard_writeBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData);
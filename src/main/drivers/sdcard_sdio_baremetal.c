@@ -50,30 +50,24 @@
 #define SDCARD_TIMEOUT_INIT_MILLIS      200
 #define SDCARD_MAX_CONSECUTIVE_FAILURES 8
 
-// Use this to speed up writing to SDCARD... asyncfatfs has limited support for multiblock write
-#define FATFS_BLOCK_CACHE_SIZE 16
-uint8_t writeCache[512 * FATFS_BLOCK_CACHE_SIZE] __attribute__ ((aligned (4)));
-uint32_t cacheCount = 0;
-
-void cache_write(uint8_t *buffer)
-{
-    if (cacheCount == sizeof(writeCache)) {
-        // Prevents overflow
-        return;
-    }
-    memcpy(&writeCache[cacheCount], buffer, 512);
-    cacheCount += 512;
-}
+/*
+ * Write-behind queue, used when sdio_use_cache is on. Sectors handed to sdcard_writeBlock() are copied here and
+ * reported as written straight away, and runs of consecutive sectors are sent to the card as one multi-block DMA
+ * transfer while the next ones queue up behind it. A run only leaves the queue once the card has committed it, and
+ * the queue is kept across a card reset and sent again, since afatfs has already been told those sectors are written.
+ */
+#ifndef SDCARD_SDIO_WRITE_QUEUE_SECTORS
+#define SDCARD_SDIO_WRITE_QUEUE_SECTORS 16
+#endif
 
-uint16_t cache_getCount(void)
-{
-    return (cacheCount / 512);
-}
-
-void cache_reset(void)
-{
-    cacheCount = 0;
-}
+static struct {
+    uint8_t buffer[SDCARD_SDIO_WRITE_QUEUE_SECTORS][SDCARD_BLOCK_SIZE] __attribute__ ((aligned (4)));
+    uint32_t blockIndex[SDCARD_SDIO_WRITE_QUEUE_SECTORS];
+    uint8_t head;       // next free slot
+    uint8_t tail;       // oldest queued sector
+    uint8_t count;      // queued sectors, including those in flight
+    uint8_t inFlight;   // sectors from the tail on that are being transferred
+} writeQueue;
 
 typedef enum {
     // In these states we run at the initialization 400kHz clockspeed:
@@ -128,6 +122,7 @@ typedef struct sdcard_t {
     dmaIdentifier_e dma;
     uint8_t dmaChannel;
     uint8_t useCache;
+    uint8_t readHoldPolls;  // a read was turned away, hold the write queue for this many polls so it can get in
 } sdcard_t;
 
 static sdcard_t sdcard;
@@ -171,6 +166,14 @@ bool sdcard_isFunctional(void)
     return sdcard.state != SDCARD_STATE_NOT_PRESENT;
 }
 
+static void sdcard_writeQueueReset(void)
+{
+    writeQueue.head = 0;
+    writeQueue.tail = 0;
+    writeQueue.count = 0;
+    writeQueue.inFlight = 0;
+}
+
 /**
  * Handle a failure of an SD card operation by resetting the card back to its initialization phase.
  *
@@ -179,9 +182,14 @@ bool sdcard_isFunctional(void)
  */
 static void sdcard_reset(void)
 {
+    // The run in flight may not have reached the card, so the whole queue goes out again once it is ready
+    writeQueue.inFlight = 0;
+
     if (SD_Init() != 0) {
         sdcard.failureCount++;
         if (sdcard.failureCount >= SDCARD_MAX_CONSECUTIVE_FAILURES || sdcard_isInserted() == SD_NOT_PRESENT) {
+            // The card is gone, and with it whatever was still queued
+            sdcard_writeQueueReset();
             sdcard.state = SDCARD_STATE_NOT_PRESENT;
         } else {
             sdcard.operationStartTime = millis();
@@ -303,6 +311,7 @@ void sdcard_init(const sdcardConfig_t *config)
     } else {
         sdcard.useCache = 0;
     }
+    sdcard_writeQueueReset();
     SD_Initialize_LL(dmaGetRefByIdentifier(sdcard.dma));
     if (SD_IsDetected()) {
         if (SD_Init() != 0) {
@@ -342,9 +351,6 @@ static bool sdcard_isReady()
 static sdcardOperationStatus_e sdcard_endWriteBlocks()
 {
     sdcard.multiWriteBlocksRemain = 0;
-    if (sdcard.useCache) {
-        cache_reset();
-    }
 
     // 8 dummy clocks to guarantee N_WR clocks between the last card response and this token
 
@@ -359,6 +365,68 @@ static sdcardOperationStatus_e sdcard_endWriteBlocks()
         return SDCARD_OPERATION_IN_PROGRESS;
     }
 }
+
+/**
+ * Start sending the oldest run of consecutive sectors in the write queue, if the card is free to take it.
+ */
+static void sdcard_writeQueueStart(void)
+{
+    if (sdcard.state != SDCARD_STATE_READY || writeQueue.count == 0 || sdcard.readHoldPolls) {
+        return;
+    }
+
+    // The run has to be consecutive on the card and contiguous in the queue memory for one DMA transfer
+    const uint8_t tail = writeQueue.tail;
+    const uint32_t blockIndex = writeQueue.blockIndex[tail];
+    uint8_t blockCount = 1;
+
+    while (blockCount < writeQueue.count && tail + blockCount < SDCARD_SDIO_WRITE_QUEUE_SECTORS
+        && writeQueue.blockIndex[tail + blockCount] == blockIndex + blockCount) {
+        blockCount++;
+    }
+
+#ifdef SDCARD_PROFILING
+    sdcard.pendingOperation.profileStartTime = micros();
+#endif
+
+    sdcard.pendingOperation.buffer = writeQueue.buffer[tail];
+    sdcard.pendingOperation.blockIndex = blockIndex;
+    sdcard.pendingOperation.callback = NULL;
+    sdcard.state = SDCARD_STATE_SENDING_WRITE;
+    writeQueue.inFlight = blockCount;
+
+    if (SD_WriteBlocks_DMA(blockIndex, (uint32_t*) writeQueue.buffer[tail], SDCARD_BLOCK_SIZE, blockCount) != SD_OK) {
+        sdcard_reset();
+    }
+}
+
+static bool sdcard_writeQueueContains(uint32_t blockIndex)
+{
+    for (int i = 0; i < writeQueue.count; i++) {
+        if (writeQueue.blockIndex[(writeQueue.tail + i) % SDCARD_SDIO_WRITE_QUEUE_SECTORS] == blockIndex) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static sdcardOperationStatus_e sdcard_writeQueuePush(uint32_t blockIndex, const uint8_t *buffer)
+{
+    if (sdcard.state < SDCARD_STATE_READY || writeQueue.count == SDCARD_SDIO_WRITE_QUEUE_SECTORS) {
+        return SDCARD_OPERATION_BUSY;
+    }
+
+    memcpy(writeQueue.buffer[writeQueue.head], buffer, SDCARD_BLOCK_SIZE);
+    writeQueue.blockIndex[writeQueue.head] = blockIndex;
+    writeQueue.head = (writeQueue.head + 1) % SDCARD_SDIO_WRITE_QUEUE_SECTORS;
+    writeQueue.count++;
+
+    sdcard_writeQueueStart();
+
+    return SDCARD_OPERATION_SUCCESS;
+}
+
 /**
  * Call periodically for the SD card to perform in-progress transfers.
  *
@@ -434,13 +502,17 @@ bool sdcard_poll(void)
 
                 sdcard.failureCount = 0; // Assume the card is good if it can complete a write
 
+                if (writeQueue.inFlight) {
+                    // The card has those sectors now, so their queue slots are free again
+                    writeQueue.tail = (writeQueue.tail + writeQueue.inFlight) % SDCARD_SDIO_WRITE_QUEUE_SECTORS;
+                    writeQueue.count -= writeQueue.inFlight;
+                    writeQueue.inFlight = 0;
+                }
+
                 // Still more blocks left to write in a multi-block chain?
                 if (sdcard.multiWriteBlocksRemain > 1) {
                     sdcard.multiWriteBlocksRemain--;
                     sdcard.multiWriteNextBlock++;
-                    if (sdcard.useCache) {
-                        cache_reset();
-                    }
                     sdcard.state = SDCARD_STATE_WRITING_MULTIPLE_BLOCKS;
                 } else if (sdcard.multiWriteBlocksRemain == 1) {
                     // This function changes the sd card state for us whether immediately succesful or delayed:
@@ -458,7 +530,8 @@ bool sdcard_poll(void)
                 /*
                  * The caller has already been told that their write has completed, so they will have discarded
                  * their buffer and have no hope of retrying the operation. But this should be very rare and it allows
-                 * them to reuse their buffer milliseconds faster than they otherwise would.
+                 * them to reuse their buffer milliseconds faster than they otherwise would. Queued writes are
+                 * still in the write queue and are sent again after the reset.
                  */
                 sdcard_reset();
                 goto doMore;
@@ -522,6 +595,16 @@ bool sdcard_poll(void)
         sdcard_reset();
     }
 
+    if (sdcard.useCache) {
+        if (sdcard.state == SDCARD_STATE_READY && sdcard.readHoldPolls) {
+            sdcard.readHoldPolls--;
+        }
+        sdcard_writeQueueStart();
+
+        // Writes can be queued while a transfer is in flight
+        return sdcard.state >= SDCARD_STATE_READY;
+    }
+
     return sdcard_isReady();
 }
 
@@ -541,6 +624,10 @@ bool sdcard_poll(void)
  */
 sdcardOperationStatus_e sdcard_writeBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData)
 {
+    if (sdcard.useCache) {
+        // Queued writes complete immediately, so the callback is never needed
+        return sdcard_writeQueuePush(blockIndex, buffer);
+    }
 
 #ifdef SDCARD_PROFILING
     sdcard.pendingOperation.profileStartTime = micros();
@@ -570,30 +657,12 @@ sdcardOperationStatus_e sdcard_writeBlock(uint32_t blockIndex, uint8_t *buffer,
     sdcard.pendingOperation.buffer = buffer;
     sdcard.pendingOperation.blockIndex = blockIndex;
 
-    uint16_t block_count = 1;
-    if ((cache_getCount() < FATFS_BLOCK_CACHE_SIZE) &&
-        (sdcard.multiWriteBlocksRemain != 0) && sdcard.useCache) {
-        cache_write(buffer);
-        if (cache_getCount() == FATFS_BLOCK_CACHE_SIZE || sdcard.multiWriteBlocksRemain == 1) {
-            //Relocate buffer
-            buffer = (uint8_t*)writeCache;
-            //Recalculate block index
-            blockIndex -= cache_getCount() - 1;
-            block_count = cache_getCount();
-        } else {
-            sdcard.multiWriteBlocksRemain--;
-            sdcard.multiWriteNextBlock++;
-            sdcard.state = SDCARD_STATE_READY;
-            return SDCARD_OPERATION_SUCCESS;
-        }
-    }
-
     sdcard.pendingOperation.callback = callback;
     sdcard.pendingOperation.callbackData = callbackData;
     sdcard.pendingOperation.chunkIndex = 1; // (for non-DMA transfers) we've sent chunk #0 already
     sdcard.state = SDCARD_STATE_SENDING_WRITE;
 
-    if (SD_WriteBlocks_DMA(blockIndex, (uint32_t*) buffer, 512, block_count) != SD_OK) {
+    if (SD_WriteBlocks_DMA(blockIndex, (uint32_t*) buffer, 512, 1) != SD_OK) {
         /* Our write was rejected! This could be due to a bad address but we hope not to attempt that, so assume
          * the card is broken and needs reset.
          */
@@ -624,6 +693,11 @@ sdcardOperationStatus_e sdcard_writeBlock(uint32_t blockIndex, uint8_t *buffer,
  */
 sdcardOperationStatus_e sdcard_beginWriteBlocks(uint32_t blockIndex, uint32_t blockCount)
 {
+    if (sdcard.useCache) {
+        // The write queue finds the runs of consecutive blocks itself
+        return sdcard.state >= SDCARD_STATE_READY ? SDCARD_OPERATION_SUCCESS : SDCARD_OPERATION_BUSY;
+    }
+
     if (sdcard.state != SDCARD_STATE_READY) {
         if (sdcard.state == SDCARD_STATE_WRITING_MULTIPLE_BLOCKS) {
             if (blockIndex == sdcard.multiWriteNextBlock) {
@@ -657,6 +731,19 @@ sdcardOperationStatus_e sdcard_beginWriteBlocks(uint32_t blockIndex, uint32_t bl
  */
 bool sdcard_readBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData)
 {
+    if (sdcard.useCache) {
+        if (sdcard_writeQueueContains(blockIndex)) {
+            // The card's copy is stale until the queue has drained past it
+            sdcard.readHoldPolls = 0;
+            return false;
+        }
+        if (sdcard.state != SDCARD_STATE_READY) {
+            sdcard.readHoldPolls = 2;
+            return false;
+        }
+        sdcard.readHoldPolls = 0;
+    }
+
     if (sdcard.state != SDCARD_STATE_READY) {
 		if (sdcard.state == SDCARD_STATE_WRITING_MULTIPLE_BLOCKS) {
 			if (sdcard_endWriteBlocks() != SDCARD_OPERATION_SUCCESS) {
@@ -699,6 +786,17 @@ bool sdcard_readBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationComp
     }
 }
 
+/**
+ * Begin reading a series of consecutive blocks. Reads are single DMA transfers on SDIO with no per-block command
+ * overhead worth avoiding, so this only reports whether the card could accept a read.
+ */
+sdcardOperationStatus_e sdcard_beginReadBlocks(uint32_t blockIndex)
+{
+    UNUSED(blockIndex);
+
+    return sdcard.state == SDCARD_STATE_READY ? SDCARD_OPERATION_SUCCESS : SDCARD_OPERATION_BUSY;
+}
+
 /**
  * Returns true if the SD card has successfully completed its startup procedures.
  */
@@ -107,6 +107,13 @@ void serialSetBaudRateCb(serialPort_t *serialPort, void (*cb)(serialPort_t *cont
     }
 }
 
+void serialSetRxFrameCallback(serialPort_t *instance, serialReceiveFrameCallbackPtr rxFrameCallback)
+{
+    // Only drivers that receive by DMA deliver whole frames, everything else keeps using the per byte rxCallback.
+    // The frame callback shares rxCallbackData with the per byte callback.
+    instance->rxFrameCallback = rxFrameCallback;
+}
+
 void serialWriteBufShim(void *instance, const uint8_t *data, int count)
 {
     serialWriteBuf((serialPort_t *)instance, data, count);
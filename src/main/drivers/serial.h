@@ -56,6 +56,8 @@ typedef enum {
 #define CTRL_LINE_STATE_RTS (1 << 1)
 
 typedef void (*serialReceiveCallbackPtr)(uint16_t data, void *rxCallbackData);   // used by serial drivers to return frames to app
+// used by DMA RX serial drivers to hand over contiguous runs of received bytes, frameEnd is set once the line goes idle
+typedef void (*serialReceiveFrameCallbackPtr)(const uint8_t *data, uint32_t length, bool frameEnd, void *rxCallbackData);
 
 typedef struct serialPort_s {
 
@@ -76,6 +78,7 @@ typedef struct serialPort_s {
     uint32_t txBufferTail;
 
     serialReceiveCallbackPtr rxCallback;
+    serialReceiveFrameCallbackPtr rxFrameCallback;
     void *rxCallbackData;
 
     uint8_t identifier;
@@ -131,6 +134,7 @@ void serialSetBaudRate(serialPort_t *instance, uint32_t baudRate);
 void serialSetMode(serialPort_t *instance, portMode_e mode);
 void serialSetCtrlLineStateCb(serialPort_t *instance, void (*cb)(void *context, uint16_t ctrlLineState), void *context);
 void serialSetBaudRateCb(serialPort_t *instance, void (*cb)(serialPort_t *context, uint32_t baud), serialPort_t *context);
+void serialSetRxFrameCallback(serialPort_t *instance, serialReceiveFrameCallbackPtr rxFrameCallback);
 bool isSerialTransmitBufferEmpty(const serialPort_t *instance);
 void serialPrint(serialPort_t *instance, const char *str);
 uint32_t serialGetBaudRate(serialPort_t *instance);
@@ -40,6 +40,9 @@
 #include "drivers/pwm_output.h"
 #include "drivers/serial.h"
 #include "drivers/serial_escserial.h"
+#ifdef USE_ESCSERIAL_UART
+#include "drivers/serial_uart.h"
+#endif
 #include "drivers/time.h"
 #include "drivers/timer.h"
 
@@ -923,6 +926,128 @@ static bool processExitCommand(uint8_t c)
 }
 
 
+static uint32_t escSerialBaudRate(uint8_t mode)
+{
+    switch (mode) {
+        case PROTOCOL_KISS:
+            return BAUDRATE_KISS;
+        case PROTOCOL_CASTLE:
+            return BAUDRATE_CASTLE;
+        default:
+            return BAUDRATE_NORMAL;
+    }
+}
+
+// Index of the output in timerHardware, -1 if there is none
+static int escSerialTimerIndex(uint16_t output)
+{
+    uint8_t first_output = 0;
+    for (unsigned i = 0; i < USABLE_TIMER_CHANNEL_COUNT; i++) {
+        if (timerHardware[i].usageFlags & TIM_USE_MOTOR) {
+            first_output = i;
+            break;
+        }
+    }
+
+    //doesn't work with messy timertable
+    const int index = first_output + output;
+
+    return index < USABLE_TIMER_CHANNEL_COUNT ? index : -1;
+}
+
+#ifdef USE_ESCSERIAL_UART
+static int escUart = -1;    // UARTDevice_e the passthrough runs on, -1 for escserial
+static uartPins_t escUartPins;
+
+// A UART that is not open and can drive the pin of the output, -1 if there is none
+static int escSerialFindUart(uint16_t output, uint8_t mode)
+{
+    // the other protocols have their own timing, or drive several ESCs at once
+    const int index = mode == PROTOCOL_BLHELI ? escSerialTimerIndex(output) : -1;
+    if (index < 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < SERIAL_PORT_COUNT; i++) {
+        const serialPortIdentifier_e identifier = serialPortIdentifiers[i];
+        if (identifier < SERIAL_PORT_USART1 || identifier > SERIAL_PORT_USART8) {
+            continue;
+        }
+
+        const serialPortUsage_t *usage = findSerialPortUsageByIdentifier(identifier);
+        if (usage && !usage->serialPort && uartCanDriveTxPin(SERIAL_PORT_IDENTIFIER_TO_UARTDEV(identifier), timerHardware[index].tag)) {
+            return SERIAL_PORT_IDENTIFIER_TO_UARTDEV(identifier);
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * The UART takes the motor pin in single wire half duplex. It receives the bytes it sends, which makes the loopback
+ * the BLHeli bootloader protocol expects, and spares the per bit interrupts and their jitter of escserial.
+ */
+static serialPort_t *openEscUart(uint16_t output, uint8_t motorOutput, uint32_t baud, uint8_t mode)
+{
+    escUart = escSerialFindUart(output, mode);
+    if (escUart < 0 || !uartRemapTxPin(escUart, timerHardware[motorOutput].tag, &escUartPins)) {
+        escUart = -1;
+        return NULL;
+    }
+
+    serialPort_t *port = uartOpen(escUart, NULL, NULL, baud, MODE_RXTX, SERIAL_BIDIR);
+    if (!port) {
+        uartRestorePins(escUart, &escUartPins);
+        escUart = -1;
+        return NULL;
+    }
+    delay(50);
+
+    return port;
+}
+#endif
+
+static bool isEscOnUart(void)
+{
+#ifdef USE_ESCSERIAL_UART
+    return escUart >= 0;
+#else
+    return false;
+#endif
+}
+
+static void closeEscPort(uint8_t motorOutput, uint8_t mode)
+{
+#ifdef USE_ESCSERIAL_UART
+    if (isEscOnUart()) {
+        // the UART is left running, but no longer connected to the pin
+        IOConfigGPIO(IOGetByTag(timerHardware[motorOutput].tag), IOCFG_IPU);
+        uartRestorePins(escUart, &escUartPins);
+        escUart = -1;
+        return;
+    }
+#else
+    UNUSED(motorOutput);
+#endif
+
+    closeEscSerial(ESCSERIAL1, mode);
+}
+
+uint32_t escSerialGetLink(uint16_t output, uint8_t mode, int *uart)
+{
+#ifdef USE_ESCSERIAL_UART
+    *uart = escSerialFindUart(output, mode);
+    if (*uart >= 0) {
+        return uartAchievableBaudRate(*uart, escSerialBaudRate(mode));
+    }
+#else
+    UNUSED(output);
+    *uart = -1;
+#endif
+
+    return escSerialBaudRate(mode);
+}
+
 void escEnablePassthrough(serialPort_t *escPassthroughPort, uint16_t output, uint8_t mode)
 {
     bool exitEsc = false;
@@ -933,40 +1058,27 @@ void escEnablePassthrough(serialPort_t *escPassthroughPort, uint16_t output, uin
     pwmDisableMotors();
     passPort = escPassthroughPort;
 
-    uint32_t escBaudrate;
-    switch (mode) {
-        case PROTOCOL_KISS:
-            escBaudrate = BAUDRATE_KISS;
-            break;
-        case PROTOCOL_CASTLE:
-            escBaudrate = BAUDRATE_CASTLE;
-            break;
-        default:
-            escBaudrate = BAUDRATE_NORMAL;
-            break;
-    }
+    const uint32_t escBaudrate = escSerialBaudRate(mode);
 
     if ((mode == PROTOCOL_KISS) && (output == 255)) {
         motor_output = 255;
         mode = PROTOCOL_KISSALL;
     }
     else {
-        uint8_t first_output = 0;
-        for (unsigned i = 0; i < USABLE_TIMER_CHANNEL_COUNT; i++) {
-            if (timerHardware[i].usageFlags & TIM_USE_MOTOR) {
-                first_output = i;
-                break;
-            }
-        }
-
-        //doesn't work with messy timertable
-        motor_output = first_output + output;
-        if (motor_output >= USABLE_TIMER_CHANNEL_COUNT) {
+        const int index = escSerialTimerIndex(output);
+        if (index < 0) {
             return;
         }
+        motor_output = index;
     }
 
-    escPort = openEscSerial(ESCSERIAL1, NULL, motor_output, escBaudrate, 0, mode);
+    escPort = NULL;
+#ifdef USE_ESCSERIAL_UART
+    escPort = openEscUart(output, motor_output, escBaudrate, mode);
+#endif
+    if (!escPort) {
+        escPort = openEscSerial(ESCSERIAL1, NULL, motor_output, escBaudrate, 0, mode);
+    }
 
     if (!escPort) {
         return;
@@ -1000,10 +1112,10 @@ void escEnablePassthrough(serialPort_t *escPassthroughPort, uint16_t output, uin
                     serialWrite(escPassthroughPort, 0x00);
                     serialWrite(escPassthroughPort, 0xF4);
                     serialWrite(escPassthroughPort, 0xF4);
-                    closeEscSerial(ESCSERIAL1, mode);
+                    closeEscPort(motor_output, mode);
                     return;
                 }
-                if (mode==PROTOCOL_BLHELI) {
+                if (mode==PROTOCOL_BLHELI && !isEscOnUart()) {
                     serialWrite(escPassthroughPort, ch); // blheli loopback
                 }
                 serialWrite(escPort, ch);
@@ -38,6 +38,8 @@ typedef enum {
 
 // serialPort API
 void escEnablePassthrough(serialPort_t *escPassthroughPort, uint16_t output, uint8_t mode);
+// Baud rate the ESC of the output is reached at, through a hardware UART (`uart` set to its UARTDevice_e) or escserial (-1)
+uint32_t escSerialGetLink(uint16_t output, uint8_t mode, int *uart);
 
 typedef struct escSerialConfig_s {
     ioTag_t ioTag;
@@ -37,6 +37,7 @@
 
 #include "common/utils.h"
 
+#include "drivers/dma.h"
 #include "drivers/nvic.h"
 #include "drivers/io.h"
 #include "timer.h"
@@ -63,6 +64,14 @@ typedef enum {
 #define ICPOLARITY_RISING true
 #define ICPOLARITY_FALLING false
 
+#if defined(USE_SOFTSERIAL_RX_DMA) && !defined(USE_HAL_DRIVER)
+#define SOFTSERIAL_RX_DMA
+// Edge timestamps captured by DMA between two reads of the port, 10 per byte at most
+#define RX_DMA_EDGES 256
+// Resolution of the free running capture timer
+#define RX_DMA_TICKS_PER_BIT 16
+#endif
+
 typedef struct softSerial_s {
     serialPort_t     port;
 
@@ -86,6 +95,8 @@ typedef struct softSerial_s {
 
     uint8_t          isTransmittingData;
     int8_t           bitsLeftToTransmit;
+    uint8_t          txGapBits;         // idle bit times after each byte
+    uint8_t          txGapBitsLeft;
 
     uint16_t         internalTxBuffer;  // includes start and stop bits
     uint16_t         internalRxBuffer;  // includes start and stop bits
@@ -98,6 +109,17 @@ typedef struct softSerial_s {
 
     timerOvrHandlerRec_t overCb;
     timerCCHandlerRec_t edgeCb;
+
+#ifdef SOFTSERIAL_RX_DMA
+    // Both edges of the RX pin are captured into a ring, the bytes are decoded when the port is read
+    bool             rxDma;
+    volatile bool    rxDmaRestarted;
+    uint16_t         rxDmaTail;
+    uint16_t         rxStartAt;
+    uint32_t         rxBitTicks;        // 1/256 capture timer ticks
+    dmaChannelDescriptor_t *rxDmaDescriptor;
+    volatile uint16_t rxDmaBuffer[RX_DMA_EDGES];
+#endif
 } softSerial_t;
 
 static const struct serialPortVTable softSerialVTable; // Forward
@@ -129,6 +151,94 @@ static void serialEnableCC(softSerial_t *softSerial)
 #endif
 }
 
+#ifdef SOFTSERIAL_RX_DMA
+static bool serialRxDmaInit(softSerial_t *softSerial)
+{
+    const timerHardware_t *timerHardware = softSerial->timerHardware;
+
+    // The bytes are decoded when the port is read, a receive callback would only be called from there
+    if (!(softSerial->port.mode & MODE_RX) || softSerial->port.rxCallback || !timerHardware->dmaRef) {
+        return false;
+    }
+
+    // The free running capture timer can not be the bit clock of a full duplex transmitter
+    if ((softSerial->port.mode & MODE_TX) && !(softSerial->port.options & SERIAL_BIDIR) && softSerial->timerMode != TIMER_MODE_DUAL) {
+        return false;
+    }
+
+    const dmaIdentifier_e dmaIdentifier = dmaGetIdentifier(timerHardware->dmaRef);
+    if (dmaGetOwner(dmaIdentifier) != OWNER_FREE) {
+        return false;
+    }
+
+    dmaInit(dmaIdentifier, OWNER_SERIAL_RX, RESOURCE_INDEX(softSerial->softSerialPortIndex + RESOURCE_SOFT_OFFSET));
+    softSerial->rxDmaDescriptor = dmaGetDescriptorByIdentifier(dmaIdentifier);
+
+    DMA_InitTypeDef DMA_InitStructure;
+
+    DMA_DeInit(timerHardware->dmaRef);
+    DMA_StructInit(&DMA_InitStructure);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)timerCCR(timerHardware->tim, timerHardware->channel);
+    DMA_InitStructure.DMA_BufferSize = RX_DMA_EDGES;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+#if defined(STM32F4)
+    DMA_InitStructure.DMA_Channel = timerHardware->dmaChannel;
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)softSerial->rxDmaBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+#else
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)softSerial->rxDmaBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+#endif
+    DMA_Init(timerHardware->dmaRef, &DMA_InitStructure);
+
+    return true;
+}
+
+static void serialRxDmaStart(softSerial_t *softSerial)
+{
+    const timerHardware_t *timerHardware = softSerial->timerHardware;
+    TIM_TypeDef *tim = timerHardware->tim;
+
+    // No bit clock interrupts while receiving, the timer runs free so that the captures of a byte
+    // can be told apart
+    timerChConfigCallbacks(timerHardware, NULL, NULL);
+    configTimeBase(tim, 0, softSerial->port.baudRate * RX_DMA_TICKS_PER_BIT);
+    softSerial->rxBitTicks = timerClock(tim) / (tim->PSC + 1) * 256 / softSerial->port.baudRate;
+
+    TIM_ICInitTypeDef TIM_ICInitStructure;
+
+    TIM_ICStructInit(&TIM_ICInitStructure);
+    TIM_ICInitStructure.TIM_Channel = timerHardware->channel;
+    TIM_ICInitStructure.TIM_ICPolarity = TIM_ICPolarity_BothEdge;
+    TIM_ICInitStructure.TIM_ICSelection = TIM_ICSelection_DirectTI;
+    TIM_ICInitStructure.TIM_ICPrescaler = TIM_ICPSC_DIV1;
+    TIM_ICInit(tim, &TIM_ICInitStructure);
+
+    DMA_Cmd(timerHardware->dmaRef, DISABLE);
+#if defined(STM32F4)
+    while (DMA_GetCmdStatus(timerHardware->dmaRef) != DISABLE);
+#endif
+    DMA_CLEAR_FLAG(softSerial->rxDmaDescriptor, DMA_IT_TCIF | DMA_IT_HTIF | DMA_IT_TEIF);
+    DMA_SetCurrDataCounter(timerHardware->dmaRef, RX_DMA_EDGES);
+    DMA_Cmd(timerHardware->dmaRef, ENABLE);
+    TIM_DMACmd(tim, timerDmaSource(timerHardware->channel), ENABLE);
+
+    softSerial->rxDmaRestarted = true;
+}
+
+static void serialRxDmaStop(softSerial_t *softSerial)
+{
+    TIM_DMACmd(softSerial->timerHardware->tim, timerDmaSource(softSerial->timerHardware->channel), DISABLE);
+    DMA_Cmd(softSerial->timerHardware->dmaRef, DISABLE);
+}
+#endif
+
 static void serialInputPortActivate(softSerial_t *softSerial)
 {
     if (softSerial->port.options & SERIAL_INVERTED) {
@@ -147,6 +257,14 @@ static void serialInputPortActivate(softSerial_t *softSerial)
 #endif
     }
 
+#ifdef SOFTSERIAL_RX_DMA
+    if (softSerial->rxDma) {
+        serialRxDmaStart(softSerial);
+        softSerial->rxActive = true;
+        return;
+    }
+#endif
+
     softSerial->rxActive = true;
     softSerial->isSearchingForStartBit = true;
     softSerial->rxBitIndex = 0;
@@ -166,6 +284,12 @@ static void serialInputPortDeActivate(softSerial_t *softSerial)
     TIM_CCxCmd(softSerial->timerHardware->tim, softSerial->timerHardware->channel, TIM_CCx_Disable);
 #endif
 
+#ifdef SOFTSERIAL_RX_DMA
+    if (softSerial->rxDma) {
+        serialRxDmaStop(softSerial);
+    }
+#endif
+
     IOConfigGPIO(softSerial->rxIO, IOCFG_IN_FLOATING);
     softSerial->rxActive = false;
 }
@@ -308,6 +432,7 @@ serialPort_t *openSoftSerial(softSerialPortIndex_e portIndex, serialReceiveCallb
 
     softSerial->rxActive = false;
     softSerial->isTransmittingData = false;
+    softSerial->txGapBits = 0;
 
     // Configure master timer (on RX); time base and input capture
 
@@ -337,6 +462,10 @@ serialPort_t *openSoftSerial(softSerialPortIndex_e portIndex, serialReceiveCallb
     softSerial->timerHandle = timerFindTimerHandle(softSerial->timerHardware->tim);
 #endif
 
+#ifdef SOFTSERIAL_RX_DMA
+    softSerial->rxDma = serialRxDmaInit(softSerial);
+#endif
+
     if (!(options & SERIAL_BIDIR)) {
         serialOutputPortActivate(softSerial);
         setTxSignal(softSerial, ENABLE);
@@ -376,6 +505,7 @@ void processTxState(softSerial_t *softSerial)
         // build internal buffer, MSB = Stop Bit (1) + data bits (MSB to LSB) + start bit(0) LSB
         softSerial->internalTxBuffer = (1 << (TX_TOTAL_BITS - 1)) | (byteToSend << 1);
         softSerial->bitsLeftToTransmit = TX_TOTAL_BITS;
+        softSerial->txGapBitsLeft = softSerial->txGapBits;
         softSerial->isTransmittingData = true;
 
         if (softSerial->rxActive && (softSerial->port.options & SERIAL_BIDIR)) {
@@ -401,6 +531,12 @@ void processTxState(softSerial_t *softSerial)
         return;
     }
 
+    if (softSerial->txGapBitsLeft) {
+        // the line stays at the level of the stop bit
+        softSerial->txGapBitsLeft--;
+        return;
+    }
+
     softSerial->isTransmittingData = false;
 }
 
@@ -434,6 +570,16 @@ void prepareForNextRxByte(softSerial_t *softSerial)
 #define STOP_BIT_MASK (1 << 0)
 #define START_BIT_MASK (1 << (RX_TOTAL_BITS - 1))
 
+static void storeRxByte(softSerial_t *softSerial, uint8_t rxByte)
+{
+    if (softSerial->port.rxCallback) {
+        softSerial->port.rxCallback(rxByte, softSerial->port.rxCallbackData);
+    } else {
+        softSerial->port.rxBuffer[softSerial->port.rxBufferHead] = rxByte;
+        softSerial->port.rxBufferHead = (softSerial->port.rxBufferHead + 1) % softSerial->port.rxBufferSize;
+    }
+}
+
 void extractAndStoreRxByte(softSerial_t *softSerial)
 {
     if ((softSerial->port.mode & MODE_RX) == 0) {
@@ -450,12 +596,7 @@ void extractAndStoreRxByte(softSerial_t *softSerial)
 
     uint8_t rxByte = (softSerial->internalRxBuffer >> 1) & 0xFF;
 
-    if (softSerial->port.rxCallback) {
-        softSerial->port.rxCallback(rxByte, softSerial->port.rxCallbackData);
-    } else {
-        softSerial->port.rxBuffer[softSerial->port.rxBufferHead] = rxByte;
-        softSerial->port.rxBufferHead = (softSerial->port.rxBufferHead + 1) % softSerial->port.rxBufferSize;
-    }
+    storeRxByte(softSerial, rxByte);
 }
 
 void processRxState(softSerial_t *softSerial)
@@ -490,6 +631,11 @@ void onSerialTimerOverflow(timerOvrHandlerRec_t *cbRec, captureCompare_t capture
     if (self->port.mode & MODE_TX)
         processTxState(self);
 
+#ifdef SOFTSERIAL_RX_DMA
+    if (self->rxDma)
+        return;
+#endif
+
     if (self->port.mode & MODE_RX)
         processRxState(self);
 }
@@ -555,6 +701,171 @@ void onSerialRxPinChange(timerCCHandlerRec_t *cbRec, captureCompare_t capture)
 #endif
 }
 
+#ifdef SOFTSERIAL_RX_DMA
+/*
+ * Captured edge decoding.
+ * Both edges are captured, as the line changes level on each of them LEADING means the line
+ * is at mark after the last edge and TRAILING that it is at space. Bit 0 of internalRxBuffer is
+ * the start bit.
+ */
+
+static void serialRxDmaFillBits(softSerial_t *softSerial, uint8_t toBit)
+{
+    if (toBit <= softSerial->rxBitIndex) {
+        return;
+    }
+
+    if (softSerial->rxEdge == LEADING) {
+        for (uint8_t bitToSet = softSerial->rxBitIndex; bitToSet < toBit; bitToSet++) {
+            softSerial->internalRxBuffer |= 1 << bitToSet;
+        }
+    }
+    softSerial->rxBitIndex = toBit;
+}
+
+static void serialRxDmaEndByte(softSerial_t *softSerial)
+{
+    serialRxDmaFillBits(softSerial, RX_TOTAL_BITS);
+    softSerial->isSearchingForStartBit = true;
+
+    const bool haveStartBit = (softSerial->internalRxBuffer & (1 << 0)) == 0;
+    const bool haveStopBit = (softSerial->internalRxBuffer & (1 << (RX_TOTAL_BITS - 1))) != 0;
+
+    if (!haveStartBit || !haveStopBit) {
+        softSerial->receiveErrors++;
+        return;
+    }
+
+    storeRxByte(softSerial, (softSerial->internalRxBuffer >> 1) & 0xFF);
+}
+
+static void serialRxDmaEdge(softSerial_t *softSerial, uint16_t capture)
+{
+    if (!softSerial->isSearchingForStartBit) {
+        const uint32_t elapsed = (uint32_t)(uint16_t)(capture - softSerial->rxStartAt) * 256;
+
+        // Edges before the middle of the stop bit are on a bit boundary of this byte
+        if (elapsed < softSerial->rxBitTicks * (2 * RX_TOTAL_BITS - 1) / 2) {
+            serialRxDmaFillBits(softSerial, (elapsed + softSerial->rxBitTicks / 2) / softSerial->rxBitTicks);
+            softSerial->rxEdge = (softSerial->rxEdge == LEADING) ? TRAILING : LEADING;
+            return;
+        }
+
+        serialRxDmaEndByte(softSerial);
+    }
+
+    if (softSerial->rxEdge == TRAILING) {
+        // The line returns to mark after a missing stop bit or a break
+        softSerial->rxEdge = LEADING;
+        return;
+    }
+
+    softSerial->rxStartAt = capture;
+    softSerial->rxBitIndex = 0;
+    softSerial->internalRxBuffer = 0;
+    softSerial->rxEdge = TRAILING;
+    softSerial->isSearchingForStartBit = false;
+}
+
+// Whether the ring position moving from `from` to `to` passes the half way point and the end
+static uint32_t serialRxDmaCrossedFlags(uint16_t from, uint16_t to)
+{
+    const uint16_t moved = (to - from + RX_DMA_EDGES) % RX_DMA_EDGES;
+    const uint16_t half = (from < RX_DMA_EDGES / 2) ? RX_DMA_EDGES / 2 : RX_DMA_EDGES + RX_DMA_EDGES / 2;
+    uint32_t flags = 0;
+    if (from + moved >= half) {
+        flags |= DMA_IT_HTIF;
+    }
+    if (from + moved >= RX_DMA_EDGES) {
+        flags |= DMA_IT_TCIF;
+    }
+    return flags;
+}
+
+// The position the DMA writes next. Returns false if the DMA has gone round the ring past the decoder
+// since the last call: the half and full transfer flags then show a pass the position alone does not.
+static bool serialRxDmaHead(softSerial_t *softSerial, uint16_t *head)
+{
+    const timerHardware_t *timerHardware = softSerial->timerHardware;
+    const dmaChannelDescriptor_t *descriptor = softSerial->rxDmaDescriptor;
+
+    // retried until the flags and the position are taken between the same two passes
+    while (true) {
+        const uint16_t before = (RX_DMA_EDGES - DMA_GetCurrDataCounter(timerHardware->dmaRef)) % RX_DMA_EDGES;
+        uint32_t flags = 0;
+        if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_HTIF)) {
+            flags |= DMA_IT_HTIF;
+        }
+        if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TCIF)) {
+            flags |= DMA_IT_TCIF;
+        }
+        DMA_CLEAR_FLAG(descriptor, flags);
+        *head = (RX_DMA_EDGES - DMA_GetCurrDataCounter(timerHardware->dmaRef)) % RX_DMA_EDGES;
+        if (!serialRxDmaCrossedFlags(before, *head)) {
+            return (flags & ~serialRxDmaCrossedFlags(softSerial->rxDmaTail, *head)) == 0;
+        }
+    }
+}
+
+static void serialRxDmaDecode(softSerial_t *softSerial)
+{
+    if (!softSerial->rxDma || !softSerial->rxActive) {
+        return;
+    }
+
+    // Read the time first, edges captured after it must not end the byte early
+    const uint16_t now = TIM_GetCounter(softSerial->timerHardware->tim);
+
+    // a half duplex port turning back to receive restarts the DMA from the bit timer interrupt
+    uint16_t head;
+    bool overrun;
+    ATOMIC_BLOCK(NVIC_PRIO_TIMER) {
+        if (softSerial->rxDmaRestarted) {
+            softSerial->rxDmaRestarted = false;
+            softSerial->rxDmaTail = 0;
+            softSerial->isSearchingForStartBit = true;
+            softSerial->rxEdge = LEADING;
+        }
+        overrun = !serialRxDmaHead(softSerial, &head);
+    }
+
+    if (overrun) {
+        // the edges since the last call are lost, start again from the level the line is at now
+        softSerial->receiveErrors++;
+        softSerial->rxDmaTail = head;
+        softSerial->isSearchingForStartBit = true;
+        const bool lineHigh = IORead(softSerial->rxIO) != 0;
+        const bool lineAtMark = (softSerial->port.options & SERIAL_INVERTED) ? !lineHigh : lineHigh;
+        softSerial->rxEdge = lineAtMark ? LEADING : TRAILING;
+    }
+
+    while (softSerial->rxDmaTail != head) {
+        serialRxDmaEdge(softSerial, softSerial->rxDmaBuffer[softSerial->rxDmaTail]);
+        softSerial->rxDmaTail = (softSerial->rxDmaTail + 1) % RX_DMA_EDGES;
+    }
+
+    // A byte ending in mark has no edge after its last data bit
+    if (!softSerial->isSearchingForStartBit) {
+        const int16_t elapsed = now - softSerial->rxStartAt;
+        if (elapsed > 0 && (uint32_t)elapsed * 256 >= softSerial->rxBitTicks * (2 * RX_TOTAL_BITS - 1) / 2) {
+            serialRxDmaEndByte(softSerial);
+        }
+    }
+}
+
+// Half duplex ports listen without a bit clock, the first byte written starts it again
+static void serialRxDmaStartTx(softSerial_t *softSerial)
+{
+    ATOMIC_BLOCK(NVIC_PRIO_TIMER) {
+        if (softSerial->rxActive) {
+            serialInputPortDeActivate(softSerial);
+            serialOutputPortActivate(softSerial);
+            serialTimerConfigureTimebase(softSerial->timerHardware, softSerial->port.baudRate);
+            timerChConfigCallbacks(softSerial->timerHardware, NULL, &softSerial->overCb);
+        }
+    }
+}
+#endif
 
 /*
  * Standard serial driver API
@@ -568,6 +879,10 @@ uint32_t softSerialRxBytesWaiting(const serialPort_t *instance)
 
     softSerial_t *s = (softSerial_t *)instance;
 
+#ifdef SOFTSERIAL_RX_DMA
+    serialRxDmaDecode(s);
+#endif
+
     return (s->port.rxBufferHead - s->port.rxBufferTail) & (s->port.rxBufferSize - 1);
 }
 
@@ -609,6 +924,13 @@ void softSerialWriteByte(serialPort_t *s, uint8_t ch)
 
     s->txBuffer[s->txBufferHead] = ch;
     s->txBufferHead = (s->txBufferHead + 1) % s->txBufferSize;
+
+#ifdef SOFTSERIAL_RX_DMA
+    softSerial_t *softSerial = (softSerial_t *)s;
+    if (softSerial->rxDma && (s->options & SERIAL_BIDIR)) {
+        serialRxDmaStartTx(softSerial);
+    }
+#endif
 }
 
 void softSerialSetBaudRate(serialPort_t *s, uint32_t baudRate)
@@ -617,9 +939,24 @@ void softSerialSetBaudRate(serialPort_t *s, uint32_t baudRate)
 
     softSerial->port.baudRate = baudRate;
 
+#ifdef SOFTSERIAL_RX_DMA
+    if (softSerial->rxDma && softSerial->rxActive) {
+        serialRxDmaStart(softSerial);
+        return;
+    }
+#endif
+
     serialTimerConfigureTimebase(softSerial->timerHardware, baudRate);
 }
 
+// Spaces the bytes sent by `bits` idle bit times, for protocols with an inter byte delay. The bit timer makes the gaps.
+void softSerialSetTxGap(serialPort_t *instance, uint8_t bits)
+{
+    softSerial_t *softSerial = (softSerial_t *)instance;
+
+    softSerial->txGapBits = bits;
+}
+
 void softSerialSetMode(serialPort_t *instance, portMode_e mode)
 {
     instance->mode = mode;
@@ -44,6 +44,14 @@ static const struct serialPortVTable tcpVTable; // Forward
 static tcpPort_t tcpSerialPorts[SERIAL_PORT_COUNT];
 static bool tcpPortInitialized[SERIAL_PORT_COUNT];
 static bool tcpStart = false;
+static uint16_t tcpPortOffset;
+
+// moves the ports of all UARTs on, so that several instances can run on one host
+void tcpSetPortOffset(uint16_t offset)
+{
+    tcpPortOffset = offset;
+}
+
 bool tcpIsStart(void) {
     return tcpStart;
 }
@@ -53,25 +61,42 @@ static void onData(dyad_Event *e) {
 }
 static void onClose(dyad_Event *e) {
     tcpPort_t* s = (tcpPort_t*)(e->udata);
-    s->clientCount--;
-    s->conn = NULL;
-    fprintf(stderr, "[CLS]UART%u: %d,%d\n", s->id + 1, s->connected, s->clientCount);
+    pthread_mutex_lock(&s->txLock);
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (s->clients[i] == e->stream) {
+            s->clients[i] = NULL;
+            s->clientCount--;
+        }
+    }
     if (s->clientCount == 0) {
         s->connected = false;
     }
+    pthread_mutex_unlock(&s->txLock);
+    fprintf(stderr, "[CLS]UART%u: %d,%d\n", s->id + 1, s->connected, s->clientCount);
 }
 static void onAccept(dyad_Event *e) {
     tcpPort_t* s = (tcpPort_t*)(e->udata);
     fprintf(stderr, "New connection on UART%u, %d\n", s->id + 1, s->clientCount);
 
-    s->connected = true;
-    if (s->clientCount > 0) {
+    pthread_mutex_lock(&s->txLock);
+    int slot = -1;
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (!s->clients[i]) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        pthread_mutex_unlock(&s->txLock);
         dyad_close(e->remote);
         return;
     }
+    s->clients[slot] = e->remote;
     s->clientCount++;
+    s->connected = true;
+    pthread_mutex_unlock(&s->txLock);
+
     fprintf(stderr, "[NEW]UART%u: %d,%d\n", s->id + 1, s->connected, s->clientCount);
-    s->conn = e->remote;
     dyad_setNoDelay(e->remote, 1);
     dyad_setTimeout(e->remote, 120);
     dyad_addListener(e->remote, DYAD_EVENT_DATA, onData, e->udata);
@@ -101,15 +126,18 @@ static tcpPort_t* tcpReconfigure(tcpPort_t *s, int id)
     s->connected = false;
     s->clientCount = 0;
     s->id = id;
-    s->conn = NULL;
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        s->clients[i] = NULL;
+    }
     s->serv = dyad_newStream();
     dyad_setNoDelay(s->serv, 1);
     dyad_addListener(s->serv, DYAD_EVENT_ACCEPT, onAccept, s);
 
-    if (dyad_listenEx(s->serv, NULL, BASE_PORT + id + 1, 10) == 0) {
-        fprintf(stderr, "bind port %u for UART%u\n", (unsigned)BASE_PORT + id + 1, (unsigned)id + 1);
+    const unsigned port = BASE_PORT + tcpPortOffset + id + 1;
+    if (dyad_listenEx(s->serv, NULL, port, 10) == 0) {
+        fprintf(stderr, "bind port %u for UART%u\n", port, (unsigned)id + 1);
     } else {
-        fprintf(stderr, "bind port %u for UART%u failed!!\n", (unsigned)BASE_PORT + id + 1, (unsigned)id + 1);
+        fprintf(stderr, "bind port %u for UART%u failed!!\n", port, (unsigned)id + 1);
     }
     return s;
 }
@@ -204,42 +232,90 @@ uint8_t tcpRead(serialPort_t *instance)
     return ch;
 }
 
-void tcpWrite(serialPort_t *instance, uint8_t ch)
+// Writes only queue the data. The queue is sent as one block once per tcp thread update (see tcpDataOutAll()), at the
+// end of a beginWrite()/endWrite() frame, or as soon as it fills up, rather than one segment per byte.
+static bool tcpQueue(tcpPort_t *s, uint8_t ch)
 {
-    tcpPort_t *s = (tcpPort_t *)instance;
-    pthread_mutex_lock(&s->txLock);
-
     s->port.txBuffer[s->port.txBufferHead] = ch;
     if (s->port.txBufferHead + 1 >= s->port.txBufferSize) {
         s->port.txBufferHead = 0;
     } else {
         s->port.txBufferHead++;
     }
+
+    return (s->port.txBufferHead + 1) % s->port.txBufferSize == s->port.txBufferTail;
+}
+
+void tcpWrite(serialPort_t *instance, uint8_t ch)
+{
+    tcpPort_t *s = (tcpPort_t *)instance;
+    pthread_mutex_lock(&s->txLock);
+    const bool full = tcpQueue(s, ch);
     pthread_mutex_unlock(&s->txLock);
 
-    tcpDataOut(s);
+    if (full) {
+        tcpDataOut(s);
+    }
+}
+
+static void tcpWriteBuf(serialPort_t *instance, const void *data, int count)
+{
+    tcpPort_t *s = (tcpPort_t *)instance;
+    const uint8_t *p = data;
+
+    while (count--) {
+        pthread_mutex_lock(&s->txLock);
+        const bool full = tcpQueue(s, *p++);
+        pthread_mutex_unlock(&s->txLock);
+
+        if (full) {
+            tcpDataOut(s);
+        }
+    }
+}
+
+static void tcpEndWrite(serialPort_t *instance)
+{
+    tcpDataOut((tcpPort_t *)instance);
+}
+
+static void tcpSend(tcpPort_t *s, const uint8_t *data, int count)
+{
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (s->clients[i]) {
+            dyad_write(s->clients[i], (const void *)data, count);
+        }
+    }
 }
 
 void tcpDataOut(tcpPort_t *instance)
 {
     tcpPort_t *s = (tcpPort_t *)instance;
-    if (s->conn == NULL) return;
     pthread_mutex_lock(&s->txLock);
 
     if (s->port.txBufferHead < s->port.txBufferTail) {
         // send data till end of buffer
         int chunk = s->port.txBufferSize - s->port.txBufferTail;
-        dyad_write(s->conn, (const void *)&s->port.txBuffer[s->port.txBufferTail], chunk);
+        tcpSend(s, (const uint8_t *)&s->port.txBuffer[s->port.txBufferTail], chunk);
         s->port.txBufferTail = 0;
     }
     int chunk = s->port.txBufferHead - s->port.txBufferTail;
     if (chunk)
-        dyad_write(s->conn, (const void*)&s->port.txBuffer[s->port.txBufferTail], chunk);
+        tcpSend(s, (const uint8_t *)&s->port.txBuffer[s->port.txBufferTail], chunk);
     s->port.txBufferTail = s->port.txBufferHead;
 
     pthread_mutex_unlock(&s->txLock);
 }
 
+void tcpDataOutAll(void)
+{
+    for (int id = 0; id < SERIAL_PORT_COUNT; id++) {
+        if (tcpPortInitialized[id]) {
+            tcpDataOut(&tcpSerialPorts[id]);
+        }
+    }
+}
+
 void tcpDataIn(tcpPort_t *instance, uint8_t* ch, int size)
 {
     tcpPort_t *s = (tcpPort_t *)instance;
@@ -268,7 +344,7 @@ static const struct serialPortVTable tcpVTable = {
         .setMode = NULL,
         .setCtrlLineStateCb = NULL,
         .setBaudRateCb = NULL,
-        .writeBuf = NULL,
+        .writeBuf = tcpWriteBuf,
         .beginWrite = NULL,
-        .endWrite = NULL,
+        .endWrite = tcpEndWrite,
 };
@@ -26,6 +26,7 @@
 
 #define RX_BUFFER_SIZE    1400
 #define TX_BUFFER_SIZE    1400
+#define TCP_MAX_CLIENTS   4
 
 typedef struct {
     serialPort_t port;
@@ -33,7 +34,7 @@ typedef struct {
     uint8_t txBuffer[TX_BUFFER_SIZE];
 
     dyad_Stream *serv;
-    dyad_Stream *conn;
+    dyad_Stream *clients[TCP_MAX_CLIENTS]; // output goes to every client, input from all of them is merged
     pthread_mutex_t txLock;
     pthread_mutex_t rxLock;
     bool connected;
@@ -46,7 +47,9 @@ serialPort_t *serTcpOpen(int id, serialReceiveCallbackPtr rxCallback, void *rxCa
 // tcpPort API
 void tcpDataIn(tcpPort_t *instance, uint8_t* ch, int size);
 void tcpDataOut(tcpPort_t *instance);
+void tcpDataOutAll(void);
 
+void tcpSetPortOffset(uint16_t offset);
 bool tcpIsStart(void);
 bool* tcpGetUsed(void);
 tcpPort_t* tcpGetPool(void);
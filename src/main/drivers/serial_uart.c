@@ -33,6 +33,7 @@
 #include "build/build_config.h"
 #include "build/atomic.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/dma.h"
@@ -151,10 +152,11 @@ static uint32_t uartTotalRxBytesWaiting(const serialPort_t *instance)
     if (s->rxDMAChannel) {
         uint32_t rxDMAHead = s->rxDMAChannel->CNDTR;
 #endif
-        if (rxDMAHead >= s->rxDMAPos) {
-            return rxDMAHead - s->rxDMAPos;
+        // rxDMAPos and rxDMAHead are distances from the end of the buffer, so they count down as they advance
+        if (s->rxDMAPos >= rxDMAHead) {
+            return s->rxDMAPos - rxDMAHead;
         } else {
-            return s->port.rxBufferSize + rxDMAHead - s->rxDMAPos;
+            return s->port.rxBufferSize + s->rxDMAPos - rxDMAHead;
         }
     }
 
@@ -246,16 +248,51 @@ static uint8_t uartRead(serialPort_t *instance)
     return ch;
 }
 
-static void uartWrite(serialPort_t *instance, uint8_t ch)
+#ifdef STM32F4
+/*
+ * Hand everything the RX DMA has received so far to the receive callback. This is called from the IDLE line and
+ * the RX DMA half/complete transfer interrupts, so the parser gets a whole frame in one go rather than taking an
+ * interrupt for every byte.
+ *
+ * A frame callback is given the bytes straight out of the DMA buffer, at most two runs when the buffer wraps, with
+ * frameEnd set on the last run delivered from the IDLE line.
+ */
+void uartRxDMADeliver(uartPort_t *s, bool idle)
 {
-    uartPort_t *s = (uartPort_t *)instance;
-    s->port.txBuffer[s->port.txBufferHead] = ch;
-    if (s->port.txBufferHead + 1 >= s->port.txBufferSize) {
-        s->port.txBufferHead = 0;
-    } else {
-        s->port.txBufferHead++;
+    if (s->port.rxFrameCallback) {
+        uint32_t waiting = uartTotalRxBytesWaiting(&s->port);
+        if (!waiting && idle) {
+            s->port.rxFrameCallback(NULL, 0, true, s->port.rxCallbackData);
+        }
+        while (waiting) {
+            // rxDMAPos counts down to the end of the buffer, so it is also the length of the run up to the wrap
+            const uint32_t length = MIN(waiting, s->rxDMAPos);
+            const uint8_t *data = (const uint8_t *)&s->port.rxBuffer[s->port.rxBufferSize - s->rxDMAPos];
+
+            s->rxDMAPos -= length;
+            if (s->rxDMAPos == 0) {
+                s->rxDMAPos = s->port.rxBufferSize;
+            }
+            waiting -= length;
+
+            s->port.rxFrameCallback(data, length, idle && !waiting, s->port.rxCallbackData);
+        }
+        return;
+    }
+
+    if (!s->port.rxCallback) {
+        // Nobody to deliver to, serialRead() will pick the bytes up from the DMA buffer instead
+        return;
+    }
+
+    while (uartTotalRxBytesWaiting(&s->port)) {
+        s->port.rxCallback(uartRead(&s->port), s->port.rxCallbackData);
     }
+}
+#endif
 
+void uartStartTx(uartPort_t *s)
+{
 #ifdef STM32F4
     if (s->txDMAStream)
 #else
@@ -268,6 +305,19 @@ static void uartWrite(serialPort_t *instance, uint8_t ch)
     }
 }
 
+static void uartWrite(serialPort_t *instance, uint8_t ch)
+{
+    uartPort_t *s = (uartPort_t *)instance;
+    s->port.txBuffer[s->port.txBufferHead] = ch;
+    if (s->port.txBufferHead + 1 >= s->port.txBufferSize) {
+        s->port.txBufferHead = 0;
+    } else {
+        s->port.txBufferHead++;
+    }
+
+    uartStartTx(s);
+}
+
 const struct serialPortVTable uartVTable[] = {
     {
         .serialWrite = uartWrite,
@@ -279,7 +329,7 @@ const struct serialPortVTable uartVTable[] = {
         .setMode = uartSetMode,
         .setCtrlLineStateCb = NULL,
         .setBaudRateCb = NULL,
-        .writeBuf = NULL,
+        .writeBuf = uartWriteBuf,
         .beginWrite = NULL,
         .endWrite = NULL,
     }
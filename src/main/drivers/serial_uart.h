@@ -20,12 +20,9 @@
 
 #pragma once
 
-// Since serial ports can be used for any function these buffer sizes should be equal
-// The two largest things that need to be sent are: 1, MSP responses, 2, UBLOX SVINFO packet.
-
-// Size must be a power of two due to various optimizations which use 'and' instead of 'mod'
-// Various serial routines return the buffer occupied size as uint8_t which would need to be extended in order to
-// increase size further.
+// The default buffer sizes (UART_RX_BUFFER_SIZE and UART_TX_BUFFER_SIZE) size the buffer arena, serialInit()
+// redistributes it by the functions of the ports. The two largest things that need to be sent with the default
+// sizes are: 1, MSP responses, 2, UBLOX SVINFO packet. The UART buffers can have any size.
 
 #if defined(USE_UART1) || defined(USE_UART2) || defined(USE_UART3) || defined(USE_UART4) || defined(USE_UART5) || defined(USE_UART6) || defined(USE_UART7) || defined(USE_UART8)
 #define USE_UART
@@ -74,5 +71,26 @@ typedef struct uartPort_s {
     bool txDMAEmpty;
 } uartPort_t;
 
+// pins of a UART, while they are lent to a half duplex port on a pin with another use
+typedef struct uartPins_s {
+    ioTag_t rx;
+    ioTag_t tx;
+} uartPins_t;
+
+// buffer sizes of a UART, a size of 0 gives it the default size
+typedef struct uartBufferSizes_s {
+    uint16_t rx;
+    uint16_t tx;
+} uartBufferSizes_t;
+
 void uartPinConfigure(const serialPinConfig_t *pSerialPinConfig);
+uint32_t uartBufferArenaSize(void);
+bool uartAllocateBuffers(const uartBufferSizes_t *sizes);
 serialPort_t *uartOpen(UARTDevice_e device, serialReceiveCallbackPtr rxCallback, void *rxCallbackData, uint32_t baudRate, portMode_e mode, portOptions_e options);
+
+#ifdef USE_ESCSERIAL_UART
+bool uartCanDriveTxPin(UARTDevice_e device, ioTag_t txTag);
+bool uartRemapTxPin(UARTDevice_e device, ioTag_t txTag, uartPins_t *saved);
+void uartRestorePins(UARTDevice_e device, const uartPins_t *saved);
+uint32_t uartAchievableBaudRate(UARTDevice_e device, uint32_t baudRate);
+#endif
@@ -207,6 +207,7 @@ serialPort_t *uartOpen(UARTDevice_e device, serialReceiveCallbackPtr callback, v
     // callback works for IRQ-based RX ONLY
     s->port.rxCallback = callback;
     s->port.rxCallbackData = callbackData;
+    s->port.rxFrameCallback = NULL;
     s->port.mode = mode;
     s->port.baudRate = baudRate;
     s->port.options = options;
@@ -259,10 +260,11 @@ uint32_t uartTotalRxBytesWaiting(const serialPort_t *instance)
     if (s->rxDMAStream) {
         uint32_t rxDMAHead = __HAL_DMA_GET_COUNTER(s->Handle.hdmarx);
 
-        if (rxDMAHead >= s->rxDMAPos) {
-            return rxDMAHead - s->rxDMAPos;
+        // rxDMAPos and rxDMAHead are distances from the end of the buffer, so they count down as they advance
+        if (s->rxDMAPos >= rxDMAHead) {
+            return s->rxDMAPos - rxDMAHead;
         } else {
-            return s->port.rxBufferSize + rxDMAHead - s->rxDMAPos;
+            return s->port.rxBufferSize + s->rxDMAPos - rxDMAHead;
         }
     }
 
@@ -338,6 +340,16 @@ uint8_t uartRead(serialPort_t *instance)
     return ch;
 }
 
+void uartStartTx(uartPort_t *s)
+{
+    if (s->txDMAStream) {
+        if (!(s->txDMAStream->CR & 1))
+            uartStartTxDMA(s);
+    } else {
+        __HAL_UART_ENABLE_IT(&s->Handle, UART_IT_TXE);
+    }
+}
+
 void uartWrite(serialPort_t *instance, uint8_t ch)
 {
     uartPort_t *s = (uartPort_t *)instance;
@@ -348,12 +360,7 @@ void uartWrite(serialPort_t *instance, uint8_t ch)
         s->port.txBufferHead++;
     }
 
-    if (s->txDMAStream) {
-        if (!(s->txDMAStream->CR & 1))
-            uartStartTxDMA(s);
-    } else {
-        __HAL_UART_ENABLE_IT(&s->Handle, UART_IT_TXE);
-    }
+    uartStartTx(s);
 }
 
 const struct serialPortVTable uartVTable[] = {
@@ -367,7 +374,7 @@ const struct serialPortVTable uartVTable[] = {
         .setMode = uartSetMode,
         .setCtrlLineStateCb = NULL,
         .setBaudRateCb = NULL,
-        .writeBuf = NULL,
+        .writeBuf = uartWriteBuf,
         .beginWrite = NULL,
         .endWrite = NULL,
     }
@@ -155,8 +155,10 @@ typedef struct uartDevice_s {
     const uartHardware_t *hardware;
     ioTag_t rx;
     ioTag_t tx;
-    volatile uint8_t rxBuffer[UART_RX_BUFFER_SIZE];
-    volatile uint8_t txBuffer[UART_TX_BUFFER_SIZE];
+    volatile uint8_t *rxBuffer;         // allocated from the UART buffer arena
+    volatile uint8_t *txBuffer;
+    uint16_t rxBufferSize;
+    uint16_t txBufferSize;
 } uartDevice_t;
 
 extern uartDevice_t *uartDevmap[];
@@ -169,8 +171,15 @@ void uartStartTxDMA(uartPort_t *s);
 void uartTryStartTxDMA(uartPort_t *s);
 #endif
 
+#ifdef STM32F4
+void uartRxDMADeliver(uartPort_t *s, bool idle);
+#endif
+
 uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode, portOptions_e options);
 
 void uartIrqHandler(uartPort_t *s);
 
+void uartStartTx(uartPort_t *s);
+void uartWriteBuf(serialPort_t *instance, const void *data, int count);
+
 void uartReconfigure(uartPort_t *uartPort);
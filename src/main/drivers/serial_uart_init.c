@@ -126,9 +126,10 @@ serialPort_t *uartOpen(UARTDevice_e device, serialReceiveCallbackPtr rxCallback,
     // common serial initialisation code should move to serialPort::init()
     s->port.rxBufferHead = s->port.rxBufferTail = 0;
     s->port.txBufferHead = s->port.txBufferTail = 0;
-    // callback works for IRQ-based RX ONLY
+    // callback works for IRQ-based RX, and for DMA-based RX on F4
     s->port.rxCallback = rxCallback;
     s->port.rxCallbackData = rxCallbackData;
+    s->port.rxFrameCallback = NULL;
     s->port.mode = mode;
     s->port.baudRate = baudRate;
     s->port.options = options;
@@ -174,6 +175,12 @@ serialPort_t *uartOpen(UARTDevice_e device, serialReceiveCallbackPtr rxCallback,
             DMA_Cmd(s->rxDMAStream, ENABLE);
             USART_DMACmd(s->USARTx, USART_DMAReq_Rx, ENABLE);
             s->rxDMAPos = DMA_GetCurrDataCounter(s->rxDMAStream);
+
+            if (rxCallback) {
+                // Deliver received bytes when the line goes idle after a frame, or when the buffer is half full
+                DMA_ITConfig(s->rxDMAStream, DMA_IT_HT | DMA_IT_TC, ENABLE);
+                USART_ITConfig(s->USARTx, USART_IT_IDLE, ENABLE);
+            }
 #else
             DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
             DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
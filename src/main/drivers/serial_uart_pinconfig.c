@@ -39,9 +39,51 @@
 #include "drivers/serial_uart.h"
 #include "drivers/serial_uart_impl.h"
 
-FAST_RAM_ZERO_INIT uartDevice_t uartDevice[UARTDEV_COUNT];      // Only those configured in target.h
+DMA_RAM uartDevice_t uartDevice[UARTDEV_COUNT];      // Only those configured in target.h
 FAST_RAM_ZERO_INIT uartDevice_t *uartDevmap[UARTDEV_COUNT_MAX]; // Full array
 
+// The UART buffers are allocated from one arena, as large as the default buffers of all UARTs.
+// The sizes can be redistributed by the function of each port before any port is opened.
+#define UART_BUFFER_ARENA_SIZE (UARTDEV_COUNT * (UART_RX_BUFFER_SIZE + UART_TX_BUFFER_SIZE))
+
+static DMA_RAM volatile uint8_t uartBufferArena[UART_BUFFER_ARENA_SIZE];
+
+uint32_t uartBufferArenaSize(void)
+{
+    return sizeof(uartBufferArena);
+}
+
+// sizes holds an entry per UARTDevice_e, up to UARTDEV_COUNT_MAX. Without sizes, or if they do not
+// fit into the arena, every UART gets the default sizes. Returns true if the sizes were taken.
+bool uartAllocateBuffers(const uartBufferSizes_t *sizes)
+{
+    uint32_t total = 0;
+    if (sizes) {
+        for (int device = 0; device < UARTDEV_COUNT_MAX; device++) {
+            if (uartDevmap[device]) {
+                total += (sizes[device].rx ? sizes[device].rx : UART_RX_BUFFER_SIZE) + (sizes[device].tx ? sizes[device].tx : UART_TX_BUFFER_SIZE);
+            }
+        }
+    }
+    const bool useSizes = sizes && total <= sizeof(uartBufferArena);
+
+    volatile uint8_t *next = uartBufferArena;
+    for (int device = 0; device < UARTDEV_COUNT_MAX; device++) {
+        uartDevice_t *uartdev = uartDevmap[device];
+        if (!uartdev) {
+            continue;
+        }
+        uartdev->rxBufferSize = useSizes && sizes[device].rx ? sizes[device].rx : UART_RX_BUFFER_SIZE;
+        uartdev->txBufferSize = useSizes && sizes[device].tx ? sizes[device].tx : UART_TX_BUFFER_SIZE;
+        uartdev->rxBuffer = next;
+        next += uartdev->rxBufferSize;
+        uartdev->txBuffer = next;
+        next += uartdev->txBufferSize;
+    }
+
+    return useSizes;
+}
+
 void uartPinConfigure(const serialPinConfig_t *pSerialPinConfig)
 {
     uartDevice_t *uartdev = uartDevice;
@@ -64,4 +106,63 @@ void uartPinConfigure(const serialPinConfig_t *pSerialPinConfig)
             uartDevmap[device] = uartdev++;
         }
     }
+
+    uartAllocateBuffers(NULL);
+}
+
+#ifdef USE_ESCSERIAL_UART
+static const uartHardware_t *uartFindHardware(UARTDevice_e device)
+{
+    for (size_t hindex = 0; hindex < UARTDEV_COUNT; hindex++) {
+        if (uartHardware[hindex].device == device) {
+            return &uartHardware[hindex];
+        }
+    }
+
+    return NULL;
+}
+
+// True if the UART has a device instance and its TX alternate function reaches the pin
+bool uartCanDriveTxPin(UARTDevice_e device, ioTag_t txTag)
+{
+    const uartHardware_t *hardware = uartFindHardware(device);
+
+    if (!txTag || !hardware || !uartDevmap[device]) {
+        return false;
+    }
+
+    for (int pindex = 0 ; pindex < UARTHARDWARE_MAX_PINS ; pindex++) {
+        if (hardware->txPins[pindex] == txTag) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Moves a UART that is not open onto a single pin for half duplex, the pins it had are kept in `saved`
+bool uartRemapTxPin(UARTDevice_e device, ioTag_t txTag, uartPins_t *saved)
+{
+    if (!uartCanDriveTxPin(device, txTag)) {
+        return false;
+    }
+
+    uartDevice_t *uartdev = uartDevmap[device];
+    saved->rx = uartdev->rx;
+    saved->tx = uartdev->tx;
+    uartdev->rx = IO_TAG_NONE;
+    uartdev->tx = txTag;
+
+    return true;
+}
+
+void uartRestorePins(UARTDevice_e device, const uartPins_t *saved)
+{
+    uartDevice_t *uartdev = uartDevmap[device];
+
+    if (uartdev) {
+        uartdev->rx = saved->rx;
+        uartdev->tx = saved->tx;
+    }
 }
+#endif
@@ -40,6 +40,7 @@
 #include "drivers/serial.h"
 #include "drivers/serial_uart.h"
 #include "drivers/serial_uart_impl.h"
+#include "drivers/stack_check.h"
 
 #ifdef USE_UART
 
@@ -134,8 +135,8 @@ uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode,
 
     s->port.rxBuffer = uartdev->rxBuffer;
     s->port.txBuffer = uartdev->txBuffer;
-    s->port.rxBufferSize = ARRAYLEN(uartdev->rxBuffer);
-    s->port.txBufferSize = ARRAYLEN(uartdev->txBuffer);
+    s->port.rxBufferSize = uartdev->rxBufferSize;
+    s->port.txBufferSize = uartdev->txBufferSize;
 
     const uartHardware_t *hardware = uartdev->hardware;
 
@@ -191,6 +192,8 @@ uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode,
 
 void uartIrqHandler(uartPort_t *s)
 {
+    STACK_CHECK_ISR(STACK_ISR_UART);
+
     uint16_t SR = s->USARTx->SR;
 
     if (SR & USART_FLAG_RXNE && !s->rxDMAChannel) {
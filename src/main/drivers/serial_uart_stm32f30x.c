@@ -41,6 +41,7 @@
 #include "drivers/serial.h"
 #include "drivers/serial_uart.h"
 #include "drivers/serial_uart_impl.h"
+#include "drivers/stack_check.h"
 
 #ifdef USE_UART
 
@@ -219,8 +220,8 @@ uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode,
 
     s->port.rxBuffer = uartDev->rxBuffer;
     s->port.txBuffer = uartDev->txBuffer;
-    s->port.rxBufferSize = sizeof(uartDev->rxBuffer);
-    s->port.txBufferSize = sizeof(uartDev->txBuffer);
+    s->port.rxBufferSize = uartDev->rxBufferSize;
+    s->port.txBufferSize = uartDev->txBufferSize;
 
     const uartHardware_t *hardware = uartDev->hardware;
 
@@ -259,6 +260,8 @@ uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode,
 
 void uartIrqHandler(uartPort_t *s)
 {
+    STACK_CHECK_ISR(STACK_ISR_UART);
+
     uint32_t ISR = s->USARTx->ISR;
 
     if (!s->rxDMAChannel && (ISR & USART_FLAG_RXNE)) {
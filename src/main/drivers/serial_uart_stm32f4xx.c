@@ -30,12 +30,14 @@
 #include "drivers/system.h"
 #include "drivers/io.h"
 #include "drivers/dma.h"
+#include "drivers/dma_reqmap.h"
 #include "drivers/nvic.h"
 #include "drivers/rcc.h"
 
 #include "drivers/serial.h"
 #include "drivers/serial_uart.h"
 #include "drivers/serial_uart_impl.h"
+#include "drivers/stack_check.h"
 
 #ifdef USE_UART
 
@@ -195,6 +197,15 @@ void dmaIRQHandler(dmaChannelDescriptor_t* descriptor)
     }
 }
 
+static void uartRxDmaIrqHandler(dmaChannelDescriptor_t* descriptor)
+{
+    uartPort_t *s = &(((uartDevice_t*)(descriptor->userParam))->port);
+
+    DMA_CLEAR_FLAG(descriptor, (DMA_IT_HTIF | DMA_IT_TCIF | DMA_IT_TEIF | DMA_IT_DMEIF | DMA_IT_FEIF));
+
+    uartRxDMADeliver(s, false);
+}
+
 // XXX Should serialUART be consolidated?
 
 uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode, portOptions_e options)
@@ -213,24 +224,28 @@ uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode,
 
     s->port.rxBuffer = uart->rxBuffer;
     s->port.txBuffer = uart->txBuffer;
-    s->port.rxBufferSize = sizeof(uart->rxBuffer);
-    s->port.txBufferSize = sizeof(uart->txBuffer);
+    s->port.rxBufferSize = uart->rxBufferSize;
+    s->port.txBufferSize = uart->txBufferSize;
 
     s->USARTx = hardware->reg;
 
-    if (hardware->rxDMAStream) {
-        dmaInit(dmaGetIdentifier(hardware->rxDMAStream), OWNER_SERIAL_RX, RESOURCE_INDEX(device));
-        s->rxDMAChannel = hardware->DMAChannel;
-        s->rxDMAStream = hardware->rxDMAStream;
+    // the streams of the hardware table are preferred, the port falls back to interrupts if none is free
+    const dmaChannelSpec_t *rxSpec = hardware->rxDMAStream ? dmaAllocate(DMA_PERIPH_UART_RX, device, hardware->rxDMAStream, OWNER_SERIAL_RX, RESOURCE_INDEX(device)) : NULL;
+    if (rxSpec) {
+        const dmaIdentifier_e identifier = dmaGetIdentifier(rxSpec->ref);
+        // Same priority as the UART IRQ, so the two never preempt each other while delivering bytes
+        dmaSetHandler(identifier, uartRxDmaIrqHandler, hardware->rxPriority, (uint32_t)uart);
+        s->rxDMAChannel = rxSpec->channel;
+        s->rxDMAStream = rxSpec->ref;
         s->rxDMAPeripheralBaseAddr = (uint32_t)&s->USARTx->DR;
     }
 
-    if (hardware->txDMAStream) {
-        const dmaIdentifier_e identifier = dmaGetIdentifier(hardware->txDMAStream);
-        dmaInit(identifier, OWNER_SERIAL_TX, RESOURCE_INDEX(device));
+    const dmaChannelSpec_t *txSpec = hardware->txDMAStream ? dmaAllocate(DMA_PERIPH_UART_TX, device, hardware->txDMAStream, OWNER_SERIAL_TX, RESOURCE_INDEX(device)) : NULL;
+    if (txSpec) {
+        const dmaIdentifier_e identifier = dmaGetIdentifier(txSpec->ref);
         dmaSetHandler(identifier, dmaIRQHandler, hardware->txPriority, (uint32_t)uart);
-        s->txDMAChannel = hardware->DMAChannel;
-        s->txDMAStream = hardware->txDMAStream;
+        s->txDMAChannel = txSpec->channel;
+        s->txDMAStream = txSpec->ref;
         s->txDMAPeripheralBaseAddr = (uint32_t)&s->USARTx->DR;
     }
 
@@ -256,21 +271,29 @@ uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode,
         }
     }
 
-    if (!(s->rxDMAChannel)) {
-        NVIC_InitTypeDef NVIC_InitStructure;
+    // Needed for RX without DMA, for the IDLE line interrupt with RX DMA, and for TX without DMA
+    NVIC_InitTypeDef NVIC_InitStructure;
 
-        NVIC_InitStructure.NVIC_IRQChannel = hardware->irqn;
-        NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = NVIC_PRIORITY_BASE(hardware->rxPriority);
-        NVIC_InitStructure.NVIC_IRQChannelSubPriority = NVIC_PRIORITY_SUB(hardware->rxPriority);
-        NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
-        NVIC_Init(&NVIC_InitStructure);
-    }
+    NVIC_InitStructure.NVIC_IRQChannel = hardware->irqn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = NVIC_PRIORITY_BASE(hardware->rxPriority);
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = NVIC_PRIORITY_SUB(hardware->rxPriority);
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
 
     return s;
 }
 
 void uartIrqHandler(uartPort_t *s)
 {
+    STACK_CHECK_ISR(STACK_ISR_UART);
+
+    if (s->rxDMAStream && (USART_GetITStatus(s->USARTx, USART_IT_IDLE) == SET)) {
+        // IDLE is cleared by reading SR (done above) followed by DR, the DMA has already taken any received byte
+        (void)s->USARTx->DR;
+
+        uartRxDMADeliver(s, true);
+    }
+
     if (!s->rxDMAStream && (USART_GetITStatus(s->USARTx, USART_IT_RXNE) == SET)) {
         if (s->port.rxCallback) {
             s->port.rxCallback(s->USARTx->DR, s->port.rxCallbackData);
@@ -294,4 +317,26 @@ void uartIrqHandler(uartPort_t *s)
         USART_ClearITPendingBit (s->USARTx, USART_IT_ORE);
     }
 }
+
+#ifdef USE_ESCSERIAL_UART
+// Baud rate the UART really runs at when asked for `baudRate`, the divider is rounded the way USART_Init() does it
+uint32_t uartAchievableBaudRate(UARTDevice_e device, uint32_t baudRate)
+{
+    if (!baudRate) {
+        return 0;
+    }
+
+    RCC_ClocksTypeDef clocks;
+    RCC_GetClocksFreq(&clocks);
+    const uint32_t pclk = (device == UARTDEV_1 || device == UARTDEV_6) ? clocks.PCLK2_Frequency : clocks.PCLK1_Frequency;
+
+    // divider in hundredths, then mantissa and sixteenths of the fraction, with 16 times oversampling
+    const uint32_t divider = (25 * pclk) / (4 * baudRate);
+    const uint32_t mantissa = divider / 100;
+    const uint32_t fraction = (((divider - 100 * mantissa) * 16) + 50) / 100;
+    const uint32_t brr = (mantissa << 4) | (fraction & 0x0F);
+
+    return brr ? pclk / brr : 0;
+}
+#endif
 #endif
@@ -36,6 +36,7 @@
 #include "drivers/serial.h"
 #include "drivers/serial_uart.h"
 #include "drivers/serial_uart_impl.h"
+#include "drivers/stack_check.h"
 
 #ifdef USE_UART
 
@@ -245,6 +246,8 @@ const uartHardware_t uartHardware[UARTDEV_COUNT] = {
 
 void uartIrqHandler(uartPort_t *s)
 {
+    STACK_CHECK_ISR(STACK_ISR_UART);
+
     UART_HandleTypeDef *huart = &s->Handle;
     /* UART in mode Receiver ---------------------------------------------------*/
     if ((__HAL_UART_GET_IT(huart, UART_IT_RXNE) != RESET)) {
@@ -345,8 +348,8 @@ uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode,
 
     s->port.rxBuffer = uartdev->rxBuffer;
     s->port.txBuffer = uartdev->txBuffer;
-    s->port.rxBufferSize = ARRAYLEN(uartdev->rxBuffer);
-    s->port.txBufferSize = ARRAYLEN(uartdev->txBuffer);
+    s->port.rxBufferSize = uartdev->rxBufferSize;
+    s->port.txBufferSize = uartdev->txBufferSize;
 
     const uartHardware_t *hardware = uartdev->hardware;
 
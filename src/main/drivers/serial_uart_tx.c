@@ -0,0 +1,68 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * TX buffer part of serial_uart.c and serial_uart_hal.c
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "common/maths.h"
+
+#include "drivers/dma.h"
+#include "drivers/rcc.h"
+
+#include "drivers/serial.h"
+#include "drivers/serial_uart.h"
+#include "drivers/serial_uart_impl.h"
+
+/*
+ * Copy a whole buffer into the TX ring and start the transmitter once per contiguous chunk, rather than once per
+ * byte. Blocks while the ring is full, just like serialWriteBuf() does with byte writes.
+ */
+void uartWriteBuf(serialPort_t *instance, const void *data, int count)
+{
+    uartPort_t *s = (uartPort_t *)instance;
+    const uint8_t *p = data;
+
+    while (count > 0) {
+        uint32_t bytesFree;
+        while ((bytesFree = serialTxBytesFree(instance)) == 0) {
+        };
+
+        const uint32_t chunk = MIN(MIN(bytesFree, (uint32_t)count), s->port.txBufferSize - s->port.txBufferHead);
+
+        memcpy((uint8_t *)&s->port.txBuffer[s->port.txBufferHead], p, chunk);
+        if (s->port.txBufferHead + chunk >= s->port.txBufferSize) {
+            s->port.txBufferHead = 0;
+        } else {
+            s->port.txBufferHead += chunk;
+        }
+
+        p += chunk;
+        count -= chunk;
+
+        uartStartTx(s);
+    }
+}
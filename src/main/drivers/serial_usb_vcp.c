@@ -62,6 +62,8 @@ USBD_HandleTypeDef USBD_Device;
 
 
 #define USB_TIMEOUT  50
+// single bytes are collected for up to a USB frame before they are sent in a short packet
+#define USB_TX_COALESCE_US 1000
 
 static vcpPort_t vcpPort;
 
@@ -97,9 +99,74 @@ static void usbVcpSetBaudRateCb(serialPort_t *instance, void (*cb)(serialPort_t
     CDC_SetBaudRateCb((void (*)(void *context, uint32_t baud))cb, (void *)context);
 }
 
+static bool usbVcpTransmitReady(void)
+{
+    return usbIsConnected() && usbIsConfigured();
+}
+
+static void usbVcpDropPending(vcpPort_t *port)
+{
+    port->txAt = 0;
+    port->txSendLength = 0;
+}
+
+// Hands as much of the waiting packet to the CDC layer as it takes, returns true if the buffer is free
+static bool usbVcpSendPending(vcpPort_t *port)
+{
+    if (port->txSendLength) {
+        const uint8_t *p = &port->txBuf[port->txFill ^ 1][port->txSendAt];
+        port->txSendAt += CDC_Send_DATA(p, port->txSendLength - port->txSendAt);
+        if (port->txSendAt >= port->txSendLength) {
+            port->txSendLength = 0;
+        }
+    }
+    return port->txSendLength == 0;
+}
+
+static bool usbVcpWaitPending(vcpPort_t *port)
+{
+    const uint32_t start = millis();
+    while (!usbVcpSendPending(port)) {
+        if (millis() - start > USB_TIMEOUT) {
+            usbVcpDropPending(port);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Moves the buffer being filled to the CDC layer. Without waiting, the buffer stays where it is if
+// the previous packet has not been taken yet.
+static bool usbVcpQueueFill(vcpPort_t *port, bool wait)
+{
+    if (!usbVcpTransmitReady()) {
+        usbVcpDropPending(port);
+        return false;
+    }
+
+    if (!usbVcpSendPending(port) && !(wait && usbVcpWaitPending(port))) {
+        return false;
+    }
+
+    if (port->txAt) {
+        port->txSendLength = port->txAt;
+        port->txSendAt = 0;
+        port->txFill ^= 1;
+        port->txAt = 0;
+        usbVcpSendPending(port);
+    }
+    return true;
+}
+
 static bool isUsbVcpTransmitBufferEmpty(const serialPort_t *instance)
 {
     UNUSED(instance);
+
+    // the callers wait for this before a reboot or a baud rate change, so the packets are sent now
+    vcpPort_t *port = &vcpPort;
+    if (usbVcpQueueFill(port, true)) {
+        usbVcpWaitPending(port);
+    }
     return true;
 }
 
@@ -124,9 +191,10 @@ static uint8_t usbVcpRead(serialPort_t *instance)
 
 static void usbVcpWriteBuf(serialPort_t *instance, const void *data, int count)
 {
-    UNUSED(instance);
+    vcpPort_t *port = container_of(instance, vcpPort_t, port);
 
-    if (!(usbIsConnected() && usbIsConfigured())) {
+    // the collected bytes go first, larger writes then go to the CDC layer directly
+    if (!usbVcpQueueFill(port, true) || !usbVcpWaitPending(port)) {
         return;
     }
 
@@ -143,40 +211,21 @@ static void usbVcpWriteBuf(serialPort_t *instance, const void *data, int count)
     }
 }
 
-static bool usbVcpFlush(vcpPort_t *port)
+static void usbVcpWrite(serialPort_t *instance, uint8_t c)
 {
-    uint32_t count = port->txAt;
-    port->txAt = 0;
-
-    if (count == 0) {
-        return true;
-    }
+    vcpPort_t *port = container_of(instance, vcpPort_t, port);
 
-    if (!usbIsConnected() || !usbIsConfigured()) {
-        return false;
+    if (port->txAt >= USB_VCP_TX_PACKET_SIZE && !usbVcpQueueFill(port, true)) {
+        return;
     }
 
-    uint32_t start = millis();
-    uint8_t *p = port->txBuf;
-    while (count > 0) {
-        uint32_t txed = CDC_Send_DATA(p, count);
-        count -= txed;
-        p += txed;
-
-        if (millis() - start > USB_TIMEOUT) {
-            break;
-        }
+    if (port->txAt == 0) {
+        port->txDeadlineUs = micros() + USB_TX_COALESCE_US;
     }
-    return count == 0;
-}
-
-static void usbVcpWrite(serialPort_t *instance, uint8_t c)
-{
-    vcpPort_t *port = container_of(instance, vcpPort_t, port);
+    port->txBuf[port->txFill][port->txAt++] = c;
 
-    port->txBuf[port->txAt++] = c;
-    if (!port->buffering || port->txAt >= ARRAYLEN(port->txBuf)) {
-        usbVcpFlush(port);
+    if (port->txAt >= USB_VCP_TX_PACKET_SIZE || (!port->buffering && cmp32(micros(), port->txDeadlineUs) >= 0)) {
+        usbVcpQueueFill(port, false);
     }
 }
 
@@ -192,11 +241,30 @@ static uint32_t usbTxBytesFree(const serialPort_t *instance)
     return CDC_Send_FreeBytes();
 }
 
+// The end of a framed write, such as a reply in the blocking 4way interface loop where the serial
+// task does not run to send what is left. On the F1 and F3 the CDC layer takes a packet in pieces,
+// and none while it is busy, so the frame is not left to usbVcpFlushPending() but sent here.
 static void usbVcpEndWrite(serialPort_t *instance)
 {
     vcpPort_t *port = container_of(instance, vcpPort_t, port);
     port->buffering = false;
-    usbVcpFlush(port);
+    if (usbVcpQueueFill(port, true)) {
+        usbVcpWaitPending(port);
+    }
+}
+
+// Sends the bytes that have been waiting for a full packet for too long, from the serial task
+void usbVcpFlushPending(uint32_t currentTimeUs)
+{
+    vcpPort_t *port = &vcpPort;
+    if (!port->port.vTable) {
+        return;
+    }
+
+    usbVcpSendPending(port);
+    if (port->txAt && !port->buffering && cmp32(currentTimeUs, port->txDeadlineUs) >= 0) {
+        usbVcpQueueFill(port, false);
+    }
 }
 
 static const struct serialPortVTable usbVTable[] = {
@@ -218,7 +286,12 @@ static const struct serialPortVTable usbVTable[] = {
 
 serialPort_t *usbVcpOpen(void)
 {
-    vcpPort_t *s;
+    vcpPort_t *s = &vcpPort;
+
+    // The port moves between MSP and the blackbox, only bring up the USB device once so the host stays connected
+    if (s->port.vTable) {
+        return (serialPort_t *)s;
+    }
 
 #if defined(STM32F4)
     usbGenerateDisconnectPulse();
@@ -265,7 +338,6 @@ serialPort_t *usbVcpOpen(void)
     USB_Interrupts_Config();
 #endif
 
-    s = &vcpPort;
     s->port.vTable = usbVTable;
 
     return (serialPort_t *)s;
@@ -30,17 +30,26 @@
 extern USBD_HandleTypeDef  USBD_Device;
 #endif
 
+// one full speed bulk packet
+#define USB_VCP_TX_PACKET_SIZE 64
+
 typedef struct {
     serialPort_t port;
 
-    // Buffer used during bulk writes.
-    uint8_t txBuf[20];
-    uint8_t txAt;
+    // Written bytes are collected into packets. One buffer is filled while the other waits for
+    // the CDC layer to take it, which can take a USB frame on the F1 and F3.
+    uint8_t txBuf[2][USB_VCP_TX_PACKET_SIZE] __attribute__((aligned(4)));
+    uint8_t txFill;                 // buffer being filled
+    uint8_t txAt;                   // bytes in the buffer being filled
+    uint8_t txSendLength;           // bytes in the other buffer, 0 if it is free
+    uint8_t txSendAt;               // bytes of the other buffer the CDC layer has taken
+    uint32_t txDeadlineUs;          // when the buffer being filled is sent at the latest
     // Set if the port is in bulk write mode and can buffer.
     bool buffering;
 } vcpPort_t;
 
 serialPort_t *usbVcpOpen(void);
+void usbVcpFlushPending(uint32_t currentTimeUs);
 struct serialPort_s;
 uint32_t usbVcpGetBaudRate(struct serialPort_s *instance);
 uint8_t usbVcpIsConnected(void);
@@ -26,11 +26,13 @@
 
 #include "build/debug.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/stack_check.h"
 
 #define STACK_FILL_CHAR 0xa5
+#define STACK_FILL_WORD 0xa5a5a5a5
 
 extern char _estack; // end of stack, declared in .LD file
 extern char _Min_Stack_Size; // declared in .LD file
@@ -61,23 +63,40 @@ extern char _Min_Stack_Size; // declared in .LD file
 
 static uint32_t usedStackSize;
 
+// lowest address known to have been written, everything below it still holds the fill pattern
+static char *stackWatermark;
+
+uint32_t stackIsrLowestSp[STACK_ISR_COUNT];
+
+static char *stackLowAddress(void)
+{
+    return &_estack - (uint32_t)&_Min_Stack_Size;
+}
+
+// first byte not holding the fill pattern at or above from
+static char *stackFindUsed(char *from, const char *limit)
+{
+    char *p;
+    for (p = from; p < limit; ++p) {
+        if ((uint8_t)*p != STACK_FILL_CHAR) {
+            break;
+        }
+    }
+    return p;
+}
+
 void taskStackCheck(timeUs_t currentTimeUs)
 {
     UNUSED(currentTimeUs);
 
     char * const stackHighMem = &_estack;
-    const uint32_t stackSize = (uint32_t)&_Min_Stack_Size;
-    char * const stackLowMem = stackHighMem - stackSize;
+    char * const stackLowMem = stackHighMem - (uint32_t)&_Min_Stack_Size;
     const char * const stackCurrent = (char *)&stackLowMem;
 
-    char *p;
-    for (p = stackLowMem; p < stackCurrent; ++p) {
-        if (*p != STACK_FILL_CHAR) {
-            break;
-        }
-    }
+    // the sampling in stackCheckBegin() repaints above the watermark, so this scan can only add to the peak
+    char *p = stackFindUsed(stackLowMem, stackCurrent);
 
-    usedStackSize = (uint32_t)stackHighMem - (uint32_t)p;
+    usedStackSize = MAX(usedStackSize, (uint32_t)stackHighMem - (uint32_t)p);
 
     DEBUG_SET(DEBUG_STACK, 0, (uint32_t)stackHighMem & 0xffff);
     DEBUG_SET(DEBUG_STACK, 1, (uint32_t)stackLowMem & 0xffff);
@@ -89,6 +108,45 @@ uint32_t stackUsedSize(void)
 {
     return usedStackSize;
 }
+
+/*
+ * The peak stack use of a single context is sampled by filling the stack between the watermark and
+ * the current stack pointer with the fill pattern again before the context runs, and looking for the
+ * lowest overwritten byte afterwards. Interrupts taken meanwhile are counted into the peak, as they
+ * share the main stack with the tasks.
+ */
+void stackCheckBegin(void)
+{
+    uint32_t * const stackCurrent = (uint32_t *)__get_MSP();
+    if (!stackWatermark) {
+        stackWatermark = stackFindUsed(stackLowAddress(), (char *)stackCurrent);
+    }
+    // volatile keeps this from becoming a call to memset(), which would be filling its own frame
+    for (volatile uint32_t *p = (uint32_t *)((uint32_t)stackWatermark & ~3); p < stackCurrent; ++p) {
+        *p = STACK_FILL_WORD;
+    }
+}
+
+uint32_t stackCheckEnd(void)
+{
+    char *p = stackWatermark;
+    // the context may have gone below the watermark
+    const char * const stackLowMem = stackLowAddress();
+    while (p > stackLowMem && (uint8_t)p[-1] != STACK_FILL_CHAR) {
+        --p;
+    }
+    if (p == stackWatermark) {
+        p = stackFindUsed(p, (char *)__get_MSP());
+    }
+    stackWatermark = MIN(stackWatermark, p);
+
+    return (uint32_t)&_estack - (uint32_t)p;
+}
+
+uint32_t stackIsrUsedSize(stackIsr_e isr)
+{
+    return stackIsrLowestSp[isr] ? (uint32_t)&_estack - stackIsrLowestSp[isr] : 0;
+}
 #endif
 
 uint32_t stackTotalSize(void)
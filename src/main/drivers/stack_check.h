@@ -22,7 +22,37 @@
 
 #include "common/time.h"
 
+typedef enum {
+    STACK_ISR_EXTI = 0,
+    STACK_ISR_DMA,
+    STACK_ISR_UART,
+    STACK_ISR_COUNT
+} stackIsr_e;
+
 void taskStackCheck(timeUs_t currentTimeUs);
 uint32_t stackUsedSize(void);
+
+#ifdef STACK_CHECK
+#define STACK_CHECK_SAMPLE_INTERVAL_US 100000 // per task
+
+void stackCheckBegin(void);
+uint32_t stackCheckEnd(void);
+uint32_t stackIsrUsedSize(stackIsr_e isr); // deepest stack the interrupt was seen at
+
+extern uint32_t stackIsrLowestSp[STACK_ISR_COUNT];
+
+// records how deep the stack was when the interrupt handler got here
+static inline void stackCheckIsr(stackIsr_e isr)
+{
+    const uint32_t stackCurrent = __get_MSP();
+    if (stackCurrent < stackIsrLowestSp[isr] || !stackIsrLowestSp[isr]) {
+        stackIsrLowestSp[isr] = stackCurrent;
+    }
+}
+#define STACK_CHECK_ISR(isr) stackCheckIsr(isr)
+#else
+#define STACK_CHECK_ISR(isr) do {} while (0)
+#endif
+
 uint32_t stackTotalSize(void);
 uint32_t stackHighMem(void);
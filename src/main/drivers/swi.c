@@ -0,0 +1,54 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#ifdef USE_PREEMPTIVE_PID_LOOP
+
+#include "drivers/nvic.h"
+#include "drivers/swi.h"
+
+// The PendSV exception is used as the software interrupt, it is not used by anything else.
+
+static swiHandlerFn *swiHandler;
+
+void swiInit(swiHandlerFn *fn)
+{
+    swiHandler = fn;
+    // NVIC_SetPriority() takes the priority without the shift applied by NVIC_BUILD_PRIORITY()
+    NVIC_SetPriority(PendSV_IRQn, NVIC_PRIO_SWI >> (8 - __NVIC_PRIO_BITS));
+}
+
+FAST_CODE void swiTrigger(void)
+{
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+FAST_CODE void PendSV_Handler(void)
+{
+    if (swiHandler) {
+        swiHandler();
+    }
+}
+
+#endif
@@ -0,0 +1,39 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Software interrupt, used to run work at a low interrupt priority ahead of the main loop.
+
+typedef void swiHandlerFn(void);
+
+#ifdef USE_PREEMPTIVE_PID_LOOP
+#include "build/atomic.h"
+#include "drivers/nvic.h"
+
+// Runs the following block with the software interrupt held off. Background tasks use it when they
+// update data the preemptive PID loop reads, so the loop sees all of the update or none of it.
+#define SWI_ATOMIC_BLOCK ATOMIC_BLOCK(NVIC_PRIO_SWI)
+#else
+#define SWI_ATOMIC_BLOCK
+#endif
+
+void swiInit(swiHandlerFn *fn);
+void swiTrigger(void);
@@ -33,31 +33,125 @@
 
 // cycles per microsecond
 static uint32_t usTicks = 0;
+// 2^32 / usTicks rounded up, converts a cycle count to microseconds with a multiply
+static uint32_t usTicksInverse = 0;
 // current uptime for 1kHz systick timer. will rollover after 49 days. hopefully we won't care.
 static volatile uint32_t sysTickUptime = 0;
+// the uptime in microseconds at the cycle count cycleCounterBase, both moved on by each systick.
+// The cycle counter wraps after less than a minute, the microseconds only after the systick has
+// taken them into account.
+static volatile uint64_t microsBase = 0;
+static volatile uint32_t cycleCounterBase = 0;
 // cached value of RCC->CSR
 uint32_t cachedRccCsrValue;
 
+#ifdef USE_SCHEDULER_IDLE_SLEEP
+// The cycle counter stops with the core clock in sleep mode, the systick keeps counting. From just before an
+// idle sleep until the code after it runs, every micros() and systick takes the cycles the counter missed,
+// worked out from the systick, off cycleCounterBase. An interrupt that ends the sleep so sees the right time.
+static volatile bool cycleCounterResyncing = false;
+static uint32_t resyncSysTickCycles;    // systick position at the last resync, in cycles
+static uint32_t resyncCycleCount;       // cycle count at the last resync
+#endif
+
+// The multiply gives the exact quotient for up to 2^32 / usTicks cycles, more than 70ms worth,
+// the systick never is that late.
+#define CYCLES_TO_MICROS_EXACT_MAX (1 << 24)
+
 void cycleCounterInit(void)
 {
 #if defined(USE_HAL_DRIVER)
-    usTicks = HAL_RCC_GetSysClockFreq() / 1000000;
+    const uint32_t sysClockMHz = HAL_RCC_GetSysClockFreq() / 1000000;
 #else
     RCC_ClocksTypeDef clocks;
     RCC_GetClocksFreq(&clocks);
-    usTicks = clocks.SYSCLK_Frequency / 1000000;
+    const uint32_t sysClockMHz = clocks.SYSCLK_Frequency / 1000000;
 #endif
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#ifdef STM32F7
+    // the DWT registers are write protected on the M7
+    DWT->LAR = 0xC5ACCE55;
+#endif
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    // the systick only takes the cycle count into account once usTicks is set
+    usTicksInverse = (uint32_t)((((uint64_t)1 << 32) + sysClockMHz - 1) / sysClockMHz);
+    usTicks = sysClockMHz;
 }
 
-// SysTick
+static uint32_t cyclesToMicros(uint32_t elapsedCycles)
+{
+    if (elapsedCycles >= CYCLES_TO_MICROS_EXACT_MAX) {
+        return elapsedCycles / usTicks;
+    }
+    return ((uint64_t)elapsedCycles * usTicksInverse) >> 32;
+}
+
+#ifdef USE_SCHEDULER_IDLE_SLEEP
+// Position of the systick in cycles, it counts the core clock like the cycle counter. Called with the systick masked.
+static uint32_t sysTickCycles(void)
+{
+    const uint32_t reload = SysTick->LOAD + 1;
+    uint32_t ms = sysTickUptime;
+    uint32_t value = SysTick->VAL;
+    // a reload the systick handler has not taken yet
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+        ms++;
+        value = SysTick->VAL;
+    }
+    return ms * reload + (reload - 1 - value);
+}
 
-static volatile int sysTickPending = 0;
+// Takes the cycles missed since the last resync off cycleCounterBase. Called with the systick masked. The
+// marks only move on when cycles were missed, so reads a few cycles apart do not add up to a drift.
+static void cycleCounterResync(void)
+{
+    const uint32_t sysTickNow = sysTickCycles();
+    const uint32_t cycleCountNow = DWT->CYCCNT;
+    const int32_t missedCycles = (int32_t)((sysTickNow - resyncSysTickCycles) - (cycleCountNow - resyncCycleCount));
+    if (missedCycles > 0) {
+        cycleCounterBase -= missedCycles;
+        resyncSysTickCycles = sysTickNow;
+        resyncCycleCount = cycleCountNow;
+    }
+}
+
+// Sleeps until the next interrupt, micros() counts the time spent asleep
+void systemIdleSleep(void)
+{
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        resyncSysTickCycles = sysTickCycles();
+        resyncCycleCount = DWT->CYCCNT;
+        cycleCounterResyncing = true;
+    }
+    __WFI();
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        cycleCounterResync();
+        cycleCounterResyncing = false;
+    }
+}
+#endif
+
+// SysTick
 
 void SysTick_Handler(void)
 {
     ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+#ifdef USE_SCHEDULER_IDLE_SLEEP
+        if (cycleCounterResyncing) {
+            cycleCounterResync();
+        }
+#endif
+        // take whole microseconds into the base, the remaining cycles are counted from the new one,
+        // the HAL starts the systick before cycleCounterInit()
+        if (usTicks) {
+            const uint32_t elapsedUs = cyclesToMicros(DWT->CYCCNT - cycleCounterBase);
+            microsBase += elapsedUs;
+            cycleCounterBase += elapsedUs * usTicks;
+        }
         sysTickUptime++;
-        sysTickPending = 0;
         (void)(SysTick->CTRL);
     }
 #ifdef USE_HAL_DRIVER
@@ -66,56 +160,48 @@ void SysTick_Handler(void)
 #endif
 }
 
-// Return system uptime in microseconds (rollover in 70minutes)
-
-uint32_t microsISR(void)
+uint32_t cycles(void)
 {
-    register uint32_t ms, pending, cycle_cnt;
-
-    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
-        cycle_cnt = SysTick->VAL;
-
-        if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
-            // Update pending.
-            // Record it for multiple calls within the same rollover period
-            // (Will be cleared when serviced).
-            // Note that multiple rollovers are not considered.
-
-            sysTickPending = 1;
-
-            // Read VAL again to ensure the value is read after the rollover.
+    return DWT->CYCCNT;
+}
 
-            cycle_cnt = SysTick->VAL;
+// Return system uptime in microseconds, safe in any context. The systick updates the base with
+// the higher priority interrupts masked, so a copy that has no systick between its reads is consistent.
+uint64_t micros64(void)
+{
+    uint32_t ms;
+    uint64_t base;
+    uint32_t elapsedCycles;
+
+#ifdef USE_SCHEDULER_IDLE_SLEEP
+    if (cycleCounterResyncing) {
+        ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+            if (cycleCounterResyncing) {
+                cycleCounterResync();
+            }
         }
+    }
+#endif
 
+    do {
         ms = sysTickUptime;
-        pending = sysTickPending;
-    }
+        base = microsBase;
+        elapsedCycles = DWT->CYCCNT - cycleCounterBase;
+    } while (ms != sysTickUptime);
 
-    return ((ms + pending) * 1000) + (usTicks * 1000 - cycle_cnt) / usTicks;
+    return base + cyclesToMicros(elapsedCycles);
 }
 
+// Return system uptime in microseconds (rollover in 70minutes)
 uint32_t micros(void)
 {
-    register uint32_t ms, cycle_cnt;
-
-    // Call microsISR() in interrupt and elevated (non-zero) BASEPRI context
-
-    if ((SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) || (__get_BASEPRI())) {
-        return microsISR();
-    }
-
-    do {
-        ms = sysTickUptime;
-        cycle_cnt = SysTick->VAL;
-        /*
-         * If the SysTick timer expired during the previous instruction, we need to give it a little time for that
-         * interrupt to be delivered before we can recheck sysTickUptime:
-         */
-        asm volatile("\tnop\n");
-    } while (ms != sysTickUptime);
+    return micros64();
+}
 
-    return (ms * 1000) + (usTicks * 1000 - cycle_cnt) / usTicks;
+// the same as micros(), kept for the callers that are known to run in interrupt context
+uint32_t microsISR(void)
+{
+    return micros64();
 }
 
 // Return system uptime in milliseconds (rollover in 49 days)
@@ -29,7 +29,10 @@ void delay(timeMs_t ms);
 
 timeUs_t micros(void);
 timeUs_t microsISR(void);
+uint64_t micros64(void);
 timeMs_t millis(void);
+// the core cycle counter, for timing short stretches of code
+uint32_t cycles(void);
 
 uint32_t ticks(void);
 timeDelta_t ticks_diff_us(uint32_t begin, uint32_t end);
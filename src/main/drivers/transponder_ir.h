@@ -53,6 +53,9 @@
 /*** ERLT ***/
 #define TRANSPONDER_DATA_LENGTH_ERLT        1
 
+// the longest code of all providers
+#define TRANSPONDER_DATA_LENGTH_MAX         TRANSPONDER_DATA_LENGTH_ARCITIMER
+
 #define ERLTBitQuiet                        0
 #define ERLTCyclesForOneBit                 25
 #define ERLTCyclesForZeroBit                10
@@ -101,6 +104,10 @@ typedef struct transponder_s {
     #endif
 
     const struct transponderVTable *vTable;
+
+    // the code the DMA buffer holds, the buffer is only encoded again when the code changes
+    bool dataEncoded;
+    uint8_t encodedData[TRANSPONDER_DATA_LENGTH_MAX];
 } transponder_t;
 
 typedef enum {
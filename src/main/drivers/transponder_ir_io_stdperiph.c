@@ -50,7 +50,7 @@ static DMA_Stream_TypeDef *dmaRef = NULL;
 #error "Transponder not supported on this MCU."
 #endif
 
-transponder_t transponder;
+DMA_RAM transponder_t transponder;
 
 static void TRANSPONDER_DMA_IRQHandler(dmaChannelDescriptor_t* descriptor)
 {
@@ -174,6 +174,7 @@ bool transponderIrInit(const ioTag_t ioTag, const transponderProvider_e provider
         default:
             return false;
     }
+    transponder.dataEncoded = false;
 
     transponderIrHardwareInit(ioTag, &transponder);
 
@@ -198,8 +199,14 @@ void transponderIrWaitForTransmitComplete(void)
 
 void transponderIrUpdateData(const uint8_t* transponderData)
 {
-     transponderIrWaitForTransmitComplete();
-     transponder.vTable->updateTransponderDMABuffer(&transponder, transponderData);
+    if (transponder.dataEncoded && memcmp(transponder.encodedData, transponderData, sizeof(transponder.encodedData)) == 0) {
+        return;
+    }
+
+    transponderIrWaitForTransmitComplete();
+    transponder.vTable->updateTransponderDMABuffer(&transponder, transponderData);
+    memcpy(transponder.encodedData, transponderData, sizeof(transponder.encodedData));
+    transponder.dataEncoded = true;
 }
 
 void transponderIrDMAEnable(transponder_t *transponder)
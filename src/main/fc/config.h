@@ -41,6 +41,8 @@ typedef struct systemConfig_s {
     uint8_t rateProfile6PosSwitch;
     uint8_t cpu_overclock;
     uint8_t powerOnArmingGraceTime; // in seconds
+    uint8_t scheduler_idle_sleep;   // off, on - sleep until the next interrupt when no task is due
+    uint8_t imu_task_chaining;      // off, on - run the accelerometer and attitude tasks straight after the PID loop
     char boardIdentifier[sizeof(TARGET_BOARD_IDENTIFIER) + 1];
 } systemConfig_t;
 
@@ -26,8 +26,11 @@
 #include "platform.h"
 
 #include "build/debug.h"
+#include "build/motor_timing.h"
+#include "build/profiler.h"
 
 #include "blackbox/blackbox.h"
+#include "blackbox/blackbox_fielddefs.h"
 
 #include "common/axis.h"
 #include "common/filter.h"
@@ -41,6 +44,7 @@
 
 #include "drivers/light_led.h"
 #include "drivers/sound_beeper.h"
+#include "drivers/swi.h"
 #include "drivers/system.h"
 #include "drivers/time.h"
 #include "drivers/transponder_ir.h"
@@ -87,6 +91,7 @@
 #include "flight/imu.h"
 #include "flight/mixer.h"
 #include "flight/pid.h"
+#include "flight/rpm_filter.h"
 #include "flight/servos.h"
 #include "flight/gps_rescue.h"
 
@@ -313,31 +318,72 @@ void updateArmingStatus(void)
     }
 }
 
+// The rest of a disarm once ARMED has been cleared
+static void disarmComplete(void)
+{
+#ifdef USE_BLACKBOX
+    if (blackboxConfig()->device && blackboxConfig()->mode != BLACKBOX_MODE_ALWAYS_ON) { // Close the log upon disarm except when logging mode is ALWAYS ON
+        blackboxFinish();
+    }
+#endif
+    BEEP_OFF;
+#ifdef USE_DSHOT
+    if (isMotorProtocolDshot() && flipOverAfterCrashMode && !feature(FEATURE_3D)) {
+        pwmWriteDshotCommand(ALL_MOTORS, getMotorCount(), DSHOT_CMD_SPIN_DIRECTION_NORMAL, false);
+    }
+#endif
+    flipOverAfterCrashMode = false;
+
+    // if ARMING_DISABLED_RUNAWAY_TAKEOFF is set then we want to play it's beep pattern instead
+    if (!(getArmingDisableFlags() & ARMING_DISABLED_RUNAWAY_TAKEOFF)) {
+        beeper(BEEPER_DISARMING);      // emit disarm tone
+    }
+}
+
 void disarm(void)
 {
     if (ARMING_FLAG(ARMED)) {
         DISABLE_ARMING_FLAG(ARMED);
         lastDisarmTimeUs = micros();
+        disarmComplete();
+    }
+}
 
-#ifdef USE_BLACKBOX
-        if (blackboxConfig()->device && blackboxConfig()->mode != BLACKBOX_MODE_ALWAYS_ON) { // Close the log upon disarm except when logging mode is ALWAYS ON
-            blackboxFinish();
-        }
+// Work the PID loop leaves to TASK_MAIN when it runs preemptively, see pidLoopProcessDeferred()
+#define PID_LOOP_DEFERRED_DISARM            (1 << 0)
+#define PID_LOOP_DEFERRED_PID_RATE_CHANGE   (1 << 1)
+
+#ifdef USE_PREEMPTIVE_PID_LOOP
+static FAST_RAM_ZERO_INIT volatile uint8_t pidLoopDeferredWork;
 #endif
-        BEEP_OFF;
-#ifdef USE_DSHOT
-        if (isMotorProtocolDshot() && flipOverAfterCrashMode && !feature(FEATURE_3D)) {
-            pwmWriteDshotCommand(ALL_MOTORS, getMotorCount(), DSHOT_CMD_SPIN_DIRECTION_NORMAL, false);
-        }
+
+// A preemptive PID loop must not interleave the blackbox, beeper and DShot updates of the task it preempted with its own,
+// so it only records the work. Returns false if the loop runs as a task, the caller then does the work straight away.
+static inline bool pidLoopDefer(uint8_t work)
+{
+#ifdef USE_PREEMPTIVE_PID_LOOP
+    if (schedulerInInterruptTask()) {
+        __atomic_fetch_or(&pidLoopDeferredWork, work, __ATOMIC_RELAXED);
+        return true;
+    }
+#else
+    UNUSED(work);
 #endif
-        flipOverAfterCrashMode = false;
+    return false;
+}
 
-        // if ARMING_DISABLED_RUNAWAY_TAKEOFF is set then we want to play it's beep pattern instead
-        if (!(getArmingDisableFlags() & ARMING_DISABLED_RUNAWAY_TAKEOFF)) {
-            beeper(BEEPER_DISARMING);      // emit disarm tone
-        }
+#ifdef USE_RUNAWAY_TAKEOFF
+static FAST_CODE void pidLoopDisarm(void)
+{
+    if (ARMING_FLAG(ARMED) && pidLoopDefer(PID_LOOP_DEFERRED_DISARM)) {
+        // stops the motors straight away, the rest of the disarm follows from TASK_MAIN
+        DISABLE_ARMING_FLAG(ARMED);
+        lastDisarmTimeUs = micros();
+    } else {
+        disarm();
     }
 }
+#endif
 
 void tryArm(void)
 {
@@ -464,7 +510,7 @@ static void updateInflightCalibrationState(void)
 void updateMagHold(void)
 {
     if (ABS(rcCommand[YAW]) < 15 && FLIGHT_MODE(MAG_MODE)) {
-        int16_t dif = DECIDEGREES_TO_DEGREES(attitude.values.yaw) - magHold;
+        int16_t dif = DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw) - magHold;
         if (dif <= -180)
             dif += 360;
         if (dif >= +180)
@@ -473,7 +519,7 @@ void updateMagHold(void)
         if (STATE(SMALL_ANGLE))
             rcCommand[YAW] -= dif * currentPidProfile->pid[PID_MAG].P / 30;    // 18 deg
     } else
-        magHold = DECIDEGREES_TO_DEGREES(attitude.values.yaw);
+        magHold = DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw);
 }
 #endif
 
@@ -774,7 +820,7 @@ bool processRx(timeUs_t currentTimeUs)
         rescheduleTask(TASK_ATTITUDE, TASK_PERIOD_HZ(500));
     } else {
         LED1_OFF;
-        rescheduleTask(TASK_ATTITUDE, TASK_PERIOD_HZ(100));
+        rescheduleTask(TASK_ATTITUDE, TASK_PERIOD_HZ(200));
     }
 
     if (!IS_RC_MODE_ACTIVE(BOXPREARM) && ARMING_FLAG(WAS_ARMED_WITH_PREARM)) {
@@ -787,7 +833,7 @@ bool processRx(timeUs_t currentTimeUs)
         if (IS_RC_MODE_ACTIVE(BOXMAG)) {
             if (!FLIGHT_MODE(MAG_MODE)) {
                 ENABLE_FLIGHT_MODE(MAG_MODE);
-                magHold = DECIDEGREES_TO_DEGREES(attitude.values.yaw);
+                magHold = DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw);
             }
         } else {
             DISABLE_FLIGHT_MODE(MAG_MODE);
@@ -856,7 +902,12 @@ static FAST_CODE void subTaskPidController(timeUs_t currentTimeUs)
     uint32_t startTime = 0;
     if (debugMode == DEBUG_PIDLOOP) {startTime = micros();}
     // PID - note this is function pointer set by setPIDController()
+    PROFILER_BEGIN(PROFILER_PID_CONTROLLER);
     pidController(currentPidProfile, &accelerometerConfig()->accelerometerTrims, currentTimeUs);
+    PROFILER_END(PROFILER_PID_CONTROLLER);
+#ifdef USE_MOTOR_TIMING
+    motorTimingTestPidDone();
+#endif
     DEBUG_SET(DEBUG_PIDLOOP, 1, micros() - startTime);
 
 #ifdef USE_RUNAWAY_TAKEOFF
@@ -882,7 +933,7 @@ static FAST_CODE void subTaskPidController(timeUs_t currentTimeUs)
                 runawayTakeoffTriggerUs = currentTimeUs + RUNAWAY_TAKEOFF_ACTIVATE_DELAY;
             } else if (currentTimeUs > runawayTakeoffTriggerUs) {
                 setArmingDisabled(ARMING_DISABLED_RUNAWAY_TAKEOFF);
-                disarm();
+                pidLoopDisarm();
             }
         } else {
             runawayTakeoffTriggerUs = 0;
@@ -898,9 +949,7 @@ static FAST_CODE void subTaskPidController(timeUs_t currentTimeUs)
 
 
 #ifdef USE_PID_AUDIO
-    if (isModeActivationConditionPresent(BOXPIDAUDIO)) {
-        pidAudioUpdate();
-    }
+    pidAudioSample();
 #endif
 }
 
@@ -919,7 +968,9 @@ static FAST_CODE_NOINLINE void subTaskPidSubprocesses(timeUs_t currentTimeUs)
 
 #ifdef USE_BLACKBOX
     if (!cliMode && blackboxConfig()->device) {
+        PROFILER_BEGIN(PROFILER_BLACKBOX_UPDATE);
         blackboxUpdate(currentTimeUs);
+        PROFILER_END(PROFILER_BLACKBOX_UPDATE);
     }
 #else
     UNUSED(currentTimeUs);
@@ -938,6 +989,33 @@ void subTaskTelemetryPollSensors(timeUs_t currentTimeUs)
 }
 #endif
 
+#ifdef USE_MOTOR_OUTPUT_SYNC
+static FAST_RAM_ZERO_INIT uint32_t motorOutputSyncMissed;
+
+// Holds the motor update back to a fixed time after the gyro sample, so the ESCs see
+// the same gyro to output latency however long the filters and PID took this loop.
+// The wait never runs past one loop time from the start of this loop, whatever the sample time says.
+static FAST_CODE void motorOutputSyncWait(timeUs_t currentTimeUs)
+{
+    timeUs_t outputAtUs = gyroGetSampleTimeUs() + MIN(motorConfig()->motorOutputDelayUs, targetPidLooptime);
+    if (cmpTimeUs(outputAtUs, currentTimeUs + targetPidLooptime) > 0) {
+        outputAtUs = currentTimeUs + targetPidLooptime;
+    }
+
+    if (cmpTimeUs(micros(), outputAtUs) > 0) {
+        motorOutputSyncMissed++;
+        return;
+    }
+    while (cmpTimeUs(outputAtUs, micros()) > 0) {
+    }
+}
+
+uint32_t getMotorOutputSyncMissedCount(void)
+{
+    return motorOutputSyncMissed;
+}
+#endif
+
 static FAST_CODE void subTaskMotorUpdate(timeUs_t currentTimeUs)
 {
     uint32_t startTime = 0;
@@ -952,7 +1030,12 @@ static FAST_CODE void subTaskMotorUpdate(timeUs_t currentTimeUs)
         startTime = micros();
     }
 
+    PROFILER_BEGIN(PROFILER_MIX_TABLE);
     mixTable(currentTimeUs, currentPidProfile->vbatPidCompensation);
+    PROFILER_END(PROFILER_MIX_TABLE);
+#ifdef USE_MOTOR_TIMING
+    motorTimingTestMixerDone();
+#endif
 
 #ifdef USE_SERVOS
     // motor outputs are used as sources for servo mixing, so motors must be calculated using mixTable() before servos.
@@ -961,7 +1044,16 @@ static FAST_CODE void subTaskMotorUpdate(timeUs_t currentTimeUs)
     }
 #endif
 
+#ifdef USE_MOTOR_OUTPUT_SYNC
+    // only worth the spin when the motors are actually flying the craft
+    if (motorConfig()->motorOutputDelayUs && ARMING_FLAG(ARMED)) {
+        motorOutputSyncWait(currentTimeUs);
+    }
+#endif
+
+    PROFILER_BEGIN(PROFILER_WRITE_MOTORS);
     writeMotors();
+    PROFILER_END(PROFILER_WRITE_MOTORS);
 
     DEBUG_SET(DEBUG_PIDLOOP, 2, micros() - startTime);
 }
@@ -994,11 +1086,79 @@ static FAST_CODE_NOINLINE void subTaskRcCommand(timeUs_t currentTimeUs)
 
 #if defined(USE_GPS_RESCUE)
     if (FLIGHT_MODE(GPS_RESCUE_MODE)) {
-        gpsRescueInjectRcCommands();
+        gpsRescueInjectRcCommands(currentTimeUs);
     }
 #endif
 }
 
+#ifdef USE_ADAPTIVE_PID_PROCESS_DENOM
+#define PID_LOOP_OVERRUN_PERCENT        50      // a loop starting this much later than the gyro looptime counts as an overrun
+#define PID_LOOP_DEGRADE_PERCENT        10      // overruns within a window that lower the PID loop rate
+#define PID_LOOP_RECOVER_PERCENT        1       // overruns within a window below which the PID loop rate may be raised again
+#define PID_LOOP_RECOVER_WINDOWS        5       // consecutive quiet windows needed before the PID loop rate is raised again
+#define PID_LOOP_ADAPT_WINDOW_US        1000000
+
+static FAST_RAM_ZERO_INIT uint32_t pidLoopAdaptIterations;
+static FAST_RAM_ZERO_INIT uint32_t pidLoopAdaptOverruns;
+static FAST_RAM_ZERO_INIT timeUs_t pidLoopAdaptWindowStartUs;
+static FAST_RAM_ZERO_INIT uint8_t pidLoopAdaptQuietWindows;
+
+static void pidLoopLogProcessDenomChange(void)
+{
+#ifdef USE_BLACKBOX
+    if (blackboxConfig()->device) {
+        flightLogEvent_pidRateChange_t eventData;
+        eventData.pidProcessDenom = pidGetProcessDenom();
+        eventData.pidLooptime = targetPidLooptime;
+        blackboxLogEvent(FLIGHT_LOG_EVENT_PID_RATE_CHANGE, (flightLogEventData_t *)&eventData);
+    }
+#endif
+}
+
+// Raises pid_process_denom while the PID loop keeps overrunning, and lowers it back
+// towards the configured value once the overruns have stayed away for a while
+static void pidLoopAdaptProcessDenom(timeUs_t currentTimeUs)
+{
+    pidLoopAdaptIterations++;
+    if (getTaskDeltaTime(TASK_SELF) > (timeDelta_t)(gyro.targetLooptime * (100 + PID_LOOP_OVERRUN_PERCENT) / 100)) {
+        pidLoopAdaptOverruns++;
+    }
+
+    if (cmpTimeUs(currentTimeUs, pidLoopAdaptWindowStartUs) < PID_LOOP_ADAPT_WINDOW_US) {
+        return;
+    }
+
+    const uint32_t overrunPercent = pidLoopAdaptOverruns * 100 / pidLoopAdaptIterations;
+    const uint8_t currentDenom = pidGetProcessDenom();
+    uint8_t denom = currentDenom;
+
+    if (overrunPercent >= PID_LOOP_DEGRADE_PERCENT) {
+        pidLoopAdaptQuietWindows = 0;
+        if (denom < MAX_PID_PROCESS_DENOM) {
+            denom++;
+        }
+    } else if (overrunPercent < PID_LOOP_RECOVER_PERCENT && denom > pidConfig()->pid_process_denom) {
+        if (++pidLoopAdaptQuietWindows >= PID_LOOP_RECOVER_WINDOWS) {
+            pidLoopAdaptQuietWindows = 0;
+            denom--;
+        }
+    } else {
+        pidLoopAdaptQuietWindows = 0;
+    }
+
+    if (denom != currentDenom) {
+        pidSetProcessDenom(currentPidProfile, denom);
+        if (!pidLoopDefer(PID_LOOP_DEFERRED_PID_RATE_CHANGE)) {
+            pidLoopLogProcessDenomChange();
+        }
+    }
+
+    pidLoopAdaptIterations = 0;
+    pidLoopAdaptOverruns = 0;
+    pidLoopAdaptWindowStartUs = currentTimeUs;
+}
+#endif
+
 // Function for loop trigger
 FAST_CODE void taskMainPidLoop(timeUs_t currentTimeUs)
 {
@@ -1013,10 +1173,31 @@ FAST_CODE void taskMainPidLoop(timeUs_t currentTimeUs)
     // 1 - subTaskPidController()
     // 2 - subTaskMotorUpdate()
     // 3 - subTaskPidSubprocesses()
+    PROFILER_BEGIN(PROFILER_GYRO_UPDATE);
     gyroUpdate(currentTimeUs);
+    PROFILER_END(PROFILER_GYRO_UPDATE);
     DEBUG_SET(DEBUG_PIDLOOP, 0, micros() - currentTimeUs);
 
-    if (pidUpdateCounter++ % pidConfig()->pid_process_denom == 0) {
+    bool runPid;
+#ifdef USE_GYRO_DECIMATION
+    if (gyroIsDecimating()) {
+        // the decimator sets the PID rate, so the denom can not be adapted
+        runPid = gyroDecimatedSampleAvailable();
+    } else
+#endif
+    {
+#ifdef USE_ADAPTIVE_PID_PROCESS_DENOM
+        if (pidConfig()->pid_process_denom_adaptive) {
+            pidLoopAdaptProcessDenom(currentTimeUs);
+        }
+#endif
+        runPid = (pidUpdateCounter++ % pidGetProcessDenom() == 0);
+    }
+
+    if (runPid) {
+#ifdef USE_RPM_FILTER
+        rpmFilterUpdate();
+#endif
         subTaskRcCommand(currentTimeUs);
         subTaskPidController(currentTimeUs);
         subTaskMotorUpdate(currentTimeUs);
@@ -1026,9 +1207,64 @@ FAST_CODE void taskMainPidLoop(timeUs_t currentTimeUs)
     if (debugMode == DEBUG_CYCLETIME) {
         debug[0] = getTaskDeltaTime(TASK_SELF);
         debug[1] = averageSystemLoadPercent;
+#ifndef SKIP_TASK_STATISTICS
+        debug[2] = averageIdlePercent;
+#endif
+    }
+}
+
+#ifdef USE_PREEMPTIVE_PID_LOOP
+static FAST_CODE void pidLoopSwiHandler(void)
+{
+    schedulerExecuteInterruptTask(micros());
+}
+
+// Runs the PID loop from a software interrupt triggered by the gyro data ready interrupt,
+// so it preempts whatever cooperative task is running. Returns false if the gyro has no data ready interrupt.
+//
+// The loop can then run in the middle of any background task. What the two share, and how it is kept consistent:
+// - rcCommand, isRXDataNew and currentRxRefreshRate (TASK_RX): updated under SWI_ATOMIC_BLOCK in taskUpdateRxMain().
+// - rMat and the Euler angles (TASK_ATTITUDE): written under SWI_ATOMIC_BLOCK, the loop works the angles out of
+//   rMat itself when they are stale.
+// - the gyro accumulation read by the attitude task: taken and cleared under SWI_ATOMIC_BLOCK.
+// - the accelerometer samples summed by the gyro burst reads: taken and cleared under SWI_ATOMIC_BLOCK in mpuAccRead().
+// - the rate curve of the rate profile: built in a second table and handed over with a pointer store.
+// - PID gains and a PID profile switch: staged by pidPrepareProfile() and taken by the loop at its start.
+// - the gyro lowpass and static notch filters: staged by gyroReconfigureFilters(), installed at the next gyroUpdate().
+// - the DShot command queue: commands are queued under SWI_ATOMIC_BLOCK.
+// - armingDisableFlags: the runaway takeoff check sets a flag from the loop, the setters use SWI_ATOMIC_BLOCK.
+// - the blackbox device buffer: events logged from tasks, and blackboxFinish(), use SWI_ATOMIC_BLOCK.
+// - disarming from the loop and its blackbox events: the loop only clears ARMED and leaves the rest to TASK_MAIN,
+//   see pidLoopDefer(). Beeps the loop asks for are started by beeperUpdate().
+// - the PID sums summed for PID audio: taken and cleared under SWI_ATOMIC_BLOCK in pidAudioUpdate().
+// - armingFlags: the loop only ever clears ARMED (runaway takeoff), which a task would only clear as well.
+// - SMALL_ANGLE: the loop may set it again from rMat, to the value the attitude task already worked out.
+// Single words the loop only reads (flight mode flags, rcData, the motor test values) and data the tasks only
+// display (motor, pidData, debug, task statistics) are left as they are.
+bool pidLoopPreemptionInit(void)
+{
+    swiInit(pidLoopSwiHandler);
+    if (!gyroSetDataReadyCallback(swiTrigger)) {
+        return false;
     }
+    schedulerSetInterruptTask(TASK_GYROPID);
+    return true;
 }
 
+// Called from TASK_MAIN to do the work a preemptive PID loop has left to it
+void pidLoopProcessDeferred(void)
+{
+    const uint8_t work = __atomic_exchange_n(&pidLoopDeferredWork, 0, __ATOMIC_RELAXED);
+    if (work & PID_LOOP_DEFERRED_DISARM) {
+        disarmComplete();
+    }
+#ifdef USE_ADAPTIVE_PID_PROCESS_DENOM
+    if (work & PID_LOOP_DEFERRED_PID_RATE_CHANGE) {
+        pidLoopLogProcessDenomChange();
+    }
+#endif
+}
+#endif
 
 bool isFlipOverAfterCrashMode(void)
 {
@@ -49,7 +49,10 @@ bool processRx(timeUs_t currentTimeUs);
 void updateArmingStatus(void);
 
 void taskMainPidLoop(timeUs_t currentTimeUs);
+bool pidLoopPreemptionInit(void);
+void pidLoopProcessDeferred(void);
 bool isFlipOverAfterCrashMode(void);
+uint32_t getMotorOutputSyncMissedCount(void);
 
 void runawayTakeoffTemporaryDisable(uint8_t disableFlag);
 bool isAirmodeActivated();
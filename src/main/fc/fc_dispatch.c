@@ -30,38 +30,139 @@
 
 #include "fc/fc_dispatch.h"
 
-static dispatchEntry_t *head = NULL;
-static bool dispatchEnabled = false;
+// Pending entries are kept in a hierarchical timer wheel, so adding, cancelling and expiring an entry
+// take constant time however many entries are pending. Level 0 has one slot per tick, each higher level
+// covers DISPATCH_WHEEL_SLOTS times the time span of the level below it. Entries on the higher levels are
+// moved down (cascaded) as time moves on until they end up in the level 0 slot of the tick they expire in.
+#define DISPATCH_TICK_SHIFT     7       // 128us per tick
+#define DISPATCH_TICK_US        (1 << DISPATCH_TICK_SHIFT)
+#define DISPATCH_WHEEL_BITS     6
+#define DISPATCH_WHEEL_SLOTS    (1 << DISPATCH_WHEEL_BITS)
+#define DISPATCH_WHEEL_MASK     (DISPATCH_WHEEL_SLOTS - 1)
+#define DISPATCH_WHEEL_LEVELS   4       // 64^4 ticks, enough for any positive int delay
+#define DISPATCH_MAX_TICKS      ((1U << (DISPATCH_WHEEL_BITS * DISPATCH_WHEEL_LEVELS)) - 1)
 
-bool dispatchIsEnabled(void)
+static dispatchEntry_t *dispatchWheel[DISPATCH_WHEEL_LEVELS][DISPATCH_WHEEL_SLOTS];
+static uint32_t dispatchTick;           // next tick to be processed
+static uint32_t dispatchTickTime;       // time at which dispatchTick is due
+static int dispatchPending;
+
+static void dispatchLink(dispatchEntry_t **head, dispatchEntry_t *entry)
+{
+    entry->next = *head;
+    if (entry->next) {
+        entry->next->pprev = &entry->next;
+    }
+    entry->pprev = head;
+    *head = entry;
+}
+
+static void dispatchUnlink(dispatchEntry_t *entry)
+{
+    *entry->pprev = entry->next;
+    if (entry->next) {
+        entry->next->pprev = entry->pprev;
+    }
+    entry->next = NULL;
+    entry->pprev = NULL;
+}
+
+static void dispatchInsert(dispatchEntry_t *entry)
+{
+    // expire in the first tick that is not due before the entry
+    const int32_t delay = cmp32(entry->delayedUntil, dispatchTickTime);
+    uint32_t ticks = delay > 0 ? ((uint32_t)delay + DISPATCH_TICK_US - 1) >> DISPATCH_TICK_SHIFT : 0;
+    if (ticks > DISPATCH_MAX_TICKS) {
+        ticks = DISPATCH_MAX_TICKS;
+    }
+    const uint32_t expires = dispatchTick + ticks;
+
+    int level = 0;
+    while (ticks >= (1U << (DISPATCH_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    const int slot = (expires >> (DISPATCH_WHEEL_BITS * level)) & DISPATCH_WHEEL_MASK;
+    dispatchLink(&dispatchWheel[level][slot], entry);
+}
+
+static void dispatchCascade(int level, int slot)
 {
-    return dispatchEnabled;
+    dispatchEntry_t *entry = dispatchWheel[level][slot];
+    dispatchWheel[level][slot] = NULL;
+    while (entry) {
+        dispatchEntry_t *next = entry->next;
+        dispatchInsert(entry);
+        entry = next;
+    }
 }
 
-void dispatchEnable(void)
+// Nothing can expire while the wheel is empty, so jump straight to the current tick
+static void dispatchSkipIdleTicks(uint32_t currentTime)
 {
-    dispatchEnabled = true;
+    const int32_t behind = cmp32(currentTime, dispatchTickTime);
+    if (dispatchPending == 0 && behind >= 0) {
+        const uint32_t ticks = ((uint32_t)behind >> DISPATCH_TICK_SHIFT) + 1;
+        dispatchTick += ticks;
+        dispatchTickTime += ticks << DISPATCH_TICK_SHIFT;
+    }
 }
 
 void dispatchProcess(uint32_t currentTime)
 {
-    for (dispatchEntry_t **p = &head; *p; ) {
-        if (cmp32(currentTime, (*p)->delayedUntil) < 0)
-            break;
-        // unlink entry first, so handler can replan self
-        dispatchEntry_t *current = *p;
-        *p = (*p)->next;
-        (*current->dispatch)(current);
+    dispatchSkipIdleTicks(currentTime);
+
+    while (cmp32(currentTime, dispatchTickTime) >= 0) {
+        for (int level = 1; level < DISPATCH_WHEEL_LEVELS; level++) {
+            if ((dispatchTick >> (DISPATCH_WHEEL_BITS * (level - 1))) & DISPATCH_WHEEL_MASK) {
+                break;
+            }
+            dispatchCascade(level, (dispatchTick >> (DISPATCH_WHEEL_BITS * level)) & DISPATCH_WHEEL_MASK);
+        }
+
+        // move the expired entries out of the wheel first, so handlers can replan or cancel any entry
+        dispatchEntry_t *expired = NULL;
+        dispatchEntry_t **slot = &dispatchWheel[0][dispatchTick & DISPATCH_WHEEL_MASK];
+        if (*slot) {
+            expired = *slot;
+            expired->pprev = &expired;
+            *slot = NULL;
+        }
+        dispatchTick++;
+        dispatchTickTime += DISPATCH_TICK_US;
+
+        while (expired) {
+            dispatchEntry_t *current = expired;
+            dispatchUnlink(current);
+            dispatchPending--;
+            (*current->dispatch)(current);
+        }
     }
 }
 
 void dispatchAdd(dispatchEntry_t *entry, int delayUs)
 {
-    uint32_t delayedUntil = micros() + delayUs;
-    entry->delayedUntil = delayedUntil;
-    dispatchEntry_t **p = &head;
-    while (*p && cmp32((*p)->delayedUntil, delayedUntil) < 0)
-        p = &(*p)->next;
-    entry->next = *p;
-    *p = entry;
+    const uint32_t currentTime = micros();
+    dispatchCancel(entry);
+    dispatchSkipIdleTicks(currentTime);
+    entry->delayedUntil = currentTime + delayUs;
+    dispatchInsert(entry);
+    dispatchPending++;
+}
+
+void dispatchCancel(dispatchEntry_t *entry)
+{
+    if (entry->pprev) {
+        dispatchUnlink(entry);
+        dispatchPending--;
+    }
+}
+
+bool dispatchIsPending(const dispatchEntry_t *entry)
+{
+    return entry->pprev != NULL;
+}
+
+int dispatchPendingCount(void)
+{
+    return dispatchPending;
 }
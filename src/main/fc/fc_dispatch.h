@@ -27,9 +27,11 @@ typedef struct dispatchEntry_s {
     dispatchFunc *dispatch;
     uint32_t delayedUntil;
     struct dispatchEntry_s *next;
+    struct dispatchEntry_s **pprev;     // link pointing at this entry, NULL while the entry is not pending
 } dispatchEntry_t;
 
-bool dispatchIsEnabled(void);
-void dispatchEnable(void);
 void dispatchProcess(uint32_t currentTime);
 void dispatchAdd(dispatchEntry_t *entry, int delayUs);
+void dispatchCancel(dispatchEntry_t *entry);
+bool dispatchIsPending(const dispatchEntry_t *entry);
+int dispatchPendingCount(void);
@@ -23,6 +23,8 @@
 
 #include "platform.h"
 
+#include "build/crash_trace.h"
+
 #include "drivers/light_led.h"
 #include "drivers/time.h"
 #include "drivers/transponder_ir.h"
@@ -91,9 +93,32 @@ void hard_fault_handler_c(unsigned long *hardfault_args)
   __asm("BKPT #0\n") ; // Break into the debugger
 }
 
+#else
+#ifdef USE_CRASH_TRACE
+void hardFaultHandler(uint32_t *exceptionFrame);
+
+// the registers stacked on the fault are on the main or the process stack, as given by EXC_RETURN in lr
+__attribute__((naked)) void HardFault_Handler(void)
+{
+    __asm volatile (
+        "tst lr, #4\n"
+        "ite eq\n"
+        "mrseq r0, msp\n"
+        "mrsne r0, psp\n"
+        "b hardFaultHandler\n"
+    );
+}
+
+__attribute__((used)) void hardFaultHandler(uint32_t *exceptionFrame)
 #else
 void HardFault_Handler(void)
+#endif
 {
+#ifdef USE_CRASH_TRACE
+    // first, stopping the motors may fault again
+    crashTraceFault(exceptionFrame);
+#endif
+
     LED2_ON;
 
 #ifndef USE_OSD_SLAVE
@@ -152,6 +152,7 @@
 #include "flight/imu.h"
 #include "flight/mixer.h"
 #include "flight/pid.h"
+#include "flight/rpm_filter.h"
 #include "flight/servos.h"
 
 #include "io/rcdevice_cam.h"
@@ -161,7 +162,10 @@
 #endif
 
 #include "build/build_config.h"
+#include "build/crash_trace.h"
 #include "build/debug.h"
+#include "build/motor_timing.h"
+#include "build/profiler.h"
 
 #ifdef TARGET_PREINIT
 void targetPreInit(void);
@@ -200,6 +204,46 @@ static IO_t busSwitchResetPin        = IO_NONE;
 }
 #endif
 
+#ifdef USE_OVERCLOCK
+#define OVERCLOCK_SELF_TEST_SEED    0x5eed
+#define OVERCLOCK_SELF_TEST_RESULT  0x2ea46e51  // overclockSelfTestRun(OVERCLOCK_SELF_TEST_SEED) on working silicon
+
+// Integer, division, float and memory work, with the branches, the divisors and the addresses all
+// depending on the data. The float products are exact, so fused multiply-adds give the same sum.
+static uint32_t overclockSelfTestRun(uint32_t seed)
+{
+    uint32_t buffer[64];
+    for (unsigned i = 0; i < ARRAYLEN(buffer); i++) {
+        buffer[i] = i;
+    }
+    uint32_t value = seed;
+    float sum = 0;
+    for (unsigned i = 0; i < 1024; i++) {
+        value = value * 1664525 + 1013904223;
+        uint32_t *slot = &buffer[value >> 26];
+        if (value & 0x8000) {
+            *slot += value / ((value & 0xff) | 1);
+        } else {
+            *slot ^= value;
+        }
+        sum += (float)(value >> 22) * (float)(value & 0x3ff);
+    }
+    for (unsigned i = 0; i < ARRAYLEN(buffer); i++) {
+        value = value * 31 + buffer[i];
+    }
+    return value ^ (uint32_t)sum;
+}
+
+// Silicon that does not keep up with the overclocked core clock tends to get some of the work wrong,
+// the result then differs from the known one
+static bool overclockSelfTest(void)
+{
+    // read at run time, so the compiler can't work the result out in advance
+    static volatile uint32_t seed = OVERCLOCK_SELF_TEST_SEED;
+    return overclockSelfTestRun(seed) == OVERCLOCK_SELF_TEST_RESULT;
+}
+#endif
+
 void init(void)
 {
 #ifdef USE_ITCM_RAM
@@ -226,6 +270,21 @@ void init(void)
 
     systemInit();
 
+#ifdef USE_CRASH_TRACE
+    crashTraceInit();
+#endif
+
+#ifdef USE_PROFILER
+    profilerInit();
+#endif
+
+#ifdef USE_MOTOR_TIMING
+    motorTimingInit();
+#endif
+
+    // the filters are set up from the table
+    trigTableInit();
+
     // initialize IO (needed for all IO operations)
     IOInitGlobal();
 
@@ -317,6 +376,10 @@ void init(void)
 
 #ifdef USE_OVERCLOCK
     OverclockRebootIfNecessary(systemConfig()->cpu_overclock);
+    if (SystemCoreClock != SystemCoreClockStock() && !overclockSelfTest()) {
+        // the next boot falls back to the stock clock
+        systemReset();
+    }
 #endif
 
     delay(100);
@@ -491,7 +554,13 @@ void init(void)
     // gyro.targetLooptime set in sensorsAutodetect(),
     // so we are ready to call validateAndFixGyroConfig(), pidInit(), and setAccelerationFilter()
     validateAndFixGyroConfig();
+#ifdef USE_GYRO_DECIMATION
+    gyroSetDecimation(pidConfig()->pid_process_denom);
+#endif
     pidInit(currentPidProfile);
+#ifdef USE_RPM_FILTER
+    rpmFilterInit();
+#endif
     accInitFilters();
 
 #ifdef USE_PID_AUDIO
@@ -503,7 +572,9 @@ void init(void)
     servoConfigureOutput();
     if (isMixerUsingServos()) {
         //pwm_params.useChannelForwarding = feature(FEATURE_CHANNEL_FORWARDING);
-        servoDevInit(&servoConfig()->dev);
+        servoDevConfig_t servoDevConfig = servoConfig()->dev;
+        servoDevConfig.servoPwmRate = servoGetPwmRate();
+        servoDevInit(&servoDevConfig);
     }
     servosFilterInit();
 #endif
@@ -671,7 +742,9 @@ void init(void)
     if (mixerConfig()->mixerMode == MIXER_GIMBAL) {
         accSetCalibrationCycles(CALIBRATING_ACC_CYCLES);
     }
-    gyroStartCalibration(false);
+    if (!gyroTempCompSetZero()) {
+        gyroStartCalibration(false);
+    }
 #ifdef USE_BARO
     baroSetCalibrationCycles(CALIBRATING_BARO_CYCLES);
 #endif
@@ -743,5 +816,10 @@ void init(void)
 
     fcTasksInit();
 
+#ifdef USE_OVERCLOCK
+    // the clock has run everything through init, it is kept for the boots to come
+    OverclockBootCompleted();
+#endif
+
     systemState |= SYSTEM_STATE_READY;
 }
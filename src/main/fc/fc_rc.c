@@ -25,6 +25,7 @@
 #include "platform.h"
 
 #include "build/debug.h"
+#include "build/motor_timing.h"
 
 #include "common/axis.h"
 #include "common/maths.h"
@@ -113,6 +114,25 @@ static int16_t rcLookupThrottle(int32_t tmp)
 #define SETPOINT_RATE_LIMIT 1998.0f
 #define RC_RATE_INCREMENTAL 14.54f
 
+// The rate curves are odd functions of the stick deflection, so the table only covers [0, 1].
+// It holds the rates before the rate limit, so the limit does not put a corner between two
+// entries. The entries are spaced evenly in 1 - sqrt(1 - deflection), which puts them closer
+// together towards full stick where super rates make the curve steep. The interpolation error
+// stays under 0.5 deg/s at an RC rate of 1 and super rates up to 0.95.
+// The curve of a new rate profile is built in the table the PID loop is not using and handed over
+// with a single pointer store, so a preemptive PID loop never reads a half built table.
+#define SETPOINT_LOOKUP_LENGTH 129
+static FAST_RAM_ZERO_INIT float lookupSetpointRateTables[2][XYZ_AXIS_COUNT][SETPOINT_LOOKUP_LENGTH];
+static float (* volatile lookupSetpointRate)[SETPOINT_LOOKUP_LENGTH] = lookupSetpointRateTables[0];    // lookup table for the rate curve of the current rate profile
+
+static float rcLookupSetpointRate(int axis, float rcCommandfAbs)
+{
+    const float *lookup = lookupSetpointRate[axis];
+    const float position = (1.0f - sqrtf(1.0f - MIN(rcCommandfAbs, 1.0f))) * (SETPOINT_LOOKUP_LENGTH - 1);
+    const int index = MIN((int)position, SETPOINT_LOOKUP_LENGTH - 2);
+    return lookup[index] + (position - index) * (lookup[index + 1] - lookup[index]);
+}
+
 float applyBetaflightRates(const int axis, float rcCommandf, const float rcCommandfAbs)
 {
     if (currentControlRateProfile->rcExpo[axis]) {
@@ -152,7 +172,8 @@ static void calculateSetpointRate(int axis)
     const float rcCommandfAbs = ABS(rcCommandf);
     rcDeflectionAbs[axis] = rcCommandfAbs;
 
-    float angleRate = applyRates(axis, rcCommandf, rcCommandfAbs);
+    const float angleRateAbs = rcLookupSetpointRate(axis, rcCommandfAbs);
+    const float angleRate = rcCommandf < 0 ? -angleRateAbs : angleRateAbs;
 
     DEBUG_SET(DEBUG_ANGLERATE, axis, angleRate);
 
@@ -518,6 +539,66 @@ FAST_CODE uint8_t processRcSmoothingFilter(void)
 }
 #endif // USE_RC_SMOOTHING_FILTER
 
+#ifdef USE_RC_PREDICTION
+// Each frame gives a new sample of the sticks and, from the frame times taken by the receiver
+// driver, the slope since the previous sample. rcCommand ramps from where it is to the value that
+// slope projects for the expected arrival of the next frame. Unlike the interpolation it does
+// not lag a frame behind, and it does not step when a frame comes early or late.
+static FAST_CODE uint8_t processRcPrediction(void)
+{
+    static FAST_RAM_ZERO_INIT float rcCommandPredicted[PRIMARY_CHANNEL_COUNT];
+    static FAST_RAM_ZERO_INIT float rcCommandPrevious[PRIMARY_CHANNEL_COUNT];
+    static FAST_RAM_ZERO_INIT float rcStepSize[PRIMARY_CHANNEL_COUNT];
+    static FAST_RAM_ZERO_INIT timeUs_t previousFrameTimeUs;
+    static FAST_RAM_ZERO_INIT int rcPredictionStepCount;
+
+    uint8_t updatedChannel = 0;
+
+    if (isRXDataNew) {
+        const timeUs_t frameTimeUs = rxGetFrameTimeUs();
+        const timeDelta_t frameDeltaUs = cmpTimeUs(frameTimeUs, previousFrameTimeUs);
+        previousFrameTimeUs = frameTimeUs;
+        const float frameIntervalUs = rxGetFrameIntervalUs();
+        // without a measured frame rate there is nothing to predict, the sample is taken as it is
+        const bool predict = frameIntervalUs > 0 && frameDeltaUs > 0 && frameDeltaUs < 2 * frameIntervalUs;
+
+        // the time left until the next frame is expected, the frame may have waited for the RX task
+        const float remainingUs = frameIntervalUs - cmpTimeUs(micros(), frameTimeUs);
+        rcPredictionStepCount = MAX(lrintf(remainingUs / targetPidLooptime), 1);
+
+        for (int channel = 0; channel < PRIMARY_CHANNEL_COUNT; channel++) {
+            if ((1 << channel) & interpolationChannels) {
+                float target = rcCommand[channel];
+                if (predict) {
+                    target += (rcCommand[channel] - rcCommandPrevious[channel]) * frameIntervalUs / frameDeltaUs;
+                    target = channel == THROTTLE ? constrainf(target, PWM_RANGE_MIN, PWM_RANGE_MAX) : constrainf(target, -500, 500);
+                }
+                rcCommandPrevious[channel] = rcCommand[channel];
+                rcStepSize[channel] = (target - rcCommandPredicted[channel]) / rcPredictionStepCount;
+            }
+        }
+
+        DEBUG_SET(DEBUG_RC_INTERPOLATION, 0, lrintf(rcCommand[0]));
+        DEBUG_SET(DEBUG_RC_INTERPOLATION, 1, lrintf(rxGetFrameJitterUs()));
+    }
+
+    // once the target is reached rcCommand holds it until the next frame
+    if (rcPredictionStepCount > 0) {
+        rcPredictionStepCount--;
+        for (updatedChannel = 0; updatedChannel < PRIMARY_CHANNEL_COUNT; updatedChannel++) {
+            if ((1 << updatedChannel) & interpolationChannels) {
+                rcCommandPredicted[updatedChannel] += rcStepSize[updatedChannel];
+                rcCommand[updatedChannel] = rcCommandPredicted[updatedChannel];
+            }
+        }
+    }
+
+    DEBUG_SET(DEBUG_RC_INTERPOLATION, 2, rcPredictionStepCount);
+
+    return updatedChannel;
+}
+#endif // USE_RC_PREDICTION
+
 FAST_CODE void processRcCommand(void)
 {
     uint8_t updatedChannel;
@@ -532,6 +613,11 @@ FAST_CODE void processRcCommand(void)
         updatedChannel = processRcSmoothingFilter();
         break;
 #endif // USE_RC_SMOOTHING_FILTER
+#ifdef USE_RC_PREDICTION
+    case RC_SMOOTHING_TYPE_PREDICTION:
+        updatedChannel = processRcPrediction();
+        break;
+#endif
     case RC_SMOOTHING_TYPE_INTERPOLATION:
     default:
         updatedChannel = processRcInterpolation();
@@ -560,6 +646,9 @@ FAST_CODE void processRcCommand(void)
     }
 
     if (isRXDataNew) {
+#ifdef USE_MOTOR_TIMING
+        motorTimingRxSetpoint(rxGetRcDataFrameUs());
+#endif
         isRXDataNew = false;
     }
 }
@@ -692,6 +781,16 @@ void initRcProcessing(void)
         break;
     }
 
+    float (*table)[SETPOINT_LOOKUP_LENGTH] = lookupSetpointRate == lookupSetpointRateTables[0] ? lookupSetpointRateTables[1] : lookupSetpointRateTables[0];
+    for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+        for (int i = 0; i < SETPOINT_LOOKUP_LENGTH; i++) {
+            const float position = 1.0f - (float)i / (SETPOINT_LOOKUP_LENGTH - 1);
+            const float rcCommandf = 1.0f - position * position;
+            table[axis][i] = applyRates(axis, rcCommandf, rcCommandf);
+        }
+    }
+    lookupSetpointRate = table;
+
     interpolationChannels = 0;
     switch (rxConfig()->rcInterpolationChannels) {
     case INTERPOLATION_CHANNELS_RPYT:
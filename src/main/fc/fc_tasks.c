@@ -24,6 +24,8 @@
 
 #include "platform.h"
 
+#include "blackbox/blackbox.h"
+
 #include "build/debug.h"
 
 #include "cms/cms.h"
@@ -40,6 +42,7 @@
 #include "drivers/serial.h"
 #include "drivers/serial_usb_vcp.h"
 #include "drivers/stack_check.h"
+#include "drivers/swi.h"
 #include "drivers/transponder_ir.h"
 #include "drivers/usb_io.h"
 #include "drivers/vtx_common.h"
@@ -49,6 +52,7 @@
 #include "fc/fc_rc.h"
 #include "fc/fc_dispatch.h"
 #include "fc/rc_controls.h"
+#include "fc/rc_modes.h"
 #include "fc/runtime_config.h"
 
 #include "flight/position.h"
@@ -62,10 +66,12 @@
 #include "io/asyncfatfs/asyncfatfs.h"
 #include "io/beeper.h"
 #include "io/dashboard.h"
+#include "io/flashfs.h"
 #include "io/gps.h"
 #include "io/ledstrip.h"
 #include "io/osd.h"
 #include "io/osd_slave.h"
+#include "io/pidaudio.h"
 #include "io/piniobox.h"
 #include "io/serial.h"
 #include "io/transponder_ir.h"
@@ -76,6 +82,7 @@
 
 #include "msp/msp_serial.h"
 
+#include "pg/flash.h"
 #include "pg/rx.h"
 
 #include "rx/rx.h"
@@ -113,11 +120,15 @@
 
 static void taskMain(timeUs_t currentTimeUs)
 {
-    UNUSED(currentTimeUs);
+#ifdef USE_PREEMPTIVE_PID_LOOP
+    pidLoopProcessDeferred();
+#endif
 
 #ifdef USE_SDCARD
     afatfs_poll();
 #endif
+
+    gyroTempCompUpdate(currentTimeUs);
 }
 
 #ifdef USE_OSD_SLAVE
@@ -137,6 +148,7 @@ static void taskHandleSerial(timeUs_t currentTimeUs)
 #if defined(USE_VCP)
     DEBUG_SET(DEBUG_USB, 0, usbCableIsInserted());
     DEBUG_SET(DEBUG_USB, 1, usbVcpIsConnected());
+    usbVcpFlushPending(currentTimeUs);
 #endif
 
 #ifdef USE_CLI
@@ -176,19 +188,22 @@ static void taskUpdateRxMain(timeUs_t currentTimeUs)
         return;
     }
 
-    static timeUs_t lastRxTimeUs;
-    currentRxRefreshRate = constrain(currentTimeUs - lastRxTimeUs, 1000, 20000);
-    lastRxTimeUs = currentTimeUs;
-    isRXDataNew = true;
-
 #ifdef USE_USB_CDC_HID
     if (!ARMING_FLAG(ARMED)) {
         sendRcDataToHid();
     }
 #endif
 
-    // updateRcCommands sets rcCommand, which is needed by updateAltHoldState and updateSonarAltHoldState
-    updateRcCommands();
+    static timeUs_t lastRxTimeUs;
+    // a preemptive PID loop must not see isRXDataNew before the rcCommand it goes with, or a stick half way negated
+    SWI_ATOMIC_BLOCK {
+        currentRxRefreshRate = constrain(currentTimeUs - lastRxTimeUs, 1000, 20000);
+        lastRxTimeUs = currentTimeUs;
+        isRXDataNew = true;
+
+        // updateRcCommands sets rcCommand, which is needed by updateAltHoldState and updateSonarAltHoldState
+        updateRcCommands();
+    }
     updateArmingStatus();
 }
 #endif
@@ -207,6 +222,16 @@ static void taskUpdateBaro(timeUs_t currentTimeUs)
 }
 #endif
 
+#ifdef USE_RANGEFINDER
+static void taskUpdateRangefinder(timeUs_t currentTimeUs)
+{
+    if (sensors(SENSOR_RANGEFINDER)) {
+        rangefinderUpdate(currentTimeUs);
+        rangefinderProcess(getCosTiltAngle());
+    }
+}
+#endif
+
 #if defined(USE_BARO) || defined(USE_GPS)
 static void taskCalculateAltitude(timeUs_t currentTimeUs)
 {
@@ -236,6 +261,24 @@ static void taskCameraControl(uint32_t currentTime)
 }
 #endif
 
+#ifdef USE_FLASHFS
+static void taskFlashfsEraseAhead(timeUs_t currentTimeUs)
+{
+    UNUSED(currentTimeUs);
+
+    flashfsEraseAheadUpdate();
+}
+#endif
+
+#ifdef USE_BLACKBOX_ASYNC
+static void taskBlackbox(timeUs_t currentTimeUs)
+{
+    if (!cliMode && blackboxConfig()->device) {
+        blackboxAsyncUpdate(currentTimeUs);
+    }
+}
+#endif
+
 void fcTasksInit(void)
 {
     schedulerInit();
@@ -270,17 +313,36 @@ void fcTasksInit(void)
     if (sensors(SENSOR_GYRO)) {
         rescheduleTask(TASK_GYROPID, gyro.targetLooptime);
         setTaskEnabled(TASK_GYROPID, true);
+#ifdef USE_PREEMPTIVE_PID_LOOP
+        if (pidConfig()->pid_loop_preemption) {
+            pidLoopPreemptionInit();
+        }
+#endif
     }
 
+#ifdef USE_SCHEDULER_IDLE_SLEEP
+    if (systemConfig()->scheduler_idle_sleep) {
+        // without a gyro data ready interrupt only the system tick is certain to end the sleep
+        schedulerEnableIdleSleep(gyroHasDataReadyInterrupt() ? (timeDelta_t)gyro.targetLooptime : SCHEDULER_IDLE_WAKEUP_SYSTICK_US);
+    }
+#endif
+
     if (sensors(SENSOR_ACC)) {
         setTaskEnabled(TASK_ACCEL, true);
         rescheduleTask(TASK_ACCEL, acc.accSamplingInterval);
         setTaskEnabled(TASK_ATTITUDE, true);
+#ifdef USE_TASK_CHAINING
+        if (systemConfig()->imu_task_chaining && sensors(SENSOR_GYRO)) {
+            // use the slack straight after the PID loop rather than compete with it
+            schedulerChainTask(TASK_ACCEL, TASK_GYROPID, cfTasks[TASK_ACCEL].desiredPeriod / gyro.targetLooptime);
+            schedulerChainTask(TASK_ATTITUDE, TASK_GYROPID, cfTasks[TASK_ATTITUDE].desiredPeriod / gyro.targetLooptime);
+        }
+#endif
     }
 
     setTaskEnabled(TASK_RX, true);
 
-    setTaskEnabled(TASK_DISPATCH, dispatchIsEnabled());
+    setTaskEnabled(TASK_DISPATCH, true);
 
 #ifdef USE_BEEPER
     setTaskEnabled(TASK_BEEPER, true);
@@ -294,6 +356,9 @@ void fcTasksInit(void)
 #ifdef USE_BARO
     setTaskEnabled(TASK_BARO, sensors(SENSOR_BARO));
 #endif
+#ifdef USE_RANGEFINDER
+    setTaskEnabled(TASK_RANGEFINDER, sensors(SENSOR_RANGEFINDER));
+#endif
 #if defined(USE_BARO) || defined(USE_GPS)
     setTaskEnabled(TASK_ALTITUDE, sensors(SENSOR_BARO) || feature(FEATURE_GPS));
 #endif
@@ -333,6 +398,15 @@ void fcTasksInit(void)
 #ifdef USE_PINIOBOX
     setTaskEnabled(TASK_PINIOBOX, true);
 #endif
+#ifdef USE_PID_AUDIO
+    setTaskEnabled(TASK_PID_AUDIO, isModeActivationConditionPresent(BOXPIDAUDIO));
+#endif
+#ifdef USE_FLASHFS
+    setTaskEnabled(TASK_FLASHFS_ERASE_AHEAD, flashConfig()->eraseAheadSectors && flashfsIsSupported());
+#endif
+#ifdef USE_BLACKBOX_ASYNC
+    setTaskEnabled(TASK_BLACKBOX, blackboxConfig()->async && blackboxConfig()->device);
+#endif
 #ifdef USE_CMS
 #ifdef USE_MSP_DISPLAYPORT
     setTaskEnabled(TASK_CMS, true);
@@ -451,7 +525,7 @@ cfTask_t cfTasks[TASK_COUNT] = {
     [TASK_ATTITUDE] = {
         .taskName = "ATTITUDE",
         .taskFunc = imuUpdateAttitude,
-        .desiredPeriod = TASK_PERIOD_HZ(100),
+        .desiredPeriod = TASK_PERIOD_HZ(200),
         .staticPriority = TASK_PRIORITY_MEDIUM,
     },
 
@@ -506,11 +580,20 @@ cfTask_t cfTasks[TASK_COUNT] = {
     },
 #endif
 
+#ifdef USE_RANGEFINDER
+    [TASK_RANGEFINDER] = {
+        .taskName = "RANGEFINDER",
+        .taskFunc = taskUpdateRangefinder,
+        .desiredPeriod = TASK_PERIOD_MS(70),        // rescheduled for the detected device
+        .staticPriority = TASK_PRIORITY_LOW,
+    },
+#endif
+
 #if defined(USE_BARO) || defined(USE_GPS)
     [TASK_ALTITUDE] = {
         .taskName = "ALTITUDE",
         .taskFunc = taskCalculateAltitude,
-        .desiredPeriod = TASK_PERIOD_HZ(40),
+        .desiredPeriod = TASK_PERIOD_HZ(100),
         .staticPriority = TASK_PRIORITY_LOW,
     },
 #endif
@@ -622,5 +705,32 @@ cfTask_t cfTasks[TASK_COUNT] = {
         .staticPriority = TASK_PRIORITY_IDLE
     },
 #endif
+
+#ifdef USE_BLACKBOX_ASYNC
+    [TASK_BLACKBOX] = {
+        .taskName = "BLACKBOX",
+        .taskFunc = taskBlackbox,
+        .desiredPeriod = TASK_PERIOD_HZ(1000),
+        .staticPriority = TASK_PRIORITY_MEDIUM_HIGH
+    },
+#endif
+
+#ifdef USE_FLASHFS
+    [TASK_FLASHFS_ERASE_AHEAD] = {
+        .taskName = "ERASEAHEAD",
+        .taskFunc = taskFlashfsEraseAhead,
+        .desiredPeriod = TASK_PERIOD_HZ(10),
+        .staticPriority = TASK_PRIORITY_IDLE
+    },
+#endif
+
+#ifdef USE_PID_AUDIO
+    [TASK_PID_AUDIO] = {
+        .taskName = "PIDAUDIO",
+        .taskFunc = pidAudioUpdate,
+        .desiredPeriod = TASK_PERIOD_HZ(200),
+        .staticPriority = TASK_PRIORITY_LOW
+    },
+#endif
 #endif
 };
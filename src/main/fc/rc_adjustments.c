@@ -312,7 +312,6 @@ static int applyStepAdjustment(controlRateConfig_t *controlRateConfig, uint8_t a
     case ADJUSTMENT_THROTTLE_EXPO:
         newValue = constrain((int)controlRateConfig->thrExpo8 + delta, 0, 100); // FIXME magic numbers repeated in cli.c
         controlRateConfig->thrExpo8 = newValue;
-        initRcProcessing();
         blackboxLogInflightAdjustmentEvent(ADJUSTMENT_THROTTLE_EXPO, newValue);
         break;
     case ADJUSTMENT_PITCH_ROLL_RATE:
@@ -461,7 +460,6 @@ static int applyAbsoluteAdjustment(controlRateConfig_t *controlRateConfig, adjus
     case ADJUSTMENT_THROTTLE_EXPO:
         newValue = constrain(value, 0, 100); // FIXME magic numbers repeated in cli.c
         controlRateConfig->thrExpo8 = newValue;
-        initRcProcessing();
         blackboxLogInflightAdjustmentEvent(ADJUSTMENT_THROTTLE_EXPO, newValue);
         break;
     case ADJUSTMENT_PITCH_ROLL_RATE:
@@ -667,7 +665,8 @@ void processRcAdjustments(controlRateConfig_t *controlRateConfig)
             }
 
             newValue = applyStepAdjustment(controlRateConfig, adjustmentFunction, delta);
-            pidInitConfig(pidProfile);
+            pidPrepareProfile(pidProfile);
+            initRcProcessing();
         } else if (adjustmentState->config->mode == ADJUSTMENT_MODE_SELECT) {
             int switchPositions = adjustmentState->config->data.switchPositions;
             if (adjustmentFunction == ADJUSTMENT_RATE_PROFILE && systemConfig()->rateProfile6PosSwitch) {
@@ -706,7 +705,8 @@ void processRcAdjustments(controlRateConfig_t *controlRateConfig)
 
             lastRcData[index] = rcData[channelIndex];
             applyAbsoluteAdjustment(controlRateConfig, adjustmentRange->adjustmentFunction, value);
-            pidInitConfig(pidProfile);
+            pidPrepareProfile(pidProfile);
+            initRcProcessing();
         }
     }
 }
@@ -28,6 +28,7 @@
 
 #include "common/bitarray.h"
 #include "common/maths.h"
+#include "common/utils.h"
 
 #include "config/feature.h"
 #include "pg/pg.h"
@@ -42,6 +43,21 @@
 boxBitmask_t rcModeActivationMask; // one bit per mode defined in boxId_e
 static bool modeChangesDisabled = false;
 
+// conditions that can affect a mode, in configuration order, compiled by analyzeModeActivationConditions()
+static uint8_t activeMacCount = 0;
+static uint8_t activeMacArray[MAX_MODE_ACTIVATION_CONDITION_COUNT];
+// the aux channels those conditions use, with the step each was last evaluated at
+static uint8_t activeAuxChannelCount = 0;
+static uint8_t activeAuxChannelArray[MAX_MODE_ACTIVATION_CONDITION_COUNT];
+static uint8_t activeAuxChannelStep[MAX_MODE_ACTIVATION_CONDITION_COUNT];
+// range result of each condition, one bit per condition index
+static uint32_t macRangeActive = 0;
+static boxBitmask_t macPresentMask;
+
+#define AUX_CHANNEL_STEP_UNKNOWN 0xff
+
+STATIC_ASSERT(MAX_MODE_ACTIVATION_CONDITION_COUNT <= 32, mode_activation_conditions_fit_range_bits);
+
 PG_REGISTER_ARRAY(modeActivationCondition_t, MAX_MODE_ACTIVATION_CONDITION_COUNT, modeActivationConditions,
                   PG_MODE_ACTIVATION_PROFILE, 1);
 
@@ -78,6 +94,37 @@ bool isRangeActive(uint8_t auxChannelIndex, const channelRange_t *range) {
 }
 
 
+static uint8_t auxChannelStep(uint8_t auxChannelIndex)
+{
+    // same thresholds as isRangeActive(), a range is active when startStep <= step < endStep
+    const uint16_t channelValue = constrain(rcData[auxChannelIndex + NON_AUX_CHANNEL_COUNT], CHANNEL_RANGE_MIN, CHANNEL_RANGE_MAX - 1);
+    return (channelValue - CHANNEL_RANGE_MIN) / 25;
+}
+
+static void updateMacRangeActive(void)
+{
+    for (int i = 0; i < activeAuxChannelCount; i++) {
+        const uint8_t auxChannelIndex = activeAuxChannelArray[i];
+        const uint8_t step = auxChannelStep(auxChannelIndex);
+        if (step == activeAuxChannelStep[i]) {
+            continue;
+        }
+        activeAuxChannelStep[i] = step;
+
+        for (int j = 0; j < activeMacCount; j++) {
+            const uint8_t macIndex = activeMacArray[j];
+            const modeActivationCondition_t *mac = modeActivationConditions(macIndex);
+            if (mac->auxChannelIndex == auxChannelIndex) {
+                if (step >= mac->range.startStep && step < mac->range.endStep) {
+                    macRangeActive |= 1U << macIndex;
+                } else {
+                    macRangeActive &= ~(1U << macIndex);
+                }
+            }
+        }
+    }
+}
+
 void updateActivatedModes(void)
 {
     boxBitmask_t newMask, andMask;
@@ -89,9 +136,13 @@ void updateActivatedModes(void)
         memcpy(&newMask, &rcModeActivationMask, sizeof(newMask));
     }
 
+    // only the aux channels whose step changed since the last update are evaluated again
+    updateMacRangeActive();
+
     // determine which conditions set/clear the mode
-    for (int i = 0; i < MAX_MODE_ACTIVATION_CONDITION_COUNT; i++) {
-        const modeActivationCondition_t *mac = modeActivationConditions(i);
+    for (int i = 0; i < activeMacCount; i++) {
+        const uint8_t macIndex = activeMacArray[i];
+        const modeActivationCondition_t *mac = modeActivationConditions(macIndex);
 
         boxId_e mode = mac->modeId;
 
@@ -99,29 +150,61 @@ void updateActivatedModes(void)
             continue;
         }
 
-        if (mode < CHECKBOX_ITEM_COUNT) {
-            bool bAnd = (mac->modeLogic == MODELOGIC_AND) || bitArrayGet(&andMask, mode);
-            bool bAct = isRangeActive(mac->auxChannelIndex, &mac->range);
-            if (bAnd)
-                bitArraySet(&andMask, mode);
-            if (bAnd != bAct)
-                bitArraySet(&newMask, mode);
-        }
+        bool bAnd = (mac->modeLogic == MODELOGIC_AND) || bitArrayGet(&andMask, mode);
+        bool bAct = macRangeActive & (1U << macIndex);
+        if (bAnd)
+            bitArraySet(&andMask, mode);
+        if (bAnd != bAct)
+            bitArraySet(&newMask, mode);
     }
-    bitArrayXor(&newMask, sizeof(&newMask), &newMask, &andMask);
+    bitArrayXor(&newMask, sizeof(newMask), &newMask, &andMask);
 
     rcModeUpdate(&newMask);
 }
 
 bool isModeActivationConditionPresent(boxId_e modeId)
 {
+    return bitArrayGet(&macPresentMask, modeId);
+}
+
+/*
+ * Compiles the mode activation conditions into the list updateActivatedModes() walks.
+ * Must be called whenever the conditions are changed.
+ */
+void analyzeModeActivationConditions(void)
+{
+    activeMacCount = 0;
+    activeAuxChannelCount = 0;
+    macRangeActive = 0;
+    memset(&macPresentMask, 0, sizeof(macPresentMask));
+
     for (int i = 0; i < MAX_MODE_ACTIVATION_CONDITION_COUNT; i++) {
         const modeActivationCondition_t *mac = modeActivationConditions(i);
 
-        if (mac->modeId == modeId && IS_RANGE_USABLE(&mac->range)) {
-            return true;
+        if (mac->modeId >= CHECKBOX_ITEM_COUNT) {
+            continue;
+        }
+
+        const bool usable = IS_RANGE_USABLE(&mac->range);
+        if (usable) {
+            bitArraySet(&macPresentMask, mac->modeId);
         }
-    }
 
-    return false;
+        // an unusable OR condition never changes its mode, an unusable AND condition keeps it off
+        if (usable || mac->modeLogic == MODELOGIC_AND) {
+            activeMacArray[activeMacCount++] = i;
+        }
+
+        if (usable) {
+            int j = 0;
+            while (j < activeAuxChannelCount && activeAuxChannelArray[j] != mac->auxChannelIndex) {
+                j++;
+            }
+            if (j == activeAuxChannelCount) {
+                activeAuxChannelArray[activeAuxChannelCount] = mac->auxChannelIndex;
+                activeAuxChannelStep[activeAuxChannelCount] = AUX_CHANNEL_STEP_UNKNOWN;
+                activeAuxChannelCount++;
+            }
+        }
+    }
 }
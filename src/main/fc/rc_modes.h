@@ -137,3 +137,4 @@ bool isAntiGravityModeActive(void);
 bool isRangeActive(uint8_t auxChannelIndex, const channelRange_t *range);
 void updateActivatedModes(void);
 bool isModeActivationConditionPresent(boxId_e modeId);
+void analyzeModeActivationConditions(void);
@@ -23,6 +23,8 @@
 
 #include "platform.h"
 
+#include "drivers/swi.h"
+
 #include "fc/runtime_config.h"
 #include "io/beeper.h"
 
@@ -58,14 +60,20 @@ const char *armingDisableFlagNames[]= {
 
 static armingDisableFlags_e armingDisableFlags = 0;
 
+// The runaway takeoff check sets its flag from the PID loop, which may preempt the
+// updates made by the arming checks in TASK_RX
 void setArmingDisabled(armingDisableFlags_e flag)
 {
-    armingDisableFlags = armingDisableFlags | flag;
+    SWI_ATOMIC_BLOCK {
+        armingDisableFlags = armingDisableFlags | flag;
+    }
 }
 
 void unsetArmingDisabled(armingDisableFlags_e flag)
 {
-    armingDisableFlags = armingDisableFlags & ~flag;
+    SWI_ATOMIC_BLOCK {
+        armingDisableFlags = armingDisableFlags & ~flag;
+    }
 }
 
 bool isArmingDisabled(void)
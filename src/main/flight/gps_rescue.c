@@ -50,6 +50,9 @@
 
 #include "gps_rescue.h"
 
+#define GPS_RESCUE_PLAN_INTERVAL_MIN_US     20000
+#define GPS_RESCUE_PLAN_INTERVAL_MAX_US     200000
+
 PG_REGISTER_WITH_RESET_TEMPLATE(gpsRescueConfig_t, gpsRescueConfig, PG_GPS_RESCUE, 0);
 
 PG_RESET_TEMPLATE(gpsRescueConfig_t, gpsRescueConfig,
@@ -74,6 +77,14 @@ PG_RESET_TEMPLATE(gpsRescueConfig_t, gpsRescueConfig,
 static uint16_t      rescueThrottle;
 static int16_t       rescueYaw;
 
+// Targets set by the planner on each GPS fix, the guidance ramps the outputs towards them until the next fix
+static int32_t       rescuePitchTarget;
+static uint16_t      rescueThrottleTarget;
+static int32_t       rescuePitchStart;
+static uint16_t      rescueThrottleStart;
+static timeUs_t      rescuePlanTimeUs;
+static timeDelta_t   rescuePlanIntervalUs = GPS_RESCUE_PLAN_INTERVAL_MAX_US;
+
 int32_t       gpsRescueAngle[ANGLE_INDEX_COUNT] = { 0, 0 };
 uint16_t      hoverThrottle = 0;
 float         averageThrottle = 0.0;
@@ -96,7 +107,9 @@ void rescueNewGpsData(void)
 }
 
 /*
-    Determine what phase we are in, determine if all criteria are met to move to the next phase
+    Determine what phase we are in, determine if all criteria are met to move to the next phase.
+    Everything that depends on the GPS runs once per fix, the guidance in gpsRescueInjectRcCommands()
+    flies the targets set here at the RC rate.
 */
 void updateGPSRescueState(void)
 {
@@ -110,10 +123,34 @@ void updateGPSRescueState(void)
 
     sensorUpdate();
 
-    switch (rescueState.phase) {
-    case RESCUE_IDLE:
+    if (rescueState.phase == RESCUE_IDLE) {
         idleTasks();
+    } else if (newGPSData || rescueState.phase == RESCUE_INITIALIZE) {
+        rescuePlan();
+        rescueAttainPosition();
+    }
+
+    performSanityChecks();
+
+    switch (rescueState.phase) {
+    case RESCUE_COMPLETE:
+        rescueStop();
         break;
+    case RESCUE_ABORT:
+        disarm();
+        rescueStop();
+        break;
+    default:
+        break;
+    }
+
+    newGPSData = false;
+}
+
+// Phase transitions and intent, from the sensor data of the latest fix
+void rescuePlan(void)
+{
+    switch (rescueState.phase) {
     case RESCUE_INITIALIZE:
         if (hoverThrottle == 0) { //no actual throttle data yet, let's use the default.
             hoverThrottle = gpsRescueConfig()->throttleHover;
@@ -178,51 +215,26 @@ void updateGPSRescueState(void)
         rescueState.intent.minAngleDeg = 0;
         rescueState.intent.maxAngleDeg = 15;
         break;
-    case RESCUE_COMPLETE:
-        rescueStop();
-        break;
-    case RESCUE_ABORT:
-        disarm();
-        rescueStop();
-        break;
     default:
         break;
     }
-
-    performSanityChecks();
-
-    if (rescueState.phase != RESCUE_IDLE) {
-        rescueAttainPosition();
-    }
-
-    newGPSData = false;
 }
 
 void sensorUpdate()
 {
     rescueState.sensor.currentAltitude = getEstimatedAltitude();
 
-    // Calculate altitude velocity
-    static uint32_t previousTimeUs;
-    static int32_t previousAltitude;
-
-    const uint32_t currentTimeUs = micros();
-    const float dTime = currentTimeUs - previousTimeUs;
-
-    if (newGPSData) { // Calculate velocity at lowest common denominator
+    if (newGPSData) {
         rescueState.sensor.distanceToHome = GPS_distanceToHome;
         rescueState.sensor.directionToHome = GPS_directionToHome;
         rescueState.sensor.numSat = gpsSol.numSat;
         rescueState.sensor.groundSpeed = gpsSol.groundSpeed;
 
-        rescueState.sensor.zVelocity = (rescueState.sensor.currentAltitude - previousAltitude) * 1000000.0f / dTime;
+        rescueState.sensor.zVelocity = getEstimatedVario();
         rescueState.sensor.zVelocityAvg = 0.8f * rescueState.sensor.zVelocityAvg + rescueState.sensor.zVelocity * 0.2f;
 
         rescueState.sensor.accMagnitude = (float) sqrt(sq(acc.accADC[Z]) + sq(acc.accADC[X]) + sq(acc.accADC[Y]) / sq(acc.dev.acc_1G));
         rescueState.sensor.accMagnitudeAvg = (rescueState.sensor.accMagnitudeAvg * 0.8f) + (rescueState.sensor.accMagnitude * 0.2f);
-
-        previousAltitude = rescueState.sensor.currentAltitude;
-        previousTimeUs = currentTimeUs;
     }
 }
 
@@ -310,6 +322,7 @@ void idleTasks()
 
     gpsRescueAngle[AI_PITCH] = 0;
     gpsRescueAngle[AI_ROLL] = 0;
+    rescuePitchTarget = 0;
 
     // Store the max altitude we see not during RTH so we know our fly-back minimum alt
     rescueState.sensor.maxAltitude = MAX(rescueState.sensor.currentAltitude, rescueState.sensor.maxAltitude);
@@ -332,19 +345,19 @@ void idleTasks()
         throttleSamples++;
     }
 
+    rescueThrottleTarget = rescueThrottle;
 }
 
+// Speed and altitude controllers, run once per fix to set the pitch and throttle targets
 void rescueAttainPosition()
 {
-    // Point to home if that is in our intent
-    if (rescueState.intent.crosstrack) {
-        setBearing(rescueState.sensor.directionToHome);
-    }
-
-    if (!newGPSData) {
-        return;
-    }
+    const timeUs_t currentTimeUs = micros();
+    rescuePlanIntervalUs = constrain(cmpTimeUs(currentTimeUs, rescuePlanTimeUs), GPS_RESCUE_PLAN_INTERVAL_MIN_US, GPS_RESCUE_PLAN_INTERVAL_MAX_US);
+    rescuePlanTimeUs = currentTimeUs;
 
+    // ramp from where the guidance is now, so the outputs stay continuous
+    rescuePitchStart = gpsRescueAngle[AI_PITCH];
+    rescueThrottleStart = rescueThrottle;
 
     /**
         Speed controller
@@ -361,9 +374,9 @@ void rescueAttainPosition()
 
     int16_t angleAdjustment =  gpsRescueConfig()->velP * speedError + (gpsRescueConfig()->velI * speedIntegral) / 100 +  gpsRescueConfig()->velD * speedDerivative;
 
-    gpsRescueAngle[AI_PITCH] = constrain(gpsRescueAngle[AI_PITCH] + MIN(angleAdjustment, 80), rescueState.intent.minAngleDeg * 100, rescueState.intent.maxAngleDeg * 100);
+    rescuePitchTarget = constrain(rescuePitchTarget + MIN(angleAdjustment, 80), rescueState.intent.minAngleDeg * 100, rescueState.intent.maxAngleDeg * 100);
 
-    float ct = cos(DECIDEGREES_TO_RADIANS(gpsRescueAngle[AI_PITCH] / 10));
+    float ct = cos(DECIDEGREES_TO_RADIANS(rescuePitchTarget / 10));
 
     /**
         Altitude controller
@@ -386,10 +399,10 @@ void rescueAttainPosition()
     int16_t altitudeAdjustment = (gpsRescueConfig()->throttleP * altitudeError + (gpsRescueConfig()->throttleI * altitudeIntegral) / 10 *  + gpsRescueConfig()->throttleD * altitudeDerivative) / ct / 20;
     int16_t hoverAdjustment = (hoverThrottle - 1000) / ct;
 
-    rescueThrottle = constrain(1000 + altitudeAdjustment + hoverAdjustment, gpsRescueConfig()->throttleMin, gpsRescueConfig()->throttleMax);
+    rescueThrottleTarget = constrain(1000 + altitudeAdjustment + hoverAdjustment, gpsRescueConfig()->throttleMin, gpsRescueConfig()->throttleMax);
 
-    DEBUG_SET(DEBUG_RTH, 0, rescueThrottle);
-    DEBUG_SET(DEBUG_RTH, 1, gpsRescueAngle[AI_PITCH]);
+    DEBUG_SET(DEBUG_RTH, 0, rescueThrottleTarget);
+    DEBUG_SET(DEBUG_RTH, 1, rescuePitchTarget);
     DEBUG_SET(DEBUG_RTH, 2, altitudeAdjustment);
     DEBUG_SET(DEBUG_RTH, 3, rescueState.failure);
 }
@@ -397,7 +410,7 @@ void rescueAttainPosition()
 // Very similar to maghold function on betaflight/cleanflight
 void setBearing(int16_t deg)
 {
-    int16_t dif = DECIDEGREES_TO_DEGREES(attitude.values.yaw) - deg;
+    int16_t dif = DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw) - deg;
 
     if (dif <= -180) {
         dif += 360;
@@ -410,8 +423,29 @@ void setBearing(int16_t deg)
     rescueYaw = - (dif * gpsRescueConfig()->yawP / 20);
 }
 
-void gpsRescueInjectRcCommands(void)
+/*
+    Guidance, runs at the RC rate. Holds the heading to home against the current attitude
+    and ramps pitch and throttle to the planner's targets over one fix interval.
+*/
+void gpsRescueInjectRcCommands(timeUs_t currentTimeUs)
 {
+    if (rescueState.phase != RESCUE_IDLE) {
+        const timeDelta_t sincePlanUs = cmpTimeUs(currentTimeUs, rescuePlanTimeUs);
+        if (sincePlanUs >= rescuePlanIntervalUs) {
+            gpsRescueAngle[AI_PITCH] = rescuePitchTarget;
+            rescueThrottle = rescueThrottleTarget;
+        } else {
+            const float ramp = (float)MAX(sincePlanUs, 0) / rescuePlanIntervalUs;
+            gpsRescueAngle[AI_PITCH] = rescuePitchStart + lrintf((rescuePitchTarget - rescuePitchStart) * ramp);
+            rescueThrottle = rescueThrottleStart + lrintf((rescueThrottleTarget - rescueThrottleStart) * ramp);
+        }
+
+        // Point to home if that is in our intent
+        if (rescueState.intent.crosstrack) {
+            setBearing(rescueState.sensor.directionToHome);
+        }
+    }
+
     rcCommand[THROTTLE] = rescueThrottle;
     rcCommand[YAW] = rescueYaw;
 }
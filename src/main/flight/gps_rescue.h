@@ -16,6 +16,7 @@
  */
  
 #include "common/axis.h"
+#include "common/time.h"
 
 #include "pg/pg.h"
 
@@ -99,6 +100,7 @@ extern int32_t gpsRescueAngle[ANGLE_INDEX_COUNT]; //NOTE: ANGLES ARE IN CENTIDEG
 extern rescueState_s rescueState;
 
 void updateGPSRescueState(void);
+void rescuePlan(void);
 void rescueNewGpsData(void);
 void idleTasks(void);
 void rescueStop(void);
@@ -109,4 +111,4 @@ void sensorUpdate(void);
 
 void rescueAttainPosition(void);
 
-void gpsRescueInjectRcCommands(void);
+void gpsRescueInjectRcCommands(timeUs_t currentTimeUs);
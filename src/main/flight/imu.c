@@ -34,6 +34,7 @@
 #include "pg/pg.h"
 #include "pg/pg_ids.h"
 
+#include "drivers/swi.h"
 #include "drivers/time.h"
 
 #include "fc/runtime_config.h"
@@ -107,7 +108,9 @@ quaternion headfree = QUATERNION_INITIALIZE;
 quaternion offset = QUATERNION_INITIALIZE;
 
 // absolute angle inclination in multiple of 0.1 degree    180 deg = 1800
-attitudeEulerAngles_t attitude = EULER_INITIALIZE;
+STATIC_UNIT_TESTED attitudeEulerAngles_t attitude = EULER_INITIALIZE;
+// the Euler angles are only worked out from rMat when they are read
+static bool attitudeIsStale = false;
 
 PG_REGISTER_WITH_RESET_TEMPLATE(imuConfig_t, imuConfig, PG_IMU_CONFIG, 0);
 
@@ -119,25 +122,40 @@ PG_RESET_TEMPLATE(imuConfig_t, imuConfig,
     .acc_unarmedcal = 1
 );
 
-STATIC_UNIT_TESTED void imuComputeRotationMatrix(void){
+// The gravity row and the heading terms, these are all the attitude task and its consumers read.
+static void imuComputeRotationMatrixAttitude(void)
+{
     imuQuaternionComputeProducts(&q, &qP);
 
-    rMat[0][0] = 1.0f - 2.0f * qP.yy - 2.0f * qP.zz;
+    // a preemptive PID loop works the angles out of these terms when it finds the attitude stale
+    SWI_ATOMIC_BLOCK {
+        rMat[0][0] = 1.0f - 2.0f * qP.yy - 2.0f * qP.zz;
+        rMat[1][0] = 2.0f * (qP.xy - -qP.wz);
+
+        rMat[2][0] = 2.0f * (qP.xz + -qP.wy);
+        rMat[2][1] = 2.0f * (qP.yz - -qP.wx);
+        rMat[2][2] = 1.0f - 2.0f * qP.xx - 2.0f * qP.yy;
+
+#if defined(SIMULATOR_BUILD) && defined(SKIP_IMU_CALC) && !defined(SET_IMU_FROM_EULER)
+        rMat[1][0] = -2.0f * (qP.xy - -qP.wz);
+        rMat[2][0] = -2.0f * (qP.xz + -qP.wy);
+#endif
+    }
+}
+
+// The rest of the first two rows, only the magnetometer fusion needs them.
+static void imuComputeRotationMatrixHorizontal(void)
+{
     rMat[0][1] = 2.0f * (qP.xy + -qP.wz);
     rMat[0][2] = 2.0f * (qP.xz - -qP.wy);
 
-    rMat[1][0] = 2.0f * (qP.xy - -qP.wz);
     rMat[1][1] = 1.0f - 2.0f * qP.xx - 2.0f * qP.zz;
     rMat[1][2] = 2.0f * (qP.yz + -qP.wx);
+}
 
-    rMat[2][0] = 2.0f * (qP.xz + -qP.wy);
-    rMat[2][1] = 2.0f * (qP.yz - -qP.wx);
-    rMat[2][2] = 1.0f - 2.0f * qP.xx - 2.0f * qP.yy;
-
-#if defined(SIMULATOR_BUILD) && defined(SKIP_IMU_CALC) && !defined(SET_IMU_FROM_EULER)
-    rMat[1][0] = -2.0f * (qP.xy - -qP.wz);
-    rMat[2][0] = -2.0f * (qP.xz + -qP.wy);
-#endif
+STATIC_UNIT_TESTED void imuComputeRotationMatrix(void){
+    imuComputeRotationMatrixAttitude();
+    imuComputeRotationMatrixHorizontal();
 }
 
 /*
@@ -193,6 +211,16 @@ void imuResetAccelerationSum(void)
     accTimeSum = 0;
 }
 
+// Sum the vertical earth frame acceleration, gravity removed, for the altitude estimator
+static void imuAccumulateAcceleration(const float *accAverage, timeDelta_t deltaT)
+{
+    const float accZ = rMat[2][0] * accAverage[X] + rMat[2][1] * accAverage[Y] + rMat[2][2] * accAverage[Z] - acc.dev.acc_1G;
+
+    accSum[Z] += lrintf(accZ);
+    accSumCount++;
+    accTimeSum += deltaT;
+}
+
 static float invSqrt(float x)
 {
     return 1.0f / sqrtf(x);
@@ -219,7 +247,7 @@ static void imuMahonyAHRSupdate(float dt, float gx, float gy, float gz,
             courseOverGround += (2.0f * M_PIf);
         }
 
-        const float ez_ef = (- sin_approx(courseOverGround) * rMat[0][0] - cos_approx(courseOverGround) * rMat[1][0]);
+        const float ez_ef = (- sin_table(courseOverGround) * rMat[0][0] - cos_table(courseOverGround) * rMat[1][0]);
 
         ex = rMat[2][0] * ez_ef;
         ey = rMat[2][1] * ez_ef;
@@ -236,6 +264,8 @@ static void imuMahonyAHRSupdate(float dt, float gx, float gy, float gz,
         my *= recipMagNorm;
         mz *= recipMagNorm;
 
+        imuComputeRotationMatrixHorizontal();
+
         // For magnetometer correction we make an assumption that magnetic field is perpendicular to gravity (ignore Z-component in EF).
         // This way magnetic field will only affect heading and wont mess roll/pitch angles
 
@@ -300,16 +330,35 @@ static void imuMahonyAHRSupdate(float dt, float gx, float gy, float gz,
     gy *= (0.5f * dt);
     gz *= (0.5f * dt);
 
+    // The rotation over dt is applied as the quaternion exponential of the half angle, which is
+    // exact for the average rate over the gyro accumulation. Unlike the first order step it does
+    // not lose accuracy as the attitude task runs less often. The series hold to 2e-5 up to a
+    // half angle of 0.5 rad.
+    const float halfAngleSq = sq(gx) + sq(gy) + sq(gz);
+    float dqw;
+    float dqScale;
+    if (halfAngleSq < 0.25f) {
+        dqw = 1.0f - halfAngleSq * (1.0f / 2.0f) + sq(halfAngleSq) * (1.0f / 24.0f);
+        dqScale = 1.0f - halfAngleSq * (1.0f / 6.0f) + sq(halfAngleSq) * (1.0f / 120.0f);
+    } else {
+        const float halfAngle = sqrtf(halfAngleSq);
+        dqw = cos_approx(halfAngle);
+        dqScale = sin_approx(halfAngle) / halfAngle;
+    }
+    gx *= dqScale;
+    gy *= dqScale;
+    gz *= dqScale;
+
     quaternion buffer;
     buffer.w = q.w;
     buffer.x = q.x;
     buffer.y = q.y;
     buffer.z = q.z;
 
-    q.w += (-buffer.x * gx - buffer.y * gy - buffer.z * gz);
-    q.x += (+buffer.w * gx + buffer.y * gz - buffer.z * gy);
-    q.y += (+buffer.w * gy - buffer.x * gz + buffer.z * gx);
-    q.z += (+buffer.w * gz + buffer.x * gy - buffer.y * gx);
+    q.w = dqw * buffer.w - buffer.x * gx - buffer.y * gy - buffer.z * gz;
+    q.x = dqw * buffer.x + buffer.w * gx + buffer.y * gz - buffer.z * gy;
+    q.y = dqw * buffer.y + buffer.w * gy - buffer.x * gz + buffer.z * gx;
+    q.z = dqw * buffer.z + buffer.w * gz + buffer.x * gy - buffer.y * gx;
 
     // Normalise quaternion
     float recipNorm = invSqrt(sq(q.w) + sq(q.x) + sq(q.y) + sq(q.z));
@@ -319,34 +368,43 @@ static void imuMahonyAHRSupdate(float dt, float gx, float gy, float gz,
     q.z *= recipNorm;
 
     // Pre-compute rotation matrix from quaternion
-    imuComputeRotationMatrix();
+    imuComputeRotationMatrixAttitude();
+}
+
+static void imuUpdateSmallAngleState(void)
+{
+    if (rMat[2][2] > smallAngleCosZ) {
+        ENABLE_STATE(SMALL_ANGLE);
+    } else {
+        DISABLE_STATE(SMALL_ANGLE);
+    }
 }
 
 STATIC_UNIT_TESTED void imuUpdateEulerAngles(void)
 {
     quaternionProducts buffer;
 
-    if (FLIGHT_MODE(HEADFREE_MODE)) {
-       imuQuaternionComputeProducts(&headfree, &buffer);
+    // the PID loop reads the angles, a preemptive one must not see a yaw before it is wrapped to [0, 3600)
+    SWI_ATOMIC_BLOCK {
+        if (FLIGHT_MODE(HEADFREE_MODE)) {
+           imuQuaternionComputeProducts(&headfree, &buffer);
 
-       attitude.values.roll = lrintf(atan2_approx((+2.0f * (buffer.wx + buffer.yz)), (+1.0f - 2.0f * (buffer.xx + buffer.yy))) * (1800.0f / M_PIf));
-       attitude.values.pitch = lrintf(((0.5f * M_PIf) - acos_approx(+2.0f * (buffer.wy - buffer.xz))) * (1800.0f / M_PIf));
-       attitude.values.yaw = lrintf((-atan2_approx((+2.0f * (buffer.wz + buffer.xy)), (+1.0f - 2.0f * (buffer.yy + buffer.zz))) * (1800.0f / M_PIf)));
-    } else {
-       attitude.values.roll = lrintf(atan2_approx(rMat[2][1], rMat[2][2]) * (1800.0f / M_PIf));
-       attitude.values.pitch = lrintf(((0.5f * M_PIf) - acos_approx(-rMat[2][0])) * (1800.0f / M_PIf));
-       attitude.values.yaw = lrintf((-atan2_approx(rMat[1][0], rMat[0][0]) * (1800.0f / M_PIf)));
-    }
+           attitude.values.roll = lrintf(atan2_approx((+2.0f * (buffer.wx + buffer.yz)), (+1.0f - 2.0f * (buffer.xx + buffer.yy))) * (1800.0f / M_PIf));
+           attitude.values.pitch = lrintf(((0.5f * M_PIf) - acos_approx(+2.0f * (buffer.wy - buffer.xz))) * (1800.0f / M_PIf));
+           attitude.values.yaw = lrintf((-atan2_approx((+2.0f * (buffer.wz + buffer.xy)), (+1.0f - 2.0f * (buffer.yy + buffer.zz))) * (1800.0f / M_PIf)));
+        } else {
+           attitude.values.roll = lrintf(atan2_approx(rMat[2][1], rMat[2][2]) * (1800.0f / M_PIf));
+           attitude.values.pitch = lrintf(((0.5f * M_PIf) - acos_approx(-rMat[2][0])) * (1800.0f / M_PIf));
+           attitude.values.yaw = lrintf((-atan2_approx(rMat[1][0], rMat[0][0]) * (1800.0f / M_PIf)));
+        }
 
-    if (attitude.values.yaw < 0)
-        attitude.values.yaw += 3600;
+        if (attitude.values.yaw < 0)
+            attitude.values.yaw += 3600;
 
-    // Update small angle state
-    if (rMat[2][2] > smallAngleCosZ) {
-        ENABLE_STATE(SMALL_ANGLE);
-    } else {
-        DISABLE_STATE(SMALL_ANGLE);
+        attitudeIsStale = false;
     }
+
+    imuUpdateSmallAngleState();
 }
 
 static bool imuIsAccelerometerHealthy(float *accAverage)
@@ -464,6 +522,10 @@ static void imuCalculateEstimatedAttitude(timeUs_t currentTimeUs)
         if (useCOG && shouldInitializeGPSHeading()) {
             // Reset our reference and reinitialize quaternion.  This will likely ideally happen more than once per flight, but for now,
             // shouldInitializeGPSHeading() returns true only once.
+            // already holding the IMU lock
+            if (attitudeIsStale) {
+                imuUpdateEulerAngles();
+            }
             imuComputeQuaternionFromRPY(&qP, attitude.values.roll, attitude.values.pitch, gpsSol.groundCourse);
 
             useCOG = false; // Don't use the COG when we first reinitialize.  Next time around though, yes.
@@ -474,6 +536,7 @@ static void imuCalculateEstimatedAttitude(timeUs_t currentTimeUs)
 #if defined(SIMULATOR_BUILD) && defined(SKIP_IMU_CALC)
     UNUSED(imuMahonyAHRSupdate);
     UNUSED(imuIsAccelerometerHealthy);
+    UNUSED(imuAccumulateAcceleration);
     UNUSED(useAcc);
     UNUSED(useMag);
     UNUSED(useCOG);
@@ -489,7 +552,8 @@ static void imuCalculateEstimatedAttitude(timeUs_t currentTimeUs)
     float gyroAverage[XYZ_AXIS_COUNT];
     gyroGetAccumulationAverage(gyroAverage);
     float accAverage[XYZ_AXIS_COUNT];
-    if (accGetAccumulationAverage(accAverage)) {
+    const bool haveAcc = accGetAccumulationAverage(accAverage);
+    if (haveAcc) {
         useAcc = imuIsAccelerometerHealthy(accAverage);
     }
 
@@ -499,7 +563,18 @@ static void imuCalculateEstimatedAttitude(timeUs_t currentTimeUs)
                         useMag, mag.magADC[X], mag.magADC[Y], mag.magADC[Z],
                         useCOG, courseOverGround,  imuCalcKpGain(currentTimeUs, useAcc, gyroAverage));
 
-    imuUpdateEulerAngles();
+    // climbing and braking push the accelerometer out of its healthy band, the estimator wants those too
+    if (haveAcc) {
+        imuAccumulateAcceleration(accAverage, deltaT);
+    }
+
+    // the level modes read the angles every PID loop, so work them out here rather than in there
+    if (FLIGHT_MODE(ANGLE_MODE | HORIZON_MODE | GPS_RESCUE_MODE)) {
+        imuUpdateEulerAngles();
+    } else {
+        attitudeIsStale = true;
+        imuUpdateSmallAngleState();
+    }
 #endif
 }
 
@@ -541,6 +616,16 @@ float getCosTiltAngle(void)
     return rMat[2][2];
 }
 
+const attitudeEulerAngles_t *getAttitude(void)
+{
+    if (attitudeIsStale) {
+        IMU_LOCK;
+        imuUpdateEulerAngles();
+        IMU_UNLOCK;
+    }
+    return &attitude;
+}
+
 void getQuaternion(quaternion *quat)
 {
    quat->w = q.w;
@@ -616,6 +701,7 @@ void imuSetAttitudeRPY(float roll, float pitch, float yaw)
     attitude.values.roll = roll * 10;
     attitude.values.pitch = pitch * 10;
     attitude.values.yaw = yaw * 10;
+    attitudeIsStale = false;
 
     IMU_UNLOCK;
 }
@@ -662,7 +748,7 @@ void imuQuaternionComputeProducts(quaternion *quat, quaternionProducts *quatProd
 
 bool imuQuaternionHeadfreeOffsetSet(void)
 {
-    if ((ABS(attitude.values.roll) < 450)  && (ABS(attitude.values.pitch) < 450)) {
+    if ((ABS(getAttitude()->values.roll) < 450)  && (ABS(getAttitude()->values.pitch) < 450)) {
         const float yaw = -atan2_approx((+2.0f * (qP.wz + qP.xy)), (+1.0f - 2.0f * (qP.yy + qP.zz)));
 
         offset.w = cos_approx(yaw/2);
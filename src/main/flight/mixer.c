@@ -63,7 +63,7 @@
 #include "sensors/battery.h"
 #include "sensors/gyro.h"
 
-PG_REGISTER_WITH_RESET_TEMPLATE(mixerConfig_t, mixerConfig, PG_MIXER_CONFIG, 0);
+PG_REGISTER_WITH_RESET_TEMPLATE(mixerConfig_t, mixerConfig, PG_MIXER_CONFIG, 1);
 
 #ifndef TARGET_DEFAULT_MIXER
 #define TARGET_DEFAULT_MIXER    MIXER_QUADX
@@ -72,9 +72,10 @@ PG_RESET_TEMPLATE(mixerConfig_t, mixerConfig,
     .mixerMode = TARGET_DEFAULT_MIXER,
     .yaw_motors_reversed = false,
     .crashflip_motor_percent = 0,
+    .thrust_linear = 0,
 );
 
-PG_REGISTER_WITH_RESET_FN(motorConfig_t, motorConfig, PG_MOTOR_CONFIG, 1);
+PG_REGISTER_WITH_RESET_FN(motorConfig_t, motorConfig, PG_MOTOR_CONFIG, 4);
 
 void pgResetFn_motorConfig(motorConfig_t *motorConfig)
 {
@@ -104,6 +105,7 @@ void pgResetFn_motorConfig(motorConfig_t *motorConfig)
 #ifdef USE_DSHOT_DMAR
     motorConfig->dev.useBurstDshot = ENABLE_DSHOT_DMAR;
 #endif
+    motorConfig->dev.useDshotTelemetry = false;
 
     for (int motorIndex = 0; motorIndex < MAX_SUPPORTED_MOTORS; motorIndex++) {
         motorConfig->dev.ioTags[motorIndex] = timerioTagGetByUsage(TIM_USE_MOTOR, motorIndex);
@@ -123,7 +125,17 @@ float FAST_RAM_ZERO_INIT motor[MAX_SUPPORTED_MOTORS];
 float motor_disarmed[MAX_SUPPORTED_MOTORS];
 
 mixerMode_e currentMixerMode;
-static motorMixer_t currentMixer[MAX_SUPPORTED_MOTORS];
+
+// The active mix kept as one column per axis, so the mixer loops read each factor from a
+// contiguous array rather than striding through motorMixer_t entries
+typedef struct motorMixMatrix_s {
+    float roll[MAX_SUPPORTED_MOTORS];
+    float pitch[MAX_SUPPORTED_MOTORS];
+    float yaw[MAX_SUPPORTED_MOTORS];
+    float throttle[MAX_SUPPORTED_MOTORS];
+} motorMixMatrix_t;
+
+static FAST_RAM_ZERO_INIT motorMixMatrix_t motorMixMatrix;
 
 
 static const motorMixer_t mixerQuadX[] = {
@@ -321,6 +333,19 @@ static FAST_RAM_ZERO_INIT uint16_t rcCommand3dDeadBandLow;
 static FAST_RAM_ZERO_INIT uint16_t rcCommand3dDeadBandHigh;
 static FAST_RAM_ZERO_INIT float rcCommandThrottleRange, rcCommandThrottleRange3dLow, rcCommandThrottleRange3dHigh;
 
+// the configuration mixTable() reads every loop, the rx and mixer parts are taken by initEscEndpoints()
+// and the profile part by mixerInitProfile() whenever the PID settings are applied
+typedef struct mixerRuntime_s {
+    float pidSumLimit;
+    float pidSumLimitYaw;
+    float crashflipMotorFactor;
+    uint16_t mincheck;
+    uint16_t midrc;
+    bool yawMotorsReversed;
+} mixerRuntime_t;
+
+static FAST_RAM_ZERO_INIT mixerRuntime_t mixerRuntime;
+
 uint8_t getMotorCount(void)
 {
     return motorCount;
@@ -406,6 +431,11 @@ void initEscEndpoints(void)
         break;
     }
 
+    mixerRuntime.mincheck = rxConfig()->mincheck;
+    mixerRuntime.midrc = rxConfig()->midrc;
+    mixerRuntime.yawMotorsReversed = mixerConfig()->yaw_motors_reversed;
+    mixerRuntime.crashflipMotorFactor = mixerConfig()->crashflip_motor_percent / 100.0f;
+
     rcCommandThrottleRange = PWM_RANGE_MAX - rxConfig()->mincheck;
 
     rcCommand3dDeadBandLow = rxConfig()->midrc - flight3DConfig()->deadband3d_throttle;
@@ -415,16 +445,68 @@ void initEscEndpoints(void)
     rcCommandThrottleRange3dHigh = PWM_RANGE_MAX - rcCommand3dDeadBandHigh;
 }
 
+#ifdef USE_THRUST_LINEARIZATION
+#define THRUST_LINEARIZATION_LOOKUP_LENGTH 33
+
+static FAST_RAM_ZERO_INIT float thrustLinearizationLookup[THRUST_LINEARIZATION_LOOKUP_LENGTH];
+static FAST_RAM_ZERO_INIT bool thrustLinearizationActive;
+
+// The thrust is modelled as t = (1 - k) * c + k * c^2 for a motor command c in [0, 1], the table
+// holds the command that gives the thrust asked for, so the PID gains hold across the throttle range
+static void thrustLinearizationInit(void)
+{
+    const float k = mixerConfig()->thrust_linear / 100.0f;
+    thrustLinearizationActive = k > 0.0f;
+    if (!thrustLinearizationActive) {
+        return;
+    }
+    for (int i = 0; i < THRUST_LINEARIZATION_LOOKUP_LENGTH; i++) {
+        const float thrust = (float)i / (THRUST_LINEARIZATION_LOOKUP_LENGTH - 1);
+        thrustLinearizationLookup[i] = (sqrtf(sq(1.0f - k) + 4.0f * k * thrust) - (1.0f - k)) / (2.0f * k);
+    }
+}
+
+static FAST_CODE float applyThrustLinearization(float motorOutput)
+{
+    // the curve passes through both ends, outside of them the output is clipped anyway
+    if (motorOutput <= 0.0f || motorOutput >= 1.0f) {
+        return motorOutput;
+    }
+    const float position = motorOutput * (THRUST_LINEARIZATION_LOOKUP_LENGTH - 1);
+    const int index = position;
+    const float low = thrustLinearizationLookup[index];
+    return low + (position - index) * (thrustLinearizationLookup[index + 1] - low);
+}
+#endif
+
+void mixerInitProfile(const pidProfile_t *pidProfile)
+{
+    mixerRuntime.pidSumLimit = pidProfile->pidSumLimit;
+    mixerRuntime.pidSumLimitYaw = pidProfile->pidSumLimitYaw;
+}
+
 void mixerInit(mixerMode_e mixerMode)
 {
     currentMixerMode = mixerMode;
 
     initEscEndpoints();
+    mixerInitProfile(currentPidProfile);
+#ifdef USE_THRUST_LINEARIZATION
+    thrustLinearizationInit();
+#endif
     if (mixerIsTricopter()) {
         mixerTricopterInit();
     }
 }
 
+static void mixerSetMotorMix(int index, const motorMixer_t *motorMix)
+{
+    motorMixMatrix.roll[index] = motorMix->roll;
+    motorMixMatrix.pitch[index] = motorMix->pitch;
+    motorMixMatrix.yaw[index] = motorMix->yaw;
+    motorMixMatrix.throttle[index] = motorMix->throttle;
+}
+
 #ifndef USE_QUAD_MIXER_ONLY
 
 void mixerConfigureOutput(void)
@@ -432,13 +514,13 @@ void mixerConfigureOutput(void)
     motorCount = 0;
 
     if (currentMixerMode == MIXER_CUSTOM || currentMixerMode == MIXER_CUSTOM_TRI || currentMixerMode == MIXER_CUSTOM_AIRPLANE) {
-        // load custom mixer into currentMixer
+        // load custom mixer into motorMixMatrix
         for (int i = 0; i < MAX_SUPPORTED_MOTORS; i++) {
             // check if done
             if (customMotorMixer(i)->throttle == 0.0f) {
                 break;
             }
-            currentMixer[i] = *customMotorMixer(i);
+            mixerSetMotorMix(i, customMotorMixer(i));
             motorCount++;
         }
     } else {
@@ -449,7 +531,7 @@ void mixerConfigureOutput(void)
         // copy motor-based mixers
         if (mixers[currentMixerMode].motor) {
             for (int i = 0; i < motorCount; i++)
-                currentMixer[i] = mixers[currentMixerMode].motor[i];
+                mixerSetMotorMix(i, &mixers[currentMixerMode].motor[i]);
         }
     }
     mixerResetDisarmedMotors();
@@ -475,7 +557,7 @@ void mixerConfigureOutput(void)
 {
     motorCount = QUAD_MOTOR_COUNT;
     for (int i = 0; i < motorCount; i++) {
-        currentMixer[i] = mixerQuadX[i];
+        mixerSetMotorMix(i, &mixerQuadX[i]);
     }
     mixerResetDisarmedMotors();
 }
@@ -535,7 +617,7 @@ static void calculateThrottleAndCurrentMotorEndpoints(timeUs_t currentTimeUs)
 
     if (feature(FEATURE_3D)) {
         if (!ARMING_FLAG(ARMED)) {
-            rcThrottlePrevious = rxConfig()->midrc; // When disarmed set to mid_rc. It always results in positive direction after arming.
+            rcThrottlePrevious = mixerRuntime.midrc; // When disarmed set to mid_rc. It always results in positive direction after arming.
         }
 
         if (rcCommand[THROTTLE] <= rcCommand3dDeadBandLow) {
@@ -606,7 +688,7 @@ static void calculateThrottleAndCurrentMotorEndpoints(timeUs_t currentTimeUs)
             pidResetITerm();
         }
     } else {
-        throttle = rcCommand[THROTTLE] - rxConfig()->mincheck;
+        throttle = rcCommand[THROTTLE] - mixerRuntime.mincheck;
         currentThrottleInputRange = rcCommandThrottleRange;
         motorRangeMin = motorOutputLow;
         motorRangeMax = motorOutputHigh;
@@ -629,7 +711,7 @@ static void applyFlipOverAfterCrashModeToMotors(void)
         float stickDeflectionYawAbs = getRcDeflectionAbs(FD_YAW);
         float signPitch = getRcDeflection(FD_PITCH) < 0 ? 1 : -1;
         float signRoll = getRcDeflection(FD_ROLL) < 0 ? 1 : -1;
-        float signYaw = (getRcDeflection(FD_YAW) < 0 ? 1 : -1) * (mixerConfig()->yaw_motors_reversed ? 1 : -1);
+        float signYaw = (getRcDeflection(FD_YAW) < 0 ? 1 : -1) * (mixerRuntime.yawMotorsReversed ? 1 : -1);
 
         float stickDeflectionLength = sqrtf(stickDeflectionPitchAbs*stickDeflectionPitchAbs + stickDeflectionRollAbs*stickDeflectionRollAbs);
 
@@ -661,13 +743,13 @@ static void applyFlipOverAfterCrashModeToMotors(void)
 
         for (int i = 0; i < motorCount; ++i) {
             float motorOutput =
-                signPitch*currentMixer[i].pitch +
-                signRoll*currentMixer[i].roll +
-                signYaw*currentMixer[i].yaw;
+                signPitch*motorMixMatrix.pitch[i] +
+                signRoll*motorMixMatrix.roll[i] +
+                signYaw*motorMixMatrix.yaw[i];
                 
             if (motorOutput < 0) {
-                if (mixerConfig()->crashflip_motor_percent > 0) {
-                    motorOutput = -motorOutput * (float)mixerConfig()->crashflip_motor_percent / 100.0f;
+                if (mixerRuntime.crashflipMotorFactor > 0.0f) {
+                    motorOutput = -motorOutput * mixerRuntime.crashflipMotorFactor;
                 } else {
                     motorOutput = disarmMotorOutput;
                 }
@@ -687,37 +769,48 @@ static void applyFlipOverAfterCrashModeToMotors(void)
     }
 }
 
-static void applyMixToMotors(float motorMix[MAX_SUPPORTED_MOTORS])
+static void applyMixToMotors(const float motorMix[MAX_SUPPORTED_MOTORS], float motorMixScale)
 {
+    // Disarmed mode
+    if (!ARMING_FLAG(ARMED)) {
+        for (int i = 0; i < motorCount; i++) {
+            motor[i] = motor_disarmed[i];
+        }
+        return;
+    }
+
+    // Motor stop handling
+    if (feature(FEATURE_MOTOR_STOP) && !feature(FEATURE_3D) && !isAirmodeActive() && rcData[THROTTLE] < mixerRuntime.mincheck) {
+        for (int i = 0; i < motorCount; i++) {
+            motor[i] = disarmMotorOutput;
+        }
+        return;
+    }
+
+    // the conditions do not change from motor to motor, only the mix does
+    const float mixScale = motorOutputMixSign * motorMixScale;
+    const bool tricopter = mixerIsTricopter();
+    const bool failsafeActive = failsafeIsActive();
+    const bool preventDshotReservedRange = failsafeActive && isMotorProtocolDshot();
+    const float outputLow = failsafeActive ? disarmMotorOutput : motorRangeMin;
+
     // Now add in the desired throttle, but keep in a range that doesn't clip adjusted
     // roll/pitch/yaw. This could move throttle down, but also up for those low throttle flips.
     for (int i = 0; i < motorCount; i++) {
-        float motorOutput = motorOutputMin + (motorOutputRange * (motorOutputMixSign * motorMix[i] + throttle * currentMixer[i].throttle));
-        if (mixerIsTricopter()) {
-            motorOutput += mixerTricopterMotorCorrection(i);
-        }
-        if (failsafeIsActive()) {
-            if (isMotorProtocolDshot()) {
-                motorOutput = (motorOutput < motorRangeMin) ? disarmMotorOutput : motorOutput; // Prevent getting into special reserved range
-            }
-            motorOutput = constrain(motorOutput, disarmMotorOutput, motorRangeMax);
-        } else {
-            motorOutput = constrain(motorOutput, motorRangeMin, motorRangeMax);
+        float motorOutput = mixScale * motorMix[i] + throttle * motorMixMatrix.throttle[i];
+#ifdef USE_THRUST_LINEARIZATION
+        if (thrustLinearizationActive) {
+            motorOutput = applyThrustLinearization(motorOutput);
         }
-        // Motor stop handling
-        if (feature(FEATURE_MOTOR_STOP) && ARMING_FLAG(ARMED) && !feature(FEATURE_3D) && !isAirmodeActive()) {
-            if (((rcData[THROTTLE]) < rxConfig()->mincheck)) {
-                motorOutput = disarmMotorOutput;
-            }
+#endif
+        motorOutput = motorOutputMin + motorOutputRange * motorOutput;
+        if (tricopter) {
+            motorOutput += mixerTricopterMotorCorrection(i);
         }
-        motor[i] = motorOutput;
-    }
-
-    // Disarmed mode
-    if (!ARMING_FLAG(ARMED)) {
-        for (int i = 0; i < motorCount; i++) {
-            motor[i] = motor_disarmed[i];
+        if (preventDshotReservedRange) {
+            motorOutput = (motorOutput < motorRangeMin) ? disarmMotorOutput : motorOutput; // Prevent getting into special reserved range
         }
+        motor[i] = constrain(motorOutput, outputLow, motorRangeMax);
     }
 }
 
@@ -748,11 +841,11 @@ FAST_CODE_NOINLINE void mixTable(timeUs_t currentTimeUs, uint8_t vbatPidCompensa
 
     // Calculate and Limit the PID sum
     const float scaledAxisPidRoll =
-        constrainf(pidData[FD_ROLL].Sum, -currentPidProfile->pidSumLimit, currentPidProfile->pidSumLimit) / PID_MIXER_SCALING;
+        constrainf(pidData[FD_ROLL].Sum, -mixerRuntime.pidSumLimit, mixerRuntime.pidSumLimit) / PID_MIXER_SCALING;
     const float scaledAxisPidPitch =
-        constrainf(pidData[FD_PITCH].Sum, -currentPidProfile->pidSumLimit, currentPidProfile->pidSumLimit) / PID_MIXER_SCALING;
+        constrainf(pidData[FD_PITCH].Sum, -mixerRuntime.pidSumLimit, mixerRuntime.pidSumLimit) / PID_MIXER_SCALING;
 
-    uint16_t yawPidSumLimit = currentPidProfile->pidSumLimitYaw;
+    float yawPidSumLimit = mixerRuntime.pidSumLimitYaw;
 
 #ifdef USE_YAW_SPIN_RECOVERY
     const bool yawSpinDetected = gyroYawSpinDetected();
@@ -764,12 +857,15 @@ FAST_CODE_NOINLINE void mixTable(timeUs_t currentTimeUs, uint8_t vbatPidCompensa
     float scaledAxisPidYaw =
         constrainf(pidData[FD_YAW].Sum, -yawPidSumLimit, yawPidSumLimit) / PID_MIXER_SCALING;
 
-    if (!mixerConfig()->yaw_motors_reversed) {
+    if (!mixerRuntime.yawMotorsReversed) {
         scaledAxisPidYaw = -scaledAxisPidYaw;
     }
 
-    // Calculate voltage compensation
+    // Calculate voltage compensation, the mix is linear so it is applied to the axes rather than every motor
     const float vbatCompensationFactor = vbatPidCompensation ? calculateVbatPidCompensation() : 1.0f;
+    const float mixRoll = scaledAxisPidRoll * vbatCompensationFactor;
+    const float mixPitch = scaledAxisPidPitch * vbatCompensationFactor;
+    const float mixYaw = scaledAxisPidYaw * vbatCompensationFactor;
 
     // Apply the throttle_limit_percent to scale or limit the throttle based on throttle_limit_type
     if (currentControlRateProfile->throttle_limit_type != THROTTLE_LIMIT_TYPE_OFF) {
@@ -784,22 +880,17 @@ FAST_CODE_NOINLINE void mixTable(timeUs_t currentTimeUs, uint8_t vbatPidCompensa
     }
 #endif // USE_YAW_SPIN_RECOVERY
 
-    // Find roll/pitch/yaw desired output
+    // Find roll/pitch/yaw desired output and its range in the same pass
     float motorMix[MAX_SUPPORTED_MOTORS];
     float motorMixMax = 0, motorMixMin = 0;
     for (int i = 0; i < motorCount; i++) {
-        float mix =
-            scaledAxisPidRoll  * currentMixer[i].roll +
-            scaledAxisPidPitch * currentMixer[i].pitch +
-            scaledAxisPidYaw   * currentMixer[i].yaw;
-
-        mix *= vbatCompensationFactor;  // Add voltage compensation
+        const float mix =
+            mixRoll  * motorMixMatrix.roll[i] +
+            mixPitch * motorMixMatrix.pitch[i] +
+            mixYaw   * motorMixMatrix.yaw[i];
 
-        if (mix > motorMixMax) {
-            motorMixMax = mix;
-        } else if (mix < motorMixMin) {
-            motorMixMin = mix;
-        }
+        motorMixMax = MAX(motorMixMax, mix);
+        motorMixMin = MIN(motorMixMin, mix);
         motorMix[i] = mix;
     }
 
@@ -810,11 +901,11 @@ FAST_CODE_NOINLINE void mixTable(timeUs_t currentTimeUs, uint8_t vbatPidCompensa
     }
 #endif
 
+    // a saturated mix is scaled back to the output range when it is applied
+    float motorMixScale = 1.0f;
     motorMixRange = motorMixMax - motorMixMin;
     if (motorMixRange > 1.0f) {
-        for (int i = 0; i < motorCount; i++) {
-            motorMix[i] /= motorMixRange;
-        }
+        motorMixScale = 1.0f / motorMixRange;
         // Get the maximum correction by setting offset to center when airmode enabled
         if (isAirmodeActive()) {
             throttle = 0.5f;
@@ -827,7 +918,7 @@ FAST_CODE_NOINLINE void mixTable(timeUs_t currentTimeUs, uint8_t vbatPidCompensa
     }
 
     // Apply the mix to motor endpoints
-    applyMixToMotors(motorMix);
+    applyMixToMotors(motorMix, motorMixScale);
 }
 
 float convertExternalToMotor(uint16_t externalValue)
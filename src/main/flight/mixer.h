@@ -91,6 +91,7 @@ typedef struct mixerConfig_s {
     uint8_t mixerMode;
     bool yaw_motors_reversed;
     uint8_t crashflip_motor_percent;
+    uint8_t thrust_linear;                  // share of the thrust that is quadratic in the motor command, in percent
 } mixerConfig_t;
 
 PG_DECLARE(mixerConfig_t, mixerConfig);
@@ -102,6 +103,7 @@ typedef struct motorConfig_s {
     uint16_t maxthrottle;                   // This is the maximum value for the ESCs at full power this value can be increased up to 2000
     uint16_t mincommand;                    // This is the value for the ESCs when they are not armed. In some cases, this value must be lowered down to 900 for some specific ESCs
     uint8_t motorPoleCount;                // Magnetic poles in the motors for calculating actual RPM from eRPM provided by ESC telemetry
+    uint16_t motorOutputDelayUs;            // Time after the gyro sample at which the motors are updated, 0 updates them as soon as the mix is done
 } motorConfig_t;
 
 PG_DECLARE(motorConfig_t, motorConfig);
@@ -113,6 +115,7 @@ extern float motor[MAX_SUPPORTED_MOTORS];
 extern float motor_disarmed[MAX_SUPPORTED_MOTORS];
 extern float motorOutputHigh, motorOutputLow;
 struct rxConfig_s;
+struct pidProfile_s;
 
 uint8_t getMotorCount(void);
 float getMotorMixRange(void);
@@ -121,6 +124,7 @@ bool mixerIsOutputSaturated(int axis, float errorRate);
 
 void mixerLoadMix(int index, motorMixer_t *customMixers);
 void mixerInit(mixerMode_e mixerMode);
+void mixerInitProfile(const struct pidProfile_s *pidProfile);
 
 void mixerConfigureOutput(void);
 
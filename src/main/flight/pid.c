@@ -33,6 +33,7 @@
 #include "common/filter.h"
 
 #include "config/config_reset.h"
+#include "config/feature.h"
 #include "pg/pg.h"
 #include "pg/pg_ids.h"
 
@@ -53,6 +54,7 @@
 #include "io/gps.h"
 
 #include "sensors/gyro.h"
+#include "sensors/gyroanalyse.h"
 #include "sensors/acceleration.h"
 
 
@@ -66,7 +68,7 @@ static FAST_RAM_ZERO_INIT bool inCrashRecoveryMode = false;
 static FAST_RAM_ZERO_INIT float dT;
 static FAST_RAM_ZERO_INIT float pidFrequency;
 
-PG_REGISTER_WITH_RESET_TEMPLATE(pidConfig_t, pidConfig, PG_PID_CONFIG, 2);
+PG_REGISTER_WITH_RESET_TEMPLATE(pidConfig_t, pidConfig, PG_PID_CONFIG, 4);
 
 #ifdef STM32F10X
 #define PID_PROCESS_DENOM_DEFAULT       1
@@ -94,7 +96,7 @@ PG_RESET_TEMPLATE(pidConfig_t, pidConfig,
 #define ACRO_TRAINER_SETPOINT_LIMIT       1000.0f // Limit the correcting setpoint
 #endif // USE_ACRO_TRAINER
 
-PG_REGISTER_ARRAY_WITH_RESET_FN(pidProfile_t, MAX_PROFILE_COUNT, pidProfiles, PG_PID_PROFILE, 4);
+PG_REGISTER_ARRAY_WITH_RESET_FN(pidProfile_t, MAX_PROFILE_COUNT, pidProfiles, PG_PID_PROFILE, 5);
 
 void resetPidProfile(pidProfile_t *pidProfile)
 {
@@ -166,6 +168,8 @@ void pgResetFn_pidProfiles(pidProfile_t *pidProfiles)
     }
 }
 
+static FAST_RAM_ZERO_INIT uint8_t pidProcessDenom;
+
 static void pidSetTargetLooptime(uint32_t pidLooptime)
 {
     targetPidLooptime = pidLooptime;
@@ -203,6 +207,13 @@ static FAST_RAM_ZERO_INIT filterApplyFnPtr dtermLowpassApplyFn;
 static FAST_RAM_ZERO_INIT dtermLowpass_t dtermLowpass[2];
 static FAST_RAM_ZERO_INIT filterApplyFnPtr dtermLowpass2ApplyFn;
 static FAST_RAM_ZERO_INIT pt1Filter_t dtermLowpass2[2];
+static FAST_RAM_ZERO_INIT filterChainApplyFnPtr dtermFilterChainApplyFn;
+static FAST_RAM_ZERO_INIT filterChain_t dtermFilterChain[2];
+#ifdef USE_GYRO_DATA_ANALYSE
+// retuned by the gyro analyser together with the gyro dynamic notches, yaw is left unused
+static FAST_RAM_ZERO_INIT uint8_t dtermNotchDynCount;
+static FAST_RAM_ZERO_INIT biquadFilter_t dtermNotchDyn[DYN_NOTCH_COUNT_MAX][XYZ_AXIS_COUNT];
+#endif
 static FAST_RAM_ZERO_INIT filterApplyFnPtr ptermYawLowpassApplyFn;
 static FAST_RAM_ZERO_INIT pt1Filter_t ptermYawLowpass;
 #if defined(USE_ITERM_RELAX)
@@ -220,15 +231,52 @@ static FAST_RAM_ZERO_INIT uint8_t rcSmoothingDebugAxis;
 static FAST_RAM_ZERO_INIT uint8_t rcSmoothingFilterType;
 #endif // USE_RC_SMOOTHING_FILTER
 
-void pidInitFilters(const pidProfile_t *pidProfile)
+static void pidInitDtermFilterChain(void)
 {
-    BUILD_BUG_ON(FD_YAW != 2); // only setting up Dterm filters on roll and pitch axes, so ensure yaw axis is 2
+    bool ok = true;
+    for (int axis = FD_ROLL; axis <= FD_PITCH; axis++) {
+        filterChainInit(&dtermFilterChain[axis]);
+        ok = filterChainAdd(&dtermFilterChain[axis], dtermNotchApplyFn, &dtermNotch[axis]) && ok;
+        ok = filterChainAdd(&dtermFilterChain[axis], dtermLowpassApplyFn, &dtermLowpass[axis]) && ok;
+        ok = filterChainAdd(&dtermFilterChain[axis], dtermLowpass2ApplyFn, &dtermLowpass2[axis]) && ok;
+    }
+    // stages the chain does not know about are applied one by one by pidApplyDtermFilters()
+    dtermFilterChainApplyFn = ok ? filterChainGetApplyFn(&dtermFilterChain[FD_ROLL]) : NULL;
+}
+
+static FAST_CODE float pidApplyDtermFilters(int axis, float gyroRate)
+{
+    if (dtermFilterChainApplyFn) {
+        return dtermFilterChainApplyFn(&dtermFilterChain[axis], gyroRate);
+    }
+    gyroRate = dtermNotchApplyFn((filter_t *) &dtermNotch[axis], gyroRate);
+    gyroRate = dtermLowpassApplyFn((filter_t *) &dtermLowpass[axis], gyroRate);
+    return dtermLowpass2ApplyFn((filter_t *) &dtermLowpass2[axis], gyroRate);
+}
+
+// The filters of a profile with their coefficients worked out, one filter of each stage
+// stands for both axes
+typedef struct pidProfileFilters_s {
+    filterApplyFnPtr dtermNotchApplyFn;
+    biquadFilter_t dtermNotch;
+    filterApplyFnPtr dtermLowpassApplyFn;
+    dtermLowpass_t dtermLowpass;
+    filterApplyFnPtr dtermLowpass2ApplyFn;
+    pt1Filter_t dtermLowpass2;
+    filterApplyFnPtr ptermYawLowpassApplyFn;
+    pt1Filter_t ptermYawLowpass;
+} pidProfileFilters_t;
+
+static void pidBuildFilters(const pidProfile_t *pidProfile, pidProfileFilters_t *filters)
+{
+    memset(filters, 0, sizeof(pidProfileFilters_t));
 
     if (targetPidLooptime == 0) {
         // no looptime set, so set all the filters to null
-        dtermNotchApplyFn = nullFilterApply;
-        dtermLowpassApplyFn = nullFilterApply;
-        ptermYawLowpassApplyFn = nullFilterApply;
+        filters->dtermNotchApplyFn = nullFilterApply;
+        filters->dtermLowpassApplyFn = nullFilterApply;
+        filters->dtermLowpass2ApplyFn = nullFilterApply;
+        filters->ptermYawLowpassApplyFn = nullFilterApply;
         return;
     }
 
@@ -246,53 +294,130 @@ void pidInitFilters(const pidProfile_t *pidProfile)
     }
 
     if (dTermNotchHz != 0 && pidProfile->dterm_notch_cutoff != 0) {
-        dtermNotchApplyFn = (filterApplyFnPtr)biquadFilterApply;
+        filters->dtermNotchApplyFn = (filterApplyFnPtr)biquadFilterApply;
         const float notchQ = filterGetNotchQ(dTermNotchHz, pidProfile->dterm_notch_cutoff);
-        for (int axis = FD_ROLL; axis <= FD_PITCH; axis++) {
-            biquadFilterInit(&dtermNotch[axis], dTermNotchHz, targetPidLooptime, notchQ, FILTER_NOTCH);
-        }
+        biquadFilterInit(&filters->dtermNotch, dTermNotchHz, targetPidLooptime, notchQ, FILTER_NOTCH);
     } else {
-        dtermNotchApplyFn = nullFilterApply;
+        filters->dtermNotchApplyFn = nullFilterApply;
     }
 
     //2nd Dterm Lowpass Filter
     if (pidProfile->dterm_lowpass2_hz == 0 || pidProfile->dterm_lowpass2_hz > pidFrequencyNyquist) {
-    	dtermLowpass2ApplyFn = nullFilterApply;
+        filters->dtermLowpass2ApplyFn = nullFilterApply;
     } else {
-        dtermLowpass2ApplyFn = (filterApplyFnPtr)pt1FilterApply;
-        for (int axis = FD_ROLL; axis <= FD_PITCH; axis++) {
-            pt1FilterInit(&dtermLowpass2[axis], pt1FilterGain(pidProfile->dterm_lowpass2_hz, dT));
-        }
+        filters->dtermLowpass2ApplyFn = (filterApplyFnPtr)pt1FilterApply;
+        pt1FilterInit(&filters->dtermLowpass2, pt1FilterGain(pidProfile->dterm_lowpass2_hz, dT));
     }
 
     if (pidProfile->dterm_lowpass_hz == 0 || pidProfile->dterm_lowpass_hz > pidFrequencyNyquist) {
-        dtermLowpassApplyFn = nullFilterApply;
+        filters->dtermLowpassApplyFn = nullFilterApply;
     } else {
         switch (pidProfile->dterm_filter_type) {
         default:
-            dtermLowpassApplyFn = nullFilterApply;
+            filters->dtermLowpassApplyFn = nullFilterApply;
             break;
         case FILTER_PT1:
-            dtermLowpassApplyFn = (filterApplyFnPtr)pt1FilterApply;
-            for (int axis = FD_ROLL; axis <= FD_PITCH; axis++) {
-                pt1FilterInit(&dtermLowpass[axis].pt1Filter, pt1FilterGain(pidProfile->dterm_lowpass_hz, dT));
-            }
+            filters->dtermLowpassApplyFn = (filterApplyFnPtr)pt1FilterApply;
+            pt1FilterInit(&filters->dtermLowpass.pt1Filter, pt1FilterGain(pidProfile->dterm_lowpass_hz, dT));
             break;
         case FILTER_BIQUAD:
-            dtermLowpassApplyFn = (filterApplyFnPtr)biquadFilterApply;
-            for (int axis = FD_ROLL; axis <= FD_PITCH; axis++) {
-                biquadFilterInitLPF(&dtermLowpass[axis].biquadFilter, pidProfile->dterm_lowpass_hz, targetPidLooptime);
-            }
+            filters->dtermLowpassApplyFn = (filterApplyFnPtr)biquadFilterApply;
+            biquadFilterInitLPF(&filters->dtermLowpass.biquadFilter, pidProfile->dterm_lowpass_hz, targetPidLooptime);
             break;
         }
     }
 
     if (pidProfile->yaw_lowpass_hz == 0 || pidProfile->yaw_lowpass_hz > pidFrequencyNyquist) {
-        ptermYawLowpassApplyFn = nullFilterApply;
+        filters->ptermYawLowpassApplyFn = nullFilterApply;
     } else {
-        ptermYawLowpassApplyFn = (filterApplyFnPtr)pt1FilterApply;
-        pt1FilterInit(&ptermYawLowpass, pt1FilterGain(pidProfile->yaw_lowpass_hz, dT));
+        filters->ptermYawLowpassApplyFn = (filterApplyFnPtr)pt1FilterApply;
+        pt1FilterInit(&filters->ptermYawLowpass, pt1FilterGain(pidProfile->yaw_lowpass_hz, dT));
+    }
+}
+
+// with keepState only the coefficients are taken, so the output carries on from where it was
+static void pidInstallBiquad(biquadFilter_t *filter, const biquadFilter_t *from, bool keepState)
+{
+    if (keepState) {
+        filter->b0 = from->b0;
+        filter->b1 = from->b1;
+        filter->b2 = from->b2;
+        filter->a1 = from->a1;
+        filter->a2 = from->a2;
+    } else {
+        *filter = *from;
+    }
+}
+
+static void pidInstallPt1(pt1Filter_t *filter, const pt1Filter_t *from, bool keepState)
+{
+    if (keepState) {
+        filter->k = from->k;
+    } else {
+        *filter = *from;
+    }
+}
+
+// The state of a stage is only kept when the stage stays the same kind of filter
+static void pidInstallFilters(const pidProfileFilters_t *filters, bool keepState)
+{
+    const bool keepNotch = keepState && filters->dtermNotchApplyFn == dtermNotchApplyFn;
+    const bool keepLowpass = keepState && filters->dtermLowpassApplyFn == dtermLowpassApplyFn;
+    const bool keepLowpass2 = keepState && filters->dtermLowpass2ApplyFn == dtermLowpass2ApplyFn;
+
+    for (int axis = FD_ROLL; axis <= FD_PITCH; axis++) {
+        pidInstallBiquad(&dtermNotch[axis], &filters->dtermNotch, keepNotch);
+        if (filters->dtermLowpassApplyFn == (filterApplyFnPtr)biquadFilterApply) {
+            pidInstallBiquad(&dtermLowpass[axis].biquadFilter, &filters->dtermLowpass.biquadFilter, keepLowpass);
+        } else {
+            pidInstallPt1(&dtermLowpass[axis].pt1Filter, &filters->dtermLowpass.pt1Filter, keepLowpass);
+        }
+        pidInstallPt1(&dtermLowpass2[axis], &filters->dtermLowpass2, keepLowpass2);
     }
+    pidInstallPt1(&ptermYawLowpass, &filters->ptermYawLowpass, keepState && filters->ptermYawLowpassApplyFn == ptermYawLowpassApplyFn);
+
+    dtermNotchApplyFn = filters->dtermNotchApplyFn;
+    dtermLowpassApplyFn = filters->dtermLowpassApplyFn;
+    dtermLowpass2ApplyFn = filters->dtermLowpass2ApplyFn;
+    ptermYawLowpassApplyFn = filters->ptermYawLowpassApplyFn;
+
+    pidInitDtermFilterChain();
+}
+
+#ifdef USE_GYRO_DATA_ANALYSE
+static void pidInitDtermDynNotch(const pidProfile_t *pidProfile, bool keepState)
+{
+    const uint8_t count = pidProfile->dterm_dyn_notch && feature(FEATURE_DYNAMIC_FILTER) ? constrain(gyroConfig()->dyn_notch_count, 1, DYN_NOTCH_COUNT_MAX) : 0;
+
+    // notches already running keep following the peaks, new ones start off at the same placeholder as the gyro notches
+    if (!keepState || count != dtermNotchDynCount) {
+        const float notchQ = filterGetNotchQ(400, 390);
+        for (int notch = 0; notch < count; notch++) {
+            for (int axis = FD_ROLL; axis <= FD_PITCH; axis++) {
+                biquadFilterInit(&dtermNotchDyn[notch][axis], 400, targetPidLooptime, notchQ, FILTER_NOTCH);
+            }
+        }
+    }
+    dtermNotchDynCount = count;
+    gyroDataAnalyseSetDtermNotch(count ? dtermNotchDyn : NULL, targetPidLooptime);
+}
+#endif
+
+void pidInitFilters(const pidProfile_t *pidProfile)
+{
+    BUILD_BUG_ON(FD_YAW != 2); // only setting up Dterm filters on roll and pitch axes, so ensure yaw axis is 2
+
+    pidProfileFilters_t filters;
+    pidBuildFilters(pidProfile, &filters);
+    pidInstallFilters(&filters, false);
+
+    if (targetPidLooptime == 0) {
+        return;
+    }
+
+#ifdef USE_GYRO_DATA_ANALYSE
+    pidInitDtermDynNotch(pidProfile, false);
+#endif
 
 #if defined(USE_THROTTLE_BOOST)
     pt1FilterInit(&throttleLpf, pt1FilterGain(pidProfile->throttle_boost_cutoff, dT));
@@ -343,17 +468,29 @@ void pidUpdateSetpointDerivativeLpf(uint16_t filterCutoff)
 }
 #endif // USE_RC_SMOOTHING_FILTER
 
+// per axis constants, precomputed from the profile by pidInitConfig()
 typedef struct pidCoefficient_s {
     float Kp;
     float Ki;
     float Kd;
+    float Kf;           // setpoint derivative gain, Kd scaled by the setpoint weight
+    float maxVelocity;  // setpoint change limit per PID loop, 0 for none
+    bool itermRelax;
 } pidCoefficient_t;
 
-static FAST_RAM_ZERO_INIT pidCoefficient_t pidCoefficient[3];
-static FAST_RAM_ZERO_INIT float maxVelocity[3];
+// per axis values carried from one PID loop to the next
+typedef struct pidAxisState_s {
+    float previousSetpoint;         // acceleration limited setpoint
+    float previousGyroRateDterm;
+    float previousPidSetpoint;
+} pidAxisState_t;
+
+static FAST_RAM_ZERO_INIT pidCoefficient_t pidCoefficient[XYZ_AXIS_COUNT];
+static FAST_RAM_ZERO_INIT pidAxisState_t pidAxisState[XYZ_AXIS_COUNT];
 static FAST_RAM_ZERO_INIT float relaxFactor;
-static FAST_RAM_ZERO_INIT float dtermSetpointWeight;
+static FAST_RAM_ZERO_INIT bool dtermSetpointWeightActive;
 static FAST_RAM_ZERO_INIT float levelGain, horizonGain, horizonTransition, horizonCutoffDegrees, horizonFactorRatio;
+static FAST_RAM_ZERO_INIT float levelAngleLimit;
 static FAST_RAM_ZERO_INIT float ITermWindupPointInv;
 static FAST_RAM_ZERO_INIT uint8_t horizonTiltExpertMode;
 static FAST_RAM_ZERO_INIT timeDelta_t crashTimeLimitUs;
@@ -402,26 +539,31 @@ static FAST_RAM_ZERO_INIT float acroTrainerGain;
 
 void pidInitConfig(const pidProfile_t *pidProfile)
 {
+    const float dtermSetpointWeight = pidProfile->dtermSetpointWeight / 100.0f;
+    dtermSetpointWeightActive = dtermSetpointWeight != 0;
     for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
         pidCoefficient[axis].Kp = PTERM_SCALE * pidProfile->pid[axis].P;
         pidCoefficient[axis].Ki = ITERM_SCALE * pidProfile->pid[axis].I;
         pidCoefficient[axis].Kd = DTERM_SCALE * pidProfile->pid[axis].D;
+        pidCoefficient[axis].Kf = pidCoefficient[axis].Kd * dtermSetpointWeight;
+        pidCoefficient[axis].maxVelocity = (axis == FD_YAW ? pidProfile->yawRateAccelLimit : pidProfile->rateAccelLimit) * 100 * dT;
+#if defined(USE_ITERM_RELAX)
+        pidCoefficient[axis].itermRelax = pidProfile->iterm_relax && (axis < FD_YAW || pidProfile->iterm_relax == ITERM_RELAX_RPY);
+#endif
     }
 
-    dtermSetpointWeight = pidProfile->dtermSetpointWeight / 100.0f;
     if (pidProfile->setpointRelaxRatio == 0) {
         relaxFactor = 0;
     } else {
         relaxFactor = 100.0f / pidProfile->setpointRelaxRatio;
     }
+    levelAngleLimit = pidProfile->levelAngleLimit;
     levelGain = pidProfile->pid[PID_LEVEL].P / 10.0f;
     horizonGain = pidProfile->pid[PID_LEVEL].I / 10.0f;
     horizonTransition = (float)pidProfile->pid[PID_LEVEL].D;
     horizonTiltExpertMode = pidProfile->horizon_tilt_expert_mode;
     horizonCutoffDegrees = (175 - pidProfile->horizon_tilt_effect) * 1.8f;
     horizonFactorRatio = (100 - pidProfile->horizon_tilt_effect) * 0.01f;
-    maxVelocity[FD_ROLL] = maxVelocity[FD_PITCH] = pidProfile->rateAccelLimit * 100 * dT;
-    maxVelocity[FD_YAW] = pidProfile->yawRateAccelLimit * 100 * dT;
     const float ITermWindupPoint = (float)pidProfile->itermWindupPointPercent / 100.0f;
     ITermWindupPointInv = 1.0f / (1.0f - ITermWindupPoint);
     crashTimeLimitUs = pidProfile->crash_time * 1000;
@@ -458,15 +600,85 @@ void pidInitConfig(const pidProfile_t *pidProfile)
     acLimit = (float)pidProfile->abs_control_limit;
     acErrorLimit = (float)pidProfile->abs_control_error_limit;
 #endif
+
+    // the mixer limits the PID sums of the same profile
+    mixerInitProfile(pidProfile);
+}
+
+// A profile switched to in flight is prepared by pidPrepareProfile() in the task that switched
+// it, which does the slow part of working out the filter coefficients. The PID loop takes the
+// new profile at the start of its next run. The filter states carry over, so the switch does not
+// stall the loop or kick the D term.
+static pidProfileFilters_t pidPendingFilters;
+static const pidProfile_t * volatile pidPendingProfile;
+
+void pidPrepareProfile(const pidProfile_t *pidProfile)
+{
+    // holds the swap off while the buffer is written
+    pidPendingProfile = NULL;
+    pidBuildFilters(pidProfile, &pidPendingFilters);
+    pidPendingProfile = pidProfile;
+}
+
+// Takes new filter coefficients in flight without resetting the filter states,
+// pidInitConfig() must have been called for the profile first
+static void pidUpdateFilters(const pidProfile_t *pidProfile, const pidProfileFilters_t *filters)
+{
+    pidInstallFilters(filters, true);
+#ifdef USE_GYRO_DATA_ANALYSE
+    pidInitDtermDynNotch(pidProfile, true);
+#endif
+#if defined(USE_THROTTLE_BOOST)
+    pt1FilterUpdateCutoff(&throttleLpf, pt1FilterGain(pidProfile->throttle_boost_cutoff, dT));
+#endif
+#if defined(USE_ITERM_RELAX)
+    if (itermRelax) {
+        for (int i = 0; i < XYZ_AXIS_COUNT; i++) {
+            pt1FilterUpdateCutoff(&windupLpf[i], pt1FilterGain(itermRelaxCutoff, dT));
+        }
+    }
+#endif
+}
+
+static void pidApplyPendingProfile(void)
+{
+    const pidProfile_t *pidProfile = pidPendingProfile;
+    pidPendingProfile = NULL;
+
+    pidInitConfig(pidProfile);
+    pidUpdateFilters(pidProfile, &pidPendingFilters);
 }
 
 void pidInit(const pidProfile_t *pidProfile)
 {
-    pidSetTargetLooptime(gyro.targetLooptime * pidConfig()->pid_process_denom); // Initialize pid looptime
+    pidPendingProfile = NULL;
+    pidProcessDenom = pidConfig()->pid_process_denom;
+    pidSetTargetLooptime(gyro.targetLooptime * pidProcessDenom); // Initialize pid looptime
     pidInitFilters(pidProfile);
     pidInitConfig(pidProfile);
 }
 
+uint8_t pidGetProcessDenom(void)
+{
+    return pidProcessDenom;
+}
+
+#ifdef USE_ADAPTIVE_PID_PROCESS_DENOM
+// Changes the PID loop rate at runtime. Must be called from the PID loop itself,
+// the filter coefficients and the looptime dependent limits are recalculated for the new rate.
+// The filter and I term states carry on, so the change does not kick the D term.
+void pidSetProcessDenom(const pidProfile_t *pidProfile, uint8_t denom)
+{
+    pidProcessDenom = constrain(denom, 1, MAX_PID_PROCESS_DENOM);
+    pidSetTargetLooptime(gyro.targetLooptime * pidProcessDenom);
+
+    pidProfileFilters_t filters;
+    pidBuildFilters(pidProfile, &filters);
+    pidInitConfig(pidProfile);
+    pidUpdateFilters(pidProfile, &filters);
+}
+#endif
+
 #ifdef USE_ACRO_TRAINER
 void pidAcroTrainerInit(void)
 {
@@ -491,7 +703,7 @@ static float calcHorizonLevelStrength(void)
     float horizonLevelStrength = 1.0f - MAX(getRcDeflectionAbs(FD_ROLL), getRcDeflectionAbs(FD_PITCH));
 
     // 0 at level, 90 at vertical, 180 at inverted (degrees):
-    const float currentInclination = MAX(ABS(attitude.values.roll), ABS(attitude.values.pitch)) / 10.0f;
+    const float currentInclination = MAX(ABS(getAttitude()->values.roll), ABS(getAttitude()->values.pitch)) / 10.0f;
 
     // horizonTiltExpertMode:  0 = leveling always active when sticks centered,
     //                         1 = leveling can be totally off when inverted
@@ -540,22 +752,22 @@ static float calcHorizonLevelStrength(void)
     return constrainf(horizonLevelStrength, 0, 1);
 }
 
-static float pidLevel(int axis, const pidProfile_t *pidProfile, const rollAndPitchTrims_t *angleTrim, float currentPidSetpoint) {
+// horizonLevelStrength is only used in HORIZON mode, it is the same for roll and pitch so the caller works it out once
+static float pidLevel(int axis, const rollAndPitchTrims_t *angleTrim, float currentPidSetpoint, float horizonLevelStrength) {
     // calculate error angle and limit the angle to the max inclination
     // rcDeflection is in range [-1.0, 1.0]
-    float angle = pidProfile->levelAngleLimit * getRcDeflection(axis);
+    float angle = levelAngleLimit * getRcDeflection(axis);
 #ifdef USE_GPS_RESCUE
     angle += gpsRescueAngle[axis] / 100; // ANGLE IS IN CENTIDEGREES
 #endif
-    angle = constrainf(angle, -pidProfile->levelAngleLimit, pidProfile->levelAngleLimit);
-    const float errorAngle = angle - ((attitude.raw[axis] - angleTrim->raw[axis]) / 10.0f);
+    angle = constrainf(angle, -levelAngleLimit, levelAngleLimit);
+    const float errorAngle = angle - ((getAttitude()->raw[axis] - angleTrim->raw[axis]) / 10.0f);
     if (FLIGHT_MODE(ANGLE_MODE) || FLIGHT_MODE(GPS_RESCUE_MODE)) {
         // ANGLE mode - control is angle based
         currentPidSetpoint = errorAngle * levelGain;
     } else {
         // HORIZON mode - mix of ANGLE and ACRO modes
         // mix in errorAngle to currentPidSetpoint to add a little auto-level feel
-        const float horizonLevelStrength = calcHorizonLevelStrength();
         currentPidSetpoint = currentPidSetpoint + (errorAngle * horizonGain * horizonLevelStrength);
     }
     return currentPidSetpoint;
@@ -563,14 +775,15 @@ static float pidLevel(int axis, const pidProfile_t *pidProfile, const rollAndPit
 
 static float accelerationLimit(int axis, float currentPidSetpoint)
 {
-    static float previousSetpoint[3];
-    const float currentVelocity = currentPidSetpoint - previousSetpoint[axis];
+    const float maxVelocity = pidCoefficient[axis].maxVelocity;
+    float *previousSetpoint = &pidAxisState[axis].previousSetpoint;
+    const float currentVelocity = currentPidSetpoint - *previousSetpoint;
 
-    if (ABS(currentVelocity) > maxVelocity[axis]) {
-        currentPidSetpoint = (currentVelocity > 0) ? previousSetpoint[axis] + maxVelocity[axis] : previousSetpoint[axis] - maxVelocity[axis];
+    if (ABS(currentVelocity) > maxVelocity) {
+        currentPidSetpoint = (currentVelocity > 0) ? *previousSetpoint + maxVelocity : *previousSetpoint - maxVelocity;
     }
 
-    previousSetpoint[axis] = currentPidSetpoint;
+    *previousSetpoint = currentPidSetpoint;
     return currentPidSetpoint;
 }
 
@@ -590,7 +803,7 @@ static void handleCrashRecovery(
             // on roll and pitch axes calculate currentPidSetpoint and errorRate to level the aircraft to recover from crash
             if (sensors(SENSOR_ACC)) {
                 // errorAngle is deviation from horizontal
-                const float errorAngle =  -(attitude.raw[axis] - angleTrim->raw[axis]) / 10.0f;
+                const float errorAngle =  -(getAttitude()->raw[axis] - angleTrim->raw[axis]) / 10.0f;
                 *currentPidSetpoint = errorAngle * levelGain;
                 *errorRate = *currentPidSetpoint - gyroRate;
             }
@@ -605,8 +818,8 @@ static void handleCrashRecovery(
                    && ABS(gyro.gyroADCf[FD_YAW]) < crashRecoveryRate)) {
             if (sensors(SENSOR_ACC)) {
                 // check aircraft nearly level
-                if (ABS(attitude.raw[FD_ROLL] - angleTrim->raw[FD_ROLL]) < crashRecoveryAngleDeciDegrees
-                   && ABS(attitude.raw[FD_PITCH] - angleTrim->raw[FD_PITCH]) < crashRecoveryAngleDeciDegrees) {
+                if (ABS(getAttitude()->raw[FD_ROLL] - angleTrim->raw[FD_ROLL]) < crashRecoveryAngleDeciDegrees
+                   && ABS(getAttitude()->raw[FD_PITCH] - angleTrim->raw[FD_PITCH]) < crashRecoveryAngleDeciDegrees) {
                     inCrashRecoveryMode = false;
                     BEEP_OFF;
                 }
@@ -714,7 +927,7 @@ static FAST_CODE_NOINLINE float applyAcroTrainer(int axis, const rollAndPitchTri
         bool resetIterm = false;
         float projectedAngle = 0;
         const int setpointSign = acroTrainerSign(setPoint);
-        const float currentAngle = (attitude.raw[axis] - angleTrim->raw[axis]) / 10.0f;
+        const float currentAngle = (getAttitude()->raw[axis] - angleTrim->raw[axis]) / 10.0f;
         const int angleSign = acroTrainerSign(currentAngle);
 
         if ((acroTrainerAxisState[axis] != 0) && (acroTrainerAxisState[axis] != setpointSign)) {  // stick has reversed - stop limiting
@@ -764,10 +977,13 @@ static FAST_CODE_NOINLINE float applyAcroTrainer(int axis, const rollAndPitchTri
 
 // Betaflight pid controller, which will be maintained in the future with additional features specialised for current (mini) multirotor usage.
 // Based on 2DOF reference design (matlab)
+// Everything that does not change from axis to axis is worked out before the axis loop, so the loop
+// only works on the packed per axis coefficients and state.
 void FAST_CODE pidController(const pidProfile_t *pidProfile, const rollAndPitchTrims_t *angleTrim, timeUs_t currentTimeUs)
 {
-    static float previousGyroRateDterm[2];
-    static float previousPidSetpoint[2];
+    if (pidPendingProfile) {
+        pidApplyPendingProfile();
+    }
 
     const float tpaFactor = getThrottlePIDAttenuation();
     const float motorMixRange = getMotorMixRange();
@@ -781,27 +997,45 @@ void FAST_CODE pidController(const pidProfile_t *pidProfile, const rollAndPitchT
     const float dynCi = MIN((1.0f - motorMixRange) * ITermWindupPointInv, 1.0f) * dT * itermAccelerator;
 
     // Dynamic d component, enable 2-DOF PID controller only for rate mode
-    const float dynCd = flightModeFlags ? 0.0f : dtermSetpointWeight;
+    const float dynCf = flightModeFlags ? 0.0f : 1.0f;
+#ifdef USE_RC_SMOOTHING_FILTER
+    const bool setpointDerivativeFilterActive = dtermSetpointWeightActive && !flightModeFlags && setpointDerivativeLpfInitialized;
+#endif
+
+    const bool levelModeActive = FLIGHT_MODE(ANGLE_MODE) || FLIGHT_MODE(HORIZON_MODE) || FLIGHT_MODE(GPS_RESCUE_MODE);
+    const float horizonLevelStrength = levelModeActive && !FLIGHT_MODE(ANGLE_MODE) && !FLIGHT_MODE(GPS_RESCUE_MODE) ? calcHorizonLevelStrength() : 0.0f;
+    const pidCrashRecovery_e crashRecovery = pidProfile->crash_recovery;
+#if defined(USE_ABSOLUTE_CONTROL)
+    const bool absoluteControlActive = acGain > 0 && isAirmodeActivated();
+#endif
 
     // Precalculate gyro deta for D-term here, this allows loop unrolling
     float gyroRateDterm[2];
     for (int axis = FD_ROLL; axis < FD_YAW; ++axis) {
-        gyroRateDterm[axis] = dtermNotchApplyFn((filter_t *) &dtermNotch[axis], gyro.gyroADCf[axis]);
-        gyroRateDterm[axis] = dtermLowpassApplyFn((filter_t *) &dtermLowpass[axis], gyroRateDterm[axis]);
-        gyroRateDterm[axis] = dtermLowpass2ApplyFn((filter_t *) &dtermLowpass2[axis], gyroRateDterm[axis]);
+        float gyroRate = gyro.gyroADCf[axis];
+#ifdef USE_GYRO_DATA_ANALYSE
+        // DF1 like the gyro dynamic notches, as they are retuned on the fly
+        for (int notch = 0; notch < dtermNotchDynCount; notch++) {
+            gyroRate = biquadFilterApplyDF1(&dtermNotchDyn[notch][axis], gyroRate);
+        }
+#endif
+        gyroRateDterm[axis] = pidApplyDtermFilters(axis, gyroRate);
     }
 
     rotateITermAndAxisError();
 
     // ----------PID controller----------
     for (int axis = FD_ROLL; axis <= FD_YAW; ++axis) {
+        const pidCoefficient_t *coefficient = &pidCoefficient[axis];
+        pidAxisState_t *state = &pidAxisState[axis];
+
         float currentPidSetpoint = getSetpointRate(axis);
-        if (maxVelocity[axis]) {
+        if (coefficient->maxVelocity) {
             currentPidSetpoint = accelerationLimit(axis, currentPidSetpoint);
         }
         // Yaw control is GYRO based, direct sticks control is applied to rate PID
-        if ((FLIGHT_MODE(ANGLE_MODE) || FLIGHT_MODE(HORIZON_MODE) || FLIGHT_MODE(GPS_RESCUE_MODE)) && axis != YAW) {
-            currentPidSetpoint = pidLevel(axis, pidProfile, angleTrim, currentPidSetpoint);
+        if (levelModeActive && axis != YAW) {
+            currentPidSetpoint = pidLevel(axis, angleTrim, currentPidSetpoint, horizonLevelStrength);
         }
 
 #ifdef USE_ACRO_TRAINER
@@ -824,11 +1058,11 @@ void FAST_CODE pidController(const pidProfile_t *pidProfile, const rollAndPitchT
 #ifdef USE_ABSOLUTE_CONTROL
         float acCorrection = 0;
         float acErrorRate;
-#endif        
+#endif
         float itermErrorRate = 0.0f;
 
 #if defined(USE_ITERM_RELAX)
-        if (itermRelax && (axis < FD_YAW || itermRelax == ITERM_RELAX_RPY )) {
+        if (coefficient->itermRelax) {
             const float setpointLpf = pt1FilterApply(&windupLpf[axis], currentPidSetpoint);
             const float setpointHpf = fabsf(currentPidSetpoint - setpointLpf);
             const float itermRelaxFactor = 1 - setpointHpf / 30.0f;
@@ -837,7 +1071,7 @@ void FAST_CODE pidController(const pidProfile_t *pidProfile, const rollAndPitchT
             } else if (itermRelaxType == ITERM_RELAX_GYRO ) {
                 itermErrorRate = fapplyDeadband(setpointLpf - gyroRate, setpointHpf);
             }
-            
+
             if (axis == FD_ROLL) {
                 DEBUG_SET(DEBUG_ITERM_RELAX, 0, lrintf(setpointHpf));
                 DEBUG_SET(DEBUG_ITERM_RELAX, 1, lrintf(itermRelaxFactor * 100.0f));
@@ -861,7 +1095,7 @@ void FAST_CODE pidController(const pidProfile_t *pidProfile, const rollAndPitchT
             } else {
                 acErrorRate = (gyroRate > gmaxac ? gmaxac : gminac ) - gyroRate;
             }
-#endif // USE_ABSOLUTE_CONTROL             
+#endif // USE_ABSOLUTE_CONTROL
         } else
 #endif // USE_ITERM_RELAX
         {
@@ -870,9 +1104,9 @@ void FAST_CODE pidController(const pidProfile_t *pidProfile, const rollAndPitchT
             acErrorRate = itermErrorRate;
 #endif // USE_ABSOLUTE_CONTROL
         }
-        
+
 #if defined(USE_ABSOLUTE_CONTROL)
-        if (acGain > 0 && isAirmodeActivated()) {
+        if (absoluteControlActive) {
             axisError[axis] = constrainf(axisError[axis] + acErrorRate * dT, -acErrorLimit, acErrorLimit);
             acCorrection = constrainf(axisError[axis] * acGain, -acLimit, acLimit);
             currentPidSetpoint += acCorrection;
@@ -885,7 +1119,7 @@ void FAST_CODE pidController(const pidProfile_t *pidProfile, const rollAndPitchT
 
         float errorRate = currentPidSetpoint - gyroRate; // r - y
         handleCrashRecovery(
-            pidProfile->crash_recovery, angleTrim, axis, currentTimeUs, gyroRate,
+            crashRecovery, angleTrim, axis, currentTimeUs, gyroRate,
             &currentPidSetpoint, &errorRate);
 
         // --------low-level gyro-based PID based on 2DOF PID controller. ----------
@@ -893,15 +1127,13 @@ void FAST_CODE pidController(const pidProfile_t *pidProfile, const rollAndPitchT
         // b = 1 and only c (dtermSetpointWeight) can be tuned (amount derivative on measurement or error).
 
         // -----calculate P component and add Dynamic Part based on stick input
-        pidData[axis].P = pidCoefficient[axis].Kp * errorRate * tpaFactor;
-        if (axis == FD_YAW) {
-            pidData[axis].P = ptermYawLowpassApplyFn((filter_t *) &ptermYawLowpass, pidData[axis].P);
-        }
+        // the yaw lowpass is applied after the loop
+        pidData[axis].P = coefficient->Kp * errorRate * tpaFactor;
 
         // -----calculate I component
 
         const float ITerm = pidData[axis].I;
-        const float ITermNew = constrainf(ITerm + pidCoefficient[axis].Ki * itermErrorRate * dynCi, -itermLimit, itermLimit);
+        const float ITermNew = constrainf(ITerm + coefficient->Ki * itermErrorRate * dynCi, -itermLimit, itermLimit);
         const bool outputSaturated = mixerIsOutputSaturated(axis, errorRate);
         if (outputSaturated == false || ABS(ITermNew) < ABS(ITerm)) {
             // Only increase ITerm if output is not saturated
@@ -919,19 +1151,19 @@ void FAST_CODE pidController(const pidProfile_t *pidProfile, const rollAndPitchT
             // calculated deltaT whenever another task causes the PID
             // loop execution to be delayed.
             const float delta =
-                - (gyroRateDterm[axis] - previousGyroRateDterm[axis]) * pidFrequency;
+                - (gyroRateDterm[axis] - state->previousGyroRateDterm) * pidFrequency;
 
-            detectAndSetCrashRecovery(pidProfile->crash_recovery, axis, currentTimeUs, delta, errorRate);
+            detectAndSetCrashRecovery(crashRecovery, axis, currentTimeUs, delta, errorRate);
 
-            pidData[axis].D = pidCoefficient[axis].Kd * delta * tpaFactor;
+            pidData[axis].D = coefficient->Kd * delta * tpaFactor;
 
-            float pidSetpointDelta = currentPidSetpoint - previousPidSetpoint[axis];
+            float pidSetpointDelta = currentPidSetpoint - state->previousPidSetpoint;
 
 #ifdef USE_RC_SMOOTHING_FILTER
             if (axis == rcSmoothingDebugAxis) {
                 DEBUG_SET(DEBUG_RC_SMOOTHING, 1, lrintf(pidSetpointDelta * 100.0f));
             }
-            if ((dynCd != 0) && setpointDerivativeLpfInitialized) {
+            if (setpointDerivativeFilterActive) {
                 switch (rcSmoothingFilterType) {
                     case RC_SMOOTHING_DERIVATIVE_PT1:
                         pidSetpointDelta = pt1FilterApply(&setpointDerivativePt1[axis], pidSetpointDelta);
@@ -947,7 +1179,7 @@ void FAST_CODE pidController(const pidProfile_t *pidProfile, const rollAndPitchT
 #endif // USE_RC_SMOOTHING_FILTER
 
             const float pidFeedForward =
-                pidCoefficient[axis].Kd * dynCd * transition * pidSetpointDelta * tpaFactor * pidFrequency;
+                coefficient->Kf * dynCf * transition * pidSetpointDelta * tpaFactor * pidFrequency;
 #if defined(USE_SMART_FEEDFORWARD)
             bool addFeedforward = true;
             if (smartFeedforward) {
@@ -964,31 +1196,29 @@ void FAST_CODE pidController(const pidProfile_t *pidProfile, const rollAndPitchT
             {
                 pidData[axis].D += pidFeedForward;
             }
-            previousGyroRateDterm[axis] = gyroRateDterm[axis];
-            previousPidSetpoint[axis] = currentPidSetpoint;
-
-#ifdef USE_YAW_SPIN_RECOVERY
-            if (yawSpinActive)  {
-                // zero PIDs on pitch and roll leaving yaw P to correct spin 
-                pidData[axis].P = 0;
-                pidData[axis].I = 0;
-                pidData[axis].D = 0;
-            }
-#endif // USE_YAW_SPIN_RECOVERY
+            state->previousGyroRateDterm = gyroRateDterm[axis];
+            state->previousPidSetpoint = currentPidSetpoint;
         }
     }
 
-    // calculating the PID sum
-    pidData[FD_ROLL].Sum = pidData[FD_ROLL].P + pidData[FD_ROLL].I + pidData[FD_ROLL].D;
-    pidData[FD_PITCH].Sum = pidData[FD_PITCH].P + pidData[FD_PITCH].I + pidData[FD_PITCH].D;
+    pidData[FD_YAW].P = ptermYawLowpassApplyFn((filter_t *) &ptermYawLowpass, pidData[FD_YAW].P);
 
 #ifdef USE_YAW_SPIN_RECOVERY
     if (yawSpinActive) {
-    // yaw P alone to correct spin 
+        // zero PIDs on pitch and roll leaving yaw P alone to correct spin
+        for (int axis = FD_ROLL; axis < FD_YAW; ++axis) {
+            pidData[axis].P = 0;
+            pidData[axis].I = 0;
+            pidData[axis].D = 0;
+        }
         pidData[FD_YAW].I = 0;
     }
 #endif // USE_YAW_SPIN_RECOVERY
 
+    // calculating the PID sum
+    pidData[FD_ROLL].Sum = pidData[FD_ROLL].P + pidData[FD_ROLL].I + pidData[FD_ROLL].D;
+    pidData[FD_PITCH].Sum = pidData[FD_PITCH].P + pidData[FD_PITCH].I + pidData[FD_PITCH].D;
+
     // YAW has no D
     pidData[FD_YAW].Sum = pidData[FD_YAW].P + pidData[FD_YAW].I;
 
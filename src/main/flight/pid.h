@@ -138,6 +138,7 @@ typedef struct pidProfile_s {
     uint8_t abs_control_gain;               // How strongly should the absolute accumulated error be corrected for
     uint8_t abs_control_limit;              // Limit to the correction
     uint8_t abs_control_error_limit;        // Limit to the accumulated error
+    uint8_t dterm_dyn_notch;                // off, on - notch the D term at the peaks the gyro analyser finds
 } pidProfile_t;
 
 #ifndef USE_OSD_SLAVE
@@ -149,6 +150,8 @@ typedef struct pidConfig_s {
     uint8_t runaway_takeoff_prevention;          // off, on - enables pidsum runaway disarm logic
     uint16_t runaway_takeoff_deactivate_delay;   // delay in ms for "in-flight" conditions before deactivation (successful flight)
     uint8_t runaway_takeoff_deactivate_throttle; // minimum throttle percent required during deactivation phase
+    uint8_t pid_loop_preemption;            // off, on - run the PID loop from the gyro data ready interrupt
+    uint8_t pid_process_denom_adaptive;     // off, on - raise pid_process_denom while the PID loop overruns
 } pidConfig_t;
 
 PG_DECLARE(pidConfig_t, pidConfig);
@@ -178,6 +181,9 @@ float pidItermAccelerator(void);
 void pidInitFilters(const pidProfile_t *pidProfile);
 void pidInitConfig(const pidProfile_t *pidProfile);
 void pidInit(const pidProfile_t *pidProfile);
+void pidPrepareProfile(const pidProfile_t *pidProfile);
+uint8_t pidGetProcessDenom(void);
+void pidSetProcessDenom(const pidProfile_t *pidProfile, uint8_t denom);
 void pidCopyProfile(uint8_t dstPidProfileIndex, uint8_t srcPidProfileIndex);
 bool crashRecoveryModeActive(void);
 void pidAcroTrainerInit(void);
@@ -37,26 +37,81 @@
 
 #include "sensors/sensors.h"
 #include "sensors/barometer.h"
+#include "sensors/rangefinder.h"
 
 static int32_t estimatedAltitude = 0;                // in cm
+static int16_t estimatedVario = 0;                   // in cm/s
 
 #define BARO_UPDATE_FREQUENCY_40HZ (1000 * 25)
 
+// complementary filter fusing the vertical acceleration from the IMU with the
+// baro/gps altitude, critically damped with a natural frequency of ALTITUDE_FILTER_OMEGA
+#define ALTITUDE_FILTER_OMEGA 2.0f                   // rad/s
+#define ALTITUDE_FILTER_GAIN_ALT (2.0f * ALTITUDE_FILTER_OMEGA)
+#define ALTITUDE_FILTER_GAIN_VEL (ALTITUDE_FILTER_OMEGA * ALTITUDE_FILTER_OMEGA)
+#define ALTITUDE_FILTER_MAX_DT 0.1f                  // s, longer gaps restart the filter from the measurement
+#define RANGEFINDER_ALT_BLEND_TIME 1.0f              // s, time constant of the move onto a new rangefinder offset
 
 #if defined(USE_BARO) || defined(USE_GPS)
 static bool altitudeOffsetSet = false;
 
+static float filterAltitude = 0;                     // in cm
+static float filterVario = 0;                        // in cm/s
+static bool filterValid = false;
+
+// Integrate the acceleration summed by the IMU since the last call, returns false if there was none
+static bool altitudePredict(float dt)
+{
+    if (!sensors(SENSOR_ACC) || accSumCount == 0) {
+        return false;
+    }
+
+    const float velocityDelta = (float)accSum[Z] / accSumCount * accTimeSum * accVelScale;
+    imuResetAccelerationSum();
+
+    filterAltitude += (filterVario + 0.5f * velocityDelta) * dt;
+    filterVario += velocityDelta;
+
+    return true;
+}
+
+static void altitudeCorrect(float measuredAltitude, float dt)
+{
+    const float error = measuredAltitude - filterAltitude;
+
+    filterAltitude += ALTITUDE_FILTER_GAIN_ALT * error * dt;
+    filterVario += ALTITUDE_FILTER_GAIN_VEL * error * dt;
+}
+
 void calculateEstimatedAltitude(timeUs_t currentTimeUs)
 {
     static timeUs_t previousTimeUs = 0;
+    static timeUs_t previousMeasurementTimeUs = 0;
     static int32_t baroAltOffset = 0;
     static int32_t gpsAltOffset = 0;
+    static int32_t previousMeasuredAltitude = 0;
+#ifdef USE_RANGEFINDER
+    static float rangefinderAltOffset = 0;
+#endif
+
+    const float dt = (currentTimeUs - previousTimeUs) * 1e-6f;
+    previousTimeUs = currentTimeUs;
+
+    if (dt > ALTITUDE_FILTER_MAX_DT) {
+        filterValid = false;
+    }
+    const bool havePrediction = altitudePredict(dt);
 
-    const uint32_t dTime = currentTimeUs - previousTimeUs;
+    // the baro filtering and calibration are tuned for this rate, so keep the measurements at it
+    const uint32_t dTime = currentTimeUs - previousMeasurementTimeUs;
     if (dTime < BARO_UPDATE_FREQUENCY_40HZ) {
+        if (havePrediction && filterValid) {
+            estimatedAltitude = lrintf(filterAltitude);
+            estimatedVario = constrain(lrintf(filterVario), -32768, 32767);
+        }
         return;
     }
-    previousTimeUs = currentTimeUs;
+    previousMeasurementTimeUs = currentTimeUs;
 
     int32_t baroAlt = 0;
 
@@ -92,23 +147,68 @@ if (sensors(SENSOR_GPS) && STATE(GPS_FIX)) {
         baroAltOffset = baroAlt;
         gpsAltOffset = gpsAlt;
         altitudeOffsetSet = true;
+        filterValid = false;
+#ifdef USE_RANGEFINDER
+        rangefinderAltOffset = 0;
+#endif
     } else if (!ARMING_FLAG(ARMED) && altitudeOffsetSet) {
         altitudeOffsetSet = false;
+        filterValid = false;
     }
     baroAlt -= baroAltOffset;
     gpsAlt -= gpsAltOffset;
-    
+
+    int32_t measuredAltitude;
     if (haveGpsAlt && haveBaroAlt) {
-        estimatedAltitude = gpsAlt * gpsTrust + baroAlt * (1 - gpsTrust);
+        measuredAltitude = gpsAlt * gpsTrust + baroAlt * (1 - gpsTrust);
     } else if (haveGpsAlt) {
-        estimatedAltitude = gpsAlt;
+        measuredAltitude = gpsAlt;
     } else if (haveBaroAlt) {
-        estimatedAltitude = baroAlt;
+        measuredAltitude = baroAlt;
+    } else {
+        filterValid = false;
+        return;
+    }
+
+#ifdef USE_RANGEFINDER
+    // Close to the ground the rangefinder is the better reference, the other sources follow it
+    // through an offset. The offset is kept when it goes out of range and slews onto the new one
+    // when the rangefinder comes back, so the altitude doesn't step either way.
+    if (altitudeOffsetSet && sensors(SENSOR_RANGEFINDER) && isSurfaceAltitudeValid()) {
+        const float targetOffset = rangefinderGetLatestAltitude() - measuredAltitude;
+        const float measurementDt = dTime * 1e-6f;
+        rangefinderAltOffset += (targetOffset - rangefinderAltOffset) * measurementDt / (RANGEFINDER_ALT_BLEND_TIME + measurementDt);
     }
-    
+    measuredAltitude += lrintf(rangefinderAltOffset);
+#endif
+
+    if (!havePrediction) {
+        // no accelerometer, fall back to the measurement and its rate of change
+        if (filterValid) {
+            estimatedVario = constrain((measuredAltitude - previousMeasuredAltitude) * 1000000 / (int32_t)dTime, -32768, 32767);
+        } else {
+            estimatedVario = 0;
+        }
+        estimatedAltitude = measuredAltitude;
+        filterValid = true;
+    } else if (!filterValid) {
+        filterAltitude = measuredAltitude;
+        filterVario = 0;
+        filterValid = true;
+    } else {
+        altitudeCorrect(measuredAltitude, dTime * 1e-6f);
+    }
+    previousMeasuredAltitude = measuredAltitude;
+
+    if (havePrediction) {
+        estimatedAltitude = lrintf(filterAltitude);
+        estimatedVario = constrain(lrintf(filterVario), -32768, 32767);
+    }
+
     DEBUG_SET(DEBUG_ALTITUDE, 0, (int32_t)(100 * gpsTrust));
     DEBUG_SET(DEBUG_ALTITUDE, 1, baroAlt);
     DEBUG_SET(DEBUG_ALTITUDE, 2, gpsAlt);
+    DEBUG_SET(DEBUG_ALTITUDE, 3, estimatedVario);
 }
 
 bool isAltitudeOffset(void)
@@ -122,8 +222,8 @@ int32_t getEstimatedAltitude(void)
     return estimatedAltitude;
 }
 
-// This should be removed or fixed, but it would require changing a lot of other things to get rid of.
+// vertical speed in cm/s
 int16_t getEstimatedVario(void)
 {
-    return 0;
+    return estimatedVario;
 }
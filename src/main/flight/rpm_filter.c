@@ -0,0 +1,216 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "platform.h"
+
+#ifdef USE_RPM_FILTER
+
+#include "build/debug.h"
+
+#include "common/filter.h"
+#include "common/maths.h"
+
+#include "config/feature.h"
+
+#include "drivers/pwm_output.h"
+
+#include "flight/mixer.h"
+#include "flight/pid.h"
+#include "flight/rpm_filter.h"
+
+#include "pg/pg.h"
+#include "pg/pg_ids.h"
+
+#include "sensors/esc_sensor.h"
+#include "sensors/gyro.h"
+
+#define RPM_FILTER_REFRESH_US       1000    // all notches are retuned within this interval
+#define RPM_FILTER_MAX_DATA_AGE     10      // motor updates without a valid reply before the last frequency is held
+
+PG_REGISTER_WITH_RESET_TEMPLATE(rpmFilterConfig_t, rpmFilterConfig, PG_RPM_FILTER_CONFIG, 0);
+
+PG_RESET_TEMPLATE(rpmFilterConfig_t, rpmFilterConfig,
+    .gyro_rpm_notch_harmonics = 3,
+    .gyro_rpm_notch_min = 100,
+    .gyro_rpm_notch_q = 500,
+    .rpm_lpf = 150,
+);
+
+typedef struct rpmNotchCoeffs_s {
+    float b0, b1, b2, a1, a2;
+} rpmNotchCoeffs_t;
+
+static FAST_RAM_ZERO_INIT rpmNotchCoeffs_t notchCoeffs[MAX_SUPPORTED_MOTORS][RPM_FILTER_HARMONICS_MAX];
+static FAST_RAM_ZERO_INIT uint8_t notchMotorCount;     // 0 while the filter is disabled
+static FAST_RAM_ZERO_INIT uint8_t notchHarmonics;
+
+static FAST_RAM_ZERO_INIT pt1Filter_t motorFrequencyFilter[MAX_SUPPORTED_MOTORS];
+static FAST_RAM_ZERO_INIT float motorFrequencyHz[MAX_SUPPORTED_MOTORS];
+static FAST_RAM_ZERO_INIT float erpmToHz;
+static FAST_RAM_ZERO_INIT float notchMinHz;
+static FAST_RAM_ZERO_INIT float notchMaxHz;
+static FAST_RAM_ZERO_INIT float notchQ;
+static FAST_RAM_ZERO_INIT uint32_t notchLooptimeUs;
+
+// next notch to retune
+static FAST_RAM_ZERO_INIT uint8_t updateMotor;
+static FAST_RAM_ZERO_INIT uint8_t updateHarmonic;
+
+static bool rpmFilterHasRpmSource(void)
+{
+#ifdef USE_DSHOT_TELEMETRY
+    if (isDshotTelemetryActive()) {
+        return true;
+    }
+#endif
+#ifdef USE_ESC_SENSOR
+    if (feature(FEATURE_ESC_SENSOR)) {
+        return true;
+    }
+#endif
+    return false;
+}
+
+// eRPM in units of 100, false if there is no recent reading
+static bool rpmFilterGetMotorErpm(int motor, uint16_t *erpm)
+{
+#ifdef USE_DSHOT_TELEMETRY
+    if (isDshotTelemetryActive()) {
+        const dshotTelemetryData_t *telemetry = getDshotTelemetryData(motor);
+        *erpm = telemetry->erpm;
+        return telemetry->dataAge <= RPM_FILTER_MAX_DATA_AGE;
+    }
+#endif
+#ifdef USE_ESC_SENSOR
+    const escSensorData_t *escData = getEscSensorData(motor);
+    if (escData && escData->dataAge < ESC_DATA_INVALID) {
+        *erpm = escData->rpm;
+        return true;
+    }
+#endif
+    UNUSED(motor);
+    UNUSED(erpm);
+    return false;
+}
+
+static void rpmFilterUpdateNotch(int motor, int harmonic)
+{
+    const float frequency = constrainf(motorFrequencyHz[motor] * (harmonic + 1), notchMinHz, notchMaxHz);
+
+    biquadFilter_t notch;
+    biquadFilterUpdateNotch(&notch, frequency, notchLooptimeUs, notchQ);
+
+    rpmNotchCoeffs_t *coeffs = &notchCoeffs[motor][harmonic];
+    coeffs->b0 = notch.b0;
+    coeffs->b1 = notch.b1;
+    coeffs->b2 = notch.b2;
+    coeffs->a1 = notch.a1;
+    coeffs->a2 = notch.a2;
+}
+
+// Must be called after gyroInit() and pidInit(), the notches run at the gyro filter rate and are retuned by the PID loop
+void rpmFilterInit(void)
+{
+    const rpmFilterConfig_t *config = rpmFilterConfig();
+
+    notchMotorCount = 0;
+    notchHarmonics = MIN(config->gyro_rpm_notch_harmonics, RPM_FILTER_HARMONICS_MAX);
+    if (!notchHarmonics || !rpmFilterHasRpmSource()) {
+        return;
+    }
+
+    notchLooptimeUs = gyroFilterLooptime();
+    notchMinHz = config->gyro_rpm_notch_min;
+    notchMaxHz = 0.48f * 1e6f / notchLooptimeUs;
+    notchQ = config->gyro_rpm_notch_q / 100.0f;
+    erpmToHz = 100.0f / 60.0f / (motorConfig()->motorPoleCount / 2);
+
+    const uint8_t motorCount = MIN(getMotorCount(), MAX_SUPPORTED_MOTORS);
+    for (int motor = 0; motor < motorCount; motor++) {
+        pt1FilterInit(&motorFrequencyFilter[motor], pt1FilterGain(config->rpm_lpf, targetPidLooptime * 1e-6f));
+        motorFrequencyHz[motor] = notchMinHz;
+        for (int harmonic = 0; harmonic < notchHarmonics; harmonic++) {
+            rpmFilterUpdateNotch(motor, harmonic);
+        }
+    }
+    updateMotor = 0;
+    updateHarmonic = 0;
+    notchMotorCount = motorCount;
+}
+
+bool isRpmFilterEnabled(void)
+{
+    return notchMotorCount > 0;
+}
+
+/*
+ * Smooth the motor frequencies, then retune as many notches as needed
+ * to refresh all of them every RPM_FILTER_REFRESH_US
+ */
+FAST_CODE void rpmFilterUpdate(void)
+{
+    if (!notchMotorCount) {
+        return;
+    }
+
+    for (int motor = 0; motor < notchMotorCount; motor++) {
+        uint16_t erpm;
+        if (rpmFilterGetMotorErpm(motor, &erpm)) {
+            motorFrequencyHz[motor] = pt1FilterApply(&motorFrequencyFilter[motor], erpm * erpmToHz);
+        }
+        if (motor < 4) {
+            DEBUG_SET(DEBUG_RPM_FILTER, motor, lrintf(motorFrequencyHz[motor]));
+        }
+    }
+
+    const int notchCount = notchMotorCount * notchHarmonics;
+    const int updateCount = MIN(notchCount, (notchCount * targetPidLooptime + RPM_FILTER_REFRESH_US - 1) / RPM_FILTER_REFRESH_US);
+    for (int i = 0; i < updateCount; i++) {
+        rpmFilterUpdateNotch(updateMotor, updateHarmonic);
+        if (++updateHarmonic >= notchHarmonics) {
+            updateHarmonic = 0;
+            updateMotor = (updateMotor + 1) % notchMotorCount;
+        }
+    }
+}
+
+FAST_CODE float rpmFilterApply(rpmFilterBank_t *bank, int axis, float value)
+{
+    for (int motor = 0; motor < notchMotorCount; motor++) {
+        for (int harmonic = 0; harmonic < notchHarmonics; harmonic++) {
+            // direct form 1, as the coefficients change while the filter runs
+            const rpmNotchCoeffs_t *coeffs = &notchCoeffs[motor][harmonic];
+            rpmNotchState_t *state = &bank->notch[motor][harmonic][axis];
+            const float result = coeffs->b0 * value + coeffs->b1 * state->x1 + coeffs->b2 * state->x2 - coeffs->a1 * state->y1 - coeffs->a2 * state->y2;
+            state->x2 = state->x1;
+            state->x1 = value;
+            state->y2 = state->y1;
+            state->y1 = result;
+            value = result;
+        }
+    }
+    return value;
+}
+
+#endif // USE_RPM_FILTER
@@ -0,0 +1,50 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/axis.h"
+#include "drivers/pwm_output_counts.h"
+#include "pg/pg.h"
+
+#define RPM_FILTER_HARMONICS_MAX 3
+
+typedef struct rpmFilterConfig_s {
+    uint8_t  gyro_rpm_notch_harmonics;  // notches per motor and axis, on the motor frequency and its multiples, 0 disables the filter
+    uint8_t  gyro_rpm_notch_min;        // lowest notch frequency in Hz
+    uint16_t gyro_rpm_notch_q;          // notch quality factor * 100
+    uint16_t rpm_lpf;                   // cutoff in Hz of the lowpass smoothing the motor frequencies
+} rpmFilterConfig_t;
+
+PG_DECLARE(rpmFilterConfig_t, rpmFilterConfig);
+
+typedef struct rpmNotchState_s {
+    float x1, x2, y1, y2;
+} rpmNotchState_t;
+
+// delay lines of the notches of one gyro, the coefficients are shared by all gyros
+typedef struct rpmFilterBank_s {
+    rpmNotchState_t notch[MAX_SUPPORTED_MOTORS][RPM_FILTER_HARMONICS_MAX][XYZ_AXIS_COUNT];
+} rpmFilterBank_t;
+
+void rpmFilterInit(void);
+bool isRpmFilterEnabled(void);
+void rpmFilterUpdate(void);
+float rpmFilterApply(rpmFilterBank_t *bank, int axis, float value);
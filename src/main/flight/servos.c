@@ -57,12 +57,13 @@
 
 extern mixerMode_e currentMixerMode;
 
-PG_REGISTER_WITH_RESET_FN(servoConfig_t, servoConfig, PG_SERVO_CONFIG, 0);
+PG_REGISTER_WITH_RESET_FN(servoConfig_t, servoConfig, PG_SERVO_CONFIG, 1);
 
 void pgResetFn_servoConfig(servoConfig_t *servoConfig)
 {
     servoConfig->dev.servoCenterPulse = 1500;
     servoConfig->dev.servoPwmRate = 50;
+    servoConfig->dev.servoSync = 0;
     servoConfig->tri_unarmed_servo = 1;
     servoConfig->servo_lowpass_freq = 0;
     servoConfig->channelForwardingStartChannel = AUX1;
@@ -98,6 +99,18 @@ static uint8_t servoRuleCount = 0;
 static servoMixer_t currentServoMixer[MAX_SERVO_RULES];
 static int useServo;
 
+// per rule constants that only depend on the configuration, see servoMixerUpdateRuleLimits()
+typedef struct servoMixerRuleLimits_s {
+    int16_t min;
+    int16_t max;
+    int8_t direction;
+} servoMixerRuleLimits_t;
+
+static servoMixerRuleLimits_t servoMixerRuleLimits[MAX_SERVO_RULES];
+
+static timeUs_t servoSyncPeriodUs;
+static timeUs_t servoSyncElapsedUs;
+
 
 #define COUNT_SERVO_RULES(rules) (sizeof(rules) / sizeof(servoMixer_t))
 // mixer rule format servo, input, rate, speed, min, max, box
@@ -233,11 +246,35 @@ void servosInit(void)
         servo[i] = DEFAULT_SERVO_MIDDLE;
     }
 
+    if (servoConfig()->dev.servoSync) {
+        servoSyncPeriodUs = 1000000 / servoGetPwmRate();
+    }
+
     if (mixerIsTricopter()) {
         servosTricopterInit();
     }
 }
 
+// Above the standard rate the period gets shorter than the pulse of a standard servo. Such rates
+// are only used as far as the longest pulse the servos are configured for still fits the period,
+// which leaves them to servos with a narrow pulse range.
+uint16_t servoGetPwmRate(void)
+{
+    const uint16_t servoPwmRate = servoConfig()->dev.servoPwmRate;
+    if (servoPwmRate <= SERVO_PWM_RATE_STANDARD_MAX) {
+        return servoPwmRate;
+    }
+
+    // forwarded channels are not constrained to the servo range
+    uint16_t maxPulse = feature(FEATURE_CHANNEL_FORWARDING) ? PWM_PULSE_MAX : 0;
+    for (int i = 0; i < MAX_SUPPORTED_SERVOS; i++) {
+        maxPulse = MAX(maxPulse, servoParams(i)->max);
+    }
+    const uint16_t maxRate = 1000000 / (maxPulse + SERVO_PWM_MIN_GAP_US);
+
+    return constrain(maxRate, SERVO_PWM_RATE_STANDARD_MAX, servoPwmRate);
+}
+
 void loadCustomServoMixer(void)
 {
     // reset settings
@@ -387,6 +424,27 @@ void writeServos(void)
         forwardAuxChannelsToServos(servoIndex);
         servoIndex += MAX_AUX_CHANNEL_COUNT;
     }
+
+    // the pulses of synced servos start once all of them are written, at most at the servo rate
+    if (servoSyncPeriodUs) {
+        servoSyncElapsedUs += targetPidLooptime;
+        if (servoSyncElapsedUs >= servoSyncPeriodUs) {
+            servoSyncElapsedUs = 0;
+            pwmCompleteServoUpdate();
+        }
+    }
+}
+
+// Works out the output range and direction of each rule once, instead of on every run of the mixer
+static void servoMixerUpdateRuleLimits(void)
+{
+    for (int i = 0; i < servoRuleCount; i++) {
+        const uint8_t target = currentServoMixer[i].targetChannel;
+        const uint16_t servo_width = servoParams(target)->max - servoParams(target)->min;
+        servoMixerRuleLimits[i].min = currentServoMixer[i].min * servo_width / 100 - servo_width / 2;
+        servoMixerRuleLimits[i].max = currentServoMixer[i].max * servo_width / 100 - servo_width / 2;
+        servoMixerRuleLimits[i].direction = servoDirection(target, currentServoMixer[i].inputSource);
+    }
 }
 
 void servoMixer(void)
@@ -411,8 +469,8 @@ void servoMixer(void)
         }
     }
 
-    input[INPUT_GIMBAL_PITCH] = scaleRange(attitude.values.pitch, -1800, 1800, -500, +500);
-    input[INPUT_GIMBAL_ROLL] = scaleRange(attitude.values.roll, -1800, 1800, -500, +500);
+    input[INPUT_GIMBAL_PITCH] = scaleRange(getAttitude()->values.pitch, -1800, 1800, -500, +500);
+    input[INPUT_GIMBAL_ROLL] = scaleRange(getAttitude()->values.roll, -1800, 1800, -500, +500);
 
     input[INPUT_STABILIZED_THROTTLE] = motor[0] - 1000 - 500;  // Since it derives from rcCommand or mincommand and must be [-500:+500]
 
@@ -435,26 +493,29 @@ void servoMixer(void)
         servo[i] = 0;
     }
 
+    // the servo parameters are only edited while disarmed, so the rule limits stay put in flight
+    if (!ARMING_FLAG(ARMED)) {
+        servoMixerUpdateRuleLimits();
+    }
+
     // mix servos according to rules
     for (int i = 0; i < servoRuleCount; i++) {
+        const servoMixer_t *rule = &currentServoMixer[i];
         // consider rule if no box assigned or box is active
-        if (currentServoMixer[i].box == 0 || IS_RC_MODE_ACTIVE(BOXSERVO1 + currentServoMixer[i].box - 1)) {
-            uint8_t target = currentServoMixer[i].targetChannel;
-            uint8_t from = currentServoMixer[i].inputSource;
-            uint16_t servo_width = servoParams(target)->max - servoParams(target)->min;
-            int16_t min = currentServoMixer[i].min * servo_width / 100 - servo_width / 2;
-            int16_t max = currentServoMixer[i].max * servo_width / 100 - servo_width / 2;
-
-            if (currentServoMixer[i].speed == 0)
-                currentOutput[i] = input[from];
+        if (rule->box == 0 || IS_RC_MODE_ACTIVE(BOXSERVO1 + rule->box - 1)) {
+            const servoMixerRuleLimits_t *limits = &servoMixerRuleLimits[i];
+            const int16_t in = input[rule->inputSource];
+
+            if (rule->speed == 0)
+                currentOutput[i] = in;
             else {
-                if (currentOutput[i] < input[from])
-                    currentOutput[i] = constrain(currentOutput[i] + currentServoMixer[i].speed, currentOutput[i], input[from]);
-                else if (currentOutput[i] > input[from])
-                    currentOutput[i] = constrain(currentOutput[i] - currentServoMixer[i].speed, input[from], currentOutput[i]);
+                if (currentOutput[i] < in)
+                    currentOutput[i] = constrain(currentOutput[i] + rule->speed, currentOutput[i], in);
+                else if (currentOutput[i] > in)
+                    currentOutput[i] = constrain(currentOutput[i] - rule->speed, in, currentOutput[i]);
             }
 
-            servo[target] += servoDirection(target, from) * constrain(((int32_t)currentOutput[i] * currentServoMixer[i].rate) / 100, min, max);
+            servo[rule->targetChannel] += limits->direction * constrain(((int32_t)currentOutput[i] * rule->rate) / 100, limits->min, limits->max);
         } else {
             currentOutput[i] = 0;
         }
@@ -488,8 +549,8 @@ static void servoTable(void)
 
     /*
     case MIXER_GIMBAL:
-        servo[SERVO_GIMBAL_PITCH] = (((int32_t)servoParams(SERVO_GIMBAL_PITCH)->rate * attitude.values.pitch) / 50) + determineServoMiddleOrForwardFromChannel(SERVO_GIMBAL_PITCH);
-        servo[SERVO_GIMBAL_ROLL] = (((int32_t)servoParams(SERVO_GIMBAL_ROLL)->rate * attitude.values.roll) / 50) + determineServoMiddleOrForwardFromChannel(SERVO_GIMBAL_ROLL);
+        servo[SERVO_GIMBAL_PITCH] = (((int32_t)servoParams(SERVO_GIMBAL_PITCH)->rate * getAttitude()->values.pitch) / 50) + determineServoMiddleOrForwardFromChannel(SERVO_GIMBAL_PITCH);
+        servo[SERVO_GIMBAL_ROLL] = (((int32_t)servoParams(SERVO_GIMBAL_ROLL)->rate * getAttitude()->values.roll) / 50) + determineServoMiddleOrForwardFromChannel(SERVO_GIMBAL_ROLL);
         break;
     */
 
@@ -505,11 +566,11 @@ static void servoTable(void)
 
         if (IS_RC_MODE_ACTIVE(BOXCAMSTAB)) {
             if (gimbalConfig()->mode == GIMBAL_MODE_MIXTILT) {
-                servo[SERVO_GIMBAL_PITCH] -= (-(int32_t)servoParams(SERVO_GIMBAL_PITCH)->rate) * attitude.values.pitch / 50 - (int32_t)servoParams(SERVO_GIMBAL_ROLL)->rate * attitude.values.roll / 50;
-                servo[SERVO_GIMBAL_ROLL] += (-(int32_t)servoParams(SERVO_GIMBAL_PITCH)->rate) * attitude.values.pitch / 50 + (int32_t)servoParams(SERVO_GIMBAL_ROLL)->rate * attitude.values.roll / 50;
+                servo[SERVO_GIMBAL_PITCH] -= (-(int32_t)servoParams(SERVO_GIMBAL_PITCH)->rate) * getAttitude()->values.pitch / 50 - (int32_t)servoParams(SERVO_GIMBAL_ROLL)->rate * getAttitude()->values.roll / 50;
+                servo[SERVO_GIMBAL_ROLL] += (-(int32_t)servoParams(SERVO_GIMBAL_PITCH)->rate) * getAttitude()->values.pitch / 50 + (int32_t)servoParams(SERVO_GIMBAL_ROLL)->rate * getAttitude()->values.roll / 50;
             } else {
-                servo[SERVO_GIMBAL_PITCH] += (int32_t)servoParams(SERVO_GIMBAL_PITCH)->rate * attitude.values.pitch / 50;
-                servo[SERVO_GIMBAL_ROLL] += (int32_t)servoParams(SERVO_GIMBAL_ROLL)->rate * attitude.values.roll  / 50;
+                servo[SERVO_GIMBAL_PITCH] += (int32_t)servoParams(SERVO_GIMBAL_PITCH)->rate * getAttitude()->values.pitch / 50;
+                servo[SERVO_GIMBAL_ROLL] += (int32_t)servoParams(SERVO_GIMBAL_ROLL)->rate * getAttitude()->values.roll  / 50;
             }
         }
     }
@@ -101,6 +101,9 @@ PG_DECLARE_ARRAY(servoMixer_t, MAX_SERVO_RULES, customServoMixers);
 #define MAX_SERVO_SPEED UINT8_MAX
 #define MAX_SERVO_BOXES 3
 
+#define SERVO_PWM_RATE_STANDARD_MAX 498   // highest rate whose period still fits a 2ms pulse
+#define SERVO_PWM_MIN_GAP_US        20    // shortest low time between two pulses above that rate
+
 // Custom mixer configuration
 typedef struct mixerRules_s {
     uint8_t servoRuleCount;
@@ -142,6 +145,7 @@ void loadCustomServoMixer(void);
 int servoDirection(int servoIndex, int fromChannel);
 void servoConfigureOutput(void);
 void servosInit(void);
+uint16_t servoGetPwmRate(void);
 void servosFilterInit(void);
 void servoMixer(void);
 // tricopter specific
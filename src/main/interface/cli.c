@@ -41,7 +41,9 @@ extern uint8_t __config_end;
 #include "blackbox/blackbox.h"
 
 #include "build/build_config.h"
+#include "build/crash_trace.h"
 #include "build/debug.h"
+#include "build/motor_timing.h"
 #include "build/version.h"
 
 #include "cms/cms.h"
@@ -65,6 +67,7 @@ extern uint8_t __config_end;
 #include "drivers/compass/compass.h"
 #include "drivers/display.h"
 #include "drivers/dma.h"
+#include "drivers/dma_reqmap.h"
 #include "drivers/flash.h"
 #include "drivers/io.h"
 #include "drivers/io_impl.h"
@@ -92,6 +95,7 @@ extern uint8_t __config_end;
 #include "fc/fc_rc.h"
 #include "fc/rc_adjustments.h"
 #include "fc/rc_controls.h"
+#include "fc/rc_modes.h"
 #include "fc/runtime_config.h"
 
 #include "flight/failsafe.h"
@@ -172,6 +176,20 @@ static uint8_t cliWriteBuffer[sizeof(*cliWriter) + CLI_OUT_BUFFER_SIZE];
 static char cliBuffer[CLI_IN_BUFFER_SIZE];
 static uint32_t bufferIndex = 0;
 
+#ifdef USE_CLI_BATCH
+// Between 'batch start' and 'batch end' only errors are printed and the save is left to the end
+static bool cliBatchMode = false;
+static bool cliQuiet = false;
+static bool cliBatchSavePending = false;
+static uint16_t cliBatchLine;
+static uint16_t cliBatchErrorCount;
+#define CLI_IN_BATCH() (cliBatchMode)
+#define CLI_QUIET() (cliQuiet)
+#else
+#define CLI_IN_BATCH() (false)
+#define CLI_QUIET() (false)
+#endif
+
 static bool configIsInCopy = false;
 
 #define CURRENT_PROFILE_INDEX -1
@@ -269,6 +287,9 @@ static void backupAndResetConfigs(void)
 
 static void cliPrint(const char *str)
 {
+    if (CLI_QUIET()) {
+        return;
+    }
     while (*str) {
         bufWriterAppend(cliWriter, *str++);
     }
@@ -298,7 +319,9 @@ static void cliPrintHashLine(const char *str)
 
 static void cliPutp(void *p, char ch)
 {
-    bufWriterAppend(p, ch);
+    if (!CLI_QUIET()) {
+        bufWriterAppend(p, ch);
+    }
 }
 
 typedef enum {
@@ -333,7 +356,9 @@ static bool cliDumpPrintLinef(uint8_t dumpMask, bool equalsDefault, const char *
 
 static void cliWrite(uint8_t ch)
 {
-    bufWriterAppend(cliWriter, ch);
+    if (!CLI_QUIET()) {
+        bufWriterAppend(cliWriter, ch);
+    }
 }
 
 static bool cliDefaultPrintLinef(uint8_t dumpMask, bool equalsDefault, const char *format, ...)
@@ -372,12 +397,26 @@ static void cliPrintLinef(const char *format, ...)
 
 static void cliPrintErrorLinef(const char *format, ...)
 {
+#ifdef USE_CLI_BATCH
+    const bool quiet = cliQuiet;
+    cliQuiet = false;
+#endif
     cliPrint("###ERROR### ");
+#ifdef USE_CLI_BATCH
+    if (cliBatchMode) {
+        // the commands aren't echoed, so say which one failed
+        cliPrintf("line %d: ", cliBatchLine);
+        cliBatchErrorCount++;
+    }
+#endif
     va_list va;
     va_start(va, format);
     cliPrintfva(format, va);
     va_end(va);
     cliPrintLinefeed();
+#ifdef USE_CLI_BATCH
+    cliQuiet = quiet;
+#endif
 }
 
 
@@ -930,6 +969,7 @@ static void cliAux(char *cmdline)
             } else if (validArgumentCount != 5) {
                 memset(mac, 0, sizeof(modeActivationCondition_t));
             }
+            analyzeModeActivationConditions();
             cliPrintLinef( "aux %u %u %u %u %u %u",
                 i,
                 mac->modeId,
@@ -1547,6 +1587,9 @@ static void cliLed(char *cmdline)
         if (i < LED_MAX_STRIP_LENGTH) {
             ptr = nextArg(cmdline);
             if (parseLedStripConfig(i, ptr)) {
+                if (!CLI_IN_BATCH()) {
+                    reevaluateLedConfig();
+                }
                 generateLedConfig((ledConfig_t *)&ledStripConfig()->ledConfigs[i], ledConfigBuffer, sizeof(ledConfigBuffer));
                 cliDumpPrintLinef(0, false, format, i, ledConfigBuffer);
             } else {
@@ -3039,6 +3082,14 @@ static void cliEscPassthrough(char *cmdline)
         pch = strtok_r(NULL, " ", &saveptr);
     }
 
+    int uart;
+    const uint32_t baudRate = escSerialGetLink(escIndex, mode, &uart);
+    if (uart >= 0) {
+        cliPrintLinef("Using UART%d at %d baud.", uart + 1, baudRate);
+    } else {
+        cliPrintLinef("Using escserial at %d baud.", baudRate);
+    }
+
     escEnablePassthrough(cliPort, escIndex, mode);
 }
 #endif
@@ -3235,6 +3286,13 @@ static void cliSave(char *cmdline)
 {
     UNUSED(cmdline);
 
+#ifdef USE_CLI_BATCH
+    if (cliBatchMode) {
+        cliBatchSavePending = true;
+        return;
+    }
+#endif
+
     cliPrintHashLine("saving");
 
 #if defined(USE_BOARD_INFO)
@@ -3253,6 +3311,42 @@ static void cliSave(char *cmdline)
     cliReboot();
 }
 
+#ifdef USE_CLI_BATCH
+static void cliBatch(char *cmdline)
+{
+    if (strncasecmp(cmdline, "start", 5) == 0) {
+        cliBatchMode = true;
+        cliBatchSavePending = false;
+        cliBatchLine = 0;
+        cliBatchErrorCount = 0;
+        cliQuiet = true;
+    } else if (strncasecmp(cmdline, "end", 3) == 0) {
+        if (!cliBatchMode) {
+            cliPrintErrorLinef("No batch started");
+            return;
+        }
+        cliBatchMode = false;
+        cliQuiet = false;
+
+        // Catch up with what the commands in the batch left undone
+#ifdef USE_LED_STRIP
+        reevaluateLedConfig();
+#endif
+        cliPrintLinef("Batch ended, %d errors", cliBatchErrorCount);
+
+        if (cliBatchSavePending) {
+            if (cliBatchErrorCount) {
+                cliPrintErrorLinef("Not saving, fix the errors and run the batch again");
+            } else {
+                cliSave("");
+            }
+        }
+    } else {
+        cliShowParseError();
+    }
+}
+#endif
+
 static void cliDefaults(char *cmdline)
 {
     bool saveConfigs;
@@ -3339,6 +3433,64 @@ STATIC_UNIT_TESTED void cliGet(char *cmdline)
     cliPrintErrorLinef("Invalid name");
 }
 
+#ifdef USE_CLI_SETTINGS_INDEX
+static bool valueTableNameIndexBuilt;
+
+static void cliBuildValueTableNameIndex(void)
+{
+    // Insertion sort, valueTable is mostly grouped by prefix so this is close to linear
+    for (unsigned i = 0; i < valueTableEntryCount; i++) {
+        unsigned j = i;
+        while (j > 0 && strcasecmp(valueTable[valueTableNameIndex[j - 1]].name, valueTable[i].name) > 0) {
+            valueTableNameIndex[j] = valueTableNameIndex[j - 1];
+            j--;
+        }
+        valueTableNameIndex[j] = i;
+    }
+    valueTableNameIndexBuilt = true;
+}
+#endif
+
+// Returns the setting named by the first nameLength characters of name, or NULL
+static const clivalue_t *cliFindValue(const char *name, uint8_t nameLength)
+{
+#ifdef USE_CLI_SETTINGS_INDEX
+    if (!valueTableNameIndexBuilt) {
+        cliBuildValueTableNameIndex();
+    }
+
+    int low = 0;
+    int high = valueTableEntryCount - 1;
+    while (low <= high) {
+        const int mid = (low + high) / 2;
+        const clivalue_t *val = &valueTable[valueTableNameIndex[mid]];
+        int result = strncasecmp(name, val->name, nameLength);
+        if (result == 0 && val->name[nameLength]) {
+            // name is a prefix of this setting, so it sorts before it
+            result = -1;
+        }
+
+        if (result == 0) {
+            return val;
+        } else if (result < 0) {
+            high = mid - 1;
+        } else {
+            low = mid + 1;
+        }
+    }
+#else
+    for (uint32_t i = 0; i < valueTableEntryCount; i++) {
+        const clivalue_t *val = &valueTable[i];
+
+        // ensure exact match when setting to prevent setting variables with shorter names
+        if (strncasecmp(name, val->name, strlen(val->name)) == 0 && nameLength == strlen(val->name)) {
+            return val;
+        }
+    }
+#endif
+    return NULL;
+}
+
 static uint8_t getWordLength(char *bufBegin, char *bufEnd)
 {
     while (*(bufEnd - 1) == ' ') {
@@ -3348,6 +3500,24 @@ static uint8_t getWordLength(char *bufBegin, char *bufEnd)
     return bufEnd - bufBegin;
 }
 
+// The filter settings are taken up as soon as they are set, everything else on save
+static void cliApplyFilterSettings(const clivalue_t *val)
+{
+    if (configIsInCopy) {
+        return;
+    }
+    switch (val->pgn) {
+    case PG_GYRO_CONFIG:
+        gyroReconfigureFilters();
+        break;
+    case PG_PID_PROFILE:
+        if (getPidProfileIndexToUse() == getCurrentPidProfileIndex()) {
+            pidPrepareProfile(currentPidProfile);
+        }
+        break;
+    }
+}
+
 STATIC_UNIT_TESTED void cliSet(char *cmdline)
 {
     const uint32_t len = strlen(cmdline);
@@ -3371,125 +3541,121 @@ STATIC_UNIT_TESTED void cliSet(char *cmdline)
         eqptr++;
         eqptr = skipSpace(eqptr);
 
-        for (uint32_t i = 0; i < valueTableEntryCount; i++) {
-            const clivalue_t *val = &valueTable[i];
+        const clivalue_t *val = cliFindValue(cmdline, variableNameLength);
+        if (val) {
+            bool valueChanged = false;
+            int16_t value  = 0;
+            switch (val->type & VALUE_MODE_MASK) {
+            case MODE_DIRECT: {
+                    int16_t value = atoi(eqptr);
+
+                    if (value >= val->config.minmax.min && value <= val->config.minmax.max) {
+                        cliSetVar(val, value);
+                        valueChanged = true;
+                    }
+                }
 
-            // ensure exact match when setting to prevent setting variables with shorter names
-            if (strncasecmp(cmdline, val->name, strlen(val->name)) == 0 && variableNameLength == strlen(val->name)) {
+                break;
+            case MODE_LOOKUP: 
+            case MODE_BITSET: {
+                    int tableIndex;
+                    if ((val->type & VALUE_MODE_MASK) == MODE_BITSET) {
+                        tableIndex = TABLE_OFF_ON;
+                    } else {
+                        tableIndex = val->config.lookup.tableIndex;
+                    }
+                    const lookupTableEntry_t *tableEntry = &lookupTables[tableIndex];
+                    bool matched = false;
+                    for (uint32_t tableValueIndex = 0; tableValueIndex < tableEntry->valueCount && !matched; tableValueIndex++) {
+                        matched = tableEntry->values[tableValueIndex] && strcasecmp(tableEntry->values[tableValueIndex], eqptr) == 0;
 
-                bool valueChanged = false;
-                int16_t value  = 0;
-                switch (val->type & VALUE_MODE_MASK) {
-                case MODE_DIRECT: {
-                        int16_t value = atoi(eqptr);
+                        if (matched) {
+                            value = tableValueIndex;
 
-                        if (value >= val->config.minmax.min && value <= val->config.minmax.max) {
                             cliSetVar(val, value);
                             valueChanged = true;
                         }
                     }
+                }
 
-                    break;
-                case MODE_LOOKUP: 
-                case MODE_BITSET: {
-                        int tableIndex;
-                        if ((val->type & VALUE_MODE_MASK) == MODE_BITSET) {
-                            tableIndex = TABLE_OFF_ON;
-                        } else {
-                            tableIndex = val->config.lookup.tableIndex;
-                        }
-                        const lookupTableEntry_t *tableEntry = &lookupTables[tableIndex];
-                        bool matched = false;
-                        for (uint32_t tableValueIndex = 0; tableValueIndex < tableEntry->valueCount && !matched; tableValueIndex++) {
-                            matched = tableEntry->values[tableValueIndex] && strcasecmp(tableEntry->values[tableValueIndex], eqptr) == 0;
-
-                            if (matched) {
-                                value = tableValueIndex;
-
-                                cliSetVar(val, value);
-                                valueChanged = true;
-                            }
-                        }
-                    }
-
-                    break;
+                break;
 
-                case MODE_ARRAY: {
-                        const uint8_t arrayLength = val->config.array.length;
-                        char *valPtr = eqptr;
-
-                        int i = 0;
-                        while (i < arrayLength && valPtr != NULL) {
-                            // skip spaces
-                            valPtr = skipSpace(valPtr);
-
-                            // process substring starting at valPtr
-                            // note: no need to copy substrings for atoi()
-                            //       it stops at the first character that cannot be converted...
-                            switch (val->type & VALUE_TYPE_MASK) {
-                            default:
-                            case VAR_UINT8:
-                                {
-                                    // fetch data pointer
-                                    uint8_t *data = (uint8_t *)cliGetValuePointer(val) + i;
-                                    // store value
-                                    *data = (uint8_t)atoi((const char*) valPtr);
-                                }
+            case MODE_ARRAY: {
+                    const uint8_t arrayLength = val->config.array.length;
+                    char *valPtr = eqptr;
 
-                                break;
-                            case VAR_INT8:
-                                {
-                                    // fetch data pointer
-                                    int8_t *data = (int8_t *)cliGetValuePointer(val) + i;
-                                    // store value
-                                    *data = (int8_t)atoi((const char*) valPtr);
-                                }
+                    int i = 0;
+                    while (i < arrayLength && valPtr != NULL) {
+                        // skip spaces
+                        valPtr = skipSpace(valPtr);
 
-                                break;
-                            case VAR_UINT16:
-                                {
-                                    // fetch data pointer
-                                    uint16_t *data = (uint16_t *)cliGetValuePointer(val) + i;
-                                    // store value
-                                    *data = (uint16_t)atoi((const char*) valPtr);
-                                }
+                        // process substring starting at valPtr
+                        // note: no need to copy substrings for atoi()
+                        //       it stops at the first character that cannot be converted...
+                        switch (val->type & VALUE_TYPE_MASK) {
+                        default:
+                        case VAR_UINT8:
+                            {
+                                // fetch data pointer
+                                uint8_t *data = (uint8_t *)cliGetValuePointer(val) + i;
+                                // store value
+                                *data = (uint8_t)atoi((const char*) valPtr);
+                            }
 
-                                break;
-                            case VAR_INT16:
-                                {
-                                    // fetch data pointer
-                                    int16_t *data = (int16_t *)cliGetValuePointer(val) + i;
-                                    // store value
-                                    *data = (int16_t)atoi((const char*) valPtr);
-                                }
+                            break;
+                        case VAR_INT8:
+                            {
+                                // fetch data pointer
+                                int8_t *data = (int8_t *)cliGetValuePointer(val) + i;
+                                // store value
+                                *data = (int8_t)atoi((const char*) valPtr);
+                            }
 
-                                break;
+                            break;
+                        case VAR_UINT16:
+                            {
+                                // fetch data pointer
+                                uint16_t *data = (uint16_t *)cliGetValuePointer(val) + i;
+                                // store value
+                                *data = (uint16_t)atoi((const char*) valPtr);
                             }
 
-                            // find next comma (or end of string)
-                            valPtr = strchr(valPtr, ',') + 1;
+                            break;
+                        case VAR_INT16:
+                            {
+                                // fetch data pointer
+                                int16_t *data = (int16_t *)cliGetValuePointer(val) + i;
+                                // store value
+                                *data = (int16_t)atoi((const char*) valPtr);
+                            }
 
-                            i++;
+                            break;
                         }
-                    }
 
-                    // mark as changed
-                    valueChanged = true;
-
-                    break;
+                        // find next comma (or end of string)
+                        valPtr = strchr(valPtr, ',') + 1;
 
+                        i++;
+                    }
                 }
 
-                if (valueChanged) {
-                    cliPrintf("%s set to ", val->name);
-                    cliPrintVar(val, 0);
-                } else {
-                    cliPrintErrorLinef("Invalid value");
-                    cliPrintVarRange(val);
-                }
+                // mark as changed
+                valueChanged = true;
+
+                break;
 
-                return;
             }
+
+            if (valueChanged) {
+                cliApplyFilterSettings(val);
+                cliPrintf("%s set to ", val->name);
+                cliPrintVar(val, 0);
+            } else {
+                cliPrintErrorLinef("Invalid value");
+                cliPrintVarRange(val);
+            }
+
+            return;
         }
         cliPrintErrorLinef("Invalid name");
     } else {
@@ -3516,6 +3682,11 @@ static void cliStatus(char *cmdline)
     cliPrintLinef("Voltage: %d * 0.1V (%dS battery - %s)", getBatteryVoltage(), getBatteryCellCount(), getBatteryStateString());
 
     cliPrintf("CPU Clock=%dMHz", (SystemCoreClock / 1000000));
+#ifdef USE_OVERCLOCK
+    if (OverclockFailed(systemConfig()->cpu_overclock)) {
+        cliPrintf(" (cpu_overclock failed the boot, stock clock until power cycle)");
+    }
+#endif
 
 #ifdef USE_ADC_INTERNAL
     uint16_t vrefintMv = getVrefMv();
@@ -3568,6 +3739,28 @@ static void cliStatus(char *cmdline)
     const int systemRate = getTaskDeltaTime(TASK_SYSTEM) == 0 ? 0 : (int)(1000000.0f / ((float)getTaskDeltaTime(TASK_SYSTEM)));
     cliPrintLinef("CPU:%d%%, cycle time: %d, GYRO rate: %d, RX rate: %d, System rate: %d",
             constrain(averageSystemLoadPercent, 0, 100), getTaskDeltaTime(TASK_GYROPID), gyroRate, rxRate, systemRate);
+#ifndef SKIP_TASK_STATISTICS
+    cliPrintLinef("CPU idle: %d%%", averageIdlePercent);
+#endif
+#ifdef USE_MOTOR_OUTPUT_SYNC
+    if (motorConfig()->motorOutputDelayUs) {
+        cliPrintLinef("Motor output slots missed: %d", getMotorOutputSyncMissedCount());
+    }
+#endif
+#ifdef USE_ESC_SENSOR
+    if (feature(FEATURE_ESC_SENSOR) && isEscSensorActive()) {
+        cliPrint("ESC telemetry age (ms):");
+        for (int i = 0; i < getMotorCount(); i++) {
+            const timeMs_t ageMs = getEscSensorFrameAgeMs(i);
+            if (ageMs == UINT32_MAX) {
+                cliPrint(" -");
+            } else {
+                cliPrintf(" %d", (int)ageMs);
+            }
+        }
+        cliPrintLinefeed();
+    }
+#endif
     cliPrint("Arming disable flags:");
     armingDisableFlags_e flags = getArmingDisableFlags();
     while (flags) {
@@ -3579,6 +3772,44 @@ static void cliStatus(char *cmdline)
 }
 
 #ifndef SKIP_TASK_STATISTICS
+#ifdef USE_TASK_HISTOGRAMS
+static void cliTaskHistograms(void)
+{
+    cliPrintLine("Task percentiles/us    exec p50   p99  p999  start p50   p99  p999");
+    for (cfTaskId_e taskId = 0; taskId < TASK_COUNT; taskId++) {
+        cfTaskInfo_t taskInfo;
+        getTaskInfo(taskId, &taskInfo);
+        taskHistogram_t executionTime;
+        taskHistogram_t startLatency;
+        if (taskInfo.isEnabled && getTaskHistograms(taskId, &executionTime, &startLatency)) {
+            cliPrintLinef("%02d - (%15s) %7d %5d %5d %10d %5d %5d", taskId, taskInfo.taskName,
+                taskHistogramPercentile(&executionTime, 500), taskHistogramPercentile(&executionTime, 990), taskHistogramPercentile(&executionTime, 999),
+                taskHistogramPercentile(&startLatency, 500), taskHistogramPercentile(&startLatency, 990), taskHistogramPercentile(&startLatency, 999));
+        }
+    }
+}
+#endif
+
+#ifdef STACK_CHECK
+static void cliTaskStack(void)
+{
+    static const char * const stackIsrNames[STACK_ISR_COUNT] = { "EXTI", "DMA", "UART" };
+
+    // ISRs are listed with the deepest stack they were entered at, the task peaks include the ISRs taken meanwhile
+    cliPrintLinef("Stack peak/bytes            %7d of %d", stackUsedSize(), stackTotalSize());
+    for (cfTaskId_e taskId = 0; taskId < TASK_COUNT; taskId++) {
+        cfTaskInfo_t taskInfo;
+        getTaskInfo(taskId, &taskInfo);
+        if (taskInfo.isEnabled) {
+            cliPrintLinef("%02d - (%15s) %7d", taskId, taskInfo.taskName, getTaskStackPeak(taskId));
+        }
+    }
+    for (int isr = 0; isr < STACK_ISR_COUNT; isr++) {
+        cliPrintLinef("ISR  (%15s) %7d", stackIsrNames[isr], stackIsrUsedSize(isr));
+    }
+}
+#endif
+
 static void cliTasks(char *cmdline)
 {
     UNUSED(cmdline);
@@ -3600,8 +3831,8 @@ static void cliTasks(char *cmdline)
             int subTaskFrequency = 0;
             if (taskId == TASK_GYROPID) {
                 subTaskFrequency = taskInfo.latestDeltaTime == 0 ? 0 : (int)(1000000.0f / ((float)taskInfo.latestDeltaTime));
-                taskFrequency = subTaskFrequency / pidConfig()->pid_process_denom;
-                if (pidConfig()->pid_process_denom > 1) {
+                taskFrequency = subTaskFrequency / pidGetProcessDenom();
+                if (pidGetProcessDenom() > 1) {
                     cliPrintf("%02d - (%15s) ", taskId, taskInfo.taskName);
                 } else {
                     taskFrequency = subTaskFrequency;
@@ -3624,7 +3855,7 @@ static void cliTasks(char *cmdline)
             } else {
                 cliPrintLinef("%6d", taskFrequency);
             }
-            if (taskId == TASK_GYROPID && pidConfig()->pid_process_denom > 1) {
+            if (taskId == TASK_GYROPID && pidGetProcessDenom() > 1) {
                 cliPrintLinef("   - (%15s) %6d", taskInfo.subTaskName, subTaskFrequency);
             }
         }
@@ -3634,6 +3865,98 @@ static void cliTasks(char *cmdline)
         getCheckFuncInfo(&checkFuncInfo);
         cliPrintLinef("RX Check Function %19d %7d %25d", checkFuncInfo.maxExecutionTime, checkFuncInfo.averageExecutionTime, checkFuncInfo.totalExecutionTime / 1000);
         cliPrintLinef("Total (excluding SERIAL) %25d.%1d%% %4d.%1d%%", maxLoadSum/10, maxLoadSum%10, averageLoadSum/10, averageLoadSum%10);
+#ifdef USE_TASK_HISTOGRAMS
+        cliTaskHistograms();
+#endif
+    }
+#ifdef STACK_CHECK
+    cliTaskStack();
+#endif
+}
+#endif
+
+#ifdef USE_CRASH_TRACE
+static void cliCrashTrace(char *cmdline)
+{
+    UNUSED(cmdline);
+
+    const crashTraceReport_t *report = crashTraceGetReport();
+    if (!report) {
+        cliPrintLine("No trace from before the last reset");
+        return;
+    }
+
+    static const struct {
+        uint32_t flag;
+        const char *name;
+    } resetFlagNames[] = {
+        { RCC_CSR_LPWRRSTF, "LOWPOWER" },
+        { RCC_CSR_WWDGRSTF, "WWDG" },
+        { RCC_CSR_WDGRSTF, "IWDG" },
+        { RCC_CSR_SFTRSTF, "SOFTWARE" },
+        { RCC_CSR_PORRSTF, "POWERON" },
+        { RCC_CSR_PADRSTF, "PIN" },
+        { RCC_CSR_BORRSTF, "BROWNOUT" },
+    };
+    cliPrint("Reset:");
+    for (unsigned i = 0; i < ARRAYLEN(resetFlagNames); i++) {
+        if (report->resetFlags & resetFlagNames[i].flag) {
+            cliPrintf(" %s", resetFlagNames[i].name);
+        }
+    }
+    cliPrintLinefeed();
+
+    if (report->faulted) {
+        const crashTraceFault_t *fault = &report->fault;
+        cliPrintLinef("Hard fault in task %d, PC: 0x%08x, LR: 0x%08x, PSR: 0x%08x", fault->taskId, fault->pc, fault->lr, fault->psr);
+        cliPrintLinef("CFSR: 0x%08x, HFSR: 0x%08x, MMFAR: 0x%08x, BFAR: 0x%08x", fault->cfsr, fault->hfsr, fault->mmfar, fault->bfar);
+    }
+
+    // the newest task run is the last one that returned
+    cliPrintLine("Task runs before the reset  started/us  exec/us  late/us");
+    for (int i = 0; i < report->entryCount; i++) {
+        const schedulerTraceEntry_t *entry = &report->entries[i];
+        cfTaskInfo_t taskInfo;
+        getTaskInfo(entry->taskId, &taskInfo);
+        cliPrintLinef("%02d - (%15s) %12u %8d %8d", entry->taskId, taskInfo.taskName, entry->startedAt, entry->executionTime, entry->lateness);
+    }
+}
+#endif
+
+#ifdef USE_MOTOR_TIMING
+#define LATENCY_TEST_MAX_RUNS 10000
+
+static void cliLatencyTest(char *cmdline)
+{
+    if (!isEmpty(cmdline)) {
+        const int runs = atoi(cmdline);
+        if (runs < 1 || runs > LATENCY_TEST_MAX_RUNS) {
+            cliShowArgumentRangeError("runs", 1, LATENCY_TEST_MAX_RUNS);
+        } else if (!motorTimingTestStart(runs)) {
+            cliPrintLine("Only runs while disarmed");
+        } else {
+            cliPrintLinef("Started %d runs", runs);
+        }
+        return;
+    }
+
+    motorTimingTestStatus_t status;
+    motorTimingTestGetStatus(&status);
+    cliPrintLinef("Runs left: %d, completed: %d, timed out: %d", status.runsLeft, status.completed, status.timedOut);
+
+    static const char * const stageNames[MOTOR_TIMING_TEST_HISTOGRAM_COUNT] = {
+        [MOTOR_TIMING_TEST_GYRO_TO_PID] = "GYRO TO PID",
+        [MOTOR_TIMING_TEST_PID_TO_MIXER] = "PID TO MIXER",
+        [MOTOR_TIMING_TEST_MIXER_TO_OUTPUT] = "MIXER TO DMA",
+        [MOTOR_TIMING_TEST_OUTPUT_DURATION] = "DMA",
+        [MOTOR_TIMING_TEST_TOTAL] = "TOTAL",
+    };
+    // the percentiles are the upper bounds of their log2 buckets
+    cliPrintLine("Stage          p50/us  p99/us");
+    for (int id = 0; id < MOTOR_TIMING_TEST_HISTOGRAM_COUNT; id++) {
+        const uint32_t p50 = motorTimingTestPercentile(id, 500);
+        const uint32_t p99 = motorTimingTestPercentile(id, 990);
+        cliPrintLinef("%-12s %5d.%d %5d.%d", stageNames[id], p50 / 10, p50 % 10, p99 / 10, p99 % 10);
     }
 }
 #endif
@@ -3690,6 +4013,17 @@ static void cliRcSmoothing(char *cmdline)
                 cliPrintLine("manual)");
             }
         }
+#ifdef USE_RC_PREDICTION
+    } else if (rxConfig()->rc_smoothing_type == RC_SMOOTHING_TYPE_PREDICTION) {
+        cliPrintLine("PREDICTION");
+        const int frameIntervalUs = lrintf(rxGetFrameIntervalUs());
+        cliPrint("# Measured RX frame interval: ");
+        if (frameIntervalUs == 0) {
+            cliPrintLine("NO SIGNAL");
+        } else {
+            cliPrintLinef("%dus, jitter %dus", frameIntervalUs, (int)lrintf(rxGetFrameJitterUs()));
+        }
+#endif
     } else {
         cliPrintLine("INTERPOLATION");
     }
@@ -4034,11 +4368,27 @@ static void printDma(void)
         cliPrintf(DMA_OUTPUT_STRING, DMA_DEVICE_NO(i), DMA_DEVICE_INDEX(i));
         uint8_t resourceIndex = dmaGetResourceIndex(i);
         if (resourceIndex > 0) {
-            cliPrintLinef(" %s %d", owner, resourceIndex);
+            cliPrintf(" %s %d", owner, resourceIndex);
         } else {
-            cliPrintLinef(" %s", owner);
+            cliPrintf(" %s", owner);
+        }
+        const resourceOwner_e conflictOwner = dmaGetConflictOwner(i);
+        if (conflictOwner != OWNER_FREE) {
+            const uint8_t conflictIndex = dmaGetConflictResourceIndex(i);
+            if (conflictIndex > 0) {
+                cliPrintf(" (CONFLICT, taken from %s %d)", ownerNames[conflictOwner], conflictIndex);
+            } else {
+                cliPrintf(" (CONFLICT, taken from %s)", ownerNames[conflictOwner]);
+            }
         }
+        cliPrintLinefeed();
     }
+#ifdef USE_DMA_SPEC
+    const dmaAllocationFailure_t *failure;
+    for (unsigned i = 0; (failure = dmaGetAllocationFailure(i)); i++) {
+        cliPrintLinef("No free DMA stream: %s %d", ownerNames[failure->owner], failure->resourceIndex);
+    }
+#endif
 }
 
 static void cliDma(char* cmdLine)
@@ -4407,6 +4757,9 @@ static void cliHelp(char *cmdline);
 const clicmd_t cmdTable[] = {
     CLI_COMMAND_DEF("adjrange", "configure adjustment ranges", NULL, cliAdjustmentRange),
     CLI_COMMAND_DEF("aux", "configure modes", "<index> <mode> <aux> <start> <end> <logic>", cliAux),
+#ifdef USE_CLI_BATCH
+    CLI_COMMAND_DEF("batch", "start or end a batch of commands, only errors are shown and the save is done at the end", "start | end", cliBatch),
+#endif
 #if defined(USE_BEEPER)
 #if defined(USE_DSHOT)
     CLI_COMMAND_DEF("beacon", "enable/disable Dshot beacon for a condition", "list\r\n"
@@ -4421,6 +4774,9 @@ const clicmd_t cmdTable[] = {
 #endif
 #ifdef USE_LED_STRIP
     CLI_COMMAND_DEF("color", "configure colors", NULL, cliColor),
+#endif
+#ifdef USE_CRASH_TRACE
+    CLI_COMMAND_DEF("crashtrace", "show the task runs and the fault before the last reset", NULL, cliCrashTrace),
 #endif
     CLI_COMMAND_DEF("defaults", "reset to defaults and reboot", "[nosave]", cliDefaults),
     CLI_COMMAND_DEF("diff", "list configuration changes from default", "[master|profile|rates|all] {defaults}", cliDiff),
@@ -4458,6 +4814,9 @@ const clicmd_t cmdTable[] = {
     CLI_COMMAND_DEF("gyroregisters", "dump gyro config registers contents", NULL, cliDumpGyroRegisters),
 #endif
     CLI_COMMAND_DEF("help", NULL, NULL, cliHelp),
+#ifdef USE_MOTOR_TIMING
+    CLI_COMMAND_DEF("latency_test", "measure the gyro to motor output latency while disarmed", "[<runs>]", cliLatencyTest),
+#endif
 #ifdef USE_LED_STRIP
     CLI_COMMAND_DEF("led", "configure leds", NULL, cliLed),
 #endif
@@ -4624,10 +4983,19 @@ void cliProcess(void)
                         break;
                     }
                 }
-                if (cmd < cmdTable + ARRAYLEN(cmdTable))
+#ifdef USE_CLI_BATCH
+                if (cliBatchMode) {
+                    cliBatchLine++;
+                }
+#endif
+                if (cmd < cmdTable + ARRAYLEN(cmdTable)) {
                     cmd->func(options);
-                else
+                } else if (CLI_IN_BATCH()) {
+                    // nothing else is printed in a batch, so count it as a failed line
+                    cliPrintErrorLinef("Unknown command, try 'help'");
+                } else {
                     cliPrint("Unknown command, try 'help'");
+                }
                 bufferIndex = 0;
             }
 
@@ -55,6 +55,15 @@ typedef enum {
     CRSF_FRAMETYPE_DISPLAYPORT_CMD = 0x7D, // displayport control command
 } crsfFrameType_e;
 
+enum {
+    CRSF_COMMAND_SUBCMD_GENERAL = 0x0A,    // general command
+};
+
+enum {
+    CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL = 0x70,    // proposed new CRSF port speed
+    CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE = 0x71,    // response to the proposed CRSF port speed
+};
+
 enum {
     CRSF_DISPLAYPORT_SUBCMD_UPDATE = 0x01, // transmit displayport buffer to remote
     CRSF_DISPLAYPORT_SUBCMD_CLEAR = 0X02, // clear client screen
@@ -74,6 +83,8 @@ enum {
     CRSF_FRAME_LINK_STATISTICS_PAYLOAD_SIZE = 10,
     CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE = 22, // 11 bits per channel * 16 channels = 22 bytes.
     CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE = 6,
+    CRSF_FRAME_SPEED_PROPOSAL_PAYLOAD_SIZE = 10, // dest, origin, command, subcommand, port, baud rate (4 bytes), command CRC
+    CRSF_FRAME_SPEED_RESPONSE_PAYLOAD_SIZE = 7,  // dest, origin, command, subcommand, port, status, command CRC
 };
 
 enum {
@@ -27,14 +27,19 @@
 #include "platform.h"
 
 #include "blackbox/blackbox.h"
+#include "blackbox/blackbox_io.h"
 
 #include "build/build_config.h"
+#include "build/crash_trace.h"
 #include "build/debug.h"
+#include "build/motor_timing.h"
+#include "build/profiler.h"
 #include "build/version.h"
 
 #include "common/axis.h"
 #include "common/bitarray.h"
 #include "common/color.h"
+#include "common/crc.h"
 #include "common/maths.h"
 #include "common/streambuf.h"
 #include "common/huffman.h"
@@ -57,6 +62,7 @@
 #include "drivers/sdcard.h"
 #include "drivers/serial.h"
 #include "drivers/serial_escserial.h"
+#include "drivers/stack_check.h"
 #include "drivers/system.h"
 #include "drivers/vtx_common.h"
 #include "drivers/transponder_ir.h"
@@ -118,6 +124,7 @@
 #include "sensors/esc_sensor.h"
 #include "sensors/compass.h"
 #include "sensors/gyro.h"
+#include "sensors/gyroanalyse.h"
 #include "sensors/rangefinder.h"
 #include "sensors/sensors.h"
 
@@ -161,6 +168,8 @@ typedef enum {
 } mspFlashFsFlags_e;
 
 #define RATEPROFILE_MASK (1 << 7)
+
+#define MSP_SCHEDULER_TRACE_MAX_ENTRIES 16 // 9 bytes each
 #endif //USE_OSD_SLAVE
 
 #define RTC_NOT_SUPPORTED 0xff
@@ -317,7 +326,8 @@ enum compressionType_e {
     HUFFMAN
 };
 
-static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uint16_t size, bool useLegacyFormat, bool allowCompression)
+// Returns the number of bytes read from the flash
+static uint16_t serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uint16_t size, bool useLegacyFormat, bool allowCompression)
 {
     BUILD_BUG_ON(MSP_PORT_DATAFLASH_INFO_SIZE < 16);
 
@@ -359,6 +369,8 @@ static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uin
                 sbufWriteU8(dst, 0);
             }
         }
+
+        return bytesRead;
     } else {
 #ifdef USE_HUFFMAN
         // compress in 256-byte chunks
@@ -398,8 +410,47 @@ static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uin
         // payload
         sbufWriteU16(dst, bytesReadTotal);
         sbufAdvance(dst, state.bytesWritten);
+
+        return bytesReadTotal;
 #endif
     }
+
+    return 0;
+}
+
+/*
+ * MSP_DATAFLASH_STREAM pushes a range of the flash as a continuous run of frames instead of one reply per
+ * request. Each frame is laid out like an MSP_DATAFLASH_READ reply, followed by a CRC16-CCITT of the frame payload
+ * before it, so a host can check every block on top of the weak MSP checksum.
+ *
+ * The flash reads are synchronous SPI transfers, so with compression each block is read and encoded in chunks as
+ * the frame is built, rather than overlapped with a read in flight.
+ */
+static struct {
+    uint32_t address;       // next byte to send
+    uint32_t end;
+    uint16_t blockSize;
+    bool allowCompression;
+} dataflashStream;
+
+static bool mspFcDataflashStreamFill(sbuf_t *dst)
+{
+    if (dataflashStream.address >= dataflashStream.end) {
+        return false;
+    }
+
+    uint8_t *frameStart = sbufPtr(dst);
+    const uint16_t size = MIN(dataflashStream.blockSize, dataflashStream.end - dataflashStream.address);
+
+    dataflashStream.address += serializeDataflashReadReply(dst, dataflashStream.address, size, false, dataflashStream.allowCompression);
+    crc16_ccitt_sbuf_append(dst, frameStart);
+
+    return true;
+}
+
+static void mspFcDataflashStreamStart(serialPort_t *port)
+{
+    mspSerialStartStream(port, MSP_DATAFLASH_STREAM, mspFcDataflashStreamFill);
 }
 #endif // USE_FLASHFS
 #endif // USE_OSD_SLAVE
@@ -507,9 +558,7 @@ static bool mspCommonProcessOutCommand(uint8_t cmdMSP, sbuf_t *dst, mspPostProce
         // output some useful QA statistics
         // debug[x] = ((hse_value / 1000000) * 1000) + (SystemCoreClock / 1000000);         // XX0YY [crystal clock : core clock]
 
-        for (int i = 0; i < DEBUG16_VALUE_COUNT; i++) {
-            sbufWriteU16(dst, debug[i]);      // 4 variables are here for general monitoring purpose
-        }
+        sbufWriteU16Array(dst, (const uint16_t *)debug, DEBUG16_VALUE_COUNT); // 4 variables are here for general monitoring purpose
         break;
 
     case MSP_UID:
@@ -542,6 +591,11 @@ static bool mspCommonProcessOutCommand(uint8_t cmdMSP, sbuf_t *dst, mspPostProce
 
         // battery alerts
         sbufWriteU8(dst, (uint8_t)getBatteryState());
+
+        // battery model
+        sbufWriteU16(dst, (uint16_t)constrain(getBatteryRemainingTime(), 0, 0xFFFF)); // seconds at the present draw, 0 when unknown
+        sbufWriteU8(dst, (uint8_t)constrain(getBatteryRestingVoltage(), 0, 255)); // voltage without the load sag, in 0.1V steps
+        sbufWriteU16(dst, getBatteryResistance()); // in milliohm
         break;
     }
 
@@ -736,6 +790,28 @@ static bool mspCommonProcessOutCommand(uint8_t cmdMSP, sbuf_t *dst, mspPostProce
         break;
     }
 
+#ifdef USE_MAX7456
+    case MSP_OSD_CHAR_WRITE_STATUS:
+        sbufWriteU8(dst, max7456NvmCharsPending());
+        sbufWriteU16(dst, max7456NvmCharsWritten());
+        break;
+#endif
+
+#ifdef STACK_CHECK
+    case MSP_STACK_USAGE:
+        sbufWriteU16(dst, stackTotalSize());
+        sbufWriteU16(dst, stackUsedSize());
+        sbufWriteU8(dst, TASK_COUNT);
+        for (cfTaskId_e taskId = 0; taskId < TASK_COUNT; taskId++) {
+            sbufWriteU16(dst, getTaskStackPeak(taskId));
+        }
+        sbufWriteU8(dst, STACK_ISR_COUNT);
+        for (int isr = 0; isr < STACK_ISR_COUNT; isr++) {
+            sbufWriteU16(dst, stackIsrUsedSize(isr));
+        }
+        break;
+#endif
+
     default:
         return false;
     }
@@ -895,15 +971,13 @@ static bool mspProcessOutCommand(uint8_t cmdMSP, sbuf_t *dst)
         break;
 
     case MSP_RC:
-        for (int i = 0; i < rxRuntimeConfig.channelCount; i++) {
-            sbufWriteU16(dst, rcData[i]);
-        }
+        sbufWriteU16Array(dst, (const uint16_t *)rcData, rxRuntimeConfig.channelCount);
         break;
 
     case MSP_ATTITUDE:
-        sbufWriteU16(dst, attitude.values.roll);
-        sbufWriteU16(dst, attitude.values.pitch);
-        sbufWriteU16(dst, DECIDEGREES_TO_DEGREES(attitude.values.yaw));
+        sbufWriteU16(dst, getAttitude()->values.roll);
+        sbufWriteU16(dst, getAttitude()->values.pitch);
+        sbufWriteU16(dst, DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw));
         break;
 
     case MSP_ALTITUDE:
@@ -1199,6 +1273,26 @@ static bool mspProcessOutCommand(uint8_t cmdMSP, sbuf_t *dst)
 #endif
         break;
 
+#ifdef USE_BLACKBOX
+    case MSP_BLACKBOX_STATS:
+        {
+            blackboxDeviceStats_t stats;
+            blackboxDeviceGetStats(&stats);
+
+            sbufWriteU8(dst, !blackboxMayEditConfig()); // a log is open
+            for (int i = 0; i < BLACKBOX_FRAME_TYPE_COUNT; i++) {
+                sbufWriteU32(dst, stats.framesWritten[i]);
+                sbufWriteU32(dst, stats.framesDropped[i]);
+            }
+            sbufWriteU32(dst, stats.bytesWritten);
+            sbufWriteU32(dst, stats.bytesDropped);
+            sbufWriteU32(dst, stats.stallTimeMs);
+            sbufWriteU32(dst, stats.durationMs);
+            sbufWriteU32(dst, stats.bytesPerSecond);
+        }
+        break;
+#endif
+
     case MSP_SDCARD_SUMMARY:
         serializeSDCardSummaryReply(dst);
         break;
@@ -1359,6 +1453,231 @@ static mspResult_e mspFcProcessOutCommandWithArg(uint8_t cmdMSP, sbuf_t *arg, sb
             serializeBoxReply(dst, page, &serializeBoxPermanentIdFn);
         }
         break;
+#ifdef USE_TASK_HISTOGRAMS
+    case MSP_TASK_HISTOGRAMS:
+        {
+            const cfTaskId_e taskId = sbufBytesRemaining(arg) ? sbufReadU8(arg) : TASK_GYROPID;
+            taskHistogram_t executionTime;
+            taskHistogram_t startLatency;
+            if (!getTaskHistograms(taskId, &executionTime, &startLatency)) {
+                return MSP_RESULT_ERROR;
+            }
+            sbufWriteU8(dst, taskId);
+            sbufWriteU8(dst, TASK_HISTOGRAM_BUCKET_COUNT);
+            for (int i = 0; i < TASK_HISTOGRAM_BUCKET_COUNT; i++) {
+                sbufWriteU16(dst, executionTime.bucket[i]);
+            }
+            for (int i = 0; i < TASK_HISTOGRAM_BUCKET_COUNT; i++) {
+                sbufWriteU16(dst, startLatency.bucket[i]);
+            }
+        }
+        break;
+#endif
+#ifdef USE_FLASHFS
+    case MSP_DATAFLASH_INDEX:
+        {
+            // as many entries from the given one on as fit in the reply
+            const int count = flashfsLogIndexGetCount();
+            const int first = sbufBytesRemaining(arg) >= 2 ? sbufReadU16(arg) : 0;
+            const int entrySize = 4 * sizeof(uint32_t);
+            const int entries = constrain(MIN(count - first, (sbufBytesRemaining(dst) - 5) / entrySize), 0, UINT8_MAX);
+
+            sbufWriteU16(dst, count);
+            sbufWriteU16(dst, first);
+            sbufWriteU8(dst, entries);
+            for (int i = first; i < first + entries; i++) {
+                flashfsLogIndexEntry_t entry;
+                if (!flashfsLogIndexGetEntry(i, &entry)) {
+                    return MSP_RESULT_ERROR;
+                }
+                sbufWriteU32(dst, entry.start);
+                sbufWriteU32(dst, entry.length);
+                sbufWriteU32(dst, entry.durationMs);
+                sbufWriteU32(dst, entry.flags);
+            }
+        }
+        break;
+#endif
+#ifdef USE_RX_LINK_STATS
+    case MSP_RX_LINK_STATS:
+        {
+            uint8_t *countPtr = sbufPtr(dst);
+            sbufWriteU8(dst, 0);
+            uint8_t count = 0;
+            rxLinkStats_t linkStats;
+            for (; rxGetLinkStats(&linkStats, count); count++) {
+                sbufWriteU16(dst, linkStats.frames);
+                sbufWriteU16(dst, linkStats.droppedFrames);
+                sbufWriteU16(dst, linkStats.failsafeFrames);
+                sbufWriteU16(dst, linkStats.crcErrors);
+                sbufWriteU16(dst, linkStats.intervalMinUs);
+                sbufWriteU16(dst, linkStats.intervalAvgUs);
+                sbufWriteU16(dst, linkStats.intervalMaxUs);
+            }
+            *countPtr = count;
+        }
+        break;
+#endif
+#ifdef USE_GYRO_DATA_ANALYSE
+    case MSP_GYRO_SPECTRUM:
+        {
+            // with the dynamic filter off the analysis runs while the spectrum is being polled,
+            // so the first reply after a pause may still hold an old spectrum
+            gyroSpectrumRequest(micros());
+            gyroSpectrum_t spectrum;
+            gyroSpectrumGet(X, &spectrum);
+            sbufWriteU8(dst, XYZ_AXIS_COUNT);
+            sbufWriteU8(dst, spectrum.binCount);
+            sbufWriteU16(dst, spectrum.binWidth);
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                gyroSpectrumGet(axis, &spectrum);
+                for (int i = 0; i < spectrum.binCount; i++) {
+                    sbufWriteU16(dst, spectrum.magnitude[i]);
+                }
+            }
+        }
+        break;
+#endif
+#ifdef USE_SCHEDULER_TRACE
+    case MSP_SCHEDULER_TRACE:
+        {
+            // entries from the given sequence number on, or the oldest ones still available
+            const uint32_t nextSequence = schedulerTraceSequence();
+            const uint32_t oldestSequence = nextSequence > SCHEDULER_TRACE_SIZE ? nextSequence - SCHEDULER_TRACE_SIZE : 0;
+            uint32_t sequence = sbufBytesRemaining(arg) >= 4 ? sbufReadU32(arg) : oldestSequence;
+            if (nextSequence - sequence > nextSequence - oldestSequence) {
+                sequence = oldestSequence;
+            }
+            const uint8_t count = MIN(nextSequence - sequence, (uint32_t)MSP_SCHEDULER_TRACE_MAX_ENTRIES);
+            sbufWriteU32(dst, sequence);
+            uint8_t *countPtr = sbufPtr(dst);
+            sbufWriteU8(dst, 0);
+            uint8_t written = 0;
+            schedulerTraceEntry_t entry;
+            for (; written < count && schedulerTraceRead(sequence + written, &entry); written++) {
+                sbufWriteU8(dst, entry.taskId);
+                sbufWriteU32(dst, entry.startedAt);
+                sbufWriteU16(dst, entry.executionTime);
+                sbufWriteU16(dst, entry.lateness);
+            }
+            *countPtr = written;
+        }
+        break;
+#endif
+#ifdef USE_CRASH_TRACE
+    case MSP_CRASH_TRACE:
+        {
+            // the task runs from the given one on, the reply is empty without a trace from before the reset
+            const crashTraceReport_t *report = crashTraceGetReport();
+            if (!report) {
+                break;
+            }
+            const uint8_t first = MIN(sbufBytesRemaining(arg) ? sbufReadU8(arg) : 0, report->entryCount);
+            const crashTraceFault_t *fault = &report->fault;
+            sbufWriteU32(dst, report->resetFlags);
+            sbufWriteU8(dst, report->faulted);
+            sbufWriteU8(dst, fault->taskId);
+            sbufWriteU32(dst, fault->pc);
+            sbufWriteU32(dst, fault->lr);
+            sbufWriteU32(dst, fault->psr);
+            sbufWriteU32(dst, fault->cfsr);
+            sbufWriteU32(dst, fault->hfsr);
+            sbufWriteU32(dst, fault->mmfar);
+            sbufWriteU32(dst, fault->bfar);
+            sbufWriteU8(dst, report->entryCount);
+            sbufWriteU8(dst, first);
+            const uint8_t count = MIN(report->entryCount - first, MSP_SCHEDULER_TRACE_MAX_ENTRIES);
+            sbufWriteU8(dst, count);
+            for (int i = first; i < first + count; i++) {
+                const schedulerTraceEntry_t *entry = &report->entries[i];
+                sbufWriteU8(dst, entry->taskId);
+                sbufWriteU32(dst, entry->startedAt);
+                sbufWriteU16(dst, entry->executionTime);
+                sbufWriteU16(dst, entry->lateness);
+            }
+        }
+        break;
+#endif
+#ifdef USE_PROFILER
+    case MSP_PROFILER:
+        {
+            // a non zero argument restarts the statistics after they are sent
+            const bool reset = sbufBytesRemaining(arg) && sbufReadU8(arg);
+            sbufWriteU32(dst, PROFILER_CLOCK_HZ);
+            sbufWriteU8(dst, PROFILER_PROBE_COUNT);
+            for (int probe = 0; probe < PROFILER_PROBE_COUNT; probe++) {
+                profilerStats_t stats;
+                profilerGetStats(probe, &stats);
+                sbufWriteU32(dst, stats.count);
+                sbufWriteU32(dst, stats.count ? stats.minCycles : 0);
+                sbufWriteU32(dst, stats.count ? stats.totalCycles / stats.count : 0);
+                sbufWriteU32(dst, stats.maxCycles);
+            }
+            if (reset) {
+                profilerReset();
+            }
+        }
+        break;
+#endif
+#ifdef USE_MOTOR_TIMING
+    case MSP_MOTOR_TIMING:
+        {
+            // a non zero argument restarts the histograms after they are sent
+            const bool reset = sbufBytesRemaining(arg) && sbufReadU8(arg);
+            sbufWriteU8(dst, MOTOR_TIMING_HISTOGRAM_COUNT);
+            sbufWriteU8(dst, MOTOR_TIMING_BUCKET_COUNT);
+            for (int id = 0; id < MOTOR_TIMING_HISTOGRAM_COUNT; id++) {
+                motorTimingHistogram_t histogram;
+                motorTimingGetHistogram(id, &histogram);
+                for (int i = 0; i < MOTOR_TIMING_BUCKET_COUNT; i++) {
+                    sbufWriteU16(dst, histogram.bucket[i]);
+                }
+            }
+            if (reset) {
+                motorTimingReset();
+            }
+        }
+        break;
+    case MSP_MOTOR_TIMING_TEST:
+        {
+            // a non zero number of runs starts the test, which is refused while armed
+            const uint16_t runs = sbufBytesRemaining(arg) >= 2 ? sbufReadU16(arg) : 0;
+            if (runs && !motorTimingTestStart(runs)) {
+                return MSP_RESULT_ERROR;
+            }
+            motorTimingTestStatus_t status;
+            motorTimingTestGetStatus(&status);
+            sbufWriteU16(dst, status.runsLeft);
+            sbufWriteU16(dst, status.completed);
+            sbufWriteU16(dst, status.timedOut);
+            sbufWriteU8(dst, MOTOR_TIMING_TEST_HISTOGRAM_COUNT);
+            sbufWriteU8(dst, MOTOR_TIMING_BUCKET_COUNT);
+            for (int id = 0; id < MOTOR_TIMING_TEST_HISTOGRAM_COUNT; id++) {
+                motorTimingHistogram_t histogram;
+                motorTimingTestGetHistogram(id, &histogram);
+                for (int i = 0; i < MOTOR_TIMING_BUCKET_COUNT; i++) {
+                    sbufWriteU16(dst, histogram.bucket[i]);
+                }
+            }
+        }
+        break;
+#endif
+#ifdef USE_CONFIG_SNAPSHOT
+    case MSP_CONFIG_SNAPSHOT:
+        {
+            // as much of the snapshot from the given offset on as fits in the reply
+            const int offset = sbufBytesRemaining(arg) >= 2 ? sbufReadU16(arg) : 0;
+            uint8_t *sizePtr = sbufPtr(dst);
+            sbufWriteU16(dst, 0);
+            sbufWriteU16(dst, offset);
+            const int size = getConfigSnapshot(sbufPtr(dst), offset, sbufBytesRemaining(dst));
+            const int length = constrain(size - offset, 0, sbufBytesRemaining(dst));
+            sizePtr[0] = size & 0xFF;
+            sizePtr[1] = size >> 8;
+            sbufAdvance(dst, length);
+        }
+        break;
+#endif
     default:
         return MSP_RESULT_CMD_UNKNOWN;
     }
@@ -1367,6 +1686,29 @@ static mspResult_e mspFcProcessOutCommandWithArg(uint8_t cmdMSP, sbuf_t *arg, sb
 #endif // USE_OSD_SLAVE
 
 #ifdef USE_FLASHFS
+/*
+ * Request: start address (u32), length (u32, 0 stops a running stream), and optionally the largest block per frame
+ * (u16) and whether compression is allowed (u8). Replies with the address and the length that will be sent.
+ */
+static void mspFcDataflashStreamCommand(sbuf_t *dst, sbuf_t *src, mspPostProcessFnPtr *mspPostProcessFn)
+{
+    const uint32_t address = sbufReadU32(src);
+    const uint32_t length = sbufReadU32(src);
+    const uint32_t flashfsSize = flashfsGetSize();
+
+    dataflashStream.blockSize = sbufBytesRemaining(src) >= 2 ? sbufReadU16(src) : MSP_PORT_DATAFLASH_BUFFER_SIZE;
+    dataflashStream.allowCompression = sbufBytesRemaining(src) ? sbufReadU8(src) : false;
+    dataflashStream.address = MIN(address, flashfsSize);
+    dataflashStream.end = dataflashStream.address + MIN(length, flashfsSize - dataflashStream.address);
+
+    sbufWriteU32(dst, dataflashStream.address);
+    sbufWriteU32(dst, dataflashStream.end - dataflashStream.address);
+
+    if (dataflashStream.end > dataflashStream.address && dataflashStream.blockSize) {
+        *mspPostProcessFn = mspFcDataflashStreamStart;
+    }
+}
+
 static void mspFcDataFlashReadCommand(sbuf_t *dst, sbuf_t *src)
 {
     const unsigned int dataSize = sbufBytesRemaining(src);
@@ -1389,6 +1731,86 @@ static void mspFcDataFlashReadCommand(sbuf_t *dst, sbuf_t *src)
 }
 #endif
 
+#ifdef USE_MSP_MULTIPLE
+/*
+ * Reply to each of the out messages listed in src, as a U8 command, U8 size and the reply itself. Only messages that
+ * take no arguments are supported. Replies stop at the first one that doesn't fit, so the caller should ask again
+ * for the rest.
+ */
+static void mspFcMultipleCommand(sbuf_t *dst, sbuf_t *src)
+{
+    // Large enough for any reply that fits in the minimum MSP_PORT_OUTBUF_SIZE
+    static uint8_t replyBuf[UINT8_MAX + 1];
+
+    while (sbufBytesRemaining(src)) {
+        const uint8_t cmdMSP = sbufReadU8(src);
+        sbuf_t reply = { .ptr = replyBuf, .end = ARRAYEND(replyBuf) };
+        mspPostProcessFnPtr mspPostProcessFn = NULL;
+
+        if ((!mspCommonProcessOutCommand(cmdMSP, &reply, &mspPostProcessFn) && !mspProcessOutCommand(cmdMSP, &reply))
+            || reply.ptr - replyBuf > UINT8_MAX) {
+            // Unknown, needs arguments, or too big for the size byte, so it gets an empty reply
+            reply.ptr = replyBuf;
+        }
+
+        const int replySize = reply.ptr - replyBuf;
+        if (sbufBytesRemaining(dst) < replySize + 2) {
+            break;
+        }
+
+        sbufWriteU8(dst, cmdMSP);
+        sbufWriteU8(dst, replySize);
+        sbufWriteData(dst, replyBuf, replySize);
+    }
+}
+#endif
+
+#ifdef USE_MSP_SUBSCRIPTIONS
+// Shortest period a subscription can ask for, so a few subscriptions can't starve the port
+#define MSP_SUBSCRIPTION_MIN_PERIOD_MS 10
+
+static mspSubscription_t mspPendingSubscriptions[MSP_MAX_SUBSCRIPTIONS];
+static uint8_t mspPendingSubscriptionCount;
+
+static void mspFcSubscribeStart(serialPort_t *port)
+{
+    mspSerialSetSubscriptions(port, mspPendingSubscriptions, mspPendingSubscriptionCount);
+}
+
+/*
+ * Replace the subscriptions of the requesting port with the list in src, each a U8 out message and its U16 period in
+ * milliseconds. An empty list cancels them. Messages that aren't out messages without arguments are dropped, as
+ * they would be unsafe or meaningless to repeat, and the reply is the U8 number of subscriptions accepted.
+ */
+static void mspFcSubscribeCommand(sbuf_t *dst, sbuf_t *src, mspPostProcessFnPtr *mspPostProcessFn)
+{
+    // Large enough for any reply that fits in the minimum MSP_PORT_OUTBUF_SIZE
+    static uint8_t replyBuf[UINT8_MAX + 1];
+
+    mspPendingSubscriptionCount = 0;
+    while (sbufBytesRemaining(src) >= 3 && mspPendingSubscriptionCount < MSP_MAX_SUBSCRIPTIONS) {
+        const uint8_t cmdMSP = sbufReadU8(src);
+        const uint16_t periodMs = sbufReadU16(src);
+        sbuf_t reply = { .ptr = replyBuf, .end = ARRAYEND(replyBuf) };
+        mspPostProcessFnPtr outPostProcessFn = NULL;
+
+        if (periodMs == 0 || cmdMSP == MSP_SUBSCRIBE
+            || (!mspCommonProcessOutCommand(cmdMSP, &reply, &outPostProcessFn) && !mspProcessOutCommand(cmdMSP, &reply))
+            || outPostProcessFn) {
+            continue;
+        }
+
+        mspSubscription_t *subscription = &mspPendingSubscriptions[mspPendingSubscriptionCount++];
+        subscription->cmd = cmdMSP;
+        subscription->periodMs = MAX(periodMs, (uint16_t)MSP_SUBSCRIPTION_MIN_PERIOD_MS);
+        subscription->nextDueMs = 0;
+    }
+
+    sbufWriteU8(dst, mspPendingSubscriptionCount);
+    *mspPostProcessFn = mspFcSubscribeStart;
+}
+#endif
+
 #ifdef USE_OSD_SLAVE
 static mspResult_e mspProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
 {
@@ -1464,9 +1886,7 @@ static mspResult_e mspProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
                 return MSP_RESULT_ERROR;
             } else {
                 uint16_t frame[MAX_SUPPORTED_RC_CHANNEL_COUNT];
-                for (int i = 0; i < channelCount; i++) {
-                    frame[i] = sbufReadU16(src);
-                }
+                sbufReadU16Array(src, frame, channelCount);
                 rxMspFrameReceive(frame, channelCount);
             }
         }
@@ -1493,7 +1913,7 @@ static mspResult_e mspProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
             currentPidProfile->pid[i].I = sbufReadU8(src);
             currentPidProfile->pid[i].D = sbufReadU8(src);
         }
-        pidInitConfig(currentPidProfile);
+        pidPrepareProfile(currentPidProfile);
         break;
 
     case MSP_SET_MODE_RANGE:
@@ -1509,6 +1929,7 @@ static mspResult_e mspProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
                 mac->range.endStep = sbufReadU8(src);
 
                 useRcControlsConfig(currentPidProfile);
+                analyzeModeActivationConditions();
             } else {
                 return MSP_RESULT_ERROR;
             }
@@ -1701,6 +2122,10 @@ static mspResult_e mspProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
 
         break;
     case MSP_SET_FILTER_CONFIG:
+        // the gyro filters are only swapped while disarmed
+        if (ARMING_FLAG(ARMED)) {
+            return MSP_RESULT_ERROR;
+        }
         gyroConfigMutable()->gyro_lowpass_hz = sbufReadU8(src);
         currentPidProfile->dterm_lowpass_hz = sbufReadU16(src);
         currentPidProfile->yaw_lowpass_hz = sbufReadU16(src);
@@ -1726,11 +2151,11 @@ static mspResult_e mspProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
             gyroConfigMutable()->gyro_lowpass2_type = sbufReadU8(src);
             currentPidProfile->dterm_lowpass2_hz = sbufReadU16(src);
         }
-        // reinitialize the gyro filters with the new values
+        // take up the new values without resetting the filter states, the gyro and PID loops
+        // swap in the new filters at the start of their next run
         validateAndFixGyroConfig();
-        gyroInitFilters();
-        // reinitialize the PID filters with the new values
-        pidInitFilters(currentPidProfile);
+        gyroReconfigureFilters();
+        pidPrepareProfile(currentPidProfile);
 
         break;
     case MSP_SET_PID_ADVANCED:
@@ -1757,7 +2182,7 @@ static mspResult_e mspProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
         if (sbufBytesRemaining(src) >= 2) {
             currentPidProfile->dtermSetpointWeight = sbufReadU16(src);
         }
-        pidInitConfig(currentPidProfile);
+        pidPrepareProfile(currentPidProfile);
         break;
 
     case MSP_SET_SENSOR_CONFIG:
@@ -2086,6 +2511,25 @@ static mspResult_e mspProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
         }
         break;
 
+#ifdef USE_CONFIG_SNAPSHOT
+    case MSP_SET_CONFIG_SNAPSHOT:
+        // U16 offset and the part of the snapshot from it, until the last part applies the whole snapshot
+        if (ARMING_FLAG(ARMED) || sbufBytesRemaining(src) < 2) {
+            return MSP_RESULT_ERROR;
+        } else {
+            const int offset = sbufReadU16(src);
+            const configSnapshotImport_e result = importConfigSnapshot(offset, sbufPtr(src), sbufBytesRemaining(src));
+            if (result == CONFIG_SNAPSHOT_IMPORT_FAILED) {
+                return MSP_RESULT_ERROR;
+            }
+            if (result == CONFIG_SNAPSHOT_IMPORT_DONE) {
+                // the snapshot is in the EEPROM now, loading it activates all of it at once
+                readEEPROM();
+            }
+        }
+        break;
+#endif
+
 #ifdef USE_RTC_TIME
     case MSP_SET_RTC:
         {
@@ -2318,14 +2762,15 @@ static mspResult_e mspCommonProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
 
     case MSP_OSD_CHAR_WRITE:
 #ifdef USE_MAX7456
-        {
-            uint8_t font_data[64];
+        // One or more characters, each an address followed by its font data
+        if (sbufBytesRemaining(src) < 1 + MAX7456_NVM_CHAR_BYTES) {
+            return MSP_RESULT_ERROR;
+        }
+        while (sbufBytesRemaining(src) >= 1 + MAX7456_NVM_CHAR_BYTES) {
             const uint8_t addr = sbufReadU8(src);
-            for (int i = 0; i < 54; i++) {
-                font_data[i] = sbufReadU8(src);
-            }
             // !!TODO - replace this with a device independent implementation
-            max7456WriteNvm(addr, font_data);
+            max7456WriteNvm(addr, sbufPtr(src));
+            sbufAdvance(src, MAX7456_NVM_CHAR_BYTES);
         }
         break;
 #else
@@ -2339,6 +2784,31 @@ static mspResult_e mspCommonProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
     return MSP_RESULT_ACK;
 }
 
+/*
+ * The first of the command handlers below that handled each command ID, so that later requests for it go straight
+ * there instead of falling through every handler's switch before it.
+ */
+typedef enum {
+    MSP_DISPATCH_UNKNOWN = 0,
+    MSP_DISPATCH_COMMON_OUT,
+    MSP_DISPATCH_OUT,
+    MSP_DISPATCH_OUT_WITH_ARG,
+    MSP_DISPATCH_IN,
+} mspDispatchStage_e;
+
+static uint8_t mspDispatchStages[(UINT8_MAX + 1) / 2]; // one nibble per command ID
+
+static mspDispatchStage_e mspDispatchStageGet(uint8_t cmdMSP)
+{
+    return (mspDispatchStages[cmdMSP / 2] >> (cmdMSP % 2 * 4)) & 0x0F;
+}
+
+static void mspDispatchStageSet(uint8_t cmdMSP, mspDispatchStage_e stage)
+{
+    const int shift = cmdMSP % 2 * 4;
+    mspDispatchStages[cmdMSP / 2] = (mspDispatchStages[cmdMSP / 2] & ~(0x0F << shift)) | (stage << shift);
+}
+
 /*
  * Returns MSP_RESULT_ACK, MSP_RESULT_ERROR or MSP_RESULT_NO_REPLY
  */
@@ -2348,16 +2818,19 @@ mspResult_e mspFcProcessCommand(mspPacket_t *cmd, mspPacket_t *reply, mspPostPro
     sbuf_t *dst = &reply->buf;
     sbuf_t *src = &cmd->buf;
     const uint8_t cmdMSP = cmd->cmd;
+    const mspDispatchStage_e stage = mspDispatchStageGet(cmdMSP);
     // initialize reply by default
     reply->cmd = cmd->cmd;
 
-    if (mspCommonProcessOutCommand(cmdMSP, dst, mspPostProcessFn)) {
+    if (stage <= MSP_DISPATCH_COMMON_OUT && mspCommonProcessOutCommand(cmdMSP, dst, mspPostProcessFn)) {
+        mspDispatchStageSet(cmdMSP, MSP_DISPATCH_COMMON_OUT);
         ret = MSP_RESULT_ACK;
-    } else if (mspProcessOutCommand(cmdMSP, dst)) {
+    } else if (stage <= MSP_DISPATCH_OUT && mspProcessOutCommand(cmdMSP, dst)) {
+        mspDispatchStageSet(cmdMSP, MSP_DISPATCH_OUT);
         ret = MSP_RESULT_ACK;
 #ifndef USE_OSD_SLAVE
-    } else if ((ret = mspFcProcessOutCommandWithArg(cmdMSP, src, dst)) != MSP_RESULT_CMD_UNKNOWN) {
-        /* ret */;
+    } else if (stage <= MSP_DISPATCH_OUT_WITH_ARG && (ret = mspFcProcessOutCommandWithArg(cmdMSP, src, dst)) != MSP_RESULT_CMD_UNKNOWN) {
+        mspDispatchStageSet(cmdMSP, MSP_DISPATCH_OUT_WITH_ARG);
 #endif
 #ifdef USE_SERIAL_4WAY_BLHELI_INTERFACE
     } else if (cmdMSP == MSP_SET_4WAY_IF) {
@@ -2368,9 +2841,27 @@ mspResult_e mspFcProcessCommand(mspPacket_t *cmd, mspPacket_t *reply, mspPostPro
     } else if (cmdMSP == MSP_DATAFLASH_READ) {
         mspFcDataFlashReadCommand(dst, src);
         ret = MSP_RESULT_ACK;
+    } else if (cmdMSP == MSP_DATAFLASH_STREAM) {
+        mspFcDataflashStreamCommand(dst, src, mspPostProcessFn);
+        ret = MSP_RESULT_ACK;
+#endif
+#ifdef USE_MSP_MULTIPLE
+    } else if (cmdMSP == MSP_MULTIPLE) {
+        mspFcMultipleCommand(dst, src);
+        ret = MSP_RESULT_ACK;
+#endif
+#ifdef USE_MSP_SUBSCRIPTIONS
+    } else if (cmdMSP == MSP_SUBSCRIBE) {
+        mspFcSubscribeCommand(dst, src, mspPostProcessFn);
+        ret = MSP_RESULT_ACK;
 #endif
     } else {
         ret = mspCommonProcessInCommand(cmdMSP, src);
+        // Out handlers can decline a command at run time (e.g. MSP_ESC_SENSOR_DATA without the feature), which ends
+        // up here as an error, so only skip them for commands the in handlers actually accepted
+        if (ret != MSP_RESULT_ERROR) {
+            mspDispatchStageSet(cmdMSP, MSP_DISPATCH_IN);
+        }
     }
     reply->result = ret;
     return ret;
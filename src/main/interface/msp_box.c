@@ -139,10 +139,59 @@ void serializeBoxPermanentIdFn(sbuf_t *dst, const box_t *box)
     sbufWriteU8(dst, box->permanentId);
 }
 
+#ifdef USE_MSP_REPLY_CACHE
+// The box replies only change with the active boxes, so the last page of each is kept serialised
+// and the repeated requests of configurators are answered with a copy.
+#define BOX_NAME_REPLY_CACHE_SIZE   400 // longest 32 names with their separators
+#define BOX_ID_REPLY_CACHE_SIZE     32
+
+typedef struct boxReplyCache_s {
+    serializeBoxFn *serializeBox;
+    uint8_t *data;
+    uint16_t size;
+    uint16_t length;
+    int16_t page;                   // -1 if nothing is cached
+} boxReplyCache_t;
+
+static uint8_t boxNameReplyData[BOX_NAME_REPLY_CACHE_SIZE];
+static uint8_t boxIdReplyData[BOX_ID_REPLY_CACHE_SIZE];
+
+static boxReplyCache_t boxReplyCache[] = {
+    { serializeBoxNameFn, boxNameReplyData, sizeof(boxNameReplyData), 0, -1 },
+    { serializeBoxPermanentIdFn, boxIdReplyData, sizeof(boxIdReplyData), 0, -1 },
+};
+
+static boxReplyCache_t *boxReplyCacheFind(serializeBoxFn *serializeBox)
+{
+    for (unsigned i = 0; i < ARRAYLEN(boxReplyCache); i++) {
+        if (boxReplyCache[i].serializeBox == serializeBox) {
+            return &boxReplyCache[i];
+        }
+    }
+    return NULL;
+}
+
+static void boxReplyCacheInvalidate(void)
+{
+    for (unsigned i = 0; i < ARRAYLEN(boxReplyCache); i++) {
+        boxReplyCache[i].page = -1;
+    }
+}
+#endif
+
 // serialize 'page' of boxNames.
 // Each page contains at most 32 boxes
 void serializeBoxReply(sbuf_t *dst, int page, serializeBoxFn *serializeBox)
 {
+#ifdef USE_MSP_REPLY_CACHE
+    boxReplyCache_t *cache = boxReplyCacheFind(serializeBox);
+    if (cache && cache->page == page) {
+        sbufWriteData(dst, cache->data, cache->length);
+        return;
+    }
+    const uint8_t *replyStart = sbufPtr(dst);
+#endif
+
     unsigned boxIdx = 0;
     unsigned pageStart = page * 32;
     unsigned pageEnd = pageStart + 32;
@@ -154,6 +203,15 @@ void serializeBoxReply(sbuf_t *dst, int page, serializeBoxFn *serializeBox)
             boxIdx++;                 // count active boxes
         }
     }
+
+#ifdef USE_MSP_REPLY_CACHE
+    const int length = sbufPtr(dst) - replyStart;
+    if (cache && length <= cache->size) {
+        memcpy(cache->data, replyStart, length);
+        cache->length = length;
+        cache->page = page;
+    }
+#endif
 }
 
 void initActiveBoxIds(void)
@@ -315,6 +373,9 @@ void initActiveBoxIds(void)
             bitArrayClr(&ena, boxId);                 // this should not happen, but handle it gracefully
 
     activeBoxIds = ena;                               // set global variable
+#ifdef USE_MSP_REPLY_CACHE
+    boxReplyCacheInvalidate();
+#endif
 }
 
 // return state of given boxId box, handling ARM and FLIGHT_MODE
@@ -280,6 +280,22 @@
 #define MSP_GPS_CONFIG           132    //out message         GPS configuration
 #define MSP_COMPASS_CONFIG       133    //out message         Compass configuration
 #define MSP_ESC_SENSOR_DATA      134    //out message         Extra ESC data from 32-Bit ESCs (Temperature, RPM)
+#define MSP_TASK_HISTOGRAMS      135    //out message         Execution time and start latency histograms of a task
+#define MSP_SCHEDULER_TRACE      136    //out message         Most recent task runs recorded by the scheduler
+#define MSP_PROFILER             137    //out message         Cycle counts of the profiler probes in the PID loop
+#define MSP_MOTOR_TIMING         138    //out message         Gyro to motor output latency and output jitter histograms
+#define MSP_DATAFLASH_INDEX      139    //out message         Start, length and metadata of the logs on the dataflash chip
+#define MSP_DATAFLASH_STREAM     140    //out message         Push a range of the dataflash chip as a continuous run of frames
+#define MSP_BLACKBOX_STATS       141    //out message         Frames and bytes written and dropped by the blackbox device in the current log
+#define MSP_MULTIPLE             142    //out message         Replies to a list of out messages without arguments, in one frame
+#define MSP_SUBSCRIBE            143    //in message          Push out messages without arguments to this port at fixed rates
+#define MSP_CONFIG_SNAPSHOT      144    //out message         Part of the config as binary PG records, with versions and CRC
+#define MSP_RX_LINK_STATS        145    //out message         RX frame, error and frame interval counts of the last seconds, newest first
+#define MSP_OSD_CHAR_WRITE_STATUS 146   //out message         Font characters waiting to be programmed and programmed since boot
+#define MSP_STACK_USAGE          147    //out message         Stack size and peak use, per task and per interrupt handler
+#define MSP_CRASH_TRACE          148    //out message         Reset flags, hard fault registers and last task runs from before the last reset
+#define MSP_GYRO_SPECTRUM        149    //out message         Gyro noise spectrum of each axis from the dynamic notch analysis
+#define MSP_MOTOR_TIMING_TEST    151    //out message         Start the bench latency test, or its progress and stage latency histograms
 
 #define MSP_SET_RAW_RC           200    //in message          8 rc chan
 #define MSP_SET_RAW_GPS          201    //in message          fix, numsat, lat, lon, alt, speed
@@ -306,6 +322,7 @@
 #define MSP_SET_MOTOR_CONFIG     222    //out message         Motor configuration (min/max throttle, etc)
 #define MSP_SET_GPS_CONFIG       223    //out message         GPS configuration
 #define MSP_SET_COMPASS_CONFIG   224    //out message         Compass configuration
+#define MSP_SET_CONFIG_SNAPSHOT  225    //in message          Part of a config snapshot, applied once complete; save with MSP_EEPROM_WRITE
 
 // #define MSP_BIND                 240    //in message          no param
 // #define MSP_ALARMS               242
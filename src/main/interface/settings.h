@@ -66,6 +66,7 @@ typedef enum {
     TABLE_MOTOR_PWM_PROTOCOL,
     TABLE_RC_INTERPOLATION,
     TABLE_RC_INTERPOLATION_CHANNELS,
+    TABLE_RX_PPM_PWM_FILTER,
     TABLE_LOWPASS_TYPE,
     TABLE_DTERM_LOWPASS_TYPE,
     TABLE_FAILSAFE,
@@ -111,6 +112,9 @@ typedef enum {
     TABLE_RC_SMOOTHING_INPUT_TYPE,
     TABLE_RC_SMOOTHING_DERIVATIVE_TYPE,
 #endif // USE_RC_SMOOTHING_FILTER
+#ifdef USE_GYRO_DATA_ANALYSE
+    TABLE_DYN_NOTCH_ESTIMATOR,
+#endif
     LOOKUP_TABLE_COUNT
 } lookupTableIndex_e;
 
@@ -183,6 +187,9 @@ extern const lookupTableEntry_t lookupTables[];
 extern const uint16_t valueTableEntryCount;
 
 extern const clivalue_t valueTable[];
+#ifdef USE_CLI_SETTINGS_INDEX
+extern uint16_t valueTableNameIndex[]; // valueTableEntryCount entries, filled in by the CLI
+#endif
 //extern const uint8_t lookupTablesEntryCount;
 
 extern const char * const lookupTableGyroHardware[];
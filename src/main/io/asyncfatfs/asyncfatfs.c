@@ -58,7 +58,10 @@
     #define ONLY_EXPOSE_FOR_TESTING static
 #endif
 
+// Targets with RAM to spare can define a larger cache to ride out the card's write latency spikes
+#ifndef AFATFS_NUM_CACHE_SECTORS
 #define AFATFS_NUM_CACHE_SECTORS 8
+#endif
 
 // FAT filesystems are allowed to differ from these parameters, but we choose not to support those weird filesystems:
 #define AFATFS_SECTOR_SIZE  512
@@ -113,6 +116,16 @@
 // Filename in 8.3 format:
 #define AFATFS_FREESPACE_FILENAME "FREESPAC.E"
 
+/*
+ * Remember which FAT sectors have no free clusters left (one bit per FAT sector), so searches for free space can skip
+ * them without reading them. The map is filled in as FAT sectors pass through a search, which includes the whole FAT
+ * on the first mount of a card while the freefile is being placed. 8192 sectors covers a 32GB card with 32kB clusters,
+ * FAT sectors beyond the map are always read.
+ */
+#if !defined(AFATFS_FULL_FAT_SECTOR_MAP_SIZE) && (defined(STM32F4) || defined(STM32F7))
+#define AFATFS_FULL_FAT_SECTOR_MAP_SIZE 8192
+#endif
+
 #define AFATFS_INTROSPEC_LOG_FILENAME "ASYNCFAT.LOG"
 
 typedef enum {
@@ -420,6 +433,9 @@ typedef struct afatfsFile_t {
 
     // State for a queued operation on the file
     struct afatfsFileOperation_t operation;
+
+    // A supercluster append that writes carried on into failed, the data past it has nowhere to go
+    bool appendFailed;
 } afatfsFile_t;
 
 typedef enum {
@@ -466,6 +482,10 @@ typedef struct afatfs_t {
 
     afatfsFile_t openFiles[AFATFS_MAX_OPEN_FILES];
 
+#ifdef AFATFS_FULL_FAT_SECTOR_MAP_SIZE
+    uint32_t fullFATSectorMap[AFATFS_FULL_FAT_SECTOR_MAP_SIZE / 32];
+#endif
+
 #ifdef AFATFS_USE_FREEFILE
     afatfsFile_t freeFile;
 #endif
@@ -507,7 +527,7 @@ typedef struct afatfs_t {
     uint32_t rootDirectorySectors; // Zero on FAT32, for FAT16 the number of sectors that the root directory occupies
 } afatfs_t;
 
-static afatfs_t afatfs;
+static DMA_RAM afatfs_t afatfs;
 
 static void afatfs_fileOperationContinue(afatfsFile_t *file);
 static uint8_t* afatfs_fileLockCursorSectorForWrite(afatfsFilePtr_t file);
@@ -556,6 +576,21 @@ static bool afatfs_fileIsBusy(afatfsFilePtr_t file)
     return file->operation.operation != AFATFS_FILE_OPERATION_NONE;
 }
 
+/**
+ * The clusters of a contiguous file are found without reading the FAT, so writes can carry on into a freshly appended
+ * supercluster while its FAT entries and directory entries are still being saved.
+ */
+static bool afatfs_fileIsBusyForWrite(afatfsFilePtr_t file)
+{
+#ifdef AFATFS_USE_FREEFILE
+    if (file->operation.operation == AFATFS_FILE_OPERATION_APPEND_SUPERCLUSTER) {
+        return false;
+    }
+#endif
+
+    return afatfs_fileIsBusy(file);
+}
+
 /**
  * The number of FAT table entries that fit within one AFATFS sector size.
  *
@@ -1086,6 +1121,44 @@ static void afatfs_getFATPositionForCluster(uint32_t cluster, uint32_t *fatSecto
     }
 }
 
+#ifdef AFATFS_FULL_FAT_SECTOR_MAP_SIZE
+
+static bool afatfs_FATSectorIsKnownFull(uint32_t fatSectorIndex)
+{
+    return fatSectorIndex < AFATFS_FULL_FAT_SECTOR_MAP_SIZE
+        && (afatfs.fullFATSectorMap[fatSectorIndex / 32] & (1U << (fatSectorIndex % 32))) != 0;
+}
+
+static void afatfs_FATSectorMarkFull(uint32_t fatSectorIndex, bool full)
+{
+    if (fatSectorIndex < AFATFS_FULL_FAT_SECTOR_MAP_SIZE) {
+        if (full) {
+            afatfs.fullFATSectorMap[fatSectorIndex / 32] |= 1U << (fatSectorIndex % 32);
+        } else {
+            afatfs.fullFATSectorMap[fatSectorIndex / 32] &= ~(1U << (fatSectorIndex % 32));
+        }
+    }
+}
+
+/**
+ * Record whether the given FAT sector, which has just been read, has any free cluster in it.
+ */
+static void afatfs_FATSectorUpdateFull(uint32_t fatSectorIndex, afatfsFATSector_t sector)
+{
+    const uint32_t fatEntriesPerSector = afatfs_fatEntriesPerSector();
+    bool full = true;
+
+    for (uint32_t i = 0; i < fatEntriesPerSector && full; i++) {
+        const uint32_t clusterNumber = afatfs.filesystemType == FAT_FILESYSTEM_TYPE_FAT16 ? sector.fat16[i] : fat32_decodeClusterNumber(sector.fat32[i]);
+
+        full = !fat_isFreeSpace(clusterNumber);
+    }
+
+    afatfs_FATSectorMarkFull(fatSectorIndex, full);
+}
+
+#endif
+
 static bool afatfs_FATIsEndOfChainMarker(uint32_t clusterNumber)
 {
     if (afatfs.filesystemType == FAT_FILESYSTEM_TYPE_FAT32) {
@@ -1158,6 +1231,12 @@ static afatfsOperationStatus_e afatfs_FATSetNextCluster(uint32_t startCluster, u
         } else {
             sector.fat32[fatSectorEntryIndex] = nextCluster;
         }
+
+#ifdef AFATFS_FULL_FAT_SECTOR_MAP_SIZE
+        if (fat_isFreeSpace(nextCluster)) {
+            afatfs_FATSectorMarkFull(fatSectorIndex, false);
+        }
+#endif
     }
 
     return result;
@@ -1243,14 +1322,28 @@ static afatfsFindClusterStatus_e afatfs_findClusterWithCondition(afatfsClusterSe
 
             // Maintain alignment
             *cluster = roundUpTo(*cluster, jump);
+            afatfs_getFATPositionForCluster(*cluster, &fatSectorIndex, &fatSectorEntryIndex);
             continue; // Go back to check that the new cluster number is within the volume
         }
 #endif
 
+#ifdef AFATFS_FULL_FAT_SECTOR_MAP_SIZE
+        // Nothing free in this FAT sector last time we looked, skip over it without reading it
+        if (lookingForFree && afatfs_FATSectorIsKnownFull(fatSectorIndex)) {
+            *cluster += fatEntriesPerSector - fatSectorEntryIndex;
+            fatSectorIndex++;
+            fatSectorEntryIndex = 0;
+            continue;
+        }
+#endif
+
         afatfsOperationStatus_e status = afatfs_cacheSector(afatfs_fatSectorToPhysical(0, fatSectorIndex), &sector.bytes, AFATFS_CACHE_READ | AFATFS_CACHE_DISCARDABLE, 0);
 
         switch (status) {
             case AFATFS_OPERATION_SUCCESS:
+#ifdef AFATFS_FULL_FAT_SECTOR_MAP_SIZE
+                afatfs_FATSectorUpdateFull(fatSectorIndex, sector);
+#endif
                 do {
                     uint32_t clusterNumber;
 
@@ -1420,6 +1513,10 @@ static afatfsOperationStatus_e afatfs_FATFillWithPattern(afatfsFATPattern_e patt
 
                 memset(sector.bytes + firstEntryIndex * fatEntrySize, 0, (lastEntryIndex - firstEntryIndex) * fatEntrySize);
 
+#ifdef AFATFS_FULL_FAT_SECTOR_MAP_SIZE
+                afatfs_FATSectorMarkFull(fatPhysicalSector - afatfs_fatSectorToPhysical(0, 0), false);
+#endif
+
                 *startCluster += lastEntryIndex - firstEntryIndex;
             break;
         }
@@ -1725,6 +1822,8 @@ static afatfsOperationStatus_e afatfs_appendSuperclusterContinue(afatfsFile_t *f
 
     if ((status == AFATFS_OPERATION_FAILURE || status == AFATFS_OPERATION_SUCCESS) && file->operation.operation == AFATFS_FILE_OPERATION_APPEND_SUPERCLUSTER) {
         file->operation.operation = AFATFS_FILE_OPERATION_NONE;
+        // fwrite() does not wait for the append, so it has to be told to stop
+        file->appendFailed = status == AFATFS_OPERATION_FAILURE;
     }
 
     return status;
@@ -3062,6 +3161,7 @@ void afatfs_fputc(afatfsFilePtr_t file, uint8_t c)
  *
  * 0 will be returned when:
  *     The filesystem is busy (try again later)
+ *     A supercluster append failed after writes had carried on past it (the filesystem is in its fatal state)
  *
  * Fewer bytes will be written than requested when:
  *     The write spanned a sector boundary and the next sector's contents/location was not yet available in the cache.
@@ -3073,11 +3173,15 @@ uint32_t afatfs_fwrite(afatfsFilePtr_t file, const uint8_t *buffer, uint32_t len
         return 0;
     }
 
-    if (afatfs_fileIsBusy(file)) {
+    if (afatfs_fileIsBusyForWrite(file)) {
         // There might be a seek pending
         return 0;
     }
 
+    if (file->appendFailed) {
+        return 0;
+    }
+
     uint32_t cursorOffsetInSector = file->cursorOffset % AFATFS_SECTOR_SIZE;
     uint32_t writtenBytes = 0;
 
@@ -3093,18 +3197,24 @@ uint32_t afatfs_fwrite(afatfsFilePtr_t file, const uint8_t *buffer, uint32_t len
 
         memcpy(sectorBuffer + cursorOffsetInSector, buffer, bytesToWriteThisSector);
 
-        writtenBytes += bytesToWriteThisSector;
-
         /*
          * If the seek doesn't complete immediately then we'll break and wait for that seek to complete by waiting for
          * the file to be non-busy on entry again.
          *
-         * A seek operation should always be able to queue on the file since we have checked that the file wasn't busy
-         * on entry (fseek will never return AFATFS_OPERATION_FAILURE).
+         * The seek can only fail to queue while a supercluster append is still pending on the file. The cursor
+         * didn't move then, so those bytes are not counted as written and the caller hands them to us again.
          *
          * If the seek has to queue, when the seek completes, it'll update the fileSize for us to contain the cursor.
          */
-        if (afatfs_fseekInternal(file, bytesToWriteThisSector, NULL) == AFATFS_OPERATION_IN_PROGRESS) {
+        const afatfsOperationStatus_e seekStatus = afatfs_fseekInternal(file, bytesToWriteThisSector, NULL);
+
+        if (seekStatus == AFATFS_OPERATION_FAILURE) {
+            break;
+        }
+
+        writtenBytes += bytesToWriteThisSector;
+
+        if (seekStatus == AFATFS_OPERATION_IN_PROGRESS) {
             break;
         }
 
@@ -48,6 +48,8 @@
 
 #include "pg/beeper.h"
 
+#include "scheduler/scheduler.h"
+
 #include "sensors/battery.h"
 #include "sensors/sensors.h"
 
@@ -226,6 +228,9 @@ static const beeperTableEntry_t beeperTable[] = {
 };
 
 static const beeperTableEntry_t *currentBeeperEntry = NULL;
+#ifdef USE_PREEMPTIVE_PID_LOOP
+static volatile uint32_t beeperDeferredModes;   // BEEPER_GET_FLAG() of the beeps asked for by the PID loop
+#endif
 
 #define BEEPER_TABLE_ENTRY_COUNT (sizeof(beeperTable) / sizeof(beeperTableEntry_t))
 
@@ -235,6 +240,15 @@ static const beeperTableEntry_t *currentBeeperEntry = NULL;
  */
 void beeper(beeperMode_e mode)
 {
+#ifdef USE_PREEMPTIVE_PID_LOOP
+    if (schedulerInInterruptTask()) {
+        // a preemptive PID loop must not switch the sequence under beeperUpdate(), which starts the beep instead
+        if (mode != BEEPER_SILENCE) {
+            __atomic_fetch_or(&beeperDeferredModes, BEEPER_GET_FLAG(mode), __ATOMIC_RELAXED);
+        }
+        return;
+    }
+#endif
     if (
         mode == BEEPER_SILENCE || (
             (beeperConfigMutable()->beeper_off_flags & BEEPER_GET_FLAG(BEEPER_USB))
@@ -374,6 +388,16 @@ static void beeperGpsStatus(void)
  */
 void beeperUpdate(timeUs_t currentTimeUs)
 {
+#ifdef USE_PREEMPTIVE_PID_LOOP
+    uint32_t deferredModes = __atomic_exchange_n(&beeperDeferredModes, 0, __ATOMIC_RELAXED);
+    for (beeperMode_e mode = BEEPER_SILENCE + 1; deferredModes && mode < BEEPER_ALL; mode++) {
+        if (deferredModes & BEEPER_GET_FLAG(mode)) {
+            deferredModes &= ~BEEPER_GET_FLAG(mode);
+            beeper(mode);
+        }
+    }
+#endif
+
     // If beeper option from AUX switch has been selected
     if (IS_RC_MODE_ACTIVE(BOXBEEPERON)) {
         beeper(BEEPER_RX_SET);
@@ -400,7 +424,8 @@ void beeperUpdate(timeUs_t currentTimeUs)
             && ((currentBeeperEntry->mode == BEEPER_RX_SET && !(beeperConfig()->dshotBeaconOffFlags & BEEPER_GET_FLAG(BEEPER_RX_SET)))
             || (currentBeeperEntry->mode == BEEPER_RX_LOST && !(beeperConfig()->dshotBeaconOffFlags & BEEPER_GET_FLAG(BEEPER_RX_LOST))))) {
 
-            if ((currentTimeUs - getLastDisarmTimeUs() > DSHOT_BEACON_GUARD_DELAY_US) && !isTryingToArm()) {
+            // beacons repeat, so don't let them pile up behind a pending command
+            if ((currentTimeUs - getLastDisarmTimeUs() > DSHOT_BEACON_GUARD_DELAY_US) && !isTryingToArm() && !pwmDshotCommandIsQueued()) {
                 lastDshotBeaconCommandTimeUs = currentTimeUs;
                 pwmWriteDshotCommand(ALL_MOTORS, getMotorCount(), beeperConfig()->dshotBeaconTone, false);
             }
@@ -125,14 +125,92 @@ typedef struct pageState_s {
 
 static pageState_t pageState;
 
+// The pages draw into a character frame buffer. Only the part of a row between its first and last
+// cell that differs from what the display shows is sent, rows that have not changed are not sent at all.
+static uint8_t screenBuffer[SCREEN_CHARACTER_ROW_COUNT][SCREEN_CHARACTER_COLUMN_COUNT];
+static uint8_t screenDisplayed[SCREEN_CHARACTER_ROW_COUNT][SCREEN_CHARACTER_COLUMN_COUNT];
+static uint8_t screenDirtyRows;     // a bit per row that has been changed since the last flush
+static uint8_t cursorColumn;
+static uint8_t cursorRow;
+
+STATIC_ASSERT(SCREEN_CHARACTER_ROW_COUNT <= 8, dashboard_dirty_rows_overflow);
+
 static void resetDisplay(void)
 {
     dashboardPresent = ug2864hsweg01InitI2C(bus);
 }
 
+static void dashboardSetXY(uint8_t column, uint8_t row)
+{
+    cursorColumn = column;
+    cursorRow = row;
+}
+
+static void dashboardSetLine(uint8_t row)
+{
+    dashboardSetXY(0, row);
+}
+
+static void dashboardPrintChar(uint8_t c)
+{
+    if (cursorRow < SCREEN_CHARACTER_ROW_COUNT && cursorColumn < SCREEN_CHARACTER_COLUMN_COUNT
+        && screenBuffer[cursorRow][cursorColumn] != c) {
+        screenBuffer[cursorRow][cursorColumn] = c;
+        screenDirtyRows |= 1 << cursorRow;
+    }
+    cursorColumn++;
+}
+
+static void dashboardPrintString(const char *string)
+{
+    while (*string) {
+        dashboardPrintChar(*string++);
+    }
+}
+
+// the display has just been cleared
+static void clearScreenBuffer(void)
+{
+    memset(screenBuffer, ' ', sizeof(screenBuffer));
+    memset(screenDisplayed, ' ', sizeof(screenDisplayed));
+    screenDirtyRows = 0;
+}
+
+static void flushScreenBuffer(void)
+{
+    char run[SCREEN_CHARACTER_COLUMN_COUNT + 1];
+
+    for (uint8_t row = 0; screenDirtyRows; row++) {
+        if (!(screenDirtyRows & (1 << row))) {
+            continue;
+        }
+        screenDirtyRows &= ~(1 << row);
+
+        int first = 0;
+        while (first < SCREEN_CHARACTER_COLUMN_COUNT && screenBuffer[row][first] == screenDisplayed[row][first]) {
+            first++;
+        }
+        if (first == SCREEN_CHARACTER_COLUMN_COUNT) {
+            continue;
+        }
+        int last = SCREEN_CHARACTER_COLUMN_COUNT - 1;
+        while (screenBuffer[row][last] == screenDisplayed[row][last]) {
+            last--;
+        }
+
+        const int length = last - first + 1;
+        memcpy(run, &screenBuffer[row][first], length);
+        run[length] = 0;
+        memcpy(&screenDisplayed[row][first], &screenBuffer[row][first], length);
+
+        i2c_OLED_set_xy(bus, first, row);
+        i2c_OLED_send_string(bus, run);
+    }
+}
+
 void LCDprint(uint8_t i)
 {
-   i2c_OLED_send_char(bus, i);
+   dashboardPrintChar(i);
 }
 
 static void padLineBuffer(void)
@@ -181,8 +259,8 @@ static void fillScreenWithCharacters(void)
 {
     for (uint8_t row = 0; row < SCREEN_CHARACTER_ROW_COUNT; row++) {
         for (uint8_t column = 0; column < SCREEN_CHARACTER_COLUMN_COUNT; column++) {
-            i2c_OLED_set_xy(bus, column, row);
-            i2c_OLED_send_char(bus, 'A' + column);
+            dashboardSetXY(column, row);
+            dashboardPrintChar('A' + column);
         }
     }
 }
@@ -192,22 +270,22 @@ static void fillScreenWithCharacters(void)
 static void updateTicker(void)
 {
     static uint8_t tickerIndex = 0;
-    i2c_OLED_set_xy(bus, SCREEN_CHARACTER_COLUMN_COUNT - 1, 0);
-    i2c_OLED_send_char(bus, tickerCharacters[tickerIndex]);
+    dashboardSetXY(SCREEN_CHARACTER_COLUMN_COUNT - 1, 0);
+    dashboardPrintChar(tickerCharacters[tickerIndex]);
     tickerIndex++;
     tickerIndex = tickerIndex % TICKER_CHARACTER_COUNT;
 }
 
 static void updateRxStatus(void)
 {
-    i2c_OLED_set_xy(bus, SCREEN_CHARACTER_COLUMN_COUNT - 2, 0);
+    dashboardSetXY(SCREEN_CHARACTER_COLUMN_COUNT - 2, 0);
     char rxStatus = '!';
     if (rxIsReceivingSignal()) {
         rxStatus = 'r';
     } if (rxAreFlightChannelsValid()) {
         rxStatus = 'R';
     }
-    i2c_OLED_send_char(bus, rxStatus);
+    dashboardPrintChar(rxStatus);
 }
 
 static void updateFailsafeStatus(void)
@@ -236,19 +314,20 @@ static void updateFailsafeStatus(void)
         failsafeIndicator = 'G';
         break;
     }
-    i2c_OLED_set_xy(bus, SCREEN_CHARACTER_COLUMN_COUNT - 3, 0);
-    i2c_OLED_send_char(bus, failsafeIndicator);
+    dashboardSetXY(SCREEN_CHARACTER_COLUMN_COUNT - 3, 0);
+    dashboardPrintChar(failsafeIndicator);
 }
 
 static void showTitle(void)
 {
-    i2c_OLED_set_line(bus, 0);
-    i2c_OLED_send_string(bus, pageState.page->title);
+    dashboardSetLine(0);
+    dashboardPrintString(pageState.page->title);
 }
 
 static void handlePageChange(void)
 {
     i2c_OLED_clear_display_quick(bus);
+    clearScreenBuffer();
     showTitle();
 }
 
@@ -264,7 +343,7 @@ static void drawRxChannel(uint8_t channelIndex, uint8_t width)
 static void showRxPage(void)
 {
     for (int channelIndex = 0; channelIndex < rxRuntimeConfig.channelCount && channelIndex < RX_CHANNELS_PER_PAGE_COUNT; channelIndex += 2) {
-        i2c_OLED_set_line(bus, (channelIndex / 2) + PAGE_TITLE_LINE_COUNT);
+        dashboardSetLine((channelIndex / 2) + PAGE_TITLE_LINE_COUNT);
 
         drawRxChannel(channelIndex, HALF_SCREEN_CHARACTER_COLUMN_COUNT);
 
@@ -285,11 +364,11 @@ static void showWelcomePage(void)
     uint8_t rowIndex = PAGE_TITLE_LINE_COUNT;
 
     tfp_sprintf(lineBuffer, "v%s (%s)", FC_VERSION_STRING, shortGitRevision);
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(lineBuffer);
 
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, targetName);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(targetName);
 }
 
 static void showArmedPage(void)
@@ -301,8 +380,8 @@ static void showProfilePage(void)
     uint8_t rowIndex = PAGE_TITLE_LINE_COUNT;
 
     tfp_sprintf(lineBuffer, "Profile: %d", getCurrentPidProfileIndex());
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(lineBuffer);
 
     static const char* const axisTitles[3] = {"ROL", "PIT", "YAW"};
     const pidProfile_t *pidProfile = currentPidProfile;
@@ -314,14 +393,14 @@ static void showProfilePage(void)
             pidProfile->pid[axis].D
         );
         padLineBuffer();
-        i2c_OLED_set_line(bus, rowIndex++);
-        i2c_OLED_send_string(bus, lineBuffer);
+        dashboardSetLine(rowIndex++);
+        dashboardPrintString(lineBuffer);
     }
 
     const uint8_t currentRateProfileIndex = getCurrentControlRateProfileIndex();
     tfp_sprintf(lineBuffer, "Rate profile: %d", currentRateProfileIndex);
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(lineBuffer);
 
     const controlRateConfig_t *controlRateConfig = controlRateProfiles(currentRateProfileIndex);
     tfp_sprintf(lineBuffer, "RRr:%d PRR:%d YRR:%d",
@@ -330,8 +409,8 @@ static void showProfilePage(void)
         controlRateConfig->rcRates[FD_YAW]
     );
     padLineBuffer();
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(lineBuffer);
 
     tfp_sprintf(lineBuffer, "RE:%d PE:%d YE:%d",
         controlRateConfig->rcExpo[FD_ROLL],
@@ -339,8 +418,8 @@ static void showProfilePage(void)
         controlRateConfig->rcExpo[FD_YAW]
     );
     padLineBuffer();
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(lineBuffer);
 
     tfp_sprintf(lineBuffer, "RR:%d PR:%d YR:%d",
         controlRateConfig->rates[FD_ROLL],
@@ -348,8 +427,8 @@ static void showProfilePage(void)
         controlRateConfig->rates[FD_YAW]
     );
     padLineBuffer();
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(lineBuffer);
 }
 #define SATELLITE_COUNT (sizeof(GPS_svinfo_cno) / sizeof(GPS_svinfo_cno[0]))
 #define SATELLITE_GRAPH_LEFT_OFFSET ((SCREEN_CHARACTER_COLUMN_COUNT - SATELLITE_COUNT) / 2)
@@ -372,64 +451,64 @@ static void showGpsPage(void)
         gpsTicker = gpsTicker % TICKER_CHARACTER_COUNT;
     }
 
-    i2c_OLED_set_xy(bus, 0, rowIndex);
-    i2c_OLED_send_char(bus, tickerCharacters[gpsTicker]);
+    dashboardSetXY(0, rowIndex);
+    dashboardPrintChar(tickerCharacters[gpsTicker]);
 
-    i2c_OLED_set_xy(bus, MAX(0, (uint8_t)SATELLITE_GRAPH_LEFT_OFFSET), rowIndex++);
+    dashboardSetXY(MAX(0, (uint8_t)SATELLITE_GRAPH_LEFT_OFFSET), rowIndex++);
 
     uint32_t index;
     for (index = 0; index < SATELLITE_COUNT && index < SCREEN_CHARACTER_COLUMN_COUNT; index++) {
         uint8_t bargraphOffset = ((uint16_t) GPS_svinfo_cno[index] * VERTICAL_BARGRAPH_CHARACTER_COUNT) / (GPS_DBHZ_MAX - 1);
         bargraphOffset = MIN(bargraphOffset, VERTICAL_BARGRAPH_CHARACTER_COUNT - 1);
-        i2c_OLED_send_char(bus, VERTICAL_BARGRAPH_ZERO_CHARACTER + bargraphOffset);
+        dashboardPrintChar(VERTICAL_BARGRAPH_ZERO_CHARACTER + bargraphOffset);
     }
 
 
     char fixChar = STATE(GPS_FIX) ? 'Y' : 'N';
     tfp_sprintf(lineBuffer, "Sats: %d Fix: %c", gpsSol.numSat, fixChar);
     padLineBuffer();
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(lineBuffer);
 
     tfp_sprintf(lineBuffer, "La/Lo: %d/%d", gpsSol.llh.lat / GPS_DEGREES_DIVIDER, gpsSol.llh.lon / GPS_DEGREES_DIVIDER);
     padLineBuffer();
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(lineBuffer);
 
     tfp_sprintf(lineBuffer, "Spd: %d", gpsSol.groundSpeed);
     padHalfLineBuffer();
-    i2c_OLED_set_line(bus, rowIndex);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex);
+    dashboardPrintString(lineBuffer);
 
     tfp_sprintf(lineBuffer, "GC: %d", gpsSol.groundCourse);
     padHalfLineBuffer();
-    i2c_OLED_set_xy(bus, HALF_SCREEN_CHARACTER_COLUMN_COUNT, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetXY(HALF_SCREEN_CHARACTER_COLUMN_COUNT, rowIndex++);
+    dashboardPrintString(lineBuffer);
 
     tfp_sprintf(lineBuffer, "RX: %d", GPS_packetCount);
     padHalfLineBuffer();
-    i2c_OLED_set_line(bus, rowIndex);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex);
+    dashboardPrintString(lineBuffer);
 
     tfp_sprintf(lineBuffer, "ERRs: %d", gpsData.errors, gpsData.timeouts);
     padHalfLineBuffer();
-    i2c_OLED_set_xy(bus, HALF_SCREEN_CHARACTER_COLUMN_COUNT, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetXY(HALF_SCREEN_CHARACTER_COLUMN_COUNT, rowIndex++);
+    dashboardPrintString(lineBuffer);
 
     tfp_sprintf(lineBuffer, "Dt: %d", gpsData.lastMessage - gpsData.lastLastMessage);
     padHalfLineBuffer();
-    i2c_OLED_set_line(bus, rowIndex);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex);
+    dashboardPrintString(lineBuffer);
 
     tfp_sprintf(lineBuffer, "TOs: %d", gpsData.timeouts);
     padHalfLineBuffer();
-    i2c_OLED_set_xy(bus, HALF_SCREEN_CHARACTER_COLUMN_COUNT, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetXY(HALF_SCREEN_CHARACTER_COLUMN_COUNT, rowIndex++);
+    dashboardPrintString(lineBuffer);
 
     strncpy(lineBuffer, gpsPacketLog, GPS_PACKET_LOG_ENTRY_COUNT);
     padHalfLineBuffer();
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(lineBuffer);
 }
 #endif
 
@@ -440,11 +519,11 @@ static void showBatteryPage(void)
     if (batteryConfig()->voltageMeterSource != VOLTAGE_METER_NONE) {
         tfp_sprintf(lineBuffer, "Volts: %d.%1d Cells: %d", getBatteryVoltage() / 10, getBatteryVoltage() % 10, getBatteryCellCount());
         padLineBuffer();
-        i2c_OLED_set_line(bus, rowIndex++);
-        i2c_OLED_send_string(bus, lineBuffer);
+        dashboardSetLine(rowIndex++);
+        dashboardPrintString(lineBuffer);
 
         uint8_t batteryPercentage = calculateBatteryPercentageRemaining();
-        i2c_OLED_set_line(bus, rowIndex++);
+        dashboardSetLine(rowIndex++);
         drawHorizonalPercentageBar(SCREEN_CHARACTER_COLUMN_COUNT, batteryPercentage);
     }
 
@@ -453,11 +532,11 @@ static void showBatteryPage(void)
         int32_t amperage = getAmperage();
         tfp_sprintf(lineBuffer, "Amps: %d.%2d mAh: %d", amperage / 100, amperage % 100, getMAhDrawn());
         padLineBuffer();
-        i2c_OLED_set_line(bus, rowIndex++);
-        i2c_OLED_send_string(bus, lineBuffer);
+        dashboardSetLine(rowIndex++);
+        dashboardPrintString(lineBuffer);
 
         uint8_t capacityPercentage = calculateBatteryPercentageRemaining();
-        i2c_OLED_set_line(bus, rowIndex++);
+        dashboardSetLine(rowIndex++);
         drawHorizonalPercentageBar(SCREEN_CHARACTER_COLUMN_COUNT, capacityPercentage);
     }
 }
@@ -467,36 +546,36 @@ static void showSensorsPage(void)
     uint8_t rowIndex = PAGE_TITLE_LINE_COUNT;
     static const char *format = "%s %5d %5d %5d";
 
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, "        X     Y     Z");
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString("        X     Y     Z");
 
     if (sensors(SENSOR_ACC)) {
         tfp_sprintf(lineBuffer, format, "ACC", lrintf(acc.accADC[X]), lrintf(acc.accADC[Y]), lrintf(acc.accADC[Z]));
         padLineBuffer();
-        i2c_OLED_set_line(bus, rowIndex++);
-        i2c_OLED_send_string(bus, lineBuffer);
+        dashboardSetLine(rowIndex++);
+        dashboardPrintString(lineBuffer);
     }
 
     if (sensors(SENSOR_GYRO)) {
         tfp_sprintf(lineBuffer, format, "GYR", lrintf(gyro.gyroADCf[X]), lrintf(gyro.gyroADCf[Y]), lrintf(gyro.gyroADCf[Z]));
         padLineBuffer();
-        i2c_OLED_set_line(bus, rowIndex++);
-        i2c_OLED_send_string(bus, lineBuffer);
+        dashboardSetLine(rowIndex++);
+        dashboardPrintString(lineBuffer);
     }
 
 #ifdef USE_MAG
     if (sensors(SENSOR_MAG)) {
         tfp_sprintf(lineBuffer, format, "MAG", lrintf(mag.magADC[X]), lrintf(mag.magADC[Y]), lrintf(mag.magADC[Z]));
         padLineBuffer();
-        i2c_OLED_set_line(bus, rowIndex++);
-        i2c_OLED_send_string(bus, lineBuffer);
+        dashboardSetLine(rowIndex++);
+        dashboardPrintString(lineBuffer);
     }
 #endif
 
-    tfp_sprintf(lineBuffer, format, "I&H", attitude.values.roll, attitude.values.pitch, DECIDEGREES_TO_DEGREES(attitude.values.yaw));
+    tfp_sprintf(lineBuffer, format, "I&H", getAttitude()->values.roll, getAttitude()->values.pitch, DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw));
     padLineBuffer();
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(lineBuffer);
 
     /*
     uint8_t length;
@@ -509,8 +588,8 @@ static void showSensorsPage(void)
     }
     ftoa(EstG.A[Y], lineBuffer + length);
     padLineBuffer();
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(lineBuffer);
 
     ftoa(EstG.A[Z], lineBuffer);
     length = strlen(lineBuffer);
@@ -520,8 +599,8 @@ static void showSensorsPage(void)
     }
     ftoa(smallAngle, lineBuffer + length);
     padLineBuffer();
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, lineBuffer);
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString(lineBuffer);
     */
 
 }
@@ -532,8 +611,8 @@ static void showTasksPage(void)
     uint8_t rowIndex = PAGE_TITLE_LINE_COUNT;
     static const char *format = "%2d%6d%5d%4d%4d";
 
-    i2c_OLED_set_line(bus, rowIndex++);
-    i2c_OLED_send_string(bus, "Task max  avg mx% av%");
+    dashboardSetLine(rowIndex++);
+    dashboardPrintString("Task max  avg mx% av%");
     cfTaskInfo_t taskInfo;
     for (cfTaskId_e taskId = 0; taskId < TASK_COUNT; ++taskId) {
         getTaskInfo(taskId, &taskInfo);
@@ -543,8 +622,8 @@ static void showTasksPage(void)
             const int averageLoad = (taskInfo.averageExecutionTime * taskFrequency + 5000) / 10000;
             tfp_sprintf(lineBuffer, format, taskId, taskInfo.maxExecutionTime, taskInfo.averageExecutionTime, maxLoad, averageLoad);
             padLineBuffer();
-            i2c_OLED_set_line(bus, rowIndex++);
-            i2c_OLED_send_string(bus, lineBuffer);
+            dashboardSetLine(rowIndex++);
+            dashboardPrintString(lineBuffer);
             if (rowIndex > SCREEN_CHARACTER_ROW_COUNT) {
                 break;
             }
@@ -560,8 +639,8 @@ static void showDebugPage(void)
     for (int rowIndex = 0; rowIndex < 4; rowIndex++) {
         tfp_sprintf(lineBuffer, "%d = %5d", rowIndex, debug[rowIndex]);
         padLineBuffer();
-        i2c_OLED_set_line(bus, rowIndex + PAGE_TITLE_LINE_COUNT);
-        i2c_OLED_send_string(bus, lineBuffer);
+        dashboardSetLine(rowIndex + PAGE_TITLE_LINE_COUNT);
+        dashboardPrintString(lineBuffer);
     }
 }
 #endif
@@ -601,9 +680,17 @@ void dashboardUpdate(timeUs_t currentTimeUs)
     static uint8_t previousArmedState = 0;
 
 #ifdef USE_CMS
+    static bool displayWasGrabbed = false;
+
     if (displayIsGrabbed(displayPort)) {
+        displayWasGrabbed = true;
         return;
     }
+    if (displayWasGrabbed) {
+        // the CMS has drawn over the page, the frame buffer no longer matches the display
+        displayWasGrabbed = false;
+        pageState.pageFlags |= PAGE_STATE_FLAG_FORCE_PAGE_CHANGE;
+    }
 #endif
 
     const bool updateNow = (int32_t)(currentTimeUs - nextDisplayUpdateAt) >= 0L;
@@ -667,6 +754,7 @@ void dashboardUpdate(timeUs_t currentTimeUs)
         updateTicker();
     }
 
+    flushScreenBuffer();
 }
 
 void dashboardInit(void)
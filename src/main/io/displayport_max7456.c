@@ -43,7 +43,7 @@
 
 displayPort_t max7456DisplayPort;
 
-PG_REGISTER_WITH_RESET_FN(displayPortProfile_t, displayPortProfileMax7456, PG_DISPLAY_PORT_MAX7456_CONFIG, 0);
+PG_REGISTER_WITH_RESET_FN(displayPortProfile_t, displayPortProfileMax7456, PG_DISPLAY_PORT_MAX7456_CONFIG, 1);
 
 void pgResetFn_displayPortProfileMax7456(displayPortProfile_t *displayPortProfile)
 {
@@ -27,12 +27,14 @@
 
 #ifdef USE_MSP_DISPLAYPORT
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "pg/pg.h"
 #include "pg/pg_ids.h"
 
 #include "drivers/display.h"
+#include "drivers/time.h"
 
 #include "interface/msp.h"
 #include "interface/msp_protocol.h"
@@ -42,10 +44,26 @@
 #include "msp/msp_serial.h"
 
 // no template required since defaults are zero
-PG_REGISTER(displayPortProfile_t, displayPortProfileMsp, PG_DISPLAY_PORT_MSP_CONFIG, 0);
+PG_REGISTER(displayPortProfile_t, displayPortProfileMsp, PG_DISPLAY_PORT_MSP_CONFIG, 1);
 
 static displayPort_t mspDisplayPort;
 
+#define MSP_OSD_MAX_STRING_LENGTH 30 // FIXME move this
+
+// With displayport_msp_buffered the writes only go into screenBuffer. drawScreen() compares it with
+// what was sent and sends the changed runs of each row, several runs close to each other in one write.
+// Every MSP_DISPLAYPORT_KEYFRAME_INTERVAL_MS the screen is cleared and sent again, so the display
+// catches up after lost frames.
+#define MSP_DISPLAYPORT_MAX_ROWS 16
+#define MSP_DISPLAYPORT_MAX_COLS 30
+#define MSP_DISPLAYPORT_KEYFRAME_INTERVAL_MS 2000
+#define MSP_DISPLAYPORT_RUN_MAX_GAP 8           // unchanged chars sent again rather than starting another frame
+#define MSP_DISPLAYPORT_FRAME_OVERHEAD 10       // MSP header, checksum and the write command
+
+static uint8_t screenBuffer[MSP_DISPLAYPORT_MAX_ROWS * MSP_DISPLAYPORT_MAX_COLS];
+static uint8_t sentBuffer[MSP_DISPLAYPORT_MAX_ROWS * MSP_DISPLAYPORT_MAX_COLS];
+static timeMs_t nextKeyframeMs;
+
 #ifdef USE_CLI
 extern uint8_t cliMode;
 #endif
@@ -63,8 +81,15 @@ static int output(displayPort_t *displayPort, uint8_t cmd, uint8_t *buf, int len
     return mspSerialPush(cmd, buf, len, MSP_DIRECTION_REPLY);
 }
 
+static int flushScreen(displayPort_t *displayPort);
+
 static int heartbeat(displayPort_t *displayPort)
 {
+    // the CMS only calls heartbeat, make sure what it wrote goes out
+    if (displayPortProfileMsp()->useScreenBuffer) {
+        flushScreen(displayPort);
+    }
+
     uint8_t subcmd[] = { 0 };
 
     // heartbeat is used to:
@@ -85,30 +110,23 @@ static int release(displayPort_t *displayPort)
     return output(displayPort, MSP_DISPLAYPORT, subcmd, sizeof(subcmd));
 }
 
-static int clearScreen(displayPort_t *displayPort)
+static int sendClearScreen(displayPort_t *displayPort)
 {
     uint8_t subcmd[] = { 2 };
 
     return output(displayPort, MSP_DISPLAYPORT, subcmd, sizeof(subcmd));
 }
 
-static int drawScreen(displayPort_t *displayPort)
+static int sendDrawScreen(displayPort_t *displayPort)
 {
     uint8_t subcmd[] = { 4 };
     return output(displayPort, MSP_DISPLAYPORT, subcmd, sizeof(subcmd));
 }
 
-static int screenSize(const displayPort_t *displayPort)
-{
-    return displayPort->rows * displayPort->cols;
-}
-
-static int writeString(displayPort_t *displayPort, uint8_t col, uint8_t row, const char *string)
+static int sendString(displayPort_t *displayPort, uint8_t col, uint8_t row, const uint8_t *data, int len)
 {
-#define MSP_OSD_MAX_STRING_LENGTH 30 // FIXME move this
     uint8_t buf[MSP_OSD_MAX_STRING_LENGTH + 4];
 
-    int len = strlen(string);
     if (len >= MSP_OSD_MAX_STRING_LENGTH) {
         len = MSP_OSD_MAX_STRING_LENGTH;
     }
@@ -117,11 +135,100 @@ static int writeString(displayPort_t *displayPort, uint8_t col, uint8_t row, con
     buf[1] = row;
     buf[2] = col;
     buf[3] = 0;
-    memcpy(&buf[4], string, len);
+    memcpy(&buf[4], data, len);
 
     return output(displayPort, MSP_DISPLAYPORT, buf, len + 4);
 }
 
+static int flushScreen(displayPort_t *displayPort)
+{
+    const int rows = MIN(displayPort->rows, MSP_DISPLAYPORT_MAX_ROWS);
+    const int cols = MIN(displayPort->cols, MSP_DISPLAYPORT_MAX_COLS);
+    bool sent = false;
+
+    if (cmp32(millis(), nextKeyframeMs) >= 0) {
+        sendClearScreen(displayPort);
+        memset(sentBuffer, ' ', sizeof(sentBuffer));
+        nextKeyframeMs = millis() + MSP_DISPLAYPORT_KEYFRAME_INTERVAL_MS;
+        sent = true;
+    }
+
+    for (int row = 0; row < rows; row++) {
+        const uint8_t *screenRow = &screenBuffer[row * MSP_DISPLAYPORT_MAX_COLS];
+        uint8_t *sentRow = &sentBuffer[row * MSP_DISPLAYPORT_MAX_COLS];
+
+        int col = 0;
+        while (col < cols) {
+            if (screenRow[col] == sentRow[col]) {
+                col++;
+                continue;
+            }
+
+            // the run ends at the last change that is not too far from the previous one
+            int end = col + 1;
+            for (int i = end, gap = 0; i < cols && i - col < MSP_OSD_MAX_STRING_LENGTH && gap <= MSP_DISPLAYPORT_RUN_MAX_GAP; i++) {
+                if (screenRow[i] != sentRow[i]) {
+                    end = i + 1;
+                    gap = 0;
+                } else {
+                    gap++;
+                }
+            }
+
+            // what does not fit now goes out with the next flush
+            const int len = end - col;
+            if (mspSerialTxBytesFree() < (uint32_t)(len + MSP_DISPLAYPORT_FRAME_OVERHEAD)) {
+                return sent ? sendDrawScreen(displayPort) : 0;
+            }
+
+            sendString(displayPort, col, row, &screenRow[col], len);
+            memcpy(&sentRow[col], &screenRow[col], len);
+            sent = true;
+            col = end;
+        }
+    }
+
+    return sent ? sendDrawScreen(displayPort) : 0;
+}
+
+static int clearScreen(displayPort_t *displayPort)
+{
+    if (displayPortProfileMsp()->useScreenBuffer) {
+        memset(screenBuffer, ' ', sizeof(screenBuffer));
+        return 0;
+    }
+
+    return sendClearScreen(displayPort);
+}
+
+static int drawScreen(displayPort_t *displayPort)
+{
+    if (displayPortProfileMsp()->useScreenBuffer) {
+        return flushScreen(displayPort);
+    }
+
+    return sendDrawScreen(displayPort);
+}
+
+static int screenSize(const displayPort_t *displayPort)
+{
+    return displayPort->rows * displayPort->cols;
+}
+
+static int writeString(displayPort_t *displayPort, uint8_t col, uint8_t row, const char *string)
+{
+    if (displayPortProfileMsp()->useScreenBuffer) {
+        if (row < MSP_DISPLAYPORT_MAX_ROWS) {
+            for (int i = 0; string[i] && col + i < MSP_DISPLAYPORT_MAX_COLS; i++) {
+                screenBuffer[row * MSP_DISPLAYPORT_MAX_COLS + col + i] = string[i];
+            }
+        }
+        return 0;
+    }
+
+    return sendString(displayPort, col, row, (const uint8_t *)string, strlen(string));
+}
+
 static int writeChar(displayPort_t *displayPort, uint8_t col, uint8_t row, uint8_t c)
 {
     char buf[2];
@@ -147,6 +254,8 @@ static void resync(displayPort_t *displayPort)
 {
     displayPort->rows = 13 + displayPortProfileMsp()->rowAdjust; // XXX Will reflect NTSC/PAL in the future
     displayPort->cols = 30 + displayPortProfileMsp()->colAdjust;
+    // send everything again with the next frame
+    nextKeyframeMs = millis();
     drawScreen(displayPort);
 }
 
@@ -173,6 +282,8 @@ static const displayPortVTable_t mspDisplayPortVTable = {
 
 displayPort_t *displayPortMspInit(void)
 {
+    memset(screenBuffer, ' ', sizeof(screenBuffer));
+    memset(sentBuffer, ' ', sizeof(sentBuffer));
     displayInit(&mspDisplayPort, &mspDisplayPortVTable);
     resync(&mspDisplayPort);
     return &mspDisplayPort;
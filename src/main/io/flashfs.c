@@ -32,14 +32,37 @@
  * and make calls through that, at the moment flashfs just calls m25p16_* routines explicitly.
  */
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
 
+#include "platform.h"
+
+#include "build/build_config.h"
+
+#include "common/maths.h"
+#include "common/utils.h"
+
 #include "drivers/flash.h"
 
 #include "io/flashfs.h"
 
+#include "pg/flash.h"
+
+enum {
+    /* We can choose whatever power of 2 size we like, which determines how much wastage of free space we'll have
+     * at the end of the last written data. But smaller blocksizes will require more searching.
+     */
+    FREE_BLOCK_SIZE = 2048, // XXX This can't be smaller than page size for underlying flash device.
+
+    /* We don't expect valid data to ever contain this many consecutive uint32_t's of all 1 bits: */
+    FREE_BLOCK_TEST_SIZE_INTS = 4, // i.e. 16 bytes
+    FREE_BLOCK_TEST_SIZE_BYTES = FREE_BLOCK_TEST_SIZE_INTS * sizeof(uint32_t)
+};
+
+STATIC_ASSERT(FREE_BLOCK_SIZE >= FLASH_MAX_PAGE_SIZE, FREE_BLOCK_SIZE_too_small);
+
 static uint8_t flashWriteBuffer[FLASHFS_WRITE_BUFFER_SIZE];
 
 /* The position of our head and tail in the circular flash write buffer.
@@ -54,6 +77,44 @@ static uint8_t bufferHead = 0, bufferTail = 0;
 // The position of the buffer's tail in the overall flash address space:
 static uint32_t tailAddress = 0;
 
+/* With erase-ahead (flash_erase_ahead > 0) the sectors in front of the tail are erased in the background, so
+ * logging can go on from the start of a full or dirty chip without a full chip erase first. Only the space below
+ * this address is known to be erased and may be written, data for past it waits in the buffer.
+ */
+static uint32_t erasedUpToAddress = 0;
+
+/* With flash_log_index the last sector of the chip is taken out of the volume and holds a table of the logs on it,
+ * so a reader can fetch one log without downloading the whole chip. The sector starts with a header, then an entry
+ * is appended for each log when it begins, and its remaining fields are programmed in place when it ends (they are
+ * still erased until then). Only NOR flash allows a page to be programmed in pieces like this.
+ */
+#define FLASHFS_LOG_INDEX_MAGIC 0x58444E49 // "INDX"
+#define FLASHFS_LOG_INDEX_VERSION 1
+#define FLASHFS_LOG_INDEX_ERASED 0xFFFFFFFF
+
+static enum {
+    FLASHFS_LOG_INDEX_NONE,     // disabled, or the sector holds old log data until the next full erase
+    FLASHFS_LOG_INDEX_ERASE,    // the sector is erased by the erase-ahead task
+    FLASHFS_LOG_INDEX_HEADER,   // the sector is erased, the header is written before the first entry
+    FLASHFS_LOG_INDEX_READY
+} logIndexState = FLASHFS_LOG_INDEX_NONE;
+
+static uint32_t logIndexAddress = 0; // start of the index sector, 0 if there is none
+static int logIndexCount;            // entries in use
+static bool logIndexOpen;            // the last entry belongs to the log being written
+static uint32_t logIndexStart;       // start offset of that log
+
+static uint32_t flashfsLogIndexEntryAddress(int index)
+{
+    // the header takes the first slot
+    return logIndexAddress + (index + 1) * sizeof(flashfsLogIndexEntry_t);
+}
+
+static int flashfsLogIndexCapacity(void)
+{
+    return flashGetGeometry()->sectorSize / sizeof(flashfsLogIndexEntry_t) - 1;
+}
+
 static void flashfsClearBuffer(void)
 {
     bufferTail = bufferHead = 0;
@@ -76,6 +137,14 @@ void flashfsEraseCompletely(void)
     flashfsClearBuffer();
 
     flashfsSetTailAddress(0);
+
+    erasedUpToAddress = flashfsGetSize();
+
+    if (logIndexAddress) {
+        logIndexState = FLASHFS_LOG_INDEX_HEADER;
+        logIndexCount = 0;
+        logIndexOpen = false;
+    }
 }
 
 /**
@@ -120,7 +189,8 @@ bool flashfsIsSupported(void)
 
 uint32_t flashfsGetSize(void)
 {
-    return flashGetGeometry()->totalSize;
+    // The log index sector is not part of the volume
+    return logIndexAddress ? logIndexAddress : flashGetGeometry()->totalSize;
 }
 
 static uint32_t flashfsTransmitBufferUsed(void)
@@ -171,6 +241,31 @@ const flashGeometry_t* flashfsGetGeometry(void)
  *
  * Returns the number of bytes written
  */
+#define FLASHFS_ERASE_WAIT_TIMEOUT_MILLIS 5000
+
+/*
+ * Sync writes must not leave data behind, so instead of stopping at the end of the erased space they run the
+ * erase-ahead themselves until it has passed the tail. Returns false if the erase makes no progress.
+ */
+static bool flashfsWaitForErasedTail(void)
+{
+    while (tailAddress >= erasedUpToAddress) {
+        const uint32_t erasedBefore = erasedUpToAddress;
+        const unsigned logIndexStateBefore = logIndexState;
+
+        flashFlush();
+        if (!flashWaitForReady(FLASHFS_ERASE_WAIT_TIMEOUT_MILLIS)) {
+            return false;
+        }
+        flashfsEraseAheadUpdate();
+
+        if (erasedUpToAddress == erasedBefore && logIndexState == logIndexStateBefore) {
+            return false;
+        }
+    }
+    return true;
+}
+
 static uint32_t flashfsWriteBuffers(uint8_t const **buffers, uint32_t *bufferSizes, int bufferCount, bool sync)
 {
     uint32_t bytesTotal = 0;
@@ -211,6 +306,13 @@ static uint32_t flashfsWriteBuffers(uint8_t const **buffers, uint32_t *bufferSiz
             break;
         }
 
+        // Pages never straddle sectors, so the whole page is erased if its start is
+        if (flashConfig()->eraseAheadSectors && tailAddress >= erasedUpToAddress) {
+            if (!sync || !flashfsWaitForErasedTail()) {
+                break;
+            }
+        }
+
         flashPageProgramBegin(tailAddress);
 
         bytesRemainThisIteration = bytesTotalThisIteration;
@@ -347,15 +449,19 @@ void flashfsFlushSync(void)
     uint32_t bufferSizes[2];
 
     flashfsGetDirtyDataBuffers(buffers, bufferSizes);
-    flashfsWriteBuffers(buffers, bufferSizes, 2, true);
+    const uint32_t bytesWritten = flashfsWriteBuffers(buffers, bufferSizes, 2, true);
 
-    // We've written our entire buffer now:
-    flashfsClearBuffer();
+    // Normally that was the entire buffer, only data that could not be written stays (at EOF it was dropped)
+    if (!flashfsBufferIsEmpty()) {
+        flashfsAdvanceTailInBuffer(bytesWritten);
+    }
 }
 
 void flashfsSeekAbs(uint32_t offset)
 {
     flashfsFlushSync();
+    // anything the flush could not write belongs to the old position
+    flashfsClearBuffer();
 
     flashfsSetTailAddress(offset);
 }
@@ -363,6 +469,8 @@ void flashfsSeekAbs(uint32_t offset)
 void flashfsSeekRel(int32_t offset)
 {
     flashfsFlushSync();
+    // anything the flush could not write belongs to the old position
+    flashfsClearBuffer();
 
     flashfsSetTailAddress(tailAddress + offset);
 }
@@ -490,6 +598,32 @@ int flashfsReadAbs(uint32_t address, uint8_t *buffer, unsigned int len)
     return bytesRead;
 }
 
+/**
+ * Test whether the block at the given address appears to be erased, returns false if the flash could not be read.
+ */
+static bool flashfsIsBlockErased(uint32_t address, bool *erased)
+{
+    union {
+        uint8_t bytes[FREE_BLOCK_TEST_SIZE_BYTES];
+        uint32_t ints[FREE_BLOCK_TEST_SIZE_INTS];
+    } testBuffer;
+
+    if (flashReadBytes(address, testBuffer.bytes, FREE_BLOCK_TEST_SIZE_BYTES) < FREE_BLOCK_TEST_SIZE_BYTES) {
+        return false;
+    }
+
+    // Checking the buffer 4 bytes at a time like this is probably faster than byte-by-byte, but I didn't benchmark it :)
+    *erased = true;
+    for (int i = 0; i < FREE_BLOCK_TEST_SIZE_INTS; i++) {
+        if (testBuffer.ints[i] != 0xFFFFFFFF) {
+            *erased = false;
+            break;
+        }
+    }
+
+    return true;
+}
+
 /**
  * Find the offset of the start of the free space on the device (or the size of the device if it is full).
  */
@@ -504,48 +638,35 @@ int flashfsIdentifyStartOfFreeSpace(void)
      * bandwidth and block more often.
      */
 
-    enum {
-        /* We can choose whatever power of 2 size we like, which determines how much wastage of free space we'll have
-         * at the end of the last written data. But smaller blocksizes will require more searching.
-         */
-        FREE_BLOCK_SIZE = 2048, // XXX This can't be smaller than page size for underlying flash device.
-
-        /* We don't expect valid data to ever contain this many consecutive uint32_t's of all 1 bits: */
-        FREE_BLOCK_TEST_SIZE_INTS = 4, // i.e. 16 bytes
-        FREE_BLOCK_TEST_SIZE_BYTES = FREE_BLOCK_TEST_SIZE_INTS * sizeof(uint32_t)
-    };
-
-    STATIC_ASSERT(FREE_BLOCK_SIZE >= FLASH_MAX_PAGE_SIZE, FREE_BLOCK_SIZE_too_small);
-
-    union {
-        uint8_t bytes[FREE_BLOCK_TEST_SIZE_BYTES];
-        uint32_t ints[FREE_BLOCK_TEST_SIZE_INTS];
-    } testBuffer;
-
     int left = 0; // Smallest block index in the search region
     int right = flashfsGetSize() / FREE_BLOCK_SIZE; // One past the largest block index in the search region
     int mid;
     int result = right;
-    int i;
     bool blockErased;
 
+    if (flashConfig()->eraseAheadSectors) {
+        /* Erase-ahead leaves old data behind the sectors it erased, so the used space is not one contiguous
+         * region and the binary search can't be trusted. A linear scan finds the first erased block instead.
+         */
+        for (mid = 0; mid < right; mid++) {
+            if (!flashfsIsBlockErased(mid * FREE_BLOCK_SIZE, &blockErased)) {
+                break;
+            }
+            if (blockErased) {
+                return mid * FREE_BLOCK_SIZE;
+            }
+        }
+        return mid * FREE_BLOCK_SIZE;
+    }
+
     while (left < right) {
         mid = (left + right) / 2;
 
-        if (flashReadBytes(mid * FREE_BLOCK_SIZE, testBuffer.bytes, FREE_BLOCK_TEST_SIZE_BYTES) < FREE_BLOCK_TEST_SIZE_BYTES) {
+        if (!flashfsIsBlockErased(mid * FREE_BLOCK_SIZE, &blockErased)) {
             // Unexpected timeout from flash, so bail early (reporting the device fuller than it really is)
             break;
         }
 
-        // Checking the buffer 4 bytes at a time like this is probably faster than byte-by-byte, but I didn't benchmark it :)
-        blockErased = true;
-        for (i = 0; i < FREE_BLOCK_TEST_SIZE_INTS; i++) {
-            if (testBuffer.ints[i] != 0xFFFFFFFF) {
-                blockErased = false;
-                break;
-            }
-        }
-
         if (blockErased) {
             /* This erased block might be the leftmost erased block in the volume, but we'll need to continue the
              * search leftwards to find out:
@@ -573,6 +694,9 @@ void flashfsClose(void)
 {
     switch(flashfsGetGeometry()->flashType) {
     case FLASH_TYPE_NOR:
+        // the driver may still hold the last page
+        flashFlush();
+
         break;
 
     case FLASH_TYPE_NAND:
@@ -586,14 +710,234 @@ void flashfsClose(void)
     }
 }
 
+/**
+ * Keeps flash_erase_ahead sectors in front of the tail erased, one sector erase per call.
+ *
+ * Call from idle time. An erase is only issued while the chip is idle, so it never holds up a page program
+ * that is waiting or in progress, and buffered data just waits for the erase to finish.
+ */
+void flashfsEraseAheadUpdate(void)
+{
+    const uint32_t sectorSize = flashfsGetGeometry()->sectorSize;
+    if (!flashConfig()->eraseAheadSectors || !sectorSize) {
+        return;
+    }
+
+    // The log index has to be cleared once the logs it describes are overwritten
+    if (logIndexState == FLASHFS_LOG_INDEX_ERASE) {
+        if (flashIsIdle()) {
+            flashEraseSector(logIndexAddress);
+            logIndexState = FLASHFS_LOG_INDEX_HEADER;
+        }
+        return;
+    }
+
+    const uint32_t tailSector = flashfsGetOffset() / sectorSize;
+    const uint32_t eraseUpTo = MIN((tailSector + 1 + flashConfig()->eraseAheadSectors) * sectorSize, flashfsGetSize());
+
+    while (erasedUpToAddress < eraseUpTo) {
+        if (!flashIsIdle()) {
+            return;
+        }
+
+        // stale data always starts at the beginning of a sector, so a sector with an erased first block is clean
+        bool erased;
+        if (!flashfsIsBlockErased(erasedUpToAddress, &erased)) {
+            return;
+        }
+        if (!erased) {
+            flashEraseSector(erasedUpToAddress);
+        }
+
+        erasedUpToAddress += sectorSize;
+
+        if (!erased) {
+            return;
+        }
+    }
+}
+
+static void flashfsLogIndexInit(void)
+{
+    const flashGeometry_t *geometry = flashGetGeometry();
+
+    logIndexAddress = 0;
+    logIndexState = FLASHFS_LOG_INDEX_NONE;
+    logIndexCount = 0;
+    logIndexOpen = false;
+
+    if (!flashConfig()->logIndex || geometry->flashType != FLASH_TYPE_NOR || geometry->sectors < 2) {
+        return;
+    }
+
+    logIndexAddress = geometry->totalSize - geometry->sectorSize;
+
+    uint32_t header[2];
+    if (flashReadBytes(logIndexAddress, (uint8_t *)header, sizeof(header)) < (int)sizeof(header)) {
+        return;
+    }
+
+    if (header[0] == FLASHFS_LOG_INDEX_ERASED && header[1] == FLASHFS_LOG_INDEX_ERASED) {
+        logIndexState = FLASHFS_LOG_INDEX_HEADER;
+        return;
+    }
+
+    if (header[0] != FLASHFS_LOG_INDEX_MAGIC || header[1] != FLASHFS_LOG_INDEX_VERSION) {
+        // Old log data, erase-ahead can reclaim it, otherwise it waits for a full erase
+        logIndexState = flashConfig()->eraseAheadSectors ? FLASHFS_LOG_INDEX_ERASE : FLASHFS_LOG_INDEX_NONE;
+        return;
+    }
+
+    // Entries are appended, so binary search for the first one that was never started
+    int left = 0;
+    int right = flashfsLogIndexCapacity();
+    while (left < right) {
+        const int mid = (left + right) / 2;
+        uint32_t start;
+
+        if (flashReadBytes(flashfsLogIndexEntryAddress(mid), (uint8_t *)&start, sizeof(start)) < (int)sizeof(start)) {
+            return;
+        }
+
+        if (start == FLASHFS_LOG_INDEX_ERASED) {
+            right = mid;
+        } else {
+            left = mid + 1;
+        }
+    }
+
+    logIndexCount = left;
+    logIndexState = FLASHFS_LOG_INDEX_READY;
+}
+
+/**
+ * Record the start of a log in the log index, call before the first byte of the log is written.
+ *
+ * This runs at arming, so it never waits for the flash. Returns false while the flash is busy, call again until it
+ * returns true.
+ */
+bool flashfsLogIndexBegin(void)
+{
+    if (logIndexState == FLASHFS_LOG_INDEX_HEADER) {
+        if (!flashIsReady()) {
+            return false;
+        }
+
+        const uint32_t header[2] = { FLASHFS_LOG_INDEX_MAGIC, FLASHFS_LOG_INDEX_VERSION };
+
+        flashPageProgram(logIndexAddress, (const uint8_t *)header, sizeof(header));
+        logIndexCount = 0;
+        logIndexState = FLASHFS_LOG_INDEX_READY;
+
+        // the entry is programmed once the header is in
+        return false;
+    }
+
+    logIndexOpen = false;
+
+    if (logIndexState != FLASHFS_LOG_INDEX_READY || logIndexCount >= flashfsLogIndexCapacity()) {
+        return true;
+    }
+
+    if (!flashIsReady()) {
+        return false;
+    }
+
+    logIndexStart = flashfsGetOffset();
+
+    flashPageProgram(flashfsLogIndexEntryAddress(logIndexCount), (const uint8_t *)&logIndexStart, sizeof(logIndexStart));
+    logIndexCount++;
+    logIndexOpen = true;
+
+    return true;
+}
+
+/**
+ * Complete the log index entry of the current log, call once all of the log has been written.
+ *
+ * Returns false while the flash is busy, call again until it returns true.
+ */
+bool flashfsLogIndexEnd(uint32_t durationMs, uint32_t flags)
+{
+    if (!logIndexOpen) {
+        return true;
+    }
+
+    if (!flashIsReady()) {
+        return false;
+    }
+
+    logIndexOpen = false;
+
+    const uint32_t entryAddress = flashfsLogIndexEntryAddress(logIndexCount - 1);
+    const uint32_t fields[3] = { flashfsGetOffset() - logIndexStart, durationMs, flags };
+
+    flashPageProgram(entryAddress + offsetof(flashfsLogIndexEntry_t, length), (const uint8_t *)fields, sizeof(fields));
+
+    return true;
+}
+
+int flashfsLogIndexGetCount(void)
+{
+    return logIndexState == FLASHFS_LOG_INDEX_READY ? logIndexCount : 0;
+}
+
+/**
+ * Read an entry of the log index. A log that was never ended (e.g. power was lost) runs up to the start of the
+ * next log, or up to the end of the written data.
+ */
+bool flashfsLogIndexGetEntry(int index, flashfsLogIndexEntry_t *entry)
+{
+    if (index < 0 || index >= flashfsLogIndexGetCount()) {
+        return false;
+    }
+
+    if (flashReadBytes(flashfsLogIndexEntryAddress(index), (uint8_t *)entry, sizeof(*entry)) < (int)sizeof(*entry)) {
+        return false;
+    }
+
+    if (entry->length == FLASHFS_LOG_INDEX_ERASED) {
+        uint32_t end = flashfsGetOffset();
+
+        if (index + 1 < logIndexCount) {
+            flashReadBytes(flashfsLogIndexEntryAddress(index + 1), (uint8_t *)&end, sizeof(end));
+        }
+        entry->length = end > entry->start ? end - entry->start : 0;
+        entry->durationMs = 0;
+        entry->flags = 0;
+    }
+
+    return true;
+}
+
 /**
  * Call after initializing the flash chip in order to set up the filesystem.
  */
 void flashfsInit(void)
 {
+    flashfsLogIndexInit();
+
     // If we have a flash chip present at all
     if (flashfsGetSize() > 0) {
+        uint32_t offset = flashfsIdentifyStartOfFreeSpace();
+
+        if (flashConfig()->eraseAheadSectors) {
+            const uint32_t sectorSize = flashfsGetGeometry()->sectorSize;
+
+            if (flashfsGetSize() - offset < flashConfig()->eraseAheadSectors * sectorSize) {
+                // Too full to log to, start over from the beginning and erase the old logs on the way
+                offset = 0;
+
+                if (logIndexState != FLASHFS_LOG_INDEX_NONE) {
+                    logIndexState = FLASHFS_LOG_INDEX_ERASE;
+                }
+            }
+
+            // The rest of the sector the free space starts in is erased
+            erasedUpToAddress = (offset + sectorSize - 1) / sectorSize * sectorSize;
+        }
+
         // Start the file pointer off at the beginning of free space so caller can start writing immediately
-        flashfsSeekAbs(flashfsIdentifyStartOfFreeSpace());
+        flashfsSeekAbs(offset);
     }
 }
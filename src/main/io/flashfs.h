@@ -50,7 +50,22 @@ void flashfsFlushSync(void);
 
 void flashfsClose(void);
 void flashfsInit(void);
+void flashfsEraseAheadUpdate(void);
 bool flashfsIsSupported(void);
 
 bool flashfsIsReady(void);
 bool flashfsIsEOF(void);
+
+#define FLASHFS_LOG_INDEX_FLAG_DISCARDED (1 << 0) // the log was ended without being retained
+
+typedef struct flashfsLogIndexEntry_s {
+    uint32_t start;         // volume offset of the first byte of the log
+    uint32_t length;        // in bytes
+    uint32_t durationMs;    // time from the start to the end of the log, 0 if the log was never ended
+    uint32_t flags;         // FLASHFS_LOG_INDEX_FLAG_*
+} flashfsLogIndexEntry_t;
+
+bool flashfsLogIndexBegin(void);
+bool flashfsLogIndexEnd(uint32_t durationMs, uint32_t flags);
+int flashfsLogIndexGetCount(void);
+bool flashfsLogIndexGetEntry(int index, flashfsLogIndexEntry_t *entry);
@@ -73,6 +73,7 @@ typedef struct gpsConfig_s {
     gpsAutoConfig_e autoConfig;
     gpsAutoBaud_e autoBaud;
     uint8_t gps_ublox_use_galileo;
+    uint8_t gps_ublox_use_pvt;
 } gpsConfig_t;
 
 PG_DECLARE(gpsConfig_t, gpsConfig);
@@ -102,6 +103,7 @@ typedef enum {
     GPS_MESSAGE_STATE_INIT,
     GPS_MESSAGE_STATE_SBAS,
     GPS_MESSAGE_STATE_GALILEO,
+    GPS_MESSAGE_STATE_PVT,
     GPS_MESSAGE_STATE_ENTRY_COUNT
 } gpsMessageState_e;
 
@@ -124,6 +126,8 @@ extern char gpsPacketLog[GPS_PACKET_LOG_ENTRY_COUNT];
 extern int32_t GPS_home[2];
 extern uint16_t GPS_distanceToHome;        // distance to home point in meters
 extern int16_t GPS_directionToHome;        // direction to home or hol point in degrees
+extern int32_t GPS_homeOffsetCm[2];        // position relative to home in cm on the local tangent plane, [GPS_X] east, [GPS_Y] north
+extern uint32_t GPS_distanceToHomeCm;      // distance to home point in cm
 extern int16_t GPS_angle[ANGLE_INDEX_COUNT];                // it's the angles that must be applied for GPS correction
 extern float dTnav;             // Delta Time in milliseconds for navigation computations, updated with every good GPS read
 extern float GPS_scaleLonDown;  // this is used to offset the shrinking longitude as we go towards the poles
@@ -347,8 +347,6 @@ bool parseLedStripConfig(int ledIndex, const char *config)
 
     *ledConfig = DEFINE_LED(x, y, color, direction_flags, baseFunction, overlay_flags, 0);
 
-    reevaluateLedConfig();
-
     return true;
 }
 
@@ -46,6 +46,7 @@
 #include "cms/cms.h"
 #include "cms/cms_types.h"
 
+#include "common/bitarray.h"
 #include "common/maths.h"
 #include "common/printf.h"
 #include "common/typeconversion.h"
@@ -86,6 +87,8 @@
 
 #include "rx/rx.h"
 
+#include "scheduler/scheduler.h"
+
 #include "sensors/adcinternal.h"
 #include "sensors/barometer.h"
 #include "sensors/battery.h"
@@ -116,6 +119,31 @@ static uint32_t blinkBits[(OSD_ITEM_COUNT + 31)/32];
 #define IS_BLINK(item) (blinkBits[(item) / 32] & (1 << ((item) % 32)))
 #define BLINK(item) (IS_BLINK(item) && blinkState)
 
+// What each element last put on the screen, so a refresh only writes what changed.
+// The screen is only cleared and completely redrawn after something else cleared or used it,
+// and every OSD_FULL_REDRAW_INTERVAL_US in case a display lost what was sent.
+#define OSD_FULL_REDRAW_INTERVAL_US (10 * 1000 * 1000)
+#define AH_COLUMN_COUNT 9
+
+typedef struct osdElementCache_s {
+    uint32_t hash;      // of the string drawn, or of the quantised attitude for the horizon
+    uint8_t x;
+    uint8_t y;
+    uint8_t length;     // 0 when nothing of the element is on screen
+} osdElementCache_t;
+
+typedef struct osdScreenCell_s {
+    uint8_t x;
+    uint8_t y;
+    uint8_t c;          // 0 when empty
+} osdScreenCell_t;
+
+static osdElementCache_t osdElementCache[OSD_ITEM_COUNT];
+static osdScreenCell_t osdAhCells[AH_COLUMN_COUNT];
+static uint8_t osdElementDrawRank[OSD_ITEM_COUNT];  // later drawn elements are on top
+static bool osdRedrawAll = true;
+static timeUs_t osdFullRedrawAt;
+
 // Things in both OSD and CMS
 
 #define IS_HI(X)  (rcData[X] > 1750)
@@ -149,6 +177,7 @@ static escSensorData_t *escDataCombined;
 #endif
 
 #define AH_SYMBOL_COUNT 9
+#define AH_ROLL_STEP 16     // tenths of a degree, moves the outer columns by one of the AH_SYMBOL_COUNT steps of a row
 #define AH_SIDEBAR_WIDTH_POS 7
 #define AH_SIDEBAR_HEIGHT_POS 3
 
@@ -175,6 +204,7 @@ static const uint8_t osdElementDisplayOrder[] = {
     OSD_ITEM_TIMER_1,
     OSD_ITEM_TIMER_2,
     OSD_REMAINING_TIME_ESTIMATE,
+    OSD_BATTERY_TIME_REMAINING,
     OSD_FLYMODE,
     OSD_THROTTLE_POS,
     OSD_VTX_CHANNEL,
@@ -200,7 +230,20 @@ static const uint8_t osdElementDisplayOrder[] = {
     OSD_ANTI_GRAVITY
 };
 
-PG_REGISTER_WITH_RESET_FN(osdConfig_t, osdConfig, PG_OSD_CONFIG, 3);
+PG_REGISTER_WITH_RESET_FN(osdConfig_t, osdConfig, PG_OSD_CONFIG, 5);
+
+// Sensor values used by the elements, alarms and statistics, read once per refresh
+typedef struct osdSnapshot_s {
+    uint16_t batteryVoltage;        // 0.1V
+    int32_t amperage;               // 0.01A
+    int32_t mAhDrawn;
+    batteryState_e batteryState;
+    uint8_t rssiPercent;
+    int32_t altitude;               // cm
+    int32_t altitudeInSelectedUnit; // cm or ft / 100
+} osdSnapshot_t;
+
+static osdSnapshot_t osdSnapshot;
 
 /**
  * Gets the correct altitude symbol for the current unit system
@@ -220,12 +263,12 @@ static char osdGetMetersToSelectedUnitSymbol(void)
  */
 static int osdGetBatteryAverageCellVoltage(void)
 {
-    return (getBatteryVoltage() * 10) / getBatteryCellCount();
+    return (osdSnapshot.batteryVoltage * 10) / getBatteryCellCount();
 }
 
 static char osdGetBatterySymbol(int cellVoltage)
 {
-    if (getBatteryState() == BATTERY_CRITICAL) {
+    if (osdSnapshot.batteryState == BATTERY_CRITICAL) {
         return SYM_MAIN_BATT; // FIXME: currently the BAT- symbol, ideally replace with a battery with exclamation mark
     } else {
         // Calculate a symbol offset using cell voltage over full cell voltage range
@@ -274,11 +317,25 @@ static void osdFormatAltitudeString(char * buff, int altitude)
 {
     const int alt = osdGetMetersToSelectedUnit(altitude) / 10;
 
-    tfp_sprintf(buff, "%5d %c", alt, osdGetMetersToSelectedUnitSymbol());
+    char *p = i2aPadded(alt, 5, ' ', buff);
+    *p++ = ' ';
+    *p++ = osdGetMetersToSelectedUnitSymbol();
+    *p = '\0';
     buff[5] = buff[4];
     buff[4] = '.';
 }
 
+static void osdUpdateSnapshot(void)
+{
+    osdSnapshot.batteryVoltage = getBatteryVoltage();
+    osdSnapshot.amperage = getAmperage();
+    osdSnapshot.mAhDrawn = getMAhDrawn();
+    osdSnapshot.batteryState = getBatteryState();
+    osdSnapshot.rssiPercent = getRssiPercent();
+    osdSnapshot.altitude = getEstimatedAltitude();
+    osdSnapshot.altitudeInSelectedUnit = osdGetMetersToSelectedUnit(osdSnapshot.altitude);
+}
+
 static void osdFormatPID(char * buff, const char * label, const pid8_t * pid)
 {
     tfp_sprintf(buff, "%s %3d %3d %3d", label, pid->P, pid->I, pid->D);
@@ -344,17 +401,14 @@ STATIC_UNIT_TESTED void osdFormatTime(char * buff, osd_timer_precision_e precisi
     const int minutes = seconds / 60;
     seconds = seconds % 60;
 
-    switch (precision) {
-    case OSD_TIMER_PREC_SECOND:
-    default:
-        tfp_sprintf(buff, "%02d:%02d", minutes, seconds);
-        break;
-    case OSD_TIMER_PREC_HUNDREDTHS:
-        {
-            const int hundredths = (time / 10000) % 100;
-            tfp_sprintf(buff, "%02d:%02d.%02d", minutes, seconds, hundredths);
-            break;
-        }
+    // "%02d:%02d" and "%02d:%02d.%02d", the timers are redrawn every frame
+    char *p = i2aPadded(minutes, 2, '0', buff);
+    *p++ = ':';
+    p = i2aPadded(seconds, 2, '0', p);
+    if (precision == OSD_TIMER_PREC_HUNDREDTHS) {
+        const int hundredths = (time / 10000) % 100;
+        *p++ = '.';
+        i2aPadded(hundredths, 2, '0', p);
     }
 }
 
@@ -446,9 +500,141 @@ bool osdWarnGetState(uint8_t warningIndex)
     return osdConfig()->enabledWarnings & (1 << warningIndex);
 }
 
+static uint32_t osdHashString(const char *s)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261;
+    while (*s) {
+        hash = (hash ^ (uint8_t)*s++) * 16777619;
+    }
+    return hash;
+}
+
+static bool osdElementCovers(uint8_t item, uint8_t x, uint8_t y, uint8_t length)
+{
+    const osdElementCache_t *cache = &osdElementCache[item];
+
+    if (item == OSD_HORIZON_SIDEBARS) {
+        return cache->length && y + AH_SIDEBAR_HEIGHT_POS >= cache->y && y <= cache->y + AH_SIDEBAR_HEIGHT_POS
+            && x + length + AH_SIDEBAR_WIDTH_POS > cache->x && x <= cache->x + AH_SIDEBAR_WIDTH_POS;
+    }
+    return cache->length && y == cache->y && x + length > cache->x && x < cache->x + cache->length;
+}
+
+// The cells were written by an element, or blanked. Elements that were on top of them there,
+// or anywhere when blanked, have to be drawn again.
+static void osdCellsChanged(uint8_t writer, uint8_t x, uint8_t y, uint8_t length, bool blanked)
+{
+    for (unsigned i = 0; i < OSD_ITEM_COUNT; i++) {
+        if (i == writer || (!blanked && osdElementDrawRank[i] <= osdElementDrawRank[writer])) {
+            continue;
+        }
+        if (i == OSD_ARTIFICIAL_HORIZON) {
+            for (int j = 0; j < AH_COLUMN_COUNT; j++) {
+                if (osdAhCells[j].y == y && osdAhCells[j].x >= x && osdAhCells[j].x < x + length) {
+                    osdAhCells[j].c = 0;
+                    osdElementCache[i].length = 0;
+                }
+            }
+        } else if (osdElementCovers(i, x, y, length)) {
+            osdElementCache[i].length = 0;
+        }
+    }
+}
+
+static void osdWriteString(uint8_t item, uint8_t x, uint8_t y, const char *s)
+{
+    displayWrite(osdDisplayPort, x, y, s);
+    osdCellsChanged(item, x, y, strlen(s), false);
+}
+
+static void osdWriteChar(uint8_t item, uint8_t x, uint8_t y, uint8_t c)
+{
+    displayWriteChar(osdDisplayPort, x, y, c);
+    osdCellsChanged(item, x, y, 1, c == SYM_BLANK);
+}
+
+static void osdEraseCells(uint8_t item, uint8_t x, uint8_t y, uint8_t length)
+{
+    char blank[OSD_ELEMENT_BUFFER_LENGTH];
+    length = MIN(length, sizeof(blank) - 1);
+    memset(blank, SYM_BLANK, length);
+    blank[length] = '\0';
+    displayWrite(osdDisplayPort, x, y, blank);
+    osdCellsChanged(item, x, y, length, true);
+}
+
+static void osdDrawHorizonSidebars(uint8_t x, uint8_t y, bool erase)
+{
+    const int8_t hudwidth = AH_SIDEBAR_WIDTH_POS;
+    const int8_t hudheight = AH_SIDEBAR_HEIGHT_POS;
+
+    // Draw AH sides
+    for (int i = -hudheight; i <= hudheight; i++) {
+        osdWriteChar(OSD_HORIZON_SIDEBARS, x - hudwidth, y + i, erase ? SYM_BLANK : SYM_AH_DECORATION);
+        osdWriteChar(OSD_HORIZON_SIDEBARS, x + hudwidth, y + i, erase ? SYM_BLANK : SYM_AH_DECORATION);
+    }
+
+    // AH level indicators
+    osdWriteChar(OSD_HORIZON_SIDEBARS, x - hudwidth + 1, y, erase ? SYM_BLANK : SYM_AH_LEFT);
+    osdWriteChar(OSD_HORIZON_SIDEBARS, x + hudwidth - 1, y, erase ? SYM_BLANK : SYM_AH_RIGHT);
+}
+
+static void osdEraseElement(uint8_t item)
+{
+    osdElementCache_t *cache = &osdElementCache[item];
+
+    if (item == OSD_ARTIFICIAL_HORIZON) {
+        cache->length = 0;
+        for (int i = 0; i < AH_COLUMN_COUNT; i++) {
+            if (osdAhCells[i].c) {
+                osdAhCells[i].c = 0;
+                osdWriteChar(item, osdAhCells[i].x, osdAhCells[i].y, SYM_BLANK);
+            }
+        }
+    } else if (cache->length) {
+        const uint8_t length = cache->length;
+        cache->length = 0;
+        if (item == OSD_HORIZON_SIDEBARS) {
+            osdDrawHorizonSidebars(cache->x, cache->y, true);
+        } else {
+            osdEraseCells(item, cache->x, cache->y, length);
+        }
+    }
+}
+
+// Writes the string of an element unless it is already on screen, and blanks what the previous one left behind
+static void osdWriteElement(uint8_t item, uint8_t x, uint8_t y, const char *buff)
+{
+    osdElementCache_t *cache = &osdElementCache[item];
+    const uint32_t hash = osdHashString(buff);
+    const uint8_t length = strlen(buff);
+
+    if (cache->length && cache->x == x && cache->y == y) {
+        if (cache->hash == hash && cache->length == length) {
+            return;
+        }
+        if (cache->length > length) {
+            osdEraseCells(item, x + length, y, cache->length - length);
+        }
+    } else {
+        osdEraseElement(item);
+    }
+
+    if (length) {
+        osdWriteString(item, x, y, buff);
+    }
+
+    cache->hash = hash;
+    cache->x = x;
+    cache->y = y;
+    cache->length = length;
+}
+
 static bool osdDrawSingleElement(uint8_t item)
 {
     if (!VISIBLE(osdConfig()->item_pos[item]) || BLINK(item)) {
+        osdEraseElement(item);
         return false;
     }
 
@@ -463,25 +649,40 @@ static bool osdDrawSingleElement(uint8_t item)
             if (osdRssi >= 100)
                 osdRssi = 99;
 
-            tfp_sprintf(buff, "%c%2d", SYM_RSSI, osdRssi);
+            buff[0] = SYM_RSSI;
+            i2aPadded(osdRssi, 2, ' ', buff + 1);
             break;
         }
 
     case OSD_MAIN_BATT_VOLTAGE:
-        buff[0] = osdGetBatterySymbol(osdGetBatteryAverageCellVoltage());
-        tfp_sprintf(buff + 1, "%2d.%1d%c", getBatteryVoltage() / 10, getBatteryVoltage() % 10, SYM_VOLT);
-        break;
+        {
+            buff[0] = osdGetBatterySymbol(osdGetBatteryAverageCellVoltage());
+            char *p = i2aPadded(osdSnapshot.batteryVoltage / 10, 2, ' ', buff + 1);
+            *p++ = '.';
+            *p++ = '0' + osdSnapshot.batteryVoltage % 10;
+            *p++ = SYM_VOLT;
+            *p = '\0';
+            break;
+        }
 
     case OSD_CURRENT_DRAW:
         {
-            const int32_t amperage = getAmperage();
-            tfp_sprintf(buff, "%3d.%02d%c", abs(amperage) / 100, abs(amperage) % 100, SYM_AMP);
+            const int32_t amperage = osdSnapshot.amperage;
+            char *p = i2aPadded(abs(amperage) / 100, 3, ' ', buff);
+            *p++ = '.';
+            p = i2aPadded(abs(amperage) % 100, 2, '0', p);
+            *p++ = SYM_AMP;
+            *p = '\0';
             break;
         }
 
     case OSD_MAH_DRAWN:
-        tfp_sprintf(buff, "%4d%c", getMAhDrawn(), SYM_MAH);
-        break;
+        {
+            char *p = i2aPadded(osdSnapshot.mAhDrawn, 4, ' ', buff);
+            *p++ = SYM_MAH;
+            *p = '\0';
+            break;
+        }
 
 #ifdef USE_GPS
     case OSD_GPS_SATS:
@@ -513,7 +714,7 @@ static bool osdDrawSingleElement(uint8_t item)
     case OSD_HOME_DIR:
         if (STATE(GPS_FIX) && STATE(GPS_FIX_HOME)) {
             if (GPS_distanceToHome > 0) {
-                const int h = GPS_directionToHome - DECIDEGREES_TO_DEGREES(attitude.values.yaw);
+                const int h = GPS_directionToHome - DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw);
                 buff[0] = osdGetDirectionSymbolFromHeading(h);
             } else {
                 // We don't have a HOME symbol in the font, by now we use this
@@ -545,12 +746,12 @@ static bool osdDrawSingleElement(uint8_t item)
 #endif // GPS
 
     case OSD_COMPASS_BAR:
-        memcpy(buff, compassBar + osdGetHeadingIntoDiscreteDirections(DECIDEGREES_TO_DEGREES(attitude.values.yaw), 16), 9);
+        memcpy(buff, compassBar + osdGetHeadingIntoDiscreteDirections(DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw), 16), 9);
         buff[9] = 0;
         break;
 
     case OSD_ALTITUDE:
-        osdFormatAltitudeString(buff, getEstimatedAltitude());
+        osdFormatAltitudeString(buff, osdSnapshot.altitude);
         break;
 
     case OSD_ITEM_TIMER_1:
@@ -560,7 +761,7 @@ static bool osdDrawSingleElement(uint8_t item)
 
     case OSD_REMAINING_TIME_ESTIMATE:
         {
-            const int mAhDrawn = getMAhDrawn();
+            const int mAhDrawn = osdSnapshot.mAhDrawn;
             const int remaining_time = (int)((osdConfig()->cap_alarm - mAhDrawn) * ((float)flyTime) / mAhDrawn);
 
             if (mAhDrawn < 0.1 * osdConfig()->cap_alarm) {
@@ -573,6 +774,19 @@ static bool osdDrawSingleElement(uint8_t item)
             break;
         }
 
+    case OSD_BATTERY_TIME_REMAINING:
+        {
+            // time until the battery capacity is used up at the present draw
+            const int32_t remainingTime = getBatteryRemainingTime();
+            if (remainingTime < 0) {
+                tfp_sprintf(buff, "%c--:--", SYM_MAIN_BATT);
+            } else {
+                buff[0] = SYM_MAIN_BATT;
+                osdFormatTime(buff + 1, OSD_TIMER_PREC_SECOND, MIN(remainingTime, 99 * 60 + 59) * 1000000);
+            }
+            break;
+        }
+
     case OSD_FLYMODE:
         {
             if (FLIGHT_MODE(FAILSAFE_MODE)) {
@@ -624,7 +838,7 @@ static bool osdDrawSingleElement(uint8_t item)
     case OSD_THROTTLE_POS:
         buff[0] = SYM_THR;
         buff[1] = SYM_THR1;
-        tfp_sprintf(buff + 2, "%3d", (constrain(rcData[THROTTLE], PWM_RANGE_MIN, PWM_RANGE_MAX) - PWM_RANGE_MIN) * 100 / (PWM_RANGE_MAX - PWM_RANGE_MIN));
+        i2aPadded((constrain(rcData[THROTTLE], PWM_RANGE_MIN, PWM_RANGE_MAX) - PWM_RANGE_MIN) * 100 / (PWM_RANGE_MAX - PWM_RANGE_MIN), 3, ' ', buff + 2);
         break;
 
 #if defined(USE_VTX_COMMON)
@@ -654,36 +868,61 @@ static bool osdDrawSingleElement(uint8_t item)
             // Get pitch and roll limits in tenths of degrees
             const int maxPitch = osdConfig()->ahMaxPitch * 10;
             const int maxRoll = osdConfig()->ahMaxRoll * 10;
-            const int rollAngle = constrain(attitude.values.roll, -maxRoll, maxRoll);
-            int pitchAngle = constrain(attitude.values.pitch, -maxPitch, maxPitch);
+            const int rollStep = constrain(getAttitude()->values.roll, -maxRoll, maxRoll) / AH_ROLL_STEP;
+            int pitchAngle = constrain(getAttitude()->values.pitch, -maxPitch, maxPitch);
             // Convert pitchAngle to y compensation value
             // (maxPitch / 25) divisor matches previous settings of fixed divisor of 8 and fixed max AHI pitch angle of 20.0 degrees
             pitchAngle = ((pitchAngle * 25) / maxPitch) - 41; // 41 = 4 * AH_SYMBOL_COUNT + 5
 
+            // The line only moves in steps of a ninth of a row, nothing to do while the attitude stays within one
+            osdElementCache_t *cache = &osdElementCache[item];
+            const uint32_t attitude = (uint16_t)rollStep << 16 | (uint16_t)pitchAngle;
+            if (cache->length && cache->hash == attitude && cache->x == elemPosX && cache->y == elemPosY) {
+                return true;
+            }
+
             for (int x = -4; x <= 4; x++) {
-                const int y = ((-rollAngle * x) / 64) - pitchAngle;
+                osdScreenCell_t *cell = &osdAhCells[x + 4];
+                osdScreenCell_t newCell = { 0, 0, 0 };
+                const int y = ((-rollStep * x * AH_ROLL_STEP) / 64) - pitchAngle;
                 if (y >= 0 && y <= 81) {
-                    displayWriteChar(osdDisplayPort, elemPosX + x, elemPosY + (y / AH_SYMBOL_COUNT), (SYM_AH_BAR9_0 + (y % AH_SYMBOL_COUNT)));
+                    newCell.x = elemPosX + x;
+                    newCell.y = elemPosY + (y / AH_SYMBOL_COUNT);
+                    newCell.c = SYM_AH_BAR9_0 + (y % AH_SYMBOL_COUNT);
+                }
+
+                // only touch the cells of the columns that moved
+                const bool samePosition = cell->x == newCell.x && cell->y == newCell.y;
+                const osdScreenCell_t oldCell = *cell;
+                *cell = newCell;
+                if (oldCell.c && (!newCell.c || !samePosition)) {
+                    osdWriteChar(item, oldCell.x, oldCell.y, SYM_BLANK);
+                }
+                if (newCell.c && (newCell.c != oldCell.c || !samePosition)) {
+                    osdWriteChar(item, newCell.x, newCell.y, newCell.c);
                 }
             }
 
+            cache->hash = attitude;
+            cache->x = elemPosX;
+            cache->y = elemPosY;
+            cache->length = 1;
+
             return true;
         }
 
     case OSD_HORIZON_SIDEBARS:
         {
-            // Draw AH sides
-            const int8_t hudwidth = AH_SIDEBAR_WIDTH_POS;
-            const int8_t hudheight = AH_SIDEBAR_HEIGHT_POS;
-            for (int y = -hudheight; y <= hudheight; y++) {
-                displayWriteChar(osdDisplayPort, elemPosX - hudwidth, elemPosY + y, SYM_AH_DECORATION);
-                displayWriteChar(osdDisplayPort, elemPosX + hudwidth, elemPosY + y, SYM_AH_DECORATION);
+            // the sidebars never change, they are only drawn again when moved
+            osdElementCache_t *cache = &osdElementCache[item];
+            if (!cache->length || cache->x != elemPosX || cache->y != elemPosY) {
+                osdEraseElement(item);
+                osdDrawHorizonSidebars(elemPosX, elemPosY, false);
+                cache->x = elemPosX;
+                cache->y = elemPosY;
+                cache->length = 1;
             }
 
-            // AH level indicators
-            displayWriteChar(osdDisplayPort, elemPosX - hudwidth + 1, elemPosY, SYM_AH_LEFT);
-            displayWriteChar(osdDisplayPort, elemPosX + hudwidth - 1, elemPosY, SYM_AH_RIGHT);
-
             return true;
         }
 
@@ -700,8 +939,12 @@ static bool osdDrawSingleElement(uint8_t item)
         break;
 
     case OSD_POWER:
-        tfp_sprintf(buff, "%4dW", getAmperage() * getBatteryVoltage() / 1000);
-        break;
+        {
+            char *p = i2aPadded(osdSnapshot.amperage * osdSnapshot.batteryVoltage / 1000, 4, ' ', buff);
+            *p++ = 'W';
+            *p = '\0';
+            break;
+        }
 
     case OSD_PIDRATE_PROFILE:
         tfp_sprintf(buff, "%d-%d", getCurrentPidProfileIndex() + 1, getCurrentControlRateProfileIndex() + 1);
@@ -715,7 +958,7 @@ static bool osdDrawSingleElement(uint8_t item)
 
             STATIC_ASSERT(OSD_FORMAT_MESSAGE_BUFFER_SIZE <= sizeof(buff), osd_warnings_size_exceeds_buffer_size);
 
-            const batteryState_e batteryState = getBatteryState();
+            const batteryState_e batteryState = osdSnapshot.batteryState;
 
 #ifdef USE_DSHOT
             if (isTryingToArm() && !ARMING_FLAG(ARMED)) {
@@ -826,7 +1069,7 @@ static bool osdDrawSingleElement(uint8_t item)
             }
 
             // Show warning if battery is not fresh
-            if (osdWarnGetState(OSD_WARNING_BATTERY_NOT_FULL) && !ARMING_FLAG(WAS_EVER_ARMED) && (getBatteryState() == BATTERY_OK)
+            if (osdWarnGetState(OSD_WARNING_BATTERY_NOT_FULL) && !ARMING_FLAG(WAS_EVER_ARMED) && (osdSnapshot.batteryState == BATTERY_OK)
                   && getBatteryAverageCellVoltage() < batteryConfig()->vbatfullcellvoltage) {
                 osdFormatMessage(buff, OSD_FORMAT_MESSAGE_BUFFER_SIZE, "BATT < FULL");
                 break;
@@ -857,8 +1100,12 @@ static bool osdDrawSingleElement(uint8_t item)
     case OSD_PITCH_ANGLE:
     case OSD_ROLL_ANGLE:
         {
-            const int angle = (item == OSD_PITCH_ANGLE) ? attitude.values.pitch : attitude.values.roll;
-            tfp_sprintf(buff, "%c%02d.%01d", angle < 0 ? '-' : ' ', abs(angle / 10), abs(angle % 10));
+            const int angle = (item == OSD_PITCH_ANGLE) ? getAttitude()->values.pitch : getAttitude()->values.roll;
+            buff[0] = angle < 0 ? '-' : ' ';
+            char *p = i2aPadded(abs(angle / 10), 2, '0', buff + 1);
+            *p++ = '.';
+            *p++ = '0' + abs(angle % 10);
+            *p = '\0';
             break;
         }
 
@@ -868,7 +1115,7 @@ static bool osdDrawSingleElement(uint8_t item)
             #define MAIN_BATT_USAGE_STEPS 11 // Use an odd number so the bar can be centered.
 
             // Calculate constrained value
-            const float value = constrain(batteryConfig()->batteryCapacity - getMAhDrawn(), 0, batteryConfig()->batteryCapacity);
+            const float value = constrain(batteryConfig()->batteryCapacity - osdSnapshot.mAhDrawn, 0, batteryConfig()->batteryCapacity);
 
             // Calculate mAh used progress
             const uint8_t mAhUsedProgress = ceilf((value / (batteryConfig()->batteryCapacity / MAIN_BATT_USAGE_STEPS)));
@@ -898,8 +1145,9 @@ static bool osdDrawSingleElement(uint8_t item)
 
     case OSD_NUMERICAL_HEADING:
         {
-            const int heading = DECIDEGREES_TO_DEGREES(attitude.values.yaw);
-            tfp_sprintf(buff, "%c%03d", osdGetDirectionSymbolFromHeading(heading), heading);
+            const int heading = DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw);
+            buff[0] = osdGetDirectionSymbolFromHeading(heading);
+            i2aPadded(heading, 3, '0', buff + 1);
             break;
         }
 
@@ -943,64 +1191,139 @@ static bool osdDrawSingleElement(uint8_t item)
         break;
 #endif
 
+#ifdef USE_RX_LINK_STATS
+    case OSD_RX_LINK_STATS:
+        {
+            // good frames and frame errors in the last second
+            rxLinkStats_t linkStats;
+            if (rxGetLinkStats(&linkStats, 0)) {
+                const int errors = linkStats.droppedFrames + linkStats.failsafeFrames + linkStats.crcErrors;
+                tfp_sprintf(buff, "%3dHZ E%d", linkStats.frames - linkStats.droppedFrames - linkStats.failsafeFrames, MIN(errors, 99));
+            }
+            break;
+        }
+#endif
+
     default:
         return false;
     }
 
-    displayWrite(osdDisplayPort, elemPosX, elemPosY, buff);
+    osdWriteElement(item, elemPosX, elemPosY, buff);
 
     return true;
 }
 
-static void osdDrawElements(void)
+// Elements of the frame being drawn. When the scheduler runs short of time the drawing
+// stops and carries on in the next slot, the frame is only sent to the display when complete.
+#define OSD_ELEMENT_DRAW_TIME_US 30
+
+static uint8_t osdElementDrawList[OSD_ITEM_COUNT];
+static uint8_t osdElementDrawCount;
+static uint8_t osdElementDrawIndex;
+static uint32_t osdElementDrawBits[(OSD_ITEM_COUNT + 31) / 32];
+
+static void osdAddElementToDraw(uint8_t item)
 {
-    displayClearScreen(osdDisplayPort);
+    if (osdElementDrawCount < ARRAYLEN(osdElementDrawList)) {
+        bitArraySet(osdElementDrawBits, item);
+        osdElementDrawRank[item] = osdElementDrawCount;
+        osdElementDrawList[osdElementDrawCount++] = item;
+    }
+}
 
+static void osdAddElementsToDraw(void)
+{
     // Hide OSD when OSDSW mode is active
     if (IS_RC_MODE_ACTIVE(BOXOSD)) {
         return;
     }
 
     if (sensors(SENSOR_ACC)) {
-        osdDrawSingleElement(OSD_ARTIFICIAL_HORIZON);
+        osdAddElementToDraw(OSD_ARTIFICIAL_HORIZON);
     }
 
 
     for (unsigned i = 0; i < sizeof(osdElementDisplayOrder); i++) {
-        osdDrawSingleElement(osdElementDisplayOrder[i]);
+        osdAddElementToDraw(osdElementDisplayOrder[i]);
     }
 
 #ifdef USE_GPS
     if (sensors(SENSOR_GPS)) {
-        osdDrawSingleElement(OSD_GPS_SATS);
-        osdDrawSingleElement(OSD_GPS_SPEED);
-        osdDrawSingleElement(OSD_GPS_LAT);
-        osdDrawSingleElement(OSD_GPS_LON);
-        osdDrawSingleElement(OSD_HOME_DIST);
-        osdDrawSingleElement(OSD_HOME_DIR);
+        osdAddElementToDraw(OSD_GPS_SATS);
+        osdAddElementToDraw(OSD_GPS_SPEED);
+        osdAddElementToDraw(OSD_GPS_LAT);
+        osdAddElementToDraw(OSD_GPS_LON);
+        osdAddElementToDraw(OSD_HOME_DIST);
+        osdAddElementToDraw(OSD_HOME_DIR);
     }
 #endif // GPS
 
 #ifdef USE_ESC_SENSOR
     if (feature(FEATURE_ESC_SENSOR)) {
-        osdDrawSingleElement(OSD_ESC_TMP);
-        osdDrawSingleElement(OSD_ESC_RPM);
+        osdAddElementToDraw(OSD_ESC_TMP);
+        osdAddElementToDraw(OSD_ESC_RPM);
     }
 #endif
 
 #ifdef USE_RTC_TIME
-    osdDrawSingleElement(OSD_RTC_DATETIME);
+    osdAddElementToDraw(OSD_RTC_DATETIME);
 #endif
 
 #ifdef USE_OSD_ADJUSTMENTS
-    osdDrawSingleElement(OSD_ADJUSTMENT_RANGE);
+    osdAddElementToDraw(OSD_ADJUSTMENT_RANGE);
 #endif
 
 #ifdef USE_ADC_INTERNAL
-    osdDrawSingleElement(OSD_CORE_TEMPERATURE);
+    osdAddElementToDraw(OSD_CORE_TEMPERATURE);
+#endif
+
+#ifdef USE_RX_LINK_STATS
+    osdAddElementToDraw(OSD_RX_LINK_STATS);
 #endif
 }
 
+static void osdStartDrawElements(timeUs_t currentTimeUs)
+{
+    if (osdRedrawAll || osdDisplayPort->cleared || cmpTimeUs(currentTimeUs, osdFullRedrawAt) >= 0) {
+        displayClearScreen(osdDisplayPort);
+        osdDisplayPort->cleared = false;
+        memset(osdElementCache, 0, sizeof(osdElementCache));
+        memset(osdAhCells, 0, sizeof(osdAhCells));
+        osdRedrawAll = false;
+        osdFullRedrawAt = currentTimeUs + OSD_FULL_REDRAW_INTERVAL_US;
+    }
+
+    osdElementDrawCount = 0;
+    osdElementDrawIndex = 0;
+    memset(osdElementDrawBits, 0, sizeof(osdElementDrawBits));
+
+    osdAddElementsToDraw();
+
+    // elements that are no longer drawn at all leave the screen now
+    for (unsigned i = 0; i < OSD_ITEM_COUNT; i++) {
+        if (!bitArrayGet(osdElementDrawBits, i)) {
+            osdEraseElement(i);
+        }
+    }
+}
+
+static bool osdDrawElementsPending(void)
+{
+    return osdElementDrawIndex < osdElementDrawCount;
+}
+
+// Draws at least one element, yields to the scheduler if it runs out of time before the frame is complete
+static void osdDrawElements(void)
+{
+    do {
+        osdDrawSingleElement(osdElementDrawList[osdElementDrawIndex++]);
+    } while (osdDrawElementsPending() && schedulerGetRemainingTimeUs() >= OSD_ELEMENT_DRAW_TIME_US);
+
+    if (osdDrawElementsPending()) {
+        schedulerYield();
+    }
+}
+
 void pgResetFn_osdConfig(osdConfig_t *osdConfig)
 {
     // Position elements near centre of screen and disabled by default
@@ -1107,16 +1430,16 @@ void osdUpdateAlarms(void)
 {
     // This is overdone?
 
-    int32_t alt = osdGetMetersToSelectedUnit(getEstimatedAltitude()) / 100;
+    int32_t alt = osdSnapshot.altitudeInSelectedUnit / 100;
 
-    if (getRssiPercent() < osdConfig()->rssi_alarm) {
+    if (osdSnapshot.rssiPercent < osdConfig()->rssi_alarm) {
         SET_BLINK(OSD_RSSI_VALUE);
     } else {
         CLR_BLINK(OSD_RSSI_VALUE);
     }
 
     // Determine if the OSD_WARNINGS should blink
-    if (getBatteryState() != BATTERY_OK
+    if (osdSnapshot.batteryState != BATTERY_OK
            && (osdWarnGetState(OSD_WARNING_BATTERY_CRITICAL) || osdWarnGetState(OSD_WARNING_BATTERY_WARNING))
 #ifdef USE_DSHOT
            && (!isTryingToArm())
@@ -1127,7 +1450,7 @@ void osdUpdateAlarms(void)
         CLR_BLINK(OSD_WARNINGS);
     }
 
-    if (getBatteryState() == BATTERY_OK) {
+    if (osdSnapshot.batteryState == BATTERY_OK) {
         CLR_BLINK(OSD_MAIN_BATT_VOLTAGE);
         CLR_BLINK(OSD_AVG_CELL_VOLTAGE);
     } else {
@@ -1152,7 +1475,7 @@ void osdUpdateAlarms(void)
         }
     }
 
-    if (getMAhDrawn() >= osdConfig()->cap_alarm) {
+    if (osdSnapshot.mAhDrawn >= osdConfig()->cap_alarm) {
         SET_BLINK(OSD_MAH_DRAWN);
         SET_BLINK(OSD_MAIN_BATT_USAGE);
         SET_BLINK(OSD_REMAINING_TIME_ESTIMATE);
@@ -1224,22 +1547,22 @@ static void osdUpdateStats(void)
         stats.max_speed = value;
     }
 
-    value = getBatteryVoltage();
+    value = osdSnapshot.batteryVoltage;
     if (stats.min_voltage > value) {
         stats.min_voltage = value;
     }
 
-    value = getAmperage() / 100;
+    value = osdSnapshot.amperage / 100;
     if (stats.max_current < value) {
         stats.max_current = value;
     }
 
-    value = getRssiPercent();
+    value = osdSnapshot.rssiPercent;
     if (stats.min_rssi > value) {
         stats.min_rssi = value;
     }
 
-    int altitude = getEstimatedAltitude();
+    int altitude = osdSnapshot.altitude;
     if (stats.max_altitude < altitude) {
         stats.max_altitude = altitude;
     }
@@ -1256,6 +1579,16 @@ static void osdUpdateStats(void)
 }
 
 #ifdef USE_BLACKBOX
+static bool osdBlackboxDeviceIsStorage(void)
+{
+    // serial and VCP logs are stored by whatever is on the other end
+    return blackboxConfig()->device && blackboxConfig()->device != BLACKBOX_DEVICE_SERIAL
+#ifdef USE_BLACKBOX_VCP
+        && blackboxConfig()->device != BLACKBOX_DEVICE_VCP
+#endif
+        ;
+}
+
 static void osdGetBlackboxStatusString(char * buff)
 {
     bool storageDeviceIsWorking = false;
@@ -1371,7 +1704,7 @@ static void osdShowStats(uint16_t endBatteryVoltage)
     }
 
     if (osdStatGetState(OSD_STAT_BATTERY)) {
-        tfp_sprintf(buff, "%d.%1d%c", getBatteryVoltage() / 10, getBatteryVoltage() % 10, SYM_VOLT);
+        tfp_sprintf(buff, "%d.%1d%c", osdSnapshot.batteryVoltage / 10, osdSnapshot.batteryVoltage % 10, SYM_VOLT);
         osdDisplayStatisticLabel(top++, "BATTERY", buff);
     }
 
@@ -1389,7 +1722,7 @@ static void osdShowStats(uint16_t endBatteryVoltage)
         }
 
         if (osdStatGetState(OSD_STAT_USED_MAH)) {
-            tfp_sprintf(buff, "%d%c", getMAhDrawn(), SYM_MAH);
+            tfp_sprintf(buff, "%d%c", osdSnapshot.mAhDrawn, SYM_MAH);
             osdDisplayStatisticLabel(top++, "USED MAH", buff);
         }
     }
@@ -1400,12 +1733,25 @@ static void osdShowStats(uint16_t endBatteryVoltage)
     }
 
 #ifdef USE_BLACKBOX
-    if (osdStatGetState(OSD_STAT_BLACKBOX) && blackboxConfig()->device && blackboxConfig()->device != BLACKBOX_DEVICE_SERIAL) {
+    if (osdStatGetState(OSD_STAT_BLACKBOX) && osdBlackboxDeviceIsStorage()) {
         osdGetBlackboxStatusString(buff);
         osdDisplayStatisticLabel(top++, "BLACKBOX", buff);
     }
 
-    if (osdStatGetState(OSD_STAT_BLACKBOX_NUMBER) && blackboxConfig()->device && blackboxConfig()->device != BLACKBOX_DEVICE_SERIAL) {
+    if (osdStatGetState(OSD_STAT_BLACKBOX) && blackboxConfig()->device) {
+        blackboxDeviceStats_t bbStats;
+        blackboxDeviceGetStats(&bbStats);
+
+        const uint32_t framesDropped = bbStats.framesDropped[BLACKBOX_FRAME_INTRA] + bbStats.framesDropped[BLACKBOX_FRAME_INTER] + bbStats.framesDropped[BLACKBOX_FRAME_SLOW];
+        if (framesDropped) {
+            tfp_sprintf(buff, "%u", framesDropped);
+            osdDisplayStatisticLabel(top++, "BB DROPPED", buff);
+        }
+        tfp_sprintf(buff, "%uKB/S", bbStats.bytesPerSecond / 1024);
+        osdDisplayStatisticLabel(top++, "BB RATE", buff);
+    }
+
+    if (osdStatGetState(OSD_STAT_BLACKBOX_NUMBER) && osdBlackboxDeviceIsStorage()) {
         itoa(blackboxGetLogNumber(), buff, 10);
         osdDisplayStatisticLabel(top++, "BB LOG NUM", buff);
     }
@@ -1427,6 +1773,8 @@ STATIC_UNIT_TESTED void osdRefresh(timeUs_t currentTimeUs)
     static timeUs_t osdStatsRefreshTimeUs;
     static uint16_t endBatteryVoltage;
 
+    osdUpdateSnapshot();
+
     // detect arm/disarm
     if (armState != ARMING_FLAG(ARMED)) {
         if (ARMING_FLAG(ARMED)) {
@@ -1440,7 +1788,7 @@ STATIC_UNIT_TESTED void osdRefresh(timeUs_t currentTimeUs)
                        || !VISIBLE(osdConfig()->item_pos[OSD_WARNINGS]))) { // suppress stats if runaway takeoff triggered disarm and WARNINGS element is visible
             osdStatsEnabled = true;
             resumeRefreshAt = currentTimeUs + (60 * REFRESH_1S);
-            endBatteryVoltage = getBatteryVoltage();
+            endBatteryVoltage = osdSnapshot.batteryVoltage;
         }
 
         armState = ARMING_FLAG(ARMED);
@@ -1502,10 +1850,15 @@ STATIC_UNIT_TESTED void osdRefresh(timeUs_t currentTimeUs)
 #ifdef USE_CMS
     if (!displayIsGrabbed(osdDisplayPort)) {
         osdUpdateAlarms();
-        osdDrawElements();
+        osdStartDrawElements(currentTimeUs);
+        if (osdDrawElementsPending()) {
+            osdDrawElements();
+        }
         displayHeartbeat(osdDisplayPort);
-#ifdef OSD_CALLS_CMS
     } else {
+        // the CMS owns the screen, start over when it gives it back
+        osdRedrawAll = true;
+#ifdef OSD_CALLS_CMS
         cmsUpdate(currentTimeUs);
 #endif
     }
@@ -1548,7 +1901,14 @@ void osdUpdate(timeUs_t currentTimeUs)
 #endif
 #define STATS_FREQ_DENOM    50
 
-    if (counter % DRAW_FREQ_DENOM == 0) {
+    if (osdDrawElementsPending()) {
+        // finish the frame that ran out of time, unless the CMS took over the display meanwhile
+        if (displayIsGrabbed(osdDisplayPort)) {
+            osdElementDrawCount = 0;
+        } else {
+            osdDrawElements();
+        }
+    } else if (counter % DRAW_FREQ_DENOM == 0) {
         osdRefresh(currentTimeUs);
         showVisualBeeper = false;
     } else {
@@ -95,6 +95,8 @@ typedef enum {
     OSD_ADJUSTMENT_RANGE,
     OSD_CORE_TEMPERATURE,
     OSD_ANTI_GRAVITY,
+    OSD_RX_LINK_STATS,
+    OSD_BATTERY_TIME_REMAINING,
     OSD_ITEM_COUNT // MUST BE LAST
 } osd_items_e;
 
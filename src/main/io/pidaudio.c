@@ -26,8 +26,10 @@
 
 #include "common/axis.h"
 #include "common/maths.h"
+#include "common/utils.h"
 
 #include "drivers/audio.h"
+#include "drivers/swi.h"
 
 #include "fc/rc_modes.h"
 
@@ -39,6 +41,15 @@ static bool pidAudioEnabled = false;
 
 static pidAudioModes_e pidAudioMode = PID_AUDIO_PIDSUM_XY;
 
+#define PID_AUDIO_TONE_NONE 0xFF
+
+// PID sum magnitudes accumulated by the PID loop since the last tone update, the task takes them
+// under SWI_ATOMIC_BLOCK as a preemptive loop can add to them at any time
+static float pidAudioSumX;
+static float pidAudioSumY;
+static uint16_t pidAudioSampleCount;
+static uint8_t pidAudioTone;
+
 void pidAudioInit(void)
 {
     audioSetupIO();
@@ -64,47 +75,81 @@ void pidAudioSetMode(pidAudioModes_e mode)
     pidAudioMode = mode;
 }
 
-void FAST_CODE_NOINLINE pidAudioUpdate(void)
+// Called from the PID loop, only collects the PID sums. The tone is worked out from their
+// average by pidAudioUpdate(), the DAC noise generator and TIM6 do the rest in hardware.
+void FAST_CODE_NOINLINE pidAudioSample(void)
+{
+    if (!pidAudioEnabled) {
+        return;
+    }
+
+    pidAudioSumX += ABS(pidData[FD_ROLL].Sum);
+    pidAudioSumY += ABS(pidData[FD_PITCH].Sum);
+    pidAudioSampleCount++;
+}
+
+void pidAudioUpdate(timeUs_t currentTimeUs)
 {
+    UNUSED(currentTimeUs);
+
     bool newState = IS_RC_MODE_ACTIVE(BOXPIDAUDIO);
 
     if (pidAudioEnabled != newState) {
         if (newState) {
             pidAudioStart();
+            pidAudioTone = PID_AUDIO_TONE_NONE;
         } else {
             pidAudioStop();
         }
-        pidAudioEnabled = newState;
+        SWI_ATOMIC_BLOCK {
+            pidAudioSumX = 0;
+            pidAudioSumY = 0;
+            pidAudioSampleCount = 0;
+            pidAudioEnabled = newState;
+        }
     }
 
     if (!pidAudioEnabled) {
         return;
     }
 
+    float sumX;
+    float sumY;
+    uint16_t sampleCount;
+    SWI_ATOMIC_BLOCK {
+        sumX = pidAudioSumX;
+        sumY = pidAudioSumY;
+        sampleCount = pidAudioSampleCount;
+        pidAudioSumX = 0;
+        pidAudioSumY = 0;
+        pidAudioSampleCount = 0;
+    }
+
+    if (!sampleCount) {
+        return;
+    }
+
+    const uint32_t pidSumX = MIN(sumX / sampleCount, PIDSUM_LIMIT);
+    const uint32_t pidSumY = MIN(sumY / sampleCount, PIDSUM_LIMIT);
+
     uint8_t tone = TONE_MID;
 
     switch (pidAudioMode) {
     case PID_AUDIO_PIDSUM_X:
-        {
-            const uint32_t pidSumX = MIN(ABS(pidData[FD_ROLL].Sum), PIDSUM_LIMIT);
-            tone = scaleRange(pidSumX, 0, PIDSUM_LIMIT, TONE_MAX, TONE_MIN);
-            break;
-        }
+        tone = scaleRange(pidSumX, 0, PIDSUM_LIMIT, TONE_MAX, TONE_MIN);
+        break;
     case PID_AUDIO_PIDSUM_Y:
-        {
-            const uint32_t pidSumY = MIN(ABS(pidData[FD_PITCH].Sum), PIDSUM_LIMIT);
-            tone = scaleRange(pidSumY, 0, PIDSUM_LIMIT, TONE_MAX, TONE_MIN);
-            break;
-        }
+        tone = scaleRange(pidSumY, 0, PIDSUM_LIMIT, TONE_MAX, TONE_MIN);
+        break;
     case PID_AUDIO_PIDSUM_XY:
-        {
-            const uint32_t pidSumXY = MIN((ABS(pidData[FD_ROLL].Sum) + ABS(pidData[FD_PITCH].Sum)) / 2, PIDSUM_LIMIT);
-            tone = scaleRange(pidSumXY, 0, PIDSUM_LIMIT, TONE_MAX, TONE_MIN);
-            break;
-        }
+        tone = scaleRange((pidSumX + pidSumY) / 2, 0, PIDSUM_LIMIT, TONE_MAX, TONE_MIN);
+        break;
     default:
         break;
     }
 
-    audioPlayTone(tone);
+    if (tone != pidAudioTone) {
+        audioPlayTone(tone);
+        pidAudioTone = tone;
+    }
 }
@@ -18,7 +18,10 @@
  * If not, see <http://www.gnu.org/licenses/>.
  */
 
-void pidAudioUpdate(void);
+#include "common/time.h"
+
+void pidAudioSample(void);
+void pidAudioUpdate(timeUs_t currentTimeUs);
 void pidAudioInit(void);
 
 typedef enum {
@@ -108,9 +108,14 @@ static rcdeviceResponseParseContext_t* rcdeviceRespCtxQueueShift(rcdeviceWaiting
 // every time send packet to device, and want to get something from device,
 // it'd better call the method to clear the rx buffer before the packet send,
 // else may be the useless data in rx buffer will cause the response decoding
-// failed.
+// failed. While other requests are waiting, the data in the rx buffer is
+// their responses, so it's only cleared when no response is expected.
 static void runcamDeviceFlushRxBuffer(runcamDevice_t *device)
 {
+    if (watingResponseQueue.itemCount > 0) {
+        return;
+    }
+
     while (serialRxBytesWaiting(device->serialPort) > 0) {
         serialRead(device->serialPort);
     }
@@ -165,7 +170,11 @@ static void runcamDeviceSendRequestAndWaitingResp(runcamDevice_t *device, uint8_
     memcpy(responseCtx.paramData, paramData, paramDataLen);
     responseCtx.paramDataLen = paramDataLen;
     responseCtx.userInfo = userInfo;
-    rcdeviceRespCtxQueuePushRespCtx(&watingResponseQueue, &responseCtx);
+    // the responses are matched to the requests in order, a request without a
+    // place in the queue must not be sent
+    if (!rcdeviceRespCtxQueuePushRespCtx(&watingResponseQueue, &responseCtx)) {
+        return;
+    }
 
     // send packet
     runcamDeviceSendPacket(device, commandID, paramData, paramDataLen);
@@ -261,7 +270,8 @@ static rcdeviceResponseParseContext_t* getWaitingResponse(timeUs_t currentTimeUs
     rcdeviceResponseParseContext_t *respCtx = rcdeviceRespCtxQueuePeekFront(&watingResponseQueue);
     while (respCtx != NULL && respCtx->timeoutTimestamp != 0 && currentTimeUs > respCtx->timeoutTimestamp) {
         if (respCtx->timeoutTimestamp != 0 && currentTimeUs > respCtx->timeoutTimestamp) {
-            if (respCtx->maxRetryTimes > 0) {
+            // a request sent again would be answered after the ones queued behind it
+            if (respCtx->maxRetryTimes > 0 && watingResponseQueue.itemCount == 1) {
                 runcamDeviceSendPacket(respCtx->device, respCtx->command, respCtx->paramData, respCtx->paramDataLen);
                 respCtx->timeoutTimestamp = currentTimeUs + respCtx->timeout;
                 respCtx->maxRetryTimes -= 1;
@@ -283,33 +293,53 @@ static rcdeviceResponseParseContext_t* getWaitingResponse(timeUs_t currentTimeUs
     return respCtx;
 }
 
+uint8_t runcamDeviceWaitingResponses(void)
+{
+    return watingResponseQueue.itemCount;
+}
+
+// copies the bytes of the response frame of the oldest waiting request out of
+// the rx buffer, returns true once the frame is complete
+static bool rcdeviceReceiveFrame(rcdeviceResponseParseContext_t *respCtx)
+{
+    serialPort_t *serialPort = respCtx->device->serialPort;
+    uint32_t bytesWaiting = serialRxBytesWaiting(serialPort);
+
+    while (bytesWaiting > 0 && respCtx->recvRespLen < respCtx->expectedRespLen) {
+        const uint8_t c = serialRead(serialPort);
+        bytesWaiting--;
+
+        // skip anything in front of the header, e.g. the tail of an earlier
+        // response that was longer than expected
+        if (respCtx->recvRespLen == 0 && c != RCDEVICE_PROTOCOL_HEADER) {
+            continue;
+        }
+        respCtx->recvBuf[respCtx->recvRespLen++] = c;
+    }
+
+    return respCtx->recvRespLen == respCtx->expectedRespLen;
+}
+
 void rcdeviceReceive(timeUs_t currentTimeUs) 
 {
     UNUSED(currentTimeUs);
     rcdeviceResponseParseContext_t *respCtx = NULL;
-    while ((respCtx = getWaitingResponse(millis())) != NULL && serialRxBytesWaiting(respCtx->device->serialPort)) {
-        const uint8_t c = serialRead(respCtx->device->serialPort);
-        respCtx->recvBuf[respCtx->recvRespLen] = c;
-        respCtx->recvRespLen += 1;
-        
-        // if data received done, trigger callback to parse response data, and update rcdevice state
-        if (respCtx->recvRespLen == respCtx->expectedRespLen) {
-            // verify the crc value
-            if (respCtx->protocolVer == RCDEVICE_PROTOCOL_VERSION_1_0) {
-                uint8_t crc = 0;
-                for (int i = 0; i < respCtx->recvRespLen; i++) {
-                    crc = crc8_dvb_s2(crc, respCtx->recvBuf[i]);
-                }
-                respCtx->result = (crc == 0) ? RCDEVICE_RESP_SUCCESS : RCDEVICE_RESP_INCORRECT_CRC;
-            }
-
-            if (respCtx->parserFunc != NULL) {
-                respCtx->parserFunc(respCtx);
-            }
+    // responses of pipelined requests arrive in order, so every complete
+    // frame in the rx buffer is handled in this run
+    while ((respCtx = getWaitingResponse(millis())) != NULL && rcdeviceReceiveFrame(respCtx)) {
+        // verify the crc value
+        if (respCtx->protocolVer == RCDEVICE_PROTOCOL_VERSION_1_0) {
+            const uint8_t crc = crc8_dvb_s2_update(0, respCtx->recvBuf, respCtx->recvRespLen);
+            respCtx->result = (crc == 0) ? RCDEVICE_RESP_SUCCESS : RCDEVICE_RESP_INCORRECT_CRC;
+        }
 
-            // dequeue current response context
-            rcdeviceRespCtxQueueShift(&watingResponseQueue);
+        // trigger callback to parse response data, and update rcdevice state
+        if (respCtx->parserFunc != NULL) {
+            respCtx->parserFunc(respCtx);
         }
+
+        // dequeue current response context
+        rcdeviceRespCtxQueueShift(&watingResponseQueue);
     }
 }
 
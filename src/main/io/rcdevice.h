@@ -147,6 +147,7 @@ typedef struct {
 
 void runcamDeviceInit(runcamDevice_t *device);
 void rcdeviceReceive(timeUs_t currentTimeUs);
+uint8_t runcamDeviceWaitingResponses(void);
 
 // camera button simulation
 bool runcamDeviceSimulateCameraButton(runcamDevice_t *device, uint8_t operation);
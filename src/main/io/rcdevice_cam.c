@@ -51,6 +51,8 @@ rcdeviceSwitchState_t switchStates[BOXCAMERA3 - BOXCAMERA1 + 1];
 bool rcdeviceInMenu = false;
 bool isButtonPressed = false;
 bool waitingDeviceResponse = false;
+// the last key event sent was a press, its response may still be outstanding
+static bool keyPressSent = false;
 
 
 static bool isFeatureSupported(uint8_t feature)
@@ -138,6 +140,12 @@ static void rcdeviceSimulationOSDCableFailed(rcdeviceResponseParseContext_t *ctx
     } else {
         rcdeviceInMenu = false;
         waitingDeviceResponse = false;
+        // the failed request is still queued while its callback runs, so a press that is
+        // the only one waiting is the most recent key event. A release or a newer press
+        // sent after it already set keyPressSent for itself.
+        if (ctx->command == RCDEVICE_PROTOCOL_COMMAND_5KEY_SIMULATION_PRESS && runcamDeviceWaitingResponses() == 1) {
+            keyPressSent = false;
+        }
     }
 }
 
@@ -253,11 +261,17 @@ static void rcdevice5KeySimulationProcess(timeUs_t currentTimeUs)
         return;
     }
 
-    if (isButtonPressed) {
+    // key presses and releases don't wait for the response of the previous
+    // event, their responses are matched in order as long as the queue has room
+    if (runcamDeviceWaitingResponses() >= MAX_WAITING_RESPONSES) {
+        return;
+    }
+
+    if (keyPressSent) {
         if (IS_MID(YAW) && IS_MID(PITCH) && IS_MID(ROLL)) {
             if (rcdeviceIs5KeyEnabled()) {
                 rcdeviceSend5KeyOSDCableSimualtionEvent(RCDEVICE_CAM_KEY_RELEASE);
-                waitingDeviceResponse = true;
+                keyPressSent = false;
             }
         }
     } else {
@@ -287,10 +301,16 @@ static void rcdevice5KeySimulationProcess(timeUs_t currentTimeUs)
             }
         }
 
-        if (key != RCDEVICE_CAM_KEY_NONE) {
-            if (rcdeviceIs5KeyEnabled()) {
+        if (key != RCDEVICE_CAM_KEY_NONE && rcdeviceIs5KeyEnabled()) {
+            if (key == RCDEVICE_CAM_KEY_CONNECTION_OPEN || key == RCDEVICE_CAM_KEY_CONNECTION_CLOSE) {
+                // the menu state has to be known before the connection changes
+                if (runcamDeviceWaitingResponses() == 0) {
+                    rcdeviceSend5KeyOSDCableSimualtionEvent(key);
+                    waitingDeviceResponse = true;
+                }
+            } else {
                 rcdeviceSend5KeyOSDCableSimualtionEvent(key);
-                waitingDeviceResponse = true;
+                keyPressSent = true;
             }
         }
     }
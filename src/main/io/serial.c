@@ -26,6 +26,7 @@
 
 #include "build/build_config.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "pg/pg.h"
@@ -422,11 +423,79 @@ void closeSerialPort(serialPort_t *serialPort)
 
     // TODO wait until data has been transmitted.
     serialPort->rxCallback = NULL;
+    serialPort->rxFrameCallback = NULL;
 
     serialPortUsage->function = FUNCTION_NONE;
     serialPortUsage->serialPort = NULL;
 }
 
+#if defined(USE_UART) && !defined(SIMULATOR_BUILD)
+#define SERIAL_UART_COUNT (SERIAL_PORT_USART8 - SERIAL_PORT_USART1 + 1)
+
+typedef struct serialFunctionBufferSizes_s {
+    uint16_t functionMask;
+    uint16_t rx;
+    uint16_t tx;
+} serialFunctionBufferSizes_t;
+
+// UART buffer sizes by function, a port gets the largest sizes of its functions
+static const serialFunctionBufferSizes_t serialFunctionBufferSizes[] = {
+    { FUNCTION_MSP,                                                         128, 256 },
+    { FUNCTION_GPS,                                                         128,  64 }, // short configuration messages out
+    { TELEMETRY_PORT_FUNCTIONS_MASK | FUNCTION_TELEMETRY_IBUS,               64, 128 },
+    { FUNCTION_RX_SERIAL,                                                   128, 128 }, // telemetry frames of up to 64 bytes
+    { FUNCTION_BLACKBOX,                                                     32, 512 },
+    { FUNCTION_ESC_SENSOR | FUNCTION_LIDAR_TF,                               64,  16 },
+    { FUNCTION_VTX_SMARTAUDIO | FUNCTION_VTX_TRAMP | FUNCTION_RCDEVICE,      64,  64 },
+};
+
+// a port without a function is only opened for a serial passthrough
+#define SERIAL_UNUSED_PORT_BUFFER_SIZE 64
+
+// the RAM left in the arena goes to the TX buffers of these, they send the most
+#define SERIAL_BULK_TX_FUNCTIONS (FUNCTION_BLACKBOX | FUNCTION_MSP)
+
+STATIC_UNIT_TESTED void serialUartBufferSizes(uartBufferSizes_t *sizes, uint32_t arenaSize)
+{
+    memset(sizes, 0, SERIAL_UART_COUNT * sizeof(*sizes));
+
+    uint32_t total = 0;
+    unsigned bulkCount = 0;
+    for (int i = 0; i < SERIAL_PORT_COUNT; i++) {
+        const serialPortConfig_t *portConfig = &serialConfig()->portConfigs[i];
+        if (portConfig->identifier == SERIAL_PORT_NONE || portConfig->identifier > SERIAL_PORT_USART8) {
+            continue;
+        }
+        uartBufferSizes_t *size = &sizes[SERIAL_PORT_IDENTIFIER_TO_UARTDEV(portConfig->identifier)];
+        if (!portConfig->functionMask) {
+            size->rx = SERIAL_UNUSED_PORT_BUFFER_SIZE;
+            size->tx = SERIAL_UNUSED_PORT_BUFFER_SIZE;
+        }
+        for (unsigned j = 0; j < ARRAYLEN(serialFunctionBufferSizes); j++) {
+            if (portConfig->functionMask & serialFunctionBufferSizes[j].functionMask) {
+                size->rx = MAX(size->rx, serialFunctionBufferSizes[j].rx);
+                size->tx = MAX(size->tx, serialFunctionBufferSizes[j].tx);
+            }
+        }
+        if (portConfig->functionMask & SERIAL_BULK_TX_FUNCTIONS) {
+            bulkCount++;
+        }
+        total += size->rx + size->tx;
+    }
+
+    if (bulkCount && total < arenaSize) {
+        const uint16_t spare = (arenaSize - total) / bulkCount;
+        for (int i = 0; i < SERIAL_PORT_COUNT; i++) {
+            const serialPortConfig_t *portConfig = &serialConfig()->portConfigs[i];
+            if (portConfig->identifier != SERIAL_PORT_NONE && portConfig->identifier <= SERIAL_PORT_USART8
+                && (portConfig->functionMask & SERIAL_BULK_TX_FUNCTIONS)) {
+                sizes[SERIAL_PORT_IDENTIFIER_TO_UARTDEV(portConfig->identifier)].tx += spare;
+            }
+        }
+    }
+}
+#endif
+
 void serialInit(bool softserialEnabled, serialPortIdentifier_e serialPortToDisable)
 {
 #if !defined(USE_SOFTSERIAL1) && !defined(USE_SOFTSERIAL2)
@@ -471,6 +540,13 @@ void serialInit(bool softserialEnabled, serialPortIdentifier_e serialPortToDisab
             serialPortCount--;
         }
     }
+
+#if defined(USE_UART) && !defined(SIMULATOR_BUILD)
+    // the UART buffers are sized for the port functions, before any port is opened
+    uartBufferSizes_t uartBufferSizes[SERIAL_UART_COUNT];
+    serialUartBufferSizes(uartBufferSizes, uartBufferArenaSize());
+    uartAllocateBuffers(uartBufferSizes);
+#endif
 }
 
 void serialRemovePort(serialPortIdentifier_e identifier)
@@ -512,6 +588,28 @@ static void nopConsumer(uint8_t data)
     UNUSED(data);
 }
 
+#define SERIAL_PASSTHROUGH_CHUNK_SIZE 64 // a full USB packet
+
+// Forward what one side received to the other side, as much of it as the other side takes without waiting. Waiting
+// for one side's transmit buffer would leave the other direction unserviced and its receive buffer overflowing.
+static void serialPassthroughForward(serialPort_t *from, serialPort_t *to, serialConsumer *consumer)
+{
+    uint8_t buf[SERIAL_PASSTHROUGH_CHUNK_SIZE];
+    const uint32_t count = MIN(MIN(serialRxBytesWaiting(from), serialTxBytesFree(to)), sizeof(buf));
+
+    if (count == 0) {
+        return;
+    }
+
+    LED0_ON;
+    for (uint32_t i = 0; i < count; i++) {
+        buf[i] = serialRead(from);
+        consumer(buf[i]);
+    }
+    serialWriteBuf(to, buf, count);
+    LED0_OFF;
+}
+
 /*
  A high-level serial passthrough implementation. Used by cli to start an
  arbitrary serial passthrough "proxy". Optional callbacks can be given to allow
@@ -538,24 +636,8 @@ void serialPassthrough(serialPort_t *left, serialPort_t *right, serialConsumer *
         // implement a guard interval and check for `+++` as an escape sequence
         // to return to CLI command mode.
         // https://en.wikipedia.org/wiki/Escape_sequence#Modem_control
-        if (serialRxBytesWaiting(left)) {
-            LED0_ON;
-            uint8_t c = serialRead(left);
-            // Make sure there is space in the tx buffer
-            while (!serialTxBytesFree(right));
-            serialWrite(right, c);
-            leftC(c);
-            LED0_OFF;
-         }
-         if (serialRxBytesWaiting(right)) {
-             LED0_ON;
-             uint8_t c = serialRead(right);
-             // Make sure there is space in the tx buffer
-             while (!serialTxBytesFree(left));
-             serialWrite(left, c);
-             rightC(c);
-             LED0_OFF;
-         }
-     }
- }
+        serialPassthroughForward(left, right, leftC);
+        serialPassthroughForward(right, left, rightC);
+    }
+}
  #endif
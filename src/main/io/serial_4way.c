@@ -76,7 +76,7 @@
 // *** change to adapt Revision
 #define SERIAL_4WAY_VER_MAIN 20
 #define SERIAL_4WAY_VER_SUB_1 (uint8_t) 0
-#define SERIAL_4WAY_VER_SUB_2 (uint8_t) 02
+#define SERIAL_4WAY_VER_SUB_2 (uint8_t) 03
 
 #define SERIAL_4WAY_PROTOCOL_VER 107
 // *** end
@@ -265,6 +265,16 @@ void esc4wayRelease(void)
 //PARAM: uint8_t ADRESS_Hi + ADRESS_Lo + BUffLen + Buffer[0..255]
 //RETURN: ACK
 
+// Posted write to Device Memory of connected Device // Buffer Len is Max 256 Bytes
+// BuffLen = 0 means 256 Bytes
+// ACKed as soon as the frame CRC checks out, the flash write then runs while the host already sends the next frame.
+// A failed write is reported as ACK_D_GENERAL_ERROR on the next command, which is not executed.
+// The whole next frame has to fit the rx buffer of the port (VCP, or 120 byte frames on a 128 byte UART buffer).
+// Available since interface version 20.0.03.
+#define cmd_DeviceWritePosted 0x41   //'A' write
+//PARAM: uint8_t ADRESS_Hi + ADRESS_Lo + BUffLen + Buffer[0..255]
+//RETURN: ACK
+
 
 // responses
 #define ACK_OK                  0x00
@@ -413,6 +423,28 @@ static void WriteByteCrc(uint8_t b)
     CRCout.word = _crc_xmodem_update(CRCout.word, b);
 }
 
+static bool writeFlash(ioMem_t *pMem)
+{
+    switch (CurrentInterfaceMode)
+    {
+        #ifdef USE_SERIAL_4WAY_BLHELI_BOOTLOADER
+        case imSIL_BLB:
+        case imATM_BLB:
+        case imARM_BLB:
+        {
+            return BL_WriteFlash(pMem);
+        }
+        #endif
+        #ifdef USE_SERIAL_4WAY_SK_BOOTLOADER
+        case imSK:
+        {
+            return Stk_WriteFlash(pMem);
+        }
+        #endif
+    }
+    return true;
+}
+
 void esc4wayProcess(serialPort_t *mspPort)
 {
 
@@ -437,6 +469,7 @@ void esc4wayProcess(serialPort_t *mspPort)
     beeperSilence();
 #endif
     bool isExitScheduled = false;
+    bool postedWriteFailed = false;
 
     while (1) {
         // restart looking for new sequence from host
@@ -474,7 +507,11 @@ void esc4wayProcess(serialPort_t *mspPort)
 
         TX_LED_ON;
 
-        if (ACK_OUT == ACK_OK)
+        bool postedWrite = false;
+        if (ACK_OUT == ACK_OK && postedWriteFailed) {
+            ACK_OUT = ACK_D_GENERAL_ERROR;
+            postedWriteFailed = false;
+        } else if (ACK_OUT == ACK_OK)
         {
             // wtf.D_FLASH_ADDR_H=Adress_H;
             // wtf.D_FLASH_ADDR_L=Adress_L;
@@ -752,33 +789,20 @@ void esc4wayProcess(serialPort_t *mspPort)
                     wtf.D_FLASH_ADDR_L=Adress_L;
                     wtf.D_PTR_I = BUF_I;
                     */
-                    switch (CurrentInterfaceMode)
-                    {
-                        #ifdef USE_SERIAL_4WAY_BLHELI_BOOTLOADER
-                        case imSIL_BLB:
-                        case imATM_BLB:
-                        case imARM_BLB:
-                        {
-                            if (!BL_WriteFlash(&ioMem)) {
-                                ACK_OUT = ACK_D_GENERAL_ERROR;
-                            }
-                            break;
-                        }
-                        #endif
-                        #ifdef USE_SERIAL_4WAY_SK_BOOTLOADER
-                        case imSK:
-                        {
-                            if (!Stk_WriteFlash(&ioMem))
-                            {
-                                ACK_OUT = ACK_D_GENERAL_ERROR;
-                            }
-                            break;
-                        }
-                        #endif
+                    if (!writeFlash(&ioMem)) {
+                        ACK_OUT = ACK_D_GENERAL_ERROR;
                     }
                     break;
                 }
 
+                case cmd_DeviceWritePosted:
+                {
+                    // written after the ACK went out, see below
+                    ioMem.D_NUM_BYTES = I_PARAM_LEN;
+                    postedWrite = true;
+                    break;
+                }
+
                 case cmd_DeviceWriteEEprom:
                 {
                     ioMem.D_NUM_BYTES = I_PARAM_LEN;
@@ -888,6 +912,10 @@ void esc4wayProcess(serialPort_t *mspPort)
         WriteByte(CRCout.bytes[0]);
         serialEndWrite(port);
 
+        if (postedWrite && !writeFlash(&ioMem)) {
+            postedWriteFailed = true;
+        }
+
         TX_LED_OFF;
         if (isExitScheduled) {
             esc4wayRelease();
@@ -42,6 +42,8 @@
 
 #include "io/transponder_ir.h"
 
+#include "scheduler/scheduler.h"
+
 PG_REGISTER_WITH_RESET_FN(transponderConfig_t, transponderConfig, PG_TRANSPONDER_CONFIG, 0);
 
 void pgResetFn_transponderConfig(transponderConfig_t *transponderConfig)
@@ -106,6 +108,9 @@ void transponderUpdate(timeUs_t currentTimeUs)
     }
 #endif
 
+    // the DMA buffer is encoded already, so wake up only for the next burst
+    rescheduleTask(TASK_SELF, nextUpdateAtUs - currentTimeUs);
+
     transponderIrTransmit();
 }
 
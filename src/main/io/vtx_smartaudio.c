@@ -53,6 +53,7 @@
 #define SMARTAUDIO_CMD_TIMEOUT       120    // Time until the command is considered lost
 #define SMARTAUDIO_POLLING_INTERVAL  150    // Minimum time between state polling
 #define SMARTAUDIO_POLLING_WINDOW   1000    // Time window after command polling for state change
+#define SMARTAUDIO_MAX_RETRIES         3    // Resends before a set command is dropped
 
 //#define USE_SMARTAUDIO_DPRINTF
 //#define DPRINTF_SERIAL_PORT SERIAL_PORT_USART1
@@ -263,6 +264,7 @@ static timeUs_t sa_lastTransmissionMs = 0;
 static uint8_t sa_outstanding = SA_CMD_NONE; // Outstanding command
 static uint8_t sa_osbuf[32]; // Outstanding comamnd frame for retransmission
 static int sa_oslen;         // And associate length
+static uint8_t sa_osretries; // Number of times the outstanding command was resent
 
 static void saProcessResponse(uint8_t *buf, int len)
 {
@@ -474,6 +476,7 @@ static void saSendFrame(uint8_t *buf, int len)
 
 static void saResendCmd(void)
 {
+    sa_osretries++;
     saSendFrame(sa_osbuf, sa_oslen);
 }
 
@@ -485,14 +488,18 @@ static void saSendCmd(uint8_t *buf, int len)
 
     sa_oslen = len;
     sa_outstanding = (buf[2] >> 1);
+    sa_osretries = 0;
 
     saSendFrame(sa_osbuf, sa_oslen);
 }
 
 // Command queue management
 
+#define SA_CMD_MAX_LEN 7    // SET_FREQ is the longest command
+
+// Queued commands are copies, so a request can be built in a buffer that is reused for the next one
 typedef struct saCmdQueue_s {
-    uint8_t *buf;
+    uint8_t buf[SA_CMD_MAX_LEN];
     int len;
 } saCmdQueue_t;
 
@@ -511,13 +518,24 @@ static bool saQueueFull(void)
     return ((sa_qhead + 1) % SA_QSIZE) == sa_qtail;
 }
 
-static void saQueueCmd(uint8_t *buf, int len)
+// A command with the same bytes that is still queued makes the request redundant
+static bool saQueueContains(const uint8_t *buf, int len)
+{
+    for (uint8_t i = sa_qtail; i != sa_qhead; i = (i + 1) % SA_QSIZE) {
+        if (sa_queue[i].len == len && memcmp(sa_queue[i].buf, buf, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void saQueueCmd(const uint8_t *buf, int len)
 {
-    if (saQueueFull()) {
+    if (saQueueFull() || len > SA_CMD_MAX_LEN || saQueueContains(buf, len)) {
          return;
     }
 
-    sa_queue[sa_qhead].buf = buf;
+    memcpy(sa_queue[sa_qhead].buf, buf, len);
     sa_queue[sa_qhead].len = len;
     sa_qhead = (sa_qhead + 1) % SA_QSIZE;
 }
@@ -548,8 +566,8 @@ static bool saValidateFreq(uint16_t freq)
 
 static void saDoDevSetFreq(uint16_t freq)
 {
-    static uint8_t buf[7] = { 0xAA, 0x55, SACMD(SA_CMD_SET_FREQ), 2 };
-    static uint8_t switchBuf[7];
+    uint8_t buf[7] = { 0xAA, 0x55, SACMD(SA_CMD_SET_FREQ), 2 };
+    uint8_t switchBuf[7];
 
     if (freq & SA_FREQ_GETPIT) {
         dprintf(("smartAudioSetFreq: GETPIT\r\n"));
@@ -565,8 +583,9 @@ static void saDoDevSetFreq(uint16_t freq)
 
     // Need to work around apparent SmartAudio bug when going from 'channel'
     // to 'user-freq' mode, where the set-freq command will fail if the freq
-    // value is unchanged from the previous 'user-freq' mode
-    if ((saDevice.mode & SA_MODE_GET_FREQ_BY_FREQ) == 0 && freq == saDevice.freq) {
+    // value is unchanged from the previous 'user-freq' mode. Skip it when the
+    // same set-freq is still queued, its switch command is queued ahead of it.
+    if ((saDevice.mode & SA_MODE_GET_FREQ_BY_FREQ) == 0 && freq == saDevice.freq && !saQueueContains(buf, sizeof(buf))) {
         memcpy(&switchBuf, &buf, sizeof(buf));
         const uint16_t switchFreq = freq + ((freq == VTX_SMARTAUDIO_MAX_FREQUENCY_MHZ) ? -1 : 1);
         switchBuf[4] = (switchFreq >> 8);
@@ -744,12 +763,20 @@ static void vtxSAProcess(vtxDevice_t *vtxDevice, timeUs_t currentTimeUs)
     timeMs_t nowMs = millis();             // Don't substitute with "currentTimeUs / 1000"; sa_lastTransmissionMs is based on millis().
     static timeMs_t lastCommandSentMs = 0; // Last non-GET_SETTINGS sent
 
-    if ((sa_outstanding != SA_CMD_NONE) && (nowMs - sa_lastTransmissionMs > SMARTAUDIO_CMD_TIMEOUT)) {
-        // Last command timed out
-        // dprintf(("process: resending 0x%x\r\n", sa_outstanding));
-        // XXX Todo: Resend termination and possible offline transition
-        saResendCmd();
-    lastCommandSentMs = nowMs;
+    if (sa_outstanding != SA_CMD_NONE) {
+        // Only one command is in flight; wait for its response or time out
+        if (nowMs - sa_lastTransmissionMs > SMARTAUDIO_CMD_TIMEOUT) {
+            // Last command timed out. Give up on set commands after a few
+            // resends; GetSettings keeps going as it detects the device.
+            if (sa_outstanding == SA_CMD_GET_SETTINGS || sa_osretries < SMARTAUDIO_MAX_RETRIES) {
+                // dprintf(("process: resending 0x%x\r\n", sa_outstanding));
+                saResendCmd();
+            } else {
+                dprintf(("process: dropping 0x%x\r\n", sa_outstanding));
+                sa_outstanding = SA_CMD_NONE;
+            }
+            lastCommandSentMs = nowMs;
+        }
     } else if (!saQueueEmpty()) {
         // Command pending. Send it.
         // dprintf(("process: sending queue\r\n"));
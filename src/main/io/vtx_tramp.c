@@ -104,6 +104,9 @@ uint8_t  trampFreqRetries = 0;
 uint16_t trampConfPower = 0;
 uint8_t  trampPowerRetries = 0;
 
+// Status queries sent without a reply while checking a set command
+static uint8_t trampCheckQueries = 0;
+
 static void trampWriteBuf(uint8_t *buf)
 {
     serialWriteBuf(trampSerialPort, buf, 16);
@@ -453,6 +456,7 @@ static void vtxTrampProcess(vtxDevice_t *vtxDevice, timeUs_t currentTimeUs)
 
             if (!done) {
                 trampStatus = TRAMP_STATUS_CHECK_FREQ_PW;
+                trampCheckQueries = 0;
 
                 // delay next status query by 300ms
                 lastQueryTimeUs = currentTimeUs + 300 * 1000;
@@ -469,7 +473,16 @@ static void vtxTrampProcess(vtxDevice_t *vtxDevice, timeUs_t currentTimeUs)
 
     case TRAMP_STATUS_CHECK_FREQ_PW:
         if (cmp32(currentTimeUs, lastQueryTimeUs) > 200 * 1000) {
-            trampQueryV();
+            if (trampCheckQueries > TRAMP_MAX_RETRIES) {
+                // device stopped answering, give up on the pending change
+                trampStatus = TRAMP_STATUS_ONLINE;
+                trampConfFreq  = trampCurFreq;
+                trampConfPower = trampPower;
+                trampFreqRetries = trampPowerRetries = 0;
+            } else {
+                trampQueryV();
+                trampCheckQueries++;
+            }
             lastQueryTimeUs = currentTimeUs;
         }
         break;
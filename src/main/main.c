@@ -41,9 +41,14 @@ int main(void)
 void FAST_CODE FAST_CODE_NOINLINE run(void)
 {
     while (true) {
+#ifdef SIMULATOR_LOCKSTEP
+        if (!simulatorLockstepTick()) {
+            continue;
+        }
+#endif
         scheduler();
         processLoopback();
-#ifdef SIMULATOR_BUILD
+#if defined(SIMULATOR_BUILD) && !defined(SIMULATOR_LOCKSTEP)
         delayMicroseconds_real(50); // max rate 20kHz
 #endif
     }
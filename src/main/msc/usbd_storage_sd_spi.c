@@ -215,6 +215,15 @@ static int8_t STORAGE_Read (uint8_t lun,
 {
 	UNUSED(lun);
 	LED1_ON;
+	// Hosts read sequentially, so keep a multi-block read open that the next request can carry on with
+	sdcardOperationStatus_e status;
+	while ((status = sdcard_beginReadBlocks(blk_addr)) == SDCARD_OPERATION_BUSY) {
+		sdcard_poll();
+	}
+	if (status != SDCARD_OPERATION_SUCCESS) {
+		LED1_OFF;
+		return -1;
+	}
 	for (int i = 0; i < blk_len; i++) {
 	    while (sdcard_readBlock(blk_addr + i, buf + (512 * i), NULL, NULL) == 0);
 		while (sdcard_poll() == 0);
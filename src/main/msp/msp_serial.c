@@ -26,11 +26,13 @@
 
 #include "build/debug.h"
 
+#include "common/maths.h"
 #include "common/streambuf.h"
 #include "common/utils.h"
 #include "common/crc.h"
 
 #include "drivers/system.h"
+#include "drivers/time.h"
 
 #include "interface/msp.h"
 #include "interface/cli.h"
@@ -41,6 +43,19 @@
 
 static mspPort_t mspPorts[MAX_MSP_PORT_COUNT];
 
+static uint8_t mspSerialOutBuf[MSP_PORT_OUTBUF_SIZE];
+
+// Stream frames are only built when they fit in the TX buffer along with the largest MSP header and checksums
+#define MSP_STREAM_FRAME_OVERHEAD 16
+#define MSP_STREAM_MIN_PAYLOAD 64
+#define MSP_STREAM_FRAMES_PER_CALL 4
+
+// Bound the work of one mspSerialProcess() call, a flood on one port must not starve the others or stretch the task
+#define MSP_PORT_RX_BYTES_PER_CALL 128
+#define MSP_SERIAL_PROCESS_BUDGET_US 500
+
+static uint8_t mspFirstPortIndex; // ports are served round robin, the first one skipped by the budget goes first next call
+
 static void resetMspPort(mspPort_t *mspPortToReset, serialPort_t *serialPort, bool sharedWithTelemetry)
 {
     memset(mspPortToReset, 0, sizeof(mspPort_t));
@@ -382,10 +397,8 @@ static int mspSerialEncode(mspPort_t *msp, mspPacket_t *packet, mspVersion_e msp
 
 static mspPostProcessFnPtr mspSerialProcessReceivedCommand(mspPort_t *msp, mspProcessCommandFnPtr mspProcessCommandFn)
 {
-    static uint8_t outBuf[MSP_PORT_OUTBUF_SIZE];
-
     mspPacket_t reply = {
-        .buf = { .ptr = outBuf, .end = ARRAYEND(outBuf), },
+        .buf = { .ptr = mspSerialOutBuf, .end = ARRAYEND(mspSerialOutBuf), },
         .cmd = -1,
         .flags = 0,
         .result = 0,
@@ -412,6 +425,131 @@ static mspPostProcessFnPtr mspSerialProcessReceivedCommand(mspPort_t *msp, mspPr
     return mspPostProcessFn;
 }
 
+/*
+ * Push the next frames of the stream running on the port. Frames are only built once the TX buffer has room for
+ * them, which is the flow control: a slow link just gets smaller or fewer frames.
+ */
+static void mspSerialProcessStream(mspPort_t *msp)
+{
+    for (int i = 0; i < MSP_STREAM_FRAMES_PER_CALL && msp->streamFn; i++) {
+        const int payloadSpace = MIN((int)serialTxBytesFree(msp->port) - MSP_STREAM_FRAME_OVERHEAD, (int)sizeof(mspSerialOutBuf));
+        if (payloadSpace < MSP_STREAM_MIN_PAYLOAD) {
+            return;
+        }
+
+        mspPacket_t frame = {
+            .buf = { .ptr = mspSerialOutBuf, .end = mspSerialOutBuf + payloadSpace, },
+            .cmd = msp->streamCmd,
+            .flags = 0,
+            .result = 0,
+            .direction = MSP_DIRECTION_REPLY,
+        };
+
+        if (!msp->streamFn(&frame.buf)) {
+            msp->streamFn = NULL;
+            return;
+        }
+
+        sbufSwitchToReader(&frame.buf, mspSerialOutBuf);
+        mspSerialEncode(msp, &frame, msp->mspVersion);
+    }
+}
+
+/*
+ * Start pushing frames from streamFn to the MSP port, until the stream ends or another command arrives on the port.
+ * Call from the post process function of the command that requested the stream.
+ */
+void mspSerialStartStream(serialPort_t *serialPort, int16_t cmd, mspStreamFnPtr streamFn)
+{
+    for (uint8_t portIndex = 0; portIndex < MAX_MSP_PORT_COUNT; portIndex++) {
+        mspPort_t *candidateMspPort = &mspPorts[portIndex];
+        if (candidateMspPort->port == serialPort) {
+            candidateMspPort->streamCmd = cmd;
+            candidateMspPort->streamFn = streamFn;
+        }
+    }
+}
+
+#ifdef USE_MSP_SUBSCRIPTIONS
+/*
+ * Push the replies of the port's subscriptions that are due. Subscriptions may use up to half of the link's bandwidth,
+ * leaving the rest for requests; due replies that don't fit in that budget are sent on a later call.
+ */
+static void mspSerialProcessSubscriptions(mspPort_t *msp, mspProcessCommandFnPtr mspProcessCommandFn)
+{
+    const timeMs_t now = millis();
+    const int32_t budgetLimit = sizeof(mspSerialOutBuf) + MSP_STREAM_FRAME_OVERHEAD;
+
+    // 10 bits per byte on the wire, half of them available to subscriptions. Virtual ports (USB VCP) have no baud rate.
+    const uint32_t baudRate = msp->port->baudRate ? msp->port->baudRate : 115200;
+    const uint32_t elapsedMs = MIN(now - msp->subscriptionBudgetMs, 1000U);
+    msp->subscriptionBudget += (int32_t)(elapsedMs * (baudRate / 20) / 1000);
+    msp->subscriptionBudget = MIN(msp->subscriptionBudget, budgetLimit);
+    msp->subscriptionBudgetMs = now;
+
+    for (int i = 0; i < msp->subscriptionCount && msp->subscriptionBudget > 0; i++) {
+        mspSubscription_t *subscription = &msp->subscriptions[i];
+        if (cmp32(now, subscription->nextDueMs) < 0) {
+            continue;
+        }
+
+        mspPacket_t command = {
+            .buf = { .ptr = NULL, .end = NULL, },
+            .cmd = subscription->cmd,
+            .flags = 0,
+            .result = 0,
+            .direction = MSP_DIRECTION_REQUEST,
+        };
+        mspPacket_t reply = {
+            .buf = { .ptr = mspSerialOutBuf, .end = ARRAYEND(mspSerialOutBuf), },
+            .cmd = -1,
+            .flags = 0,
+            .result = 0,
+            .direction = MSP_DIRECTION_REPLY,
+        };
+        mspPostProcessFnPtr mspPostProcessFn = NULL;
+
+        if (mspProcessCommandFn(&command, &reply, &mspPostProcessFn) != MSP_RESULT_NO_REPLY) {
+            sbufSwitchToReader(&reply.buf, mspSerialOutBuf);
+            const int sent = mspSerialEncode(msp, &reply, msp->mspVersion);
+            if (!sent) {
+                // TX buffer is full, try again next time
+                return;
+            }
+            msp->subscriptionBudget -= sent;
+        }
+
+        // Keep a steady rate, but don't try to catch up after falling behind
+        subscription->nextDueMs += subscription->periodMs;
+        if (cmp32(now, subscription->nextDueMs) >= 0) {
+            subscription->nextDueMs = now + subscription->periodMs;
+        }
+    }
+}
+
+/*
+ * Replace the subscriptions of the port, an empty list cancels them. Call from the post process function of the
+ * command that requested them.
+ */
+void mspSerialSetSubscriptions(serialPort_t *serialPort, const mspSubscription_t *subscriptions, int count)
+{
+    for (uint8_t portIndex = 0; portIndex < MAX_MSP_PORT_COUNT; portIndex++) {
+        mspPort_t *candidateMspPort = &mspPorts[portIndex];
+        if (candidateMspPort->port == serialPort) {
+            const timeMs_t now = millis();
+
+            candidateMspPort->subscriptionCount = MIN(count, MSP_MAX_SUBSCRIPTIONS);
+            for (int i = 0; i < candidateMspPort->subscriptionCount; i++) {
+                candidateMspPort->subscriptions[i] = subscriptions[i];
+                candidateMspPort->subscriptions[i].nextDueMs = now;
+            }
+            candidateMspPort->subscriptionBudget = 0;
+            candidateMspPort->subscriptionBudgetMs = now;
+        }
+    }
+}
+#endif
+
 static void mspEvaluateNonMspData(mspPort_t * mspPort, uint8_t receivedChar)
 {
 #ifdef USE_CLI
@@ -473,12 +611,22 @@ static void mspSerialProcessReceivedReply(mspPort_t *msp, mspProcessReplyFnPtr m
  */
 void mspSerialProcess(mspEvaluateNonMspData_e evaluateNonMspData, mspProcessCommandFnPtr mspProcessCommandFn, mspProcessReplyFnPtr mspProcessReplyFn)
 {
-    for (uint8_t portIndex = 0; portIndex < MAX_MSP_PORT_COUNT; portIndex++) {
+    const timeUs_t startUs = micros();
+    const uint8_t firstPortIndex = mspFirstPortIndex;
+    mspFirstPortIndex = (firstPortIndex + 1) % MAX_MSP_PORT_COUNT;
+
+    for (uint8_t i = 0; i < MAX_MSP_PORT_COUNT; i++) {
+        const uint8_t portIndex = (firstPortIndex + i) % MAX_MSP_PORT_COUNT;
         mspPort_t * const mspPort = &mspPorts[portIndex];
         if (!mspPort->port) {
             continue;
         }
 
+        if (i > 0 && cmpTimeUs(micros(), startUs) >= MSP_SERIAL_PROCESS_BUDGET_US) {
+            mspFirstPortIndex = portIndex;
+            break;
+        }
+
         mspPostProcessFnPtr mspPostProcessFn = NULL;
 
         if (serialRxBytesWaiting(mspPort->port)) {
@@ -486,7 +634,8 @@ void mspSerialProcess(mspEvaluateNonMspData_e evaluateNonMspData, mspProcessComm
             mspPort->lastActivityMs = millis();
             mspPort->pendingRequest = MSP_PENDING_NONE;
 
-            while (serialRxBytesWaiting(mspPort->port)) {
+            // whatever is left over is picked up on the next call, mspSerialWaiting() keeps the task coming back for it
+            for (int bytes = 0; bytes < MSP_PORT_RX_BYTES_PER_CALL && serialRxBytesWaiting(mspPort->port); bytes++) {
                 const uint8_t c = serialRead(mspPort->port);
                 const bool consumed = mspSerialProcessReceivedData(mspPort, c);
 
@@ -495,6 +644,9 @@ void mspSerialProcess(mspEvaluateNonMspData_e evaluateNonMspData, mspProcessComm
                 }
 
                 if (mspPort->c_state == MSP_COMMAND_RECEIVED) {
+                    // Any command cancels a running stream
+                    mspPort->streamFn = NULL;
+
                     if (mspPort->packetType == MSP_PACKET_COMMAND) {
                         mspPostProcessFn = mspSerialProcessReceivedCommand(mspPort, mspProcessCommandFn);
                     } else if (mspPort->packetType == MSP_PACKET_REPLY) {
@@ -514,6 +666,16 @@ void mspSerialProcess(mspEvaluateNonMspData_e evaluateNonMspData, mspProcessComm
         else {
             mspProcessPendingRequest(mspPort);
         }
+
+        if (mspPort->streamFn) {
+            mspSerialProcessStream(mspPort);
+        }
+
+#ifdef USE_MSP_SUBSCRIPTIONS
+        if (mspPort->subscriptionCount) {
+            mspSerialProcessSubscriptions(mspPort, mspProcessCommandFn);
+        }
+#endif
     }
 }
 
@@ -93,6 +93,14 @@ typedef struct __attribute__((packed)) {
 
 #define MSP_MAX_HEADER_SIZE     9
 
+#define MSP_MAX_SUBSCRIPTIONS   8
+
+typedef struct mspSubscription_s {
+    uint8_t cmd;
+    uint16_t periodMs;
+    timeMs_t nextDueMs;
+} mspSubscription_t;
+
 struct serialPort_s;
 typedef struct mspPort_s {
     struct serialPort_s *port; // null when port unused.
@@ -109,6 +117,14 @@ typedef struct mspPort_s {
     uint8_t checksum1;
     uint8_t checksum2;
     bool sharedWithTelemetry;
+    mspStreamFnPtr streamFn;    // non-null while frames are pushed to the port without further requests
+    int16_t streamCmd;
+#ifdef USE_MSP_SUBSCRIPTIONS
+    mspSubscription_t subscriptions[MSP_MAX_SUBSCRIPTIONS]; // replies pushed to the port at a fixed rate each
+    uint8_t subscriptionCount;
+    int32_t subscriptionBudget; // bytes the subscriptions may still send, refilled at half the link rate
+    timeMs_t subscriptionBudgetMs;
+#endif
 } mspPort_t;
 
 void mspSerialInit(void);
@@ -118,4 +134,6 @@ void mspSerialAllocatePorts(void);
 void mspSerialReleasePortIfAllocated(struct serialPort_s *serialPort);
 void mspSerialReleaseSharedTelemetryPorts(void);
 int mspSerialPush(uint8_t cmd, uint8_t *data, int datalen, mspDirection_e direction);
+void mspSerialStartStream(struct serialPort_s *serialPort, int16_t cmd, mspStreamFnPtr streamFn);
+void mspSerialSetSubscriptions(struct serialPort_s *serialPort, const mspSubscription_t *subscriptions, int count);
 uint32_t mspSerialTxBytesFree(void);
@@ -33,7 +33,7 @@
 
 #include "flash.h"
 
-PG_REGISTER_WITH_RESET_FN(flashConfig_t, flashConfig, PG_FLASH_CONFIG, 0);
+PG_REGISTER_WITH_RESET_FN(flashConfig_t, flashConfig, PG_FLASH_CONFIG, 3);
 
 void pgResetFn_flashConfig(flashConfig_t *flashConfig)
 {
@@ -29,6 +29,9 @@
 typedef struct flashConfig_s {
     ioTag_t csTag;
     uint8_t spiDevice;
+    uint8_t eraseAheadSectors;              // sectors kept erased ahead of the flashfs write position, 0 = off
+    uint8_t dieInterleave;                  // alternate page programs between the dies of a stacked die chip
+    uint8_t logIndex;                       // keep a table of the logs in the last sector of the chip
 } flashConfig_t;
 
 PG_DECLARE(flashConfig_t, flashConfig);
@@ -30,8 +30,15 @@
 
 const pgRegistry_t* pgFind(pgn_t pgn)
 {
+    // Callers such as the CLI dump look up the same group for many settings in a row
+    static const pgRegistry_t *lastFound;
+
+    if (lastFound && pgN(lastFound) == pgn) {
+        return lastFound;
+    }
     PG_FOREACH(reg) {
         if (pgN(reg) == pgn) {
+            lastFound = reg;
             return reg;
         }
     }
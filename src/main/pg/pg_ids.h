@@ -133,7 +133,10 @@
 #define PG_SPI_PREINIT_OPU_CONFIG 536
 #define PG_RX_SPI_CONFIG 537
 #define PG_BOARD_CONFIG 538
-#define PG_BETAFLIGHT_END 538
+#define PG_RPM_FILTER_CONFIG 539
+#define PG_GYRO_TEMP_COMP_CONFIG 540
+#define PG_SENSOR_DETECTION_CACHE 541
+#define PG_BETAFLIGHT_END 541
 
 
 // OSD configuration (subject to change)
@@ -56,6 +56,7 @@ typedef struct rxConfig_s {
     uint8_t rc_smoothing_debug_axis;        // Axis to log as debug values when debug_mode = RC_SMOOTHING
     uint8_t rc_smoothing_input_type;        // Input filter type (0 = PT1, 1 = BIQUAD)
     uint8_t rc_smoothing_derivative_type;   // Derivative filter type (0 = OFF, 1 = PT1, 2 = BIQUAD)
+    uint8_t ppm_pwm_filter;                 // How the last PPM/PWM samples of a channel are combined (0 = AVERAGE, 1 = MEDIAN)
 } rxConfig_t;
 
 PG_DECLARE(rxConfig_t, rxConfig);
@@ -232,7 +232,7 @@ rx_spi_received_e frSkyDHandlePacket(uint8_t * const packet, uint8_t * const pro
                                 *protocolState = STATE_UPDATE;
                             }
                             ret = RX_SPI_RECEIVED_DATA;
-                            lastPacketReceivedTime = currentPacketReceivedTime;
+                            lastPacketReceivedTime = packetReceivedTimeUs(currentPacketReceivedTime);
                         }
                     }
                 }
@@ -32,6 +32,7 @@
 #include "pg/rx_spi.h"
 
 #include "drivers/rx/rx_cc2500.h"
+#include "drivers/rx/rx_spi.h"
 #include "drivers/io.h"
 #include "drivers/time.h"
 
@@ -468,6 +469,18 @@ void frSkySpiSetRcData(uint16_t *rcData, const uint8_t *payload)
     setRcData(rcData, payload);
 }
 
+// Time the packet now in the FIFO arrived. With GDO0 on an EXTI the channel hopping and the telemetry
+// slot follow the transmitter rather than the moment TASK_RX polled the radio.
+timeUs_t packetReceivedTimeUs(timeUs_t currentTimeUs)
+{
+#ifdef USE_EXTI
+    if (rxSpiExtiConfigured()) {
+        return rxSpiGetLastExtiTimeUs();
+    }
+#endif
+    return currentTimeUs;
+}
+
 void nextChannel(uint8_t skip)
 {
     static uint8_t channr = 0;
@@ -558,6 +571,9 @@ bool frSkySpiInit(const rxSpiConfig_t *rxSpiConfig, rxRuntimeConfig_t *rxRuntime
     gdoPin = IOGetByTag(IO_TAG(RX_FRSKY_SPI_GDO_0_PIN));
     IOInit(gdoPin, OWNER_RX_SPI, 0);
     IOConfigGPIO(gdoPin, IOCFG_IN_FLOATING);
+#ifdef USE_EXTI
+    rxSpiExtiInit(gdoPin);
+#endif
     frSkyLedPin = IOGetByTag(IO_TAG(RX_FRSKY_SPI_LED_PIN));
     IOInit(frSkyLedPin, OWNER_LED, 0);
     IOConfigGPIO(frSkyLedPin, IOCFG_OUT_PP);
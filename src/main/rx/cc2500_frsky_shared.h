@@ -69,3 +69,5 @@ void initialiseData(uint8_t adr);
 bool checkBindRequested(bool reset);
 
 void nextChannel(uint8_t skip);
+
+timeUs_t packetReceivedTimeUs(timeUs_t currentTimeUs);
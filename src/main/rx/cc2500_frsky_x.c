@@ -425,7 +425,7 @@ rx_spi_received_e frSkyXHandlePacket(uint8_t * const packet, uint8_t * const pro
                                  receiveTelemetryRetryCount = 0;
                              }
 
-                            packetTimerUs = micros();
+                            packetTimerUs = packetReceivedTimeUs(micros());
                             frameReceived = true; // no need to process frame again.
                         }
                     }
@@ -48,9 +48,13 @@
 
 #include "telemetry/crsf.h"
 
-#define CRSF_TIME_NEEDED_PER_FRAME_US   1100 // 700 ms + 400 ms for potential ad-hoc request
+#define CRSF_TIME_NEEDED_PER_FRAME_US   1100 // 700 ms + 400 ms for potential ad-hoc request, at CRSF_BAUDRATE
 #define CRSF_TIME_BETWEEN_FRAMES_US     6667 // At fastest, frames are sent by the transmitter every 6.667 milliseconds, 150 Hz
 
+#define CRSF_RC_FRAME_INTERVAL_MAX_US   50000   // longer gaps are lost frames and don't count towards the cadence
+#define CRSF_TELEMETRY_SLOT_GUARD_US    50      // a reply must end this long before the next RC frame is due
+#define CRSF_BAUDRATE_FALLBACK_US       1000000 // a negotiated baud rate is dropped after this long without a good RC frame
+
 #define CRSF_DIGITAL_CHANNEL_MIN 172
 #define CRSF_DIGITAL_CHANNEL_MAX 1811
 
@@ -62,9 +66,36 @@ STATIC_UNIT_TESTED uint32_t crsfChannelData[CRSF_MAX_CHANNEL];
 
 static serialPort_t *serialPort;
 static uint32_t crsfFrameStartAtUs = 0;
+static uint32_t crsfFrameCompleteAtUs = 0;
+static uint32_t crsfRcFrameCompleteAtUs = 0;
+#ifdef USE_RC_PREDICTION
+static uint32_t crsfRcFrameStartAtUs = 0;
+#endif
 static uint8_t telemetryBuf[CRSF_FRAME_SIZE_MAX];
 static uint8_t telemetryBufLen = 0;
 
+static uint32_t crsfBaudRate = CRSF_BAUDRATE;
+static uint32_t crsfFrameTimeoutUs = CRSF_TIME_NEEDED_PER_FRAME_US;
+
+// RC frame cadence, measured in the receive interrupt so telemetry can be fitted in between the RC frames
+static volatile uint32_t crsfLastRcFrameStartAtUs = 0;
+static volatile uint32_t crsfLastRcFrameDurationUs = 0;
+static volatile timeDelta_t crsfRcFrameIntervalUs = 0;   // 0 until measured
+static timeUs_t crsfLastGoodRcFrameUs = 0;
+
+// receive port speed negotiation, the proposal is taken in the interrupt and answered by the RX task
+static volatile bool crsfSpeedProposalPending = false;
+static uint8_t crsfSpeedProposalPortId;
+static uint32_t crsfSpeedProposalBaudRate;
+static uint32_t crsfNextBaudRate = 0;                    // switched to once the response has been sent
+
+static const uint32_t crsfSupportedBaudRates[] = { 115200, 400000, 420000, 921600, 1870000, 2000000, 2250000 };
+
+// link statistics frames are stored as received, the newest at crsfLinkStatisticsCount - 1
+static crsfLinkStatistics_t crsfLinkStatisticsHistory[CRSF_LINK_STATISTICS_HISTORY_COUNT];
+static uint32_t crsfLinkStatisticsCount = 0;     // written by the receive interrupt only, after the entry
+static uint32_t crsfLinkStatisticsCountUsed = 0;
+
 /*
  * CRSF protocol
  *
@@ -82,6 +113,10 @@ static uint8_t telemetryBufLen = 0;
  *
  * CRSF_TIME_NEEDED_PER_FRAME_US is set conservatively at 1500 microseconds
  *
+ * The receiver may propose a higher baud rate with a CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL
+ * command, the port switches over once the response has been sent. High rate links send RC frames
+ * at up to 1kHz, so replies are only sent when they end before the next RC frame is due.
+ *
  * Every frame has the structure:
  * <Device address><Frame length><Type><Payload><CRC>
  *
@@ -124,6 +159,33 @@ STATIC_UNIT_TESTED uint8_t crsfFrameCRC(void)
     return crc;
 }
 
+static void crsfUpdateRcFrameCadence(uint32_t frameStartAtUs, uint32_t frameCompleteAtUs)
+{
+    const timeDelta_t intervalUs = frameStartAtUs - crsfLastRcFrameStartAtUs;
+    if (crsfLastRcFrameStartAtUs && intervalUs < CRSF_RC_FRAME_INTERVAL_MAX_US) {
+        crsfRcFrameIntervalUs = crsfRcFrameIntervalUs ? crsfRcFrameIntervalUs + (intervalUs - crsfRcFrameIntervalUs) / 8 : intervalUs;
+    }
+    crsfLastRcFrameStartAtUs = frameStartAtUs;
+    crsfLastRcFrameDurationUs = frameCompleteAtUs - frameStartAtUs;
+}
+
+// Called from the receive interrupt with a command frame that passed the frame CRC
+static void crsfProcessCommand(int fullFrameLength)
+{
+    const uint8_t *payload = crsfFrame.frame.payload;
+    // the command CRC covers the type and the payload up to itself
+    const uint8_t commandCrc = crc8_poly_0xba_update(0, &crsfFrame.frame.type, fullFrameLength - CRSF_FRAME_LENGTH_ADDRESS - CRSF_FRAME_LENGTH_FRAMELENGTH - 2);
+    if (payload[0] != CRSF_ADDRESS_FLIGHT_CONTROLLER || commandCrc != crsfFrame.bytes[fullFrameLength - 2]) {
+        return;
+    }
+    if (payload[2] == CRSF_COMMAND_SUBCMD_GENERAL && payload[3] == CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL
+        && crsfFrame.frame.frameLength == CRSF_FRAME_SPEED_PROPOSAL_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC) {
+        crsfSpeedProposalPortId = payload[4];
+        crsfSpeedProposalBaudRate = ((uint32_t)payload[5] << 24) | ((uint32_t)payload[6] << 16) | ((uint32_t)payload[7] << 8) | payload[8];
+        crsfSpeedProposalPending = true;
+    }
+}
+
 // Receive ISR callback, called back from serial port
 STATIC_UNIT_TESTED void crsfDataReceive(uint16_t c, void *data)
 {
@@ -136,7 +198,7 @@ STATIC_UNIT_TESTED void crsfDataReceive(uint16_t c, void *data)
     debug[2] = currentTimeUs - crsfFrameStartAtUs;
 #endif
 
-    if (currentTimeUs > crsfFrameStartAtUs + CRSF_TIME_NEEDED_PER_FRAME_US) {
+    if (currentTimeUs > crsfFrameStartAtUs + crsfFrameTimeoutUs) {
         // We've received a character after max time needed to complete a frame,
         // so this must be the start of a new frame.
         crsfFramePosition = 0;
@@ -154,7 +216,13 @@ STATIC_UNIT_TESTED void crsfDataReceive(uint16_t c, void *data)
         crsfFrameDone = crsfFramePosition < fullFrameLength ? false : true;
         if (crsfFrameDone) {
             crsfFramePosition = 0;
-            if (crsfFrame.frame.type != CRSF_FRAMETYPE_RC_CHANNELS_PACKED) {
+            crsfFrameCompleteAtUs = currentTimeUs;
+            if (crsfFrame.frame.type == CRSF_FRAMETYPE_RC_CHANNELS_PACKED) {
+                crsfUpdateRcFrameCadence(crsfFrameStartAtUs, currentTimeUs);
+#ifdef USE_TASK_SIGNAL
+                rxSignalFrameComplete();
+#endif
+            } else {
                 const uint8_t crc = crsfFrameCRC();
                 if (crc == crsfFrame.bytes[fullFrameLength - 1]) {
                     switch (crsfFrame.frame.type)
@@ -172,6 +240,15 @@ STATIC_UNIT_TESTED void crsfDataReceive(uint16_t c, void *data)
                         case CRSF_FRAMETYPE_DEVICE_PING:
                             crsfScheduleDeviceInfoResponse();
                             break;
+                        case CRSF_FRAMETYPE_LINK_STATISTICS:
+                            if (crsfFrame.frame.frameLength == CRSF_FRAME_LINK_STATISTICS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC) {
+                                memcpy(&crsfLinkStatisticsHistory[crsfLinkStatisticsCount % CRSF_LINK_STATISTICS_HISTORY_COUNT], crsfFrame.frame.payload, sizeof(crsfLinkStatistics_t));
+                                __atomic_store_n(&crsfLinkStatisticsCount, crsfLinkStatisticsCount + 1, __ATOMIC_RELEASE);
+                            }
+                            break;
+                        case CRSF_FRAMETYPE_COMMAND:
+                            crsfProcessCommand(fullFrameLength);
+                            break;
 #if defined(USE_CRSF_CMS_TELEMETRY)
                         case CRSF_FRAMETYPE_DISPLAYPORT_CMD: {
                             uint8_t *frameStart = (uint8_t *)&crsfFrame.frame.payload + CRSF_FRAME_ORIGIN_DEST_SIZE;
@@ -188,17 +265,90 @@ STATIC_UNIT_TESTED void crsfDataReceive(uint16_t c, void *data)
     }
 }
 
+static void crsfSetBaudRate(uint32_t baudRate)
+{
+    crsfBaudRate = baudRate;
+    // frames take less time on the wire at higher rates, so a broken one is given up on sooner
+    crsfFrameTimeoutUs = CRSF_TIME_NEEDED_PER_FRAME_US * CRSF_BAUDRATE / baudRate;
+    crsfRcFrameIntervalUs = 0;
+    crsfLastRcFrameStartAtUs = 0;
+    if (serialPort) {
+        serialSetBaudRate(serialPort, baudRate);
+    }
+}
+
+static void crsfProcessSpeedNegotiation(timeUs_t currentTimeUs)
+{
+    if (crsfSpeedProposalPending && telemetryBufLen == 0) {
+        bool accepted = false;
+        for (unsigned ii = 0; ii < ARRAYLEN(crsfSupportedBaudRates); ++ii) {
+            accepted = accepted || crsfSupportedBaudRates[ii] == crsfSpeedProposalBaudRate;
+        }
+
+        uint8_t *frame = telemetryBuf;
+        *frame++ = CRSF_ADDRESS_BROADCAST;
+        *frame++ = CRSF_FRAME_SPEED_RESPONSE_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC;
+        *frame++ = CRSF_FRAMETYPE_COMMAND;
+        *frame++ = CRSF_ADDRESS_CRSF_RECEIVER;
+        *frame++ = CRSF_ADDRESS_FLIGHT_CONTROLLER;
+        *frame++ = CRSF_COMMAND_SUBCMD_GENERAL;
+        *frame++ = CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE;
+        *frame++ = crsfSpeedProposalPortId;
+        *frame++ = accepted;
+        *frame = crc8_poly_0xba_update(0, &telemetryBuf[2], frame - &telemetryBuf[2]);
+        frame++;
+        *frame = crc8_dvb_s2_update(0, &telemetryBuf[2], frame - &telemetryBuf[2]);
+        frame++;
+        telemetryBufLen = frame - telemetryBuf;
+
+        crsfNextBaudRate = accepted ? crsfSpeedProposalBaudRate : 0;
+        crsfSpeedProposalPending = false;
+        // the next RC frame at the new rate starts the fallback timeout
+        crsfLastGoodRcFrameUs = currentTimeUs;
+    }
+
+    if (crsfNextBaudRate && telemetryBufLen == 0 && isSerialTransmitBufferEmpty(serialPort)) {
+        crsfSetBaudRate(crsfNextBaudRate);
+        crsfNextBaudRate = 0;
+    }
+
+    if (crsfBaudRate != CRSF_BAUDRATE && cmpTimeUs(currentTimeUs, crsfLastGoodRcFrameUs) > CRSF_BAUDRATE_FALLBACK_US) {
+        // the receiver most likely restarted, it always starts at the default rate
+        crsfSetBaudRate(CRSF_BAUDRATE);
+    }
+}
+
+static void crsfUpdateRssiFromLinkStatistics(void)
+{
+    const uint32_t count = __atomic_load_n(&crsfLinkStatisticsCount, __ATOMIC_ACQUIRE);
+    if (crsfLinkStatisticsCountUsed != count) {
+        crsfLinkStatisticsCountUsed = count;
+        crsfLinkStatistics_t linkStatistics;
+        if (crsfGetLinkStatistics(&linkStatistics, 0)) {
+            setRssi(MIN(linkStatistics.uplinkLinkQuality, 100) * RSSI_MAX_VALUE / 100, RSSI_SOURCE_RX_PROTOCOL);
+        }
+    }
+}
+
 STATIC_UNIT_TESTED uint8_t crsfFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
 {
     UNUSED(rxRuntimeConfig);
 
+    const timeUs_t currentTimeUs = micros();
+    if (serialPort) {
+        crsfProcessSpeedNegotiation(currentTimeUs);
+        // the response goes out in the first slot between two RC frames
+        crsfRxSendTelemetryData();
+    }
+    crsfUpdateRssiFromLinkStatistics();
+
     if (crsfFrameDone) {
         crsfFrameDone = false;
         if (crsfFrame.frame.type == CRSF_FRAMETYPE_RC_CHANNELS_PACKED) {
             // CRC includes type and payload of each frame
             const uint8_t crc = crsfFrameCRC();
             if (crc != crsfFrame.frame.payload[CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE]) {
-                return RX_FRAME_PENDING;
+                return RX_FRAME_CRC_ERROR;
             }
             // unpack the RC channels
             const crsfPayloadRcChannelsPacked_t* const rcChannels = (crsfPayloadRcChannelsPacked_t*)&crsfFrame.frame.payload;
@@ -218,12 +368,33 @@ STATIC_UNIT_TESTED uint8_t crsfFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
             crsfChannelData[13] = rcChannels->chan13;
             crsfChannelData[14] = rcChannels->chan14;
             crsfChannelData[15] = rcChannels->chan15;
+            crsfRcFrameCompleteAtUs = crsfFrameCompleteAtUs;
+            crsfLastGoodRcFrameUs = currentTimeUs;
+#ifdef USE_RC_PREDICTION
+            crsfRcFrameStartAtUs = crsfFrameStartAtUs;
+#endif
             return RX_FRAME_COMPLETE;
         }
     }
     return RX_FRAME_PENDING;
 }
 
+static timeUs_t crsfFrameCompleteUs(const rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    UNUSED(rxRuntimeConfig);
+
+    return crsfRcFrameCompleteAtUs;
+}
+
+#ifdef USE_RC_PREDICTION
+static timeUs_t crsfFrameTimeUs(const rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    UNUSED(rxRuntimeConfig);
+
+    return crsfRcFrameStartAtUs;
+}
+#endif
+
 STATIC_UNIT_TESTED uint16_t crsfReadRawRC(const rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan)
 {
     UNUSED(rxRuntimeConfig);
@@ -245,13 +416,61 @@ void crsfRxWriteTelemetryData(const void *data, int len)
     telemetryBufLen = len;
 }
 
-void crsfRxSendTelemetryData(void)
+// True if a reply of len bytes sent now ends before the next RC frame is due
+static bool crsfTelemetrySlotOpen(int len)
+{
+    const timeDelta_t intervalUs = crsfRcFrameIntervalUs;
+    if (intervalUs == 0) {
+        // cadence not known yet, send straight away as a static rate link expects
+        return true;
+    }
+    // position in the RC frame cycle, this keeps to the cadence when RC frames are lost
+    const timeDelta_t cycleUs = (timeDelta_t)(micros() - crsfLastRcFrameStartAtUs) % intervalUs;
+    const timeDelta_t replyUs = (len * 10 * 1000000 + crsfBaudRate - 1) / crsfBaudRate; // 8N1, 10 bits per byte
+    return cycleUs >= (timeDelta_t)crsfLastRcFrameDurationUs && cycleUs + replyUs + CRSF_TELEMETRY_SLOT_GUARD_US <= intervalUs;
+}
+
+// Returns false while a reply is still waiting for its slot, the buffer must not be written then
+bool crsfRxSendTelemetryData(void)
 {
     // if there is telemetry data to write
     if (telemetryBufLen > 0) {
+        if (!crsfTelemetrySlotOpen(telemetryBufLen)) {
+            return false;
+        }
         serialWriteBuf(serialPort, telemetryBuf, telemetryBufLen);
         telemetryBufLen = 0; // reset telemetry buffer
     }
+    return true;
+}
+
+// age 0 is the latest link statistics frame, returns false if there is none that old
+bool crsfGetLinkStatistics(crsfLinkStatistics_t *linkStatistics, unsigned age)
+{
+    // The receive interrupt can store a frame while the entry is copied, and the slot it writes is the oldest one.
+    // Copy again until no frame arrived during the copy, frames are milliseconds apart so one retry is the most.
+    uint32_t count = __atomic_load_n(&crsfLinkStatisticsCount, __ATOMIC_ACQUIRE);
+    uint32_t countAfter;
+    do {
+        if (age >= CRSF_LINK_STATISTICS_HISTORY_COUNT || age >= count) {
+            return false;
+        }
+        *linkStatistics = crsfLinkStatisticsHistory[(count - 1 - age) % CRSF_LINK_STATISTICS_HISTORY_COUNT];
+        __atomic_signal_fence(__ATOMIC_ACQUIRE);
+        countAfter = count;
+        count = __atomic_load_n(&crsfLinkStatisticsCount, __ATOMIC_ACQUIRE);
+    } while (count != countAfter);
+    return true;
+}
+
+uint32_t crsfRxGetBaudRate(void)
+{
+    return crsfBaudRate;
+}
+
+timeDelta_t crsfRxGetFrameIntervalUs(void)
+{
+    return crsfRcFrameIntervalUs;
 }
 
 bool crsfRxInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
@@ -265,6 +484,10 @@ bool crsfRxInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 
     rxRuntimeConfig->rcReadRawFn = crsfReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = crsfFrameStatus;
+    rxRuntimeConfig->rcFrameCompleteUsFn = crsfFrameCompleteUs;
+#ifdef USE_RC_PREDICTION
+    rxRuntimeConfig->rcFrameTimeUsFn = crsfFrameTimeUs;
+#endif
 
     const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
     if (!portConfig) {
@@ -280,6 +503,11 @@ bool crsfRxInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
         CRSF_PORT_OPTIONS | (rxConfig->serialrx_inverted ? SERIAL_INVERTED : 0)
         );
 
+    if (rssiSource == RSSI_SOURCE_NONE) {
+        // the uplink link quality of the link statistics frames
+        rssiSource = RSSI_SOURCE_RX_PROTOCOL;
+    }
+
     return serialPort != NULL;
 }
 
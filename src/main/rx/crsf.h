@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include "common/time.h"
+
 #include "interface/crsf_protocol.h"
 
 
@@ -40,8 +42,28 @@ typedef union crsfFrame_u {
     crsfFrameDef_t frame;
 } crsfFrame_t;
 
+// payload of CRSF_FRAMETYPE_LINK_STATISTICS, kept as received
+typedef struct crsfLinkStatistics_s {
+    uint8_t uplinkRssi1;        // -dBm
+    uint8_t uplinkRssi2;        // -dBm
+    uint8_t uplinkLinkQuality;  // %
+    int8_t uplinkSnr;           // dB
+    uint8_t activeAntenna;
+    uint8_t rfMode;
+    uint8_t uplinkTxPower;
+    uint8_t downlinkRssi;       // -dBm
+    uint8_t downlinkLinkQuality;
+    int8_t downlinkSnr;
+} __attribute__ ((__packed__)) crsfLinkStatistics_t;
+
+#define CRSF_LINK_STATISTICS_HISTORY_COUNT 8 // power of 2
+
 void crsfRxWriteTelemetryData(const void *data, int len);
-void crsfRxSendTelemetryData(void);
+bool crsfRxSendTelemetryData(void);
+
+bool crsfGetLinkStatistics(crsfLinkStatistics_t *linkStatistics, unsigned age);
+uint32_t crsfRxGetBaudRate(void);
+timeDelta_t crsfRxGetFrameIntervalUs(void);
 
 struct rxConfig_s;
 struct rxRuntimeConfig_s;
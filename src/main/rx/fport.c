@@ -128,6 +128,7 @@ static const smartPortPayload_t emptySmartPortFrame = { .frameId = 0, .valueId =
 typedef struct fportBuffer_s {
     uint8_t data[BUFFER_SIZE];
     uint8_t length;
+    timeUs_t completeAtUs;
 } fportBuffer_t;
 
 static fportBuffer_t rxBuffer[NUM_RX_BUFFERS];
@@ -142,6 +143,7 @@ static volatile uint8_t framePosition = 0;
 
 static smartPortPayload_t *mspPayload = NULL;
 static timeUs_t lastRcFrameReceivedMs = 0;
+static timeUs_t rcFrameCompleteAtUs = 0;
 
 static serialPort_t *fportPort;
 static bool telemetryEnabled = false;
@@ -180,7 +182,11 @@ static void fportDataReceive(uint16_t c, void *data)
             const uint8_t nextWriteIndex = (rxBufferWriteIndex + 1) % NUM_RX_BUFFERS;
             if (nextWriteIndex != rxBufferReadIndex) {
                 rxBuffer[rxBufferWriteIndex].length = framePosition - 1;
+                rxBuffer[rxBufferWriteIndex].completeAtUs = currentTimeUs;
                 rxBufferWriteIndex = nextWriteIndex;
+#ifdef USE_TASK_SIGNAL
+                rxSignalFrameComplete();
+#endif
             }
 
             if (telemetryFrame) {
@@ -225,12 +231,11 @@ static void fportDataReceive(uint16_t c, void *data)
 #if defined(USE_TELEMETRY_SMARTPORT)
 static void smartPortWriteFrameFport(const smartPortPayload_t *payload)
 {
+    static const uint8_t header[] = { FPORT_RESPONSE_FRAME_LENGTH, FPORT_FRAME_TYPE_TELEMETRY_RESPONSE };
+
     framePosition = 0;
 
-    uint16_t checksum = 0;
-    smartPortSendByte(FPORT_RESPONSE_FRAME_LENGTH, &checksum, fportPort);
-    smartPortSendByte(FPORT_FRAME_TYPE_TELEMETRY_RESPONSE, &checksum, fportPort);
-    smartPortWriteFrameSerial(payload, fportPort, checksum);
+    smartPortWriteFrameSerial(payload, fportPort, header, sizeof(header));
 }
 #endif
 
@@ -261,6 +266,7 @@ static uint8_t fportFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
         } else {
             if (!checkChecksum(&rxBuffer[rxBufferReadIndex].data[0], bufferLength)) {
                 reportFrameError(DEBUG_FPORT_ERROR_CHECKSUM);
+                result = RX_FRAME_CRC_ERROR;
             } else {
                 fportFrame_t *frame = (fportFrame_t *)&rxBuffer[rxBufferReadIndex].data[1];
 
@@ -274,6 +280,7 @@ static uint8_t fportFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
                         setRssi(scaleRange(frame->data.controlData.rssi, 0, 100, 0, RSSI_MAX_VALUE), RSSI_SOURCE_RX_PROTOCOL);
 
                         lastRcFrameReceivedMs = millis();
+                        rcFrameCompleteAtUs = rxBuffer[rxBufferReadIndex].completeAtUs;
                     }
 
                     break;
@@ -332,6 +339,13 @@ static uint8_t fportFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
     return result;
 }
 
+static timeUs_t fportFrameCompleteUs(const rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    UNUSED(rxRuntimeConfig);
+
+    return rcFrameCompleteAtUs;
+}
+
 static bool fportProcessFrame(const rxRuntimeConfig_t *rxRuntimeConfig)
 {
     UNUSED(rxRuntimeConfig);
@@ -381,6 +395,7 @@ bool fportRxInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
     rxRuntimeConfig->rxRefreshRate = 11000;
 
     rxRuntimeConfig->rcFrameStatusFn = fportFrameStatus;
+    rxRuntimeConfig->rcFrameCompleteUsFn = fportFrameCompleteUs;
     rxRuntimeConfig->rcProcessFrameFn = fportProcessFrame;
 
     const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
@@ -28,6 +28,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "platform.h"
 
@@ -35,6 +36,7 @@
 
 #include "pg/rx.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/serial.h"
@@ -70,6 +72,8 @@ static uint8_t rxBytesToIgnore;
 static uint16_t ibusChecksum;
 
 static bool ibusFrameDone = false;
+static uint32_t ibusFrameCompleteAtUs;
+static uint32_t ibusRcFrameCompleteAtUs;
 static uint32_t ibusChannelData[IBUS_MAX_CHANNEL];
 
 static uint8_t ibus[IBUS_BUFFSIZE] = { 0, };
@@ -124,12 +128,78 @@ static void ibusDataReceive(uint16_t c, void *data)
 
     if (ibusFramePosition == ibusFrameSize - 1) {
         ibusFrameDone = true;
+        ibusFrameCompleteAtUs = ibusTime;
+#ifdef USE_TASK_SIGNAL
+        rxSignalFrameComplete();
+#endif
     } else {
         ibusFramePosition++;
     }
 }
 
 
+// Receive callback for DMA RX ports, the frame is only accepted once the line goes idle with exactly one frame received
+static void ibusFrameReceive(const uint8_t *data, uint32_t length, bool frameEnd, void *callbackData)
+{
+    UNUSED(callbackData);
+
+    static uint8_t ibusFrameLength;
+
+    if (rxBytesToIgnore) {
+        // Echo of our own telemetry response on a half duplex line
+        const uint32_t ignore = MIN(length, rxBytesToIgnore);
+        rxBytesToIgnore -= ignore;
+        data += ignore;
+        length -= ignore;
+    }
+
+    // Anything longer than a frame is dropped as a whole when the line goes idle
+    if (ibusFrameLength + length <= IBUS_BUFFSIZE) {
+        memcpy(&ibus[ibusFrameLength], data, length);
+        ibusFrameLength += length;
+    } else {
+        ibusFrameLength = IBUS_BUFFSIZE + 1;
+    }
+
+    if (!frameEnd || !ibusFrameLength) {
+        return;
+    }
+
+    const uint8_t c = ibus[0];
+    uint8_t expectedLength = 0;
+    if (isValidIa6bIbusPacketLength(c)) {
+        expectedLength = c;
+    } else if ((ibusSyncByte == 0 || ibusSyncByte == 0x55) && (c == 0x55)) {
+        expectedLength = 31;
+    }
+
+    if (ibusFrameLength < expectedLength) {
+        // A receiver pausing mid frame raises IDLE early, the rest of the frame follows on the next delivery
+        return;
+    }
+
+    if (ibusFrameLength == expectedLength) {
+        if (c == 0x55) {
+            ibusModel = IBUS_MODEL_IA6;
+            ibusChecksum = 0x0000;
+            ibusChannelOffset = 1;
+        } else {
+            ibusModel = IBUS_MODEL_IA6B;
+            ibusChecksum = 0xFFFF;
+            ibusChannelOffset = 2;
+        }
+        ibusSyncByte = c;
+        ibusFrameSize = expectedLength;
+
+        ibusFrameDone = true;
+        ibusFrameCompleteAtUs = micros();
+#ifdef USE_TASK_SIGNAL
+        rxSignalFrameComplete();
+#endif
+    }
+    ibusFrameLength = 0;
+}
+
 static bool isChecksumOkIa6(void)
 {
     uint8_t offset;
@@ -177,6 +247,7 @@ static uint8_t ibusFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
     if (checksumIsOk()) {
         if (ibusModel == IBUS_MODEL_IA6 || ibusSyncByte == 0x20) {
             updateChannelData();
+            ibusRcFrameCompleteAtUs = ibusFrameCompleteAtUs;
             frameStatus = RX_FRAME_COMPLETE;
         }
         else
@@ -185,11 +256,18 @@ static uint8_t ibusFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
             rxBytesToIgnore = respondToIbusRequest(ibus);
 #endif
         }
+    } else {
+        frameStatus = RX_FRAME_CRC_ERROR;
     }
 
     return frameStatus;
 }
 
+static timeUs_t ibusFrameCompleteUs(const rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    UNUSED(rxRuntimeConfig);
+    return ibusRcFrameCompleteAtUs;
+}
 
 static uint16_t ibusReadRawRC(const rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan)
 {
@@ -208,6 +286,7 @@ bool ibusInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 
     rxRuntimeConfig->rcReadRawFn = ibusReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = ibusFrameStatus;
+    rxRuntimeConfig->rcFrameCompleteUsFn = ibusFrameCompleteUs;
 
     const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
     if (!portConfig) {
@@ -232,6 +311,10 @@ bool ibusInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
         (rxConfig->serialrx_inverted ? SERIAL_INVERTED : 0) | (rxConfig->halfDuplex || portShared ? SERIAL_BIDIR : 0)
         );
 
+    if (ibusPort) {
+        serialSetRxFrameCallback(ibusPort, ibusFrameReceive);
+    }
+
 #if defined(USE_TELEMETRY) && defined(USE_TELEMETRY_IBUS)
     if (portShared) {
         initSharedIbusTelemetry(ibusPort);
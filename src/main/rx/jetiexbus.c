@@ -60,6 +60,8 @@
 #include "rx/rx.h"
 #include "rx/jetiexbus.h"
 
+#include "telemetry/jetiexbus.h"
+
 
 //
 // Serial driver for Jeti EX Bus receiver
@@ -162,6 +164,13 @@ static void jetiExBusDataReceive(uint16_t c, void *data)
 
     static uint8_t *jetiExBusFrame;
 
+#if defined(USE_TELEMETRY) && defined(USE_TELEMETRY_JETIEXBUS)
+    // the echo of our own response on a half duplex line
+    if (jetiExBusTelemetryTransmitting()) {
+        return;
+    }
+#endif
+
     // Check if we shall reset frame position due to time
     now = micros();
 
@@ -221,7 +230,15 @@ static void jetiExBusDataReceive(uint16_t c, void *data)
             jetiExBusFrameState = EXBUS_STATE_RECEIVED;
         if (jetiExBusRequestState == EXBUS_STATE_IN_PROGRESS) {
             jetiExBusRequestState = EXBUS_STATE_RECEIVED;
-            jetiTimeStampRequest = micros();
+            jetiTimeStampRequest = now;
+#if defined(USE_TELEMETRY) && defined(USE_TELEMETRY_JETIEXBUS)
+            // answer right here, the response window is too short to wait for the telemetry task
+            if ((jetiExBusRequestFrame[EXBUS_HEADER_DATA_ID] == EXBUS_EX_REQUEST)
+                && (jetiExBusCalcCRC16(jetiExBusRequestFrame, jetiExBusRequestFrame[EXBUS_HEADER_MSG_LEN]) == 0)
+                && sendJetiExBusTelemetryResponse(jetiExBusRequestFrame[EXBUS_HEADER_PACKET_ID])) {
+                jetiExBusRequestState = EXBUS_STATE_PROCESSED;
+            }
+#endif
         }
 
         jetiExBusFrameReset();
@@ -21,6 +21,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <math.h>
 
 #include <string.h>
 
@@ -67,6 +68,8 @@
 #include "rx/rx_spi.h"
 #include "rx/targetcustomserial.h"
 
+#include "scheduler/scheduler.h"
+
 
 const char rcChannelLetters[] = "AERT12345678abcdefgh";
 
@@ -94,6 +97,41 @@ static uint32_t needRxSignalMaxDelayUs;
 static uint32_t suspendRxSignalUntil = 0;
 static uint8_t  skipRxSamples = 0;
 
+static timeUs_t rxFrameCompleteUs;         // last byte of the latest frame, until rcData is read from it
+static timeUs_t rcDataFrameUs;             // last byte of the frame rcData was read from, 0 if not from a new frame
+
+#if defined(USE_RC_PREDICTION) || defined(USE_RX_LATE_FRAME_DETECTION)
+#define USE_RX_FRAME_TIMING
+#define RX_FRAME_INTERVAL_MAX_US    100000  // longer gaps are lost frames, not the frame rate
+#define RX_FRAME_TIMING_GAIN        0.05f   // averages over about 20 frames
+
+static timeUs_t rxFrameTimeUs;
+static float rxFrameIntervalUs;             // average time between frames
+static float rxFrameJitterUs;               // average deviation of the time between frames from rxFrameIntervalUs
+static timeDelta_t rxFrameLastIntervalUs;   // time between the latest two frames
+#endif
+
+#ifdef USE_RX_LATE_FRAME_DETECTION
+// the signal is lost once this many frame intervals have passed without a good frame,
+// never sooner than RX_LATE_FRAME_MIN_US and never later than needRxSignalMaxDelayUs
+#define RX_LATE_FRAME_COUNT         4
+#define RX_LATE_FRAME_JITTER_COUNT  4
+#define RX_LATE_FRAME_MIN_US        20000
+
+static bool rxLateFrameDetection;
+#endif
+
+#ifdef USE_RX_LINK_STATS
+// completed periods, the newest at rxLinkStatsCount - 1
+static rxLinkStats_t rxLinkStatsHistory[RX_LINK_STATS_HISTORY_COUNT];
+static uint32_t rxLinkStatsCount = 0;
+static rxLinkStats_t rxLinkStatsCurrent;
+static uint32_t rxLinkStatsIntervalSumUs;
+static uint16_t rxLinkStatsIntervalCount;
+static timeUs_t rxLinkStatsPeriodStartUs;
+static timeUs_t rxLinkStatsFrameUs;         // latest complete frame, 0 before the first one
+#endif
+
 static int16_t rcRaw[MAX_SUPPORTED_RC_CHANNEL_COUNT];     // interval [1000;2000]
 int16_t rcData[MAX_SUPPORTED_RC_CHANNEL_COUNT];     // interval [1000;2000]
 uint32_t rcInvalidPulsPeriod[MAX_SUPPORTED_RC_CHANNEL_COUNT];
@@ -273,6 +311,7 @@ void rxInit(void)
             featureClear(FEATURE_RX_SERIAL);
             rxRuntimeConfig.rcReadRawFn = nullReadRawRC;
             rxRuntimeConfig.rcFrameStatusFn = nullFrameStatus;
+            rxRuntimeConfig.rcFrameTimeUsFn = NULL;
         }
     }
 #endif
@@ -284,6 +323,11 @@ void rxInit(void)
     }
 #endif
 
+#ifdef USE_RX_LATE_FRAME_DETECTION
+    // MSP frames are sent by a host at no fixed rate
+    rxLateFrameDetection = !feature(FEATURE_RX_MSP);
+#endif
+
 #ifdef USE_RX_SPI
     if (feature(FEATURE_RX_SPI)) {
         const bool enabled = rxSpiInit(rxSpiConfig(), &rxRuntimeConfig);
@@ -337,20 +381,170 @@ void resumeRxSignal(void)
     failsafeOnRxResume();
 }
 
+timeUs_t rxGetRcDataFrameUs(void)
+{
+    return rcDataFrameUs;
+}
+
+#ifdef USE_TASK_SIGNAL
+// Called by the serial RX drivers from their receive interrupt once a frame is complete,
+// so TASK_RX runs on the next scheduler pass instead of waiting for its turn.
+void rxSignalFrameComplete(void)
+{
+    schedulerSignalTask(TASK_RX);
+}
+#endif
+
+#ifdef USE_RX_FRAME_TIMING
+static void rxUpdateFrameTiming(timeUs_t frameTimeUs)
+{
+    const timeDelta_t frameIntervalUs = cmpTimeUs(frameTimeUs, rxFrameTimeUs);
+    rxFrameTimeUs = frameTimeUs;
+    if (frameIntervalUs <= 0 || frameIntervalUs > RX_FRAME_INTERVAL_MAX_US) {
+        return;
+    }
+    rxFrameLastIntervalUs = frameIntervalUs;
+    if (rxFrameIntervalUs == 0) {
+        rxFrameIntervalUs = frameIntervalUs;
+        return;
+    }
+    rxFrameIntervalUs += RX_FRAME_TIMING_GAIN * (frameIntervalUs - rxFrameIntervalUs);
+    rxFrameJitterUs += RX_FRAME_TIMING_GAIN * (fabsf(frameIntervalUs - rxFrameIntervalUs) - rxFrameJitterUs);
+}
+
+timeUs_t rxGetFrameTimeUs(void)
+{
+    return rxFrameTimeUs;
+}
+
+float rxGetFrameIntervalUs(void)
+{
+    return rxFrameIntervalUs;
+}
+
+float rxGetFrameJitterUs(void)
+{
+    return rxFrameJitterUs;
+}
+#endif
+
+// time after a good frame until the signal counts as lost
+static uint32_t rxSignalTimeoutUs(void)
+{
+#ifdef USE_RX_LATE_FRAME_DETECTION
+    // until the frame rate is known, and on links without a steady one, the fixed delay applies
+    if (rxLateFrameDetection && rxFrameIntervalUs > 0) {
+        // the latest interval follows a drop of the frame rate before the average does
+        const float frameIntervalUs = MAX(rxFrameIntervalUs, rxFrameLastIntervalUs);
+        const uint32_t timeoutUs = lrintf(RX_LATE_FRAME_COUNT * frameIntervalUs + RX_LATE_FRAME_JITTER_COUNT * rxFrameJitterUs);
+        return constrain(timeoutUs, RX_LATE_FRAME_MIN_US, needRxSignalMaxDelayUs);
+    }
+#endif
+    return needRxSignalMaxDelayUs;
+}
+
+#ifdef USE_RX_LINK_STATS
+static void rxLinkStatsEndPeriod(void)
+{
+    const timeUs_t periodEndUs = rxLinkStatsPeriodStartUs + RX_LINK_STATS_PERIOD_US;
+    if (rxLinkStatsFrameUs) {
+        // a gap still open at the end of the period counts towards its longest interval
+        const timeDelta_t gapUs = cmpTimeUs(periodEndUs, rxLinkStatsFrameUs);
+        if (gapUs > rxLinkStatsCurrent.intervalMaxUs) {
+            rxLinkStatsCurrent.intervalMaxUs = MIN(gapUs, UINT16_MAX);
+        }
+    }
+    rxLinkStatsCurrent.intervalAvgUs = rxLinkStatsIntervalCount ? rxLinkStatsIntervalSumUs / rxLinkStatsIntervalCount : 0;
+    rxLinkStatsHistory[rxLinkStatsCount % RX_LINK_STATS_HISTORY_COUNT] = rxLinkStatsCurrent;
+    rxLinkStatsCount++;
+
+    memset(&rxLinkStatsCurrent, 0, sizeof(rxLinkStatsCurrent));
+    rxLinkStatsIntervalSumUs = 0;
+    rxLinkStatsIntervalCount = 0;
+    rxLinkStatsPeriodStartUs = periodEndUs;
+}
+
+static void rxLinkStatsUpdate(timeUs_t currentTimeUs, uint8_t frameStatus, timeUs_t frameUs)
+{
+    if (!rxLinkStatsPeriodStartUs) {
+        rxLinkStatsPeriodStartUs = currentTimeUs;
+    }
+    // Periods are on a fixed one second grid. When the task was held off for more than a period, the missed periods
+    // are stored empty, up to the history length, rather than being merged into one long period.
+    for (int periods = 0; cmpTimeUs(currentTimeUs, rxLinkStatsPeriodStartUs) >= RX_LINK_STATS_PERIOD_US; periods++) {
+        if (periods == RX_LINK_STATS_HISTORY_COUNT) {
+            rxLinkStatsPeriodStartUs = currentTimeUs;
+            break;
+        }
+        rxLinkStatsEndPeriod();
+    }
+
+    if (frameStatus & RX_FRAME_CRC_ERROR) {
+        rxLinkStatsCurrent.crcErrors++;
+    }
+    if (!(frameStatus & RX_FRAME_COMPLETE)) {
+        return;
+    }
+
+    rxLinkStatsCurrent.frames++;
+    if (frameStatus & RX_FRAME_DROPPED) {
+        rxLinkStatsCurrent.droppedFrames++;
+    }
+    if (frameStatus & RX_FRAME_FAILSAFE) {
+        rxLinkStatsCurrent.failsafeFrames++;
+    }
+
+    // intervals longer than UINT16_MAX are link gaps, saturate them so they still show as the longest interval
+    const timeDelta_t intervalUs = MIN(cmpTimeUs(frameUs, rxLinkStatsFrameUs), UINT16_MAX);
+    if (rxLinkStatsFrameUs && intervalUs > 0) {
+        if (!rxLinkStatsIntervalCount || intervalUs < rxLinkStatsCurrent.intervalMinUs) {
+            rxLinkStatsCurrent.intervalMinUs = intervalUs;
+        }
+        if (intervalUs > rxLinkStatsCurrent.intervalMaxUs) {
+            rxLinkStatsCurrent.intervalMaxUs = intervalUs;
+        }
+        rxLinkStatsIntervalSumUs += intervalUs;
+        rxLinkStatsIntervalCount++;
+    }
+    rxLinkStatsFrameUs = frameUs;
+}
+
+// age 0 is the latest complete period
+bool rxGetLinkStats(rxLinkStats_t *linkStats, unsigned age)
+{
+    if (age >= RX_LINK_STATS_HISTORY_COUNT || age >= rxLinkStatsCount) {
+        return false;
+    }
+    *linkStats = rxLinkStatsHistory[(rxLinkStatsCount - 1 - age) % RX_LINK_STATS_HISTORY_COUNT];
+    return true;
+}
+#endif
+
 bool rxUpdateCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTime)
 {
     UNUSED(currentDeltaTime);
 
     bool signalReceived = false;
     bool useDataDrivenProcessing = true;
+#ifdef USE_RX_LINK_STATS
+    uint8_t linkFrameStatus = RX_FRAME_PENDING;
+    timeUs_t linkFrameUs = currentTimeUs;
+#endif
 
 #if defined(USE_PWM) || defined(USE_PPM)
     if (feature(FEATURE_RX_PPM)) {
         if (isPPMDataBeingReceived()) {
             signalReceived = true;
             rxIsInFailsafeMode = false;
-            needRxSignalBefore = currentTimeUs + needRxSignalMaxDelayUs;
             resetPPMDataReceivedState();
+            rxFrameCompleteUs = currentTimeUs;
+#ifdef USE_RX_FRAME_TIMING
+            rxUpdateFrameTiming(currentTimeUs);
+#endif
+            needRxSignalBefore = currentTimeUs + rxSignalTimeoutUs();
+#ifdef USE_RX_LINK_STATS
+            linkFrameStatus = RX_FRAME_COMPLETE;
+#endif
         }
     } else if (feature(FEATURE_RX_PARALLEL_PWM)) {
         if (isPWMDataBeingReceived()) {
@@ -363,12 +557,24 @@ bool rxUpdateCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTime)
 #endif
     {
         const uint8_t frameStatus = rxRuntimeConfig.rcFrameStatusFn(&rxRuntimeConfig);
+#ifdef USE_RX_LINK_STATS
+        linkFrameStatus = frameStatus;
+        if ((frameStatus & RX_FRAME_COMPLETE) && rxRuntimeConfig.rcFrameCompleteUsFn) {
+            linkFrameUs = rxRuntimeConfig.rcFrameCompleteUsFn(&rxRuntimeConfig);
+        }
+#endif
         if (frameStatus & RX_FRAME_COMPLETE) {
             rxIsInFailsafeMode = (frameStatus & RX_FRAME_FAILSAFE) != 0;
             bool rxFrameDropped = (frameStatus & RX_FRAME_DROPPED) != 0;
             signalReceived = !(rxIsInFailsafeMode || rxFrameDropped);
             if (signalReceived) {
-                needRxSignalBefore = currentTimeUs + needRxSignalMaxDelayUs;
+                // drivers that timestamp the last byte in the receive interrupt leave the task latency in the measurement
+                rxFrameCompleteUs = rxRuntimeConfig.rcFrameCompleteUsFn ? rxRuntimeConfig.rcFrameCompleteUsFn(&rxRuntimeConfig) : currentTimeUs;
+#ifdef USE_RX_FRAME_TIMING
+                // drivers that timestamp the frames in the receive interrupt are not affected by the task timing
+                rxUpdateFrameTiming(rxRuntimeConfig.rcFrameTimeUsFn ? rxRuntimeConfig.rcFrameTimeUsFn(&rxRuntimeConfig) : currentTimeUs);
+#endif
+                needRxSignalBefore = currentTimeUs + rxSignalTimeoutUs();
             }
 
             if (frameStatus & (RX_FRAME_FAILSAFE | RX_FRAME_DROPPED)) {
@@ -385,6 +591,10 @@ bool rxUpdateCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTime)
         }
     }
 
+#ifdef USE_RX_LINK_STATS
+    rxLinkStatsUpdate(currentTimeUs, linkFrameStatus, linkFrameUs);
+#endif
+
     if (signalReceived) {
         rxSignalReceived = true;
     } else if (currentTimeUs >= needRxSignalBefore) {
@@ -398,16 +608,25 @@ bool rxUpdateCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTime)
     return rxDataProcessingRequired || auxiliaryProcessingRequired; // data driven or 50Hz
 }
 
+typedef struct rcSampleRing_s {
+    int16_t sample[PPM_AND_PWM_SAMPLE_COUNT];
+    int16_t sum;                        // running sum of sample[], PPM_AND_PWM_SAMPLE_COUNT * PWM_PULSE_MAX fits
+} rcSampleRing_t;
+
+// the median mode uses quickMedianFilter3()
+STATIC_ASSERT(PPM_AND_PWM_SAMPLE_COUNT == 3, PPM_AND_PWM_SAMPLE_COUNT_does_not_match_median_filter);
+
 static uint16_t calculateChannelMovingAverage(uint8_t chan, uint16_t sample)
 {
-    static int16_t rcSamples[MAX_SUPPORTED_RX_PARALLEL_PWM_OR_PPM_CHANNEL_COUNT][PPM_AND_PWM_SAMPLE_COUNT];
-    static int16_t rcDataMean[MAX_SUPPORTED_RX_PARALLEL_PWM_OR_PPM_CHANNEL_COUNT];
+    static rcSampleRing_t rcSamples[MAX_SUPPORTED_RX_PARALLEL_PWM_OR_PPM_CHANNEL_COUNT];
     static bool rxSamplesCollected = false;
 
+    rcSampleRing_t *ring = &rcSamples[chan];
     const uint8_t currentSampleIndex = rcSampleIndex % PPM_AND_PWM_SAMPLE_COUNT;
 
-    // update the recent samples and compute the average of them
-    rcSamples[chan][currentSampleIndex] = sample;
+    // replace the oldest sample, the sum stays exact whatever the order the slots are visited in
+    ring->sum += (int16_t)sample - ring->sample[currentSampleIndex];
+    ring->sample[currentSampleIndex] = sample;
 
     // avoid returning an incorrect average which would otherwise occur before enough samples
     if (!rxSamplesCollected) {
@@ -417,11 +636,15 @@ static uint16_t calculateChannelMovingAverage(uint8_t chan, uint16_t sample)
         rxSamplesCollected = true;
     }
 
-    rcDataMean[chan] = 0;
-    for (int sampleIndex = 0; sampleIndex < PPM_AND_PWM_SAMPLE_COUNT; sampleIndex++) {
-        rcDataMean[chan] += rcSamples[chan][sampleIndex];
+    if (rxConfig()->ppm_pwm_filter == RX_PPM_PWM_FILTER_MEDIAN) {
+        int32_t samples[PPM_AND_PWM_SAMPLE_COUNT];
+        for (int sampleIndex = 0; sampleIndex < PPM_AND_PWM_SAMPLE_COUNT; sampleIndex++) {
+            samples[sampleIndex] = ring->sample[sampleIndex];
+        }
+        return quickMedianFilter3(samples);
     }
-    return rcDataMean[chan] / PPM_AND_PWM_SAMPLE_COUNT;
+
+    return ring->sum / PPM_AND_PWM_SAMPLE_COUNT;
 }
 
 static uint16_t getRxfailValue(uint8_t channel)
@@ -556,6 +779,9 @@ bool calculateRxChannelsAndUpdateFailsafe(timeUs_t currentTimeUs)
     readRxChannelsApplyRanges();
     detectAndApplySignalLossBehaviour();
 
+    rcDataFrameUs = rxFrameCompleteUs;
+    rxFrameCompleteUs = 0;
+
     rcSampleIndex++;
 
     return true;
@@ -49,7 +49,8 @@ typedef enum {
     RX_FRAME_COMPLETE = (1 << 0),
     RX_FRAME_FAILSAFE = (1 << 1),
     RX_FRAME_PROCESSING_REQUIRED = (1 << 2),
-    RX_FRAME_DROPPED = (1 << 3)
+    RX_FRAME_DROPPED = (1 << 3),
+    RX_FRAME_CRC_ERROR = (1 << 4)       // a frame was received but failed its check, only counted by the link statistics
 } rxFrameState_e;
 
 typedef enum {
@@ -106,6 +107,11 @@ typedef enum {
 
 #define RX_FAILSAFE_TYPE_COUNT 2
 
+typedef enum {
+    RX_PPM_PWM_FILTER_AVERAGE = 0,
+    RX_PPM_PWM_FILTER_MEDIAN,           // rejects single sample glitches of noisy PPM links
+} rxPpmPwmFilter_e;
+
 typedef struct rxFailsafeChannelConfig_s {
     uint8_t mode; // See rxFailsafeChannelMode_e
     uint8_t step;
@@ -124,6 +130,8 @@ struct rxRuntimeConfig_s;
 typedef uint16_t (*rcReadRawDataFnPtr)(const struct rxRuntimeConfig_s *rxRuntimeConfig, uint8_t chan); // used by receiver driver to return channel data
 typedef uint8_t (*rcFrameStatusFnPtr)(struct rxRuntimeConfig_s *rxRuntimeConfig);
 typedef bool (*rcProcessFrameFnPtr)(const struct rxRuntimeConfig_s *rxRuntimeConfig);
+typedef timeUs_t (*rcFrameTimeUsFnPtr)(const struct rxRuntimeConfig_s *rxRuntimeConfig); // time the driver saw the latest frame start, optional
+typedef timeUs_t (*rcFrameCompleteUsFnPtr)(const struct rxRuntimeConfig_s *rxRuntimeConfig); // time the driver got the last byte of the latest frame, optional
 
 typedef struct rxRuntimeConfig_s {
     uint8_t             channelCount; // number of RC channels as reported by current input driver
@@ -131,6 +139,8 @@ typedef struct rxRuntimeConfig_s {
     rcReadRawDataFnPtr  rcReadRawFn;
     rcFrameStatusFnPtr  rcFrameStatusFn;
     rcProcessFrameFnPtr rcProcessFrameFn;
+    rcFrameTimeUsFnPtr  rcFrameTimeUsFn;
+    rcFrameCompleteUsFnPtr rcFrameCompleteUsFn;
     uint16_t            *channelData;
     void                *frameData;
 } rxRuntimeConfig_t;
@@ -173,3 +183,30 @@ void suspendRxSignal(void);
 void resumeRxSignal(void);
 
 uint16_t rxGetRefreshRate(void);
+timeUs_t rxGetRcDataFrameUs(void);
+#ifdef USE_TASK_SIGNAL
+void rxSignalFrameComplete(void);
+#endif
+#ifdef USE_RC_PREDICTION
+timeUs_t rxGetFrameTimeUs(void);
+float rxGetFrameIntervalUs(void);
+float rxGetFrameJitterUs(void);
+#endif
+
+#ifdef USE_RX_LINK_STATS
+#define RX_LINK_STATS_HISTORY_COUNT 8
+#define RX_LINK_STATS_PERIOD_US 1000000
+
+// frames seen by rxUpdateCheck() in one RX_LINK_STATS_PERIOD_US
+typedef struct rxLinkStats_s {
+    uint16_t frames;            // complete frames, including dropped and failsafe ones
+    uint16_t droppedFrames;
+    uint16_t failsafeFrames;
+    uint16_t crcErrors;
+    uint16_t intervalMinUs;     // time between complete frames, 0 if fewer than two frames
+    uint16_t intervalAvgUs;
+    uint16_t intervalMaxUs;
+} rxLinkStats_t;
+
+bool rxGetLinkStats(rxLinkStats_t *linkStats, unsigned age);
+#endif
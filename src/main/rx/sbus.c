@@ -21,6 +21,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "platform.h"
 
@@ -102,6 +103,11 @@ typedef union sbusFrame_u {
 typedef struct sbusFrameData_s {
     sbusFrame_t frame;
     uint32_t startAtUs;
+    uint32_t completeAtUs;
+    uint32_t frameCompleteAtUs; // last byte of the latest frame that was decoded
+#ifdef USE_RC_PREDICTION
+    uint32_t frameStartAtUs;    // start of the latest frame that was decoded
+#endif
     uint16_t stateFlags;
     uint8_t position;
     bool done;
@@ -134,11 +140,52 @@ static void sbusDataReceive(uint16_t c, void *data)
             sbusFrameData->done = false;
         } else {
             sbusFrameData->done = true;
+            sbusFrameData->completeAtUs = nowUs;
+#ifdef USE_TASK_SIGNAL
+            rxSignalFrameComplete();
+#endif
             DEBUG_SET(DEBUG_SBUS, DEBUG_SBUS_FRAME_TIME, sbusFrameTime);
         }
     }
 }
 
+// Receive callback for DMA RX ports, the frame is only accepted once the line goes idle with exactly one frame received
+static void sbusFrameReceive(const uint8_t *data, uint32_t length, bool frameEnd, void *callbackData)
+{
+    sbusFrameData_t *sbusFrameData = callbackData;
+
+    if (sbusFrameData->position == 0) {
+        if (!length || data[0] != SBUS_FRAME_BEGIN_BYTE) {
+            return;
+        }
+    }
+
+    // Anything longer than a frame is dropped as a whole when the line goes idle
+    if (sbusFrameData->position + length <= SBUS_FRAME_SIZE) {
+        memcpy(&sbusFrameData->frame.bytes[sbusFrameData->position], data, length);
+        sbusFrameData->position += length;
+        sbusFrameData->done = false;
+    } else {
+        sbusFrameData->position = SBUS_FRAME_SIZE + 1;
+    }
+
+    if (!frameEnd || sbusFrameData->position < SBUS_FRAME_SIZE) {
+        // A receiver pausing mid frame raises IDLE early, the rest of the frame follows on the next delivery
+        return;
+    }
+
+    if (sbusFrameData->position == SBUS_FRAME_SIZE) {
+        const uint32_t nowUs = micros();
+        sbusFrameData->done = true;
+        sbusFrameData->completeAtUs = nowUs;
+        sbusFrameData->startAtUs = nowUs - SBUS_TIME_NEEDED_PER_FRAME;
+#ifdef USE_TASK_SIGNAL
+        rxSignalFrameComplete();
+#endif
+    }
+    sbusFrameData->position = 0;
+}
+
 static uint8_t sbusFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
 {
     sbusFrameData_t *sbusFrameData = rxRuntimeConfig->frameData;
@@ -146,6 +193,10 @@ static uint8_t sbusFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
         return RX_FRAME_PENDING;
     }
     sbusFrameData->done = false;
+    sbusFrameData->frameCompleteAtUs = sbusFrameData->completeAtUs;
+#ifdef USE_RC_PREDICTION
+    sbusFrameData->frameStartAtUs = sbusFrameData->startAtUs;
+#endif
 
     DEBUG_SET(DEBUG_SBUS, DEBUG_SBUS_FRAME_FLAGS, sbusFrameData->frame.frame.channels.flags);
 
@@ -163,6 +214,20 @@ static uint8_t sbusFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
     return sbusChannelsDecode(rxRuntimeConfig, &sbusFrameData->frame.frame.channels);
 }
 
+static timeUs_t sbusFrameCompleteUs(const rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    const sbusFrameData_t *sbusFrameData = rxRuntimeConfig->frameData;
+    return sbusFrameData->frameCompleteAtUs;
+}
+
+#ifdef USE_RC_PREDICTION
+static timeUs_t sbusFrameTimeUs(const rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    const sbusFrameData_t *sbusFrameData = rxRuntimeConfig->frameData;
+    return sbusFrameData->frameStartAtUs;
+}
+#endif
+
 bool sbusInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 {
     static uint16_t sbusChannelData[SBUS_MAX_CHANNEL];
@@ -176,6 +241,10 @@ bool sbusInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
     rxRuntimeConfig->rxRefreshRate = 11000;
 
     rxRuntimeConfig->rcFrameStatusFn = sbusFrameStatus;
+    rxRuntimeConfig->rcFrameCompleteUsFn = sbusFrameCompleteUs;
+#ifdef USE_RC_PREDICTION
+    rxRuntimeConfig->rcFrameTimeUsFn = sbusFrameTimeUs;
+#endif
 
     const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
     if (!portConfig) {
@@ -197,6 +266,10 @@ bool sbusInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
         SBUS_PORT_OPTIONS | (rxConfig->serialrx_inverted ? 0 : SERIAL_INVERTED) | (rxConfig->halfDuplex ? SERIAL_BIDIR : 0)
         );
 
+    if (sBusPort) {
+        serialSetRxFrameCallback(sBusPort, sbusFrameReceive);
+    }
+
     if (rxConfig->rssi_src_frame_errors) {
         rssiSource = RSSI_SOURCE_FRAME_ERRORS;
     }
@@ -21,6 +21,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "platform.h"
 
@@ -41,25 +42,34 @@
 #define SBUS_DIGITAL_CHANNEL_MIN 173
 #define SBUS_DIGITAL_CHANNEL_MAX 1812
 
+#define SBUS_PROPORTIONAL_CHANNEL_COUNT 16
+
+STATIC_ASSERT(sizeof(sbusChannels_t) == SBUS_PROPORTIONAL_CHANNEL_COUNT * 11 / 8 + 1, sbus_channels_packing);
+
+// Read four little endian bytes as one word, the channel data is not aligned
+static inline uint32_t sbusReadWord(const uint8_t *data)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    uint32_t word;
+    memcpy(&word, data, sizeof(word));
+    return word;
+#else
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+#endif
+}
+
 uint8_t sbusChannelsDecode(rxRuntimeConfig_t *rxRuntimeConfig, const sbusChannels_t *channels)
 {
     uint16_t *sbusChannelData = rxRuntimeConfig->channelData;
-    sbusChannelData[0] = channels->chan0;
-    sbusChannelData[1] = channels->chan1;
-    sbusChannelData[2] = channels->chan2;
-    sbusChannelData[3] = channels->chan3;
-    sbusChannelData[4] = channels->chan4;
-    sbusChannelData[5] = channels->chan5;
-    sbusChannelData[6] = channels->chan6;
-    sbusChannelData[7] = channels->chan7;
-    sbusChannelData[8] = channels->chan8;
-    sbusChannelData[9] = channels->chan9;
-    sbusChannelData[10] = channels->chan10;
-    sbusChannelData[11] = channels->chan11;
-    sbusChannelData[12] = channels->chan12;
-    sbusChannelData[13] = channels->chan13;
-    sbusChannelData[14] = channels->chan14;
-    sbusChannelData[15] = channels->chan15;
+    const uint8_t *data = (const uint8_t *)channels;
+
+    // Channel n starts at bit 11 * n, so it always fits in the word loaded from the byte it starts in
+    // (at most 7 + 11 bits). The last channel starts in byte 20 and would read past the flags, take it from two bytes.
+    for (unsigned n = 0; n < SBUS_PROPORTIONAL_CHANNEL_COUNT - 1; n++) {
+        const unsigned bit = n * 11;
+        sbusChannelData[n] = (sbusReadWord(&data[bit >> 3]) >> (bit & 7)) & 0x07FF;
+    }
+    sbusChannelData[SBUS_PROPORTIONAL_CHANNEL_COUNT - 1] = ((data[20] | (data[21] << 8)) >> 5) & 0x07FF;
 
     if (channels->flags & SBUS_FLAG_CHANNEL_17) {
         sbusChannelData[16] = SBUS_DIGITAL_CHANNEL_MAX;
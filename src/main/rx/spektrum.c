@@ -60,6 +60,8 @@ uint8_t rssi_channel;
 static uint8_t spek_chan_shift;
 static uint8_t spek_chan_mask;
 static bool rcFrameComplete = false;
+static uint32_t spekFrameCompleteAtUs;
+static uint32_t spekRcFrameCompleteAtUs;
 static bool spekHiRes = false;
 
 static volatile uint8_t spekFrame[SPEK_FRAME_SIZE];
@@ -98,6 +100,10 @@ static void spektrumDataReceive(uint16_t c, void *data)
             rcFrameComplete = false;
         } else {
             rcFrameComplete = true;
+            spekFrameCompleteAtUs = spekTime;
+#ifdef USE_TASK_SIGNAL
+            rxSignalFrameComplete();
+#endif
         }
     }
 }
@@ -114,6 +120,7 @@ static uint8_t spektrumFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
     }
 
     rcFrameComplete = false;
+    spekRcFrameCompleteAtUs = spekFrameCompleteAtUs;
 
 #if defined(USE_SPEKTRUM_REAL_RSSI) || defined(USE_SPEKTRUM_FAKE_RSSI)
     spektrumHandleRSSI(spekFrame);
@@ -165,6 +172,13 @@ static uint8_t spektrumFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
     return RX_FRAME_COMPLETE;
 }
 
+static timeUs_t spektrumFrameCompleteUs(const rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    UNUSED(rxRuntimeConfig);
+
+    return spekRcFrameCompleteAtUs;
+}
+
 static uint16_t spektrumReadRawRC(const rxRuntimeConfig_t *rxRuntimeConfig, uint8_t chan)
 {
     uint16_t data;
@@ -347,6 +361,7 @@ bool spektrumInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig
 
     rxRuntimeConfig->rcReadRawFn = spektrumReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = spektrumFrameStatus;
+    rxRuntimeConfig->rcFrameCompleteUsFn = spektrumFrameCompleteUs;
 
     serialPort = openSerialPort(portConfig->identifier,
         FUNCTION_RX_SERIAL,
@@ -367,9 +382,6 @@ bool spektrumInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig
         rssi_channel = 0;
     }
 
-    if (serialPort && srxlEnabled) {
-        dispatchEnable();
-    }
     return serialPort != NULL;
 }
 
@@ -121,7 +121,7 @@ static uint8_t sumdFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
     // verify CRC
     if (crc != ((sumd[SUMD_BYTES_PER_CHANNEL * sumdChannelCount + SUMD_OFFSET_CHANNEL_1_HIGH] << 8) |
             (sumd[SUMD_BYTES_PER_CHANNEL * sumdChannelCount + SUMD_OFFSET_CHANNEL_1_LOW])))
-        return frameStatus;
+        return RX_FRAME_CRC_ERROR;
 
     switch (sumd[1]) {
         case SUMD_FRAME_STATE_FAILSAFE:
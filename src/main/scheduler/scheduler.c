@@ -37,6 +37,8 @@
 #include "common/time.h"
 #include "common/utils.h"
 
+#include "drivers/stack_check.h"
+#include "drivers/system.h"
 #include "drivers/time.h"
 
 // DEBUG_SCHEDULER, timings for:
@@ -45,13 +47,36 @@
 // 2 - time spent in scheduler
 // 3 - time spent executing check function
 
+// DEBUG_IDLE_SLEEP, for each sleep:
+// 0 - time asleep
+// 1 - wakeup latency, the time asleep past the wakeup interval, SCHEDULER_IDLE_SLEEP_MARGIN_US has to cover it
+// 2 - highest wakeup latency so far
+// 3 - sleeps that woke after the next task was due
+
 static FAST_RAM_ZERO_INIT cfTask_t *currentTask = NULL;
+#ifdef USE_PREEMPTIVE_PID_LOOP
+static FAST_RAM_ZERO_INIT cfTask_t *interruptTask = NULL;  // task run from an interrupt instead of by scheduler()
+#endif
 
 static FAST_RAM_ZERO_INIT uint32_t totalWaitingTasks;
 static FAST_RAM_ZERO_INIT uint32_t totalWaitingTasksSamples;
 
 static FAST_RAM_ZERO_INIT bool calculateTaskStatistics;
+static FAST_RAM_ZERO_INIT bool currentTaskYielded;
 FAST_RAM_ZERO_INIT uint16_t averageSystemLoadPercent = 0;
+#ifndef SKIP_TASK_STATISTICS
+static FAST_RAM_ZERO_INIT timeUs_t idleTimeUs;             // time spent in scheduler passes that found no task to run
+static FAST_RAM_ZERO_INIT timeUs_t idleTimeSampledAt;
+FAST_RAM_ZERO_INIT uint16_t averageIdlePercent = 0;
+#endif
+#ifdef USE_SCHEDULER_IDLE_SLEEP
+static FAST_RAM_ZERO_INIT timeDelta_t idleSleepWakeupIntervalUs;   // 0 while sleeping is disabled
+static FAST_RAM_ZERO_INIT timeDelta_t idleSleepMaxWakeupLatencyUs;
+static FAST_RAM_ZERO_INIT uint16_t idleSleepOvershootCount;
+#endif
+#ifdef STACK_CHECK
+static bool stackSampling;      // a task preempting a sampled one must not repaint the stack under it
+#endif
 
 
 static FAST_RAM_ZERO_INIT int taskQueuePos = 0;
@@ -61,21 +86,197 @@ STATIC_UNIT_TESTED FAST_RAM_ZERO_INIT int taskQueueSize = 0;
 
 STATIC_UNIT_TESTED FAST_RAM_ZERO_INIT cfTask_t* taskQueueArray[TASK_COUNT + 1]; // extra item for NULL pointer at end of queue
 
+#ifdef USE_TASK_CHAINING
+STATIC_UNIT_TESTED FAST_RAM_ZERO_INIT cfTask_t *chainedTasks[TASK_COUNT];
+STATIC_UNIT_TESTED FAST_RAM_ZERO_INIT int chainedTaskCount;
+#endif
+
+static FAST_CODE bool taskIsEventDriven(const cfTask_t *task)
+{
+#ifdef USE_TASK_CHAINING
+    if (task->chainedAfter) {
+        return true;
+    }
+#endif
+    return task->checkFunc != NULL;
+}
+
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+// Time driven tasks are additionally kept in one binary min-heap per static priority, keyed on the time they are next due.
+// Each task stores its position in the heap, and the scheduler only pops the tasks that are due off the top of each heap,
+// rather than visiting every queued task.
+// Event driven tasks (those with a checkFunc or chained to another task) have to be polled anyway and are kept in a separate list.
+#define TASK_PRIORITY_LEVEL_COUNT (TASK_PRIORITY_REALTIME + 1)
+
+STATIC_UNIT_TESTED FAST_RAM_ZERO_INIT taskHeap_t taskHeap[TASK_PRIORITY_LEVEL_COUNT];
+STATIC_UNIT_TESTED FAST_RAM_ZERO_INIT cfTask_t *eventTaskQueue[TASK_COUNT];
+STATIC_UNIT_TESTED FAST_RAM_ZERO_INIT int eventTaskQueueSize;
+
+static FAST_CODE bool taskDueBefore(const cfTask_t *a, const cfTask_t *b)
+{
+    return (timeDelta_t)((a->lastExecutedAt + a->desiredPeriod) - (b->lastExecutedAt + b->desiredPeriod)) < 0;
+}
+
+static FAST_CODE bool taskIsDue(const cfTask_t *task, timeUs_t currentTimeUs)
+{
+    return (timeDelta_t)(currentTimeUs - (task->lastExecutedAt + task->desiredPeriod)) >= 0;
+}
+
+static FAST_CODE void taskHeapSiftDown(taskHeap_t *heap, int index)
+{
+    cfTask_t *task = heap->task[index];
+    for (;;) {
+        int child = 2 * index + 1;
+        if (child >= heap->count) {
+            break;
+        }
+        if (child + 1 < heap->count && taskDueBefore(heap->task[child + 1], heap->task[child])) {
+            child++;
+        }
+        if (!taskDueBefore(heap->task[child], task)) {
+            break;
+        }
+        heap->task[index] = heap->task[child];
+        heap->task[index]->heapIndex = index;
+        index = child;
+    }
+    heap->task[index] = task;
+    task->heapIndex = index;
+}
+
+static FAST_CODE void taskHeapSiftUp(taskHeap_t *heap, int index)
+{
+    cfTask_t *task = heap->task[index];
+    while (index > 0) {
+        const int parent = (index - 1) / 2;
+        if (!taskDueBefore(task, heap->task[parent])) {
+            break;
+        }
+        heap->task[index] = heap->task[parent];
+        heap->task[index]->heapIndex = index;
+        index = parent;
+    }
+    heap->task[index] = task;
+    task->heapIndex = index;
+}
+
+static FAST_CODE taskHeap_t *taskHeapFor(const cfTask_t *task)
+{
+    return &taskHeap[MIN(task->staticPriority, TASK_PRIORITY_REALTIME)];
+}
+
+static FAST_CODE void taskHeapPush(cfTask_t *task)
+{
+    taskHeap_t *heap = taskHeapFor(task);
+    heap->task[heap->count] = task;
+    taskHeapSiftUp(heap, heap->count++);
+}
+
+static FAST_CODE cfTask_t *taskHeapPop(taskHeap_t *heap)
+{
+    cfTask_t *task = heap->task[0];
+    task->heapIndex = -1;
+    if (--heap->count) {
+        heap->task[0] = heap->task[heap->count];
+        taskHeapSiftDown(heap, 0);
+    }
+    return task;
+}
+
+static void deadlineQueueAdd(cfTask_t *task)
+{
+    if (taskIsEventDriven(task)) {
+        eventTaskQueue[eventTaskQueueSize++] = task;
+    } else {
+        taskHeapPush(task);
+    }
+}
+
+static void deadlineQueueRemove(cfTask_t *task)
+{
+    if (taskIsEventDriven(task)) {
+        for (int ii = 0; ii < eventTaskQueueSize; ++ii) {
+            if (eventTaskQueue[ii] == task) {
+                memmove(&eventTaskQueue[ii], &eventTaskQueue[ii + 1], sizeof(task) * (eventTaskQueueSize - ii - 1));
+                --eventTaskQueueSize;
+                return;
+            }
+        }
+    } else {
+        // a task collected by the current scheduler() pass is not in its heap
+        const int index = task->heapIndex;
+        if (index >= 0) {
+            taskHeap_t *heap = taskHeapFor(task);
+            task->heapIndex = -1;
+            if (index < --heap->count) {
+                heap->task[index] = heap->task[heap->count];
+                taskHeapSiftUp(heap, index);
+                taskHeapSiftDown(heap, index);
+            }
+        }
+    }
+}
+
+// Restore the heap ordering after the next due time of a queued task has been changed
+static FAST_CODE void deadlineQueueUpdate(cfTask_t *task)
+{
+    if (!taskIsEventDriven(task) && task->queued && task->heapIndex >= 0) {
+        taskHeap_t *heap = taskHeapFor(task);
+        taskHeapSiftUp(heap, task->heapIndex);
+        taskHeapSiftDown(heap, task->heapIndex);
+    }
+}
+
+// Collect the tasks the scheduler has to consider: all event driven tasks, and every time driven task that is due,
+// highest priority level first. These are exactly the tasks the plain queue would age. The due tasks are popped off
+// their heaps in deadline order, deadlineQueueRestore() puts them back once the priorities have been evaluated.
+static FAST_CODE int deadlineQueueCollect(cfTask_t **tasks, timeUs_t currentTimeUs)
+{
+    int count = 0;
+    for (int ii = 0; ii < eventTaskQueueSize; ++ii) {
+        tasks[count++] = eventTaskQueue[ii];
+    }
+    for (int level = TASK_PRIORITY_REALTIME; level >= 0; --level) {
+        taskHeap_t *heap = &taskHeap[level];
+        while (heap->count && taskIsDue(heap->task[0], currentTimeUs)) {
+            tasks[count++] = taskHeapPop(heap);
+        }
+    }
+    return count;
+}
+
+static FAST_CODE void deadlineQueueRestore(cfTask_t **tasks, int count)
+{
+    for (int ii = 0; ii < count; ++ii) {
+        cfTask_t *task = tasks[ii];
+        // a check function may have disabled or requeued the task in the meantime
+        if (!taskIsEventDriven(task) && task->queued && task->heapIndex < 0) {
+            taskHeapPush(task);
+        }
+    }
+}
+#endif
+
 void queueClear(void)
 {
+    for (int ii = 0; ii < TASK_COUNT; ++ii) {
+        cfTasks[ii].queued = false;
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+        cfTasks[ii].heapIndex = -1;
+#endif
+    }
     memset(taskQueueArray, 0, sizeof(taskQueueArray));
     taskQueuePos = 0;
     taskQueueSize = 0;
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+    memset(taskHeap, 0, sizeof(taskHeap));
+    eventTaskQueueSize = 0;
+#endif
 }
 
 bool queueContains(cfTask_t *task)
 {
-    for (int ii = 0; ii < taskQueueSize; ++ii) {
-        if (taskQueueArray[ii] == task) {
-            return true;
-        }
-    }
-    return false;
+    return task->queued;
 }
 
 bool queueAdd(cfTask_t *task)
@@ -88,6 +289,10 @@ bool queueAdd(cfTask_t *task)
             memmove(&taskQueueArray[ii+1], &taskQueueArray[ii], sizeof(task) * (taskQueueSize - ii));
             taskQueueArray[ii] = task;
             ++taskQueueSize;
+            task->queued = true;
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+            deadlineQueueAdd(task);
+#endif
             return true;
         }
     }
@@ -96,10 +301,17 @@ bool queueAdd(cfTask_t *task)
 
 bool queueRemove(cfTask_t *task)
 {
+    if (!task->queued) {
+        return false;
+    }
     for (int ii = 0; ii < taskQueueSize; ++ii) {
         if (taskQueueArray[ii] == task) {
             memmove(&taskQueueArray[ii], &taskQueueArray[ii+1], sizeof(task) * (taskQueueSize - ii));
             --taskQueueSize;
+            task->queued = false;
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+            deadlineQueueRemove(task);
+#endif
             return true;
         }
     }
@@ -125,7 +337,9 @@ FAST_CODE cfTask_t *queueNext(void)
 
 void taskSystemLoad(timeUs_t currentTimeUs)
 {
+#ifdef SKIP_TASK_STATISTICS
     UNUSED(currentTimeUs);
+#endif
 
     // Calculate system load
     if (totalWaitingTasksSamples > 0) {
@@ -133,6 +347,14 @@ void taskSystemLoad(timeUs_t currentTimeUs)
         totalWaitingTasksSamples = 0;
         totalWaitingTasks = 0;
     }
+#ifndef SKIP_TASK_STATISTICS
+    const timeDelta_t sampleTimeUs = cmpTimeUs(currentTimeUs, idleTimeSampledAt);
+    if (sampleTimeUs > 0) {
+        averageIdlePercent = MIN((uint64_t)idleTimeUs * 100 / (uint32_t)sampleTimeUs, 100U);
+        idleTimeUs = 0;
+        idleTimeSampledAt = currentTimeUs;
+    }
+#endif
 #if defined(SIMULATOR_BUILD)
     averageSystemLoadPercent = 0;
 #endif
@@ -156,6 +378,9 @@ void getTaskInfo(cfTaskId_e taskId, cfTaskInfo_t * taskInfo)
     taskInfo->taskName = cfTasks[taskId].taskName;
     taskInfo->subTaskName = cfTasks[taskId].subTaskName;
     taskInfo->isEnabled = queueContains(&cfTasks[taskId]);
+#ifdef USE_PREEMPTIVE_PID_LOOP
+    taskInfo->isEnabled = taskInfo->isEnabled || interruptTask == &cfTasks[taskId];
+#endif
     taskInfo->desiredPeriod = cfTasks[taskId].desiredPeriod;
     taskInfo->staticPriority = cfTasks[taskId].staticPriority;
     taskInfo->maxExecutionTime = cfTasks[taskId].maxExecutionTime;
@@ -165,14 +390,67 @@ void getTaskInfo(cfTaskId_e taskId, cfTaskInfo_t * taskInfo)
 }
 #endif
 
+#ifdef USE_TASK_HISTOGRAMS
+static FAST_CODE void taskHistogramAdd(taskHistogram_t *histogram, timeUs_t value)
+{
+    const int index = value == 0 ? 0 : MIN(32 - __builtin_clz(value), TASK_HISTOGRAM_BUCKET_COUNT - 1);
+    if (histogram->bucket[index] == UINT16_MAX) {
+        for (int ii = 0; ii < TASK_HISTOGRAM_BUCKET_COUNT; ++ii) {
+            histogram->bucket[ii] >>= 1;
+        }
+    }
+    histogram->bucket[index]++;
+}
+
+/*
+ * Returns the upper bound, in microseconds, of the bucket containing the given percentile (in 1/1000ths)
+ */
+timeUs_t taskHistogramPercentile(const taskHistogram_t *histogram, unsigned permille)
+{
+    uint32_t total = 0;
+    for (int ii = 0; ii < TASK_HISTOGRAM_BUCKET_COUNT; ++ii) {
+        total += histogram->bucket[ii];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    const uint32_t threshold = (total * permille + 999) / 1000;
+    uint32_t count = 0;
+    int index = 0;
+    for (; index < TASK_HISTOGRAM_BUCKET_COUNT - 1; ++index) {
+        count += histogram->bucket[index];
+        if (count >= threshold) {
+            break;
+        }
+    }
+    return (1 << index) - 1;
+}
+
+bool getTaskHistograms(cfTaskId_e taskId, taskHistogram_t *executionTimeHistogram, taskHistogram_t *startLatencyHistogram)
+{
+    if (taskId >= TASK_COUNT) {
+        return false;
+    }
+    *executionTimeHistogram = cfTasks[taskId].executionTimeHistogram;
+    *startLatencyHistogram = cfTasks[taskId].startLatencyHistogram;
+    return true;
+}
+#endif
+
 void rescheduleTask(cfTaskId_e taskId, uint32_t newPeriodMicros)
 {
     if (taskId == TASK_SELF) {
         cfTask_t *task = currentTask;
         task->desiredPeriod = MAX(SCHEDULER_DELAY_LIMIT, (timeDelta_t)newPeriodMicros);  // Limit delay to 100us (10 kHz) to prevent scheduler clogging
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+        deadlineQueueUpdate(task);
+#endif
     } else if (taskId < TASK_COUNT) {
         cfTask_t *task = &cfTasks[taskId];
         task->desiredPeriod = MAX(SCHEDULER_DELAY_LIMIT, (timeDelta_t)newPeriodMicros);  // Limit delay to 100us (10 kHz) to prevent scheduler clogging
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+        deadlineQueueUpdate(task);
+#endif
     }
 }
 
@@ -199,6 +477,100 @@ timeDelta_t getTaskDeltaTime(cfTaskId_e taskId)
     }
 }
 
+cfTaskId_e schedulerCurrentTaskId(void)
+{
+    return currentTask ? (cfTaskId_e)(currentTask - cfTasks) : TASK_NONE;
+}
+
+#ifdef STACK_CHECK
+uint16_t getTaskStackPeak(cfTaskId_e taskId)
+{
+    return taskId < TASK_COUNT ? cfTasks[taskId].stackPeak : 0;
+}
+#endif
+
+static FAST_CODE void taskExecute(cfTask_t *task, timeUs_t currentTimeUs)
+{
+#ifdef STACK_CHECK
+    // a run now and then is enough for the peak, sampling costs a fill and a scan of the free stack
+    if (!stackSampling && cmpTimeUs(currentTimeUs, task->stackSampledAt) >= STACK_CHECK_SAMPLE_INTERVAL_US) {
+        stackSampling = true;
+        task->stackSampledAt = currentTimeUs;
+        stackCheckBegin();
+        task->taskFunc(currentTimeUs);
+        task->stackPeak = MAX(task->stackPeak, stackCheckEnd());
+        stackSampling = false;
+        return;
+    }
+#endif
+    task->taskFunc(currentTimeUs);
+}
+
+// Time the running task has left before the next realtime task is due, negative if that is overdue already.
+// Long running tasks check it to split their work over several scheduler slots, see schedulerYield().
+timeDelta_t schedulerGetRemainingTimeUs(void)
+{
+    const timeUs_t currentTimeUs = micros();
+    timeDelta_t remainingTimeUs = SCHEDULER_TIME_UNLIMITED;
+    // realtime tasks are at the front of the queue
+    for (int ii = 0; ii < taskQueueSize && taskQueueArray[ii]->staticPriority >= TASK_PRIORITY_REALTIME; ++ii) {
+        const cfTask_t *task = taskQueueArray[ii];
+        remainingTimeUs = MIN(remainingTimeUs, cmpTimeUs(task->lastExecutedAt + task->desiredPeriod, currentTimeUs));
+    }
+    return remainingTimeUs;
+}
+
+// Called by a time driven task that returns before its work is done: it is run again at the next
+// opportunity rather than after its period, and carries on from the state it kept.
+void schedulerYield(void)
+{
+    currentTaskYielded = true;
+}
+
+#ifdef USE_SCHEDULER_IDLE_SLEEP
+// Lets scheduler() sleep until the next interrupt when no task is ready to run. wakeupIntervalUs is the longest
+// time between interrupts that are certain to occur, it only sleeps if no time driven task becomes due sooner.
+void schedulerEnableIdleSleep(timeDelta_t wakeupIntervalUs)
+{
+    idleSleepWakeupIntervalUs = wakeupIntervalUs;
+}
+
+static void idleSleepDebug(timeUs_t sleptAt, timeUs_t nextDueAt)
+{
+    const timeUs_t wokeAt = micros();
+    const timeDelta_t wakeupLatencyUs = cmpTimeUs(wokeAt, sleptAt) - idleSleepWakeupIntervalUs;
+    idleSleepMaxWakeupLatencyUs = MAX(idleSleepMaxWakeupLatencyUs, wakeupLatencyUs);
+    if (cmpTimeUs(wokeAt, nextDueAt) > 0) {
+        idleSleepOvershootCount++;
+    }
+    debug[0] = cmpTimeUs(wokeAt, sleptAt);
+    debug[1] = wakeupLatencyUs;
+    debug[2] = idleSleepMaxWakeupLatencyUs;
+    debug[3] = idleSleepOvershootCount;
+}
+
+static FAST_CODE timeDelta_t timeUntilNextDueTask(timeUs_t currentTimeUs)
+{
+    timeDelta_t timeUntilDueUs = SCHEDULER_TIME_UNLIMITED;
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+    for (int ii = 0; ii < TASK_PRIORITY_LEVEL_COUNT; ++ii) {
+        if (taskHeap[ii].count) {
+            const cfTask_t *task = taskHeap[ii].task[0];
+            timeUntilDueUs = MIN(timeUntilDueUs, cmpTimeUs(task->lastExecutedAt + task->desiredPeriod, currentTimeUs));
+        }
+    }
+#else
+    for (int ii = 0; ii < taskQueueSize; ++ii) {
+        const cfTask_t *task = taskQueueArray[ii];
+        if (!taskIsEventDriven(task)) {
+            timeUntilDueUs = MIN(timeUntilDueUs, cmpTimeUs(task->lastExecutedAt + task->desiredPeriod, currentTimeUs));
+        }
+    }
+#endif
+    return timeUntilDueUs;
+}
+#endif
+
 void schedulerSetCalulateTaskStatistics(bool calculateTaskStatisticsToUse)
 {
     calculateTaskStatistics = calculateTaskStatisticsToUse;
@@ -209,18 +581,206 @@ void schedulerResetTaskStatistics(cfTaskId_e taskId)
 #ifdef SKIP_TASK_STATISTICS
     UNUSED(taskId);
 #else
+    cfTask_t *task = NULL;
     if (taskId == TASK_SELF) {
-        currentTask->movingSumExecutionTime = 0;
-        currentTask->totalExecutionTime = 0;
-        currentTask->maxExecutionTime = 0;
+        task = currentTask;
     } else if (taskId < TASK_COUNT) {
-        cfTasks[taskId].movingSumExecutionTime = 0;
-        cfTasks[taskId].totalExecutionTime = 0;
-        cfTasks[taskId].maxExecutionTime = 0;
+        task = &cfTasks[taskId];
+    }
+    if (task) {
+        task->movingSumExecutionTime = 0;
+        task->totalExecutionTime = 0;
+        task->maxExecutionTime = 0;
+#ifdef USE_TASK_HISTOGRAMS
+        memset(&task->executionTimeHistogram, 0, sizeof(task->executionTimeHistogram));
+        memset(&task->startLatencyHistogram, 0, sizeof(task->startLatencyHistogram));
+#endif
+    }
+#endif
+}
+
+#ifdef USE_SCHEDULER_TRACE
+// Ring buffer of the most recent task runs. It is lock free: the scheduler and the interrupt task both
+// add entries and claim a slot with an atomic increment. The writer clears the stamp of the slot, fills it in
+// and stamps it with its sequence number last. Readers check the stamp before and after copying the entry.
+#ifdef USE_CRASH_TRACE
+// kept over a reset, for crashTraceInit() to report after the reboot
+static PERSISTENT schedulerTraceEntry_t schedulerTrace[SCHEDULER_TRACE_SIZE];
+static PERSISTENT uint32_t schedulerTraceHead;
+#else
+static FAST_RAM_ZERO_INIT schedulerTraceEntry_t schedulerTrace[SCHEDULER_TRACE_SIZE];
+static FAST_RAM_ZERO_INIT uint32_t schedulerTraceHead; // sequence number of the next entry
+#endif
+
+static FAST_CODE void schedulerTraceAdd(const cfTask_t *task, timeUs_t startedAt, timeUs_t executionTime, timeDelta_t lateness)
+{
+    const uint32_t sequence = __atomic_fetch_add(&schedulerTraceHead, 1, __ATOMIC_RELAXED);
+    schedulerTraceEntry_t *entry = &schedulerTrace[sequence % SCHEDULER_TRACE_SIZE];
+    __atomic_store_n(&entry->stamp, 0, __ATOMIC_RELAXED);
+    __atomic_signal_fence(__ATOMIC_RELEASE);
+    entry->startedAt = startedAt;
+    entry->executionTime = MIN(executionTime, (timeUs_t)UINT16_MAX);
+    entry->lateness = constrain(lateness, INT16_MIN, INT16_MAX);
+    entry->taskId = task - cfTasks;
+    __atomic_store_n(&entry->stamp, sequence + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t schedulerTraceSequence(void)
+{
+    return __atomic_load_n(&schedulerTraceHead, __ATOMIC_RELAXED);
+}
+
+// Copies the entry with the given sequence number, returns false if it is not complete yet or already overwritten
+bool schedulerTraceRead(uint32_t sequence, schedulerTraceEntry_t *entry)
+{
+    const schedulerTraceEntry_t *slot = &schedulerTrace[sequence % SCHEDULER_TRACE_SIZE];
+    if (__atomic_load_n(&slot->stamp, __ATOMIC_ACQUIRE) != sequence + 1) {
+        return false;
+    }
+    *entry = *slot;
+    __atomic_signal_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->stamp, __ATOMIC_RELAXED) == sequence + 1;
+}
+
+void schedulerTraceClear(void)
+{
+    schedulerTraceHead = 0;
+    for (unsigned i = 0; i < SCHEDULER_TRACE_SIZE; i++) {
+        schedulerTrace[i].stamp = 0;
     }
+}
 #endif
+
+#ifdef USE_TASK_CHAINING
+// Makes a task run straight after every denom executions of another one instead of on its own period.
+// TASK_NONE makes it time driven again.
+void schedulerChainTask(cfTaskId_e taskId, cfTaskId_e afterTaskId, uint16_t denom)
+{
+    cfTask_t *task = &cfTasks[taskId];
+    // the deadline queue keeps event driven tasks apart, so requeue the task around the change
+    const bool queued = queueRemove(task);
+
+    for (int ii = 0; ii < chainedTaskCount; ++ii) {
+        if (chainedTasks[ii] == task) {
+            chainedTasks[ii] = chainedTasks[--chainedTaskCount];
+            break;
+        }
+    }
+    task->chainedAfter = NULL;
+    task->chainSignalled = false;
+    task->dynamicPriority = 0;
+
+    if (afterTaskId < TASK_COUNT && afterTaskId != taskId) {
+        task->chainedAfter = &cfTasks[afterTaskId];
+        task->chainDenom = MAX(denom, 1);
+        task->chainCount = 0;
+        // keeps the task age and the statistics meaningful
+        task->desiredPeriod = task->chainedAfter->desiredPeriod * task->chainDenom;
+        chainedTasks[chainedTaskCount++] = task;
+    }
+
+    if (queued) {
+        queueAdd(task);
+    }
 }
 
+static FAST_CODE void signalChainedTasks(const cfTask_t *task)
+{
+    for (int ii = 0; ii < chainedTaskCount; ++ii) {
+        cfTask_t *chainedTask = chainedTasks[ii];
+        if (chainedTask->chainedAfter == task && ++chainedTask->chainCount >= chainedTask->chainDenom) {
+            chainedTask->chainCount = 0;
+            chainedTask->lastSignaledAt = micros();
+            // may run from an interrupt task, release so lastSignaledAt is seen along with the flag
+            __atomic_store_n(&chainedTask->chainSignalled, true, __ATOMIC_RELEASE);
+        }
+    }
+}
+#endif
+
+#ifdef USE_TASK_SIGNAL
+// Called from an interrupt handler when an event driven task has work, e.g. a complete RX frame.
+// The task is then chosen on the next scheduler() pass ahead of anything but the realtime tasks,
+// instead of competing on its static priority. On a busy loop the wakeup latency is therefore
+// bounded by the execution time of the task running when the signal arrives, plus a PID loop
+// iteration if the signal falls into the realtime guard interval. The task's start latency
+// histogram is measured from the signal time, so the bound can be checked with the tasks CLI command.
+void schedulerSignalTask(cfTaskId_e taskId)
+{
+    if (taskId < TASK_COUNT) {
+        cfTask_t *task = &cfTasks[taskId];
+        task->signalledAt = micros();
+        task->signalled = true;
+    }
+}
+#endif
+
+#ifdef USE_PREEMPTIVE_PID_LOOP
+// Hands a task over to an interrupt handler, which then runs it through schedulerExecuteInterruptTask().
+// TASK_NONE returns the task to the cooperative scheduler.
+void schedulerSetInterruptTask(cfTaskId_e taskId)
+{
+    if (interruptTask) {
+        cfTask_t *task = interruptTask;
+        interruptTask = NULL;
+        queueAdd(task);
+    }
+    if (taskId < TASK_COUNT) {
+        queueRemove(&cfTasks[taskId]);
+        interruptTask = &cfTasks[taskId];
+    }
+}
+
+FAST_CODE void schedulerExecuteInterruptTask(timeUs_t currentTimeUs)
+{
+    cfTask_t *task = interruptTask;
+    if (!task) {
+        return;
+    }
+
+    // the preempted task gets currentTask back once the interrupt task is done, so TASK_SELF keeps working for both
+    cfTask_t *preemptedTask = currentTask;
+    currentTask = task;
+
+#ifdef USE_SCHEDULER_TRACE
+    const timeDelta_t lateness = (timeDelta_t)(currentTimeUs - (task->lastExecutedAt + task->desiredPeriod));
+#endif
+    task->taskLatestDeltaTime = currentTimeUs - task->lastExecutedAt;
+    task->lastExecutedAt = currentTimeUs;
+
+#ifdef SKIP_TASK_STATISTICS
+    taskExecute(task, currentTimeUs);
+#else
+    if (calculateTaskStatistics) {
+        taskExecute(task, currentTimeUs);
+        const timeUs_t taskExecutionTime = micros() - currentTimeUs;
+        task->movingSumExecutionTime += taskExecutionTime - task->movingSumExecutionTime / MOVING_SUM_COUNT;
+        task->totalExecutionTime += taskExecutionTime;
+        task->maxExecutionTime = MAX(task->maxExecutionTime, taskExecutionTime);
+#ifdef USE_TASK_HISTOGRAMS
+        taskHistogramAdd(&task->executionTimeHistogram, taskExecutionTime);
+#endif
+#ifdef USE_SCHEDULER_TRACE
+        schedulerTraceAdd(task, currentTimeUs, taskExecutionTime, lateness);
+#endif
+    } else {
+        taskExecute(task, currentTimeUs);
+    }
+#endif
+#ifdef USE_TASK_CHAINING
+    signalChainedTasks(task);
+#endif
+
+    currentTask = preemptedTask;
+}
+
+// True while the interrupt task runs, so what it calls can leave work that is not safe to preempt to a background task
+FAST_CODE bool schedulerInInterruptTask(void)
+{
+    return interruptTask && currentTask == interruptTask;
+}
+#endif
+
 void schedulerInit(void)
 {
     calculateTaskStatistics = true;
@@ -233,6 +793,31 @@ FAST_CODE void scheduler(void)
     // Cache currentTime
     const timeUs_t currentTimeUs = micros();
 
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+    // Check for realtime tasks, only the head of the realtime heap can be due
+    bool outsideRealtimeGuardInterval = true;
+    const cfTask_t *realtimeTask = taskHeap[TASK_PRIORITY_REALTIME].count ? taskHeap[TASK_PRIORITY_REALTIME].task[0] : NULL;
+    if (realtimeTask && taskIsDue(realtimeTask, currentTimeUs)) {
+        outsideRealtimeGuardInterval = false;
+    }
+    for (int ii = 0; outsideRealtimeGuardInterval && ii < eventTaskQueueSize; ++ii) {
+        const cfTask_t *task = eventTaskQueue[ii];
+        if (task->staticPriority >= TASK_PRIORITY_REALTIME && taskIsDue(task, currentTimeUs)) {
+            outsideRealtimeGuardInterval = false;
+        }
+    }
+
+    // The task to be invoked
+    cfTask_t *selectedTask = NULL;
+    uint16_t selectedTaskDynamicPriority = 0;
+
+    // Update dynamic priorities of the event driven tasks and of the time driven tasks that are due
+    uint16_t waitingTasks = 0;
+    cfTask_t *candidateTasks[TASK_COUNT];
+    const int candidateTaskCount = deadlineQueueCollect(candidateTasks, currentTimeUs);
+    for (int ii = 0; ii < candidateTaskCount; ++ii) {
+        cfTask_t *task = candidateTasks[ii];
+#else
     // Check for realtime tasks
     bool outsideRealtimeGuardInterval = true;
     for (const cfTask_t *task = queueFirst(); task != NULL && task->staticPriority >= TASK_PRIORITY_REALTIME; task = queueNext()) {
@@ -250,6 +835,23 @@ FAST_CODE void scheduler(void)
     // Update task dynamic priorities
     uint16_t waitingTasks = 0;
     for (cfTask_t *task = queueFirst(); task != NULL; task = queueNext()) {
+#endif
+#ifdef USE_TASK_CHAINING
+        if (task->chainedAfter) {
+            // Chained tasks take precedence over everything but the realtime tasks, to use the slack straight after the task they follow.
+            // signalChainedTasks() can run from an interrupt task, so the signal is taken with a test and clear and kept in
+            // dynamicPriority until the task is selected. A signal raised after the exchange stays set for the next pass.
+            if (__atomic_exchange_n(&task->chainSignalled, false, __ATOMIC_ACQUIRE)) {
+                task->dynamicPriority = TASK_PRIORITY_MAX;
+            }
+            if (task->dynamicPriority > 0) {
+                task->taskAgeCycles = 1;
+                waitingTasks++;
+            } else {
+                task->taskAgeCycles = 0;
+            }
+        } else
+#endif
         // Task has checkFunc - event driven
         if (task->checkFunc) {
 #if defined(SCHEDULER_DEBUG)
@@ -261,25 +863,46 @@ FAST_CODE void scheduler(void)
             if (task->dynamicPriority > 0) {
                 task->taskAgeCycles = 1 + ((currentTimeUs - task->lastSignaledAt) / task->desiredPeriod);
                 task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
+#ifdef USE_TASK_SIGNAL
+                if (task->signalled) {
+                    task->dynamicPriority = TASK_PRIORITY_MAX;
+                }
+#endif
                 waitingTasks++;
-            } else if (task->checkFunc(currentTimeBeforeCheckFuncCall, currentTimeBeforeCheckFuncCall - task->lastExecutedAt)) {
+            } else {
+#ifdef USE_TASK_SIGNAL
+                // Test and clear before the check, so a signal raised after the check has looked stays set for the
+                // next pass instead of being dropped along with one the check found nothing for (e.g. a bad CRC)
+                const bool signalled = __atomic_exchange_n(&task->signalled, false, __ATOMIC_ACQUIRE);
+#endif
+                if (task->checkFunc(currentTimeBeforeCheckFuncCall, currentTimeBeforeCheckFuncCall - task->lastExecutedAt)) {
 #if defined(SCHEDULER_DEBUG)
-                DEBUG_SET(DEBUG_SCHEDULER, 3, micros() - currentTimeBeforeCheckFuncCall);
+                    DEBUG_SET(DEBUG_SCHEDULER, 3, micros() - currentTimeBeforeCheckFuncCall);
 #endif
 #ifndef SKIP_TASK_STATISTICS
-                if (calculateTaskStatistics) {
-                    const uint32_t checkFuncExecutionTime = micros() - currentTimeBeforeCheckFuncCall;
-                    checkFuncMovingSumExecutionTime += checkFuncExecutionTime - checkFuncMovingSumExecutionTime / MOVING_SUM_COUNT;
-                    checkFuncTotalExecutionTime += checkFuncExecutionTime;   // time consumed by scheduler + task
-                    checkFuncMaxExecutionTime = MAX(checkFuncMaxExecutionTime, checkFuncExecutionTime);
-                }
+                    if (calculateTaskStatistics) {
+                        const uint32_t checkFuncExecutionTime = micros() - currentTimeBeforeCheckFuncCall;
+                        checkFuncMovingSumExecutionTime += checkFuncExecutionTime - checkFuncMovingSumExecutionTime / MOVING_SUM_COUNT;
+                        checkFuncTotalExecutionTime += checkFuncExecutionTime;   // time consumed by scheduler + task
+                        checkFuncMaxExecutionTime = MAX(checkFuncMaxExecutionTime, checkFuncExecutionTime);
+                    }
 #endif
-                task->lastSignaledAt = currentTimeBeforeCheckFuncCall;
-                task->taskAgeCycles = 1;
-                task->dynamicPriority = 1 + task->staticPriority;
-                waitingTasks++;
-            } else {
-                task->taskAgeCycles = 0;
+                    task->lastSignaledAt = currentTimeBeforeCheckFuncCall;
+                    task->taskAgeCycles = 1;
+                    task->dynamicPriority = 1 + task->staticPriority;
+#ifdef USE_TASK_SIGNAL
+                    if (signalled) {
+                        // signalled from an interrupt, so run next and measure the latency from the interrupt
+                        task->lastSignaledAt = task->signalledAt;
+                        task->dynamicPriority = TASK_PRIORITY_MAX;
+                        // keeps the boost while the task waits, it is cleared when the task is selected
+                        task->signalled = true;
+                    }
+#endif
+                    waitingTasks++;
+                } else {
+                    task->taskAgeCycles = 0;
+                }
             }
         } else {
             // Task is time-driven, dynamicPriority is last execution age (measured in desiredPeriods)
@@ -303,6 +926,10 @@ FAST_CODE void scheduler(void)
         }
     }
 
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+    deadlineQueueRestore(candidateTasks, candidateTaskCount);
+#endif
+
     totalWaitingTasksSamples++;
     totalWaitingTasks += waitingTasks;
 
@@ -310,26 +937,59 @@ FAST_CODE void scheduler(void)
 
     if (selectedTask) {
         // Found a task that should be run
+#if defined(USE_TASK_HISTOGRAMS) || defined(USE_SCHEDULER_TRACE)
+        const timeUs_t dueAt = taskIsEventDriven(selectedTask) ? selectedTask->lastSignaledAt : selectedTask->lastExecutedAt + selectedTask->desiredPeriod;
+        const timeDelta_t lateness = (timeDelta_t)(currentTimeUs - dueAt);
+#endif
+#if defined(USE_TASK_HISTOGRAMS)
+        if (calculateTaskStatistics) {
+            taskHistogramAdd(&selectedTask->startLatencyHistogram, MAX(lateness, 0));
+        }
+#endif
         selectedTask->taskLatestDeltaTime = currentTimeUs - selectedTask->lastExecutedAt;
         selectedTask->lastExecutedAt = currentTimeUs;
         selectedTask->dynamicPriority = 0;
+#ifdef USE_TASK_SIGNAL
+        selectedTask->signalled = false;
+#endif
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+        // the selected task is not necessarily the head of its heap, an older task with a longer period can win
+        deadlineQueueUpdate(selectedTask);
+#endif
 
         // Execute task
 #ifdef SKIP_TASK_STATISTICS
-        selectedTask->taskFunc(currentTimeUs);
+        taskExecute(selectedTask, currentTimeUs);
 #else
         if (calculateTaskStatistics) {
             const timeUs_t currentTimeBeforeTaskCall = micros();
-            selectedTask->taskFunc(currentTimeBeforeTaskCall);
+            taskExecute(selectedTask, currentTimeBeforeTaskCall);
             const timeUs_t taskExecutionTime = micros() - currentTimeBeforeTaskCall;
             selectedTask->movingSumExecutionTime += taskExecutionTime - selectedTask->movingSumExecutionTime / MOVING_SUM_COUNT;
             selectedTask->totalExecutionTime += taskExecutionTime;   // time consumed by scheduler + task
             selectedTask->maxExecutionTime = MAX(selectedTask->maxExecutionTime, taskExecutionTime);
+#ifdef USE_TASK_HISTOGRAMS
+            taskHistogramAdd(&selectedTask->executionTimeHistogram, taskExecutionTime);
+#endif
+#ifdef USE_SCHEDULER_TRACE
+            schedulerTraceAdd(selectedTask, currentTimeBeforeTaskCall, taskExecutionTime, lateness);
+#endif
         } else {
-            selectedTask->taskFunc(currentTimeUs);
+            taskExecute(selectedTask, currentTimeUs);
         }
 
 #endif
+#ifdef USE_TASK_CHAINING
+        signalChainedTasks(selectedTask);
+#endif
+        if (currentTaskYielded) {
+            currentTaskYielded = false;
+            // make the task due again straight away
+            selectedTask->lastExecutedAt = currentTimeUs - selectedTask->desiredPeriod;
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+            deadlineQueueUpdate(selectedTask);
+#endif
+        }
 #if defined(SCHEDULER_DEBUG)
         DEBUG_SET(DEBUG_SCHEDULER, 2, micros() - currentTimeUs - taskExecutionTime); // time spent in scheduler
     } else {
@@ -337,5 +997,24 @@ FAST_CODE void scheduler(void)
 #endif
     }
 
+    if (!selectedTask) {
+#ifdef USE_SCHEDULER_IDLE_SLEEP
+        // event driven tasks are signalled by interrupts, which also end the sleep
+        if (idleSleepWakeupIntervalUs) {
+            const timeDelta_t timeUntilDueUs = timeUntilNextDueTask(currentTimeUs);
+            if (timeUntilDueUs >= idleSleepWakeupIntervalUs + SCHEDULER_IDLE_SLEEP_MARGIN_US) {
+                const timeUs_t sleptAt = micros();
+                systemIdleSleep();
+                if (debugMode == DEBUG_IDLE_SLEEP) {
+                    idleSleepDebug(sleptAt, currentTimeUs + timeUntilDueUs);
+                }
+            }
+        }
+#endif
+#ifndef SKIP_TASK_STATISTICS
+        idleTimeUs += micros() - currentTimeUs;
+#endif
+    }
+
     GET_SCHEDULER_LOCALS();
 }
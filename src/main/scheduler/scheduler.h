@@ -26,6 +26,8 @@
 #define TASK_PERIOD_MS(ms) ((ms) * 1000)
 #define TASK_PERIOD_US(us) (us)
 
+#define SCHEDULER_TIME_UNLIMITED INT32_MAX // remaining time when no realtime task is queued
+
 
 typedef enum {
     TASK_PRIORITY_IDLE = 0,     // Disables dynamic scheduling, task is executed only if no other task is active this cycle
@@ -43,6 +45,28 @@ typedef struct {
     timeUs_t     averageExecutionTime;
 } cfCheckFuncInfo_t;
 
+#ifdef USE_TASK_HISTOGRAMS
+#define TASK_HISTOGRAM_BUCKET_COUNT 16
+
+// log2 bucketed histogram of microsecond durations, bucket n (n > 0) counts durations in [2^(n-1), 2^n - 1]
+// all buckets are halved when one of them saturates, so percentiles are over a decaying window
+typedef struct {
+    uint16_t bucket[TASK_HISTOGRAM_BUCKET_COUNT];
+} taskHistogram_t;
+#endif
+
+#ifdef USE_SCHEDULER_TRACE
+#define SCHEDULER_TRACE_SIZE 64U // power of 2
+
+typedef struct schedulerTraceEntry_s {
+    timeUs_t startedAt;
+    uint16_t executionTime; // us, saturated
+    int16_t lateness;       // us the task started after it was due, saturated
+    uint8_t taskId;
+    uint32_t stamp;         // sequence number + 1 once the entry is complete, 0 while it is written
+} schedulerTraceEntry_t;
+#endif
+
 typedef struct {
     const char * taskName;
     const char * subTaskName;
@@ -134,6 +158,17 @@ typedef enum {
 #ifdef USE_PINIOBOX
     TASK_PINIOBOX,
 #endif
+#ifdef USE_BLACKBOX_ASYNC
+    TASK_BLACKBOX,
+#endif
+
+#ifdef USE_FLASHFS
+    TASK_FLASHFS_ERASE_AHEAD,
+#endif
+
+#ifdef USE_PID_AUDIO
+    TASK_PID_AUDIO,
+#endif
 
     /* Count of real tasks */
     TASK_COUNT,
@@ -143,7 +178,7 @@ typedef enum {
     TASK_SELF
 } cfTaskId_e;
 
-typedef struct {
+typedef struct cfTask_s {
     // Configuration
     const char * taskName;
     const char * subTaskName;
@@ -153,30 +188,94 @@ typedef struct {
     const uint8_t staticPriority;   // dynamicPriority grows in steps of this size, shouldn't be zero
 
     // Scheduling
+    bool queued;                    // fits in the padding after staticPriority
     uint16_t dynamicPriority;       // measurement of how old task was last executed, used to avoid task starvation
     uint16_t taskAgeCycles;
     timeDelta_t taskLatestDeltaTime;
     timeUs_t lastExecutedAt;        // last time of invocation
     timeUs_t lastSignaledAt;        // time of invocation event for event-driven tasks
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+    int8_t heapIndex;               // position in its deadline heap, -1 while not in it
+#endif
+#ifdef USE_TASK_CHAINING
+    struct cfTask_s *chainedAfter;  // task this one is run straight after, NULL if not chained
+    uint16_t chainDenom;            // run once every chainDenom executions of chainedAfter
+    uint16_t chainCount;
+    volatile bool chainSignalled;   // set by signalChainedTasks(), possibly from an interrupt task
+#endif
+#ifdef USE_TASK_SIGNAL
+    volatile bool signalled;        // set from an interrupt by schedulerSignalTask()
+    volatile timeUs_t signalledAt;
+#endif
 
 #ifndef SKIP_TASK_STATISTICS
     // Statistics
     timeUs_t movingSumExecutionTime;  // moving sum over 32 samples
     timeUs_t maxExecutionTime;
     timeUs_t totalExecutionTime;    // total time consumed by task since boot
+#ifdef USE_TASK_HISTOGRAMS
+    taskHistogram_t executionTimeHistogram;
+    taskHistogram_t startLatencyHistogram;  // time between the task becoming due and it being started
+#endif
+#endif
+#ifdef STACK_CHECK
+    uint16_t stackPeak;             // bytes of stack in use at the deepest point of the sampled runs
+    timeUs_t stackSampledAt;
 #endif
 } cfTask_t;
 
+#ifdef USE_SCHEDULER_DEADLINE_QUEUE
+// binary min-heap of the time driven tasks of one static priority, keyed on the time they are next due
+typedef struct taskHeap_s {
+    cfTask_t *task[TASK_COUNT];
+    uint8_t count;
+} taskHeap_t;
+#endif
+
 extern cfTask_t cfTasks[TASK_COUNT];
 extern uint16_t averageSystemLoadPercent;
+#ifndef SKIP_TASK_STATISTICS
+extern uint16_t averageIdlePercent;
+#endif
 
 void getCheckFuncInfo(cfCheckFuncInfo_t *checkFuncInfo);
 void getTaskInfo(cfTaskId_e taskId, cfTaskInfo_t *taskInfo);
 void rescheduleTask(cfTaskId_e taskId, uint32_t newPeriodMicros);
 void setTaskEnabled(cfTaskId_e taskId, bool newEnabledState);
 timeDelta_t getTaskDeltaTime(cfTaskId_e taskId);
+cfTaskId_e schedulerCurrentTaskId(void);
+#ifdef STACK_CHECK
+uint16_t getTaskStackPeak(cfTaskId_e taskId);
+#endif
+timeDelta_t schedulerGetRemainingTimeUs(void);
+void schedulerYield(void);
+#ifdef USE_SCHEDULER_IDLE_SLEEP
+#define SCHEDULER_IDLE_WAKEUP_SYSTICK_US    1000    // the system tick interrupt wakes the scheduler at least this often
+#define SCHEDULER_IDLE_SLEEP_MARGIN_US      10      // allows for the wakeup interrupt arriving a little late
+void schedulerEnableIdleSleep(timeDelta_t wakeupIntervalUs);
+#endif
 void schedulerSetCalulateTaskStatistics(bool calculateTaskStatistics);
 void schedulerResetTaskStatistics(cfTaskId_e taskId);
+#ifdef USE_TASK_HISTOGRAMS
+bool getTaskHistograms(cfTaskId_e taskId, taskHistogram_t *executionTimeHistogram, taskHistogram_t *startLatencyHistogram);
+timeUs_t taskHistogramPercentile(const taskHistogram_t *histogram, unsigned permille);
+#endif
+#ifdef USE_SCHEDULER_TRACE
+uint32_t schedulerTraceSequence(void);
+bool schedulerTraceRead(uint32_t sequence, schedulerTraceEntry_t *entry);
+void schedulerTraceClear(void);
+#endif
+#ifdef USE_TASK_SIGNAL
+void schedulerSignalTask(cfTaskId_e taskId);
+#endif
+#ifdef USE_TASK_CHAINING
+void schedulerChainTask(cfTaskId_e taskId, cfTaskId_e afterTaskId, uint16_t denom);
+#endif
+#ifdef USE_PREEMPTIVE_PID_LOOP
+void schedulerSetInterruptTask(cfTaskId_e taskId);
+void schedulerExecuteInterruptTask(timeUs_t currentTimeUs);
+bool schedulerInInterruptTask(void);
+#endif
 
 void schedulerInit(void);
 void scheduler(void);
@@ -25,6 +25,7 @@
 #include "platform.h"
 
 #include "common/maths.h"
+#include "common/utils.h"
 
 #include "pg/pg.h"
 #include "pg/pg_ids.h"
@@ -145,6 +146,7 @@ static int32_t baroTemperature = 0;
 static int32_t baroGroundAltitude = 0;
 static int32_t baroGroundPressure = 8*101325;
 static uint32_t baroPressureSum = 0;
+static bool baroPressureSumChanged = true;
 
 bool baroDetect(baroDev_t *dev, baroSensor_e baroHardwareToUse)
 {
@@ -315,9 +317,14 @@ static uint32_t recalculateBarometerTotal(uint8_t baroSampleCount, uint32_t pres
 
 typedef enum {
     BAROMETER_NEEDS_SAMPLES = 0,
-    BAROMETER_NEEDS_CALCULATION
+    BAROMETER_READING_SAMPLES,
+    BAROMETER_NEEDS_CALCULATION,
+    BAROMETER_READING_CALCULATION
 } barometerState_e;
 
+// Time allowed for a non-blocking sample read to complete before it is decoded
+#define BARO_READ_DELAY_US 500
+
 
 bool isBaroReady(void) {
     return baroReady;
@@ -330,6 +337,14 @@ uint32_t baroUpdate(void)
     switch (state) {
         default:
         case BAROMETER_NEEDS_SAMPLES:
+            if (baro.dev.read_ut) {
+                baro.dev.read_ut(&baro.dev);
+                state = BAROMETER_READING_SAMPLES;
+                return BARO_READ_DELAY_US;
+            }
+            FALLTHROUGH;
+
+        case BAROMETER_READING_SAMPLES:
             baro.dev.get_ut(&baro.dev);
             baro.dev.start_up(&baro.dev);
             state = BAROMETER_NEEDS_CALCULATION;
@@ -337,27 +352,47 @@ uint32_t baroUpdate(void)
         break;
 
         case BAROMETER_NEEDS_CALCULATION:
+            if (baro.dev.read_up) {
+                baro.dev.read_up(&baro.dev);
+                state = BAROMETER_READING_CALCULATION;
+                return BARO_READ_DELAY_US;
+            }
+            FALLTHROUGH;
+
+        case BAROMETER_READING_CALCULATION:
             baro.dev.get_up(&baro.dev);
             baro.dev.start_ut(&baro.dev);
             baro.dev.calculate(&baroPressure, &baroTemperature);
             baro.baroPressure = baroPressure;
             baro.baroTemperature = baroTemperature;
             baroPressureSum = recalculateBarometerTotal(barometerConfig()->baro_sample_count, baroPressureSum, baroPressure);
+            baroPressureSumChanged = true;
             state = BAROMETER_NEEDS_SAMPLES;
             return baro.dev.ut_delay;
         break;
     }
 }
 
+// calculates height above sea level in cm from pressure in Pa
+// see: https://github.com/diydrones/ardupilot/blob/master/libraries/AP_Baro/AP_Baro.cpp#L140
+static float pressureToAltitude(const float pressure)
+{
+    return (1.0f - pow_approx(pressure / 101325.0f, 0.190295f)) * 4433000.0f;
+}
+
 int32_t baroCalculateAltitude(void)
 {
-    int32_t BaroAlt_tmp;
+    // the altitude task runs faster than new pressure samples arrive,
+    // so only redo the conversion when the pressure total has changed
+    static int32_t pressureAltitude;
+    if (baroPressureSumChanged) {
+        pressureAltitude = lrintf(pressureToAltitude((float)(baroPressureSum / PRESSURE_SAMPLE_COUNT)));
+        baroPressureSumChanged = false;
+    }
 
     // calculates height from ground via baro readings
-    // see: https://github.com/diydrones/ardupilot/blob/master/libraries/AP_Baro/AP_Baro.cpp#L140
     if (isBaroCalibrationComplete()) {
-        BaroAlt_tmp = lrintf((1.0f - pow_approx((float)(baroPressureSum / PRESSURE_SAMPLE_COUNT) / 101325.0f, 0.190295f)) * 4433000.0f); // in cm
-        BaroAlt_tmp -= baroGroundAltitude;
+        const int32_t BaroAlt_tmp = pressureAltitude - baroGroundAltitude;
         baro.BaroAlt = lrintf((float)baro.BaroAlt * CONVERT_PARAMETER_TO_FLOAT(barometerConfig()->baro_noise_lpf) + (float)BaroAlt_tmp * (1.0f - CONVERT_PARAMETER_TO_FLOAT(barometerConfig()->baro_noise_lpf))); // additional LPF to reduce baro noise
     }
     else {
@@ -372,7 +407,7 @@ void performBaroCalibrationCycle(void)
 
     baroGroundPressure -= baroGroundPressure / 8;
     baroGroundPressure += baroPressureSum / PRESSURE_SAMPLE_COUNT;
-    baroGroundAltitude = (1.0f - pow_approx((baroGroundPressure / 8) / 101325.0f, 0.190295f)) * 4433000.0f;
+    baroGroundAltitude = pressureToAltitude(baroGroundPressure / 8);
 
     if (baroGroundPressure == savedGroundPressure)
       calibratingB = 0;
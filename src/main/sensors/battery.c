@@ -20,6 +20,8 @@
 
 #include "stdbool.h"
 #include "stdint.h"
+#include <math.h>
+#include <string.h>
 
 #include "platform.h"
 
@@ -74,6 +76,30 @@ static batteryState_e batteryState;
 static batteryState_e voltageState;
 static batteryState_e consumptionState;
 
+/*
+ * Internal resistance model
+ *
+ * The voltage drops linearly with the current drawn, V = Vrest - I * R. Exponentially weighted
+ * means, variance and covariance of the current and voltage samples give R as the slope of that
+ * line. Each current sample updates them in constant time. The estimate is only refreshed while
+ * the current varies enough to tell the slope apart from noise, and is held otherwise.
+ */
+#define BATTERY_ESTIMATE_WEIGHT 0.01f               // about 2s at the 50Hz current meter rate
+#define BATTERY_ESTIMATE_MIN_CURRENT_VARIANCE 4.0f  // A^2
+#define BATTERY_ESTIMATE_MAX_RESISTANCE 0.5f        // ohm
+#define BATTERY_REMAINING_TIME_MIN_AMPERAGE 100     // 0.01A steps, below this the remaining time isn't meaningful
+
+typedef struct batteryEstimate_s {
+    bool initialised;
+    float meanCurrent;          // A
+    float meanVoltage;          // V
+    float currentVariance;
+    float covariance;
+    float resistance;           // ohm
+} batteryEstimate_t;
+
+static batteryEstimate_t batteryEstimate;
+
 #ifndef DEFAULT_CURRENT_METER_SOURCE
 #ifdef USE_VIRTUAL_CURRENT_METER
 #define DEFAULT_CURRENT_METER_SOURCE CURRENT_METER_VIRTUAL
@@ -325,6 +351,7 @@ void batteryInit(void)
     //
     consumptionState = BATTERY_OK;
     currentMeterReset(&currentMeter);
+    memset(&batteryEstimate, 0, sizeof(batteryEstimate));
     switch (batteryConfig()->currentMeterSource) {
         case CURRENT_METER_ADC:
             currentMeterADCInit();
@@ -368,6 +395,33 @@ static void batteryUpdateConsumptionState(void)
     }
 }
 
+static void batteryUpdateEstimate(void)
+{
+    if (batteryConfig()->voltageMeterSource == VOLTAGE_METER_NONE || batteryConfig()->currentMeterSource == CURRENT_METER_NONE) {
+        return;
+    }
+
+    const float current = currentMeter.amperageLatest * 0.01f;
+    const float voltage = voltageMeter.unfiltered * 0.1f;
+    if (!batteryEstimate.initialised) {
+        batteryEstimate.meanCurrent = current;
+        batteryEstimate.meanVoltage = voltage;
+        batteryEstimate.initialised = true;
+        return;
+    }
+
+    const float currentDelta = current - batteryEstimate.meanCurrent;
+    const float voltageDelta = voltage - batteryEstimate.meanVoltage;
+    batteryEstimate.meanCurrent += BATTERY_ESTIMATE_WEIGHT * currentDelta;
+    batteryEstimate.meanVoltage += BATTERY_ESTIMATE_WEIGHT * voltageDelta;
+    batteryEstimate.currentVariance = (1.0f - BATTERY_ESTIMATE_WEIGHT) * (batteryEstimate.currentVariance + BATTERY_ESTIMATE_WEIGHT * currentDelta * currentDelta);
+    batteryEstimate.covariance = (1.0f - BATTERY_ESTIMATE_WEIGHT) * (batteryEstimate.covariance + BATTERY_ESTIMATE_WEIGHT * currentDelta * voltageDelta);
+
+    if (batteryEstimate.currentVariance > BATTERY_ESTIMATE_MIN_CURRENT_VARIANCE) {
+        batteryEstimate.resistance = constrainf(-batteryEstimate.covariance / batteryEstimate.currentVariance, 0.0f, BATTERY_ESTIMATE_MAX_RESISTANCE);
+    }
+}
+
 void batteryUpdateCurrentMeter(timeUs_t currentTimeUs)
 {
     UNUSED(currentTimeUs);
@@ -418,6 +472,8 @@ void batteryUpdateCurrentMeter(timeUs_t currentTimeUs)
             currentMeterReset(&currentMeter);
             break;
     }
+
+    batteryUpdateEstimate();
 }
 
 float calculateVbatPidCompensation(void) {
@@ -438,7 +494,8 @@ uint8_t calculateBatteryPercentageRemaining(void)
         if (batteryCapacity > 0) {
             batteryPercentage = constrain(((float)batteryCapacity - currentMeter.mAhDrawn) * 100 / batteryCapacity, 0, 100);
         } else {
-            batteryPercentage = constrain((((uint32_t)voltageMeter.filtered - (batteryConfig()->vbatmincellvoltage * batteryCellCount)) * 100) / ((batteryConfig()->vbatmaxcellvoltage - batteryConfig()->vbatmincellvoltage) * batteryCellCount), 0, 100);
+            // the load doesn't change the charge, so judge it from the voltage without the sag
+            batteryPercentage = constrain((((int32_t)getBatteryRestingVoltage() - (batteryConfig()->vbatmincellvoltage * batteryCellCount)) * 100) / ((batteryConfig()->vbatmaxcellvoltage - batteryConfig()->vbatmincellvoltage) * batteryCellCount), 0, 100);
         }
     }
 
@@ -496,3 +553,30 @@ int32_t getMAhDrawn(void)
 {
     return currentMeter.mAhDrawn;
 }
+
+// internal resistance of the battery and its wiring, in milliohm, 0 until it could be estimated
+uint16_t getBatteryResistance(void)
+{
+    return lrintf(batteryEstimate.resistance * 1000);
+}
+
+// the filtered voltage with the sag of the current draw added back, in 0.1V steps
+uint16_t getBatteryRestingVoltage(void)
+{
+    const float sag = currentMeter.amperage * 0.01f * batteryEstimate.resistance;
+    return voltageMeter.filtered + MAX(lrintf(sag * 10), 0);
+}
+
+/*
+ * Time left until the configured capacity is used up at the current draw, in seconds.
+ * Returns -1 when there is no capacity configured or too little current to say.
+ */
+int32_t getBatteryRemainingTime(void)
+{
+    if (batteryCellCount == 0 || batteryConfig()->batteryCapacity == 0 || currentMeter.amperage < BATTERY_REMAINING_TIME_MIN_AMPERAGE) {
+        return -1;
+    }
+    const int32_t mAhRemaining = MAX(batteryConfig()->batteryCapacity - currentMeter.mAhDrawn, 0);
+    // mAh * 3.6 = As, amperage is in 0.01A steps
+    return mAhRemaining * 360 / currentMeter.amperage;
+}
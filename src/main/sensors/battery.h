@@ -90,6 +90,9 @@ bool isAmperageConfigured(void);
 int32_t getAmperage(void);
 int32_t getAmperageLatest(void);
 int32_t getMAhDrawn(void);
+uint16_t getBatteryResistance(void);
+uint16_t getBatteryRestingVoltage(void);
+int32_t getBatteryRemainingTime(void);
 
 void batteryUpdateCurrentMeter(timeUs_t currentTimeUs);
 
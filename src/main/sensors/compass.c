@@ -18,12 +18,15 @@
  * If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "platform.h"
 
 #include "common/axis.h"
+#include "common/maths.h"
 
 #include "pg/pg.h"
 #include "pg/pg_ids.h"
@@ -47,6 +50,7 @@
 #include "sensors/boardalignment.h"
 #include "sensors/compass.h"
 #include "sensors/gyro.h"
+#include "sensors/initialisation.h"
 #include "sensors/sensors.h"
 
 #ifdef USE_HARDWARE_REVISION_DETECTION
@@ -116,7 +120,7 @@ static int16_t magADCRaw[XYZ_AXIS_COUNT];
 static uint8_t magInit = 0;
 
 #if !defined(SIMULATOR_BUILD)
-bool compassDetect(magDev_t *dev)
+bool compassDetect(magDev_t *dev, magSensor_e magHardwareToUse)
 {
     magSensor_e magHardware = MAG_NONE;
 
@@ -163,7 +167,7 @@ bool compassDetect(magDev_t *dev)
 
     dev->magAlign = ALIGN_DEFAULT;
 
-    switch (compassConfig()->mag_hardware) {
+    switch (magHardwareToUse) {
     case MAG_DEFAULT:
         FALLTHROUGH;
 
@@ -250,9 +254,10 @@ bool compassDetect(magDev_t *dev)
     return true;
 }
 #else
-bool compassDetect(magDev_t *dev)
+bool compassDetect(magDev_t *dev, magSensor_e magHardwareToUse)
 {
     UNUSED(dev);
+    UNUSED(magHardwareToUse);
 
     return false;
 }
@@ -264,9 +269,12 @@ bool compassInit(void)
     // calculate magnetic declination
     mag.magneticDeclination = 0.0f; // TODO investigate if this is actually needed if there is no mag sensor or if the value stored in the config should be used.
 
-    if (!compassDetect(&magDev)) {
+    const magSensor_e cachedMag = sensorDetectionCache()->magHardware;
+    const bool cachedMagFound = compassConfig()->mag_hardware == MAG_DEFAULT && cachedMag != MAG_DEFAULT && compassDetect(&magDev, cachedMag);
+    if (!cachedMagFound && !compassDetect(&magDev, compassConfig()->mag_hardware)) {
         return false;
     }
+    sensorDetectionCacheMutable()->magHardware = detectedSensors[SENSOR_INDEX_MAG];
 
     const int16_t deg = compassConfig()->mag_declination / 100;
     const int16_t min = compassConfig()->mag_declination % 100;
@@ -286,13 +294,116 @@ bool compassIsHealthy(void)
     return (mag.magADC[X] != 0) && (mag.magADC[Y] != 0) && (mag.magADC[Z] != 0);
 }
 
+/*
+ * Hard iron calibration
+ *
+ * Fits a sphere to the samples seen while the craft is turned in all directions. The model
+ * x^2 + y^2 + z^2 = 2ax + 2by + 2cz + k is linear in (a, b, c, k), so each sample only adds
+ * to the least squares sums and the fit is solved once at the end. Samples are taken
+ * relative to the first one to keep the float sums small.
+ */
+#define COMPASS_CAL_PARAMS 4
+
+typedef struct compassCalibration_s {
+    float reference[XYZ_AXIS_COUNT];
+    float normal[COMPASS_CAL_PARAMS][COMPASS_CAL_PARAMS];    // sum of v * v', v = (x, y, z, 1)
+    float rhs[COMPASS_CAL_PARAMS];                          // sum of v * (x^2 + y^2 + z^2)
+    float min[XYZ_AXIS_COUNT];
+    float max[XYZ_AXIS_COUNT];
+} compassCalibration_t;
+
+static compassCalibration_t compassCal;
+
+static void compassCalibrationStart(const float *sample)
+{
+    memset(&compassCal, 0, sizeof(compassCal));
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        compassCal.reference[axis] = sample[axis];
+        compassCal.min[axis] = sample[axis];
+        compassCal.max[axis] = sample[axis];
+    }
+}
+
+static void compassCalibrationAddSample(const float *sample)
+{
+    float v[COMPASS_CAL_PARAMS];
+    float lengthSq = 0;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        v[axis] = sample[axis] - compassCal.reference[axis];
+        lengthSq += sq(v[axis]);
+        compassCal.min[axis] = MIN(compassCal.min[axis], sample[axis]);
+        compassCal.max[axis] = MAX(compassCal.max[axis], sample[axis]);
+    }
+    v[3] = 1.0f;
+
+    for (int i = 0; i < COMPASS_CAL_PARAMS; i++) {
+        for (int j = i; j < COMPASS_CAL_PARAMS; j++) {
+            compassCal.normal[i][j] += v[i] * v[j];
+        }
+        compassCal.rhs[i] += v[i] * lengthSq;
+    }
+}
+
+// solves the normal equations by gaussian elimination, fails if the samples don't span a sphere
+static bool compassCalibrationSolve(int16_t *offset)
+{
+    float a[COMPASS_CAL_PARAMS][COMPASS_CAL_PARAMS + 1];
+    for (int i = 0; i < COMPASS_CAL_PARAMS; i++) {
+        for (int j = 0; j < COMPASS_CAL_PARAMS; j++) {
+            a[i][j] = j >= i ? compassCal.normal[i][j] : compassCal.normal[j][i];
+        }
+        a[i][COMPASS_CAL_PARAMS] = compassCal.rhs[i];
+    }
+
+    for (int col = 0; col < COMPASS_CAL_PARAMS; col++) {
+        // a pivot much smaller than its column's own sum means the samples are nearly coplanar
+        const float minPivot = 1e-4f * compassCal.normal[col][col];
+        int pivot = col;
+        for (int row = col + 1; row < COMPASS_CAL_PARAMS; row++) {
+            if (fabsf(a[row][col]) > fabsf(a[pivot][col])) {
+                pivot = row;
+            }
+        }
+        if (fabsf(a[pivot][col]) <= minPivot) {
+            return false;
+        }
+        for (int j = col; j <= COMPASS_CAL_PARAMS; j++) {
+            const float tmp = a[col][j];
+            a[col][j] = a[pivot][j];
+            a[pivot][j] = tmp;
+        }
+        for (int row = 0; row < COMPASS_CAL_PARAMS; row++) {
+            if (row != col) {
+                const float factor = a[row][col] / a[col][col];
+                for (int j = col; j <= COMPASS_CAL_PARAMS; j++) {
+                    a[row][j] -= factor * a[col][j];
+                }
+            }
+        }
+    }
+
+    float centre[XYZ_AXIS_COUNT];
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        centre[axis] = compassCal.reference[axis] + a[axis][COMPASS_CAL_PARAMS] / a[axis][axis] / 2.0f;
+        // a centre outside the measured range means the fit went wrong
+        if (centre[axis] < compassCal.min[axis] || centre[axis] > compassCal.max[axis]) {
+            return false;
+        }
+    }
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        offset[axis] = lrintf(centre[axis]);
+    }
+    return true;
+}
+
 void compassUpdate(timeUs_t currentTimeUs)
 {
     static timeUs_t tCal = 0;
-    static flightDynamicsTrims_t magZeroTempMin;
-    static flightDynamicsTrims_t magZeroTempMax;
 
-    magDev.read(&magDev, magADCRaw);
+    // the driver reads asynchronously, nothing to do until a new sample has arrived
+    if (!magDev.read(&magDev, magADCRaw)) {
+        return;
+    }
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
         mag.magADC[axis] = magADCRaw[axis];
     }
@@ -303,9 +414,8 @@ void compassUpdate(timeUs_t currentTimeUs)
         tCal = currentTimeUs;
         for (int axis = 0; axis < 3; axis++) {
             magZero->raw[axis] = 0;
-            magZeroTempMin.raw[axis] = mag.magADC[axis];
-            magZeroTempMax.raw[axis] = mag.magADC[axis];
         }
+        compassCalibrationStart(mag.magADC);
         DISABLE_STATE(CALIBRATE_MAG);
     }
 
@@ -318,16 +428,13 @@ void compassUpdate(timeUs_t currentTimeUs)
     if (tCal != 0) {
         if ((currentTimeUs - tCal) < 30000000) {    // 30s: you have 30s to turn the multi in all directions
             LED0_TOGGLE;
-            for (int axis = 0; axis < 3; axis++) {
-                if (mag.magADC[axis] < magZeroTempMin.raw[axis])
-                    magZeroTempMin.raw[axis] = mag.magADC[axis];
-                if (mag.magADC[axis] > magZeroTempMax.raw[axis])
-                    magZeroTempMax.raw[axis] = mag.magADC[axis];
-            }
+            compassCalibrationAddSample(mag.magADC);
         } else {
             tCal = 0;
-            for (int axis = 0; axis < 3; axis++) {
-                magZero->raw[axis] = (magZeroTempMin.raw[axis] + magZeroTempMax.raw[axis]) / 2; // Calculate offsets
+            if (!compassCalibrationSolve(magZero->raw)) {
+                for (int axis = 0; axis < 3; axis++) {
+                    magZero->raw[axis] = lrintf((compassCal.min[axis] + compassCal.max[axis]) / 2); // Calculate offsets
+                }
             }
 
             saveConfigAndNotify();
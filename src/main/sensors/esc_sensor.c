@@ -26,6 +26,7 @@
 
 #if defined(USE_ESC_SENSOR)
 
+#include "build/atomic.h"
 #include "build/debug.h"
 
 #include "config/feature.h"
@@ -35,9 +36,11 @@
 #include "common/maths.h"
 #include "common/utils.h"
 
+#include "drivers/nvic.h"
 #include "drivers/pwm_output.h"
 #include "drivers/serial.h"
 #include "drivers/serial_uart.h"
+#include "drivers/time.h"
 
 #include "esc_sensor.h"
 
@@ -115,8 +118,13 @@ static serialPort_t *escSensorPort = NULL;
 static escSensorData_t escSensorData[MAX_SUPPORTED_MOTORS];
 
 static escSensorTriggerState_t escSensorTriggerState = ESC_SENSOR_TRIGGER_STARTUP;
-static uint32_t escTriggerTimestamp;
-static uint8_t escSensorMotor = 0;      // motor index
+static volatile timeUs_t escTriggerTimestamp;
+static volatile uint8_t escSensorMotor = 0;      // motor index
+static volatile bool escTelemetryChained = false; // the receive ISR requests the next motor itself
+
+static timeUs_t escPollTimestamp[MAX_SUPPORTED_MOTORS];     // last reply or timeout per motor
+static timeUs_t escFrameTimestamp[MAX_SUPPORTED_MOTORS];    // last valid frame per motor
+static bool escFrameReceived[MAX_SUPPORTED_MOTORS];
 
 static escSensorData_t combinedEscSensorData;
 static bool combinedDataNeedsUpdate = true;
@@ -126,6 +134,7 @@ static uint16_t totalCrcErrorCount = 0;
 
 void startEscDataRead(uint8_t *frameBuffer, uint8_t frameLength)
 {
+    escTelemetryChained = false;
     buffer = frameBuffer;
     bufferPosition = 0;
     bufferSize = frameLength;
@@ -186,6 +195,20 @@ escSensorData_t *getEscSensorData(uint8_t motorNumber)
     }
 }
 
+timeMs_t getEscSensorFrameAgeMs(uint8_t motorNumber)
+{
+    if (motorNumber >= getMotorCount() || !escFrameReceived[motorNumber]) {
+        return UINT32_MAX;
+    }
+
+    return cmpTimeUs(micros(), escFrameTimestamp[motorNumber]) / 1000;
+}
+
+static uint8_t decodeEscFrame(timeUs_t currentTimeUs);
+static void increaseDataAge(void);
+static void selectNextMotor(timeUs_t currentTimeUs);
+static void requestTelemetry(timeUs_t currentTimeUs);
+
 // Receive ISR callback
 static void escSensorDataReceive(uint16_t c, void *data)
 {
@@ -199,6 +222,23 @@ static void escSensorDataReceive(uint16_t c, void *data)
     }
 
     buffer[bufferPosition++] = (uint8_t)c;
+
+    // Hand the line to the next ESC as soon as this frame is in. All ESCs share
+    // the wire, so the next request cannot go out before the last byte arrived,
+    // but this way each reply follows the previous one within a motor update
+    // instead of waiting two runs of the ESC sensor task.
+    if (escTelemetryChained && isFrameComplete()) {
+        const timeUs_t currentTimeUs = micros();
+
+        if (decodeEscFrame(currentTimeUs) == ESC_SENSOR_FRAME_FAILED) {
+            increaseDataAge();
+
+            DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_NUM_CRC_ERRORS, ++totalCrcErrorCount);
+        }
+
+        selectNextMotor(currentTimeUs);
+        requestTelemetry(currentTimeUs);
+    }
 }
 
 bool escSensorInit(void)
@@ -242,7 +282,7 @@ uint8_t calculateCrc8(const uint8_t *Buf, const uint8_t BufLen)
     return crc;
 }
 
-static uint8_t decodeEscFrame(void)
+static uint8_t decodeEscFrame(timeUs_t currentTimeUs)
 {
     if (!isFrameComplete()) {
         return ESC_SENSOR_FRAME_PENDING;
@@ -260,6 +300,9 @@ static uint8_t decodeEscFrame(void)
         escSensorData[escSensorMotor].consumption = telemetryBuffer[5] << 8 | telemetryBuffer[6];
         escSensorData[escSensorMotor].rpm = telemetryBuffer[7] << 8 | telemetryBuffer[8];
 
+        escFrameTimestamp[escSensorMotor] = currentTimeUs;
+        escFrameReceived[escSensorMotor] = true;
+
         combinedDataNeedsUpdate = true;
 
         frameStatus = ESC_SENSOR_FRAME_COMPLETE;
@@ -282,12 +325,39 @@ static void increaseDataAge(void)
     }
 }
 
-static void selectNextMotor(void)
+// Poll the motor that has been waiting longest since its last reply or timeout,
+// ties are broken in motor order starting after the current one
+static void selectNextMotor(timeUs_t currentTimeUs)
 {
-    escSensorMotor++;
-    if (escSensorMotor == getMotorCount()) {
-        escSensorMotor = 0;
+    const uint8_t motorCount = getMotorCount();
+    uint8_t nextMotor = escSensorMotor;
+    timeDelta_t longestWaitUs = INT32_MIN;
+
+    escPollTimestamp[escSensorMotor] = currentTimeUs;
+
+    for (int i = 1; i < motorCount; i++) {
+        const uint8_t motor = (escSensorMotor + i) % motorCount;
+        const timeDelta_t waitUs = cmpTimeUs(currentTimeUs, escPollTimestamp[motor]);
+        if (waitUs > longestWaitUs) {
+            longestWaitUs = waitUs;
+            nextMotor = motor;
+        }
     }
+
+    escSensorMotor = nextMotor;
+}
+
+static void requestTelemetry(timeUs_t currentTimeUs)
+{
+    escTriggerTimestamp = currentTimeUs;
+
+    startEscDataRead(telemetryBuffer, TELEMETRY_FRAME_SIZE);
+    escTelemetryChained = true;
+
+    motorDmaOutput_t * const motor = getMotorDmaOutput(escSensorMotor);
+    motor->requestTelemetry = true;
+
+    DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_MOTOR_INDEX, escSensorMotor + 1);
 }
 
 void escSensorProcess(timeUs_t currentTimeUs)
@@ -307,44 +377,23 @@ void escSensorProcess(timeUs_t currentTimeUs)
 
             break;
         case ESC_SENSOR_TRIGGER_READY:
-            escTriggerTimestamp = currentTimeMs;
-
-            startEscDataRead(telemetryBuffer, TELEMETRY_FRAME_SIZE);
-            motorDmaOutput_t * const motor = getMotorDmaOutput(escSensorMotor);
-            motor->requestTelemetry = true;
+            requestTelemetry(currentTimeUs);
             escSensorTriggerState = ESC_SENSOR_TRIGGER_PENDING;
 
-            DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_MOTOR_INDEX, escSensorMotor + 1);
-
             break;
         case ESC_SENSOR_TRIGGER_PENDING:
-            if (currentTimeMs < escTriggerTimestamp + ESC_REQUEST_TIMEOUT) {
-                uint8_t state = decodeEscFrame();
-                switch (state) {
-                    case ESC_SENSOR_FRAME_COMPLETE:
-                        selectNextMotor();
-                        escSensorTriggerState = ESC_SENSOR_TRIGGER_READY;
-
-                        break;
-                    case ESC_SENSOR_FRAME_FAILED:
-                        increaseDataAge();
-
-                        selectNextMotor();
-                        escSensorTriggerState = ESC_SENSOR_TRIGGER_READY;
-
-                        DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_NUM_CRC_ERRORS, ++totalCrcErrorCount);
-                        break;
-                    case ESC_SENSOR_FRAME_PENDING:
-                        break;
-                }
-            } else {
-                // Move on to next ESC, we'll come back to this one
-                increaseDataAge();
+            // Completed frames chain on to the next motor from the receive ISR,
+            // only a missing reply (or a read taken over by the CLI) needs a restart
+            ATOMIC_BLOCK(NVIC_PRIO_SERIALUART1) {
+                if (!escTelemetryChained || cmpTimeUs(currentTimeUs, escTriggerTimestamp) >= ESC_REQUEST_TIMEOUT * 1000) {
+                    // Move on to next ESC, we'll come back to this one
+                    increaseDataAge();
 
-                selectNextMotor();
-                escSensorTriggerState = ESC_SENSOR_TRIGGER_READY;
+                    selectNextMotor(currentTimeUs);
+                    requestTelemetry(currentTimeUs);
 
-                DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_NUM_TIMEOUTS, ++totalTimeoutCount);
+                    DEBUG_SET(DEBUG_ESC_SENSOR, DEBUG_ESC_NUM_TIMEOUTS, ++totalTimeoutCount);
+                }
             }
 
             break;
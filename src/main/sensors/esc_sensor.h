@@ -49,6 +49,7 @@ void escSensorProcess(timeUs_t currentTime);
 #define ESC_SENSOR_COMBINED 255
 
 escSensorData_t *getEscSensorData(uint8_t motorNumber);
+timeMs_t getEscSensorFrameAgeMs(uint8_t motorNumber);
 
 void startEscDataRead(uint8_t *frameBuffer, uint8_t frameLength);
 uint8_t getNumberEscBytesRead(void);
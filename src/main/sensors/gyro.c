@@ -27,6 +27,8 @@
 #include "platform.h"
 
 #include "build/debug.h"
+#include "build/motor_timing.h"
+#include "build/profiler.h"
 
 #include "common/axis.h"
 #include "common/maths.h"
@@ -61,10 +63,13 @@
 #include "drivers/accgyro/gyro_sync.h"
 #include "drivers/bus_spi.h"
 #include "drivers/io.h"
+#include "drivers/swi.h"
 
 #include "fc/config.h"
 #include "fc/runtime_config.h"
 
+#include "flight/rpm_filter.h"
+
 #include "io/beeper.h"
 #include "io/statusindicator.h"
 
@@ -73,6 +78,7 @@
 #include "sensors/boardalignment.h"
 #include "sensors/gyro.h"
 #include "sensors/gyroanalyse.h"
+#include "sensors/initialisation.h"
 #include "sensors/sensors.h"
 
 #ifdef USE_HARDWARE_REVISION_DETECTION
@@ -84,10 +90,21 @@
 #endif
 
 FAST_RAM_ZERO_INIT gyro_t gyro;
-static FAST_RAM_ZERO_INIT uint8_t gyroDebugMode;
 
 static uint8_t gyroToUse = 0;
 
+// the gyroConfig() values read per sample, taken by gyroInit() as they only apply after a reboot
+typedef struct gyroRuntimeConfig_s {
+    float yawSpinThreshold;
+    float dualOutlierDps;
+    uint16_t overflowCheckUs;
+    bool checkOverflow;
+    bool yawSpinRecovery;
+    bool dualFusion;
+} gyroRuntimeConfig_t;
+
+static FAST_RAM_ZERO_INIT gyroRuntimeConfig_t gyroRuntimeConfig;
+
 #ifdef USE_GYRO_OVERFLOW_CHECK
 static FAST_RAM_ZERO_INIT uint8_t overflowAxisMask;
 #endif
@@ -95,6 +112,10 @@ static FAST_RAM_ZERO_INIT float accumulatedMeasurements[XYZ_AXIS_COUNT];
 static FAST_RAM_ZERO_INIT float gyroPrevious[XYZ_AXIS_COUNT];
 static FAST_RAM_ZERO_INIT timeUs_t accumulatedMeasurementTimeUs;
 static FAST_RAM_ZERO_INIT timeUs_t accumulationLastTimeSampledUs;
+#ifdef USE_GYRO_DECIMATION
+static FAST_RAM_ZERO_INIT uint8_t gyroDecimation;
+static FAST_RAM_ZERO_INIT bool gyroDecimatedSampleReady;
+#endif
 
 static bool gyroHasOverflowProtection = true;
 
@@ -102,6 +123,12 @@ typedef struct gyroCalibration_s {
     float sum[XYZ_AXIS_COUNT];
     stdev_t var[XYZ_AXIS_COUNT];
     int32_t cyclesRemaining;
+    // fast calibration, sum and var above cover the current window
+    float acceptedSum[XYZ_AXIS_COUNT];
+    float acceptedSquares[XYZ_AXIS_COUNT];  // sum of squared deviations from each window mean
+    int32_t acceptedCount;
+    int32_t windowCount;
+    uint16_t acceptedWindows;
 } gyroCalibration_t;
 
 bool firstArmingCalibrationWasStarted = false;
@@ -109,6 +136,9 @@ bool firstArmingCalibrationWasStarted = false;
 typedef union gyroLowpassFilter_u {
     pt1Filter_t pt1FilterState;
     biquadFilter_t biquadFilterState;
+#ifdef USE_GYRO_KALMAN_FILTER
+    kalmanFilter_t kalmanFilterState;
+#endif
 } gyroLowpassFilter_t;
 
 typedef struct gyroSensor_s {
@@ -130,10 +160,47 @@ typedef struct gyroSensor_s {
     filterApplyFnPtr notchFilter2ApplyFn;
     biquadFilter_t notchFilter2[XYZ_AXIS_COUNT];
 
-    filterApplyFnPtr notchFilterDynApplyFn;
-    biquadFilter_t notchFilterDyn[XYZ_AXIS_COUNT];
+    biquadFilter_t notchFilterDyn[DYN_NOTCH_COUNT_MAX][XYZ_AXIS_COUNT];
+    uint8_t notchFilterDynCount;
+
+    // all of the above filters applied by a single call, NULL if the chain cannot hold them
+    filterChainApplyFnPtr filterChainApplyFn;
+    filterChain_t filterChain[XYZ_AXIS_COUNT];
+
+#ifdef USE_RPM_FILTER
+    rpmFilterBank_t rpmFilterBank;
+#endif
+
+#ifdef USE_GYRO_DECIMATION
+    cicDecimator_t decimator[XYZ_AXIS_COUNT];
+#endif
+
+#ifdef USE_GYRO_FILTER_BANK
+    // static notch and lowpass filters of all axes, replaces the per axis filters above when active
+    bool filterBankActive;
+    biquadFilterBank_t filterBank;
+#endif
+
+#ifdef USE_FIXED_POINT_FILTERS
+    // integer copy of the static filters, replaces the float filters when active
+    bool fixedFilterBankActive;
+    biquadFilterFixedBank_t fixedFilterBank;
+#endif
+
+#ifdef USE_DUAL_GYRO
+    uint32_t filteredSampleTimeUs;  // sample time of gyroDev.gyroADCf
+#endif
+
+    gyroSampleRing_t sampleRing;
+#ifdef USE_GYRO_DATA_ANALYSE
+    gyroSampleReader_t analyseReader;
+#endif
 
     // overflow and recovery
+#if defined(USE_GYRO_OVERFLOW_CHECK) || defined(USE_YAW_SPIN_RECOVERY)
+    float peakRate[XYZ_AXIS_COUNT];  // peak absolute rate since the last check
+    timeUs_t peakCheckTimeUs;
+#endif
     timeUs_t overflowTimeUs;
     bool overflowDetected;
 #ifdef USE_YAW_SPIN_RECOVERY
@@ -142,18 +209,92 @@ typedef struct gyroSensor_s {
 #endif // USE_YAW_SPIN_RECOVERY
 } gyroSensor_t;
 
+// The lowpass and static notch filters, each worked out once for all axes
+typedef struct gyroStaticFilters_s {
+    filterApplyFnPtr lowpassApplyFn;
+    gyroLowpassFilter_t lowpass;
+    filterApplyFnPtr lowpass2ApplyFn;
+    gyroLowpassFilter_t lowpass2;
+    filterApplyFnPtr notch1ApplyFn;
+    biquadFilter_t notch1;
+    filterApplyFnPtr notch2ApplyFn;
+    biquadFilter_t notch2;
+} gyroStaticFilters_t;
+
+// staged by gyroReconfigureFilters() in task context, installed by the gyro loop
+static gyroStaticFilters_t gyroPendingFilters;
+static bool gyroFiltersPending;
+
+static void gyroFilterSampleNoDebug(gyroSensor_t *gyroSensor, timeDelta_t sampleDeltaUs);
+static void gyroFilterSampleDebug(gyroSensor_t *gyroSensor, timeDelta_t sampleDeltaUs);
+
+// gyroFilterSampleNoDebug() unless the debug mode records gyro data
+typedef void (*gyroFilterSampleFnPtr)(gyroSensor_t *gyroSensor, timeDelta_t sampleDeltaUs);
+static FAST_RAM_ZERO_INIT gyroFilterSampleFnPtr gyroFilterSampleFn;
+
 STATIC_UNIT_TESTED FAST_RAM_ZERO_INIT gyroSensor_t gyroSensor1;
 #ifdef USE_DUAL_GYRO
 STATIC_UNIT_TESTED FAST_RAM_ZERO_INIT gyroSensor_t gyroSensor2;
+
+typedef struct gyroFusion_s {
+    float gyro2[XYZ_AXIS_COUNT];
+    float gyro2Previous[XYZ_AXIS_COUNT];
+    uint32_t gyro2TimeUs;
+    uint32_t gyro2PreviousTimeUs;
+} gyroFusion_t;
+
+static FAST_RAM_ZERO_INIT gyroFusion_t gyroFusion;
+
+#define GYRO_SENSOR_COUNT 2
+
+static gyroSensor_t * const gyroSensors[GYRO_SENSOR_COUNT] = { &gyroSensor1, &gyroSensor2 };
+
+// A gyro that keeps overflowing, keeps reading the very same value or keeps disagreeing with the
+// vote is left out of the vote, until it has been good again for long enough. The score drops by
+// one for every good sample. Disagreeing only counts with at least three gyros in the vote: of two
+// gyros that disagree there is no telling which one is wrong, and the vote may well follow the bad one.
+#define GYRO_HEALTH_EXCLUDE   1000
+#define GYRO_HEALTH_READMIT   200
+#define GYRO_HEALTH_DISAGREE  4     // added for a sample further than gyro_dual_outlier_dps from the vote
+#define GYRO_HEALTH_STUCK     4     // added for a raw sample equal to the previous one on every axis
+#define GYRO_HEALTH_OVERFLOW  16    // added for a sample while the gyro is in overflow
+#define GYRO_HEALTH_MAJORITY  3     // gyros in the vote needed to hold a disagreement against one
+
+typedef struct gyroHealth_s {
+    uint16_t score;
+    bool excluded;
+    uint32_t sampleTimeUs;          // of the last sample checked for being stuck
+    int16_t previousRaw[XYZ_AXIS_COUNT];
+} gyroHealth_t;
+
+static FAST_RAM_ZERO_INIT gyroHealth_t gyroHealth[GYRO_SENSOR_COUNT];
+#endif
+
+#ifdef USE_GYRO_TEMP_COMP
+typedef struct gyroTempComp_s {
+    bool learning;                          // the gyro loop accumulates samples for the learning window
+    float sum[XYZ_AXIS_COUNT];
+    float sumSquares[XYZ_AXIS_COUNT];
+    uint32_t count;
+    timeUs_t windowStartUs;
+    bool calibrationTemperaturePending;     // calibration completed, the temperature is taken at the next update
+    bool calibrationTemperatureValid;
+    int16_t calibrationTemperature;
+    float offset[XYZ_AXIS_COUNT];           // change of the zero offset since calibration, in sensor counts
+} gyroTempComp_t;
+
+static FAST_RAM_ZERO_INIT gyroTempComp_t gyroTempComp;
 #endif
 
 #ifdef UNIT_TEST
 STATIC_UNIT_TESTED gyroSensor_t * const gyroSensorPtr = &gyroSensor1;
 STATIC_UNIT_TESTED gyroDev_t * const gyroDevPtr = &gyroSensor1.gyroDev;
+#ifdef USE_DUAL_GYRO
+STATIC_UNIT_TESTED gyroDev_t * const gyroDev2Ptr = &gyroSensor2.gyroDev;
+#endif
 #endif
 
 static void gyroInitSensorFilters(gyroSensor_t *gyroSensor);
-static void gyroInitLowpassFilterLpf(gyroSensor_t *gyroSensor, int slot, int type, uint16_t lpfHz);
 
 #define DEBUG_GYRO_CALIBRATION 3
 
@@ -166,10 +307,20 @@ static void gyroInitLowpassFilterLpf(gyroSensor_t *gyroSensor, int slot, int typ
 #define GYRO_SYNC_DENOM_DEFAULT 4
 #endif
 
+// fast calibration ends once the standard error of the zero offset is below GYRO_CALIBRATION_MAX_ERROR sensor counts
+#define GYRO_CALIBRATION_WINDOW_US      100000  // samples are checked for movement and accepted one window at a time
+#define GYRO_CALIBRATION_MIN_WINDOWS    2
+#define GYRO_CALIBRATION_MAX_ERROR      0.1f
+
 #define GYRO_OVERFLOW_TRIGGER_THRESHOLD 31980  // 97.5% full scale (1950dps for 2000dps gyro)
 #define GYRO_OVERFLOW_RESET_THRESHOLD 30340    // 92.5% full scale (1850dps for 2000dps gyro)
 
-PG_REGISTER_WITH_RESET_TEMPLATE(gyroConfig_t, gyroConfig, PG_GYRO_CONFIG, 4);
+#ifdef USE_GYRO_KALMAN_FILTER
+// noise variance in (deg/s)^2 at which the Kalman lowpass matches a PT1 at the configured cutoff
+#define GYRO_KALMAN_NOISE_VARIANCE 25.0f
+#endif
+
+PG_REGISTER_WITH_RESET_TEMPLATE(gyroConfig_t, gyroConfig, PG_GYRO_CONFIG, 12);
 
 #ifndef GYRO_CONFIG_USE_GYRO_DEFAULT
 #define GYRO_CONFIG_USE_GYRO_DEFAULT GYRO_CONFIG_USE_GYRO_1
@@ -197,7 +348,25 @@ PG_RESET_TEMPLATE(gyroConfig_t, gyroConfig,
     .gyro_offset_yaw = 0,
     .yaw_spin_recovery = true,
     .yaw_spin_threshold = 1950,
+    .gyro_filter_bank = false,
+    .gyro_use_fifo = false,
+    .gyro_32khz_decimation = false,
+    .dyn_notch_count = 1,
+    .dyn_notch_estimator = DYN_NOTCH_ESTIMATOR_FFT,
+    .gyro_dual_fusion = false,
+    .gyro_dual_outlier_dps = 100,
+    .gyro_fast_calibration = false,
+    .gyro_overflow_check_us = 1000,
+);
+
+#ifdef USE_GYRO_TEMP_COMP
+PG_REGISTER_WITH_RESET_TEMPLATE(gyroTempCompConfig_t, gyroTempCompConfig, PG_GYRO_TEMP_COMP_CONFIG, 0);
+
+PG_RESET_TEMPLATE(gyroTempCompConfig_t, gyroTempCompConfig,
+    .enabled = false,
+    .learnedMask = 0,
 );
+#endif
 
 
 const busDevice_t *gyroSensorBus(void)
@@ -255,6 +424,54 @@ const mpuDetectionResult_t *gyroMpuDetectionResult(void)
 #endif
 }
 
+#if defined(USE_PREEMPTIVE_PID_LOOP) || defined(USE_SCHEDULER_IDLE_SLEEP) || defined(USE_MOTOR_OUTPUT_SYNC) || defined(USE_MOTOR_TIMING)
+// With both gyros in use the first one sets the pace
+static gyroDev_t *gyroDevInUse(void)
+{
+#ifdef USE_DUAL_GYRO
+    return gyroToUse == GYRO_CONFIG_USE_GYRO_2 ? &gyroSensor2.gyroDev : &gyroSensor1.gyroDev;
+#else
+    return &gyroSensor1.gyroDev;
+#endif
+}
+#endif
+
+#if defined(USE_MOTOR_OUTPUT_SYNC) || defined(USE_MOTOR_TIMING)
+// Time the last sample of the gyro in use was taken, or read if the driver can not tell
+FAST_CODE timeUs_t gyroGetSampleTimeUs(void)
+{
+    return gyroDevInUse()->sampleTimeUs;
+}
+#endif
+
+#if defined(USE_PREEMPTIVE_PID_LOOP) || defined(USE_SCHEDULER_IDLE_SLEEP)
+// Returns true if the gyro in use signals new data with its data ready interrupt
+bool gyroHasDataReadyInterrupt(void)
+{
+    const gyroDev_t *gyroDev = gyroDevInUse();
+#ifdef USE_GYRO_FIFO
+    if (gyroDev->fifoReadFn) {
+        // samples are queued in the FIFO without raising the interrupt
+        return false;
+    }
+#endif
+    // the driver only claims the pin once it has set up the data ready interrupt
+    return gyroDev->mpuIntExtiTag != IO_TAG_NONE && IOGetOwner(IOGetByTag(gyroDev->mpuIntExtiTag)) == OWNER_MPU_EXTI;
+}
+#endif
+
+#ifdef USE_PREEMPTIVE_PID_LOOP
+// Calls back from the data ready interrupt of the gyro in use, returns false if it has no interrupt line.
+bool gyroSetDataReadyCallback(void (*callback)(void))
+{
+    if (!gyroHasDataReadyInterrupt()) {
+        return false;
+    }
+    gyroSyncSetDataReadyCallback(gyroDevInUse(), callback);
+    return true;
+}
+#endif
+
 STATIC_UNIT_TESTED gyroSensor_e gyroDetect(gyroDev_t *dev)
 {
     gyroSensor_e gyroHardware = GYRO_DEFAULT;
@@ -434,8 +651,14 @@ static bool gyroInitSensor(gyroSensor_t *gyroSensor)
 #if defined(USE_GYRO_MPU6050) || defined(USE_GYRO_MPU3050) || defined(USE_GYRO_MPU6500) || defined(USE_GYRO_SPI_MPU6500) || defined(USE_GYRO_SPI_MPU6000) \
  || defined(USE_ACC_MPU6050) || defined(USE_GYRO_SPI_MPU9250) || defined(USE_GYRO_SPI_ICM20601) || defined(USE_GYRO_SPI_ICM20649) || defined(USE_GYRO_SPI_ICM20689)
 
-    mpuDetect(&gyroSensor->gyroDev);
+#ifdef USE_DUAL_GYRO
+    const int cacheIndex = gyroSensor == &gyroSensor2 ? 1 : 0;
+#else
+    const int cacheIndex = 0;
+#endif
+    mpuDetect(&gyroSensor->gyroDev, sensorDetectionCache()->mpuSensor[cacheIndex]);
     mpuResetFn = gyroSensor->gyroDev.mpuConfiguration.resetFn; // must be set after mpuDetect
+    sensorDetectionCacheMutable()->mpuSensor[cacheIndex] = gyroSensor->gyroDev.mpuDetectionResult.sensor;
 #endif
 
     const gyroSensor_e gyroHardware = gyroDetect(&gyroSensor->gyroDev);
@@ -459,6 +682,12 @@ static bool gyroInitSensor(gyroSensor_t *gyroSensor)
         break;
     }
 
+#ifdef USE_GYRO_FIFO
+    if (!gyroConfig()->gyro_use_fifo) {
+        gyroSensor->gyroDev.fifoReadFn = NULL;
+    }
+#endif
+
     // Must set gyro targetLooptime before gyroDev.init and initialisation of filters
     gyro.targetLooptime = gyroSetSampleRate(&gyroSensor->gyroDev, gyroConfig()->gyro_hardware_lpf, gyroConfig()->gyro_sync_denom, gyroConfig()->gyro_use_32khz);
     gyroSensor->gyroDev.hardware_lpf = gyroConfig()->gyro_hardware_lpf;
@@ -501,13 +730,25 @@ static bool gyroInitSensor(gyroSensor_t *gyroSensor)
     gyroInitSensorFilters(gyroSensor);
 
 #ifdef USE_GYRO_DATA_ANALYSE
-    gyroDataAnalyseInit(gyro.targetLooptime);
+    gyroDataAnalyseInit(gyroFilterLooptime());
 #endif
     return true;
 }
 
+static void gyroInitRuntimeConfig(void)
+{
+    gyroRuntimeConfig.yawSpinThreshold = gyroConfig()->yaw_spin_threshold;
+    gyroRuntimeConfig.dualOutlierDps = gyroConfig()->gyro_dual_outlier_dps;
+    gyroRuntimeConfig.overflowCheckUs = gyroConfig()->gyro_overflow_check_us;
+    gyroRuntimeConfig.checkOverflow = gyroConfig()->checkOverflow != GYRO_OVERFLOW_CHECK_NONE;
+    gyroRuntimeConfig.yawSpinRecovery = gyroConfig()->yaw_spin_recovery;
+    gyroRuntimeConfig.dualFusion = gyroConfig()->gyro_dual_fusion;
+}
+
 bool gyroInit(void)
 {
+    gyroInitRuntimeConfig();
+
 #ifdef USE_GYRO_OVERFLOW_CHECK
     if (gyroConfig()->checkOverflow == GYRO_OVERFLOW_CHECK_YAW) {
         overflowAxisMask = GYRO_OVERFLOW_Z;
@@ -523,17 +764,20 @@ bool gyroInit(void)
     case DEBUG_GYRO_RAW:
     case DEBUG_GYRO_SCALED:
     case DEBUG_GYRO_FILTERED:
-        gyroDebugMode = debugMode;
+        gyroFilterSampleFn = gyroFilterSampleDebug;
         break;
     default:
         // debugMode is not gyro-related
-        gyroDebugMode = DEBUG_NONE;
+        gyroFilterSampleFn = gyroFilterSampleNoDebug;
         break;
     }
     firstArmingCalibrationWasStarted = false;
 
     bool ret = false;
     memset(&gyro, 0, sizeof(gyro));
+#ifdef USE_DUAL_GYRO
+    memset(gyroHealth, 0, sizeof(gyroHealth));
+#endif
     gyroToUse = gyroConfig()->gyro_to_use;
 
 #if defined(USE_DUAL_GYRO) && defined(GYRO_1_CS_PIN)
@@ -624,59 +868,85 @@ bool gyroInit(void)
     return ret;
 }
 
-void gyroInitLowpassFilterLpf(gyroSensor_t *gyroSensor, int slot, int type, uint16_t lpfHz)
+// With keepState only the coefficients are taken over, so the filter output carries on from its current state
+static void gyroInstallBiquad(biquadFilter_t *filter, const biquadFilter_t *from, bool keepState)
 {
-    filterApplyFnPtr *lowpassFilterApplyFn;
-    gyroLowpassFilter_t *lowpassFilter = NULL;
-
-    switch (slot) {
-    case FILTER_LOWPASS:
-        lowpassFilterApplyFn = &gyroSensor->lowpassFilterApplyFn;
-        lowpassFilter = gyroSensor->lowpassFilter;
-        break;
-
-    case FILTER_LOWPASS2:
-        lowpassFilterApplyFn = &gyroSensor->lowpass2FilterApplyFn;
-        lowpassFilter = gyroSensor->lowpass2Filter;
-        break;
+    if (keepState) {
+        filter->b0 = from->b0;
+        filter->b1 = from->b1;
+        filter->b2 = from->b2;
+        filter->a1 = from->a1;
+        filter->a2 = from->a2;
+    } else {
+        *filter = *from;
+    }
+}
 
-    default:
-        return;
+static void gyroInstallLowpass(gyroLowpassFilter_t *filter, filterApplyFnPtr applyFn, const gyroLowpassFilter_t *from, bool keepState)
+{
+    if (!keepState) {
+        *filter = *from;
+    } else if (applyFn == (filterApplyFnPtr)pt1FilterApply) {
+        filter->pt1FilterState.k = from->pt1FilterState.k;
+    } else if (applyFn == (filterApplyFnPtr)biquadFilterApply) {
+        gyroInstallBiquad(&filter->biquadFilterState, &from->biquadFilterState, true);
+#ifdef USE_GYRO_KALMAN_FILTER
+    } else if (applyFn == (filterApplyFnPtr)kalmanFilterApply) {
+        filter->kalmanFilterState.q = from->kalmanFilterState.q;
+#endif
     }
+}
 
+// Works out the lowpass filter for the settings, the apply function stays null unless the cutoff
+// and filter type are valid. The filter is worked out once and installed on every axis.
+static void gyroBuildLowpass(int type, uint16_t lpfHz, filterApplyFnPtr *applyFnOut, gyroLowpassFilter_t *filter)
+{
     // Establish some common constants
-    const uint32_t gyroFrequencyNyquist = 1000000 / 2 / gyro.targetLooptime;
-    const float gyroDt = gyro.targetLooptime * 1e-6f;
+    const uint32_t gyroFrequencyNyquist = 1000000 / 2 / gyroFilterLooptime();
+    const float gyroDt = gyroFilterLooptime() * 1e-6f;
 
     // Gain could be calculated a little later as it is specific to the pt1/bqrcf2/fkf branches
     const float gain = pt1FilterGain(lpfHz, gyroDt);
 
-    // Dereference the pointer to null before checking valid cutoff and filter
-    // type. It will be overridden for positive cases.
-    *lowpassFilterApplyFn = &nullFilterApply;
+    filterApplyFnPtr applyFn = nullFilterApply;
+    memset(filter, 0, sizeof(*filter));
 
     // If lowpass cutoff has been specified and is less than the Nyquist frequency
     if (lpfHz && lpfHz <= gyroFrequencyNyquist) {
         switch (type) {
         case FILTER_PT1:
-            *lowpassFilterApplyFn = (filterApplyFnPtr) pt1FilterApply;
-            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-                pt1FilterInit(&lowpassFilter[axis].pt1FilterState, gain);
-            }
+            applyFn = (filterApplyFnPtr) pt1FilterApply;
+            pt1FilterInit(&filter->pt1FilterState, gain);
             break;
         case FILTER_BIQUAD:
-            *lowpassFilterApplyFn = (filterApplyFnPtr) biquadFilterApply;
-            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-                biquadFilterInitLPF(&lowpassFilter[axis].biquadFilterState, lpfHz, gyro.targetLooptime);
-            }
+            applyFn = (filterApplyFnPtr) biquadFilterApply;
+            biquadFilterInitLPF(&filter->biquadFilterState, lpfHz, gyroFilterLooptime());
+            break;
+#ifdef USE_GYRO_KALMAN_FILTER
+        case FILTER_KALMAN:
+            applyFn = (filterApplyFnPtr) kalmanFilterApply;
+            kalmanFilterInit(&filter->kalmanFilterState, gain, GYRO_KALMAN_NOISE_VARIANCE);
             break;
+#endif
         }
     }
+    *applyFnOut = applyFn;
+}
+
+static void gyroInstallLowpassFilter(filterApplyFnPtr *lowpassFilterApplyFn, gyroLowpassFilter_t *lowpassFilter,
+    filterApplyFnPtr applyFn, const gyroLowpassFilter_t *filter, bool keepState)
+{
+    // the state is only worth keeping while the slot stays the same kind of filter
+    keepState = keepState && applyFn == *lowpassFilterApplyFn;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyroInstallLowpass(&lowpassFilter[axis], applyFn, filter, keepState);
+    }
+    *lowpassFilterApplyFn = applyFn;
 }
 
 static uint16_t calculateNyquistAdjustedNotchHz(uint16_t notchHz, uint16_t notchCutoffHz)
 {
-    const uint32_t gyroFrequencyNyquist = 1000000 / 2 / gyro.targetLooptime;
+    const uint32_t gyroFrequencyNyquist = 1000000 / 2 / gyroFilterLooptime();
     if (notchHz > gyroFrequencyNyquist) {
         if (notchCutoffHz < gyroFrequencyNyquist) {
             notchHz = gyroFrequencyNyquist;
@@ -697,34 +967,29 @@ void gyroInitSlewLimiter(gyroSensor_t *gyroSensor) {
 }
 #endif
 
-static void gyroInitFilterNotch1(gyroSensor_t *gyroSensor, uint16_t notchHz, uint16_t notchCutoffHz)
+static void gyroBuildNotch(uint16_t notchHz, uint16_t notchCutoffHz, filterApplyFnPtr *applyFnOut, biquadFilter_t *filter)
 {
-    gyroSensor->notchFilter1ApplyFn = nullFilterApply;
+    filterApplyFnPtr applyFn = nullFilterApply;
+    memset(filter, 0, sizeof(*filter));
 
     notchHz = calculateNyquistAdjustedNotchHz(notchHz, notchCutoffHz);
 
     if (notchHz != 0 && notchCutoffHz != 0) {
-        gyroSensor->notchFilter1ApplyFn = (filterApplyFnPtr)biquadFilterApply;
+        applyFn = (filterApplyFnPtr)biquadFilterApply;
         const float notchQ = filterGetNotchQ(notchHz, notchCutoffHz);
-        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            biquadFilterInit(&gyroSensor->notchFilter1[axis], notchHz, gyro.targetLooptime, notchQ, FILTER_NOTCH);
-        }
+        biquadFilterInit(filter, notchHz, gyroFilterLooptime(), notchQ, FILTER_NOTCH);
     }
+    *applyFnOut = applyFn;
 }
 
-static void gyroInitFilterNotch2(gyroSensor_t *gyroSensor, uint16_t notchHz, uint16_t notchCutoffHz)
+static void gyroInstallNotchFilter(filterApplyFnPtr *notchFilterApplyFn, biquadFilter_t *notchFilter,
+    filterApplyFnPtr applyFn, const biquadFilter_t *filter, bool keepState)
 {
-    gyroSensor->notchFilter2ApplyFn = nullFilterApply;
-
-    notchHz = calculateNyquistAdjustedNotchHz(notchHz, notchCutoffHz);
-
-    if (notchHz != 0 && notchCutoffHz != 0) {
-        gyroSensor->notchFilter2ApplyFn = (filterApplyFnPtr)biquadFilterApply;
-        const float notchQ = filterGetNotchQ(notchHz, notchCutoffHz);
-        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            biquadFilterInit(&gyroSensor->notchFilter2[axis], notchHz, gyro.targetLooptime, notchQ, FILTER_NOTCH);
-        }
+    keepState = keepState && applyFn == *notchFilterApplyFn;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyroInstallBiquad(&notchFilter[axis], filter, keepState);
     }
+    *notchFilterApplyFn = applyFn;
 }
 
 #ifdef USE_GYRO_DATA_ANALYSE
@@ -735,18 +1000,157 @@ static bool isDynamicFilterActive(void)
 
 static void gyroInitFilterDynamicNotch(gyroSensor_t *gyroSensor)
 {
-    gyroSensor->notchFilterDynApplyFn = nullFilterApply;
+    gyroSensor->notchFilterDynCount = 0;
+    gyroSampleReaderInit(&gyroSensor->analyseReader, &gyroSensor->sampleRing);
 
     if (isDynamicFilterActive()) {
-        gyroSensor->notchFilterDynApplyFn = (filterApplyFnPtr)biquadFilterApplyDF1; // must be this function, not DF2
+        // applied with biquadFilterApplyDF1(), not DF2, as the notches are retuned on the fly
+        gyroSensor->notchFilterDynCount = constrain(gyroConfig()->dyn_notch_count, 1, DYN_NOTCH_COUNT_MAX);
         const float notchQ = filterGetNotchQ(400, 390); //just any init value
-        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            biquadFilterInit(&gyroSensor->notchFilterDyn[axis], 400, gyro.targetLooptime, notchQ, FILTER_NOTCH);
+        for (int notch = 0; notch < gyroSensor->notchFilterDynCount; notch++) {
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                biquadFilterInit(&gyroSensor->notchFilterDyn[notch][axis], 400, gyroFilterLooptime(), notchQ, FILTER_NOTCH);
+            }
+        }
+    }
+}
+#endif
+
+static void gyroInitFilterChain(gyroSensor_t *gyroSensor)
+{
+    bool ok = true;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        filterChain_t *chain = &gyroSensor->filterChain[axis];
+        filterChainInit(chain);
+        // the dynamic notches are applied ahead of the chain, so DEBUG_FFT can record the data after them
+        ok = filterChainAdd(chain, gyroSensor->notchFilter1ApplyFn, &gyroSensor->notchFilter1[axis]) && ok;
+        ok = filterChainAdd(chain, gyroSensor->notchFilter2ApplyFn, &gyroSensor->notchFilter2[axis]) && ok;
+        ok = filterChainAdd(chain, gyroSensor->lowpassFilterApplyFn, &gyroSensor->lowpassFilter[axis]) && ok;
+        ok = filterChainAdd(chain, gyroSensor->lowpass2FilterApplyFn, &gyroSensor->lowpass2Filter[axis]) && ok;
+    }
+    // filters the chain does not know about are applied one by one by gyroApplyStaticFilters()
+    gyroSensor->filterChainApplyFn = ok ? filterChainGetApplyFn(&gyroSensor->filterChain[X]) : NULL;
+}
+
+#if defined(USE_GYRO_FILTER_BANK) || defined(USE_FIXED_POINT_FILTERS)
+static bool gyroFilterBankAddLowpass(biquadFilterBank_t *bank, filterApplyFnPtr applyFn, const gyroLowpassFilter_t *lowpassFilter)
+{
+    if (applyFn == (filterApplyFnPtr)pt1FilterApply) {
+        return biquadFilterBankAddPt1(bank, lowpassFilter->pt1FilterState.k);
+    } else if (applyFn == (filterApplyFnPtr)biquadFilterApply) {
+        return biquadFilterBankAddBiquad(bank, &lowpassFilter->biquadFilterState);
+    }
+    // the adaptive filters have no fixed coefficients
+    return applyFn == nullFilterApply;
+}
+
+// Builds the bank from the already initialised per axis filters, so both paths always use the same coefficients.
+// The dynamic notch stays per axis as gyroDataAnalyse() retunes each axis on its own.
+static bool gyroBuildFilterBank(const gyroSensor_t *gyroSensor, biquadFilterBank_t *bank)
+{
+    biquadFilterBankInit(bank);
+    bool ok = true;
+    if (gyroSensor->notchFilter1ApplyFn != nullFilterApply) {
+        ok = ok && biquadFilterBankAddBiquad(bank, &gyroSensor->notchFilter1[0]);
+    }
+    if (gyroSensor->notchFilter2ApplyFn != nullFilterApply) {
+        ok = ok && biquadFilterBankAddBiquad(bank, &gyroSensor->notchFilter2[0]);
+    }
+    ok = ok && gyroFilterBankAddLowpass(bank, gyroSensor->lowpassFilterApplyFn, &gyroSensor->lowpassFilter[0]);
+    ok = ok && gyroFilterBankAddLowpass(bank, gyroSensor->lowpass2FilterApplyFn, &gyroSensor->lowpass2Filter[0]);
+
+    return ok;
+}
+#endif
+
+#ifdef USE_GYRO_FILTER_BANK
+static void gyroInitFilterBank(gyroSensor_t *gyroSensor, bool keepState)
+{
+    biquadFilterBank_t bank;
+    const bool active = gyroConfig()->gyro_filter_bank && gyroBuildFilterBank(gyroSensor, &bank);
+
+    if (keepState && active && gyroSensor->filterBankActive && bank.stageCount == gyroSensor->filterBank.stageCount) {
+        for (int i = 0; i < bank.stageCount; i++) {
+            biquadFilterBankStage_t *stage = &gyroSensor->filterBank.stage[i];
+            stage->b0 = bank.stage[i].b0;
+            stage->b1 = bank.stage[i].b1;
+            stage->b2 = bank.stage[i].b2;
+            stage->a1 = bank.stage[i].a1;
+            stage->a2 = bank.stage[i].a2;
+        }
+    } else if (active) {
+        gyroSensor->filterBank = bank;
+    }
+    gyroSensor->filterBankActive = active;
+}
+#endif
+
+#ifdef USE_FIXED_POINT_FILTERS
+static void gyroInitFixedFilterBank(gyroSensor_t *gyroSensor, bool keepState)
+{
+    biquadFilterBank_t bank;
+    const bool active = gyroBuildFilterBank(gyroSensor, &bank);
+
+    if (keepState && active && gyroSensor->fixedFilterBankActive && bank.stageCount == gyroSensor->fixedFilterBank.stageCount) {
+        biquadFilterFixedBank_t fixedBank;
+        biquadFilterFixedBankInit(&fixedBank, &bank);
+        for (int i = 0; i < fixedBank.stageCount; i++) {
+            biquadFilterFixedBankStage_t *stage = &gyroSensor->fixedFilterBank.stage[i];
+            stage->b0 = fixedBank.stage[i].b0;
+            stage->b1 = fixedBank.stage[i].b1;
+            stage->b2 = fixedBank.stage[i].b2;
+            stage->a1 = fixedBank.stage[i].a1;
+            stage->a2 = fixedBank.stage[i].a2;
         }
+    } else if (active) {
+        biquadFilterFixedBankInit(&gyroSensor->fixedFilterBank, &bank);
     }
+    gyroSensor->fixedFilterBankActive = active;
 }
 #endif
 
+// Works out the lowpass and static notch filters for the current settings, they are the same for both gyros
+static void gyroBuildStaticFilters(gyroStaticFilters_t *filters)
+{
+    gyroBuildLowpass(gyroConfig()->gyro_lowpass_type, gyroConfig()->gyro_lowpass_hz,
+        &filters->lowpassApplyFn, &filters->lowpass);
+    gyroBuildLowpass(gyroConfig()->gyro_lowpass2_type, gyroConfig()->gyro_lowpass2_hz,
+        &filters->lowpass2ApplyFn, &filters->lowpass2);
+    gyroBuildNotch(gyroConfig()->gyro_soft_notch_hz_1, gyroConfig()->gyro_soft_notch_cutoff_1,
+        &filters->notch1ApplyFn, &filters->notch1);
+    gyroBuildNotch(gyroConfig()->gyro_soft_notch_hz_2, gyroConfig()->gyro_soft_notch_cutoff_2,
+        &filters->notch2ApplyFn, &filters->notch2);
+}
+
+// Installs the lowpass and static notch filters and the paths that apply them. With keepState the
+// filters that stay the same kind of filter keep their state and only take the new coefficients.
+static void gyroInstallStaticFilters(gyroSensor_t *gyroSensor, const gyroStaticFilters_t *filters, bool keepState)
+{
+    // the banks keep their state only if every stage is still the same kind of filter
+    const bool stagesKept = keepState
+        && filters->lowpassApplyFn == gyroSensor->lowpassFilterApplyFn
+        && filters->lowpass2ApplyFn == gyroSensor->lowpass2FilterApplyFn
+        && filters->notch1ApplyFn == gyroSensor->notchFilter1ApplyFn
+        && filters->notch2ApplyFn == gyroSensor->notchFilter2ApplyFn;
+    UNUSED(stagesKept);
+
+    gyroInstallLowpassFilter(&gyroSensor->lowpassFilterApplyFn, gyroSensor->lowpassFilter,
+        filters->lowpassApplyFn, &filters->lowpass, keepState);
+    gyroInstallLowpassFilter(&gyroSensor->lowpass2FilterApplyFn, gyroSensor->lowpass2Filter,
+        filters->lowpass2ApplyFn, &filters->lowpass2, keepState);
+    gyroInstallNotchFilter(&gyroSensor->notchFilter1ApplyFn, gyroSensor->notchFilter1,
+        filters->notch1ApplyFn, &filters->notch1, keepState);
+    gyroInstallNotchFilter(&gyroSensor->notchFilter2ApplyFn, gyroSensor->notchFilter2,
+        filters->notch2ApplyFn, &filters->notch2, keepState);
+
+    gyroInitFilterChain(gyroSensor);
+#ifdef USE_GYRO_FILTER_BANK
+    gyroInitFilterBank(gyroSensor, stagesKept);
+#endif
+#ifdef USE_FIXED_POINT_FILTERS
+    gyroInitFixedFilterBank(gyroSensor, stagesKept);
+#endif
+}
 
 static void gyroInitSensorFilters(gyroSensor_t *gyroSensor)
 {
@@ -754,22 +1158,9 @@ static void gyroInitSensorFilters(gyroSensor_t *gyroSensor)
     gyroInitSlewLimiter(gyroSensor);
 #endif
 
-    gyroInitLowpassFilterLpf(
-      gyroSensor,
-      FILTER_LOWPASS,
-      gyroConfig()->gyro_lowpass_type,
-      gyroConfig()->gyro_lowpass_hz
-    );
-
-    gyroInitLowpassFilterLpf(
-      gyroSensor,
-      FILTER_LOWPASS2,
-      gyroConfig()->gyro_lowpass2_type,
-      gyroConfig()->gyro_lowpass2_hz
-    );
-
-    gyroInitFilterNotch1(gyroSensor, gyroConfig()->gyro_soft_notch_hz_1, gyroConfig()->gyro_soft_notch_cutoff_1);
-    gyroInitFilterNotch2(gyroSensor, gyroConfig()->gyro_soft_notch_hz_2, gyroConfig()->gyro_soft_notch_cutoff_2);
+    gyroStaticFilters_t filters;
+    gyroBuildStaticFilters(&filters);
+    gyroInstallStaticFilters(gyroSensor, &filters, false);
 #ifdef USE_GYRO_DATA_ANALYSE
     gyroInitFilterDynamicNotch(gyroSensor);
 #endif
@@ -777,12 +1168,108 @@ static void gyroInitSensorFilters(gyroSensor_t *gyroSensor)
 
 void gyroInitFilters(void)
 {
+    gyroFiltersPending = false;
     gyroInitSensorFilters(&gyroSensor1);
 #ifdef USE_DUAL_GYRO
     gyroInitSensorFilters(&gyroSensor2);
 #endif
 }
 
+// Takes up changed lowpass and static notch settings without a reboot. The slow part, working out
+// the coefficients, is done here in the task that changed them. The gyro loop installs them before
+// its next update, so a loop that preempts the task never runs a half updated filter. The dynamic
+// notches are left alone. Refused while armed, returns false then.
+bool gyroReconfigureFilters(void)
+{
+    if (ARMING_FLAG(ARMED)) {
+        return false;
+    }
+    // holds the swap off while the buffer is written
+    __atomic_store_n(&gyroFiltersPending, false, __ATOMIC_RELEASE);
+    gyroBuildStaticFilters(&gyroPendingFilters);
+    __atomic_store_n(&gyroFiltersPending, true, __ATOMIC_RELEASE);
+    return true;
+}
+
+static FAST_CODE_NOINLINE void gyroApplyPendingFilters(void)
+{
+    gyroFiltersPending = false;
+    gyroInstallStaticFilters(&gyroSensor1, &gyroPendingFilters, true);
+#ifdef USE_DUAL_GYRO
+    gyroInstallStaticFilters(&gyroSensor2, &gyroPendingFilters, true);
+#endif
+}
+
+// Interval between the samples seen by the calibration and the software filters
+uint32_t gyroFilterLooptime(void)
+{
+#ifdef USE_GYRO_DECIMATION
+    if (gyroDecimation > 1) {
+        return gyro.targetLooptime * gyroDecimation;
+    }
+#endif
+    return gyro.targetLooptime;
+}
+
+#ifdef USE_GYRO_DECIMATION
+static void gyroInitSensorDecimation(gyroSensor_t *gyroSensor)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        cicDecimatorInit(&gyroSensor->decimator[axis], gyroDecimation);
+    }
+}
+
+// With 32kHz sampling, puts a CIC decimator in front of the calibration and software filters,
+// so they only run at 1/ratio of the sample rate. Must be called before the gyro is calibrated.
+void gyroSetDecimation(uint8_t ratio)
+{
+    gyroDecimation = 1;
+    bool useDecimation = gyroConfig()->gyro_32khz_decimation && gyroConfig()->gyro_use_32khz;
+#ifdef USE_GYRO_FIFO
+    // FIFO reads already decimate
+    useDecimation = useDecimation && !gyroSensor1.gyroDev.fifoReadFn;
+#endif
+    if (useDecimation) {
+        gyroDecimation = constrain(ratio, 1, CIC_DECIMATOR_MAX_RATIO);
+    }
+
+    gyroInitSensorDecimation(&gyroSensor1);
+#ifdef USE_DUAL_GYRO
+    gyroInitSensorDecimation(&gyroSensor2);
+#endif
+    gyroInitFilters();
+#ifdef USE_GYRO_DATA_ANALYSE
+    gyroDataAnalyseInit(gyroFilterLooptime());
+#endif
+}
+
+bool gyroIsDecimating(void)
+{
+    return gyroDecimation > 1;
+}
+
+// Returns true once for every decimated sample that has been filtered
+FAST_CODE bool gyroDecimatedSampleAvailable(void)
+{
+    const bool ready = gyroDecimatedSampleReady;
+    gyroDecimatedSampleReady = false;
+    return ready;
+}
+
+static FAST_CODE bool gyroDecimate(gyroSensor_t *gyroSensor)
+{
+    bool ready = false;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        int32_t output;
+        if (cicDecimatorApply(&gyroSensor->decimator[axis], gyroSensor->gyroDev.gyroADCRaw[axis], &output)) {
+            gyroSensor->gyroDev.gyroADCRaw[axis] = output;
+            ready = true;
+        }
+    }
+    return ready;
+}
+#endif
+
 FAST_CODE bool isGyroSensorCalibrationComplete(const gyroSensor_t *gyroSensor)
 {
     return gyroSensor->calibration.cyclesRemaining == 0;
@@ -815,7 +1302,7 @@ static bool isOnFinalGyroCalibrationCycle(const gyroCalibration_t *gyroCalibrati
 
 static int32_t gyroCalculateCalibratingCycles(void)
 {
-    return (gyroConfig()->gyroCalibrationDuration * 10000) / gyro.targetLooptime;
+    return (gyroConfig()->gyroCalibrationDuration * 10000) / gyroFilterLooptime();
 }
 
 static bool isOnFirstGyroCalibrationCycle(const gyroCalibration_t *gyroCalibration)
@@ -847,8 +1334,106 @@ bool isFirstArmingGyroCalibrationRunning(void)
     return firstArmingCalibrationWasStarted && !isGyroCalibrationComplete();
 }
 
+static void gyroCalibrationCompleted(void)
+{
+#ifdef USE_GYRO_TEMP_COMP
+    gyroTempComp.calibrationTemperaturePending = true;
+#endif
+    schedulerResetTaskStatistics(TASK_SELF); // so calibration cycles do not pollute tasks statistics
+    if (!firstArmingCalibrationWasStarted || (getArmingDisableFlags() & ~ARMING_DISABLED_CALIBRATING) == 0) {
+        beeper(BEEPER_GYRO_CALIBRATED);
+    }
+}
+
+static void gyroSetZero(gyroSensor_t *gyroSensor, int axis, float zero)
+{
+    // please take care with exotic boardalignment !!
+    gyroSensor->gyroDev.gyroZero[axis] = zero;
+    if (axis == Z) {
+      gyroSensor->gyroDev.gyroZero[axis] -= ((float)gyroConfig()->gyro_offset_yaw / 100);
+    }
+}
+
+// Welford variance over windows of GYRO_CALIBRATION_WINDOW_US. A window with movement is dropped on its own,
+// calibration ends as soon as the accepted windows pin down the zero offset, or after the configured
+// duration if the gyro is too noisy for that.
+static void performGyroCalibrationFast(gyroSensor_t *gyroSensor, uint8_t gyroMovementCalibrationThreshold)
+{
+    gyroCalibration_t *calibration = &gyroSensor->calibration;
+
+    if (isOnFirstGyroCalibrationCycle(calibration)) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            calibration->acceptedSum[axis] = 0.0f;
+            calibration->acceptedSquares[axis] = 0.0f;
+            // gyroZero is set to zero until calibration complete
+            gyroSensor->gyroDev.gyroZero[axis] = 0.0f;
+        }
+        calibration->acceptedCount = 0;
+        calibration->acceptedWindows = 0;
+        calibration->windowCount = 0;
+    }
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        if (calibration->windowCount == 0) {
+            calibration->sum[axis] = 0.0f;
+            devClear(&calibration->var[axis]);
+        }
+        calibration->sum[axis] += gyroSensor->gyroDev.gyroADCRaw[axis];
+        devPush(&calibration->var[axis], gyroSensor->gyroDev.gyroADCRaw[axis]);
+    }
+    calibration->windowCount++;
+    // the configured duration is a deadline, it does not complete calibration by itself
+    if (calibration->cyclesRemaining > 1) {
+        --calibration->cyclesRemaining;
+    }
+
+    const int32_t windowCycles = MAX(GYRO_CALIBRATION_WINDOW_US / (int32_t)gyroFilterLooptime(), 2);
+    if (calibration->windowCount < windowCycles) {
+        return;
+    }
+    const int32_t windowCount = calibration->windowCount;
+    calibration->windowCount = 0;
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        const float stddev = devStandardDeviation(&calibration->var[axis]);
+        if (axis == X) {
+            DEBUG_SET(DEBUG_GYRO_RAW, DEBUG_GYRO_CALIBRATION, lrintf(stddev));
+        }
+        if (gyroMovementCalibrationThreshold && stddev > gyroMovementCalibrationThreshold) {
+            // the model was moved, only this window is lost
+            return;
+        }
+    }
+
+    bool settled = true;
+    calibration->acceptedCount += windowCount;
+    calibration->acceptedWindows++;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        calibration->acceptedSum[axis] += calibration->sum[axis];
+        calibration->acceptedSquares[axis] += devVariance(&calibration->var[axis]) * (windowCount - 1);
+        // squared standard error of the mean from the variance pooled over the accepted windows
+        const float variance = calibration->acceptedSquares[axis] / (calibration->acceptedCount - calibration->acceptedWindows);
+        if (variance > sq(GYRO_CALIBRATION_MAX_ERROR) * calibration->acceptedCount) {
+            settled = false;
+        }
+    }
+
+    if ((settled && calibration->acceptedWindows >= GYRO_CALIBRATION_MIN_WINDOWS) || calibration->cyclesRemaining == 1) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            gyroSetZero(gyroSensor, axis, calibration->acceptedSum[axis] / calibration->acceptedCount);
+        }
+        gyroCalibrationCompleted();
+        calibration->cyclesRemaining = 0;
+    }
+}
+
 STATIC_UNIT_TESTED void performGyroCalibration(gyroSensor_t *gyroSensor, uint8_t gyroMovementCalibrationThreshold)
 {
+    if (gyroConfig()->gyro_fast_calibration) {
+        performGyroCalibrationFast(gyroSensor, gyroMovementCalibrationThreshold);
+        return;
+    }
+
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
         // Reset g[axis] at start of calibration
         if (isOnFirstGyroCalibrationCycle(&gyroSensor->calibration)) {
@@ -876,19 +1461,12 @@ STATIC_UNIT_TESTED void performGyroCalibration(gyroSensor_t *gyroSensor, uint8_t
                 return;
             }
 
-            // please take care with exotic boardalignment !!
-            gyroSensor->gyroDev.gyroZero[axis] = gyroSensor->calibration.sum[axis] / gyroCalculateCalibratingCycles();
-            if (axis == Z) {
-              gyroSensor->gyroDev.gyroZero[axis] -= ((float)gyroConfig()->gyro_offset_yaw / 100);
-            }
+            gyroSetZero(gyroSensor, axis, gyroSensor->calibration.sum[axis] / gyroCalculateCalibratingCycles());
         }
     }
 
     if (isOnFinalGyroCalibrationCycle(&gyroSensor->calibration)) {
-        schedulerResetTaskStatistics(TASK_SELF); // so calibration cycles do not pollute tasks statistics
-        if (!firstArmingCalibrationWasStarted || (getArmingDisableFlags() & ~ARMING_DISABLED_CALIBRATING) == 0) {
-            beeper(BEEPER_GYRO_CALIBRATED);
-        }
+        gyroCalibrationCompleted();
     }
     --gyroSensor->calibration.cyclesRemaining;
 
@@ -898,7 +1476,7 @@ STATIC_UNIT_TESTED void performGyroCalibration(gyroSensor_t *gyroSensor, uint8_t
 FAST_CODE int32_t gyroSlewLimiter(gyroSensor_t *gyroSensor, int axis)
 {
     int32_t ret = (int32_t)gyroSensor->gyroDev.gyroADCRaw[axis];
-    if (gyroConfig()->checkOverflow || gyroHasOverflowProtection) {
+    if (gyroRuntimeConfig.checkOverflow || gyroHasOverflowProtection) {
         // don't use the slew limiter if overflow checking is on or gyro is not subject to overflow bug
         return ret;
     }
@@ -913,12 +1491,12 @@ FAST_CODE int32_t gyroSlewLimiter(gyroSensor_t *gyroSensor, int axis)
 #endif
 
 #ifdef USE_GYRO_OVERFLOW_CHECK
-static FAST_CODE_NOINLINE void handleOverflow(gyroSensor_t *gyroSensor, timeUs_t currentTimeUs)
+static void handleOverflow(gyroSensor_t *gyroSensor, timeUs_t currentTimeUs)
 {
     const float gyroOverflowResetRate = GYRO_OVERFLOW_RESET_THRESHOLD * gyroSensor->gyroDev.scale;
-    if ((abs(gyro.gyroADCf[X]) < gyroOverflowResetRate)
-          && (abs(gyro.gyroADCf[Y]) < gyroOverflowResetRate)
-          && (abs(gyro.gyroADCf[Z]) < gyroOverflowResetRate)) {
+    if ((gyroSensor->peakRate[X] < gyroOverflowResetRate)
+          && (gyroSensor->peakRate[Y] < gyroOverflowResetRate)
+          && (gyroSensor->peakRate[Z] < gyroOverflowResetRate)) {
         // if we have 50ms of consecutive OK gyro vales, then assume yaw readings are OK again and reset overflowDetected
         // reset requires good OK values on all axes
         if (cmpTimeUs(currentTimeUs, gyroSensor->overflowTimeUs) > 50000) {
@@ -930,7 +1508,7 @@ static FAST_CODE_NOINLINE void handleOverflow(gyroSensor_t *gyroSensor, timeUs_t
     }
 }
 
-static FAST_CODE void checkForOverflow(gyroSensor_t *gyroSensor, timeUs_t currentTimeUs)
+static void checkForOverflow(gyroSensor_t *gyroSensor, timeUs_t currentTimeUs)
 {
     // check for overflow to handle Yaw Spin To The Moon (YSTTM)
     // ICM gyros are specified to +/- 2000 deg/sec, in a crash they can go out of spec.
@@ -943,13 +1521,13 @@ static FAST_CODE void checkForOverflow(gyroSensor_t *gyroSensor, timeUs_t curren
         // check for overflow in the axes set in overflowAxisMask
         gyroOverflow_e overflowCheck = GYRO_OVERFLOW_NONE;
         const float gyroOverflowTriggerRate = GYRO_OVERFLOW_TRIGGER_THRESHOLD * gyroSensor->gyroDev.scale;
-        if (abs(gyro.gyroADCf[X]) > gyroOverflowTriggerRate) {
+        if (gyroSensor->peakRate[X] > gyroOverflowTriggerRate) {
             overflowCheck |= GYRO_OVERFLOW_X;
         }
-        if (abs(gyro.gyroADCf[Y]) > gyroOverflowTriggerRate) {
+        if (gyroSensor->peakRate[Y] > gyroOverflowTriggerRate) {
             overflowCheck |= GYRO_OVERFLOW_Y;
         }
-        if (abs(gyro.gyroADCf[Z]) > gyroOverflowTriggerRate) {
+        if (gyroSensor->peakRate[Z] > gyroOverflowTriggerRate) {
             overflowCheck |= GYRO_OVERFLOW_Z;
         }
         if (overflowCheck & overflowAxisMask) {
@@ -965,10 +1543,10 @@ static FAST_CODE void checkForOverflow(gyroSensor_t *gyroSensor, timeUs_t curren
 #endif // USE_GYRO_OVERFLOW_CHECK
 
 #ifdef USE_YAW_SPIN_RECOVERY
-static FAST_CODE_NOINLINE void handleYawSpin(gyroSensor_t *gyroSensor, timeUs_t currentTimeUs)
+static void handleYawSpin(gyroSensor_t *gyroSensor, timeUs_t currentTimeUs)
 {
-    const float yawSpinResetRate = gyroConfig()->yaw_spin_threshold - 100.0f;
-    if (abs(gyro.gyroADCf[Z]) < yawSpinResetRate) {
+    const float yawSpinResetRate = gyroRuntimeConfig.yawSpinThreshold - 100.0f;
+    if (gyroSensor->peakRate[Z] < yawSpinResetRate) {
         // testing whether 20ms of consecutive OK gyro yaw values is enough
         if (cmpTimeUs(currentTimeUs, gyroSensor->yawSpinTimeUs) > 20000) {
             gyroSensor->yawSpinDetected = false;
@@ -979,7 +1557,7 @@ static FAST_CODE_NOINLINE void handleYawSpin(gyroSensor_t *gyroSensor, timeUs_t
     }
 }
 
-static FAST_CODE void checkForYawSpin(gyroSensor_t *gyroSensor, timeUs_t currentTimeUs)
+static void checkForYawSpin(gyroSensor_t *gyroSensor, timeUs_t currentTimeUs)
 {
     // if not in overflow mode, handle yaw spins above threshold
 #ifdef USE_GYRO_OVERFLOW_CHECK
@@ -994,7 +1572,7 @@ static FAST_CODE void checkForYawSpin(gyroSensor_t *gyroSensor, timeUs_t current
     } else {
 #ifndef SIMULATOR_BUILD
         // check for spin on yaw axis only
-         if (abs(gyro.gyroADCf[Z]) > gyroConfig()->yaw_spin_threshold) {
+         if (gyroSensor->peakRate[Z] > gyroRuntimeConfig.yawSpinThreshold) {
             gyroSensor->yawSpinDetected = true;
             gyroSensor->yawSpinTimeUs = currentTimeUs;
         }
@@ -1003,12 +1581,279 @@ static FAST_CODE void checkForYawSpin(gyroSensor_t *gyroSensor, timeUs_t current
 }
 #endif // USE_YAW_SPIN_RECOVERY
 
+#if defined(USE_GYRO_OVERFLOW_CHECK) || defined(USE_YAW_SPIN_RECOVERY)
+// The per sample work is only a peak hold of the rates, the detection state machines run on the
+// peaks once every gyro_overflow_check_us. A peak above a trigger threshold is therefore seen
+// at the next check, and a reset still needs every sample of the reset period below threshold.
+static FAST_CODE_NOINLINE void gyroCheckPeakRates(gyroSensor_t *gyroSensor, timeUs_t currentTimeUs)
+{
+    gyroSensor->peakCheckTimeUs = currentTimeUs;
+#ifdef USE_GYRO_OVERFLOW_CHECK
+    if (gyroRuntimeConfig.checkOverflow && !gyroHasOverflowProtection) {
+        checkForOverflow(gyroSensor, currentTimeUs);
+    }
+#endif
+#ifdef USE_YAW_SPIN_RECOVERY
+    if (gyroRuntimeConfig.yawSpinRecovery) {
+        checkForYawSpin(gyroSensor, currentTimeUs);
+    }
+#endif
+    gyroSensor->peakRate[X] = 0.0f;
+    gyroSensor->peakRate[Y] = 0.0f;
+    gyroSensor->peakRate[Z] = 0.0f;
+}
+
+static FAST_CODE void gyroUpdatePeakRates(gyroSensor_t *gyroSensor, timeUs_t currentTimeUs)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        const float rate = fabsf(gyro.gyroADCf[axis]);
+        if (rate > gyroSensor->peakRate[axis]) {
+            gyroSensor->peakRate[axis] = rate;
+        }
+    }
+    if (cmpTimeUs(currentTimeUs, gyroSensor->peakCheckTimeUs) >= gyroRuntimeConfig.overflowCheckUs) {
+        gyroCheckPeakRates(gyroSensor, currentTimeUs);
+    }
+}
+#endif
+
+#ifdef USE_GYRO_FIFO
+// Decimating pre-filter for the samples read from the FIFO. The boxcar average has its nulls at
+// multiples of the output rate, so the oversampled noise does not alias into the filtered band.
+STATIC_UNIT_TESTED FAST_CODE void gyroFifoDecimate(gyroDev_t *gyroDev)
+{
+    const int sampleCount = gyroDev->fifoSampleCount;
+    if (sampleCount == 0) {
+        return;
+    }
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        int32_t sum = 0;
+        for (int i = 0; i < sampleCount; i++) {
+            sum += gyroDev->gyroADCRawFifo[i][axis];
+        }
+        // round to nearest
+        sum += sum >= 0 ? sampleCount / 2 : -sampleCount / 2;
+        gyroDev->gyroADCRaw[axis] = sum / sampleCount;
+    }
+}
+#endif
+
+// The filter stages below take a debugEnabled argument that is a compile time constant at every caller,
+// each is built once with and once without its DEBUG_SET_IF() output, see gyroFilterSampleFn.
+
+static ALWAYS_INLINE void gyroStoreFilteredSample(gyroSensor_t *gyroSensor, int axis, float gyroADCf, timeDelta_t sampleDeltaUs, const bool debugEnabled)
+{
+    // DEBUG_GYRO_FILTERED records the scaled, filtered, after all software filtering has been applied.
+    DEBUG_SET_IF(debugEnabled, DEBUG_GYRO_FILTERED, axis, lrintf(gyroADCf));
+    gyroSensor->gyroDev.gyroADCf[axis] = gyroADCf;
+    if (!gyroSensor->overflowDetected) {
+        // integrate using trapezium rule to avoid bias
+        accumulatedMeasurements[axis] += 0.5f * (gyroPrevious[axis] + gyroADCf) * sampleDeltaUs;
+        gyroPrevious[axis] = gyroADCf;
+    }
+}
+
+#ifdef USE_GYRO_FILTER_BANK
+static ALWAYS_INLINE void gyroFilterBankUpdate(gyroSensor_t *gyroSensor, timeDelta_t sampleDeltaUs, const bool debugEnabled)
+{
+    float gyroADCf[XYZ_AXIS_COUNT];
+
+#ifdef USE_RPM_FILTER
+    PROFILER_SPAN_DECLARE(PROFILER_GYRO_RPM_FILTER);
+#endif
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        DEBUG_SET_IF(debugEnabled, DEBUG_GYRO_RAW, axis, gyroSensor->gyroDev.gyroADCRaw[axis]);
+        gyroADCf[axis] = gyroSensor->gyroDev.gyroADC[axis] * gyroSensor->gyroDev.scale;
+        DEBUG_SET_IF(debugEnabled, DEBUG_GYRO_SCALED, axis, lrintf(gyroADCf[axis]));
+#ifdef USE_RPM_FILTER
+        PROFILER_SPAN_BEGIN(PROFILER_GYRO_RPM_FILTER);
+        gyroADCf[axis] = rpmFilterApply(&gyroSensor->rpmFilterBank, axis, gyroADCf[axis]);
+        PROFILER_SPAN_END(PROFILER_GYRO_RPM_FILTER);
+#endif
+    }
+#ifdef USE_RPM_FILTER
+    PROFILER_SPAN_RECORD(PROFILER_GYRO_RPM_FILTER);
+#endif
+
+#ifdef USE_GYRO_DATA_ANALYSE
+    if (gyroSensor->notchFilterDynCount) {
+        DEBUG_SET_IF(debugEnabled, DEBUG_FFT, 0, lrintf(gyroADCf[X]));
+        PROFILER_BEGIN(PROFILER_GYRO_DYN_NOTCH);
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            for (int notch = 0; notch < gyroSensor->notchFilterDynCount; notch++) {
+                gyroADCf[axis] = biquadFilterApplyDF1(&gyroSensor->notchFilterDyn[notch][axis], gyroADCf[axis]);
+            }
+        }
+        PROFILER_END(PROFILER_GYRO_DYN_NOTCH);
+        DEBUG_SET_IF(debugEnabled, DEBUG_FFT, 1, lrintf(gyroADCf[X]));
+    }
+#endif
+
+    PROFILER_BEGIN(PROFILER_GYRO_STATIC_FILTERS);
+    biquadFilterBankApply(&gyroSensor->filterBank, gyroADCf);
+    PROFILER_END(PROFILER_GYRO_STATIC_FILTERS);
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyroStoreFilteredSample(gyroSensor, axis, gyroADCf[axis], sampleDeltaUs, debugEnabled);
+    }
+}
+#endif
+
+#ifdef USE_FIXED_POINT_FILTERS
+// without an FPU every float operation is a library call, so the filters run on Q8 sensor counts
+// and the data is converted and scaled only once on the way in and once on the way out
+static ALWAYS_INLINE void gyroFixedFilterBankUpdate(gyroSensor_t *gyroSensor, timeDelta_t sampleDeltaUs, const bool debugEnabled)
+{
+    int32_t gyroADCq[XYZ_AXIS_COUNT];
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        DEBUG_SET_IF(debugEnabled, DEBUG_GYRO_RAW, axis, gyroSensor->gyroDev.gyroADCRaw[axis]);
+        DEBUG_SET_IF(debugEnabled, DEBUG_GYRO_SCALED, axis, lrintf(gyroSensor->gyroDev.gyroADC[axis] * gyroSensor->gyroDev.scale));
+        gyroADCq[axis] = gyroSensor->gyroDev.gyroADC[axis] * (1 << FIXED_FILTER_DATA_BITS);
+    }
+
+    PROFILER_BEGIN(PROFILER_GYRO_STATIC_FILTERS);
+    biquadFilterFixedBankApply(&gyroSensor->fixedFilterBank, gyroADCq);
+    PROFILER_END(PROFILER_GYRO_STATIC_FILTERS);
+
+    const float scale = gyroSensor->gyroDev.scale * (1.0f / (1 << FIXED_FILTER_DATA_BITS));
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyroStoreFilteredSample(gyroSensor, axis, gyroADCq[axis] * scale, sampleDeltaUs, debugEnabled);
+    }
+}
+#endif
+
+static ALWAYS_INLINE float gyroApplyStaticFilters(const gyroSensor_t *gyroSensor, int axis, float gyroADCf)
+{
+    if (gyroSensor->filterChainApplyFn) {
+        return gyroSensor->filterChainApplyFn(&gyroSensor->filterChain[axis], gyroADCf);
+    }
+    // the chain could not take all of the filters, so they are applied one by one
+    gyroADCf = gyroSensor->notchFilter1ApplyFn((filter_t *)&gyroSensor->notchFilter1[axis], gyroADCf);
+    gyroADCf = gyroSensor->notchFilter2ApplyFn((filter_t *)&gyroSensor->notchFilter2[axis], gyroADCf);
+    gyroADCf = gyroSensor->lowpassFilterApplyFn((filter_t *)&gyroSensor->lowpassFilter[axis], gyroADCf);
+    return gyroSensor->lowpass2FilterApplyFn((filter_t *)&gyroSensor->lowpass2Filter[axis], gyroADCf);
+}
+
+// applies all filters to the calibrated and aligned sample in gyroDev.gyroADC
+static ALWAYS_INLINE void gyroFilterSample(gyroSensor_t *gyroSensor, timeDelta_t sampleDeltaUs, const bool debugEnabled)
+{
+#ifdef USE_GYRO_FILTER_BANK
+    if (gyroSensor->filterBankActive) {
+        gyroFilterBankUpdate(gyroSensor, sampleDeltaUs, debugEnabled);
+        return;
+    }
+#endif
+
+#ifdef USE_FIXED_POINT_FILTERS
+    if (gyroSensor->fixedFilterBankActive) {
+        gyroFixedFilterBankUpdate(gyroSensor, sampleDeltaUs, debugEnabled);
+        return;
+    }
+#endif
+
+    // the stages of the three axes are interleaved, so each probe adds up its spans
+#ifdef USE_RPM_FILTER
+    PROFILER_SPAN_DECLARE(PROFILER_GYRO_RPM_FILTER);
+#endif
+#ifdef USE_GYRO_DATA_ANALYSE
+    PROFILER_SPAN_DECLARE(PROFILER_GYRO_DYN_NOTCH);
+#endif
+    PROFILER_SPAN_DECLARE(PROFILER_GYRO_STATIC_FILTERS);
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        DEBUG_SET_IF(debugEnabled, DEBUG_GYRO_RAW, axis, gyroSensor->gyroDev.gyroADCRaw[axis]);
+        // scale gyro output to degrees per second
+        float gyroADCf = gyroSensor->gyroDev.gyroADC[axis] * gyroSensor->gyroDev.scale;
+        // DEBUG_GYRO_SCALED records the unfiltered, scaled gyro output
+        DEBUG_SET_IF(debugEnabled, DEBUG_GYRO_SCALED, axis, lrintf(gyroADCf));
+
+#ifdef USE_RPM_FILTER
+        // apply the motor noise notches
+        PROFILER_SPAN_BEGIN(PROFILER_GYRO_RPM_FILTER);
+        gyroADCf = rpmFilterApply(&gyroSensor->rpmFilterBank, axis, gyroADCf);
+        PROFILER_SPAN_END(PROFILER_GYRO_RPM_FILTER);
+#endif
+
+#ifdef USE_GYRO_DATA_ANALYSE
+        // apply dynamic notch filters, there are none when the dynamic filter is off
+        if (gyroSensor->notchFilterDynCount) {
+            if (axis == X) {
+                DEBUG_SET_IF(debugEnabled, DEBUG_FFT, 0, lrintf(gyroADCf)); // store raw data
+            }
+            PROFILER_SPAN_BEGIN(PROFILER_GYRO_DYN_NOTCH);
+            for (int notch = 0; notch < gyroSensor->notchFilterDynCount; notch++) {
+                gyroADCf = biquadFilterApplyDF1(&gyroSensor->notchFilterDyn[notch][axis], gyroADCf);
+            }
+            PROFILER_SPAN_END(PROFILER_GYRO_DYN_NOTCH);
+            if (axis == X) {
+                DEBUG_SET_IF(debugEnabled, DEBUG_FFT, 1, lrintf(gyroADCf)); // store data after dynamic notch
+            }
+        }
+#endif
+        // apply static notch filters and software lowpass filters
+        PROFILER_SPAN_BEGIN(PROFILER_GYRO_STATIC_FILTERS);
+        gyroADCf = gyroApplyStaticFilters(gyroSensor, axis, gyroADCf);
+        PROFILER_SPAN_END(PROFILER_GYRO_STATIC_FILTERS);
+
+        gyroStoreFilteredSample(gyroSensor, axis, gyroADCf, sampleDeltaUs, debugEnabled);
+    }
+#ifdef USE_RPM_FILTER
+    PROFILER_SPAN_RECORD(PROFILER_GYRO_RPM_FILTER);
+#endif
+#ifdef USE_GYRO_DATA_ANALYSE
+    PROFILER_SPAN_RECORD(PROFILER_GYRO_DYN_NOTCH);
+#endif
+    PROFILER_SPAN_RECORD(PROFILER_GYRO_STATIC_FILTERS);
+}
+
+static FAST_CODE void gyroFilterSampleNoDebug(gyroSensor_t *gyroSensor, timeDelta_t sampleDeltaUs)
+{
+    gyroFilterSample(gyroSensor, sampleDeltaUs, false);
+}
+
+static FAST_CODE void gyroFilterSampleDebug(gyroSensor_t *gyroSensor, timeDelta_t sampleDeltaUs)
+{
+    gyroFilterSample(gyroSensor, sampleDeltaUs, true);
+}
+
+static FAST_CODE void gyroSampleRingWrite(gyroSampleRing_t *ring, const gyroDev_t *gyroDev)
+{
+    gyroSample_t *sample = &ring->sample[ring->writeCount & (GYRO_SAMPLE_RING_SIZE - 1)];
+    sample->timeUs = gyroDev->sampleTimeUs;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        sample->raw[axis] = gyroDev->gyroADC[axis];
+        sample->filtered[axis] = gyroDev->gyroADCf[axis];
+    }
+    // the sample must be complete before readers can see it
+    asm volatile ("": : :"memory");
+    ring->writeCount++;
+}
+
 static FAST_CODE FAST_CODE_NOINLINE void gyroUpdateSensor(gyroSensor_t *gyroSensor, timeUs_t currentTimeUs)
 {
+    gyroSensor->gyroDev.sampleTimeUs = currentTimeUs;
+    // only reads that returned a sample are recorded
+    PROFILER_BEGIN(PROFILER_GYRO_READ);
     if (!gyroSensor->gyroDev.readFn(&gyroSensor->gyroDev)) {
         return;
     }
+    PROFILER_END(PROFILER_GYRO_READ);
     gyroSensor->gyroDev.dataReady = false;
+#ifdef USE_GYRO_FIFO
+    if (gyroSensor->gyroDev.fifoReadFn) {
+        gyroFifoDecimate(&gyroSensor->gyroDev);
+    }
+#endif
+#ifdef USE_GYRO_DECIMATION
+    if (gyroDecimation > 1) {
+        if (!gyroDecimate(gyroSensor)) {
+            // calibration and filters only see the decimated samples
+            return;
+        }
+        gyroDecimatedSampleReady = true;
+    }
+#endif
 
     if (isGyroSensorCalibrationComplete(gyroSensor)) {
         // move 16-bit gyro data into 32-bit variables to avoid overflows in calculations
@@ -1023,95 +1868,193 @@ static FAST_CODE FAST_CODE_NOINLINE void gyroUpdateSensor(gyroSensor_t *gyroSens
         gyroSensor->gyroDev.gyroADC[Z] = gyroSensor->gyroDev.gyroADCRaw[Z] - gyroSensor->gyroDev.gyroZero[Z];
 #endif
 
+#ifdef USE_GYRO_TEMP_COMP
+        if (gyroSensor == &gyroSensor1) {
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                gyroSensor->gyroDev.gyroADC[axis] -= gyroTempComp.offset[axis];
+                if (gyroTempComp.learning) {
+                    const float raw = gyroSensor->gyroDev.gyroADCRaw[axis];
+                    gyroTempComp.sum[axis] += raw;
+                    gyroTempComp.sumSquares[axis] += sq(raw);
+                }
+            }
+            if (gyroTempComp.learning) {
+                gyroTempComp.count++;
+            }
+        }
+#endif
+
         alignSensors(gyroSensor->gyroDev.gyroADC, gyroSensor->gyroDev.gyroAlign);
+
+#ifdef USE_MOTOR_TIMING
+        if (&gyroSensor->gyroDev == gyroDevInUse()) {
+            // The bench latency test follows an impulse to the motor outputs. It goes in after the
+            // alignment, so it is on the roll axis of the board however the sensor is mounted.
+            const float impulse = motorTimingTestImpulse();
+            if (impulse) {
+                gyroSensor->gyroDev.gyroADC[X] += impulse / gyroSensor->gyroDev.scale;
+            }
+        }
+#endif
     } else {
         performGyroCalibration(gyroSensor, gyroConfig()->gyroMovementCalibrationThreshold);
         // still calibrating, so no need to further process gyro data
         return;
     }
 
-#ifdef USE_GYRO_DATA_ANALYSE
-    if (isDynamicFilterActive()) {
-        gyroDataAnalyse(&gyroSensor->gyroDev, gyroSensor->notchFilterDyn);
-    }
+#ifdef USE_DUAL_GYRO
+    // every path below updates gyroADCf
+    gyroSensor->filteredSampleTimeUs = gyroSensor->gyroDev.sampleTimeUs;
 #endif
 
     const timeDelta_t sampleDeltaUs = currentTimeUs - accumulationLastTimeSampledUs;
     accumulationLastTimeSampledUs = currentTimeUs;
     accumulatedMeasurementTimeUs += sampleDeltaUs;
 
-#ifdef USE_GYRO_OVERFLOW_CHECK
-    if (gyroConfig()->checkOverflow && !gyroHasOverflowProtection) {
-        checkForOverflow(gyroSensor, currentTimeUs);
-    }
+#if defined(USE_GYRO_OVERFLOW_CHECK) || defined(USE_YAW_SPIN_RECOVERY)
+    gyroUpdatePeakRates(gyroSensor, currentTimeUs);
 #endif
 
-#ifdef USE_YAW_SPIN_RECOVERY
-    if (gyroConfig()->yaw_spin_recovery) {
-        checkForYawSpin(gyroSensor, currentTimeUs);
+    gyroFilterSampleFn(gyroSensor, sampleDeltaUs);
+    gyroSampleRingWrite(&gyroSensor->sampleRing, &gyroSensor->gyroDev);
+
+#ifdef USE_GYRO_DATA_ANALYSE
+    if (isDynamicFilterActive() || gyroSpectrumRequested(currentTimeUs)) {
+        PROFILER_BEGIN(PROFILER_GYRO_ANALYSE);
+        gyroDataAnalyse(&gyroSensor->gyroDev, &gyroSensor->analyseReader, gyroSensor->notchFilterDyn);
+        PROFILER_END(PROFILER_GYRO_ANALYSE);
     }
 #endif
+}
 
-    if (gyroDebugMode == DEBUG_NONE) {
-        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            // NOTE: this branch optimized for when there is no gyro debugging, ensure it is kept in step with non-optimized branch
-            float gyroADCf = gyroSensor->gyroDev.gyroADC[axis] * gyroSensor->gyroDev.scale;
-
-#ifdef USE_GYRO_DATA_ANALYSE
-            gyroADCf = gyroSensor->notchFilterDynApplyFn((filter_t *)&gyroSensor->notchFilterDyn[axis], gyroADCf);
-#endif
-            gyroADCf = gyroSensor->notchFilter1ApplyFn((filter_t *)&gyroSensor->notchFilter1[axis], gyroADCf);
-            gyroADCf = gyroSensor->notchFilter2ApplyFn((filter_t *)&gyroSensor->notchFilter2[axis], gyroADCf);
-            gyroADCf = gyroSensor->lowpassFilterApplyFn((filter_t *)&gyroSensor->lowpassFilter[axis], gyroADCf);
-            gyroADCf = gyroSensor->lowpass2FilterApplyFn((filter_t *)&gyroSensor->lowpass2Filter[axis], gyroADCf);
-            gyroSensor->gyroDev.gyroADCf[axis] = gyroADCf;
-
-            if (!gyroSensor->overflowDetected) {
-                // integrate using trapezium rule to avoid bias
-                accumulatedMeasurements[axis] += 0.5f * (gyroPrevious[axis] + gyroADCf) * sampleDeltaUs;
-                gyroPrevious[axis] = gyroADCf;
+#ifdef USE_DUAL_GYRO
+// Median of the gyros in the vote. Of an even count the two middle values are averaged, unless they
+// are further apart than the outlier threshold. Then one of them is glitching and the one closer
+// to the last output wins.
+STATIC_UNIT_TESTED FAST_CODE float gyroVoteAxis(const float sample[][XYZ_AXIS_COUNT], int axis, float outlierThreshold)
+{
+    float value[GYRO_SENSOR_COUNT];
+    int count = 0;
+    for (int i = 0; i < GYRO_SENSOR_COUNT; i++) {
+        if (!gyroHealth[i].excluded) {
+            // insertion sort, there are only a few gyros
+            int pos = count++;
+            for (; pos > 0 && value[pos - 1] > sample[i][axis]; pos--) {
+                value[pos] = value[pos - 1];
             }
+            value[pos] = sample[i][axis];
         }
-    } else {
-        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            DEBUG_SET(DEBUG_GYRO_RAW, axis, gyroSensor->gyroDev.gyroADCRaw[axis]);
-            // scale gyro output to degrees per second
-            float gyroADCf = gyroSensor->gyroDev.gyroADC[axis] * gyroSensor->gyroDev.scale;
-            // DEBUG_GYRO_SCALED records the unfiltered, scaled gyro output
-            DEBUG_SET(DEBUG_GYRO_SCALED, axis, lrintf(gyroADCf));
+    }
 
-#ifdef USE_GYRO_DATA_ANALYSE
-            // apply dynamic notch filter
-            if (isDynamicFilterActive()) {
-                if (axis == X) {
-                    DEBUG_SET(DEBUG_FFT, 0, lrintf(gyroADCf)); // store raw data
-                }
-                gyroADCf = gyroSensor->notchFilterDynApplyFn((filter_t *)&gyroSensor->notchFilterDyn[axis], gyroADCf);
-                if (axis == X) {
-                    DEBUG_SET(DEBUG_FFT, 1, lrintf(gyroADCf)); // store data after dynamic notch
+    // the last gyro in the vote is never left out, so the count is at least one
+    if (count & 1) {
+        return value[count / 2];
+    }
+    const float low = value[count / 2 - 1];
+    const float high = value[count / 2];
+    if (outlierThreshold && high - low > outlierThreshold) {
+        const float previous = gyro.gyroADCf[axis];
+        return fabsf(low - previous) < fabsf(high - previous) ? low : high;
+    }
+    return 0.5f * (low + high);
+}
+
+// A real gyro always has some noise in its raw samples, one that repeats the same raw value on every
+// axis sample after sample has stopped updating. Loops without a new sample are not counted.
+static FAST_CODE bool gyroSampleStuck(gyroHealth_t *health, const gyroDev_t *gyroDev)
+{
+    if (gyroDev->sampleTimeUs == health->sampleTimeUs) {
+        return false;
+    }
+    health->sampleTimeUs = gyroDev->sampleTimeUs;
+
+    const int16_t *raw = gyroDev->gyroADCRaw;
+    bool stuck = true;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        stuck = stuck && raw[axis] == health->previousRaw[axis];
+        health->previousRaw[axis] = raw[axis];
+    }
+    return stuck;
+}
+
+STATIC_UNIT_TESTED FAST_CODE void gyroUpdateHealth(const float sample[][XYZ_AXIS_COUNT], float outlierThreshold)
+{
+    int includedCount = 0;
+    for (int i = 0; i < GYRO_SENSOR_COUNT; i++) {
+        includedCount += !gyroHealth[i].excluded;
+    }
+    const bool voteHasMajority = includedCount >= GYRO_HEALTH_MAJORITY;
+
+    uint8_t excludedMask = 0;
+    for (int i = 0; i < GYRO_SENSOR_COUNT; i++) {
+        gyroHealth_t *health = &gyroHealth[i];
+        const bool stuck = gyroSampleStuck(health, &gyroSensors[i]->gyroDev);
+        int change = -1;
+        if (gyroSensors[i]->overflowDetected) {
+            change = GYRO_HEALTH_OVERFLOW;
+        } else if (stuck) {
+            change = GYRO_HEALTH_STUCK;
+        } else if (outlierThreshold && voteHasMajority) {
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                if (fabsf(sample[i][axis] - gyro.gyroADCf[axis]) > outlierThreshold) {
+                    change = GYRO_HEALTH_DISAGREE;
+                    break;
                 }
             }
-#endif
-            // apply static notch filters and software lowpass filters
-            gyroADCf = gyroSensor->notchFilter1ApplyFn((filter_t *)&gyroSensor->notchFilter1[axis], gyroADCf);
-            gyroADCf = gyroSensor->notchFilter2ApplyFn((filter_t *)&gyroSensor->notchFilter2[axis], gyroADCf);
-            gyroADCf = gyroSensor->lowpassFilterApplyFn((filter_t *)&gyroSensor->lowpassFilter[axis], gyroADCf);
-            gyroADCf = gyroSensor->lowpass2FilterApplyFn((filter_t *)&gyroSensor->lowpass2Filter[axis], gyroADCf);
-            // DEBUG_GYRO_FILTERED records the scaled, filtered, after all software filtering has been applied.
-            DEBUG_SET(DEBUG_GYRO_FILTERED, axis, lrintf(gyroADCf));
-
-            gyroSensor->gyroDev.gyroADCf[axis] = gyroADCf;
-            if (!gyroSensor->overflowDetected) {
-                // integrate using trapezium rule to avoid bias
-                accumulatedMeasurements[axis] += 0.5f * (gyroPrevious[axis] + gyroADCf) * sampleDeltaUs;
-                gyroPrevious[axis] = gyroADCf;
-            }
         }
+        health->score = constrain(health->score + change, 0, GYRO_HEALTH_EXCLUDE);
+
+        if (!health->excluded && health->score >= GYRO_HEALTH_EXCLUDE && includedCount > 1) {
+            health->excluded = true;
+            includedCount--;
+        } else if (health->excluded && health->score <= GYRO_HEALTH_READMIT) {
+            health->excluded = false;
+            includedCount++;
+        }
+        excludedMask |= health->excluded << i;
     }
+    DEBUG_SET(DEBUG_DUAL_GYRO_DIFF, 3, excludedMask);
 }
 
+// The gyros sample on their own clocks, so gyro 2 is moved to the sample time of gyro 1 along its
+// own slope before the gyros vote on each axis. The gyros that disagree with the vote lose health.
+static FAST_CODE void gyroFuse(void)
+{
+    if (gyroSensor2.filteredSampleTimeUs != gyroFusion.gyro2TimeUs) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            gyroFusion.gyro2Previous[axis] = gyroFusion.gyro2[axis];
+            gyroFusion.gyro2[axis] = gyroSensor2.gyroDev.gyroADCf[axis];
+        }
+        gyroFusion.gyro2PreviousTimeUs = gyroFusion.gyro2TimeUs;
+        gyroFusion.gyro2TimeUs = gyroSensor2.filteredSampleTimeUs;
+    }
+
+    const timeDelta_t gyro2PeriodUs = cmpTimeUs(gyroFusion.gyro2TimeUs, gyroFusion.gyro2PreviousTimeUs);
+    const timeDelta_t offsetUs = cmpTimeUs(gyroSensor1.filteredSampleTimeUs, gyroFusion.gyro2TimeUs);
+    // never extrapolate further than one sample
+    const float slopeScale = gyro2PeriodUs > 0 ? constrainf((float)offsetUs / gyro2PeriodUs, -1.0f, 1.0f) : 0.0f;
+    const float outlierThreshold = gyroRuntimeConfig.dualOutlierDps;
+
+    float sample[GYRO_SENSOR_COUNT][XYZ_AXIS_COUNT];
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        sample[0][axis] = gyroSensor1.gyroDev.gyroADCf[axis];
+        sample[1][axis] = gyroFusion.gyro2[axis] + (gyroFusion.gyro2[axis] - gyroFusion.gyro2Previous[axis]) * slopeScale;
+        DEBUG_SET(DEBUG_DUAL_GYRO_DIFF, axis, lrintf(sample[0][axis] - sample[1][axis]));
+    }
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyro.gyroADCf[axis] = gyroVoteAxis(sample, axis, outlierThreshold);
+    }
+    gyroUpdateHealth(sample, outlierThreshold);
+}
+#endif
+
 FAST_CODE void gyroUpdate(timeUs_t currentTimeUs)
 {
+    if (__atomic_load_n(&gyroFiltersPending, __ATOMIC_ACQUIRE)) {
+        gyroApplyPendingFilters();
+    }
+
 #ifdef USE_DUAL_GYRO
     switch (gyroToUse) {
     case GYRO_CONFIG_USE_GYRO_1:
@@ -1146,9 +2089,13 @@ FAST_CODE void gyroUpdate(timeUs_t currentTimeUs)
         gyroUpdateSensor(&gyroSensor1, currentTimeUs);
         gyroUpdateSensor(&gyroSensor2, currentTimeUs);
         if (isGyroSensorCalibrationComplete(&gyroSensor1) && isGyroSensorCalibrationComplete(&gyroSensor2)) {
-            gyro.gyroADCf[X] = (gyroSensor1.gyroDev.gyroADCf[X] + gyroSensor2.gyroDev.gyroADCf[X]) / 2.0f;
-            gyro.gyroADCf[Y] = (gyroSensor1.gyroDev.gyroADCf[Y] + gyroSensor2.gyroDev.gyroADCf[Y]) / 2.0f;
-            gyro.gyroADCf[Z] = (gyroSensor1.gyroDev.gyroADCf[Z] + gyroSensor2.gyroDev.gyroADCf[Z]) / 2.0f;
+            if (gyroRuntimeConfig.dualFusion) {
+                gyroFuse();
+            } else {
+                gyro.gyroADCf[X] = (gyroSensor1.gyroDev.gyroADCf[X] + gyroSensor2.gyroDev.gyroADCf[X]) / 2.0f;
+                gyro.gyroADCf[Y] = (gyroSensor1.gyroDev.gyroADCf[Y] + gyroSensor2.gyroDev.gyroADCf[Y]) / 2.0f;
+                gyro.gyroADCf[Z] = (gyroSensor1.gyroDev.gyroADCf[Z] + gyroSensor2.gyroDev.gyroADCf[Z]) / 2.0f;
+            }
         }
         DEBUG_SET(DEBUG_DUAL_GYRO_RAW, 0, gyroSensor1.gyroDev.gyroADCRaw[X]);
         DEBUG_SET(DEBUG_DUAL_GYRO_RAW, 1, gyroSensor1.gyroDev.gyroADCRaw[Y]);
@@ -1160,9 +2107,12 @@ FAST_CODE void gyroUpdate(timeUs_t currentTimeUs)
         DEBUG_SET(DEBUG_DUAL_GYRO, 3, lrintf(gyroSensor2.gyroDev.gyroADCf[Y]));
         DEBUG_SET(DEBUG_DUAL_GYRO_COMBINE, 1, lrintf(gyro.gyroADCf[X]));
         DEBUG_SET(DEBUG_DUAL_GYRO_COMBINE, 2, lrintf(gyro.gyroADCf[Y]));
-        DEBUG_SET(DEBUG_DUAL_GYRO_DIFF, 0, lrintf(gyroSensor1.gyroDev.gyroADCf[X] - gyroSensor2.gyroDev.gyroADCf[X]));
-        DEBUG_SET(DEBUG_DUAL_GYRO_DIFF, 1, lrintf(gyroSensor1.gyroDev.gyroADCf[Y] - gyroSensor2.gyroDev.gyroADCf[Y]));
-        DEBUG_SET(DEBUG_DUAL_GYRO_DIFF, 2, lrintf(gyroSensor1.gyroDev.gyroADCf[Z] - gyroSensor2.gyroDev.gyroADCf[Z]));
+        if (!gyroRuntimeConfig.dualFusion) {
+            // gyroFuse() records the time aligned difference
+            DEBUG_SET(DEBUG_DUAL_GYRO_DIFF, 0, lrintf(gyroSensor1.gyroDev.gyroADCf[X] - gyroSensor2.gyroDev.gyroADCf[X]));
+            DEBUG_SET(DEBUG_DUAL_GYRO_DIFF, 1, lrintf(gyroSensor1.gyroDev.gyroADCf[Y] - gyroSensor2.gyroDev.gyroADCf[Y]));
+            DEBUG_SET(DEBUG_DUAL_GYRO_DIFF, 2, lrintf(gyroSensor1.gyroDev.gyroADCf[Z] - gyroSensor2.gyroDev.gyroADCf[Z]));
+        }
         break;
     }
 #else
@@ -1173,15 +2123,77 @@ FAST_CODE void gyroUpdate(timeUs_t currentTimeUs)
 #endif
 }
 
+const gyroSampleRing_t *gyroSampleRing(void)
+{
+#ifdef USE_DUAL_GYRO
+    if (gyroToUse == GYRO_CONFIG_USE_GYRO_2) {
+        return &gyroSensor2.sampleRing;
+    }
+#endif
+    return &gyroSensor1.sampleRing;
+}
+
+// a new reader starts with the next sample written
+void gyroSampleReaderInit(gyroSampleReader_t *reader, const gyroSampleRing_t *ring)
+{
+    reader->ring = ring;
+    reader->readCount = ring->writeCount;
+    reader->missedCount = 0;
+}
+
+// Copies up to maxCount of the oldest unread samples and returns how many were copied. Samples the gyro
+// overwrote before they could be copied are skipped and counted in missedCount. The gyro can
+// preempt the reader, so the copies are checked against the write position once they are done.
+FAST_CODE unsigned gyroSampleRead(gyroSampleReader_t *reader, gyroSample_t *samples, unsigned maxCount)
+{
+    const gyroSampleRing_t *ring = reader->ring;
+
+    uint32_t unread = ring->writeCount - reader->readCount;
+    if (unread > GYRO_SAMPLE_RING_SIZE) {
+        reader->missedCount += unread - GYRO_SAMPLE_RING_SIZE;
+        reader->readCount += unread - GYRO_SAMPLE_RING_SIZE;
+        unread = GYRO_SAMPLE_RING_SIZE;
+    }
+
+    unsigned count = MIN(unread, maxCount);
+    for (unsigned i = 0; i < count; i++) {
+        samples[i] = ring->sample[(reader->readCount + i) & (GYRO_SAMPLE_RING_SIZE - 1)];
+    }
+    asm volatile ("": : :"memory");
+
+    // the slot of the sample being written may already be partly overwritten as well
+    const int32_t overwritten = (int32_t)(ring->writeCount + 1 - GYRO_SAMPLE_RING_SIZE - reader->readCount);
+    if (overwritten > 0) {
+        const unsigned dropped = MIN((unsigned)overwritten, count);
+        memmove(samples, &samples[dropped], (count - dropped) * sizeof(gyroSample_t));
+        reader->missedCount += dropped;
+        reader->readCount += dropped;
+        count -= dropped;
+    }
+    reader->readCount += count;
+
+    return count;
+}
+
 bool gyroGetAccumulationAverage(float *accumulationAverage)
 {
-    if (accumulatedMeasurementTimeUs > 0) {
-        // If we have gyro data accumulated, calculate average rate that will yield the same rotation
+    float measurements[XYZ_AXIS_COUNT];
+    timeUs_t measurementTimeUs;
+    // a preemptive PID loop keeps adding samples, take them and start over in one go
+    SWI_ATOMIC_BLOCK {
+        measurementTimeUs = accumulatedMeasurementTimeUs;
         for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            accumulationAverage[axis] = accumulatedMeasurements[axis] / accumulatedMeasurementTimeUs;
+            measurements[axis] = accumulatedMeasurements[axis];
             accumulatedMeasurements[axis] = 0.0f;
         }
         accumulatedMeasurementTimeUs = 0;
+    }
+
+    if (measurementTimeUs > 0) {
+        // If we have gyro data accumulated, calculate average rate that will yield the same rotation
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            accumulationAverage[axis] = measurements[axis] / measurementTimeUs;
+        }
         return true;
     } else {
         for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
@@ -1191,11 +2203,12 @@ bool gyroGetAccumulationAverage(float *accumulationAverage)
     }
 }
 
-void gyroReadTemperature(void)
+bool gyroReadTemperature(void)
 {
     if (gyroSensor1.gyroDev.temperatureFn) {
-        gyroSensor1.gyroDev.temperatureFn(&gyroSensor1.gyroDev, &gyroSensor1.gyroDev.temperature);
+        return gyroSensor1.gyroDev.temperatureFn(&gyroSensor1.gyroDev, &gyroSensor1.gyroDev.temperature);
     }
+    return false;
 }
 
 int16_t gyroGetTemperature(void)
@@ -1203,6 +2216,150 @@ int16_t gyroGetTemperature(void)
     return gyroSensor1.gyroDev.temperature;
 }
 
+#ifdef USE_GYRO_TEMP_COMP
+#define GYRO_TEMP_COMP_WINDOW_US    1000000 // the zero offset is learned from one second of still samples
+#define GYRO_TEMP_COMP_LEARN_RATE   0.1f
+
+// zero offset at the given temperature, interpolated between the two neighbouring table points
+static bool gyroTempCompBias(int16_t temperature, float *bias)
+{
+    const int offset = temperature - GYRO_TEMP_COMP_MIN_TEMPERATURE;
+    if (offset < 0 || offset > (GYRO_TEMP_COMP_POINTS - 1) * GYRO_TEMP_COMP_STEP) {
+        return false;
+    }
+    const int point = MIN(offset / GYRO_TEMP_COMP_STEP, GYRO_TEMP_COMP_POINTS - 2);
+    const float fraction = (float)(offset - point * GYRO_TEMP_COMP_STEP) / GYRO_TEMP_COMP_STEP;
+    const uint16_t learnedMask = gyroTempCompConfig()->learnedMask;
+    if ((fraction < 1.0f && !(learnedMask & (1 << point))) || (fraction > 0.0f && !(learnedMask & (1 << (point + 1))))) {
+        return false;
+    }
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        const float lower = gyroTempCompConfig()->bias[point][axis];
+        const float upper = gyroTempCompConfig()->bias[point + 1][axis];
+        bias[axis] = (lower + (upper - lower) * fraction) / GYRO_TEMP_COMP_SCALE;
+    }
+    return true;
+}
+
+// Moves the table point nearest to the temperature towards the zero offset just measured
+static void gyroTempCompLearn(int16_t temperature, const float *zero)
+{
+    const int offset = temperature - GYRO_TEMP_COMP_MIN_TEMPERATURE + GYRO_TEMP_COMP_STEP / 2;
+    if (offset < 0 || offset >= GYRO_TEMP_COMP_POINTS * GYRO_TEMP_COMP_STEP) {
+        return;
+    }
+    const int point = offset / GYRO_TEMP_COMP_STEP;
+    gyroTempCompConfig_t *config = gyroTempCompConfigMutable();
+    const bool learned = config->learnedMask & (1 << point);
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        const float bias = zero[axis] * GYRO_TEMP_COMP_SCALE;
+        if (learned) {
+            config->bias[point][axis] += lrintf((bias - config->bias[point][axis]) * GYRO_TEMP_COMP_LEARN_RATE);
+        } else {
+            config->bias[point][axis] = constrain(lrintf(bias), INT16_MIN, INT16_MAX);
+        }
+    }
+    config->learnedMask |= 1 << point;
+}
+
+// Runs from a low rate task. The gyro loop only sums the raw samples of the first gyro while disarmed,
+// every GYRO_TEMP_COMP_WINDOW_US the window is checked for movement and, if still, learned into the
+// table. The table is only changed in RAM, it is stored with the next save of the configuration.
+// The zero offset change since calibration is interpolated from the table and applied by the
+// gyro loop as a plain offset.
+void gyroTempCompUpdate(timeUs_t currentTimeUs)
+{
+    if (!gyroTempCompConfig()->enabled || !gyroSensor1.gyroDev.temperatureFn) {
+        gyroTempComp.learning = false;
+        return;
+    }
+    if (cmpTimeUs(currentTimeUs, gyroTempComp.windowStartUs) < GYRO_TEMP_COMP_WINDOW_US) {
+        return;
+    }
+    gyroTempComp.windowStartUs = currentTimeUs;
+    if (!gyroReadTemperature()) {
+        // the SPI drivers only have a temperature once the burst reads are running
+        gyroTempComp.learning = false;
+        return;
+    }
+    const int16_t temperature = gyroSensor1.gyroDev.temperature;
+
+    if (gyroTempComp.calibrationTemperaturePending) {
+        gyroTempComp.calibrationTemperaturePending = false;
+        gyroTempComp.calibrationTemperature = temperature;
+        gyroTempComp.calibrationTemperatureValid = true;
+    }
+
+    if (gyroTempComp.learning && gyroTempComp.count && !ARMING_FLAG(ARMED)) {
+        const float movementThreshold = gyroConfig()->gyroMovementCalibrationThreshold;
+        bool still = true;
+        float zero[XYZ_AXIS_COUNT];
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            zero[axis] = gyroTempComp.sum[axis] / gyroTempComp.count;
+            const float variance = gyroTempComp.sumSquares[axis] / gyroTempComp.count - sq(zero[axis]);
+            if (variance > sq(movementThreshold)) {
+                still = false;
+            }
+        }
+        if (still) {
+            gyroTempCompLearn(temperature, zero);
+        }
+    }
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyroTempComp.sum[axis] = 0.0f;
+        gyroTempComp.sumSquares[axis] = 0.0f;
+    }
+    gyroTempComp.count = 0;
+    gyroTempComp.learning = !ARMING_FLAG(ARMED) && isGyroSensorCalibrationComplete(&gyroSensor1);
+
+    float bias[XYZ_AXIS_COUNT];
+    float calibrationBias[XYZ_AXIS_COUNT];
+    const bool compensated = gyroTempComp.calibrationTemperatureValid
+        && gyroTempCompBias(temperature, bias)
+        && gyroTempCompBias(gyroTempComp.calibrationTemperature, calibrationBias);
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyroTempComp.offset[axis] = compensated ? bias[axis] - calibrationBias[axis] : 0.0f;
+    }
+}
+
+// Sets the zero offset from the table instead of calibrating, when the table covers the current temperature
+bool gyroTempCompSetZero(void)
+{
+    if (!gyroTempCompConfig()->enabled || !gyroSensor1.gyroDev.temperatureFn) {
+        return false;
+    }
+#ifdef USE_DUAL_GYRO
+    if (gyroToUse != GYRO_CONFIG_USE_GYRO_1) {
+        return false;
+    }
+#endif
+    if (!gyroReadTemperature()) {
+        return false;
+    }
+    const int16_t temperature = gyroSensor1.gyroDev.temperature;
+    float bias[XYZ_AXIS_COUNT];
+    if (!gyroTempCompBias(temperature, bias)) {
+        return false;
+    }
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyroSetZero(&gyroSensor1, axis, bias[axis]);
+    }
+    gyroSensor1.calibration.cyclesRemaining = 0;
+    gyroCalibrationCompleted();
+    return true;
+}
+#else
+void gyroTempCompUpdate(timeUs_t currentTimeUs)
+{
+    UNUSED(currentTimeUs);
+}
+
+bool gyroTempCompSetZero(void)
+{
+    return false;
+}
+#endif // USE_GYRO_TEMP_COMP
+
 int16_t gyroRateDps(int axis)
 {
 #ifdef USE_DUAL_GYRO
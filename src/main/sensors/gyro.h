@@ -52,6 +52,26 @@ typedef struct gyro_s {
 
 extern gyro_t gyro;
 
+#define GYRO_SAMPLE_RING_SIZE 32  // must be a power of two, readers must keep up to within this many samples
+
+typedef struct gyroSample_s {
+    uint32_t timeUs;
+    float raw[XYZ_AXIS_COUNT];      // calibrated and aligned sensor counts, as gyroDev.gyroADC
+    float filtered[XYZ_AXIS_COUNT]; // deg/s after all filters, as gyroDev.gyroADCf
+} gyroSample_t;
+
+// written by the gyro only, every reader keeps its own position
+typedef struct gyroSampleRing_s {
+    gyroSample_t sample[GYRO_SAMPLE_RING_SIZE];
+    volatile uint32_t writeCount;
+} gyroSampleRing_t;
+
+typedef struct gyroSampleReader_s {
+    const gyroSampleRing_t *ring;
+    uint32_t readCount;
+    uint32_t missedCount;           // samples overwritten before they were read
+} gyroSampleReader_t;
+
 typedef enum {
     GYRO_OVERFLOW_CHECK_NONE = 0,
     GYRO_OVERFLOW_CHECK_YAW,
@@ -96,25 +116,63 @@ typedef struct gyroConfig_s {
     int16_t  yaw_spin_threshold;
 
     uint16_t gyroCalibrationDuration;  // Gyro calibration duration in 1/100 second
+
+    uint8_t  gyro_filter_bank;         // apply the static notch and lowpass filters to all axes together
+    uint8_t  gyro_32khz_decimation;    // run calibration and filters behind a decimator at the PID loop rate when sampling at 32kHz
+    uint8_t  dyn_notch_count;          // number of spectral peaks per axis tracked by the dynamic notch filter
+    uint8_t  dyn_notch_estimator;      // spectral estimator driving the dynamic notch, see dynNotchEstimator_e
+    uint8_t  gyro_use_fifo;            // sample into the gyro FIFO at the full rate and decimate by gyro_sync_denom when reading it
+    uint8_t  gyro_dual_fusion;         // time align the two gyros, vote and leave out a failing gyro instead of a plain average
+    uint16_t gyro_dual_outlier_dps;    // difference between the gyros above which an axis follows one gyro only, 0 disables
+    uint8_t  gyro_fast_calibration;    // end calibration as soon as the zero offset is known well enough, with gyro_calib_duration as the limit
+    uint16_t gyro_overflow_check_us;   // interval of the overflow and yaw spin checks, the worst case detection delay
 } gyroConfig_t;
 
 PG_DECLARE(gyroConfig_t, gyroConfig);
 
+#define GYRO_TEMP_COMP_POINTS           12
+#define GYRO_TEMP_COMP_MIN_TEMPERATURE  10  // degrees C of the first table point
+#define GYRO_TEMP_COMP_STEP             5   // degrees C between the table points
+#define GYRO_TEMP_COMP_SCALE            16  // the bias is stored in 1/16 sensor counts
+
+typedef struct gyroTempCompConfig_s {
+    uint8_t  enabled;
+    uint16_t learnedMask;                                      // bit n is set once point n has been learned
+    int16_t  bias[GYRO_TEMP_COMP_POINTS][XYZ_AXIS_COUNT];      // zero offset of the first gyro at each table temperature
+} gyroTempCompConfig_t;
+
+PG_DECLARE(gyroTempCompConfig_t, gyroTempCompConfig);
+
 bool gyroInit(void);
 
 void gyroInitFilters(void);
+bool gyroReconfigureFilters(void);
+uint32_t gyroFilterLooptime(void);
+#ifdef USE_GYRO_DECIMATION
+void gyroSetDecimation(uint8_t ratio);
+bool gyroIsDecimating(void);
+bool gyroDecimatedSampleAvailable(void);
+#endif
 void gyroUpdate(timeUs_t currentTimeUs);
+const gyroSampleRing_t *gyroSampleRing(void);
+void gyroSampleReaderInit(gyroSampleReader_t *reader, const gyroSampleRing_t *ring);
+unsigned gyroSampleRead(gyroSampleReader_t *reader, gyroSample_t *samples, unsigned maxCount);
 bool gyroGetAccumulationAverage(float *accumulation);
 const busDevice_t *gyroSensorBus(void);
 struct mpuConfiguration_s;
 const struct mpuConfiguration_s *gyroMpuConfiguration(void);
 struct mpuDetectionResult_s;
 const struct mpuDetectionResult_s *gyroMpuDetectionResult(void);
+timeUs_t gyroGetSampleTimeUs(void);
+bool gyroHasDataReadyInterrupt(void);
+bool gyroSetDataReadyCallback(void (*callback)(void));
 void gyroStartCalibration(bool isFirstArmingCalibration);
 bool isFirstArmingGyroCalibrationRunning(void);
 bool isGyroCalibrationComplete(void);
-void gyroReadTemperature(void);
+bool gyroReadTemperature(void);
 int16_t gyroGetTemperature(void);
+void gyroTempCompUpdate(timeUs_t currentTimeUs);
+bool gyroTempCompSetZero(void);
 int16_t gyroRateDps(int axis);
 bool gyroOverflowDetected(void);
 bool gyroYawSpinDetected(void);
@@ -53,11 +53,25 @@
 #define DYN_NOTCH_CHANGERATE  60  // lower cut does not improve the performance much, higher cut makes it worse...
 #define DYN_NOTCH_MIN_CUTOFF  120  // don't cut too deep into low frequencies
 #define DYN_NOTCH_MAX_CUTOFF  200  // don't go above this cutoff (better filtering with "constant" delay at higher center frequencies)
-#define DYN_NOTCH_CALC_TICKS  (XYZ_AXIS_COUNT * 4) // we need 4 steps for each axis
+#define DYN_NOTCH_CALC_STEPS  4  // we need 4 steps for each axis, plus one for each further notch
 
 #define BIQUAD_Q 1.0f / sqrtf(2.0f)         // quality factor - butterworth
 
+// the sliding DFT keeps the bins from FFT_MIN_FREQ up, plus one on either side for the windowing
+#define SDFT_BIN_MIN          (FFT_MIN_FREQ * FFT_WINDOW_SIZE / FFT_SAMPLING_RATE)
+#define SDFT_BIN_COUNT        (FFT_BIN_COUNT - SDFT_BIN_MIN + 2)
+#define SDFT_DAMPING          0.9999f  // keeps the recursion stable against rounding errors
+
 static FAST_RAM_ZERO_INIT uint16_t fftSamplingScale;
+static FAST_RAM_ZERO_INIT uint32_t analyseLooptimeUs;   // interval between the samples read by gyroDataAnalyse()
+static FAST_RAM_ZERO_INIT uint8_t dynNotchCount;
+static FAST_RAM_ZERO_INIT uint8_t dynNotchCalcTicks;
+static FAST_RAM_ZERO_INIT uint32_t gyroDataAnalyseUpdateTicks; // update steps left for the newest 1kHz sample
+static FAST_RAM_ZERO_INIT bool useSdft;
+
+// D term notches following the same peaks, see gyroDataAnalyseSetDtermNotch()
+static FAST_RAM_ZERO_INIT biquadFilter_t (*dtermNotchFilterDyn)[XYZ_AXIS_COUNT];
+static FAST_RAM_ZERO_INIT uint32_t dtermLooptimeUs;
 
 // gyro data used for frequency analysis
 static float FAST_RAM_ZERO_INIT gyroData[XYZ_AXIS_COUNT][FFT_WINDOW_SIZE];
@@ -66,6 +80,9 @@ static FAST_RAM_ZERO_INIT arm_rfft_fast_instance_f32 fftInstance;
 static FAST_RAM_ZERO_INIT float fftData[FFT_WINDOW_SIZE];
 static FAST_RAM_ZERO_INIT float rfftData[FFT_WINDOW_SIZE];
 static FAST_RAM_ZERO_INIT gyroFftData_t fftResult[XYZ_AXIS_COUNT];
+// magnitudes of the last window analysed on each axis, only read by MSP
+static uint16_t fftSpectrum[XYZ_AXIS_COUNT][FFT_BIN_COUNT];
+static timeUs_t fftSpectrumRequestedAtUs;
 
 // use a circular buffer for the last FFT_WINDOW_SIZE samples
 static FAST_RAM_ZERO_INIT uint16_t fftIdx;
@@ -74,7 +91,14 @@ static FAST_RAM_ZERO_INIT uint16_t fftIdx;
 static FAST_RAM_ZERO_INIT biquadFilter_t fftGyroFilter[XYZ_AXIS_COUNT];
 
 // filter for smoothing frequency estimation
-static FAST_RAM_ZERO_INIT biquadFilter_t fftFreqFilter[XYZ_AXIS_COUNT];
+static FAST_RAM_ZERO_INIT biquadFilter_t fftFreqFilter[DYN_NOTCH_COUNT_MAX][XYZ_AXIS_COUNT];
+
+// sliding DFT state, bin i holds frequency bin SDFT_BIN_MIN - 1 + i
+static FAST_RAM_ZERO_INIT float sdftRe[XYZ_AXIS_COUNT][SDFT_BIN_COUNT];
+static FAST_RAM_ZERO_INIT float sdftIm[XYZ_AXIS_COUNT][SDFT_BIN_COUNT];
+static FAST_RAM_ZERO_INIT float sdftTwiddleRe[SDFT_BIN_COUNT];
+static FAST_RAM_ZERO_INIT float sdftTwiddleIm[SDFT_BIN_COUNT];
+static FAST_RAM_ZERO_INIT float sdftDampingN;   // SDFT_DAMPING ^ FFT_WINDOW_SIZE
 
 // Hanning window, see https://en.wikipedia.org/wiki/Window_function#Hann_.28Hanning.29_window
 static FAST_RAM_ZERO_INIT float hanningWindow[FFT_WINDOW_SIZE];
@@ -95,8 +119,31 @@ void initGyroData(void)
     }
 }
 
+static void initSdft(void)
+{
+    for (int i = 0; i < SDFT_BIN_COUNT; i++) {
+        const float angle = 2 * M_PIf * (SDFT_BIN_MIN - 1 + i) / FFT_WINDOW_SIZE;
+        sdftTwiddleRe[i] = SDFT_DAMPING * cos_approx(angle);
+        sdftTwiddleIm[i] = SDFT_DAMPING * sin_approx(angle);
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            sdftRe[axis][i] = 0;
+            sdftIm[axis][i] = 0;
+        }
+    }
+    sdftDampingN = 1;
+    for (int i = 0; i < FFT_WINDOW_SIZE; i++) {
+        sdftDampingN *= SDFT_DAMPING;
+    }
+}
+
 void gyroDataAnalyseInit(uint32_t targetLooptimeUs)
 {
+    analyseLooptimeUs = targetLooptimeUs;
+    dynNotchCount = constrain(gyroConfig()->dyn_notch_count, 1, DYN_NOTCH_COUNT_MAX);
+    useSdft = (gyroConfig()->dyn_notch_estimator == DYN_NOTCH_ESTIMATOR_SDFT);
+    // the sliding DFT needs one step for the frequencies of each axis and one for each notch
+    dynNotchCalcTicks = XYZ_AXIS_COUNT * (useSdft ? 1 + dynNotchCount : DYN_NOTCH_CALC_STEPS + dynNotchCount - 1);
+
     // initialise even if FEATURE_DYNAMIC_FILTER not set, since it may be set later
     const uint16_t samplingFrequency = 1000000 / targetLooptimeUs;
     fftSamplingScale = samplingFrequency / FFT_SAMPLING_RATE;
@@ -104,14 +151,17 @@ void gyroDataAnalyseInit(uint32_t targetLooptimeUs)
 
     initGyroData();
     initHanning();
+    initSdft();
 
-    // recalculation of filters takes 4 calls per axis => each filter gets updated every DYN_NOTCH_CALC_TICKS calls
-    // at 4khz gyro loop rate this means 4khz / 4 / 3 = 333Hz => update every 3ms
+    // recalculation of filters takes 4 calls per axis (one more per extra notch) => each filter gets updated every dynNotchCalcTicks calls
+    // at 4khz gyro loop rate with one notch this means 4khz / 4 / 3 = 333Hz => update every 3ms
     // for gyro rate > 16kHz, we have update frequency of 1kHz => 1ms
-    const float looptime = MAX(1000000u / FFT_SAMPLING_RATE, targetLooptimeUs * DYN_NOTCH_CALC_TICKS);
+    const float looptime = MAX(1000000u / FFT_SAMPLING_RATE, targetLooptimeUs * dynNotchCalcTicks);
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-        fftResult[axis].centerFreq = 200; // any init value
-        biquadFilterInitLPF(&fftFreqFilter[axis], DYN_NOTCH_CHANGERATE, looptime);
+        for (int peak = 0; peak < DYN_NOTCH_COUNT_MAX; peak++) {
+            fftResult[axis].centerFreq[peak] = 200 + peak * 100; // any ascending init value
+            biquadFilterInitLPF(&fftFreqFilter[peak][axis], DYN_NOTCH_CHANGERATE, looptime);
+        }
         biquadFilterInit(&fftGyroFilter[axis], FFT_BPF_HZ, 1000000 / FFT_SAMPLING_RATE, BIQUAD_Q, FILTER_BPF);
     }
 }
@@ -122,20 +172,72 @@ const gyroFftData_t *gyroFftData(int axis)
     return &fftResult[axis];
 }
 
+// Keeps the analysis running for GYRO_SPECTRUM_HOLD_US after a request, so the spectrum can be
+// watched with the dynamic filter off
+void gyroSpectrumRequest(timeUs_t currentTimeUs)
+{
+    fftSpectrumRequestedAtUs = currentTimeUs;
+}
+
+bool gyroSpectrumRequested(timeUs_t currentTimeUs)
+{
+    if (fftSpectrumRequestedAtUs && cmpTimeUs(currentTimeUs, fftSpectrumRequestedAtUs) >= GYRO_SPECTRUM_HOLD_US) {
+        fftSpectrumRequestedAtUs = 0;
+    }
+    return fftSpectrumRequestedAtUs != 0;
+}
+
+void gyroSpectrumGet(int axis, gyroSpectrum_t *spectrum)
+{
+    spectrum->binCount = FFT_BIN_COUNT;
+    spectrum->binWidth = lrintf(FFT_RESOLUTION * 100);
+    spectrum->magnitude = fftSpectrum[axis];
+}
+
+/*
+ * Slide the DFT window on by one sample, constant cost for each sample
+ */
+static FAST_CODE void sdftPush(int axis, float sample, float oldestSample)
+{
+    const float delta = sample - sdftDampingN * oldestSample;
+    for (int i = 0; i < SDFT_BIN_COUNT; i++) {
+        const float re = sdftRe[axis][i] + delta;
+        const float im = sdftIm[axis][i];
+        sdftRe[axis][i] = re * sdftTwiddleRe[i] - im * sdftTwiddleIm[i];
+        sdftIm[axis][i] = re * sdftTwiddleIm[i] + im * sdftTwiddleRe[i];
+    }
+}
+
+/*
+ * Store the hanning windowed magnitudes of the sliding DFT in fftData, as STEP_ARM_CMPLX_MAG_F32 does for the FFT
+ */
+static void sdftMagnitudes(int axis)
+{
+    for (int i = 0; i < FFT_BIN_COUNT; i++) {
+        fftData[i] = 0;
+    }
+    // the window is applied as a convolution in the frequency domain
+    for (int i = 1; i < SDFT_BIN_COUNT - 1; i++) {
+        const float re = 0.5f * sdftRe[axis][i] - 0.25f * (sdftRe[axis][i - 1] + sdftRe[axis][i + 1]);
+        const float im = 0.5f * sdftIm[axis][i] - 0.25f * (sdftIm[axis][i - 1] + sdftIm[axis][i + 1]);
+        fftData[SDFT_BIN_MIN - 1 + i] = sqrtf(re * re + im * im);
+    }
+}
+
+static void gyroDataAnalyseSdftUpdate(biquadFilter_t notchFilterDyn[][XYZ_AXIS_COUNT]);
+
 /*
  * Collect gyro data, to be analysed in gyroDataAnalyseUpdate function
  */
-void gyroDataAnalyse(const gyroDev_t *gyroDev, biquadFilter_t *notchFilterDyn)
+static FAST_CODE void gyroDataAnalyseSample(const gyroDev_t *gyroDev, const float *raw)
 {
     // accumulator for oversampled data => no aliasing and less noise
     static FAST_RAM_ZERO_INIT float fftAcc[XYZ_AXIS_COUNT];
     static FAST_RAM_ZERO_INIT uint32_t fftAccCount;
 
-    static FAST_RAM_ZERO_INIT uint32_t gyroDataAnalyseUpdateTicks;
-
     // if gyro sampling is > 1kHz, accumulate multiple samples
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-        fftAcc[axis] += gyroDev->gyroADC[axis];
+        fftAcc[axis] += raw[axis];
     }
     fftAccCount++;
 
@@ -147,6 +249,10 @@ void gyroDataAnalyse(const gyroDev_t *gyroDev, biquadFilter_t *notchFilterDyn)
         for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
             float sample = fftAcc[axis] / fftSamplingScale;
             sample = biquadFilterApply(&fftGyroFilter[axis], sample);
+            if (useSdft) {
+                // the ring buffer still holds the sample that leaves the window
+                sdftPush(axis, sample, gyroData[axis][fftIdx]);
+            }
             gyroData[axis][fftIdx] = sample;
             if (axis == 0)
                 DEBUG_SET(DEBUG_FFT, 2, lrintf(sample * gyroDev->scale));
@@ -155,13 +261,29 @@ void gyroDataAnalyse(const gyroDev_t *gyroDev, biquadFilter_t *notchFilterDyn)
 
         fftIdx = (fftIdx + 1) % FFT_WINDOW_SIZE;
 
-        // We need DYN_NOTCH_CALC_TICKS tick to update all axis with newly sampled value
-        gyroDataAnalyseUpdateTicks = DYN_NOTCH_CALC_TICKS;
+        // We need dynNotchCalcTicks tick to update all axis with newly sampled value
+        gyroDataAnalyseUpdateTicks = dynNotchCalcTicks;
+    }
+}
+
+// takes the new samples from the gyro sample ring, then does one step of the spectrum and notch update
+void gyroDataAnalyse(const gyroDev_t *gyroDev, gyroSampleReader_t *reader, biquadFilter_t notchFilterDyn[][XYZ_AXIS_COUNT])
+{
+    gyroSample_t samples[4];
+    unsigned count;
+    while ((count = gyroSampleRead(reader, samples, ARRAYLEN(samples))) > 0) {
+        for (unsigned i = 0; i < count; i++) {
+            gyroDataAnalyseSample(gyroDev, samples[i].raw);
+        }
     }
 
     // calculate FFT and update filters
     if (gyroDataAnalyseUpdateTicks > 0) {
-        gyroDataAnalyseUpdate(notchFilterDyn);
+        if (useSdft) {
+            gyroDataAnalyseSdftUpdate(notchFilterDyn);
+        } else {
+            gyroDataAnalyseUpdate(notchFilterDyn);
+        }
         --gyroDataAnalyseUpdateTicks;
     }
 }
@@ -183,13 +305,171 @@ typedef enum {
     STEP_COUNT
 } UpdateStep_e;
 
+/*
+ * Find the dynNotchCount highest local maxima of the spectrum in fftData, store their
+ * interpolated bin index in peakIndex in ascending order and return how many were found
+ */
+static int findSpectralPeaks(float *peakIndex)
+{
+    int peakBin[DYN_NOTCH_COUNT_MAX];
+    int peakCount = 0;
+
+    // a peak needs a bin on either side for the interpolation
+    for (int i = MAX(1, (int)(FFT_MIN_FREQ / FFT_RESOLUTION)); i < FFT_BIN_COUNT - 1; i++) {
+        if (fftData[i] <= fftData[i - 1] || fftData[i] < fftData[i + 1]) {
+            continue;
+        }
+        // insert into the peaks found so far, highest first
+        int pos = peakCount;
+        while (pos > 0 && fftData[peakBin[pos - 1]] < fftData[i]) {
+            if (pos < dynNotchCount) {
+                peakBin[pos] = peakBin[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < dynNotchCount) {
+            peakBin[pos] = i;
+            peakCount = MIN(peakCount + 1, dynNotchCount);
+        }
+    }
+
+    for (int peak = 0; peak < peakCount; peak++) {
+        // fit a parabola through the peak and its neighbours to get better resolution than one bin
+        const int i = peakBin[peak];
+        const float denom = fftData[i - 1] - 2 * fftData[i] + fftData[i + 1];
+        const float offset = (denom < 0) ? 0.5f * (fftData[i - 1] - fftData[i + 1]) / denom : 0;
+        peakIndex[peak] = i + constrainf(offset, -0.5f, 0.5f);
+    }
+
+    // sort by frequency, so each notch keeps following the same peak
+    for (int peak = 1; peak < peakCount; peak++) {
+        const float index = peakIndex[peak];
+        int pos = peak;
+        for (; pos > 0 && peakIndex[pos - 1] > index; pos--) {
+            peakIndex[pos] = peakIndex[pos - 1];
+        }
+        peakIndex[pos] = index;
+    }
+
+    return peakCount;
+}
+
+static void updateCenterFreq(int axis, int peak, float centerFreq)
+{
+    // don't go below the minimal cutoff frequency + 10 and don't jump around too much
+    centerFreq = constrain(centerFreq, DYN_NOTCH_MIN_CUTOFF + 10, FFT_MAX_FREQUENCY);
+    centerFreq = biquadFilterApply(&fftFreqFilter[peak][axis], centerFreq);
+    centerFreq = constrain(centerFreq, DYN_NOTCH_MIN_CUTOFF + 10, FFT_MAX_FREQUENCY);
+    fftResult[axis].centerFreq[peak] = centerFreq;
+}
+
+/*
+ * With fewer peaks found than notches each peak goes to the notch tracking the closest frequency,
+ * keeping the order, so a peak that drops out for a moment does not move the others to another notch
+ */
+static void updateCenterFreqs(int axis, const float *peakIndex, int peakCount)
+{
+    int notch = 0;
+    for (int peak = 0; peak < peakCount; peak++) {
+        const float peakFreq = peakIndex[peak] * FFT_RESOLUTION;
+        // leave a notch for each of the peaks still to come
+        const int lastNotch = dynNotchCount - (peakCount - peak);
+        while (notch < lastNotch && ABS(fftResult[axis].centerFreq[notch + 1] - peakFreq) < ABS(fftResult[axis].centerFreq[notch] - peakFreq)) {
+            notch++;
+        }
+        updateCenterFreq(axis, notch, peakFreq);
+        notch++;
+    }
+}
+
+/*
+ * Estimate the notch frequencies of an axis from the spectrum in fftData
+ */
+static void calculateFrequencies(int axis)
+{
+    float fftSum = 0;
+    float fftWeightedSum = 0;
+
+    for (int i = 0; i < FFT_BIN_COUNT; i++) {
+        fftSpectrum[axis][i] = lrintf(constrainf(fftData[i], 0, UINT16_MAX));
+    }
+
+    fftResult[axis].maxVal = 0;
+    // iterate over fft data and calculate weighted indexes
+    float squaredData;
+    for (int i = 0; i < FFT_BIN_COUNT; i++) {
+        squaredData = fftData[i] * fftData[i];  //more weight on higher peaks
+        fftResult[axis].maxVal = MAX(fftResult[axis].maxVal, squaredData);
+        fftSum += squaredData;
+        fftWeightedSum += squaredData * (i + 1); // calculate weighted index starting at 1, not 0
+    }
+
+    if (dynNotchCount > 1) {
+        // track each peak separately, peaks that are not found keep their last frequency
+        float peakIndex[DYN_NOTCH_COUNT_MAX];
+        const int peakCount = findSpectralPeaks(peakIndex);
+        updateCenterFreqs(axis, peakIndex, peakCount);
+        if (axis == 0 && peakCount > 0) {
+            DEBUG_SET(DEBUG_FFT, 3, lrintf(peakIndex[0] * 100));
+        }
+    } else if (fftSum > 0) {
+        // get weighted center of relevant frequency range (this way we have a better resolution than 31.25Hz)
+        // idx was shifted by 1 to start at 1, not 0
+        float fftMeanIndex = (fftWeightedSum / fftSum) - 1;
+        // the index points at the center frequency of each bin so index 0 is actually 16.125Hz
+        // fftMeanIndex += 0.5;
+
+        updateCenterFreq(axis, 0, fftMeanIndex * FFT_RESOLUTION);
+        if (axis == 0) {
+            DEBUG_SET(DEBUG_FFT, 3, lrintf(fftMeanIndex * 100));
+        }
+    }
+
+    DEBUG_SET(DEBUG_FFT_FREQ, axis, fftResult[axis].centerFreq[0]);
+}
+
+static void updateDynNotch(biquadFilter_t notchFilterDyn[][XYZ_AXIS_COUNT], int axis, int notch)
+{
+    const uint16_t centerFreq = fftResult[axis].centerFreq[notch];
+    float cutoffFreq = constrain(centerFreq - DYN_NOTCH_WIDTH, DYN_NOTCH_MIN_CUTOFF, DYN_NOTCH_MAX_CUTOFF);
+    float notchQ = filterGetNotchQ(centerFreq, cutoffFreq);
+    biquadFilterUpdateNotch(&notchFilterDyn[notch][axis], centerFreq, analyseLooptimeUs, notchQ);
+
+    // there is no D term on yaw
+    if (dtermNotchFilterDyn && axis != Z) {
+        biquadFilter_t *dtermNotch = &dtermNotchFilterDyn[notch][axis];
+        if (dtermLooptimeUs == analyseLooptimeUs) {
+            // same sample rate, so the gyro notch coefficients apply as they are
+            const biquadFilter_t *gyroNotch = &notchFilterDyn[notch][axis];
+            dtermNotch->b0 = gyroNotch->b0;
+            dtermNotch->b1 = gyroNotch->b1;
+            dtermNotch->b2 = gyroNotch->b2;
+            dtermNotch->a1 = gyroNotch->a1;
+            dtermNotch->a2 = gyroNotch->a2;
+        } else {
+            biquadFilterUpdateNotch(dtermNotch, centerFreq, dtermLooptimeUs, notchQ);
+        }
+    }
+}
+
+/*
+ * Have the analyser retune a second set of notches, laid out like the gyro notches, with every
+ * gyro notch update. They run at looptimeUs, the D term rate. NULL stops the updates.
+ */
+void gyroDataAnalyseSetDtermNotch(biquadFilter_t dtermNotchDyn[][XYZ_AXIS_COUNT], uint32_t looptimeUs)
+{
+    dtermNotchFilterDyn = dtermNotchDyn;
+    dtermLooptimeUs = looptimeUs;
+}
+
 /*
  * Analyse last gyro data from the last FFT_WINDOW_SIZE milliseconds
  */
-void gyroDataAnalyseUpdate(biquadFilter_t *notchFilterDyn)
+void gyroDataAnalyseUpdate(biquadFilter_t notchFilterDyn[][XYZ_AXIS_COUNT])
 {
     static int axis;
     static int step;
+    static int notch;   // notch being updated by STEP_UPDATE_FILTERS
     arm_cfft_instance_f32 * Sint = &(fftInstance.Sint);
 
     uint32_t startTime = 0;
@@ -244,50 +524,22 @@ void gyroDataAnalyseUpdate(biquadFilter_t *notchFilterDyn)
         case STEP_CALC_FREQUENCIES:
         {
             // 13us
-            float fftSum = 0;
-            float fftWeightedSum = 0;
-
-            fftResult[axis].maxVal = 0;
-            // iterate over fft data and calculate weighted indexes
-            float squaredData;
-            for (int i = 0; i < FFT_BIN_COUNT; i++) {
-                squaredData = fftData[i] * fftData[i];  //more weight on higher peaks
-                fftResult[axis].maxVal = MAX(fftResult[axis].maxVal, squaredData);
-                fftSum += squaredData;
-                fftWeightedSum += squaredData * (i + 1); // calculate weighted index starting at 1, not 0
-            }
-
-            // get weighted center of relevant frequency range (this way we have a better resolution than 31.25Hz)
-            if (fftSum > 0) {
-                // idx was shifted by 1 to start at 1, not 0
-                float fftMeanIndex = (fftWeightedSum / fftSum) - 1;
-                // the index points at the center frequency of each bin so index 0 is actually 16.125Hz
-                // fftMeanIndex += 0.5;
-
-                // don't go below the minimal cutoff frequency + 10 and don't jump around too much
-                float centerFreq;
-                centerFreq = constrain(fftMeanIndex * FFT_RESOLUTION, DYN_NOTCH_MIN_CUTOFF + 10, FFT_MAX_FREQUENCY);
-                centerFreq = biquadFilterApply(&fftFreqFilter[axis], centerFreq);
-                centerFreq = constrain(centerFreq, DYN_NOTCH_MIN_CUTOFF + 10, FFT_MAX_FREQUENCY);
-                fftResult[axis].centerFreq = centerFreq;
-                if (axis == 0) {
-                    DEBUG_SET(DEBUG_FFT, 3, lrintf(fftMeanIndex * 100));
-                }
-            }
-
-            DEBUG_SET(DEBUG_FFT_FREQ, axis, fftResult[axis].centerFreq);
+            calculateFrequencies(axis);
             DEBUG_SET(DEBUG_FFT_TIME, 1, micros() - startTime);
             break;
         }
         case STEP_UPDATE_FILTERS:
         {
-            // 7us
-            // calculate new filter coefficients
-            float cutoffFreq = constrain(fftResult[axis].centerFreq - DYN_NOTCH_WIDTH, DYN_NOTCH_MIN_CUTOFF, DYN_NOTCH_MAX_CUTOFF);
-            float notchQ = filterGetNotchQ(fftResult[axis].centerFreq, cutoffFreq);
-            biquadFilterUpdate(&notchFilterDyn[axis], fftResult[axis].centerFreq, gyro.targetLooptime, notchQ, FILTER_NOTCH);
+            // 7us per notch
+            // calculate new filter coefficients, one notch per call
+            updateDynNotch(notchFilterDyn, axis, notch);
             DEBUG_SET(DEBUG_FFT_TIME, 1, micros() - startTime);
 
+            if (++notch < dynNotchCount) {
+                // stay in this step until all notches of the axis are updated
+                return;
+            }
+            notch = 0;
             axis = (axis + 1) % 3;
             step++;
             FALLTHROUGH;
@@ -309,4 +561,31 @@ void gyroDataAnalyseUpdate(biquadFilter_t *notchFilterDyn)
     step = (step + 1) % STEP_COUNT;
 }
 
+/*
+ * Estimate the frequencies from the sliding DFT, one axis or notch per call
+ */
+static void gyroDataAnalyseSdftUpdate(biquadFilter_t notchFilterDyn[][XYZ_AXIS_COUNT])
+{
+    static int axis;
+    static int step;    // 0 estimates the frequencies, then one step per notch
+
+    uint32_t startTime = 0;
+    if (debugMode == (DEBUG_FFT_TIME))
+        startTime = micros();
+
+    DEBUG_SET(DEBUG_FFT_TIME, 0, step);
+    if (step == 0) {
+        sdftMagnitudes(axis);
+        calculateFrequencies(axis);
+    } else {
+        updateDynNotch(notchFilterDyn, axis, step - 1);
+    }
+    DEBUG_SET(DEBUG_FFT_TIME, 1, micros() - startTime);
+
+    if (++step > dynNotchCount) {
+        step = 0;
+        axis = (axis + 1) % XYZ_AXIS_COUNT;
+    }
+}
+
 #endif // USE_GYRO_DATA_ANALYSE
@@ -20,16 +20,38 @@
 
 #pragma once
 
+#include "common/axis.h"
 #include "common/time.h"
 #include "common/filter.h"
 
+#define DYN_NOTCH_COUNT_MAX 3  // spectral peaks tracked per axis, each drives its own notch
+
+typedef enum {
+    DYN_NOTCH_ESTIMATOR_FFT = 0,   // windowed FFT over the last FFT_WINDOW_SIZE samples, computed in steps
+    DYN_NOTCH_ESTIMATOR_SDFT,      // sliding DFT of the notch frequency range, updated on every sample
+} dynNotchEstimator_e;
+
 typedef struct gyroFftData_s {
     float maxVal;
-    uint16_t centerFreq;
+    uint16_t centerFreq[DYN_NOTCH_COUNT_MAX]; // ascending, only the first dyn_notch_count are used
 } gyroFftData_t;
 
+#define GYRO_SPECTRUM_HOLD_US 2000000
+
+// the gyro noise spectrum of an axis, as of the last analysis of that axis
+typedef struct gyroSpectrum_s {
+    uint8_t binCount;
+    uint16_t binWidth;          // hundredths of Hz, bin i is centred on i times the width
+    const uint16_t *magnitude;  // lowest bin first
+} gyroSpectrum_t;
+
 void gyroDataAnalyseInit(uint32_t targetLooptime);
 const gyroFftData_t *gyroFftData(int axis);
+void gyroSpectrumRequest(timeUs_t currentTimeUs);
+bool gyroSpectrumRequested(timeUs_t currentTimeUs);
+void gyroSpectrumGet(int axis, gyroSpectrum_t *spectrum);
 struct gyroDev_s;
-void gyroDataAnalyse(const struct gyroDev_s *gyroDev, biquadFilter_t *notchFilterDyn);
-void gyroDataAnalyseUpdate(biquadFilter_t *notchFilterDyn);
+struct gyroSampleReader_s;
+void gyroDataAnalyse(const struct gyroDev_s *gyroDev, struct gyroSampleReader_s *reader, biquadFilter_t notchFilterDyn[][XYZ_AXIS_COUNT]);
+void gyroDataAnalyseUpdate(biquadFilter_t notchFilterDyn[][XYZ_AXIS_COUNT]);
+void gyroDataAnalyseSetDtermNotch(biquadFilter_t dtermNotchDyn[][XYZ_AXIS_COUNT], uint32_t looptimeUs);
@@ -42,12 +42,33 @@
 #include "sensors/rangefinder.h"
 #include "sensors/initialisation.h"
 
+PG_REGISTER(sensorDetectionCache_t, sensorDetectionCache, PG_SENSOR_DETECTION_CACHE, 0);
+
 // requestedSensors is not actually used
 uint8_t requestedSensors[SENSOR_INDEX_COUNT] = { GYRO_NONE, ACC_NONE, BARO_NONE, MAG_NONE, RANGEFINDER_NONE };
 uint8_t detectedSensors[SENSOR_INDEX_COUNT] = { GYRO_NONE, ACC_NONE, BARO_NONE, MAG_NONE, RANGEFINDER_NONE };
 
+static uint32_t sensorDetectionBoardSignature(void)
+{
+    return U_ID_0 ^ U_ID_1 ^ U_ID_2;
+}
+
+/*
+ * The detection cache
+ *
+ * Probing for every supported sensor costs seconds on boards whose sensor is late in the
+ * search order, as each missing device is retried with long delays. The detection functions
+ * try the cached device first and probe in full only if it doesn't answer, then record what
+ * they found. The cache lives in RAM like any other setting and reaches the EEPROM with the
+ * next save, so boots after that start from the known hardware.
+ */
 bool sensorsAutodetect(void)
 {
+    if (sensorDetectionCache()->boardSignature != sensorDetectionBoardSignature()) {
+        // configuration from another board, forget its hardware
+        memset(sensorDetectionCacheMutable(), 0, sizeof(sensorDetectionCache_t));
+        sensorDetectionCacheMutable()->boardSignature = sensorDetectionBoardSignature();
+    }
 
     // gyro must be initialised before accelerometer
 
@@ -62,7 +83,11 @@ bool sensorsAutodetect(void)
 #endif
 
 #ifdef USE_BARO
-    baroDetect(&baro.dev, barometerConfig()->baro_hardware);
+    const baroSensor_e cachedBaro = sensorDetectionCache()->baroHardware;
+    const bool cachedBaroFound = barometerConfig()->baro_hardware == BARO_DEFAULT && cachedBaro != BARO_DEFAULT && baroDetect(&baro.dev, cachedBaro);
+    if (cachedBaroFound || baroDetect(&baro.dev, barometerConfig()->baro_hardware)) {
+        sensorDetectionCacheMutable()->baroHardware = detectedSensors[SENSOR_INDEX_BARO];
+    }
 #endif
 
 #ifdef USE_RANGEFINDER
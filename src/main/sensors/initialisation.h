@@ -20,4 +20,16 @@
 
 #pragma once
 
+#include "pg/pg.h"
+
+// Hardware found on the last boot, probed first on the next one. 0 means nothing cached.
+typedef struct sensorDetectionCache_s {
+    uint32_t boardSignature;    // the cache only applies to the MCU that wrote it
+    uint8_t mpuSensor[2];       // mpuSensor_e, per gyro
+    uint8_t baroHardware;       // baroSensor_e
+    uint8_t magHardware;        // magSensor_e
+} sensorDetectionCache_t;
+
+PG_DECLARE(sensorDetectionCache_t, sensorDetectionCache);
+
 bool sensorsAutodetect(void);
@@ -273,7 +273,8 @@ void rangefinderUpdate(timeUs_t currentTimeUs)
     // return rangefinder.dev.delayMs * 1000;  // to microseconds XXX iNav only
 }
 
-bool isSurfaceAltitudeValid() {
+bool isSurfaceAltitudeValid(void)
+{
 
     /*
      * Preconditions: raw and calculated altidude > 0
@@ -62,6 +62,7 @@ void rangefinderResetDynamicThreshold(void);
 bool rangefinderInit(void);
 
 int32_t rangefinderGetLatestAltitude(void);
+bool isSurfaceAltitudeValid(void);
 int32_t rangefinderGetLatestRawAltitude(void);
 
 void rangefinderUpdate(timeUs_t currentTimeUs);
@@ -166,6 +166,12 @@ void voltageMeterADCRefresh(void)
         // always calculate the latest voltage, see getLatestVoltage() which does the calculation on demand.
         state->voltageFiltered = voltageAdcToVoltage(filteredSample, config);
         state->voltageUnfiltered = voltageAdcToVoltage(rawSample, config);
+#elif defined(SIMULATOR_BUILD)
+        UNUSED(voltageAdcToVoltage);
+
+        // the SITL target sets the battery voltage itself, e.g. replayed from a log
+        state->voltageFiltered = i == VOLTAGE_SENSOR_ADC_VBAT ? simulatorBatteryVoltage : 0;
+        state->voltageUnfiltered = state->voltageFiltered;
 #else
         UNUSED(voltageAdcToVoltage);
 
@@ -30,6 +30,7 @@
 #include "fc/fc_core.h"
 #include "fc/rc_adjustments.h"
 #include "fc/rc_controls.h"
+#include "fc/rc_modes.h"
 #include "fc/runtime_config.h"
 
 #include "io/motors.h"
@@ -353,7 +354,7 @@ static bool bstSlaveProcessFeedbackCommand(uint8_t bstRequest)
                 bstWrite8(currentPidProfile->pid[i].I);
                 bstWrite8(currentPidProfile->pid[i].D);
             }
-            pidInitConfig(currentPidProfile);
+            pidPrepareProfile(currentPidProfile);
             break;
         case BST_MODE_RANGES:
             for (i = 0; i < MAX_MODE_ACTIVATION_CONDITION_COUNT; i++) {
@@ -513,6 +514,7 @@ static bool bstSlaveProcessWriteCommand(uint8_t bstWriteCommand)
                     mac->range.endStep = bstRead8();
 
                     useRcControlsConfig(currentPidProfile);
+                    analyzeModeActivationConditions();
                 } else {
                     ret = BST_FAILED;
                 }
@@ -844,8 +846,8 @@ bool writeGpsPositionPrameToBST(void)
 
 bool writeRollPitchYawToBST(void)
 {
-    int16_t X = -attitude.values.pitch * (M_PIf / 1800.0f) * 10000;
-    int16_t Y = attitude.values.roll * (M_PIf / 1800.0f) * 10000;
+    int16_t X = -getAttitude()->values.pitch * (M_PIf / 1800.0f) * 10000;
+    int16_t Y = getAttitude()->values.roll * (M_PIf / 1800.0f) * 10000;
     int16_t Z = 0;//radiusHeading * 10000;
 
     bstMasterStartBuffer(PUBLIC_ADDRESS);
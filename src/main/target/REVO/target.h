@@ -140,6 +140,12 @@
 #define MPU_INT_EXTI            PC4
 #define USE_MPU_DATA_READY_SIGNAL
 
+// gyro reads by DMA, the other devices on SPI1 claim the bus
+#define GYRO_SPI_DMA_RX_STREAM      DMA2_Stream0
+#define GYRO_SPI_DMA_RX_CHANNEL     DMA_Channel_3
+#define GYRO_SPI_DMA_TX_STREAM      DMA2_Stream3
+#define GYRO_SPI_DMA_TX_CHANNEL     DMA_Channel_3
+
 // Configure MAG and BARO unconditionally.
 #define USE_MAG
 #define USE_MAG_HMC5883
@@ -181,6 +187,12 @@
 #define USE_FLASHFS
 #define USE_FLASH_M25P16
 
+// page programs by DMA, with the LED strip on stream 0 and DShot on stream 2 they stay blocking
+#define FLASH_SPI_DMA_RX_STREAM     DMA1_Stream0
+#define FLASH_SPI_DMA_RX_CHANNEL    DMA_Channel_0
+#define FLASH_SPI_DMA_TX_STREAM     DMA1_Stream5
+#define FLASH_SPI_DMA_TX_CHANNEL    DMA_Channel_0
+
 #endif // AIRBOTF4SD
 
 
@@ -0,0 +1,155 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "target/SITL/replay.h"
+
+#define REPLAY_LINE_LENGTH      4096
+#define REPLAY_MAX_GAP_S        0.1     // longer steps between rows, e.g. across a log restart, reuse the last step
+
+typedef enum {
+    REPLAY_COLUMN_TIME = 0,
+    REPLAY_COLUMN_GYRO_X,
+    REPLAY_COLUMN_GYRO_Y,
+    REPLAY_COLUMN_GYRO_Z,
+    REPLAY_COLUMN_RC_ROLL,
+    REPLAY_COLUMN_RC_PITCH,
+    REPLAY_COLUMN_RC_YAW,
+    REPLAY_COLUMN_RC_THROTTLE,
+    REPLAY_COLUMN_VOLTAGE,
+    REPLAY_COLUMN_COUNT
+} replayColumn_e;
+
+static const char * const replayColumnNames[REPLAY_COLUMN_COUNT] = {
+    "time (us)", "gyroADC[0]", "gyroADC[1]", "gyroADC[2]",
+    "rcCommand[0]", "rcCommand[1]", "rcCommand[2]", "rcCommand[3]", "vbatLatest (V)",
+};
+
+static FILE *replayFile = NULL;
+static long replayFirstRow;
+static int replayColumnIndex[REPLAY_COLUMN_COUNT];
+static double replayLastTime;
+static double replayLastDt;
+
+static char *replayTrim(char *field)
+{
+    while (*field == ' ') {
+        field++;
+    }
+    size_t length = strlen(field);
+    while (length && (field[length - 1] == ' ' || field[length - 1] == '\n' || field[length - 1] == '\r')) {
+        field[--length] = '\0';
+    }
+    return field;
+}
+
+bool replayOpen(const char *fileName)
+{
+    char line[REPLAY_LINE_LENGTH];
+
+    replayFile = fopen(fileName, "r");
+    if (replayFile == NULL || fgets(line, sizeof(line), replayFile) == NULL) {
+        fprintf(stderr, "[replay] can't read '%s'\n", fileName);
+        return false;
+    }
+    replayFirstRow = ftell(replayFile);
+
+    for (int column = 0; column < REPLAY_COLUMN_COUNT; column++) {
+        replayColumnIndex[column] = -1;
+    }
+    int index = 0;
+    for (char *field = strtok(line, ","); field; field = strtok(NULL, ","), index++) {
+        field = replayTrim(field);
+        for (int column = 0; column < REPLAY_COLUMN_COUNT; column++) {
+            if (strcmp(field, replayColumnNames[column]) == 0) {
+                replayColumnIndex[column] = index;
+            }
+        }
+    }
+
+    if (replayColumnIndex[REPLAY_COLUMN_TIME] < 0) {
+        fprintf(stderr, "[replay] no '%s' column in '%s'\n", replayColumnNames[REPLAY_COLUMN_TIME], fileName);
+        return false;
+    }
+    for (int column = 0; column < REPLAY_COLUMN_COUNT; column++) {
+        if (replayColumnIndex[column] < 0) {
+            printf("[replay] no '%s' column, it is not replayed\n", replayColumnNames[column]);
+        }
+    }
+
+    replayLastTime = -1;
+    replayLastDt = 0;
+    return true;
+}
+
+// Reads the next row, at the end of the file it starts over if rewind is set and returns false otherwise
+bool replayRead(replaySample_t *sample, bool rewind)
+{
+    char line[REPLAY_LINE_LENGTH];
+
+    if (replayFile == NULL) {
+        return false;
+    }
+    if (fgets(line, sizeof(line), replayFile) == NULL) {
+        if (!rewind || fseek(replayFile, replayFirstRow, SEEK_SET) != 0 || fgets(line, sizeof(line), replayFile) == NULL) {
+            return false;
+        }
+    }
+
+    double values[REPLAY_COLUMN_COUNT] = { [REPLAY_COLUMN_RC_THROTTLE] = 1000 };
+    int index = 0;
+    for (char *field = strtok(line, ","); field; field = strtok(NULL, ","), index++) {
+        for (int column = 0; column < REPLAY_COLUMN_COUNT; column++) {
+            if (replayColumnIndex[column] == index) {
+                values[column] = strtod(field, NULL);
+            }
+        }
+    }
+
+    const double time = values[REPLAY_COLUMN_TIME] * 1e-6;
+    const double dt = time - replayLastTime;
+    if (replayLastTime >= 0 && dt > 0 && dt < REPLAY_MAX_GAP_S) {
+        replayLastDt = dt;
+    }
+    replayLastTime = time;
+
+    sample->dt = replayLastDt;
+    for (int axis = 0; axis < 3; axis++) {
+        sample->gyro[axis] = values[REPLAY_COLUMN_GYRO_X + axis];
+    }
+    for (int channel = 0; channel < 4; channel++) {
+        sample->rcCommand[channel] = values[REPLAY_COLUMN_RC_ROLL + channel];
+    }
+    sample->voltage = values[REPLAY_COLUMN_VOLTAGE];
+    return true;
+}
+
+void replayClose(void)
+{
+    if (replayFile != NULL) {
+        fclose(replayFile);
+        replayFile = NULL;
+    }
+}
@@ -0,0 +1,36 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// one row of a log decoded to CSV, e.g. by blackbox_decode, the columns are found by their name in the header
+typedef struct replaySample_s {
+    double dt;                  // seconds since the previous sample
+    double gyro[3];             // deg/s, gyroADC[0..2]
+    int16_t rcCommand[4];       // roll, pitch, yaw -500..500 and throttle 1000..2000, rcCommand[0..3]
+    double voltage;             // V, vbatLatest (V)
+} replaySample_t;
+
+bool replayOpen(const char *fileName);
+bool replayRead(replaySample_t *sample, bool rewind);
+void replayClose(void);
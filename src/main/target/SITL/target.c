@@ -27,6 +27,8 @@
 #include <errno.h>
 #include <time.h>
 
+#include "build/profiler.h"
+
 #include "common/maths.h"
 
 #include "drivers/io.h"
@@ -46,13 +48,18 @@ const timerHardware_t timerHardware[1]; // unused
 
 #include "config/feature.h"
 #include "fc/config.h"
+#include "fc/rc_controls.h"
 #include "scheduler/scheduler.h"
 
 #include "pg/rx.h"
 
+#include "rx/msp.h"
 #include "rx/rx.h"
 
+#include "sensors/gyro.h"
+
 #include "dyad.h"
+#include "target/SITL/replay.h"
 #include "target/SITL/udplink.h"
 
 static fdm_packet fdmPkt;
@@ -60,12 +67,36 @@ static servo_packet pwmPkt;
 
 static struct timespec start_time;
 static double simRate = 1.0;
-static pthread_t tcpWorker, udpWorker;
+static pthread_t tcpWorker;
+#if !defined(SIMULATOR_LOCKSTEP)
+static pthread_t udpWorker;
+#endif
 static bool workerRunning = true;
 static udpLink_t stateLink, pwmLink;
 static pthread_mutex_t updateLock;
 static pthread_mutex_t mainLoopLock;
 
+#if defined(SIMULATOR_LOCKSTEP)
+// simulated time, it only moves on through the physics steps of the simulator once the first fdm_packet arrived
+static bool lockstepRunning = false;
+static uint64_t lockstepTimeNs;
+static uint64_t lockstepStepEndNs;
+static bool lockstepStepPending = false;
+
+// SITL_REPLAY=<csv file> replays a log instead of running with the simulator, SITL_REPLAY_LOOPS=<n> stops after
+// n PID loops, starting the log over as often as needed
+static bool replaying = false;
+static uint32_t replayLoops;
+static bool replayStarted = false;
+static uint64_t replayStartedAtNs;
+static uint64_t replayStartedAtSimNs;
+#endif
+
+uint16_t simulatorBatteryVoltage = 0;
+
+static unsigned sitlInstance; // SITL_INSTANCE
+static char eepromFileName[32] = EEPROM_FILENAME;
+
 int timeval_sub(struct timespec *result, struct timespec *x, struct timespec *y);
 
 int lockMainPID(void) {
@@ -75,11 +106,30 @@ int lockMainPID(void) {
 #define RAD2DEG (180.0 / M_PI)
 #define ACC_SCALE (256 / 9.80665)
 #define GYRO_SCALE (16.4)
+#if defined(SIMULATOR_LOCKSTEP)
+// moves the end of the current physics step on by deltaSim seconds, the first step starts the clock
+static void lockstepAdvance(double deltaSim)
+{
+    if (!lockstepRunning) {
+        lockstepTimeNs = micros64() * 1000;
+        lockstepStepEndNs = lockstepTimeNs;
+        lockstepRunning = true;
+    }
+    lockstepStepEndNs += deltaSim * 1e9;
+}
+#endif
+
 void sendMotorUpdate() {
     udpSend(&pwmLink, &pwmPkt, sizeof(servo_packet));
 }
 void updateState(const fdm_packet* pkt) {
     static double last_timestamp = 0; // in seconds
+#if defined(SIMULATOR_LOCKSTEP)
+    // the first packet only starts the clock, a restarted simulation keeps it going from where it was
+    const double deltaSim = lockstepRunning ? MAX(pkt->timestamp - last_timestamp, 0) : 0;  // in seconds
+    lockstepAdvance(deltaSim);
+    last_timestamp = pkt->timestamp;
+#else
     static uint64_t last_realtime = 0; // in uS
     static struct timespec last_ts; // last packet
 
@@ -98,6 +148,7 @@ void updateState(const fdm_packet* pkt) {
     if (deltaSim < 0) { // don't use old packet
         return;
     }
+#endif
 
     int16_t x,y,z;
     x = constrain(-pkt->imu_linear_acceleration_xyz[0] * ACC_SCALE, -32767, 32767);
@@ -148,7 +199,7 @@ void updateState(const fdm_packet* pkt) {
     imuUpdateAttitude(micros());
 #endif
 
-
+#if !defined(SIMULATOR_LOCKSTEP)
     if (deltaSim < 0.02 && deltaSim > 0) { // simulator should run faster than 50Hz
 //        simRate = simRate * 0.5 + (1e6 * deltaSim / (realtime_now - last_realtime)) * 0.5;
         struct timespec out_ts;
@@ -164,12 +215,14 @@ void updateState(const fdm_packet* pkt) {
     last_ts.tv_nsec = now_ts.tv_nsec;
 
     pthread_mutex_unlock(&updateLock); // can send PWM output now
+#endif
 
 #if defined(SIMULATOR_GYROPID_SYNC)
     pthread_mutex_unlock(&mainLoopLock); // can run main loop
 #endif
 }
 
+#if !defined(SIMULATOR_LOCKSTEP)
 static void* udpThread(void* data) {
     UNUSED(data);
     int n = 0;
@@ -185,16 +238,123 @@ static void* udpThread(void* data) {
     printf("udpThread end!!\n");
     return NULL;
 }
+#else
+static void replayReport(void)
+{
+    static const char * const probeNames[PROFILER_PROBE_COUNT] = {
+        "gyro update", "gyro read", "rpm filter", "dyn notch", "static filters",
+        "gyro analyse", "pid controller", "mix table", "write motors", "blackbox",
+    };
+    profilerStats_t stats;
+
+    profilerGetStats(PROFILER_GYRO_UPDATE, &stats);
+    printf("[replay] %u PID loops, %.1fs replayed in %.2fs\n", stats.count,
+        (lockstepTimeNs - replayStartedAtSimNs) * 1e-9, (nanos64_real() - replayStartedAtNs) * 1e-9);
+
+    for (int probe = 0; probe < PROFILER_PROBE_COUNT; probe++) {
+        profilerGetStats(probe, &stats);
+        if (stats.count == 0) {
+            continue;
+        }
+        printf("%-16s %9u runs  min %8.2fus  avg %8.2fus  max %8.2fus\n", probeNames[probe], stats.count,
+            stats.minCycles * 1e-3, (double)stats.totalCycles / stats.count * 1e-3, stats.maxCycles * 1e-3);
+        for (int bucket = 0; bucket < PROFILER_HISTOGRAM_BUCKET_COUNT; bucket++) {
+            if (stats.histogram[bucket]) {
+                printf("    < %8.2fus %6.2f%%\n", (1U << bucket) * 1e-3, stats.histogram[bucket] * 100.0 / stats.count);
+            }
+        }
+    }
+}
+
+// Feeds the next row of the replayed log to the fake sensors, the MSP receiver and the battery voltage as one
+// lockstep step. The gyro is calibrated at rest first, the profiler statistics then restart so they only cover
+// the log.
+static void replayStep(void)
+{
+    if (!isGyroCalibrationComplete()) {
+        fakeGyroSet(fakeGyroDev, 0, 0, 0);
+        fakeAccSet(fakeAccDev, 0, 0, ACC_SCALE * 9.80665);
+        lockstepAdvance(0.001);
+        return;
+    }
+    if (!replayStarted) {
+        profilerReset();
+        replayStartedAtNs = nanos64_real();
+        replayStartedAtSimNs = lockstepTimeNs;
+        replayStarted = true;
+    }
+
+    profilerStats_t stats;
+    profilerGetStats(PROFILER_GYRO_UPDATE, &stats);
+    replaySample_t sample;
+    if ((replayLoops && stats.count >= replayLoops) || !replayRead(&sample, replayLoops != 0)) {
+        replayReport();
+        replayClose();
+        systemReset();
+    }
+
+    int16_t x, y, z;
+    x = constrain(sample.gyro[0] * GYRO_SCALE, -32767, 32767);
+    y = constrain(sample.gyro[1] * GYRO_SCALE, -32767, 32767);
+    z = constrain(sample.gyro[2] * GYRO_SCALE, -32767, 32767);
+    fakeGyroSet(fakeGyroDev, x, y, z);
+
+    // rcCommand is the stick deflection with the yaw reversed, the aux channels stay low so the craft is not armed
+    uint16_t frame[8];
+    for (unsigned channel = 0; channel < ARRAYLEN(frame); channel++) {
+        frame[channel] = PWM_RANGE_MIN;
+    }
+    frame[rxConfig()->rcmap[ROLL]] = rxConfig()->midrc + sample.rcCommand[ROLL];
+    frame[rxConfig()->rcmap[PITCH]] = rxConfig()->midrc + sample.rcCommand[PITCH];
+    frame[rxConfig()->rcmap[YAW]] = rxConfig()->midrc - sample.rcCommand[YAW];
+    frame[rxConfig()->rcmap[THROTTLE]] = sample.rcCommand[THROTTLE];
+    rxMspFrameReceive(frame, ARRAYLEN(frame));
+
+    simulatorBatteryVoltage = lrint(sample.voltage * 10);
+
+    lockstepAdvance(sample.dt);
+}
+
+// Called by the main loop in place of its real time pacing. Returns true once the clock was moved on by a tick
+// of the current physics step, the scheduler then runs at that time. At the end of the step the motor state
+// is sent to the simulator and the next fdm_packet is waited for.
+bool simulatorLockstepTick(void)
+{
+    if (lockstepRunning && lockstepTimeNs < lockstepStepEndNs) {
+        lockstepTimeNs = MIN(lockstepTimeNs + SIMULATOR_LOCKSTEP_TICK_US * 1000ULL, lockstepStepEndNs);
+        return true;
+    }
+
+    if (replaying) {
+        replayStep();
+        return false;
+    }
+
+    if (lockstepStepPending) {
+        sendMotorUpdate();
+        lockstepStepPending = false;
+    }
+
+    if (udpRecv(&stateLink, &fdmPkt, sizeof(fdm_packet), 100) == sizeof(fdm_packet)) {
+        updateState(&fdmPkt);
+        lockstepStepPending = true;
+    }
+    return false;
+}
+#endif
 
 static void* tcpThread(void* data) {
     UNUSED(data);
 
     dyad_init();
     dyad_setTickInterval(0.2f);
-    dyad_setUpdateTimeout(0.5f);
+    // Short select() timeout: whatever the ports queued since the last update is flushed right after it, so this
+    // bounds the output latency.
+    dyad_setUpdateTimeout(0.001f);
 
     while (workerRunning) {
         dyad_update();
+        tcpDataOutAll();
     }
 
     dyad_shutdown();
@@ -209,6 +369,16 @@ void systemInit(void) {
     clock_gettime(CLOCK_MONOTONIC, &start_time);
     printf("[system]Init...\n");
 
+    const char *instance = getenv("SITL_INSTANCE");
+    if (instance) {
+        sitlInstance = strtoul(instance, NULL, 10);
+    }
+    if (sitlInstance) {
+        snprintf(eepromFileName, sizeof(eepromFileName), EEPROM_INSTANCE_FILENAME, sitlInstance);
+        tcpSetPortOffset(sitlInstance * SITL_INSTANCE_PORT_STRIDE);
+        printf("[system]instance %u\n", sitlInstance);
+    }
+
     SystemCoreClock = 500 * 1e6; // fake 500MHz
     FLASH_Unlock();
 
@@ -228,17 +398,34 @@ void systemInit(void) {
         exit(1);
     }
 
-    ret = udpInit(&pwmLink, "127.0.0.1", 9002, false);
-    printf("init PwnOut UDP link...%d\n", ret);
+    const int portOffset = sitlInstance * SITL_INSTANCE_PORT_STRIDE;
+    ret = udpInit(&pwmLink, "127.0.0.1", SITL_PWM_PORT + portOffset, false);
+    printf("init PwnOut UDP link to port %d...%d\n", SITL_PWM_PORT + portOffset, ret);
 
-    ret = udpInit(&stateLink, NULL, 9003, true);
-    printf("start UDP server...%d\n", ret);
+    ret = udpInit(&stateLink, NULL, SITL_STATE_PORT + portOffset, true);
+    printf("start UDP server on port %d...%d\n", SITL_STATE_PORT + portOffset, ret);
 
+#if defined(SIMULATOR_LOCKSTEP)
+    // the main loop receives the fdm packets itself
+    printf("lockstep with the simulator, %dus per scheduler pass\n", SIMULATOR_LOCKSTEP_TICK_US);
+
+    const char *replayFileName = getenv("SITL_REPLAY");
+    if (replayFileName) {
+        if (!replayOpen(replayFileName)) {
+            exit(1);
+        }
+        const char *loops = getenv("SITL_REPLAY_LOOPS");
+        replayLoops = loops ? strtoul(loops, NULL, 10) : 0;
+        replaying = true;
+        printf("[replay] '%s'\n", replayFileName);
+    }
+#else
     ret = pthread_create(&udpWorker, NULL, udpThread, NULL);
     if (ret != 0) {
         printf("Create udpWorker error!\n");
         exit(1);
     }
+#endif
 
     // serial can't been slow down
     rescheduleTask(TASK_SERIAL, 1);
@@ -248,14 +435,18 @@ void systemReset(void){
     printf("[system]Reset!\n");
     workerRunning = false;
     pthread_join(tcpWorker, NULL);
+#if !defined(SIMULATOR_LOCKSTEP)
     pthread_join(udpWorker, NULL);
+#endif
     exit(0);
 }
 void systemResetToBootloader(void) {
     printf("[system]ResetToBootloader!\n");
     workerRunning = false;
     pthread_join(tcpWorker, NULL);
+#if !defined(SIMULATOR_LOCKSTEP)
     pthread_join(udpWorker, NULL);
+#endif
     exit(0);
 }
 
@@ -298,6 +489,11 @@ uint64_t millis64_real() {
 }
 
 uint64_t micros64() {
+#if defined(SIMULATOR_LOCKSTEP)
+    if (lockstepRunning) {
+        return lockstepTimeNs / 1000;
+    }
+#endif
     static uint64_t last = 0;
     static uint64_t out = 0;
     uint64_t now = nanos64_real();
@@ -310,6 +506,11 @@ uint64_t micros64() {
 }
 
 uint64_t millis64() {
+#if defined(SIMULATOR_LOCKSTEP)
+    if (lockstepRunning) {
+        return lockstepTimeNs / 1000000;
+    }
+#endif
     static uint64_t last = 0;
     static uint64_t out = 0;
     uint64_t now = nanos64_real();
@@ -325,6 +526,11 @@ uint32_t micros(void) {
     return micros64() & 0xFFFFFFFF;
 }
 
+// there is no cycle counter on the host, this counts nanoseconds
+uint32_t cycles(void) {
+    return nanos64_real();
+}
+
 uint32_t millis(void) {
     return millis64() & 0xFFFFFFFF;
 }
@@ -337,6 +543,13 @@ void microsleep(uint32_t usec) {
 }
 
 void delayMicroseconds(uint32_t us) {
+#if defined(SIMULATOR_LOCKSTEP)
+    // the wait only takes simulated time
+    if (lockstepRunning) {
+        lockstepTimeNs += us * 1000ULL;
+        return;
+    }
+#endif
     microsleep(us / simRate);
 }
 
@@ -345,6 +558,12 @@ void delayMicroseconds_real(uint32_t us) {
 }
 
 void delay(uint32_t ms) {
+#if defined(SIMULATOR_LOCKSTEP)
+    if (lockstepRunning) {
+        lockstepTimeNs += ms * 1000000ULL;
+        return;
+    }
+#endif
     uint64_t start = millis64();
 
     while ((millis64() - start) < ms) {
@@ -445,9 +664,11 @@ void pwmCompleteMotorUpdate(uint8_t motorCount) {
     pwmPkt.motor_speed[1] = motorsPwm[2] / outScale;
     pwmPkt.motor_speed[2] = motorsPwm[3] / outScale;
 
+#if !defined(SIMULATOR_LOCKSTEP)
     // get one "fdm_packet" can only send one "servo_packet"!!
     if (pthread_mutex_trylock(&updateLock) != 0) return;
     udpSend(&pwmLink, &pwmPkt, sizeof(servo_packet));
+#endif
 //    printf("[pwm]%u:%u,%u,%u,%u\n", idlePulse, motorsPwm[0], motorsPwm[1], motorsPwm[2], motorsPwm[3]);
 }
 
@@ -455,6 +676,9 @@ void pwmWriteServo(uint8_t index, float value) {
     servosPwm[index] = value;
 }
 
+void pwmCompleteServoUpdate(void) {
+}
+
 // ADC part
 uint16_t adcGetChannel(uint8_t channel) {
     UNUSED(channel);
@@ -476,7 +700,7 @@ void FLASH_Unlock(void) {
     }
 
     // open or create
-    eepromFd = fopen(EEPROM_FILENAME,"r+");
+    eepromFd = fopen(eepromFileName,"r+");
     if (eepromFd != NULL) {
         // obtain file size:
         fseek(eepromFd , 0 , SEEK_END);
@@ -485,15 +709,15 @@ void FLASH_Unlock(void) {
 
         size_t n = fread(eepromData, 1, sizeof(eepromData), eepromFd);
         if (n == lSize) {
-            printf("[FLASH_Unlock] loaded '%s', size = %ld / %ld\n", EEPROM_FILENAME, lSize, sizeof(eepromData));
+            printf("[FLASH_Unlock] loaded '%s', size = %ld / %ld\n", eepromFileName, lSize, sizeof(eepromData));
         } else {
-            fprintf(stderr, "[FLASH_Unlock] failed to load '%s'\n", EEPROM_FILENAME);
+            fprintf(stderr, "[FLASH_Unlock] failed to load '%s'\n", eepromFileName);
             return;
         }
     } else {
-        printf("[FLASH_Unlock] created '%s', size = %ld\n", EEPROM_FILENAME, sizeof(eepromData));
-        if ((eepromFd = fopen(EEPROM_FILENAME, "w+")) == NULL) {
-            fprintf(stderr, "[FLASH_Unlock] failed to create '%s'\n", EEPROM_FILENAME);
+        printf("[FLASH_Unlock] created '%s', size = %ld\n", eepromFileName, sizeof(eepromData));
+        if ((eepromFd = fopen(eepromFileName, "w+")) == NULL) {
+            fprintf(stderr, "[FLASH_Unlock] failed to create '%s'\n", eepromFileName);
             return;
         }
         if (fwrite(eepromData, sizeof(eepromData), 1, eepromFd) != 1) {
@@ -509,7 +733,7 @@ void FLASH_Lock(void) {
         fwrite(eepromData, 1, sizeof(eepromData), eepromFd);
         fclose(eepromFd);
         eepromFd = NULL;
-        printf("[FLASH_Lock] saved '%s'\n", EEPROM_FILENAME);
+        printf("[FLASH_Lock] saved '%s'\n", eepromFileName);
     } else {
         fprintf(stderr, "[FLASH_Lock] eeprom is not unlocked\n");
     }
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
@@ -40,8 +41,31 @@
 //#define SIMULATOR_IMU_SYNC
 //#define SIMULATOR_GYROPID_SYNC
 
+// lockstep with the simulator: every fdm_packet advances the clock by its physics step, the scheduler runs
+// through the step and the motor packet answers it. Runs as fast as the host allows, the clock stands still
+// without a simulator.
+//#define SIMULATOR_LOCKSTEP
+#define SIMULATOR_LOCKSTEP_TICK_US      50  // simulated time per scheduler() pass
+
+#if defined(SIMULATOR_LOCKSTEP)
+// times the stages of the PID loop, the replay benchmark reports them
+#define USE_PROFILER
+#define USE_PROFILER_HISTOGRAMS
+#endif
+
+#if defined(SIMULATOR_LOCKSTEP) && defined(SIMULATOR_GYROPID_SYNC)
+#error "SIMULATOR_LOCKSTEP already runs the PID loop in sync with the simulator"
+#endif
+
+// SITL_INSTANCE=<n> runs the n-th of several instances on one host, every UDP and TCP port is moved on by
+// SITL_INSTANCE_PORT_STRIDE * n and the config is saved to EEPROM_INSTANCE_FILENAME instead
+#define SITL_INSTANCE_PORT_STRIDE       10
+#define SITL_PWM_PORT                   9002    // motor packets to the simulator
+#define SITL_STATE_PORT                 9003    // fdm packets from the simulator
+
 // file name to save config
 #define EEPROM_FILENAME "eeprom.bin"
+#define EEPROM_INSTANCE_FILENAME "eeprom_%u.bin"
 #define EEPROM_IN_RAM
 #define EEPROM_SIZE     32768
 
@@ -57,6 +81,13 @@
 
 #define USE_FAKE_LED
 
+#define USE_SCHEDULER_DEADLINE_QUEUE
+#define USE_TASK_HISTOGRAMS
+#define USE_SCHEDULER_TRACE
+#define USE_ADAPTIVE_PID_PROCESS_DENOM
+#define USE_TASK_CHAINING
+#define USE_GYRO_FILTER_BANK
+
 #define USE_ACC
 #define USE_FAKE_ACC
 
@@ -265,3 +296,8 @@ uint64_t micros64(void);
 uint64_t millis64(void);
 
 int lockMainPID(void);
+#if defined(SIMULATOR_LOCKSTEP)
+bool simulatorLockstepTick(void);
+#endif
+
+extern uint16_t simulatorBatteryVoltage; // 0.1V steps
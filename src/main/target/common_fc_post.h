@@ -32,6 +32,71 @@
 
 #ifndef USE_DSHOT
 #undef USE_ESC_SENSOR
+#undef USE_DSHOT_TELEMETRY
+#endif
+
+// the RPM filter needs the motor speeds from the ESCs
+#if !defined(USE_DSHOT_TELEMETRY) && !defined(USE_ESC_SENSOR)
+#undef USE_RPM_FILTER
+#endif
+
+// the fixed point gyro filters only cover the static notches and lowpasses
+#if defined(USE_GYRO_DATA_ANALYSE) || defined(USE_RPM_FILTER)
+#undef USE_FIXED_POINT_FILTERS
+#endif
+
+// the motor output timing uses the profiler cycle counter and only covers DShot DMA outputs
+#if !defined(USE_PROFILER) || !defined(USE_DSHOT)
+#undef USE_MOTOR_TIMING
+#endif
+
+#ifndef USE_BLACKBOX
+#undef USE_BLACKBOX_ASYNC
+#endif
+
+// logging to the host over USB needs the VCP
+#if !defined(USE_BLACKBOX) || !defined(USE_VCP)
+#undef USE_BLACKBOX_VCP
+#endif
+
+#ifdef SKIP_TASK_STATISTICS
+#undef USE_TASK_HISTOGRAMS
+#undef USE_SCHEDULER_TRACE
+#endif
+
+// the crash trace keeps the scheduler trace in the RAM that is not cleared on a reset
+#if !defined(USE_SCHEDULER_TRACE) || !defined(PERSISTENT)
+#undef USE_CRASH_TRACE
+#endif
+
+// the lockstep simulation clock stands still while a task runs, a busy wait on it would never end
+#if defined(SIMULATOR_LOCKSTEP)
+#undef USE_MOTOR_OUTPUT_SYNC
+#endif
+
+// the PID loop can only be run from the gyro interrupt if the gyro signals data ready
+#if !defined(USE_EXTI) || !defined(USE_MPU_DATA_READY_SIGNAL)
+#undef USE_PREEMPTIVE_PID_LOOP
+#endif
+
+// DMA gyro reads are started by the data ready interrupt, the target selects the SPI DMA streams
+#if !defined(USE_EXTI) || !defined(USE_MPU_DATA_READY_SIGNAL) || !defined(MPU_INT_EXTI) || !defined(GYRO_SPI_DMA_RX_STREAM)
+#undef USE_GYRO_SPI_DMA
+#endif
+
+// DMA page programs of SPI NOR flash, the target selects the SPI DMA streams
+#if !defined(USE_FLASH_M25P16) || !defined(FLASH_SPI_DMA_RX_STREAM)
+#undef USE_FLASH_SPI_DMA
+#endif
+
+// ESC passthrough over a hardware UART on the motor pin, with escserial as the fallback
+#ifndef USE_ESCSERIAL
+#undef USE_ESCSERIAL_UART
+#endif
+
+// Transfers that run on after the call that started them have to claim their SPI bus
+#if defined(USE_GYRO_SPI_DMA) || defined(USE_FLASH_SPI_DMA)
+#define USE_SPI_BUS_CLAIM
 #endif
 
 // XXX Followup implicit dependencies among DASHBOARD, display_xxx and USE_I2C.
@@ -126,3 +191,8 @@
 #if defined(USE_MAX7456)
 #define USE_OSD
 #endif
+
+// the prediction is selected through rc_smoothing_type
+#if !defined(USE_RC_SMOOTHING_FILTER)
+#undef USE_RC_PREDICTION
+#endif
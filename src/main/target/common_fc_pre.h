@@ -39,26 +39,63 @@
 // Using RX DMA disables the use of receive callbacks
 #define USE_UART1_RX_DMA
 #define USE_UART1_TX_DMA
+#define USE_FIXED_POINT_FILTERS
 #endif
 
 #ifdef STM32F3
 #define MINIMAL_CLI
 #define USE_DSHOT
+#define USE_SOFTSERIAL_RX_DMA
 #define USE_GYRO_DATA_ANALYSE
+#define USE_GYRO_FIFO
 #endif
 
 #ifdef STM32F4
 #define USE_SRAM2
+#define USE_DMA_SPEC
 #if defined(STM32F40_41xxx)
 #define USE_FAST_RAM
 #endif
 #define USE_DSHOT
+#define USE_SOFTSERIAL_RX_DMA
 #define I2C3_OVERCLOCK true
 #define USE_GYRO_DATA_ANALYSE
 #define USE_ADC
 #define USE_ADC_INTERNAL
 #define USE_USB_CDC_HID
 #define USE_USB_MSC
+#define USE_SCHEDULER_DEADLINE_QUEUE
+#define USE_TASK_HISTOGRAMS
+#define USE_SCHEDULER_TRACE
+#define USE_CRASH_TRACE
+#define USE_PREEMPTIVE_PID_LOOP
+#define USE_ADAPTIVE_PID_PROCESS_DENOM
+#define USE_SCHEDULER_IDLE_SLEEP
+#define USE_TASK_CHAINING
+#define USE_TASK_SIGNAL
+#define USE_GYRO_FILTER_BANK
+#define USE_GYRO_FIFO
+#define USE_GYRO_DECIMATION
+#define USE_GYRO_SPI_DMA
+#define USE_ACC_BURST_READ
+#define USE_FLASH_SPI_DMA
+#define USE_DSHOT_TELEMETRY
+#define USE_DSHOT_BITBANG
+#define USE_RPM_FILTER
+#define USE_GYRO_KALMAN_FILTER
+#define USE_GYRO_TEMP_COMP
+#define USE_PROFILER
+#define USE_MOTOR_TIMING
+#define USE_BLACKBOX_ASYNC
+#define USE_BLACKBOX_VCP
+#define USE_MSP_MULTIPLE
+#define USE_MSP_SUBSCRIPTIONS
+#define USE_CLI_SETTINGS_INDEX
+#define USE_EEPROM_APPEND
+#define USE_CLI_BATCH
+#define USE_CONFIG_SNAPSHOT
+#define USE_MSP_REPLY_CACHE
+#define USE_ESCSERIAL_UART
 
 #if defined(STM32F40_41xxx) || defined(STM32F411xE)
 #define USE_OVERCLOCK
@@ -68,6 +105,7 @@
 
 #ifdef STM32F7
 #define USE_SRAM2
+#define USE_DMA_RAM
 #define USE_ITCM_RAM
 #define USE_FAST_RAM
 #define USE_DSHOT
@@ -78,6 +116,33 @@
 #define USE_ADC_INTERNAL
 #define USE_USB_CDC_HID
 #define USE_USB_MSC
+#define USE_SCHEDULER_DEADLINE_QUEUE
+#define USE_TASK_HISTOGRAMS
+#define USE_SCHEDULER_TRACE
+#define USE_PREEMPTIVE_PID_LOOP
+#define USE_ADAPTIVE_PID_PROCESS_DENOM
+#define USE_SCHEDULER_IDLE_SLEEP
+#define USE_TASK_CHAINING
+#define USE_TASK_SIGNAL
+#define USE_GYRO_FILTER_BANK
+#define USE_GYRO_FIFO
+#define USE_GYRO_DECIMATION
+#define USE_ACC_BURST_READ
+#define USE_RPM_FILTER
+#define USE_GYRO_KALMAN_FILTER
+#define USE_GYRO_TEMP_COMP
+#define USE_PROFILER
+#define USE_MOTOR_TIMING
+#define USE_BLACKBOX_ASYNC
+#define USE_BLACKBOX_VCP
+#define USE_MSP_MULTIPLE
+#define USE_MSP_SUBSCRIPTIONS
+#define USE_CLI_SETTINGS_INDEX
+#define USE_EEPROM_APPEND
+#define USE_CLI_BATCH
+#define USE_CONFIG_SNAPSHOT
+#define USE_MSP_REPLY_CACHE
+#define AFATFS_NUM_CACHE_SECTORS 16
 #endif
 
 #if defined(STM32F4) || defined(STM32F7)
@@ -121,6 +186,13 @@
 #define SRAM2
 #endif
 
+#ifdef USE_DMA_RAM
+// Buffers read or written by DMA, kept out of the data cache by the MPU, aligned to a cache line
+#define DMA_RAM                     __attribute__ ((section(".dma_ram"), aligned(32)))
+#else
+#define DMA_RAM
+#endif
+
 #define USE_BRUSHED_ESC_AUTODETECT  // Detect if brushed motors are connected and set defaults appropriately to avoid motors spinning on boot
 #define USE_CLI
 #define USE_GYRO_REGISTER_DUMP  // Adds gyroregisters command to cli to dump configured register values
@@ -146,6 +218,7 @@
 #if (FLASH_SIZE > 64)
 #define USE_ACRO_TRAINER
 #define USE_BLACKBOX
+#define USE_CRC_TABLES
 #define USE_LED_STRIP
 #define USE_RESOURCE_MGMT
 #define USE_RUNAWAY_TAKEOFF     // Runaway Takeoff Prevention (anti-taz)
@@ -187,8 +260,13 @@
 #define USE_BOARD_INFO
 #define USE_SMART_FEEDFORWARD
 #define USE_THROTTLE_BOOST
+#define USE_THRUST_LINEARIZATION
 #define USE_RC_SMOOTHING_FILTER
+#define USE_RC_PREDICTION
+#define USE_RX_LATE_FRAME_DETECTION
+#define USE_RX_LINK_STATS
 #define USE_ITERM_RELAX
+#define USE_MOTOR_OUTPUT_SYNC
 
 #ifdef USE_SERIALRX_SPEKTRUM
 #define USE_SPEKTRUM_BIND
@@ -482,13 +482,31 @@ static const pllConfig_t overclockLevels[] = {
 
 static PERSISTENT uint32_t currentOverclockLevel = 0;
 
+// An overclocked boot that resets before OverclockBootCompleted() is taken as the silicon not
+// running at that clock. The level is then left alone up to the next power cycle.
+#define OVERCLOCK_BOOT_COOKIE 0x4F43424F
+static PERSISTENT uint32_t overclockBootPending;
+static PERSISTENT uint32_t overclockFailedCookie;
+static PERSISTENT uint32_t overclockFailedLevel;
+
 void SystemInitOC(void)
 {
+    if (overclockBootPending == OVERCLOCK_BOOT_COOKIE) {
+      overclockBootPending = 0;
+      overclockFailedCookie = OVERCLOCK_BOOT_COOKIE;
+      overclockFailedLevel = currentOverclockLevel;
+      currentOverclockLevel = 0;
+    }
+
     /* PLL setting for overclocking */
     if (currentOverclockLevel >= ARRAYLEN(overclockLevels)) {
       return;
     }
 
+    if (currentOverclockLevel != 0) {
+      overclockBootPending = OVERCLOCK_BOOT_COOKIE;
+    }
+
     const pllConfig_t * const pll = overclockLevels + currentOverclockLevel;
 
     pll_n = pll->n;
@@ -498,7 +516,7 @@ void SystemInitOC(void)
 
 void OverclockRebootIfNecessary(uint32_t overclockLevel)
 {
-  if (overclockLevel >= ARRAYLEN(overclockLevels)) {
+  if (overclockLevel >= ARRAYLEN(overclockLevels) || OverclockFailed(overclockLevel)) {
     return;
   }
 
@@ -507,11 +525,29 @@ void OverclockRebootIfNecessary(uint32_t overclockLevel)
   // Reboot to adjust overclock frequency
   if (SystemCoreClock != (pll->n / pll->p) * 1000000) {
     currentOverclockLevel = overclockLevel;
+    // this reset is not a failed boot
+    overclockBootPending = 0;
     __disable_irq();
     NVIC_SystemReset();
   }
 }
 
+bool OverclockFailed(uint32_t overclockLevel)
+{
+  return overclockFailedCookie == OVERCLOCK_BOOT_COOKIE && overclockFailedLevel == overclockLevel;
+}
+
+void OverclockBootCompleted(void)
+{
+  overclockBootPending = 0;
+}
+
+// the core clock without overclocking, the drivers are set up for it
+uint32_t SystemCoreClockStock(void)
+{
+  return (overclockLevels[0].n / overclockLevels[0].p) * 1000000;
+}
+
 void SystemInit(void)
 {
   SystemInitOC();
@@ -28,6 +28,8 @@
 #ifndef __SYSTEM_STM32F4XX_H
 #define __SYSTEM_STM32F4XX_H
 
+#include <stdbool.h>
+
 #ifdef __cplusplus
  extern "C" {
 #endif
@@ -36,6 +38,9 @@ extern uint32_t SystemCoreClock;          /*!< System Clock Frequency (Core Cloc
 extern void SystemInit(void);
 extern void SystemCoreClockUpdate(void);
 extern void OverclockRebootIfNecessary(uint32_t overclockLevel);
+extern bool OverclockFailed(uint32_t overclockLevel);
+extern void OverclockBootCompleted(void);
+extern uint32_t SystemCoreClockStock(void);
 
 #ifdef __cplusplus
 }
@@ -264,11 +264,23 @@ static const pllConfig_t overclockLevels[] = {
 #define CURRENT_OVERCLOCK_LEVEL         (*(__IO uint32_t *) (BKPSRAM_BASE + 12))
 #define REQUEST_OVERCLOCK_MAGIC_COOKIE  0xBABEFACE
 
+// An overclocked boot that resets before OverclockBootCompleted() is taken as the silicon not
+// running at that clock. The level is then left alone up to the next power cycle.
+#define OVERCLOCK_BOOT_PENDING          (*(__IO uint32_t *) (BKPSRAM_BASE + 16))
+#define OVERCLOCK_FAILED                (*(__IO uint32_t *) (BKPSRAM_BASE + 20))
+#define OVERCLOCK_FAILED_LEVEL          (*(__IO uint32_t *) (BKPSRAM_BASE + 24))
+
 void SystemInitOC(void) {
     __PWR_CLK_ENABLE();
     __BKPSRAM_CLK_ENABLE();
     HAL_PWR_EnableBkUpAccess();
 
+    if (REQUEST_OVERCLOCK_MAGIC_COOKIE == OVERCLOCK_BOOT_PENDING) {
+      OVERCLOCK_BOOT_PENDING = 0;
+      OVERCLOCK_FAILED = REQUEST_OVERCLOCK_MAGIC_COOKIE;
+      OVERCLOCK_FAILED_LEVEL = CURRENT_OVERCLOCK_LEVEL;
+    }
+
     if (REQUEST_OVERCLOCK_MAGIC_COOKIE == REQUEST_OVERCLOCK) {
       const uint32_t overclockLevel = CURRENT_OVERCLOCK_LEVEL;
 
@@ -279,15 +291,35 @@ void SystemInitOC(void) {
         pll_n = pll->n;
         pll_p = pll->p;
         pll_q = pll->q;
+
+        if (overclockLevel != 0) {
+          OVERCLOCK_BOOT_PENDING = REQUEST_OVERCLOCK_MAGIC_COOKIE;
+        }
       }
 
       REQUEST_OVERCLOCK = 0;
     }
 }
 
+bool OverclockFailed(uint32_t overclockLevel)
+{
+    return OVERCLOCK_FAILED == REQUEST_OVERCLOCK_MAGIC_COOKIE && OVERCLOCK_FAILED_LEVEL == overclockLevel;
+}
+
+void OverclockBootCompleted(void)
+{
+    OVERCLOCK_BOOT_PENDING = 0;
+}
+
+// the core clock without overclocking, the drivers are set up for it
+uint32_t SystemCoreClockStock(void)
+{
+    return (overclockLevels[0].n / overclockLevels[0].p) * 1000000;
+}
+
 void OverclockRebootIfNecessary(uint32_t overclockLevel)
 {
-    if (overclockLevel >= ARRAYLEN(overclockLevels)) {
+    if (overclockLevel >= ARRAYLEN(overclockLevels) || OverclockFailed(overclockLevel)) {
         return;
     }
 
@@ -297,11 +329,46 @@ void OverclockRebootIfNecessary(uint32_t overclockLevel)
     if (SystemCoreClock != (pll->n / pll->p) * 1000000) {
         REQUEST_OVERCLOCK = REQUEST_OVERCLOCK_MAGIC_COOKIE;
         CURRENT_OVERCLOCK_LEVEL = overclockLevel;
+        // this reset is not a failed boot
+        OVERCLOCK_BOOT_PENDING = 0;
         __disable_irq();
         NVIC_SystemReset();
     }
 }
 
+#ifdef USE_DMA_RAM
+// linker symbols, their addresses are the base and the size of the DMA_RAM region
+extern uint8_t _dma_ram_region_start;
+extern uint8_t _dma_ram_region_size;
+
+// Makes the DMA_RAM region normal memory that is not cached, so the data cache can stay
+// enabled for everything else without cleaning or invalidating around each transfer
+static void SystemConfigDmaRam(void)
+{
+    const uint32_t size = (uint32_t)&_dma_ram_region_size;
+    MPU_Region_InitTypeDef MPU_InitStruct;
+
+    HAL_MPU_Disable();
+
+    MPU_InitStruct.Enable = MPU_REGION_ENABLE;
+    MPU_InitStruct.Number = MPU_REGION_NUMBER0;
+    MPU_InitStruct.BaseAddress = (uint32_t)&_dma_ram_region_start;
+    // the region covers 2^(Size + 1) bytes
+    MPU_InitStruct.Size = 30 - __CLZ(size);
+    MPU_InitStruct.SubRegionDisable = 0x00;
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+    MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+    MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_SHAREABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+    // everything outside of the region keeps the default memory map
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+}
+#endif
+
 /**
   * @}
   */
@@ -358,6 +425,11 @@ void SystemInit(void)
         SCB_EnableICache();
     }
 
+#ifdef USE_DMA_RAM
+    /* Keep the DMA buffers out of the D-Cache */
+    SystemConfigDmaRam();
+#endif
+
     /* Enable D-Cache */
     if (DATA_CACHE_ENABLE) {
         SCB_EnableDCache();
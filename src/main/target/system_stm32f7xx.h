@@ -28,6 +28,8 @@
 #ifndef __TARGET_SYSTEM_STM32F7XX_H
 #define __TARGET_SYSTEM_STM32F7XX_H
 
+#include <stdbool.h>
+
 #ifdef __cplusplus
  extern "C" {
 #endif
@@ -37,6 +39,9 @@ extern void SystemInitOC(void);
 extern void SystemInit(void);
 extern void SystemClock_Config(void);
 extern void OverclockRebootIfNecessary(uint32_t overclockLevel);
+extern bool OverclockFailed(uint32_t overclockLevel);
+extern void OverclockBootCompleted(void);
+extern uint32_t SystemCoreClockStock(void);
 
 #ifdef __cplusplus
 }
@@ -62,8 +62,9 @@
 #include "telemetry/telemetry.h"
 #include "telemetry/crsf.h"
 #include "telemetry/msp_shared.h"
+#include "telemetry/telemetry_scheduler.h"
 
-#define CRSF_CYCLETIME_US                   100000 // 100ms, 10 Hz
+#define CRSF_TELEMETRY_SLOT_US              25000 // 40 Hz, shared out between the frames by the telemetry scheduler
 #define CRSF_DEVICEINFO_VERSION             0x01
 #define CRSF_DEVICEINFO_PARAMETER_COUNT     0
 
@@ -100,27 +101,30 @@ bool bufferCrsfMspFrame(uint8_t *frameStart, int frameLength)
     }
 }
 
-bool handleCrsfMspFrameBuffer(uint8_t payloadSize, mspResponseFnPtr responseFn)
+// Feeds the buffered request frames to the MSP parser until one completes a request, whose reply then has to go out
+// before the remaining frames are looked at. Returns true if there is a reply to send.
+static bool handleCrsfMspFrameBuffer(void)
 {
-    bool requestHandled = false;
+    static int pos = 0;
+
     if (!mspRxBuffer.len) {
         return false;
     }
-    int pos = 0;
     while (true) {
         const int mspFrameLength = mspRxBuffer.bytes[pos];
-        if (handleMspFrame(&mspRxBuffer.bytes[CRSF_MSP_LENGTH_OFFSET + pos], mspFrameLength)) {
-            requestHandled |= sendMspReply(payloadSize, responseFn);
-        }
+        const bool requestHandled = handleMspFrame(&mspRxBuffer.bytes[CRSF_MSP_LENGTH_OFFSET + pos], mspFrameLength);
         pos += CRSF_MSP_LENGTH_OFFSET + mspFrameLength;
         ATOMIC_BLOCK(NVIC_PRIO_SERIALUART1) {
             if (pos >= mspRxBuffer.len) {
                 mspRxBuffer.len = 0;
+                pos = 0;
                 return requestHandled;
             }
         }
+        if (requestHandled) {
+            return true;
+        }
     }
-    return requestHandled;
 }
 #endif
 
@@ -243,9 +247,9 @@ void crsfFrameAttitude(sbuf_t *dst)
 {
      sbufWriteU8(dst, CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC);
      sbufWriteU8(dst, CRSF_FRAMETYPE_ATTITUDE);
-     sbufWriteU16BigEndian(dst, DECIDEGREES_TO_RADIANS10000(attitude.values.pitch));
-     sbufWriteU16BigEndian(dst, DECIDEGREES_TO_RADIANS10000(attitude.values.roll));
-     sbufWriteU16BigEndian(dst, DECIDEGREES_TO_RADIANS10000(attitude.values.yaw));
+     sbufWriteU16BigEndian(dst, DECIDEGREES_TO_RADIANS10000(getAttitude()->values.pitch));
+     sbufWriteU16BigEndian(dst, DECIDEGREES_TO_RADIANS10000(getAttitude()->values.roll));
+     sbufWriteU16BigEndian(dst, DECIDEGREES_TO_RADIANS10000(getAttitude()->values.yaw));
 }
 
 /*
@@ -340,9 +344,7 @@ static void crsfFrameDisplayPortClear(sbuf_t *dst)
 
 #endif
 
-#define BV(x)  (1 << (x)) // bit value
-
-// schedule array to decide how often each type of frame is sent
+// frames sent by the telemetry schedule
 typedef enum {
     CRSF_FRAME_START_INDEX = 0,
     CRSF_FRAME_ATTITUDE_INDEX = CRSF_FRAME_START_INDEX,
@@ -352,66 +354,82 @@ typedef enum {
     CRSF_SCHEDULE_COUNT_MAX
 } crsfFrameTypeIndex_e;
 
+// how often each type of frame is wanted, attitude changes fastest
+static const telemetrySensor_t crsfFrameSensors[CRSF_SCHEDULE_COUNT_MAX] = {
+    [CRSF_FRAME_ATTITUDE_INDEX]         = { .intervalMs = 40,  .priority = 3 },
+    [CRSF_FRAME_BATTERY_SENSOR_INDEX]   = { .intervalMs = 200, .priority = 2 },
+    [CRSF_FRAME_FLIGHT_MODE_INDEX]      = { .intervalMs = 200, .priority = 2 },
+    [CRSF_FRAME_GPS_INDEX]              = { .intervalMs = 500, .priority = 1 },
+};
+
 static uint8_t crsfScheduleCount;
 static uint8_t crsfSchedule[CRSF_SCHEDULE_COUNT_MAX];
+static telemetrySensor_t crsfScheduleSensors[CRSF_SCHEDULE_COUNT_MAX];
+static timeMs_t crsfScheduleSentAtMs[CRSF_SCHEDULE_COUNT_MAX];
+static telemetryScheduler_t crsfScheduler;
 
 #if defined(USE_MSP_OVER_TELEMETRY)
 
-static bool mspReplyPending;
+static bool mspReplyPending;        // request frames are waiting in mspRxBuffer
+static bool mspReplyChunksPending;  // a reply has been started and has more chunks to send
 
 void crsfScheduleMspResponse(void)
 {
     mspReplyPending = true;
 }
 
-void crsfSendMspResponse(uint8_t *payload)
+// The frame only is as long as the chunk, the last chunk of a reply usually is a lot shorter than the frame budget.
+void crsfSendMspResponse(uint8_t *payload, uint8_t payloadSize)
 {
     sbuf_t crsfPayloadBuf;
     sbuf_t *dst = &crsfPayloadBuf;
 
     crsfInitializeFrame(dst);
-    sbufWriteU8(dst, CRSF_FRAME_TX_MSP_FRAME_SIZE + CRSF_FRAME_LENGTH_EXT_TYPE_CRC);
+    sbufWriteU8(dst, payloadSize + CRSF_FRAME_LENGTH_EXT_TYPE_CRC);
     sbufWriteU8(dst, CRSF_FRAMETYPE_MSP_RESP);
     sbufWriteU8(dst, CRSF_ADDRESS_RADIO_TRANSMITTER);
     sbufWriteU8(dst, CRSF_ADDRESS_FLIGHT_CONTROLLER);
-    sbufWriteData(dst, payload, CRSF_FRAME_TX_MSP_FRAME_SIZE);
+    sbufWriteData(dst, payload, payloadSize);
     crsfFinalize(dst);
 }
 #endif
 
-static void processCrsf(void)
+static void processCrsf(timeUs_t currentTimeUs)
 {
-    static uint8_t crsfScheduleIndex = 0;
-
-    const uint8_t currentSchedule = crsfSchedule[crsfScheduleIndex];
+    const int scheduleIndex = telemetrySchedulerNextSensor(&crsfScheduler, currentTimeUs / 1000);
+    if (scheduleIndex < 0) {
+        return;
+    }
 
     sbuf_t crsfPayloadBuf;
     sbuf_t *dst = &crsfPayloadBuf;
 
-    if (currentSchedule & BV(CRSF_FRAME_ATTITUDE_INDEX)) {
+    switch (crsfSchedule[scheduleIndex]) {
+    case CRSF_FRAME_ATTITUDE_INDEX:
         crsfInitializeFrame(dst);
         crsfFrameAttitude(dst);
         crsfFinalize(dst);
-    }
-    if (currentSchedule & BV(CRSF_FRAME_BATTERY_SENSOR_INDEX)) {
+        break;
+    case CRSF_FRAME_BATTERY_SENSOR_INDEX:
         crsfInitializeFrame(dst);
         crsfFrameBatterySensor(dst);
         crsfFinalize(dst);
-    }
-
-    if (currentSchedule & BV(CRSF_FRAME_FLIGHT_MODE_INDEX)) {
+        break;
+    case CRSF_FRAME_FLIGHT_MODE_INDEX:
         crsfInitializeFrame(dst);
         crsfFrameFlightMode(dst);
         crsfFinalize(dst);
-    }
+        break;
 #ifdef USE_GPS
-    if (currentSchedule & BV(CRSF_FRAME_GPS_INDEX)) {
+    case CRSF_FRAME_GPS_INDEX:
         crsfInitializeFrame(dst);
         crsfFrameGps(dst);
         crsfFinalize(dst);
-    }
+        break;
 #endif
-    crsfScheduleIndex = (crsfScheduleIndex + 1) % crsfScheduleCount;
+    default:
+        break;
+    }
 }
 
 void crsfScheduleDeviceInfoResponse(void)
@@ -429,20 +447,25 @@ void initCrsfTelemetry(void)
     deviceInfoReplyPending = false;
 #if defined(USE_MSP_OVER_TELEMETRY)
     mspReplyPending = false;
+    mspReplyChunksPending = false;
 #endif
 
     int index = 0;
     if (sensors(SENSOR_ACC)) {
-        crsfSchedule[index++] = BV(CRSF_FRAME_ATTITUDE_INDEX);
+        crsfSchedule[index++] = CRSF_FRAME_ATTITUDE_INDEX;
     }
     if (isBatteryVoltageConfigured() || isAmperageConfigured()) {
-        crsfSchedule[index++] = BV(CRSF_FRAME_BATTERY_SENSOR_INDEX);
+        crsfSchedule[index++] = CRSF_FRAME_BATTERY_SENSOR_INDEX;
     }
-    crsfSchedule[index++] = BV(CRSF_FRAME_FLIGHT_MODE_INDEX);
+    crsfSchedule[index++] = CRSF_FRAME_FLIGHT_MODE_INDEX;
     if (feature(FEATURE_GPS)) {
-        crsfSchedule[index++] = BV(CRSF_FRAME_GPS_INDEX);
+        crsfSchedule[index++] = CRSF_FRAME_GPS_INDEX;
     }
     crsfScheduleCount = (uint8_t)index;
+    for (int i = 0; i < crsfScheduleCount; i++) {
+        crsfScheduleSensors[i] = crsfFrameSensors[crsfSchedule[i]];
+    }
+    telemetrySchedulerInit(&crsfScheduler, crsfScheduleSensors, crsfScheduleSentAtMs, crsfScheduleCount);
 
  }
 
@@ -488,13 +511,24 @@ void handleCrsfTelemetry(timeUs_t currentTimeUs)
     }
     // Give the receiver a chance to send any outstanding telemetry data.
     // This needs to be done at high frequency, to enable the RX to send the telemetry frame
-    // in between the RX frames.
-    crsfRxSendTelemetryData();
+    // in between the RX frames. Nothing new can be queued until it has gone out.
+    if (!crsfRxSendTelemetryData()) {
+        return;
+    }
 
     // Send ad-hoc response frames as soon as possible
 #if defined(USE_MSP_OVER_TELEMETRY)
+    // A reply is streamed out one chunk per call, without waiting for the host to ask for the next one.
+    if (mspReplyChunksPending) {
+        mspReplyChunksPending = sendMspReply(CRSF_FRAME_TX_MSP_FRAME_SIZE, &crsfSendMspResponse);
+        crsfLastCycleTime = currentTimeUs; // reset telemetry timing due to ad-hoc request
+        return;
+    }
     if (mspReplyPending) {
-        mspReplyPending = handleCrsfMspFrameBuffer(CRSF_FRAME_TX_MSP_FRAME_SIZE, &crsfSendMspResponse);
+        if (handleCrsfMspFrameBuffer()) {
+            mspReplyChunksPending = sendMspReply(CRSF_FRAME_TX_MSP_FRAME_SIZE, &crsfSendMspResponse);
+        }
+        mspReplyPending = mspRxBuffer.len > 0;
         crsfLastCycleTime = currentTimeUs; // reset telemetry timing due to ad-hoc request
         return;
     }
@@ -535,11 +569,10 @@ void handleCrsfTelemetry(timeUs_t currentTimeUs)
     }
 #endif
 
-    // Actual telemetry data only needs to be sent at a low frequency, ie 10Hz
-    // Spread out scheduled frames evenly so each frame is sent at the same frequency.
-    if (currentTimeUs >= crsfLastCycleTime + (CRSF_CYCLETIME_US / crsfScheduleCount)) {
+    // Telemetry frames go out in fixed slots, each slot sends the frame the schedule wants most
+    if (currentTimeUs >= crsfLastCycleTime + CRSF_TELEMETRY_SLOT_US) {
         crsfLastCycleTime = currentTimeUs;
-        processCrsf();
+        processCrsf(currentTimeUs);
     }
 }
 
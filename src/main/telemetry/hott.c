@@ -71,6 +71,9 @@
 #include "common/time.h"
 
 #include "drivers/serial.h"
+#if defined(USE_SOFTSERIAL1) || defined(USE_SOFTSERIAL2)
+#include "drivers/serial_softserial.h"
+#endif
 #include "drivers/time.h"
 
 #include "fc/runtime_config.h"
@@ -109,6 +112,15 @@ static uint8_t hottMsgCrc;
 #define HOTT_BAUDRATE 19200
 #define HOTT_PORT_MODE MODE_RXTX // must be opened in RXTX so that TX and RX pins are allocated.
 
+#if defined(USE_SOFTSERIAL1) || defined(USE_SOFTSERIAL2)
+// The bit timer of a softserial port spaces the bytes, HOTT_TX_DELAY_US from start to start
+#define HOTT_TX_PACED
+#define HOTT_TX_GAP_BITS ((HOTT_TX_DELAY_US * HOTT_BAUDRATE) / 1000000 - 10)
+
+static bool hottTxPaced = false;
+static timeUs_t hottTxDoneAt;
+#endif
+
 static serialPort_t *hottPort = NULL;
 static serialPortConfig_t *portConfig;
 
@@ -383,6 +395,13 @@ void configureHoTTTelemetryPort(void)
         return;
     }
 
+#ifdef HOTT_TX_PACED
+    hottTxPaced = !hottIsUsingHardwareUART();
+    if (hottTxPaced) {
+        softSerialSetTxGap(hottPort, HOTT_TX_GAP_BITS);
+    }
+#endif
+
     hottConfigurePortForRX();
 
     hottTelemetryEnabled = true;
@@ -497,26 +516,48 @@ static void hottCheckSerialData(uint32_t currentMicros)
     }
 }
 
-static void hottSendTelemetryData(void) {
+static void hottSendNextByte(void)
+{
+    --hottMsgRemainingBytesToSendCount;
+    if (hottMsgRemainingBytesToSendCount == 0) {
+        hottSerialWrite(hottMsgCrc++);
+        return;
+    }
 
+    hottMsgCrc += *hottMsg;
+    hottSerialWrite(*hottMsg++);
+}
+
+static void hottSendTelemetryData(timeUs_t currentTimeUs)
+{
     if (!hottIsSending) {
         hottConfigurePortForTX();
         return;
     }
 
-    if (hottMsgRemainingBytesToSendCount == 0) {
-        hottConfigurePortForRX();
+#ifdef HOTT_TX_PACED
+    if (hottTxPaced) {
+        if (hottMsgRemainingBytesToSendCount) {
+            // the whole response is queued at once, the port sends a byte every HOTT_TX_DELAY_US
+            hottTxDoneAt = currentTimeUs + hottMsgRemainingBytesToSendCount * HOTT_TX_DELAY_US;
+            while (hottMsgRemainingBytesToSendCount) {
+                hottSendNextByte();
+            }
+        } else if (cmpTimeUs(currentTimeUs, hottTxDoneAt) >= 0) {
+            hottConfigurePortForRX();
+        }
         return;
     }
+#else
+    UNUSED(currentTimeUs);
+#endif
 
-    --hottMsgRemainingBytesToSendCount;
     if (hottMsgRemainingBytesToSendCount == 0) {
-        hottSerialWrite(hottMsgCrc++);
+        hottConfigurePortForRX();
         return;
     }
 
-    hottMsgCrc += *hottMsg;
-    hottSerialWrite(*hottMsg++);
+    hottSendNextByte();
 }
 
 static inline bool shouldPrepareHoTTMessages(uint32_t currentMicros)
@@ -572,7 +613,7 @@ void handleHoTTTelemetry(timeUs_t currentTimeUs)
             return;
         }
     }
-    hottSendTelemetryData();
+    hottSendTelemetryData(currentTimeUs);
     serialTimer = currentTimeUs;
 }
 
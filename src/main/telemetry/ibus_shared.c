@@ -409,14 +409,14 @@ static void setValue(uint8_t* bufferPtr, uint8_t sensorType, uint8_t length)
         case IBUS_SENSOR_TYPE_ROLL:
         case IBUS_SENSOR_TYPE_PITCH:
         case IBUS_SENSOR_TYPE_YAW:
-            value.int16 = attitude.raw[sensorType - IBUS_SENSOR_TYPE_ROLL] *10;
+            value.int16 = getAttitude()->raw[sensorType - IBUS_SENSOR_TYPE_ROLL] *10;
             break;
         case IBUS_SENSOR_TYPE_ARMED:
             value.uint16 = ARMING_FLAG(ARMED) ? 1 : 0;
             break;
 #if defined(USE_TELEMETRY_IBUS_EXTENDED)
         case IBUS_SENSOR_TYPE_CMP_HEAD:
-            value.uint16 = DECIDEGREES_TO_DEGREES(attitude.values.yaw);
+            value.uint16 = DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw);
             break;
         case IBUS_SENSOR_TYPE_VERTICAL_SPEED:
         case IBUS_SENSOR_TYPE_CLIMB_RATE:
@@ -27,6 +27,7 @@
 #ifdef USE_SERIAL_RX
 #ifdef USE_TELEMETRY
 
+#include "build/atomic.h"
 #include "build/build_config.h"
 #include "build/debug.h"
 #include "fc/runtime_config.h"
@@ -62,6 +63,7 @@
 #define EXTEL_OVERHEAD      (EXTEL_SYNC_LEN + EXTEL_HEADER_LEN + EXTEL_CRC_LEN)
 #define EXTEL_MAX_PAYLOAD   (EXTEL_MAX_LEN - EXTEL_OVERHEAD)
 #define EXBUS_MAX_REQUEST_BUFFER_SIZE   (EXBUS_OVERHEAD + EXTEL_MAX_LEN)
+#define EXBUS_NO_FRAME      0xFF
 
 enum exTelHeader_e {
     EXTEL_HEADER_SYNC = 0,
@@ -141,12 +143,25 @@ enum exSensors_e {
 
 #define JETI_EX_SENSOR_COUNT (ARRAYLEN(jetiExSensors))
 
-static uint8_t jetiExBusTelemetryFrame[40];
-static uint8_t jetiExBusTransceiveState = EXBUS_TRANS_RX;
+// position in the sequence of description and value messages
+typedef struct exBusTelemetrySequence_s {
+    uint8_t item;
+    uint8_t sensorDescriptionCounter;
+    uint8_t requestLoop;
+} exBusTelemetrySequence_t;
+
+// The next response is prebuilt by the telemetry task and sent by the rx ISR as soon as a request
+// has been received, the task refreshes one frame while the other one is waiting for the request.
+static uint8_t jetiExBusTelemetryFrame[2][40];
+static exBusTelemetrySequence_t jetiExBusFrameSequence[2];      // sequence after each of the frames
+static exBusTelemetrySequence_t jetiExBusSequence = { .item = 0, .sensorDescriptionCounter = 0xFF, .requestLoop = 0xFF };
+static volatile uint8_t jetiExBusReadyFrame = EXBUS_NO_FRAME;
+static volatile uint8_t jetiExBusSentFrame = EXBUS_NO_FRAME;
+static volatile uint8_t jetiExBusTransceiveState = EXBUS_TRANS_ZERO;
+static uint8_t jetiExBusIsrPriority;                           // of the ISR running the rx callback
 static uint8_t firstActiveSensor = 0;
 static uint32_t exSensorEnabled = 0;
 
-static uint8_t sendJetiExBusTelemetry(uint8_t packetID, uint8_t item);
 static uint8_t getNextActiveSensor(uint8_t currentSensor);
 
 // Jeti Ex Telemetry CRC calculations for a frame
@@ -167,20 +182,24 @@ uint8_t calcCRC8(uint8_t *pt, uint8_t msgLen)
  */
 void initJetiExBusTelemetry(void)
 {
-    // Init Ex Bus Frame header
-    jetiExBusTelemetryFrame[EXBUS_HEADER_SYNC] = 0x3B;       // Startbytes
-    jetiExBusTelemetryFrame[EXBUS_HEADER_REQ] = 0x01;
-    jetiExBusTelemetryFrame[EXBUS_HEADER_DATA_ID] = 0x3A;    // Ex Telemetry
-
-    // Init Ex Telemetry header
-    uint8_t *jetiExTelemetryFrame = &jetiExBusTelemetryFrame[EXBUS_HEADER_DATA];
-
-    jetiExTelemetryFrame[EXTEL_HEADER_SYNC] = 0x9F;              // Startbyte
-    jetiExTelemetryFrame[EXTEL_HEADER_USN_LB] = 0x1E;            // Serial Number 4 Byte
-    jetiExTelemetryFrame[EXTEL_HEADER_USN_HB] = 0xA4;
-    jetiExTelemetryFrame[EXTEL_HEADER_LSN_LB] = 0x00;            // increment by telemetry count (%16) > only 15 values per device possible
-    jetiExTelemetryFrame[EXTEL_HEADER_LSN_HB] = 0x00;
-    jetiExTelemetryFrame[EXTEL_HEADER_RES] = 0x00;               // reserved, by default 0x00
+    for (unsigned i = 0; i < ARRAYLEN(jetiExBusTelemetryFrame); i++) {
+        // Init Ex Bus Frame header
+        uint8_t *exBusFrame = jetiExBusTelemetryFrame[i];
+
+        exBusFrame[EXBUS_HEADER_SYNC] = 0x3B;       // Startbytes
+        exBusFrame[EXBUS_HEADER_REQ] = 0x01;
+        exBusFrame[EXBUS_HEADER_DATA_ID] = 0x3A;    // Ex Telemetry
+
+        // Init Ex Telemetry header
+        uint8_t *jetiExTelemetryFrame = &exBusFrame[EXBUS_HEADER_DATA];
+
+        jetiExTelemetryFrame[EXTEL_HEADER_SYNC] = 0x9F;              // Startbyte
+        jetiExTelemetryFrame[EXTEL_HEADER_USN_LB] = 0x1E;            // Serial Number 4 Byte
+        jetiExTelemetryFrame[EXTEL_HEADER_USN_HB] = 0xA4;
+        jetiExTelemetryFrame[EXTEL_HEADER_LSN_LB] = 0x00;            // increment by telemetry count (%16) > only 15 values per device possible
+        jetiExTelemetryFrame[EXTEL_HEADER_LSN_HB] = 0x00;
+        jetiExTelemetryFrame[EXTEL_HEADER_RES] = 0x00;               // reserved, by default 0x00
+    }
 
     //exSensorEnabled = 0x3fe;
     // Check which sensors are available
@@ -248,15 +267,15 @@ int32_t getSensorValue(uint8_t sensor)
         break;
 
     case EX_ROLL_ANGLE:
-        return attitude.values.roll;
+        return getAttitude()->values.roll;
         break;
 
     case EX_PITCH_ANGLE:
-        return attitude.values.pitch;
+        return getAttitude()->values.pitch;
         break;
 
     case EX_HEADING:
-        return attitude.values.yaw;
+        return getAttitude()->values.yaw;
         break;
 
     case EX_VARIO:
@@ -340,80 +359,112 @@ void checkJetiExBusTelemetryState(void)
     return;
 }
 
-void handleJetiExBusTelemetry(void)
+static void prepareJetiExBusTelemetry(uint8_t *exBusFrame, exBusTelemetrySequence_t *sequence)
 {
-    static uint16_t framesLost = 0; // only for debug
-    static uint8_t item = 0;
-    uint32_t timeDiff;
-
-    // Check if we shall reset frame position due to time
-    if (jetiExBusRequestState == EXBUS_STATE_RECEIVED) {
+    uint8_t *jetiExTelemetryFrame = &exBusFrame[EXBUS_HEADER_DATA];
 
-        // to prevent timing issues from request to answer - max. 4ms
-        timeDiff = micros() - jetiTimeStampRequest;
-
-        if (timeDiff > 3000) {   // include reserved time
-            jetiExBusRequestState = EXBUS_STATE_ZERO;
-            framesLost++;
-            return;
+    if (sequence->requestLoop) {
+        while( ++sequence->sensorDescriptionCounter < JETI_EX_SENSOR_COUNT) {
+            if (bitArrayGet(&exSensorEnabled, sequence->sensorDescriptionCounter) || (jetiExSensors[sequence->sensorDescriptionCounter].exDataType == EX_TYPE_DES)) {
+                break;
+            }
+        }
+        if (sequence->sensorDescriptionCounter == JETI_EX_SENSOR_COUNT ) {
+            sequence->sensorDescriptionCounter = 0;
         }
 
-        if ((jetiExBusRequestFrame[EXBUS_HEADER_DATA_ID] == EXBUS_EX_REQUEST) && (jetiExBusCalcCRC16(jetiExBusRequestFrame, jetiExBusRequestFrame[EXBUS_HEADER_MSG_LEN]) == 0)) {
-            // switch to TX mode
-            if (serialRxBytesWaiting(jetiExBusPort) == 0) {
-                serialSetMode(jetiExBusPort, MODE_TX);
-                jetiExBusTransceiveState = EXBUS_TRANS_TX;
-                item = sendJetiExBusTelemetry(jetiExBusRequestFrame[EXBUS_HEADER_PACKET_ID], item);
-                jetiExBusRequestState = EXBUS_STATE_PROCESSED;
-                return;
-            }
-        } else {
-            jetiExBusRequestState = EXBUS_STATE_ZERO;
-            return;
+        createExTelemetryTextMessage(jetiExTelemetryFrame, sequence->sensorDescriptionCounter, &jetiExSensors[sequence->sensorDescriptionCounter]);
+        sequence->requestLoop--;
+        if (sequence->requestLoop == 0){
+            sequence->item = firstActiveSensor;
         }
+    } else {
+        sequence->item = createExTelemetryValueMessage(jetiExTelemetryFrame, sequence->item);
     }
+}
 
-    // check the state if transmit is ready
-    if (jetiExBusTransceiveState == EXBUS_TRANS_IS_TX_COMPLETED) {
-        if (isSerialTransmitBufferEmpty(jetiExBusPort)) {
-            serialSetMode(jetiExBusPort, MODE_RX);
-            jetiExBusTransceiveState = EXBUS_TRANS_RX;
-            jetiExBusRequestState = EXBUS_STATE_ZERO;
-        }
+// Called from the rx ISR with a request that has passed its CRC check. Only the packet ID and the
+// EX Bus CRC of the prebuilt frame depend on the request, so the answer goes out straight away.
+// The port is left in MODE_RXTX by the task, the driver turns the half duplex line around.
+bool sendJetiExBusTelemetryResponse(uint8_t packetID)
+{
+    const uint8_t frame = jetiExBusReadyFrame;
+
+    if (frame == EXBUS_NO_FRAME || jetiExBusTransceiveState != EXBUS_TRANS_RX) {
+        return false;
+    }
+    // the receiver is still sending, the line is not ours yet
+    if (serialRxBytesWaiting(jetiExBusPort) != 0) {
+        return false;
     }
+    jetiExBusReadyFrame = EXBUS_NO_FRAME;
+    jetiExBusSentFrame = frame;
+
+    uint8_t *exBusFrame = jetiExBusTelemetryFrame[frame];
+    createExBusMessage(exBusFrame, &exBusFrame[EXBUS_HEADER_DATA], packetID);
+
+    jetiExBusTransceiveState = EXBUS_TRANS_IS_TX_COMPLETED;
+    serialWriteBuf(jetiExBusPort, exBusFrame, exBusFrame[EXBUS_HEADER_MSG_LEN]);
+
+    return true;
 }
 
-uint8_t sendJetiExBusTelemetry(uint8_t packetID, uint8_t item)
+// A half duplex uart hears its own response, the rx ISR drops those bytes
+bool jetiExBusTelemetryTransmitting(void)
 {
-    static uint8_t sensorDescriptionCounter = 0xFF;
-    static uint8_t requestLoop = 0xFF;
-    uint8_t *jetiExTelemetryFrame = &jetiExBusTelemetryFrame[EXBUS_HEADER_DATA];
+    return jetiExBusTransceiveState == EXBUS_TRANS_IS_TX_COMPLETED && !isSerialTransmitBufferEmpty(jetiExBusPort);
+}
 
-    if (requestLoop) {
-        while( ++sensorDescriptionCounter < JETI_EX_SENSOR_COUNT) {
-            if (bitArrayGet(&exSensorEnabled, sensorDescriptionCounter) || (jetiExSensors[sensorDescriptionCounter].exDataType == EX_TYPE_DES)) {
-                break;
-            }
-        }
-        if (sensorDescriptionCounter == JETI_EX_SENSOR_COUNT ) {
-            sensorDescriptionCounter = 0;
+void handleJetiExBusTelemetry(void)
+{
+    // Switching the port over takes a reconfiguration of the uart, too slow for the rx ISR. It is
+    // done once here, from then on the port receives and transmits without being switched.
+    if (jetiExBusTransceiveState == EXBUS_TRANS_ZERO) {
+        if (!jetiExBusPort) {
+            return;
         }
+        // the rx callback runs in the timer ISR on a softserial port, in the uart or rx DMA ISR
+        // otherwise, no uart ISR is more urgent than those of UART1
+        jetiExBusIsrPriority = (jetiExBusPort->identifier >= SERIAL_PORT_SOFTSERIAL1) ? NVIC_PRIO_TIMER : NVIC_PRIO_SERIALUART1;
+        serialSetMode(jetiExBusPort, MODE_RXTX);
+        jetiExBusTransceiveState = EXBUS_TRANS_RX;
+    }
 
-        createExTelemetryTextMessage(jetiExTelemetryFrame, sensorDescriptionCounter, &jetiExSensors[sensorDescriptionCounter]);
-        createExBusMessage(jetiExBusTelemetryFrame, jetiExTelemetryFrame, packetID);
-        requestLoop--;
-        if (requestLoop == 0){
-            item = firstActiveSensor;
+    // a request the rx ISR did not answer, there was no frame ready or it was not an EX telemetry request
+    if (jetiExBusRequestState == EXBUS_STATE_RECEIVED) {
+        jetiExBusRequestState = EXBUS_STATE_ZERO;
+    }
+
+    // check the state if transmit is ready
+    if (jetiExBusTransceiveState == EXBUS_TRANS_IS_TX_COMPLETED) {
+        if (!isSerialTransmitBufferEmpty(jetiExBusPort)) {
+            return;
         }
-    } else {
-        item = createExTelemetryValueMessage(jetiExTelemetryFrame, item);
-        createExBusMessage(jetiExBusTelemetryFrame, jetiExTelemetryFrame, packetID);
+        jetiExBusTransceiveState = EXBUS_TRANS_RX;
+        jetiExBusRequestState = EXBUS_STATE_ZERO;
     }
 
-    serialWriteBuf(jetiExBusPort, jetiExBusTelemetryFrame, jetiExBusTelemetryFrame[EXBUS_HEADER_MSG_LEN]);
-    jetiExBusTransceiveState = EXBUS_TRANS_IS_TX_COMPLETED;
+    // move on in the sequence once a frame has gone out
+    const uint8_t sentFrame = jetiExBusSentFrame;
+    if (sentFrame != EXBUS_NO_FRAME) {
+        jetiExBusSequence = jetiExBusFrameSequence[sentFrame];
+        jetiExBusSentFrame = EXBUS_NO_FRAME;
+    }
+
+    // rebuild the next frame with the latest values in the buffer the ISR is not going to send,
+    // and swap it in unless the ISR has taken the previous one meanwhile
+    const uint8_t readyFrame = jetiExBusReadyFrame;
+    const uint8_t nextFrame = (readyFrame == 0) ? 1 : 0;
+    exBusTelemetrySequence_t sequence = jetiExBusSequence;
+
+    prepareJetiExBusTelemetry(jetiExBusTelemetryFrame[nextFrame], &sequence);
+    jetiExBusFrameSequence[nextFrame] = sequence;
 
-    return item;
+    ATOMIC_BLOCK(jetiExBusIsrPriority) {
+        if (jetiExBusReadyFrame == readyFrame) {
+            jetiExBusReadyFrame = nextFrame;
+        }
+    }
 }
 #endif // TELEMETRY
 #endif // SERIAL_RX
@@ -23,3 +23,5 @@
 void initJetiExBusTelemetry(void);
 void checkJetiExBusTelemetryState(void);
 void handleJetiExBusTelemetry(void);
+bool sendJetiExBusTelemetryResponse(uint8_t packetID);
+bool jetiExBusTelemetryTransmitting(void);
@@ -209,9 +209,9 @@ static void ltm_sframe(void)
 static void ltm_aframe(void)
 {
     ltm_initialise_packet('A');
-    ltm_serialise_16(DECIDEGREES_TO_DEGREES(attitude.values.pitch));
-    ltm_serialise_16(DECIDEGREES_TO_DEGREES(attitude.values.roll));
-    ltm_serialise_16(DECIDEGREES_TO_DEGREES(attitude.values.yaw));
+    ltm_serialise_16(DECIDEGREES_TO_DEGREES(getAttitude()->values.pitch));
+    ltm_serialise_16(DECIDEGREES_TO_DEGREES(getAttitude()->values.roll));
+    ltm_serialise_16(DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw));
     ltm_finalise();
 }
 
@@ -79,10 +79,13 @@
 #include "common/mavlink.h"
 #pragma GCC diagnostic pop
 
-#define TELEMETRY_MAVLINK_INITIAL_PORT_MODE MODE_TX
+#define TELEMETRY_MAVLINK_INITIAL_PORT_MODE MODE_RXTX
 #define TELEMETRY_MAVLINK_MAXRATE 50
 #define TELEMETRY_MAVLINK_DELAY ((1000 * 1000) / TELEMETRY_MAVLINK_MAXRATE)
 
+// not in the bundled MAVLink headers yet
+#define MAVLINK_CMD_SET_MESSAGE_INTERVAL 511
+
 extern uint16_t rssi; // FIXME dependency on mw.c
 
 static serialPort_t *mavlinkPort = NULL;
@@ -91,8 +94,8 @@ static serialPortConfig_t *portConfig;
 static bool mavlinkTelemetryEnabled =  false;
 static portSharing_e mavlinkPortSharing;
 
-/* MAVLink datastream rates in Hz */
-static const uint8_t mavRates[] = {
+/* Default MAVLink datastream rates in Hz */
+static const uint8_t mavDefaultRates[] = {
     [MAV_DATA_STREAM_EXTENDED_STATUS] = 2, //2Hz
     [MAV_DATA_STREAM_RC_CHANNELS] = 5, //5Hz
     [MAV_DATA_STREAM_POSITION] = 2, //2Hz
@@ -100,11 +103,16 @@ static const uint8_t mavRates[] = {
     [MAV_DATA_STREAM_EXTRA2] = 10 //2Hz
 };
 
-#define MAXSTREAMS (sizeof(mavRates) / sizeof(mavRates[0]))
+#define MAXSTREAMS (sizeof(mavDefaultRates) / sizeof(mavDefaultRates[0]))
 
+// the ground station can change these with REQUEST_DATA_STREAM or SET_MESSAGE_INTERVAL
+static uint8_t mavRates[MAXSTREAMS];
 static uint8_t mavTicks[MAXSTREAMS];
 static mavlink_message_t mavMsg;
+static mavlink_message_t mavRxMsg;
+// the messages of one tick are collected here and written to the port in one go
 static uint8_t mavBuffer[MAVLINK_MAX_PACKET_LEN];
+static uint16_t mavBufferLength;
 static uint32_t lastMavlinkMessage = 0;
 
 static int mavlinkStreamTrigger(enum MAV_DATA_STREAM streamNum)
@@ -130,10 +138,125 @@ static int mavlinkStreamTrigger(enum MAV_DATA_STREAM streamNum)
 }
 
 
-static void mavlinkSerialWrite(uint8_t * buf, uint16_t length)
+static void mavlinkFlush(void)
+{
+    if (mavBufferLength) {
+        serialWriteBuf(mavlinkPort, mavBuffer, mavBufferLength);
+        mavBufferLength = 0;
+    }
+}
+
+static void mavlinkSendMessage(void)
+{
+    const uint16_t msgLength = MAVLINK_NUM_NON_PAYLOAD_BYTES + mavMsg.len;
+
+    if (mavBufferLength + msgLength > sizeof(mavBuffer)) {
+        mavlinkFlush();
+    }
+
+    // drop the message rather than wait for the port, the stream catches up on its next trigger
+    if (mavBufferLength + msgLength > serialTxBytesFree(mavlinkPort)) {
+        return;
+    }
+
+    mavBufferLength += mavlink_msg_to_send_buffer(&mavBuffer[mavBufferLength], &mavMsg);
+}
+
+static void mavlinkSetStreamRate(uint8_t streamNum, uint16_t rate)
+{
+    if (streamNum == MAV_DATA_STREAM_ALL) {
+        for (unsigned i = 0; i < MAXSTREAMS; i++) {
+            if (mavDefaultRates[i]) {
+                mavlinkSetStreamRate(i, rate);
+            }
+        }
+    } else if (streamNum < MAXSTREAMS) {
+        mavRates[streamNum] = MIN(rate, TELEMETRY_MAVLINK_MAXRATE);
+        mavTicks[streamNum] = 0;
+    }
+}
+
+static int mavlinkStreamForMessage(uint16_t msgId)
+{
+    switch (msgId) {
+    case MAVLINK_MSG_ID_SYS_STATUS:
+        return MAV_DATA_STREAM_EXTENDED_STATUS;
+    case MAVLINK_MSG_ID_RC_CHANNELS_RAW:
+        return MAV_DATA_STREAM_RC_CHANNELS;
+    case MAVLINK_MSG_ID_GPS_RAW_INT:
+    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+    case MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN:
+        return MAV_DATA_STREAM_POSITION;
+    case MAVLINK_MSG_ID_ATTITUDE:
+        return MAV_DATA_STREAM_EXTRA1;
+    case MAVLINK_MSG_ID_VFR_HUD:
+    case MAVLINK_MSG_ID_HEARTBEAT:
+        return MAV_DATA_STREAM_EXTRA2;
+    default:
+        return -1;
+    }
+}
+
+static void mavlinkHandleCommand(const mavlink_command_long_t *command)
+{
+    uint8_t result = MAV_RESULT_UNSUPPORTED;
+
+    if (command->command == MAVLINK_CMD_SET_MESSAGE_INTERVAL) {
+        // param1 is the message id, param2 the interval in us, -1 to stop and 0 for the default
+        const int streamNum = mavlinkStreamForMessage((uint16_t)command->param1);
+        if (streamNum >= 0) {
+            uint8_t rate;
+            if (command->param2 < 0) {
+                rate = 0;
+            } else if (command->param2 == 0) {
+                rate = mavDefaultRates[streamNum];
+            } else {
+                rate = constrainf(1000000.0f / command->param2, 1, TELEMETRY_MAVLINK_MAXRATE);
+            }
+            // the messages of a stream share its rate
+            mavlinkSetStreamRate(streamNum, rate);
+            result = MAV_RESULT_ACCEPTED;
+        }
+    }
+
+    mavlink_msg_command_ack_pack(0, 200, &mavMsg, command->command, result);
+    mavlinkSendMessage();
+}
+
+static void mavlinkHandleMessage(const mavlink_message_t *msg)
+{
+    switch (msg->msgid) {
+    case MAVLINK_MSG_ID_REQUEST_DATA_STREAM: {
+        mavlink_request_data_stream_t request;
+        mavlink_msg_request_data_stream_decode(msg, &request);
+        // the requested rate is in Hz
+        mavlinkSetStreamRate(request.req_stream_id, request.start_stop ? request.req_message_rate : 0);
+        break;
+    }
+    case MAVLINK_MSG_ID_COMMAND_LONG: {
+        mavlink_command_long_t command;
+        mavlink_msg_command_long_decode(msg, &command);
+        mavlinkHandleCommand(&command);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static void mavlinkReceive(void)
 {
-    for (int i = 0; i < length; i++)
-        serialWrite(mavlinkPort, buf[i]);
+    // when the port is shared with serial RX the incoming bytes belong to the receiver
+    if (mavlinkPort == telemetrySharedPort) {
+        return;
+    }
+
+    mavlink_status_t status;
+    while (serialRxBytesWaiting(mavlinkPort)) {
+        if (mavlink_parse_char(MAVLINK_COMM_0, serialRead(mavlinkPort), &mavRxMsg, &status)) {
+            mavlinkHandleMessage(&mavRxMsg);
+        }
+    }
 }
 
 void freeMAVLinkTelemetryPort(void)
@@ -147,6 +270,8 @@ void initMAVLinkTelemetry(void)
 {
     portConfig = findSerialPortConfig(FUNCTION_TELEMETRY_MAVLINK);
     mavlinkPortSharing = determinePortSharing(portConfig, FUNCTION_TELEMETRY_MAVLINK);
+
+    memcpy(mavRates, mavDefaultRates, sizeof(mavRates));
 }
 
 void configureMAVLinkTelemetryPort(void)
@@ -193,8 +318,6 @@ void checkMAVLinkTelemetryState(void)
 
 void mavlinkSendSystemStatus(void)
 {
-    uint16_t msgLength;
-
     uint32_t onboardControlAndSensors = 35843;
 
     /*
@@ -252,13 +375,11 @@ void mavlinkSendSystemStatus(void)
         0,
         // errors_count4 Autopilot-specific errors
         0);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 
 void mavlinkSendRCChannelsAndRSSI(void)
 {
-    uint16_t msgLength;
     mavlink_msg_rc_channels_raw_pack(0, 200, &mavMsg,
         // time_boot_ms Timestamp (milliseconds since system boot)
         millis(),
@@ -282,14 +403,12 @@ void mavlinkSendRCChannelsAndRSSI(void)
         (rxRuntimeConfig.channelCount >= 8) ? rcData[7] : 0,
         // rssi Receive signal strength indicator, 0: 0%, 255: 100%
         constrain(scaleRange(getRssi(), 0, RSSI_MAX_VALUE, 0, 255), 0, 255));
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 
 #if defined(USE_GPS)
 void mavlinkSendPosition(void)
 {
-    uint16_t msgLength;
     uint8_t gpsFixType = 0;
 
     if (!sensors(SENSOR_GPS))
@@ -328,8 +447,7 @@ void mavlinkSendPosition(void)
         gpsSol.groundCourse * 10,
         // satellites_visible Number of satellites visible. If unknown, set to 255
         gpsSol.numSat);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 
     // Global position
     mavlink_msg_global_position_int_pack(0, 200, &mavMsg,
@@ -354,10 +472,9 @@ void mavlinkSendPosition(void)
         // Ground Z Speed (Altitude), expressed as m/s * 100
         0,
         // heading Current heading in degrees, in compass units (0..360, 0=north)
-        DECIDEGREES_TO_DEGREES(attitude.values.yaw)
+        DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw)
     );
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 
     mavlink_msg_gps_global_origin_pack(0, 200, &mavMsg,
         // latitude Latitude (WGS84), expressed as * 1E7
@@ -366,36 +483,32 @@ void mavlinkSendPosition(void)
         GPS_home[LON],
         // altitude Altitude(WGS84), expressed as * 1000
         0);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 #endif
 
 void mavlinkSendAttitude(void)
 {
-    uint16_t msgLength;
     mavlink_msg_attitude_pack(0, 200, &mavMsg,
         // time_boot_ms Timestamp (milliseconds since system boot)
         millis(),
         // roll Roll angle (rad)
-        DECIDEGREES_TO_RADIANS(attitude.values.roll),
+        DECIDEGREES_TO_RADIANS(getAttitude()->values.roll),
         // pitch Pitch angle (rad)
-        DECIDEGREES_TO_RADIANS(-attitude.values.pitch),
+        DECIDEGREES_TO_RADIANS(-getAttitude()->values.pitch),
         // yaw Yaw angle (rad)
-        DECIDEGREES_TO_RADIANS(attitude.values.yaw),
+        DECIDEGREES_TO_RADIANS(getAttitude()->values.yaw),
         // rollspeed Roll angular speed (rad/s)
         0,
         // pitchspeed Pitch angular speed (rad/s)
         0,
         // yawspeed Yaw angular speed (rad/s)
         0);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 
 void mavlinkSendHUDAndHeartbeat(void)
 {
-    uint16_t msgLength;
     float mavAltitude = 0;
     float mavGroundSpeed = 0;
     float mavAirSpeed = 0;
@@ -433,15 +546,14 @@ void mavlinkSendHUDAndHeartbeat(void)
         // groundspeed Current ground speed in m/s
         mavGroundSpeed,
         // heading Current heading in degrees, in compass units (0..360, 0=north)
-        DECIDEGREES_TO_DEGREES(attitude.values.yaw),
+        DECIDEGREES_TO_DEGREES(getAttitude()->values.yaw),
         // throttle Current throttle setting in integer percent, 0 to 100
         scaleRange(constrain(rcData[THROTTLE], PWM_RANGE_MIN, PWM_RANGE_MAX), PWM_RANGE_MIN, PWM_RANGE_MAX, 0, 100),
         // alt Current altitude (MSL), in meters, if we have sonar or baro use them, otherwise use GPS (less accurate)
         mavAltitude,
         // climb Current climb rate in meters/second
         mavClimbRate);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 
 
     uint8_t mavModes = MAV_MODE_FLAG_MANUAL_INPUT_ENABLED;
@@ -522,8 +634,7 @@ void mavlinkSendHUDAndHeartbeat(void)
         mavCustomMode,
         // system_status System status flag, see MAV_STATE ENUM
         mavSystemState);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 
 void processMAVLinkTelemetry(void)
@@ -550,6 +661,8 @@ void processMAVLinkTelemetry(void)
     if (mavlinkStreamTrigger(MAV_DATA_STREAM_EXTRA2)) {
         mavlinkSendHUDAndHeartbeat();
     }
+
+    mavlinkFlush();
 }
 
 void handleMAVLinkTelemetry(void)
@@ -562,6 +675,8 @@ void handleMAVLinkTelemetry(void)
         return;
     }
 
+    mavlinkReceive();
+
     uint32_t now = micros();
     if ((now - lastMavlinkMessage) >= TELEMETRY_MAVLINK_DELAY) {
         processMAVLinkTelemetry();
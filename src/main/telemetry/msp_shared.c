@@ -212,7 +212,7 @@ bool sendMspReply(uint8_t payloadSize, mspResponseFnPtr responseFn)
         sbufReadData(txBuf, frame, payloadBytesRemaining);
         sbufAdvance(txBuf, payloadBytesRemaining);
         sbufWriteData(payloadBuf, frame, payloadBytesRemaining);
-        responseFn(payloadOut);
+        responseFn(payloadOut, payloadSize);
 
         return true;
 
@@ -229,14 +229,15 @@ bool sendMspReply(uint8_t payloadSize, mspResponseFnPtr responseFn)
             checksum ^= sbufReadU8(txBuf);
         }
         sbufWriteU8(payloadBuf, checksum);
+    }
 
-        while (sbufBytesRemaining(payloadBuf)>1) {
-            sbufWriteU8(payloadBuf, 0);
-        }
-
+    // the last chunk is passed on with its actual length, links with fixed size frames send the zero padding
+    const uint8_t chunkSize = payloadBuf->ptr - payloadOut;
+    while (sbufBytesRemaining(payloadBuf)) {
+        sbufWriteU8(payloadBuf, 0);
     }
 
-    responseFn(payloadOut);
+    responseFn(payloadOut, chunkSize);
     return false;
 }
 
@@ -78,6 +78,7 @@
 
 #include "telemetry/telemetry.h"
 #include "telemetry/smartport.h"
+#include "telemetry/telemetry_scheduler.h"
 #include "telemetry/msp_shared.h"
 
 #define SMARTPORT_MIN_TELEMETRY_RESPONSE_DELAY_US 500
@@ -147,31 +148,29 @@ enum
 // if adding more sensors then increase this value
 #define MAX_DATAIDS 17
 
-static uint16_t frSkyDataIdTable[MAX_DATAIDS];
-
 #ifdef USE_ESC_SENSOR
-// number of sensors to send between sending the ESC sensors
-#define ESC_SENSOR_PERIOD 7
-
-static uint16_t frSkyEscDataIdTable[] = {
+static const uint16_t frSkyEscDataIdTable[] = {
     FSSP_DATAID_CURRENT   ,
     FSSP_DATAID_RPM       ,
     FSSP_DATAID_VFAS      ,
     FSSP_DATAID_TEMP
 };
-#endif
 
-typedef struct frSkyTableInfo_s {
-    uint16_t * table;
-    uint8_t size;
-    uint8_t index;
-} frSkyTableInfo_t;
+#define ESC_DATAID_COUNT ARRAYLEN(frSkyEscDataIdTable)
+#else
+#define ESC_DATAID_COUNT 0
+#endif
 
-static frSkyTableInfo_t frSkyDataIdTableInfo = {frSkyDataIdTable, 0, 0};
+// the data ids we send and how often, the ESC ones come last
+static uint16_t frSkyDataIdTable[MAX_DATAIDS + ESC_DATAID_COUNT];
+static telemetrySensor_t frSkyDataIdSensors[MAX_DATAIDS + ESC_DATAID_COUNT];
+static timeMs_t frSkyDataIdSentAtMs[MAX_DATAIDS + ESC_DATAID_COUNT];
+static uint8_t frSkyDataIdCount;
+static telemetryScheduler_t frSkyDataIdScheduler;
+static uint8_t frSkySensorsAvailable;
 #ifdef USE_ESC_SENSOR
-#define ESC_DATAID_COUNT sizeof(frSkyEscDataIdTable)/sizeof(uint16_t)
-
-static frSkyTableInfo_t frSkyEscDataIdTableInfo = {frSkyEscDataIdTable, ESC_DATAID_COUNT, 0};
+static uint8_t frSkyEscDataIdStart;
+static uint8_t frSkyEscDataIdOffset[ESC_DATAID_COUNT];    // combined, then each motor in turn
 #endif
 
 #define __USE_C99_MATH // for roundf()
@@ -271,19 +270,21 @@ smartPortPayload_t *smartPortDataReceive(uint16_t c, bool *clearToSend, smartPor
     return NULL;
 }
 
-void smartPortSendByte(uint8_t c, uint16_t *checksum, serialPort_t *port)
+static uint8_t *smartPortStuffByte(uint8_t *dst, uint8_t c, uint16_t *checksum)
 {
     // smart port escape sequence
     if (c == FSSP_DLE || c == FSSP_START_STOP) {
-        serialWrite(port, FSSP_DLE);
-        serialWrite(port, c ^ FSSP_DLE_XOR);
+        *dst++ = FSSP_DLE;
+        *dst++ = c ^ FSSP_DLE_XOR;
     } else {
-        serialWrite(port, c);
+        *dst++ = c;
     }
 
     if (checksum != NULL) {
         *checksum += c;
     }
+
+    return dst;
 }
 
 bool smartPortPayloadContainsMSP(const smartPortPayload_t *payload)
@@ -292,19 +293,31 @@ bool smartPortPayloadContainsMSP(const smartPortPayload_t *payload)
 }
 
 
-void smartPortWriteFrameSerial(const smartPortPayload_t *payload, serialPort_t *port, uint16_t checksum)
+void smartPortWriteFrameSerial(const smartPortPayload_t *payload, serialPort_t *port, const uint8_t *header, uint8_t headerLength)
 {
-    uint8_t *data = (uint8_t *)payload;
+    // the escaped frame is built in one pass and handed over in one write, so the UART copies it
+    // into its TX buffer and starts transmitting once instead of once per byte.
+    // Worst case every byte gets escaped.
+    uint8_t frame[2 * (SMARTPORT_FRAME_HEADER_MAX_LENGTH + sizeof(smartPortPayload_t) + 1)];
+    uint8_t *dst = frame;
+    uint16_t checksum = 0;
+
+    for (unsigned i = 0; i < MIN(headerLength, SMARTPORT_FRAME_HEADER_MAX_LENGTH); i++) {
+        dst = smartPortStuffByte(dst, header[i], &checksum);
+    }
+    const uint8_t *data = (const uint8_t *)payload;
     for (unsigned i = 0; i < sizeof(smartPortPayload_t); i++) {
-        smartPortSendByte(*data++, &checksum, port);
+        dst = smartPortStuffByte(dst, *data++, &checksum);
     }
     checksum = 0xff - ((checksum & 0xff) + (checksum >> 8));
-    smartPortSendByte((uint8_t)checksum, NULL, port);
+    dst = smartPortStuffByte(dst, (uint8_t)checksum, NULL);
+
+    serialWriteBuf(port, frame, dst - frame);
 }
 
 static void smartPortWriteFrameInternal(const smartPortPayload_t *payload)
 {
-    smartPortWriteFrameSerial(payload, smartPortSerialPort, 0);
+    smartPortWriteFrameSerial(payload, smartPortSerialPort, NULL, 0);
 }
 
 static void smartPortSendPackage(uint16_t id, uint32_t val)
@@ -317,69 +330,111 @@ static void smartPortSendPackage(uint16_t id, uint32_t val)
     smartPortWriteFrame(&payload);
 }
 
-#define ADD_SENSOR(dataId) frSkyDataIdTableInfo.table[frSkyDataIdTableInfo.index++] = dataId
+static void addSmartPortSensor(uint16_t dataId, uint16_t intervalMs, uint8_t priority)
+{
+    frSkyDataIdTable[frSkyDataIdCount] = dataId;
+    frSkyDataIdSensors[frSkyDataIdCount].intervalMs = intervalMs;
+    frSkyDataIdSensors[frSkyDataIdCount].priority = priority;
+    frSkyDataIdCount++;
+}
+
+// interval in ms and priority of each data id, the fast changing flight values get the most airtime
+#define ADD_SENSOR(dataId, intervalMs, priority) addSmartPortSensor(dataId, intervalMs, priority)
+
+// everything initSmartPortSensors() looks at, the sensor table only needs rebuilding when this changes
+static uint8_t smartPortSensorsAvailable(void)
+{
+    uint8_t available = 0;
+
+    if (isBatteryVoltageConfigured()) {
+        available |= BIT(0);
+    }
+    if (isAmperageConfigured()) {
+        available |= BIT(1);
+    }
+    if (sensors(SENSOR_ACC)) {
+        available |= BIT(2);
+    }
+    if (sensors(SENSOR_BARO)) {
+        available |= BIT(3);
+    }
+#ifdef USE_GPS
+    if (feature(FEATURE_GPS)) {
+        available |= BIT(4);
+    }
+#endif
+#ifdef USE_ESC_SENSOR
+    if (feature(FEATURE_ESC_SENSOR)) {
+        available |= BIT(5);
+    }
+#endif
+
+    return available;
+}
 
 static void initSmartPortSensors(void)
 {
-    frSkyDataIdTableInfo.index = 0;
+    frSkyDataIdCount = 0;
+    frSkySensorsAvailable = smartPortSensorsAvailable();
 
-    ADD_SENSOR(FSSP_DATAID_T1);
-    ADD_SENSOR(FSSP_DATAID_T2);
+    ADD_SENSOR(FSSP_DATAID_T1, 500, 2);
+    ADD_SENSOR(FSSP_DATAID_T2, 1000, 1);
 
     if (isBatteryVoltageConfigured()) {
 #ifdef USE_ESC_SENSOR
         if (!feature(FEATURE_ESC_SENSOR)) {
 #endif
-            ADD_SENSOR(FSSP_DATAID_VFAS);
+            ADD_SENSOR(FSSP_DATAID_VFAS, 500, 2);
 #ifdef USE_ESC_SENSOR
         }
 #endif
-        ADD_SENSOR(FSSP_DATAID_A4);
+        ADD_SENSOR(FSSP_DATAID_A4, 1000, 1);
     }
 
     if (isAmperageConfigured()) {
 #ifdef USE_ESC_SENSOR
         if (!feature(FEATURE_ESC_SENSOR)) {
 #endif
-            ADD_SENSOR(FSSP_DATAID_CURRENT);
+            ADD_SENSOR(FSSP_DATAID_CURRENT, 250, 3);
 #ifdef USE_ESC_SENSOR
         }
 #endif
-        ADD_SENSOR(FSSP_DATAID_FUEL);
+        ADD_SENSOR(FSSP_DATAID_FUEL, 1000, 1);
     }
 
     if (sensors(SENSOR_ACC)) {
-        ADD_SENSOR(FSSP_DATAID_HEADING);
-        ADD_SENSOR(FSSP_DATAID_ACCX);
-        ADD_SENSOR(FSSP_DATAID_ACCY);
-        ADD_SENSOR(FSSP_DATAID_ACCZ);
+        ADD_SENSOR(FSSP_DATAID_HEADING, 200, 2);
+        ADD_SENSOR(FSSP_DATAID_ACCX, 200, 1);
+        ADD_SENSOR(FSSP_DATAID_ACCY, 200, 1);
+        ADD_SENSOR(FSSP_DATAID_ACCZ, 200, 1);
     }
 
     if (sensors(SENSOR_BARO)) {
-        ADD_SENSOR(FSSP_DATAID_ALTITUDE);
-        ADD_SENSOR(FSSP_DATAID_VARIO);
+        ADD_SENSOR(FSSP_DATAID_ALTITUDE, 100, 3);
+        ADD_SENSOR(FSSP_DATAID_VARIO, 100, 3);
     }
 
 #ifdef USE_GPS
     if (feature(FEATURE_GPS)) {
-        ADD_SENSOR(FSSP_DATAID_SPEED);
-        ADD_SENSOR(FSSP_DATAID_LATLONG);
-        ADD_SENSOR(FSSP_DATAID_LATLONG); // twice (one for lat, one for long)
-        ADD_SENSOR(FSSP_DATAID_HOME_DIST);
-        ADD_SENSOR(FSSP_DATAID_GPS_ALT);
+        ADD_SENSOR(FSSP_DATAID_SPEED, 250, 2);
+        ADD_SENSOR(FSSP_DATAID_LATLONG, 250, 2);
+        ADD_SENSOR(FSSP_DATAID_LATLONG, 250, 2); // twice (one for lat, one for long)
+        ADD_SENSOR(FSSP_DATAID_HOME_DIST, 500, 1);
+        ADD_SENSOR(FSSP_DATAID_GPS_ALT, 500, 1);
     }
 #endif
 
-    frSkyDataIdTableInfo.size = frSkyDataIdTableInfo.index;
-    frSkyDataIdTableInfo.index = 0;
-
 #ifdef USE_ESC_SENSOR
+    frSkyEscDataIdStart = frSkyDataIdCount;
     if (feature(FEATURE_ESC_SENSOR)) {
-        frSkyEscDataIdTableInfo.size = ESC_DATAID_COUNT;
-    } else {
-        frSkyEscDataIdTableInfo.size = 0;
+        for (unsigned i = 0; i < ESC_DATAID_COUNT; i++) {
+            ADD_SENSOR(frSkyEscDataIdTable[i], 500, 2);
+            frSkyEscDataIdOffset[i] = 0;
+        }
     }
 #endif
+
+    telemetrySchedulerInit(&frSkyDataIdScheduler, frSkyDataIdSensors, frSkyDataIdSentAtMs, frSkyDataIdCount);
 }
 
 bool initSmartPortTelemetry(void)
@@ -434,6 +489,10 @@ static void configureSmartPortTelemetryPort(void)
 
 void checkSmartPortTelemetryState(void)
 {
+    if (telemetryState != TELEMETRY_STATE_UNINITIALIZED && smartPortSensorsAvailable() != frSkySensorsAvailable) {
+        initSmartPortSensors();
+    }
+
     if (telemetryState == TELEMETRY_STATE_INITIALIZED_SERIAL) {
         bool enableSerialTelemetry = telemetryDetermineEnabledState(smartPortPortSharing);
 
@@ -446,7 +505,9 @@ void checkSmartPortTelemetryState(void)
 }
 
 #if defined(USE_MSP_OVER_TELEMETRY)
-static void smartPortSendMspResponse(uint8_t *data) {
+static void smartPortSendMspResponse(uint8_t *data, uint8_t dataSize) {
+    UNUSED(dataSize);
+
     smartPortPayload_t payload;
     payload.frameId = FSSP_MSPS_FRAME;
     memcpy(&payload.valueId, data, SMARTPORT_MSP_PAYLOAD_SIZE);
@@ -457,12 +518,9 @@ static void smartPortSendMspResponse(uint8_t *data) {
 
 void processSmartPortTelemetry(smartPortPayload_t *payload, volatile bool *clearToSend, const uint32_t *requestTimeout)
 {
-    static uint8_t smartPortIdCycleCnt = 0;
     static uint8_t t1Cnt = 0;
     static uint8_t t2Cnt = 0;
-#ifdef USE_ESC_SENSOR
-    static uint8_t smartPortIdOffset = 0;
-#endif
+    static bool sendLongitude = false;
 
 #if defined(USE_MSP_OVER_TELEMETRY)
     if (payload && smartPortPayloadContainsMSP(payload)) {
@@ -496,40 +554,20 @@ void processSmartPortTelemetry(smartPortPayload_t *payload, volatile bool *clear
         }
 #endif
 
-        // we can send back any data we want, our tables keep track of the order and frequency of each data type we send
-        frSkyTableInfo_t * tableInfo = &frSkyDataIdTableInfo;
-
-#ifdef USE_ESC_SENSOR
-        if (smartPortIdCycleCnt >= ESC_SENSOR_PERIOD) {
-            // send ESC sensors
-            tableInfo = &frSkyEscDataIdTableInfo;
-            if (tableInfo->index == tableInfo->size) { // end of ESC table, return to other sensors
-                tableInfo->index = 0;
-                smartPortIdCycleCnt = 0;
-                smartPortIdOffset++;
-                if (smartPortIdOffset == getMotorCount() + 1) { // each motor and ESC_SENSOR_COMBINED
-                    smartPortIdOffset = 0;
-                }
-            }
-        }
-        if (smartPortIdCycleCnt < ESC_SENSOR_PERIOD) {
-            // send other sensors
-            tableInfo = &frSkyDataIdTableInfo;
-#endif
-            if (tableInfo->index == tableInfo->size) { // end of table reached, loop back
-                tableInfo->index = 0;
-            }
-#ifdef USE_ESC_SENSOR
+        // we can send back any data we want, the scheduler keeps track of the order and frequency of each data type we send
+        const int dataIdIndex = telemetrySchedulerNextSensor(&frSkyDataIdScheduler, millis());
+        if (dataIdIndex < 0) {
+            return;
         }
-#endif
-        uint16_t id = tableInfo->table[tableInfo->index];
+        uint16_t id = frSkyDataIdTable[dataIdIndex];
 #ifdef USE_ESC_SENSOR
-        if (smartPortIdCycleCnt >= ESC_SENSOR_PERIOD) {
-            id += smartPortIdOffset;
+        if (dataIdIndex >= frSkyEscDataIdStart) {
+            // each ESC data id goes through the combined value and then each motor
+            uint8_t *offset = &frSkyEscDataIdOffset[dataIdIndex - frSkyEscDataIdStart];
+            id += *offset;
+            *offset = (*offset + 1) % (getMotorCount() + 1);
         }
 #endif
-        smartPortIdCycleCnt++;
-        tableInfo->index++;
 
         int32_t tmpi;
         uint32_t tmp2 = 0;
@@ -641,7 +679,7 @@ void processSmartPortTelemetry(smartPortPayload_t *payload, volatile bool *clear
                 *clearToSend = false;
                 break;
             case FSSP_DATAID_HEADING    :
-                smartPortSendPackage(id, attitude.values.yaw * 10); // given in 10*deg, requested in 10000 = 100 deg
+                smartPortSendPackage(id, getAttitude()->values.yaw * 10); // given in 10*deg, requested in 10000 = 100 deg
                 *clearToSend = false;
                 break;
             case FSSP_DATAID_ACCX       :
@@ -760,8 +798,9 @@ void processSmartPortTelemetry(smartPortPayload_t *payload, volatile bool *clear
                     uint32_t tmpui = 0;
                     // the same ID is sent twice, one for longitude, one for latitude
                     // the MSB of the sent uint32_t helps FrSky keep track
-                    // the even/odd bit of our counter helps us keep track
-                    if (tableInfo->index & 1) {
+                    // and we take turns ourselves
+                    sendLongitude = !sendLongitude;
+                    if (sendLongitude) {
                         tmpui = abs(gpsSol.llh.lon);  // now we have unsigned value and one bit to spare
                         tmpui = (tmpui + tmpui / 2) / 25 | 0x80000000;  // 6/100 = 1.5/25, division by power of 2 is fast
                         if (gpsSol.llh.lon < 0) tmpui |= 0x40000000;
@@ -73,6 +73,7 @@ void processSmartPortTelemetry(smartPortPayload_t *payload, volatile bool *hasRe
 smartPortPayload_t *smartPortDataReceive(uint16_t c, bool *clearToSend, smartPortCheckQueueEmptyFn *checkQueueEmpty, bool withChecksum);
 
 struct serialPort_s;
-void smartPortWriteFrameSerial(const smartPortPayload_t *payload, struct serialPort_s *port, uint16_t checksum);
-void smartPortSendByte(uint8_t c, uint16_t *checksum, struct serialPort_s *port);
+#define SMARTPORT_FRAME_HEADER_MAX_LENGTH 2 // FPort length and type
+
+void smartPortWriteFrameSerial(const smartPortPayload_t *payload, struct serialPort_s *port, const uint8_t *header, uint8_t headerLength);
 bool smartPortPayloadContainsMSP(const smartPortPayload_t *payload);
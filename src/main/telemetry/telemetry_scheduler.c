@@ -0,0 +1,77 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#ifdef USE_TELEMETRY
+
+#include "common/maths.h"
+
+#include "telemetry/telemetry_scheduler.h"
+
+// elapsed time in 1/16 of the interval, capped so a starved sensor does not outweigh every priority
+#define TELEMETRY_SCHEDULER_OVERDUE_SHIFT   4
+#define TELEMETRY_SCHEDULER_OVERDUE_MAX     (8 << TELEMETRY_SCHEDULER_OVERDUE_SHIFT)
+#define TELEMETRY_SCHEDULER_DUE             (1 << TELEMETRY_SCHEDULER_OVERDUE_SHIFT)
+#define TELEMETRY_SCHEDULER_DUE_URGENCY     (1 << 16) // above any not yet due sensor, TELEMETRY_SCHEDULER_OVERDUE_MAX * UINT8_MAX fits below
+
+void telemetrySchedulerInit(telemetryScheduler_t *scheduler, const telemetrySensor_t *sensors, timeMs_t *sentAtMs, uint8_t sensorCount)
+{
+    scheduler->sensors = sensors;
+    scheduler->sentAtMs = sentAtMs;
+    scheduler->sensorCount = sensorCount;
+    for (int i = 0; i < sensorCount; i++) {
+        // everything is due at the start, in the order it was listed
+        sentAtMs[i] = 0;
+    }
+}
+
+/*
+ * Returns the sensor to send now and counts it as sent, -1 if there are no sensors.
+ * There always is a sensor to send so no slot is wasted, a sensor that is not due yet
+ * only gets sent when there is nothing better to send.
+ */
+int telemetrySchedulerNextSensor(telemetryScheduler_t *scheduler, timeMs_t currentTimeMs)
+{
+    int next = -1;
+    uint32_t nextUrgency = 0;
+
+    for (int i = 0; i < scheduler->sensorCount; i++) {
+        const telemetrySensor_t *sensor = &scheduler->sensors[i];
+        const uint32_t elapsedMs = MIN(currentTimeMs - scheduler->sentAtMs[i], (uint32_t)UINT16_MAX);
+        const uint32_t overdue = MIN((elapsedMs << TELEMETRY_SCHEDULER_OVERDUE_SHIFT) / MAX(sensor->intervalMs, 1),
+            (uint32_t)TELEMETRY_SCHEDULER_OVERDUE_MAX);
+        // sensors that are due come first, by priority, then the ones closest to being due
+        const uint32_t urgency = overdue >= TELEMETRY_SCHEDULER_DUE ? TELEMETRY_SCHEDULER_DUE_URGENCY + overdue * sensor->priority : overdue;
+        if (next < 0 || urgency > nextUrgency) {
+            next = i;
+            nextUrgency = urgency;
+        }
+    }
+
+    if (next >= 0) {
+        scheduler->sentAtMs[next] = currentTimeMs;
+    }
+    return next;
+}
+#endif
@@ -0,0 +1,49 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Shared sensor scheduling for the telemetry backends.
+ *
+ * Each backend lists the sensors it can send with the interval it would like
+ * to send them at and a priority. Whenever the link has room for a value the
+ * backend asks for the next sensor, which is the one most overdue relative to
+ * its interval, weighted by its priority. Slowly changing values get a long
+ * interval and leave the airtime to the fast ones.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "common/time.h"
+
+typedef struct telemetrySensor_s {
+    uint16_t intervalMs;        // wanted time between two sends of the value
+    uint8_t priority;           // weight of the value once it is due, 1 and up
+} telemetrySensor_t;
+
+typedef struct telemetryScheduler_s {
+    const telemetrySensor_t *sensors;
+    timeMs_t *sentAtMs;         // one per sensor, provided by the backend
+    uint8_t sensorCount;
+} telemetryScheduler_t;
+
+void telemetrySchedulerInit(telemetryScheduler_t *scheduler, const telemetrySensor_t *sensors, timeMs_t *sentAtMs, uint8_t sensorCount);
+int telemetrySchedulerNextSensor(telemetryScheduler_t *scheduler, timeMs_t currentTimeMs);
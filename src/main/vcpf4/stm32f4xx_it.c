@@ -18,6 +18,8 @@
  * If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "platform.h"
+
 #include "stm32f4xx_it.h"
 #include "stm32f4xx_conf.h"
 
@@ -65,9 +67,11 @@ void DebugMon_Handler(void)
   * @param  None
   * @retval None
   */
+#ifndef USE_PREEMPTIVE_PID_LOOP
 void PendSV_Handler(void)
 {
 }
+#endif
 
 /******************************************************************************/
 /*                 STM32F4xx Peripherals Interrupt Handlers                   */
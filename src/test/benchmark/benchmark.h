@@ -0,0 +1,74 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "gtest/gtest.h"
+
+// Each measurement is the best of BENCHMARK_RUNS runs, so a run interrupted by the host does not count
+#define BENCHMARK_RUNS 7
+
+// stops the compiler from optimising away a result that is not used otherwise
+template <typename T>
+static inline void benchmarkKeep(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// nanoseconds per call of fn(i) for i in [0, iterations)
+template <typename F>
+static double benchmarkNsPerCall(int iterations, F fn)
+{
+    double best = 1e30;
+    for (int run = 0; run < BENCHMARK_RUNS; run++) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            fn(i);
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / iterations);
+    }
+    return best;
+}
+
+// A dependent chain of float multiply-adds. The budgets are given in multiples of its cost,
+// so they hold on hosts of different speed.
+static double benchmarkReferenceNs(void)
+{
+    static double referenceNs;
+    if (referenceNs == 0) {
+        float x = 1.0f;
+        referenceNs = benchmarkNsPerCall(1000000, [&](int) {
+            x = x * 0.999f + 0.001f;
+            benchmarkKeep(x);
+        });
+    }
+    return referenceNs;
+}
+
+// Fails when a call costs more than budget reference operations. The budgets are about twice
+// the cost measured when they were set, a regression has to be well beyond the noise to fail.
+#define EXPECT_BENCHMARK(name, ns, budget) \
+    do { \
+        const double cost = (ns) / benchmarkReferenceNs(); \
+        printf("%-32s %10.1f ns %8.1f ref (budget %.0f)\n", name, (ns), cost, (double)(budget)); \
+        EXPECT_LE(cost, (budget)) << name << " is slower than its budget"; \
+    } while (0)
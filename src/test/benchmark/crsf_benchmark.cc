@@ -0,0 +1,115 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+
+    #include "common/crc.h"
+
+    #include "drivers/serial.h"
+    #include "io/serial.h"
+
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+    #include "pg/rx.h"
+
+    #include "rx/rx.h"
+    #include "rx/crsf.h"
+
+    void crsfDataReceive(uint16_t c, void *data);
+    uint8_t crsfFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig);
+
+    extern uint32_t crsfChannelData[CRSF_MAX_CHANNEL];
+
+    PG_REGISTER(rxConfig_t, rxConfig, PG_RX_CONFIG, 0);
+}
+
+#include "benchmark.h"
+
+#define FRAME_COUNT             64
+#define RC_FRAME_LENGTH         (CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE + 4)
+#define RC_FRAME_INTERVAL_US    4000
+
+static uint8_t rcFrames[FRAME_COUNT][RC_FRAME_LENGTH];
+static uint32_t currentTimeUs;
+
+// packed RC channel frames as a 250Hz link sends them, the sticks move a little from frame to frame
+static void initRcFrames(void)
+{
+    uint32_t seed = 1;
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        uint8_t *bytes = rcFrames[frame];
+        bytes[0] = CRSF_ADDRESS_FLIGHT_CONTROLLER;
+        bytes[1] = CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC;
+        bytes[2] = CRSF_FRAMETYPE_RC_CHANNELS_PACKED;
+        for (int i = 0; i < CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE; i++) {
+            seed = seed * 1103515245 + 12345;
+            bytes[3 + i] = seed >> 24;
+        }
+        bytes[RC_FRAME_LENGTH - 1] = crc8_dvb_s2_update(0, &bytes[2], CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE + 1);
+    }
+}
+
+TEST(CrsfBenchmark, RcFrameReceive)
+{
+    initRcFrames();
+    rxRuntimeConfig_t rxRuntimeConfig;
+    memset(&rxRuntimeConfig, 0, sizeof(rxRuntimeConfig));
+    int framesComplete = 0;
+    const double ns = benchmarkNsPerCall(20000, [&](int i) {
+        currentTimeUs += RC_FRAME_INTERVAL_US;
+        const uint8_t *bytes = rcFrames[i % FRAME_COUNT];
+        for (int j = 0; j < RC_FRAME_LENGTH; j++) {
+            crsfDataReceive(bytes[j], NULL);
+        }
+        framesComplete += crsfFrameStatus(&rxRuntimeConfig) == RX_FRAME_COMPLETE;
+    });
+    benchmarkKeep(crsfChannelData);
+    EXPECT_EQ(20000 * BENCHMARK_RUNS, framesComplete);
+    EXPECT_BENCHMARK("crsf RC frame receive", ns, 60);
+}
+
+// STUBS
+
+extern "C" {
+
+int16_t debug[DEBUG16_VALUE_COUNT];
+uint8_t debugMode;
+
+uint32_t micros(void) { return currentTimeUs; }
+uint32_t millis(void) { return currentTimeUs / 1000; }
+
+rssiSource_e rssiSource;
+void setRssi(uint16_t, rssiSource_e) {}
+serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, void *, uint32_t, portMode_e, portOptions_e) { return NULL; }
+serialPortConfig_t *findSerialPortConfig(serialPortFunction_e) { return NULL; }
+bool telemetryCheckRxPortShared(const serialPortConfig_t *) { return false; }
+serialPort_t *telemetrySharedPort = NULL;
+void crsfScheduleDeviceInfoResponse(void) {}
+void crsfScheduleMspResponse(void) {}
+bool bufferMspFrame(uint8_t *, int) { return true; }
+bool isBatteryVoltageAvailable(void) { return true; }
+bool isAmperageAvailable(void) { return true; }
+void rxSignalFrameComplete(void) {}
+
+}
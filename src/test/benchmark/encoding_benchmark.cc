@@ -0,0 +1,148 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "blackbox/blackbox_encoding.h"
+    #include "blackbox/blackbox_io.h"
+    #include "common/huffman.h"
+    #include "common/printf.h"
+    #include "common/typeconversion.h"
+    #include "drivers/serial.h"
+}
+
+#include "benchmark.h"
+
+#define FRAME_COUNT 256
+
+static uint8_t blackboxBuffer[256];
+static uint8_t blackboxBufferIndex;
+
+TEST(EncodingBenchmark, BlackboxWriteTag8_8SVB)
+{
+    // P frame deltas of the eight motor and gyro fields, mostly small with some unchanged
+    static int32_t deltas[FRAME_COUNT][8];
+    uint32_t seed = 1;
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        for (int field = 0; field < 8; field++) {
+            seed = seed * 1103515245 + 12345;
+            const int32_t delta = (int32_t)((seed >> 16) % 401) - 200;
+            deltas[frame][field] = (seed >> 28) < 3 ? 0 : delta;
+        }
+    }
+    const double ns = benchmarkNsPerCall(100000, [&](int i) {
+        blackboxWriteTag8_8SVB(deltas[i % FRAME_COUNT], 8);
+    });
+    benchmarkKeep(blackboxBuffer);
+    EXPECT_BENCHMARK("blackboxWriteTag8_8SVB", ns, 16);
+}
+
+TEST(EncodingBenchmark, HuffmanEncodeBuf)
+{
+    // the response to an MSP request, text and small numbers
+    static uint8_t inBuf[256];
+    static const char text[] = "H Field I name:loopIteration,time,axisP[0],axisP[1],axisP[2],gyroADC[0],gyroADC[1]";
+    for (unsigned i = 0; i < sizeof(inBuf); i++) {
+        inBuf[i] = (i % 64) < 48 ? text[i % (sizeof(text) - 1)] : i % 7;
+    }
+    static uint8_t outBuf[512];
+    const double ns = benchmarkNsPerCall(2000, [&](int) {
+        benchmarkKeep(huffmanEncodeBuf(outBuf, sizeof(outBuf), inBuf, sizeof(inBuf), huffmanTable));
+    });
+    EXPECT_BENCHMARK("huffmanEncodeBuf 256 bytes", ns, 300);
+}
+
+TEST(EncodingBenchmark, HuffmanEncodeBufStreaming)
+{
+    // a compressed dataflash read, blackbox frames in the 256 byte chunks msp.c uses
+    static uint8_t inBuf[4096];
+    uint32_t seed = 1;
+    for (unsigned i = 0; i < sizeof(inBuf); i++) {
+        seed = seed * 1103515245 + 12345;
+        inBuf[i] = (i % 32) == 0 ? 'P' : (seed >> 28) < 12 ? (seed >> 16) % 8 : seed >> 24;
+    }
+    static uint8_t outBuf[sizeof(inBuf) * 2];
+    const double ns = benchmarkNsPerCall(200, [&](int) {
+        huffmanState_t state = {
+            .bytesWritten = 0,
+            .outByte = outBuf,
+            .outBufLen = sizeof(outBuf),
+            .outBit = 0x80,
+        };
+        *state.outByte = 0;
+        for (unsigned pos = 0; pos < sizeof(inBuf); pos += 256) {
+            huffmanEncodeBufStreaming(&state, inBuf + pos, 256, huffmanTable);
+        }
+        benchmarkKeep(state);
+    });
+    EXPECT_BENCHMARK("huffmanEncodeBufStreaming 4096 bytes", ns, 4500);
+}
+
+TEST(EncodingBenchmark, TfpSprintfIntegers)
+{
+    // a line of the CLI dump
+    static char buf[64];
+    const double ns = benchmarkNsPerCall(20000, [&](int i) {
+        benchmarkKeep(tfp_sprintf(buf, "set %s = %d", "gyro_lowpass_hz", i * 37 - 10000));
+    });
+    EXPECT_BENCHMARK("tfp_sprintf set line", ns, 35);
+}
+
+TEST(EncodingBenchmark, I2aPadded)
+{
+    // an OSD element, the voltage as "%2d.%1d"
+    static char buf[16];
+    const double ns = benchmarkNsPerCall(100000, [&](int i) {
+        const int voltage = 100 + i % 150;
+        char *p = i2aPadded(voltage / 10, 2, ' ', buf);
+        *p++ = '.';
+        *p++ = '0' + voltage % 10;
+        *p = 0;
+        benchmarkKeep(buf);
+    });
+    EXPECT_BENCHMARK("i2aPadded OSD voltage", ns, 6);
+}
+
+// STUBS
+
+extern "C" {
+
+int32_t blackboxHeaderBudget;
+
+void blackboxWrite(uint8_t value)
+{
+    blackboxBuffer[blackboxBufferIndex++] = value;
+}
+
+int blackboxWriteString(const char *s)
+{
+    const char *pos = s;
+    while (*pos) {
+        blackboxWrite(*pos++);
+    }
+    return pos - s;
+}
+
+void serialWrite(serialPort_t *, uint8_t) {}
+bool isSerialTransmitBufferEmpty(const serialPort_t *) {return true;}
+
+}
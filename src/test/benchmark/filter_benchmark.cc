@@ -0,0 +1,66 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/filter.h"
+    #include "common/maths.h"
+}
+
+#include "benchmark.h"
+
+#define GYRO_LOOPTIME_US    125
+#define SAMPLE_COUNT        1024
+
+// 8kHz gyro signal, a 20Hz stick movement with 250Hz motor noise on top
+static float gyroSignal[SAMPLE_COUNT];
+
+static void initGyroSignal(void)
+{
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        const float t = i * GYRO_LOOPTIME_US * 1e-6f;
+        gyroSignal[i] = 300.0f * sinf(2 * M_PIf * 20 * t) + 40.0f * sinf(2 * M_PIf * 250 * t);
+    }
+}
+
+TEST(FilterBenchmark, BiquadFilterApply)
+{
+    initGyroSignal();
+    biquadFilter_t filter;
+    biquadFilterInitLPF(&filter, 100, GYRO_LOOPTIME_US);
+    const double ns = benchmarkNsPerCall(100000, [&](int i) {
+        benchmarkKeep(biquadFilterApply(&filter, gyroSignal[i % SAMPLE_COUNT]));
+    });
+    EXPECT_BENCHMARK("biquadFilterApply", ns, 3);
+}
+
+TEST(FilterBenchmark, Pt1FilterApply)
+{
+    initGyroSignal();
+    pt1Filter_t filter;
+    pt1FilterInit(&filter, pt1FilterGain(100, GYRO_LOOPTIME_US * 1e-6f));
+    const double ns = benchmarkNsPerCall(100000, [&](int i) {
+        benchmarkKeep(pt1FilterApply(&filter, gyroSignal[i % SAMPLE_COUNT]));
+    });
+    EXPECT_BENCHMARK("pt1FilterApply", ns, 3);
+}
@@ -0,0 +1,128 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+    #include "common/axis.h"
+    #include "common/filter.h"
+    #include "common/maths.h"
+    #include "common/utils.h"
+    #include "drivers/accgyro/accgyro.h"
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+    #include "sensors/gyro.h"
+    #include "sensors/gyroanalyse.h"
+
+    uint8_t debugMode;
+    int16_t debug[DEBUG16_VALUE_COUNT];
+
+    PG_REGISTER(gyroConfig_t, gyroConfig, PG_GYRO_CONFIG, 0);
+}
+
+#include "benchmark.h"
+
+#define GYRO_LOOPTIME_US    125
+#define UPDATE_CYCLES       200
+
+static uint32_t sampleIndex;
+static unsigned pendingSamples;
+
+// 8kHz gyro signal with motor noise at 180Hz, 230Hz and 260Hz on the three axes
+static void gyroSignal(float *raw)
+{
+    const float t = sampleIndex * GYRO_LOOPTIME_US * 1e-6f;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        raw[axis] = 200.0f * sinf(2 * M_PIf * 15 * t) + 30.0f * sinf(2 * M_PIf * (180 + 40 * axis) * t);
+    }
+    sampleIndex++;
+}
+
+TEST(GyroAnalyseBenchmark, UpdateSteps)
+{
+    gyroConfigMutable()->dyn_notch_count = 1;
+    gyroConfigMutable()->dyn_notch_estimator = DYN_NOTCH_ESTIMATOR_FFT;
+    gyroDataAnalyseInit(GYRO_LOOPTIME_US);
+    static biquadFilter_t notchFilterDyn[DYN_NOTCH_COUNT_MAX][XYZ_AXIS_COUNT];
+    for (int notch = 0; notch < DYN_NOTCH_COUNT_MAX; notch++) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            biquadFilterInit(&notchFilterDyn[notch][axis], 400, GYRO_LOOPTIME_US, filterGetNotchQ(400, 300), FILTER_NOTCH);
+        }
+    }
+    gyroDev_t gyroDev;
+    memset(&gyroDev, 0, sizeof(gyroDev));
+    gyroDev.scale = 1.0f;
+    gyroSampleReader_t reader;
+    memset(&reader, 0, sizeof(reader));
+
+    // fill the FFT window with one sample per gyro loop
+    for (int i = 0; i < 1000; i++) {
+        pendingSamples = 1;
+        gyroDataAnalyse(&gyroDev, &reader, notchFilterDyn);
+    }
+
+    // one update cycle covers all steps of the three axes, each call is one step
+    static const int stepsPerCycle = XYZ_AXIS_COUNT * 4;
+    double stepNs[stepsPerCycle];
+    for (int step = 0; step < stepsPerCycle; step++) {
+        stepNs[step] = 1e30;
+    }
+    for (int cycle = 0; cycle < UPDATE_CYCLES; cycle++) {
+        for (int step = 0; step < stepsPerCycle; step++) {
+            const auto start = std::chrono::steady_clock::now();
+            gyroDataAnalyseUpdate(notchFilterDyn);
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            stepNs[step] = std::min(stepNs[step], elapsed.count());
+        }
+    }
+    double worstNs = 0;
+    double totalNs = 0;
+    for (int step = 0; step < stepsPerCycle; step++) {
+        worstNs = std::max(worstNs, stepNs[step]);
+        totalNs += stepNs[step];
+    }
+    // the worst step bounds the time added to a gyro loop, the total is the cost per 1kHz sample
+    EXPECT_BENCHMARK("gyroDataAnalyseUpdate worst step", worstNs, 45);
+    EXPECT_BENCHMARK("gyroDataAnalyseUpdate cycle", totalNs, 480);
+}
+
+// STUBS
+
+extern "C" {
+
+uint32_t micros(void) {return 0;}
+
+unsigned gyroSampleRead(gyroSampleReader_t *reader, gyroSample_t *samples, unsigned maxCount)
+{
+    UNUSED(reader);
+    unsigned count = 0;
+    while (pendingSamples > 0 && count < maxCount) {
+        gyroSignal(samples[count].raw);
+        pendingSamples--;
+        count++;
+    }
+    return count;
+}
+
+}
@@ -0,0 +1,70 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <math.h>
+
+extern "C" {
+    #include "common/maths.h"
+}
+
+#include "benchmark.h"
+
+#define INPUT_COUNT 1024
+
+TEST(MathsBenchmark, SinApprox)
+{
+    // attitude angles over the full circle
+    static float angle[INPUT_COUNT];
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        angle[i] = -M_PIf + 2 * M_PIf * i / INPUT_COUNT;
+    }
+    const double ns = benchmarkNsPerCall(100000, [&](int i) {
+        benchmarkKeep(sin_approx(angle[i % INPUT_COUNT]));
+    });
+    EXPECT_BENCHMARK("sin_approx", ns, 2);
+}
+
+TEST(MathsBenchmark, SinTable)
+{
+    trigTableInit();
+    static float angle[INPUT_COUNT];
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        angle[i] = -M_PIf + 2 * M_PIf * i / INPUT_COUNT;
+    }
+    const double ns = benchmarkNsPerCall(100000, [&](int i) {
+        benchmarkKeep(sin_table(angle[i % INPUT_COUNT]));
+    });
+    EXPECT_BENCHMARK("sin_table", ns, 2);
+}
+
+TEST(MathsBenchmark, Atan2Approx)
+{
+    // points on a circle, as the accelerometer vector while the model rolls
+    static float y[INPUT_COUNT];
+    static float x[INPUT_COUNT];
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        y[i] = 512 * sinf(2 * M_PIf * i / INPUT_COUNT);
+        x[i] = 512 * cosf(2 * M_PIf * i / INPUT_COUNT);
+    }
+    const double ns = benchmarkNsPerCall(100000, [&](int i) {
+        benchmarkKeep(atan2_approx(y[i % INPUT_COUNT], x[i % INPUT_COUNT]));
+    });
+    EXPECT_BENCHMARK("atan2_approx", ns, 2);
+}
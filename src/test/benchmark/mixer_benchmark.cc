@@ -0,0 +1,125 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+
+    #include "fc/config.h"
+    #include "fc/controlrate_profile.h"
+    #include "fc/rc_controls.h"
+    #include "fc/runtime_config.h"
+
+    #include "flight/mixer.h"
+    #include "flight/pid.h"
+
+    #include "drivers/timer.h"
+
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+    #include "pg/rx.h"
+
+    #include "rx/rx.h"
+
+    PG_REGISTER(flight3DConfig_t, flight3DConfig, PG_MOTOR_3D_CONFIG, 0);
+    PG_REGISTER(rxConfig_t, rxConfig, PG_RX_CONFIG, 0);
+}
+
+#include "benchmark.h"
+
+#define PID_LOOPTIME_US     125
+#define SAMPLE_COUNT        1024
+
+static float pidSumSignal[SAMPLE_COUNT];
+
+TEST(MixerBenchmark, MixTable)
+{
+    pgResetAll();
+    static controlRateConfig_t controlRateConfig;
+    currentControlRateProfile = &controlRateConfig;
+    currentControlRateProfile->throttle_limit_percent = 100;
+    static pidProfile_t pidProfile;
+    currentPidProfile = &pidProfile;
+    currentPidProfile->pidSumLimit = PIDSUM_LIMIT;
+    currentPidProfile->pidSumLimitYaw = PIDSUM_LIMIT_YAW;
+    mixerInit(MIXER_QUADX);
+    mixerConfigureOutput();
+    ENABLE_ARMING_FLAG(ARMED);
+
+    // the PID sums of a 20Hz stick movement with 250Hz motor noise on top, at half throttle
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        const float t = i * PID_LOOPTIME_US * 1e-6f;
+        pidSumSignal[i] = 200.0f * sinf(2 * M_PIf * 20 * t) + 50.0f * sinf(2 * M_PIf * 250 * t);
+    }
+    rcCommand[THROTTLE] = 1500;
+
+    const double ns = benchmarkNsPerCall(20000, [&](int i) {
+        for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+            pidData[axis].Sum = pidSumSignal[(i + axis * 100) % SAMPLE_COUNT];
+        }
+        mixTable(i * PID_LOOPTIME_US, 0);
+    });
+    EXPECT_EQ(4, getMotorCount());
+    EXPECT_NE(motor[0], motor[1]);
+    EXPECT_BENCHMARK("mixTable", ns, 17);
+}
+
+// STUBS
+
+extern "C" {
+
+int16_t debug[DEBUG16_VALUE_COUNT];
+uint8_t debugMode;
+
+pidProfile_t *currentPidProfile;
+controlRateConfig_t *currentControlRateProfile;
+pidAxisData_t pidData[XYZ_AXIS_COUNT];
+float rcCommand[4];
+int16_t rcData[MAX_SUPPORTED_RC_CHANNEL_COUNT];
+
+bool feature(uint32_t) { return false; }
+void delay(uint32_t) {}
+void delayMicroseconds(uint32_t) {}
+void beeperConfirmationBeeps(uint8_t) {}
+float calculateVbatPidCompensation(void) { return 1.0f; }
+bool failsafeIsActive(void) { return false; }
+float getRcDeflection(int) { return 0.0f; }
+float getRcDeflectionAbs(int) { return 0.0f; }
+bool isAirmodeActive(void) { return true; }
+bool isFlipOverAfterCrashMode(void) { return false; }
+bool isMotorProtocolDshot(void) { return false; }
+bool isMotorsReversed(void) { return false; }
+void mixerTricopterInit(void) {}
+bool mixerTricopterIsServoSaturated(float) { return false; }
+float mixerTricopterMotorCorrection(int) { return 0.0f; }
+void pidResetITerm(void) {}
+bool pwmAreMotorsEnabled(void) { return true; }
+void pwmCompleteMotorUpdate(uint8_t) {}
+void pwmShutdownPulsesForAllMotors(uint8_t) {}
+void pwmWriteMotor(uint8_t, float) {}
+ioTag_t timerioTagGetByUsage(timerUsageFlag_e, uint8_t) { return IO_TAG_NONE; }
+
+}
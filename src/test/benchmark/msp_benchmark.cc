@@ -0,0 +1,123 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+
+    #include "common/crc.h"
+    #include "common/streambuf.h"
+
+    #include "drivers/serial.h"
+    #include "io/serial.h"
+
+    #include "interface/msp.h"
+    #include "interface/msp_protocol.h"
+    #include "msp/msp_serial.h"
+
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+
+    PG_REGISTER(serialConfig_t, serialConfig, PG_SERIAL_CONFIG, 0);
+}
+
+#include "benchmark.h"
+
+// a configurator polling the IMU, the request comes in as MSP v1 and v2 in turn
+static const uint8_t requestV1[] = { '$', 'M', '<', 0, MSP_RAW_IMU, MSP_RAW_IMU };
+static uint8_t requestV2[9];
+
+static serialPort_t serialPort;
+static serialPortConfig_t serialPortConfig;
+static const uint8_t *rxData;
+static int rxLength;
+static int rxIndex;
+static int txLength;
+
+static void initRequestV2(void)
+{
+    const uint8_t v2[] = { '$', 'X', '<', 0, MSP_RAW_IMU, 0, 0, 0 };
+    memcpy(requestV2, v2, sizeof(v2));
+    requestV2[8] = crc8_dvb_s2_update(0, &requestV2[3], 5);
+}
+
+static mspResult_e processCommand(mspPacket_t *cmd, mspPacket_t *reply, mspPostProcessFnPtr *)
+{
+    if (cmd->cmd != MSP_RAW_IMU) {
+        return MSP_RESULT_ERROR;
+    }
+    // acc, gyro and mag, as MSP_RAW_IMU sends them
+    for (int i = 0; i < 9; i++) {
+        sbufWriteU16(&reply->buf, i * 100 - 400);
+    }
+    return MSP_RESULT_ACK;
+}
+
+static void processReply(mspPacket_t *) {}
+
+TEST(MspBenchmark, RequestReply)
+{
+    initRequestV2();
+    mspSerialInit();
+    const double ns = benchmarkNsPerCall(20000, [&](int i) {
+        rxData = i & 1 ? requestV2 : requestV1;
+        rxLength = i & 1 ? sizeof(requestV2) : sizeof(requestV1);
+        rxIndex = 0;
+        mspSerialProcess(MSP_SKIP_NON_MSP_DATA, processCommand, processReply);
+    });
+    // header, 18 bytes of data and the checksum, the v2 frame has three more header bytes
+    EXPECT_EQ(BENCHMARK_RUNS * 20000 / 2 * (24 + 27), txLength);
+    EXPECT_BENCHMARK("msp request and reply", ns, 45);
+}
+
+// STUBS
+
+extern "C" {
+
+int16_t debug[DEBUG16_VALUE_COUNT];
+uint8_t debugMode;
+
+const uint32_t baudRates[] = { 0, 9600, 19200, 38400, 57600, 115200, 230400, 250000, 400000, 460800, 500000, 921600, 1000000, 1500000, 2000000, 2470000 };
+
+uint32_t micros(void) { return 0; }
+uint32_t millis(void) { return 0; }
+
+serialPortConfig_t *findSerialPortConfig(serialPortFunction_e) { return &serialPortConfig; }
+serialPortConfig_t *findNextSerialPortConfig(serialPortFunction_e) { return NULL; }
+serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, void *, uint32_t, portMode_e, portOptions_e) { return &serialPort; }
+void closeSerialPort(serialPort_t *) {}
+bool isSerialPortShared(const serialPortConfig_t *, uint16_t, serialPortFunction_e) { return false; }
+
+uint32_t serialRxBytesWaiting(const serialPort_t *) { return rxLength - rxIndex; }
+uint8_t serialRead(serialPort_t *) { return rxData[rxIndex++]; }
+bool isSerialTransmitBufferEmpty(const serialPort_t *) { return true; }
+uint32_t serialTxBytesFree(const serialPort_t *) { return 256; }
+void serialBeginWrite(serialPort_t *) {}
+void serialEndWrite(serialPort_t *) {}
+void serialWriteBuf(serialPort_t *, const uint8_t *data, int count) { benchmarkKeep(data); txLength += count; }
+void serialWrite(serialPort_t *, uint8_t) { txLength++; }
+void waitForSerialPortToFinishTransmitting(serialPort_t *) {}
+
+void cliEnter(serialPort_t *) {}
+void systemResetToBootloader(void) {}
+
+}
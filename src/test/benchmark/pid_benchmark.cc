@@ -0,0 +1,113 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+
+    #include "fc/rc_controls.h"
+    #include "fc/runtime_config.h"
+
+    #include "flight/imu.h"
+    #include "flight/pid.h"
+
+    #include "pg/pg.h"
+
+    #include "sensors/acceleration.h"
+    #include "sensors/gyro.h"
+}
+
+#include "benchmark.h"
+
+#define PID_LOOPTIME_US     125
+#define SAMPLE_COUNT        1024
+
+static float gyroSignal[SAMPLE_COUNT];
+static float stickSignal[SAMPLE_COUNT];
+static float simulatedSetpointRate[XYZ_AXIS_COUNT];
+static int loopIteration;
+
+static timeUs_t currentTimeUs(void)
+{
+    return PID_LOOPTIME_US * loopIteration++;
+}
+
+// armed in rate mode with the default profile, the craft follows a 20Hz stick movement with 250Hz motor noise on top
+static pidProfile_t *initPidController(void)
+{
+    pgResetAll();
+    gyro.targetLooptime = PID_LOOPTIME_US;
+    pidProfile_t *pidProfile = pidProfilesMutable(0);
+    pidInit(pidProfile);
+    ENABLE_ARMING_FLAG(ARMED);
+    pidStabilisationState(PID_STABILISATION_ON);
+
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        const float t = i * PID_LOOPTIME_US * 1e-6f;
+        stickSignal[i] = 300.0f * sinf(2 * M_PIf * 20 * (t + 0.0005f));
+        gyroSignal[i] = 300.0f * sinf(2 * M_PIf * 20 * t) + 40.0f * sinf(2 * M_PIf * 250 * t);
+    }
+    return pidProfile;
+}
+
+TEST(PidBenchmark, PidController)
+{
+    pidProfile_t *pidProfile = initPidController();
+    static rollAndPitchTrims_t trims;
+    const double ns = benchmarkNsPerCall(20000, [&](int i) {
+        for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+            simulatedSetpointRate[axis] = stickSignal[(i + axis * 100) % SAMPLE_COUNT];
+            gyro.gyroADCf[axis] = gyroSignal[(i + axis * 100) % SAMPLE_COUNT];
+        }
+        pidController(pidProfile, &trims, currentTimeUs());
+    });
+    EXPECT_NE(0, pidData[FD_ROLL].Sum);
+    EXPECT_BENCHMARK("pidController", ns, 20);
+}
+
+// STUBS
+
+extern "C" {
+
+int16_t debug[DEBUG16_VALUE_COUNT];
+uint8_t debugMode;
+
+gyro_t gyro;
+attitudeEulerAngles_t attitude;
+
+const attitudeEulerAngles_t *getAttitude(void) { return &attitude; }
+float getThrottlePIDAttenuation(void) { return 1.0f; }
+float getMotorMixRange(void) { return 0.5f; }
+float getSetpointRate(int axis) { return simulatedSetpointRate[axis]; }
+bool mixerIsOutputSaturated(int, float) { return false; }
+void mixerInitProfile(const pidProfile_t *) {}
+float getRcDeflection(int axis) { return simulatedSetpointRate[axis] / 1000.0f; }
+float getRcDeflectionAbs(int axis) { return fabsf(simulatedSetpointRate[axis] / 1000.0f); }
+void systemBeep(bool) {}
+bool gyroOverflowDetected(void) { return false; }
+void beeperConfirmationBeeps(uint8_t) {}
+
+}
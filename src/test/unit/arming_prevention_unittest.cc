@@ -58,12 +58,14 @@ extern "C" {
     float rcCommand[4];
     int16_t rcData[MAX_SUPPORTED_RC_CHANNEL_COUNT];
     uint16_t averageSystemLoadPercent = 0;
+    uint16_t averageIdlePercent = 0;
     uint8_t cliMode = 0;
     uint8_t debugMode = 0;
     int16_t debug[DEBUG16_VALUE_COUNT];
     pidProfile_t *currentPidProfile;
     controlRateConfig_t *currentControlRateProfile;
     attitudeEulerAngles_t attitude;
+    const attitudeEulerAngles_t *getAttitude(void) { return &attitude; }
     gpsSolutionData_t gpsSol;
     uint32_t targetPidLooptime;
     bool cmsInMenu = false;
@@ -89,6 +91,7 @@ TEST(ArmingPreventionTest, CalibrationPowerOnGraceAngleThrottleArmSwitch)
     modeActivationConditionsMutable(0)->modeId = BOXARM;
     modeActivationConditionsMutable(0)->range.startStep = CHANNEL_VALUE_TO_STEP(1750);
     modeActivationConditionsMutable(0)->range.endStep = CHANNEL_VALUE_TO_STEP(CHANNEL_RANGE_MAX);
+    analyzeModeActivationConditions();
     useRcControlsConfig(NULL);
 
     // and
@@ -179,6 +182,7 @@ TEST(ArmingPreventionTest, ArmingGuardRadioLeftOnAndArmed)
     modeActivationConditionsMutable(0)->modeId = BOXARM;
     modeActivationConditionsMutable(0)->range.startStep = CHANNEL_VALUE_TO_STEP(1750);
     modeActivationConditionsMutable(0)->range.endStep = CHANNEL_VALUE_TO_STEP(CHANNEL_RANGE_MAX);
+    analyzeModeActivationConditions();
     useRcControlsConfig(NULL);
 
     // and
@@ -257,6 +261,7 @@ TEST(ArmingPreventionTest, Prearm)
     modeActivationConditionsMutable(1)->modeId = BOXPREARM;
     modeActivationConditionsMutable(1)->range.startStep = CHANNEL_VALUE_TO_STEP(1750);
     modeActivationConditionsMutable(1)->range.endStep = CHANNEL_VALUE_TO_STEP(CHANNEL_RANGE_MAX);
+    analyzeModeActivationConditions();
     useRcControlsConfig(NULL);
 
     // and
@@ -300,6 +305,7 @@ TEST(ArmingPreventionTest, RadioTurnedOnAtAnyTimeArmed)
     modeActivationConditionsMutable(0)->modeId = BOXARM;
     modeActivationConditionsMutable(0)->range.startStep = CHANNEL_VALUE_TO_STEP(1750);
     modeActivationConditionsMutable(0)->range.endStep = CHANNEL_VALUE_TO_STEP(CHANNEL_RANGE_MAX);
+    analyzeModeActivationConditions();
     useRcControlsConfig(NULL);
 
     // and
@@ -366,6 +372,7 @@ TEST(ArmingPreventionTest, In3DModeAllowArmingWhenEnteringThrottleDeadband)
     modeActivationConditionsMutable(0)->modeId = BOXARM;
     modeActivationConditionsMutable(0)->range.startStep = CHANNEL_VALUE_TO_STEP(1750);
     modeActivationConditionsMutable(0)->range.endStep = CHANNEL_VALUE_TO_STEP(CHANNEL_RANGE_MAX);
+    analyzeModeActivationConditions();
     useRcControlsConfig(NULL);
 
     // and
@@ -433,6 +440,7 @@ TEST(ArmingPreventionTest, When3DModeDisabledThenNormalThrottleArmingConditionAp
     modeActivationConditionsMutable(1)->modeId = BOX3D;
     modeActivationConditionsMutable(1)->range.startStep = CHANNEL_VALUE_TO_STEP(1750);
     modeActivationConditionsMutable(1)->range.endStep = CHANNEL_VALUE_TO_STEP(CHANNEL_RANGE_MAX);
+    analyzeModeActivationConditions();
     useRcControlsConfig(NULL);
 
     // and
@@ -534,6 +542,7 @@ TEST(ArmingPreventionTest, WhenUsingSwitched3DModeThenNormalThrottleArmingCondit
     modeActivationConditionsMutable(1)->modeId = BOX3D;
     modeActivationConditionsMutable(1)->range.startStep = CHANNEL_VALUE_TO_STEP(1750);
     modeActivationConditionsMutable(1)->range.endStep = CHANNEL_VALUE_TO_STEP(CHANNEL_RANGE_MAX);
+    analyzeModeActivationConditions();
     useRcControlsConfig(NULL);
 
     // and
@@ -636,6 +645,7 @@ TEST(ArmingPreventionTest, Paralyze)
     modeActivationConditionsMutable(3)->modeId = BOXVTXPITMODE;
     modeActivationConditionsMutable(3)->range.startStep = CHANNEL_VALUE_TO_STEP(1750);
     modeActivationConditionsMutable(3)->range.endStep = CHANNEL_VALUE_TO_STEP(CHANNEL_RANGE_MAX);
+    analyzeModeActivationConditions();
     useRcControlsConfig(NULL);
 
     // and
@@ -753,6 +763,7 @@ extern "C" {
     bool isFirstArmingGyroCalibrationRunning(void) { return false; }
     void pidController(const pidProfile_t *, const rollAndPitchTrims_t *, timeUs_t) {}
     void pidStabilisationState(pidStabilisationState_e) {}
+    uint8_t pidGetProcessDenom(void) { return 1; }
     void mixTable(timeUs_t , uint8_t) {};
     void writeMotors(void) {};
     void writeServos(void) {};
@@ -772,7 +783,7 @@ extern "C" {
     void mspSerialReleaseSharedTelemetryPorts(void) {}
     void telemetryCheckState(void) {}
     void mspSerialAllocatePorts(void) {}
-    void gyroReadTemperature(void) {}
+    bool gyroReadTemperature(void) { return false; }
     void updateRcCommands(void) {}
     void applyAltHold(void) {}
     void resetYawAxis(void) {}
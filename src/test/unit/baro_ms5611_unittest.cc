@@ -148,6 +148,8 @@ void delayMicroseconds(uint32_t) {}
 
 bool busReadRegisterBuffer(const busDevice_t*, uint8_t, uint8_t*, uint8_t) {return true;}
 bool busWriteRegister(const busDevice_t*, uint8_t, uint8_t) {return true;}
+bool busReadRegisterBufferStart(const busDevice_t*, uint8_t, uint8_t*, uint8_t, busTransfer_t*) {return true;}
+bool busTransferDone(const busDevice_t*, const busTransfer_t*, bool *error) {*error = false; return true;}
 
 void spiSetDivisor() {
 }
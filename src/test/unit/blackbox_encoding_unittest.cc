@@ -14,6 +14,7 @@
  * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <limits.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -22,6 +23,7 @@ extern "C" {
 
     #include "blackbox/blackbox.h"
     #include "blackbox/blackbox_encoding.h"
+    #include "common/encoding.h"
     #include "common/utils.h"
 
     #include "pg/pg.h"
@@ -240,6 +242,331 @@ TEST(BlackboxTest, TestWriteTag2_3SVariable_BITS887)
     EXPECT_EQ(0, buf[3]); // ensure next byte has not been written
     buf += 3;
 }
+/*
+ * Reference implementations of the tag encoders as they were before they were reworked to classify field widths
+ * with bit tricks and lookup tables. The optimised encoders must produce byte identical output.
+ */
+static uint8_t referenceBuffer[SERIAL_BUFFER_SIZE];
+static int referencePos;
+
+static void referenceWrite(uint8_t value)
+{
+    EXPECT_LT(referencePos, sizeof(referenceBuffer));
+    referenceBuffer[referencePos++] = value;
+}
+
+static void referenceWriteSignedVB(int32_t value)
+{
+    uint32_t u = zigzagEncode(value);
+    while (u > 127) {
+        referenceWrite((uint8_t) (u | 0x80));
+        u >>= 7;
+    }
+    referenceWrite(u);
+}
+
+static void referenceWriteTag2_3S32(int32_t *values)
+{
+    const int NUM_FIELDS = 3;
+
+    //Need to be enums rather than const ints if we want to switch on them (due to being C)
+    enum {
+        BITS_2  = 0,
+        BITS_4  = 1,
+        BITS_6  = 2,
+        BITS_32 = 3
+    };
+
+    enum {
+        BYTES_1  = 0,
+        BYTES_2  = 1,
+        BYTES_3  = 2,
+        BYTES_4  = 3
+    };
+
+    int selector = BITS_2, selector2;
+
+    /*
+     * Find out how many bits the largest value requires to encode, and use it to choose one of the packing schemes
+     * below:
+     *
+     * Selector possibilities
+     *
+     * 2 bits per field  ss11 2233,
+     * 4 bits per field  ss00 1111 2222 3333
+     * 6 bits per field  ss11 1111 0022 2222 0033 3333
+     * 32 bits per field sstt tttt followed by fields of various byte counts
+     */
+    for (int x = 0; x < NUM_FIELDS; x++) {
+        //Require more than 6 bits?
+        if (values[x] >= 32 || values[x] < -32) {
+            selector = BITS_32;
+            break;
+        }
+
+        //Require more than 4 bits?
+        if (values[x] >= 8 || values[x] < -8) {
+             if (selector < BITS_6) {
+                 selector = BITS_6;
+             }
+        } else if (values[x] >= 2 || values[x] < -2) { //Require more than 2 bits?
+            if (selector < BITS_4) {
+                selector = BITS_4;
+            }
+        }
+    }
+
+    switch (selector) {
+    case BITS_2:
+        referenceWrite((selector << 6) | ((values[0] & 0x03) << 4) | ((values[1] & 0x03) << 2) | (values[2] & 0x03));
+        break;
+    case BITS_4:
+        referenceWrite((selector << 6) | (values[0] & 0x0F));
+        referenceWrite((values[1] << 4) | (values[2] & 0x0F));
+        break;
+    case BITS_6:
+        referenceWrite((selector << 6) | (values[0] & 0x3F));
+        referenceWrite((uint8_t)values[1]);
+        referenceWrite((uint8_t)values[2]);
+        break;
+    case BITS_32:
+        /*
+         * Do another round to compute a selector for each field, assuming that they are at least 8 bits each
+         *
+         * Selector2 field possibilities
+         * 0 - 8 bits
+         * 1 - 16 bits
+         * 2 - 24 bits
+         * 3 - 32 bits
+         */
+        selector2 = 0;
+
+        //Encode in reverse order so the first field is in the low bits:
+        for (int x = NUM_FIELDS - 1; x >= 0; x--) {
+            selector2 <<= 2;
+
+            if (values[x] < 128 && values[x] >= -128) {
+                selector2 |= BYTES_1;
+            } else if (values[x] < 32768 && values[x] >= -32768) {
+                selector2 |= BYTES_2;
+            } else if (values[x] < 8388608 && values[x] >= -8388608) {
+                selector2 |= BYTES_3;
+            } else {
+                selector2 |= BYTES_4;
+            }
+        }
+
+        //Write the selectors
+        referenceWrite((selector << 6) | selector2);
+
+        //And now the values according to the selectors we picked for them
+        for (int x = 0; x < NUM_FIELDS; x++, selector2 >>= 2) {
+            switch (selector2 & 0x03) {
+            case BYTES_1:
+                referenceWrite(values[x]);
+                break;
+            case BYTES_2:
+                referenceWrite(values[x]);
+                referenceWrite(values[x] >> 8);
+                break;
+            case BYTES_3:
+                referenceWrite(values[x]);
+                referenceWrite(values[x] >> 8);
+                referenceWrite(values[x] >> 16);
+                break;
+            case BYTES_4:
+                referenceWrite(values[x]);
+                referenceWrite(values[x] >> 8);
+                referenceWrite(values[x] >> 16);
+                referenceWrite(values[x] >> 24);
+                break;
+            }
+        }
+        break;
+    }
+}
+
+static void referenceWriteTag8_4S16(int32_t *values)
+{
+
+    //Need to be enums rather than const ints if we want to switch on them (due to being C)
+    enum {
+        FIELD_ZERO  = 0,
+        FIELD_4BIT  = 1,
+        FIELD_8BIT  = 2,
+        FIELD_16BIT = 3
+    };
+
+    uint8_t selector = 0;
+    //Encode in reverse order so the first field is in the low bits:
+    for (int x = 3; x >= 0; x--) {
+        selector <<= 2;
+
+        if (values[x] == 0) {
+            selector |= FIELD_ZERO;
+        } else if (values[x] < 8 && values[x] >= -8) {
+            selector |= FIELD_4BIT;
+        } else if (values[x] < 128 && values[x] >= -128) {
+            selector |= FIELD_8BIT;
+        } else {
+            selector |= FIELD_16BIT;
+        }
+    }
+
+    referenceWrite(selector);
+
+    int nibbleIndex = 0;
+    uint8_t buffer = 0;
+    for (int x = 0; x < 4; x++, selector >>= 2) {
+        switch (selector & 0x03) {
+        case FIELD_ZERO:
+            //No-op
+            break;
+        case FIELD_4BIT:
+            if (nibbleIndex == 0) {
+                //We fill high-bits first
+                buffer = values[x] << 4;
+                nibbleIndex = 1;
+            } else {
+                referenceWrite(buffer | (values[x] & 0x0F));
+                nibbleIndex = 0;
+            }
+            break;
+        case FIELD_8BIT:
+            if (nibbleIndex == 0) {
+                referenceWrite(values[x]);
+            } else {
+                //Write the high bits of the value first (mask to avoid sign extension)
+                referenceWrite(buffer | ((values[x] >> 4) & 0x0F));
+                //Now put the leftover low bits into the top of the next buffer entry
+                buffer = values[x] << 4;
+            }
+            break;
+        case FIELD_16BIT:
+            if (nibbleIndex == 0) {
+                //Write high byte first
+                referenceWrite(values[x] >> 8);
+                referenceWrite(values[x]);
+            } else {
+                //First write the highest 4 bits
+                referenceWrite(buffer | ((values[x] >> 12) & 0x0F));
+                // Then the middle 8
+                referenceWrite(values[x] >> 4);
+                //Only the smallest 4 bits are still left to write
+                buffer = values[x] << 4;
+            }
+            break;
+        }
+    }
+    //Anything left over to write?
+    if (nibbleIndex == 1) {
+        referenceWrite(buffer);
+    }
+}
+
+static void referenceWriteTag8_8SVB(int32_t *values, int valueCount)
+{
+    uint8_t header;
+
+    if (valueCount > 0) {
+        //If we're only writing one field then we can skip the header
+        if (valueCount == 1) {
+            referenceWriteSignedVB(values[0]);
+        } else {
+            //First write a one-byte header that marks which fields are non-zero
+            header = 0;
+
+            // First field should be in low bits of header
+            for (int i = valueCount - 1; i >= 0; i--) {
+                header <<= 1;
+
+                if (values[i] != 0) {
+                    header |= 0x01;
+                }
+            }
+
+            referenceWrite(header);
+
+            for (int i = 0; i < valueCount; i++) {
+                if (values[i] != 0) {
+                    referenceWriteSignedVB(values[i]);
+                }
+            }
+        }
+    }
+}
+
+static void referenceReset(void)
+{
+    serialTestResetBuffers();
+    memset(referenceBuffer, 0, sizeof(referenceBuffer));
+    referencePos = 0;
+}
+
+static void expectSameAsReference(void)
+{
+    ASSERT_EQ(referencePos, serialWritePos);
+    EXPECT_EQ(0, memcmp(referenceBuffer, serialWriteBuffer, referencePos));
+}
+
+// Values either side of every width boundary used by the encoders
+static const int32_t boundaryValues[] = {
+    0, 1, -1, 2, -2, -3, 7, 8, -8, -9, 15, 16, -16, -17, 31, 32, -32, -33, 127, 128, -128, -129, 255, 256, -256, -257,
+    32767, 32768, -32768, -32769, 8388607, 8388608, -8388608, -8388609, INT32_MAX, INT32_MIN
+};
+
+TEST(BlackboxEncodingTest, TestWriteTag2_3S32MatchesReference)
+{
+    for (auto a : boundaryValues) {
+        for (auto b : boundaryValues) {
+            for (auto c : boundaryValues) {
+                int32_t values[3] = { a, b, c };
+                referenceReset();
+                referenceWriteTag2_3S32(values);
+                blackboxWriteTag2_3S32(values);
+                expectSameAsReference();
+            }
+        }
+    }
+}
+
+TEST(BlackboxEncodingTest, TestWriteTag8_4S16MatchesReference)
+{
+    static const int32_t values16[] = { 0, 1, -1, 7, 8, -8, -9, 127, 128, -128, -129, 32767, -32768 };
+
+    for (auto a : values16) {
+        for (auto b : values16) {
+            for (auto c : values16) {
+                for (auto d : values16) {
+                    int32_t values[4] = { a, b, c, d };
+                    referenceReset();
+                    referenceWriteTag8_4S16(values);
+                    blackboxWriteTag8_4S16(values);
+                    expectSameAsReference();
+                }
+            }
+        }
+    }
+}
+
+TEST(BlackboxEncodingTest, TestWriteTag8_8SVBMatchesReference)
+{
+    int32_t values[8];
+
+    for (int count = 0; count <= 8; count++) {
+        // every combination of zero and non-zero fields
+        for (int mask = 0; mask < (1 << count); mask++) {
+            for (int i = 0; i < count; i++) {
+                values[i] = (mask & (1 << i)) ? boundaryValues[(mask + i * 7) % ARRAYLEN(boundaryValues)] | 1 : 0;
+            }
+            referenceReset();
+            referenceWriteTag8_8SVB(values, count);
+            blackboxWriteTag8_8SVB(values, count);
+            expectSameAsReference();
+        }
+    }
+}
+
 // STUBS
 extern "C" {
 PG_REGISTER(blackboxConfig_t, blackboxConfig, PG_BLACKBOX_CONFIG, 0);
@@ -347,6 +347,48 @@ TEST(BlackboxTest, Test_CalculateRates)
 }
 
 
+TEST(BlackboxTest, TestAdaptiveRate)
+{
+    // 8kHz PIDloop, 1kHz logging
+    targetPidLooptime = 125;
+    blackboxConfigMutable()->p_ratio = 32;
+    blackboxInit();
+    EXPECT_EQ(8, blackboxPInterval);
+
+    // no drops at the configured rate, nothing to do
+    EXPECT_EQ(8, blackboxAdaptiveRateStep(40000, 0, 1000));
+
+    // 60kB/s produced but the device took 40kB/s, keep below 80% of that
+    EXPECT_EQ(16, blackboxAdaptiveRateStep(40000, 20000, 1000));
+    // the new interval is taken up at the next I frame
+    EXPECT_EQ(8, blackboxPInterval);
+    for (int ii = 0; ii < 256; ++ii) {
+        blackboxAdvanceIterationTimers();
+    }
+    EXPECT_EQ(true, blackboxShouldLogIFrame());
+    EXPECT_EQ(16, blackboxPInterval);
+
+    // a stalled device doesn't change the rate
+    EXPECT_EQ(16, blackboxAdaptiveRateStep(0, 30000, 1000));
+
+    // after 5 windows without drops the faster rate is tried again
+    for (int ii = 0; ii < 4; ++ii) {
+        EXPECT_EQ(16, blackboxAdaptiveRateStep(30000, 0, 1000));
+    }
+    EXPECT_EQ(8, blackboxAdaptiveRateStep(30000, 0, 1000));
+
+    // it fails again, so the next try waits twice as long
+    EXPECT_EQ(16, blackboxAdaptiveRateStep(40000, 20000, 1000));
+    for (int ii = 0; ii < 9; ++ii) {
+        EXPECT_EQ(16, blackboxAdaptiveRateStep(30000, 0, 1000));
+    }
+    EXPECT_EQ(8, blackboxAdaptiveRateStep(30000, 0, 1000));
+    EXPECT_EQ(8, blackboxAdaptiveRateStep(40000, 0, 1000));
+
+    // a very slow device is left with the I frames only
+    EXPECT_EQ(256, blackboxAdaptiveRateStep(1000, 60000, 1000));
+}
+
 // STUBS
 extern "C" {
 
@@ -367,6 +409,10 @@ gpsSolutionData_t gpsSol;
 int32_t GPS_home[2];
 
 gyro_t gyro;
+static gyroSampleRing_t gyroSampleRingStub;
+const gyroSampleRing_t *gyroSampleRing(void) {return &gyroSampleRingStub;}
+void gyroSampleReaderInit(gyroSampleReader_t *reader, const gyroSampleRing_t *ring) {reader->ring = ring;}
+unsigned gyroSampleRead(gyroSampleReader_t *, gyroSample_t *, unsigned) {return 0;}
 
 float motorOutputHigh, motorOutputLow;
 float motor_disarmed[MAX_SUPPORTED_MOTORS];
@@ -386,6 +432,7 @@ bool isModeActivationConditionPresent(boxId_e) {return false;}
 uint32_t millis(void) {return 0;}
 bool sensors(uint32_t) {return false;}
 void serialWrite(serialPort_t *, uint8_t) {}
+void serialWriteBuf(serialPort_t *, const uint8_t *, int) {}
 uint32_t serialTxBytesFree(const serialPort_t *) {return 0;}
 bool isSerialTransmitBufferEmpty(const serialPort_t *) {return false;}
 bool feature(uint32_t) {return false;}
@@ -57,9 +57,12 @@ extern "C" {
     void cliGet(char *cmdline);
 
     const clivalue_t valueTable[] = {
-        { "array_unit_test",             VAR_INT8  | MODE_ARRAY | MASTER_VALUE, .config.array.length = 3, PG_RESERVED_FOR_TESTING_1, 0 }
+        { "array_unit_test",             VAR_INT8  | MODE_ARRAY | MASTER_VALUE, .config.array.length = 3, PG_RESERVED_FOR_TESTING_1, 0 },
+        { "array",                       VAR_INT8  | MODE_ARRAY | MASTER_VALUE, .config.array.length = 1, PG_RESERVED_FOR_TESTING_1, 3 },
+        { "a_unit_test",                 VAR_INT8  | MODE_ARRAY | MASTER_VALUE, .config.array.length = 1, PG_RESERVED_FOR_TESTING_1, 4 },
     };
     const uint16_t valueTableEntryCount = ARRAYLEN(valueTable);
+    uint16_t valueTableNameIndex[ARRAYLEN(valueTable)];
     const lookupTableEntry_t lookupTables[] = {};
 
 
@@ -81,7 +84,7 @@ extern "C" {
     PG_REGISTER_ARRAY(rxFailsafeChannelConfig_t, MAX_SUPPORTED_RC_CHANNEL_COUNT, rxFailsafeChannelConfigs, PG_RX_FAILSAFE_CHANNEL_CONFIG, 0);
     PG_REGISTER(pidConfig_t, pidConfig, PG_PID_CONFIG, 0);
 
-    PG_REGISTER_WITH_RESET_FN(int8_t, unitTestData, PG_RESERVED_FOR_TESTING_1, 0);
+    PG_REGISTER_ARRAY(int8_t, 5, unitTestData, PG_RESERVED_FOR_TESTING_1, 0);
 }
 
 #include "unittest_macros.h"
@@ -115,6 +118,16 @@ TEST(CLIUnittest, TestCliSet)
     //EXPECT_EQ(false, false);
 }
 
+TEST(CLIUnittest, TestCliSetFindsExactName)
+{
+    cliSet((char *)"array = 7");
+    cliSet((char *)"a_unit_test=9");
+    cliSet((char *)"arr = 11");
+
+    EXPECT_EQ(7, *(int8_t *)cliGetValuePointer(&valueTable[1]));
+    EXPECT_EQ(9, *(int8_t *)cliGetValuePointer(&valueTable[2]));
+}
+
 // STUBS
 extern "C" {
 
@@ -166,12 +179,6 @@ static const box_t boxes[] = { { 0, "DUMMYBOX", 0 } };
 const box_t *findBoxByPermanentId(uint8_t) { return &boxes[0]; }
 const box_t *findBoxByBoxId(boxId_e) { return &boxes[0]; }
 
-int8_t unitTestDataArray[3];
-
-void pgResetFn_unitTestData(int8_t *ptr) {
-    ptr = &unitTestDataArray[0];
-}
-
 uint32_t getBeeperOffMask(void) { return 0; }
 uint32_t getPreferredBeeperOffMask(void) { return 0; }
 
@@ -206,7 +213,12 @@ void mixerLoadMix(int, motorMixer_t *) {}
 bool setModeColor(ledModeIndex_e, int, int) { return false; }
 float convertExternalToMotor(uint16_t ){ return 1.0; }
 uint8_t getCurrentPidProfileIndex(void){ return 1; }
+pidProfile_t *currentPidProfile;
+void pidPrepareProfile(const pidProfile_t *) {}
+bool gyroReconfigureFilters(void) { return true; }
+void analyzeModeActivationConditions(void) {}
 uint8_t getCurrentControlRateProfileIndex(void){ return 1; }
+uint8_t pidGetProcessDenom(void) { return 1; }
 void changeControlRateProfile(uint8_t) {}
 void resetAllRxChannelRangeConfigurations(rxChannelRangeConfig_t *) {}
 void writeEEPROM() {}
@@ -229,6 +241,7 @@ uint16_t getEEPROMConfigSize(void) { return 1024; }
 uint8_t __config_start = 0x00;
 uint8_t __config_end = 0x10;
 uint16_t averageSystemLoadPercent = 0;
+uint16_t averageIdlePercent = 0;
 
 timeDelta_t getTaskDeltaTime(cfTaskId_e){ return 0; }
 uint16_t currentRxRefreshRate = 9000;
@@ -31,6 +31,7 @@ extern "C" {
     #include "cms/cms.h"
     #include "cms/cms_types.h"
     #include "fc/runtime_config.h"
+    #include "scheduler/scheduler.h"
     void cmsMenuOpen(void);
     long cmsMenuBack(displayPort_t *pDisplay);
     uint16_t cmsHandleKey(displayPort_t *pDisplay, uint8_t key);
@@ -139,6 +140,8 @@ int16_t rcData[18];
 void delay(uint32_t) {}
 uint32_t micros(void) { return 0; }
 uint32_t millis(void) { return 0; }
+timeDelta_t schedulerGetRemainingTimeUs(void) { return SCHEDULER_TIME_UNLIMITED; }
+void schedulerYield(void) {}
 void saveConfigAndNotify(void) {}
 void stopMotors(void) {}
 void stopPwmAllMotors(void) {}
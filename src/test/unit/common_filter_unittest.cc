@@ -114,3 +114,264 @@ TEST(FilterUnittest, TestSlewFilter)
     slewFilterApply(&filter, 200.0f);
     EXPECT_EQ(200, filter.state);
 }
+
+TEST(FilterUnittest, TestBiquadFilterBankMatchesScalarFilters)
+{
+    biquadFilter_t notch[3];
+    biquadFilter_t lpf[3];
+    pt1Filter_t pt1[3];
+    const float k = pt1FilterGain(100, 0.000125f);
+    for (int axis = 0; axis < 3; axis++) {
+        biquadFilterInit(&notch[axis], 200, 125, filterGetNotchQ(200, 150), FILTER_NOTCH);
+        biquadFilterInitLPF(&lpf[axis], 150, 125);
+        pt1FilterInit(&pt1[axis], k);
+    }
+
+    biquadFilterBank_t bank;
+    biquadFilterBankInit(&bank);
+    EXPECT_TRUE(biquadFilterBankAddBiquad(&bank, &notch[0]));
+    EXPECT_TRUE(biquadFilterBankAddBiquad(&bank, &lpf[0]));
+    EXPECT_TRUE(biquadFilterBankAddPt1(&bank, k));
+    EXPECT_EQ(3, bank.stageCount);
+
+    for (int i = 0; i < 200; i++) {
+        float data[3];
+        float expected[3];
+        for (int axis = 0; axis < 3; axis++) {
+            data[axis] = (i % (7 + axis)) * 100.0f - 300.0f;
+            expected[axis] = biquadFilterApply(&notch[axis], data[axis]);
+            expected[axis] = biquadFilterApply(&lpf[axis], expected[axis]);
+            expected[axis] = pt1FilterApply(&pt1[axis], expected[axis]);
+        }
+        biquadFilterBankApply(&bank, data);
+        for (int axis = 0; axis < 3; axis++) {
+            EXPECT_NEAR(expected[axis], data[axis], 1e-3f);
+        }
+    }
+}
+
+TEST(FilterUnittest, TestBiquadFilterBankFull)
+{
+    biquadFilterBank_t bank;
+    biquadFilterBankInit(&bank);
+    for (int i = 0; i < BIQUAD_FILTER_BANK_MAX_STAGES; i++) {
+        EXPECT_TRUE(biquadFilterBankAddPt1(&bank, 0.5f));
+    }
+    EXPECT_FALSE(biquadFilterBankAddPt1(&bank, 0.5f));
+
+    // an empty bank passes the data through
+    biquadFilterBankInit(&bank);
+    float data[3] = { 1.0f, 2.0f, 3.0f };
+    biquadFilterBankApply(&bank, data);
+    EXPECT_EQ(1.0f, data[0]);
+    EXPECT_EQ(2.0f, data[1]);
+    EXPECT_EQ(3.0f, data[2]);
+}
+
+TEST(FilterUnittest, TestBiquadFilterFixedBankMatchesFloatBank)
+{
+    biquadFilter_t notch;
+    biquadFilter_t lpf;
+    biquadFilterInit(&notch, 200, 1000, filterGetNotchQ(200, 150), FILTER_NOTCH);
+    biquadFilterInitLPF(&lpf, 150, 1000);
+
+    biquadFilterBank_t bank;
+    biquadFilterBankInit(&bank);
+    EXPECT_TRUE(biquadFilterBankAddBiquad(&bank, &notch));
+    EXPECT_TRUE(biquadFilterBankAddBiquad(&bank, &lpf));
+    EXPECT_TRUE(biquadFilterBankAddPt1(&bank, pt1FilterGain(100, 0.001f)));
+
+    biquadFilterFixedBank_t fixedBank;
+    biquadFilterFixedBankInit(&fixedBank, &bank);
+    EXPECT_EQ(3, fixedBank.stageCount);
+
+    const float dataScale = 1 << FIXED_FILTER_DATA_BITS;
+    for (int i = 0; i < 500; i++) {
+        float data[3];
+        int32_t fixedData[3];
+        for (int axis = 0; axis < 3; axis++) {
+            // full scale steps and a small signal, both must track within a fraction of a sensor count
+            const float input = axis == 2 ? (i % 9) - 4.0f : ((i / 50) % 2 ? 32000.0f : -32000.0f) + (i % (7 + axis)) * 100.0f;
+            data[axis] = input;
+            fixedData[axis] = lrintf(input * dataScale);
+        }
+        biquadFilterBankApply(&bank, data);
+        biquadFilterFixedBankApply(&fixedBank, fixedData);
+        for (int axis = 0; axis < 3; axis++) {
+            EXPECT_NEAR(data[axis], fixedData[axis] / dataScale, 0.05f);
+        }
+    }
+}
+
+TEST(FilterUnittest, TestKalmanFilterAdaptsToNoise)
+{
+    const float k = pt1FilterGain(90, 0.000125f);
+    const float noiseVariance = 25.0f;
+
+    // alternating +-a samples differ by 2a, so this is noise at the nominal variance
+    const float a = sqrtf(noiseVariance / 2);
+    kalmanFilter_t filter;
+    kalmanFilterInit(&filter, k, noiseVariance);
+    float gain = 0;
+    for (int i = 0; i < 2000; i++) {
+        const float previous = filter.x;
+        const float input = (i % 2) ? a : -a;
+        const float output = kalmanFilterApply(&filter, input);
+        gain = (output - previous) / (input - previous);
+    }
+    EXPECT_NEAR(k, gain, 1e-4f);
+
+    // noisier input is filtered harder
+    kalmanFilterInit(&filter, k, noiseVariance);
+    for (int i = 0; i < 2000; i++) {
+        const float previous = filter.x;
+        const float input = (i % 2) ? 2 * a : -2 * a;
+        const float output = kalmanFilterApply(&filter, input);
+        gain = (output - previous) / (input - previous);
+    }
+    EXPECT_LT(gain, k * 0.75f);
+
+    // a clean ramp is tracked with almost no lag
+    kalmanFilterInit(&filter, k, noiseVariance);
+    float output = 0;
+    for (int i = 0; i < 200; i++) {
+        output = kalmanFilterApply(&filter, i * 0.1f);
+    }
+    EXPECT_NEAR(199 * 0.1f, output, 0.1f);
+
+    // the same ramp through the PT1 lags behind
+    pt1Filter_t pt1;
+    pt1FilterInit(&pt1, k);
+    for (int i = 0; i < 200; i++) {
+        output = pt1FilterApply(&pt1, i * 0.1f);
+    }
+    EXPECT_LT(output, 199 * 0.1f - 0.5f);
+}
+
+TEST(FilterUnittest, TestKalmanFilterRecoversAfterLargeNoise)
+{
+    const float k = pt1FilterGain(90, 0.000125f);
+    const float noiseVariance = 25.0f;
+    const float a = sqrtf(noiseVariance / 2);
+
+    kalmanFilter_t filter;
+    kalmanFilterInit(&filter, k, noiseVariance);
+    // a burst of noise far above the nominal level
+    for (int i = 0; i < 1000; i++) {
+        kalmanFilterApply(&filter, (i % 3) ? 1777.7f * (i % 7) : -2333.3f);
+    }
+    // the noise estimate returns to the nominal level, without rounding left over from the burst
+    for (int i = 0; i < 2000; i++) {
+        kalmanFilterApply(&filter, (i % 2) ? a : -a);
+    }
+    EXPECT_NEAR(2 * noiseVariance, filter.deltaSquaredSum / KALMAN_FILTER_WINDOW, 1e-3f);
+}
+
+TEST(FilterUnittest, TestFilterChainMatchesScalarFilters)
+{
+    biquadFilter_t dynNotch[2];
+    biquadFilter_t notch[2];
+    pt1Filter_t pt1[2];
+    biquadFilter_t lpf[2];
+    for (int i = 0; i < 2; i++) {
+        biquadFilterInit(&dynNotch[i], 300, 125, filterGetNotchQ(300, 250), FILTER_NOTCH);
+        biquadFilterInit(&notch[i], 200, 125, filterGetNotchQ(200, 150), FILTER_NOTCH);
+        pt1FilterInit(&pt1[i], pt1FilterGain(100, 0.000125f));
+        biquadFilterInitLPF(&lpf[i], 150, 125);
+    }
+
+    filterChain_t chain;
+    filterChainInit(&chain);
+    filterChainAdd(&chain, (filterApplyFnPtr)biquadFilterApplyDF1, &dynNotch[0]);
+    filterChainAdd(&chain, (filterApplyFnPtr)biquadFilterApply, &notch[0]);
+    filterChainAdd(&chain, nullFilterApply, NULL);
+    filterChainAdd(&chain, (filterApplyFnPtr)biquadFilterApply, &lpf[0]);
+    filterChainAdd(&chain, (filterApplyFnPtr)pt1FilterApply, &pt1[0]);
+    EXPECT_EQ(&dynNotch[0], chain.biquadDF1);
+    EXPECT_EQ(2, chain.biquadCount);
+    EXPECT_EQ(1, chain.pt1Count);
+
+    const filterChainApplyFnPtr applyFn = filterChainGetApplyFn(&chain);
+    for (int i = 0; i < 200; i++) {
+        const float input = (i % 7) * 100.0f - 300.0f;
+        float expected = biquadFilterApplyDF1(&dynNotch[1], input);
+        expected = biquadFilterApply(&notch[1], expected);
+        expected = biquadFilterApply(&lpf[1], expected);
+        expected = pt1FilterApply(&pt1[1], expected);
+        EXPECT_FLOAT_EQ(expected, applyFn(&chain, input));
+    }
+
+    // an empty chain passes the input through
+    filterChainInit(&chain);
+    EXPECT_EQ(123.0f, filterChainGetApplyFn(&chain)(&chain, 123.0f));
+}
+
+TEST(FilterUnittest, TestBiquadFilterUpdateNotch)
+{
+    const float frequencies[] = { 20, 100, 330, 1000, 1999, 2001, 3500 };
+    for (unsigned i = 0; i < sizeof(frequencies) / sizeof(frequencies[0]); i++) {
+        biquadFilter_t reference;
+        biquadFilterInit(&reference, frequencies[i], 125, 3.5f, FILTER_NOTCH);
+
+        biquadFilter_t filter;
+        biquadFilterInit(&filter, 400, 125, 1.0f, FILTER_NOTCH);
+        filter.x1 = 1;
+        filter.x2 = 2;
+        filter.y1 = 3;
+        filter.y2 = 4;
+        biquadFilterUpdateNotch(&filter, frequencies[i], 125, 3.5f);
+
+        EXPECT_NEAR(reference.b0, filter.b0, 1e-5f);
+        EXPECT_NEAR(reference.b1, filter.b1, 1e-5f);
+        EXPECT_NEAR(reference.b2, filter.b2, 1e-5f);
+        EXPECT_NEAR(reference.a1, filter.a1, 1e-5f);
+        EXPECT_NEAR(reference.a2, filter.a2, 1e-5f);
+
+        // the state is kept
+        EXPECT_FLOAT_EQ(1, filter.x1);
+        EXPECT_FLOAT_EQ(2, filter.x2);
+        EXPECT_FLOAT_EQ(3, filter.y1);
+        EXPECT_FLOAT_EQ(4, filter.y2);
+    }
+}
+
+TEST(FilterUnittest, TestCicDecimator)
+{
+    cicDecimator_t filter;
+    cicDecimatorInit(&filter, 4);
+    EXPECT_EQ(4, filter.ratio);
+    EXPECT_EQ(64, filter.gain);
+
+    // a constant input settles to the same value once the filter is primed, one output every 4 samples
+    int32_t output = 0;
+    int outputs = 0;
+    for (int i = 0; i < 40; i++) {
+        if (cicDecimatorApply(&filter, -1234, &output)) {
+            outputs++;
+            EXPECT_EQ(0, (i + 1) % 4);
+        }
+    }
+    EXPECT_EQ(10, outputs);
+    EXPECT_EQ(-1234, output);
+
+    // an input alternating at the input Nyquist frequency falls in a null of the response
+    cicDecimatorInit(&filter, 4);
+    for (int i = 0; i < 40; i++) {
+        if (cicDecimatorApply(&filter, (i & 1) ? 1000 : -1000, &output) && i > 12) {
+            EXPECT_EQ(0, output);
+        }
+    }
+
+    // full scale input for a long time wraps the integrators without disturbing the output
+    cicDecimatorInit(&filter, CIC_DECIMATOR_MAX_RATIO);
+    for (int i = 0; i < 100000; i++) {
+        cicDecimatorApply(&filter, 32767, &output);
+    }
+    EXPECT_EQ(32767, output);
+
+    // ratios outside the supported range are clamped
+    cicDecimatorInit(&filter, 0);
+    EXPECT_EQ(1, filter.ratio);
+    EXPECT_TRUE(cicDecimatorApply(&filter, 7, &output));
+    EXPECT_EQ(7, output);
+}
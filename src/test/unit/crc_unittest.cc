@@ -0,0 +1,88 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "common/crc.h"
+    #include "common/streambuf.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static const uint8_t checkData[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+
+// bitwise versions, the tables have to give the same result for every input
+static uint16_t crc16CcittBitwise(uint16_t crc, uint8_t a)
+{
+    crc ^= (uint16_t)a << 8;
+    for (int ii = 0; ii < 8; ++ii) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+static uint8_t crc8DvbS2Bitwise(uint8_t crc, uint8_t a)
+{
+    crc ^= a;
+    for (int ii = 0; ii < 8; ++ii) {
+        crc = (crc & 0x80) ? (crc << 1) ^ 0xD5 : crc << 1;
+    }
+    return crc;
+}
+
+TEST(CrcTest, Crc16CcittCheckValue)
+{
+    // CRC-16/XMODEM check value
+    EXPECT_EQ(0x31C3, crc16_ccitt_update(0, checkData, sizeof(checkData)));
+}
+
+TEST(CrcTest, Crc8DvbS2CheckValue)
+{
+    EXPECT_EQ(0xBC, crc8_dvb_s2_update(0, checkData, sizeof(checkData)));
+}
+
+TEST(CrcTest, MatchesBitwiseForAllBytes)
+{
+    for (int crc = 0; crc < 256; crc++) {
+        for (int a = 0; a < 256; a++) {
+            ASSERT_EQ(crc8DvbS2Bitwise(crc, a), crc8_dvb_s2(crc, a));
+            const uint16_t crc16 = crc * 257;
+            ASSERT_EQ(crc16CcittBitwise(crc16, a), crc16_ccitt(crc16, a));
+        }
+    }
+}
+
+TEST(CrcTest, SbufAppend)
+{
+    uint8_t buffer[16];
+    sbuf_t sbuf;
+    sbuf.ptr = buffer;
+    sbuf.end = buffer + sizeof(buffer);
+
+    memcpy(buffer, checkData, sizeof(checkData));
+    sbufAdvance(&sbuf, sizeof(checkData));
+    crc8_dvb_s2_sbuf_append(&sbuf, buffer);
+    EXPECT_EQ(0xBC, buffer[sizeof(checkData)]);
+
+    sbuf.ptr = buffer + sizeof(checkData);
+    crc16_ccitt_sbuf_append(&sbuf, buffer);
+    // sbuf is little endian
+    EXPECT_EQ(0xC3, buffer[sizeof(checkData)]);
+    EXPECT_EQ(0x31, buffer[sizeof(checkData) + 1]);
+}
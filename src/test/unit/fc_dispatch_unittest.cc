@@ -0,0 +1,204 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "common/utils.h"
+    #include "fc/fc_dispatch.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+extern "C" {
+    uint32_t simulatedTime = 0;
+    uint32_t micros(void) { return simulatedTime; }
+}
+
+static int dispatchCount[4];
+static uint32_t dispatchedAt[4];
+static dispatchEntry_t entries[4];
+static dispatchEntry_t *entryToCancel;
+static int replanDelayUs;
+
+static void testDispatch(dispatchEntry_t *self)
+{
+    const int index = self - entries;
+    dispatchCount[index]++;
+    dispatchedAt[index] = simulatedTime;
+    if (entryToCancel) {
+        dispatchCancel(entryToCancel);
+        entryToCancel = NULL;
+    }
+    if (replanDelayUs) {
+        dispatchAdd(self, replanDelayUs);
+    }
+}
+
+static int manyDispatchCount;
+
+static void testManyDispatch(dispatchEntry_t *self)
+{
+    UNUSED(self);
+    manyDispatchCount++;
+}
+
+static void runUntil(uint32_t endTime, uint32_t stepUs)
+{
+    while (cmp32(endTime, simulatedTime) > 0) {
+        simulatedTime += stepUs;
+        dispatchProcess(simulatedTime);
+    }
+}
+
+class DispatchTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        // drain anything left over by the previous test
+        for (unsigned i = 0; i < ARRAYLEN(entries); i++) {
+            dispatchCancel(&entries[i]);
+            entries[i].dispatch = testDispatch;
+            dispatchCount[i] = 0;
+            dispatchedAt[i] = 0;
+        }
+        entryToCancel = NULL;
+        replanDelayUs = 0;
+    }
+};
+
+TEST_F(DispatchTest, TestExpiresInOrder)
+{
+    const uint32_t startTime = simulatedTime;
+    dispatchAdd(&entries[0], 3000);
+    dispatchAdd(&entries[1], 1000);
+    dispatchAdd(&entries[2], 2000);
+    EXPECT_EQ(3, dispatchPendingCount());
+
+    runUntil(startTime + 5000, 100);
+
+    EXPECT_EQ(0, dispatchPendingCount());
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(1, dispatchCount[i]);
+    }
+    EXPECT_LT(dispatchedAt[1], dispatchedAt[2]);
+    EXPECT_LT(dispatchedAt[2], dispatchedAt[0]);
+    // never early, and late by no more than a tick plus the polling step
+    EXPECT_GE(dispatchedAt[1], startTime + 1000);
+    EXPECT_LE(dispatchedAt[1], startTime + 1000 + 128 + 100);
+}
+
+TEST_F(DispatchTest, TestLongDelayCascades)
+{
+    // long enough to start out on the top level of the wheel
+    const uint32_t startTime = simulatedTime;
+    const int delayUs = 40000000;
+    dispatchAdd(&entries[0], delayUs);
+
+    runUntil(startTime + delayUs - 1000, 1000);
+    EXPECT_EQ(0, dispatchCount[0]);
+    EXPECT_TRUE(dispatchIsPending(&entries[0]));
+
+    runUntil(startTime + delayUs + 1000, 1000);
+    EXPECT_EQ(1, dispatchCount[0]);
+    EXPECT_FALSE(dispatchIsPending(&entries[0]));
+    EXPECT_GE(dispatchedAt[0], startTime + delayUs);
+    EXPECT_LE(dispatchedAt[0], startTime + delayUs + 1000);
+}
+
+TEST_F(DispatchTest, TestCancel)
+{
+    const uint32_t startTime = simulatedTime;
+    dispatchAdd(&entries[0], 1000);
+    dispatchAdd(&entries[1], 1000);
+    dispatchCancel(&entries[0]);
+    EXPECT_FALSE(dispatchIsPending(&entries[0]));
+    EXPECT_EQ(1, dispatchPendingCount());
+
+    // cancelling an entry that is not pending has no effect
+    dispatchCancel(&entries[0]);
+    EXPECT_EQ(1, dispatchPendingCount());
+
+    runUntil(startTime + 2000, 100);
+    EXPECT_EQ(0, dispatchCount[0]);
+    EXPECT_EQ(1, dispatchCount[1]);
+}
+
+TEST_F(DispatchTest, TestCancelFromHandler)
+{
+    // both expire in the same tick, whichever runs first cancels the other
+    const uint32_t startTime = simulatedTime;
+    dispatchAdd(&entries[0], 1000);
+    dispatchAdd(&entries[1], 1000);
+    entryToCancel = &entries[0];
+
+    runUntil(startTime + 2000, 1000);
+    EXPECT_EQ(1, dispatchCount[0] + dispatchCount[1]);
+    EXPECT_EQ(0, dispatchPendingCount());
+}
+
+TEST_F(DispatchTest, TestReplan)
+{
+    const uint32_t startTime = simulatedTime;
+    dispatchAdd(&entries[0], 5000);
+    // adding a pending entry again moves it rather than adding it twice
+    dispatchAdd(&entries[0], 1000);
+    EXPECT_EQ(1, dispatchPendingCount());
+
+    replanDelayUs = 1000;
+    runUntil(startTime + 10500, 100);
+    EXPECT_GE(dispatchCount[0], 9);
+    EXPECT_LE(dispatchCount[0], 10);
+    EXPECT_TRUE(dispatchIsPending(&entries[0]));
+
+    // a handler replanning itself without delay runs again on the next tick, not in the same dispatchProcess() call
+    dispatchCount[0] = 0;
+    replanDelayUs = -1;
+    dispatchAdd(&entries[0], 0);
+    simulatedTime += 200;
+    dispatchProcess(simulatedTime);
+    EXPECT_EQ(1, dispatchCount[0]);
+    EXPECT_TRUE(dispatchIsPending(&entries[0]));
+}
+
+TEST_F(DispatchTest, TestManyEntries)
+{
+    const uint32_t startTime = simulatedTime;
+    static dispatchEntry_t many[200];
+    for (unsigned i = 0; i < ARRAYLEN(many); i++) {
+        many[i].dispatch = testManyDispatch;
+    }
+    for (unsigned i = 0; i < ARRAYLEN(many); i++) {
+        dispatchAdd(&many[i], 100 * (ARRAYLEN(many) - i));
+    }
+    EXPECT_EQ((int)ARRAYLEN(many), dispatchPendingCount());
+    for (unsigned i = 0; i < ARRAYLEN(many); i += 2) {
+        dispatchCancel(&many[i]);
+    }
+    EXPECT_EQ((int)ARRAYLEN(many) / 2, dispatchPendingCount());
+    for (unsigned i = 0; i < ARRAYLEN(many); i++) {
+        EXPECT_EQ(i % 2 != 0, dispatchIsPending(&many[i]));
+    }
+    runUntil(startTime + 100 * (ARRAYLEN(many) + 2), 50);
+    EXPECT_EQ(0, dispatchPendingCount());
+    EXPECT_EQ((int)ARRAYLEN(many) / 2, manyDispatchCount);
+}
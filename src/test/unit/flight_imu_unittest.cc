@@ -43,6 +43,7 @@ extern "C" {
     #include "flight/mixer.h"
     #include "flight/pid.h"
     #include "flight/imu.h"
+    #include "flight/position.h"
 
     #include "io/gps.h"
 
@@ -58,6 +59,7 @@ extern "C" {
     void imuUpdateEulerAngles(void);
 
     extern quaternion q;
+    extern attitudeEulerAngles_t attitude;
     extern float rMat[3][3];
 
     PG_REGISTER(rcControlsConfig_t, rcControlsConfig, PG_RC_CONTROLS_CONFIG, 0);
@@ -196,6 +198,46 @@ TEST(FlightImuTest, TestSmallAngle)
     EXPECT_EQ(0, STATE(SMALL_ANGLE));
 }
 
+static uint32_t testSensorsMask = 0;
+static int32_t baroAltitude = 0;
+
+TEST(FlightImuTest, TestAltitudeEstimatorVario)
+{
+    // given
+    testSensorsMask = SENSOR_ACC | SENSOR_BARO;
+    acc.dev.acc_1G = 512;
+    accVelScale = 9.80665f / acc.dev.acc_1G / 10000.0f;
+
+    // when climbing steadily at 1m/s for 10s at the 100Hz task rate
+    timeUs_t currentTimeUs = 1000000;
+    for (int i = 0; i < 1000; i++) {
+        baroAltitude = i;
+        accSum[Z] = 0;
+        accSumCount = 2;
+        accTimeSum = 10000;
+        currentTimeUs += 10000;
+        calculateEstimatedAltitude(currentTimeUs);
+    }
+
+    // expect
+    EXPECT_NEAR(100, getEstimatedVario(), 5);
+    EXPECT_NEAR(baroAltitude, getEstimatedAltitude(), 10);
+
+    // when braking at 1m/s/s before the baro has caught up
+    for (int i = 0; i < 20; i++) {
+        accSum[Z] = -acc.dev.acc_1G / 10 * 2;
+        accSumCount = 2;
+        accTimeSum = 10000;
+        currentTimeUs += 10000;
+        calculateEstimatedAltitude(currentTimeUs);
+    }
+
+    // expect the vario to follow the accelerometer
+    EXPECT_NEAR(80, getEstimatedVario(), 5);
+
+    testSensorsMask = 0;
+}
+
 // STUBS
 
 extern "C" {
@@ -230,8 +272,7 @@ uint16_t disableFlightMode(flightModeFlags_e mask)
 
 bool sensors(uint32_t mask)
 {
-    UNUSED(mask);
-    return false;
+    return testSensorsMask & mask;
 };
 
 uint32_t millis(void) { return 0; }
@@ -240,7 +281,7 @@ uint32_t micros(void) { return 0; }
 bool compassIsHealthy(void) { return true; }
 bool isBaroCalibrationComplete(void) { return true; }
 void performBaroCalibrationCycle(void) {}
-int32_t baroCalculateAltitude(void) { return 0; }
+int32_t baroCalculateAltitude(void) { return baroAltitude; }
 bool gyroGetAccumulationAverage(float *) { return false; }
 bool accGetAccumulationAverage(float *) { return false; }
 }
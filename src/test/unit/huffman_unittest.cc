@@ -16,6 +16,7 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 
 extern "C" {
     #include "common/huffman.h"
@@ -503,6 +504,60 @@ TEST(HuffmanUnittest, TestHuffmanEncodeStreaming)
     EXPECT_EQ(0xd8, (int)outBuf[4]);
 }
 
+TEST(HuffmanUnittest, TestHuffmanEncodeStreamingOverflow)
+{
+    const uint8_t inBuf[] = {0,1,2,3,4,5,6,7};
+    // 11 101 1001 10001 | 10000 011101 011100 011011
+    // the second chunk does not fit into the remaining byte
+    huffmanState_t state = {
+        .bytesWritten = 0,
+        .outByte = outBuf,
+        .outBufLen = 3,
+        .outBit = 0x80,
+    };
+    *state.outByte = 0;
+    int status = huffmanEncodeBufStreaming(&state, inBuf, 4, huffmanTable);
+    EXPECT_EQ(0, status);
+    status = huffmanEncodeBufStreaming(&state, inBuf + 4, 4, huffmanTable);
+    EXPECT_EQ(-1, status);
+
+    // the state is the one after the first chunk
+    EXPECT_EQ(1, state.bytesWritten);
+    EXPECT_EQ(outBuf + 1, state.outByte);
+    EXPECT_EQ(0x02, state.outBit);
+    EXPECT_EQ(0xec, (int)outBuf[0]);
+    EXPECT_EQ(0xc4, (int)outBuf[1]);
+}
+
+TEST(HuffmanUnittest, TestHuffmanEncodeStreamingRoundTrip)
+{
+    // every byte value, in chunks of odd length so codes of up to 12 bits cross the chunk boundaries
+    uint8_t inBuf[256];
+    for (int ii = 0; ii < 256; ++ii) {
+        inBuf[ii] = ii * 37 + 11;
+    }
+    static uint8_t compressed[512];
+    huffmanState_t state = {
+        .bytesWritten = 0,
+        .outByte = compressed,
+        .outBufLen = sizeof(compressed),
+        .outBit = 0x80,
+    };
+    *state.outByte = 0;
+    for (int pos = 0; pos < 256; pos += 7) {
+        const int status = huffmanEncodeBufStreaming(&state, inBuf + pos, pos + 7 < 256 ? 7 : 256 - pos, huffmanTable);
+        EXPECT_EQ(0, status);
+    }
+    if (state.outBit != 0x80) {
+        ++state.bytesWritten;
+    }
+
+    uint8_t decoded[256];
+    const int len = huffmanDecodeBuf(decoded, sizeof(decoded), compressed, state.bytesWritten, sizeof(inBuf), huffmanTree);
+    EXPECT_EQ(256, len);
+    EXPECT_EQ(0, memcmp(inBuf, decoded, sizeof(inBuf)));
+}
+
 TEST(HuffmanUnittest, TestHuffmanDecode)
 {
     int len;
@@ -29,7 +29,11 @@ extern "C" {
 
     #include "io/serial.h"
 
+    #include "pg/pg.h"
+
     void serialInit(bool softserialEnabled, serialPortIdentifier_e serialPortToDisable);
+    void serialUartBufferSizes(uartBufferSizes_t *sizes, uint32_t arenaSize);
+    void pgResetFn_serialConfig(serialConfig_t *serialConfig);
 }
 
 #include "unittest_macros.h"
@@ -47,6 +51,36 @@ TEST(IoSerialTest, TestFindPortConfig)
     EXPECT_EQ(NULL, portConfig);
 }
 
+TEST(IoSerialTest, UartBufferSizesFollowFunctions)
+{
+    // given
+    pgResetFn_serialConfig(serialConfigMutable());
+    serialFindPortConfiguration(SERIAL_PORT_USART1)->functionMask = FUNCTION_MSP;
+    serialFindPortConfiguration(SERIAL_PORT_USART2)->functionMask = FUNCTION_GPS;
+    serialFindPortConfiguration(SERIAL_PORT_USART3)->functionMask = FUNCTION_BLACKBOX;
+    serialFindPortConfiguration(SERIAL_PORT_UART4)->functionMask = FUNCTION_NONE;
+    serialFindPortConfiguration(SERIAL_PORT_UART5)->functionMask = FUNCTION_RX_SERIAL | FUNCTION_TELEMETRY_SMARTPORT;
+
+    // when
+    uartBufferSizes_t sizes[8];
+    serialUartBufferSizes(sizes, 5 * (128 + 256));
+
+    // then
+    // 1504 bytes are assigned by function, the remaining 416 go to the MSP and blackbox TX buffers
+    EXPECT_EQ(128, sizes[UARTDEV_1].rx);
+    EXPECT_EQ(256 + 208, sizes[UARTDEV_1].tx);
+    EXPECT_EQ(128, sizes[UARTDEV_2].rx);
+    EXPECT_EQ(64, sizes[UARTDEV_2].tx);
+    EXPECT_EQ(32, sizes[UARTDEV_3].rx);
+    EXPECT_EQ(512 + 208, sizes[UARTDEV_3].tx);
+    EXPECT_EQ(64, sizes[UARTDEV_4].rx);
+    EXPECT_EQ(64, sizes[UARTDEV_4].tx);
+    EXPECT_EQ(128, sizes[UARTDEV_5].rx);
+    EXPECT_EQ(128, sizes[UARTDEV_5].tx);
+    EXPECT_EQ(0, sizes[UARTDEV_6].rx);
+    EXPECT_EQ(0, sizes[UARTDEV_6].tx);
+}
+
 
 // STUBS
 extern "C" {
@@ -61,6 +95,7 @@ extern "C" {
     uint32_t serialRxBytesWaiting(const serialPort_t *) { return 0; }
     uint8_t serialRead(serialPort_t *) { return 0; }
     void serialWrite(serialPort_t *, uint8_t) {}
+    void serialWriteBuf(serialPort_t *, const uint8_t *, int) {}
 
     serialPort_t *usbVcpOpen(void) { return NULL; }
 
@@ -68,6 +103,9 @@ extern "C" {
       return NULL;
     }
 
+    uint32_t uartBufferArenaSize(void) { return 0; }
+    bool uartAllocateBuffers(const uartBufferSizes_t *) { return false; }
+
     serialPort_t *openSoftSerial(softSerialPortIndex_e, serialReceiveCallbackPtr, void *, uint32_t, portMode_e, portOptions_e) {
       return NULL;
     }
@@ -168,6 +168,7 @@ TEST(LedStripTest, parseLedStripConfig)
     for (uint8_t index = 0; index < (sizeof(ledStripConfigCommands) / sizeof(ledStripConfigCommands[0])); index++) {
         EXPECT_EQ(true, parseLedStripConfig(index, ledStripConfigCommands[index]));
     }
+    reevaluateLedConfig();
 
     // then
     EXPECT_EQ(30, ledCounts.count);
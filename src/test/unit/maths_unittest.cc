@@ -247,6 +247,30 @@ TEST(MathsUnittest, TestFastTrigonometrySinCos)
     EXPECT_LE(cosError, 3.5e-6);
 }
 
+#ifdef USE_TRIG_TABLE
+TEST(MathsUnittest, TestTrigonometryTable)
+{
+    trigTableInit();
+
+    double sinError = 0;
+    double cosError = 0;
+    for (float x = -10 * M_PI; x < 10 * M_PI; x += M_PI / 300) {
+        sinError = MAX(sinError, fabs(sin_table(x) - sinf(x)));
+        cosError = MAX(cosError, fabs(cos_table(x) - cosf(x)));
+    }
+    printf("sin_table maximum absolute error = %e\n", sinError);
+    printf("cos_table maximum absolute error = %e\n", cosError);
+    EXPECT_LE(sinError, 6e-6);
+    EXPECT_LE(cosError, 7e-6);
+
+    // the quarter turns meet without a step
+    EXPECT_NEAR(1.0f, sin_table(0.5f * M_PIf), 1e-6);
+    EXPECT_NEAR(-1.0f, sin_table(-0.5f * M_PIf), 1e-6);
+    EXPECT_NEAR(0.0f, sin_table(M_PIf), 1e-6);
+    EXPECT_NEAR(-1.0f, cos_table(M_PIf), 1e-6);
+}
+#endif
+
 TEST(MathsUnittest, TestFastTrigonometryATan2)
 {
     double error = 0;
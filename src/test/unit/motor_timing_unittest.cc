@@ -0,0 +1,183 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/motor_timing.h"
+
+    #include "fc/runtime_config.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+// 0.1us a cycle, so the histograms count cycles
+#define TEST_CYCLES_PER_US 10
+
+extern "C" {
+    uint8_t atomic_BASEPRI;
+    uint32_t SystemCoreClock = 10000000;
+    uint8_t armingFlags;
+
+    static uint32_t testCycles;
+    uint32_t profilerCycles(void) { return testCycles; }
+    timeUs_t micros(void) { return testCycles / TEST_CYCLES_PER_US; }
+    timeUs_t gyroGetSampleTimeUs(void) { return 0; }
+}
+
+static void advanceUs(uint32_t us)
+{
+    testCycles += us * TEST_CYCLES_PER_US;
+}
+
+static motorTimingTestStatus_t testStatus(void)
+{
+    motorTimingTestStatus_t status;
+    motorTimingTestGetStatus(&status);
+    return status;
+}
+
+// the percentiles are the upper bounds of the log2 buckets
+static uint32_t bucketBound(uint32_t value)
+{
+    return (1 << (32 - __builtin_clz(value))) - 1;
+}
+
+class MotorTimingTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        armingFlags = 0;
+        testCycles = 1000000;
+        motorTimingInit();
+    }
+};
+
+TEST_F(MotorTimingTest, RunThroughEveryStage)
+{
+    EXPECT_TRUE(motorTimingTestStart(1));
+
+    // the first impulse goes into the next sample, the one after cancels it
+    EXPECT_FLOAT_EQ(100.0f, motorTimingTestImpulse());
+    advanceUs(5);
+    motorTimingTestPidDone();
+    EXPECT_FLOAT_EQ(-100.0f, motorTimingTestImpulse());
+    advanceUs(2);
+    motorTimingTestMixerDone();
+    advanceUs(3);
+    motorTimingOutputStart(2);
+    advanceUs(4);
+    motorTimingOutputComplete();
+    EXPECT_EQ(0, testStatus().completed);
+    advanceUs(1);
+    motorTimingOutputComplete();
+
+    const motorTimingTestStatus_t status = testStatus();
+    EXPECT_EQ(1, status.completed);
+    EXPECT_EQ(0, status.timedOut);
+    EXPECT_EQ(0, status.runsLeft);
+
+    EXPECT_EQ(bucketBound(50), motorTimingTestPercentile(MOTOR_TIMING_TEST_GYRO_TO_PID, 500));
+    EXPECT_EQ(bucketBound(20), motorTimingTestPercentile(MOTOR_TIMING_TEST_PID_TO_MIXER, 500));
+    EXPECT_EQ(bucketBound(30), motorTimingTestPercentile(MOTOR_TIMING_TEST_MIXER_TO_OUTPUT, 500));
+    EXPECT_EQ(bucketBound(50), motorTimingTestPercentile(MOTOR_TIMING_TEST_OUTPUT_DURATION, 500));
+    EXPECT_EQ(bucketBound(150), motorTimingTestPercentile(MOTOR_TIMING_TEST_TOTAL, 500));
+
+    // no runs left
+    advanceUs(20000);
+    EXPECT_FLOAT_EQ(0.0f, motorTimingTestImpulse());
+}
+
+TEST_F(MotorTimingTest, StagesOnlyAdvanceInOrder)
+{
+    EXPECT_TRUE(motorTimingTestStart(1));
+    EXPECT_FLOAT_EQ(100.0f, motorTimingTestImpulse());
+    EXPECT_FLOAT_EQ(-100.0f, motorTimingTestImpulse());
+
+    // a mixer run and a motor DMA before the PID controller has seen the impulse are not its stages
+    advanceUs(1);
+    motorTimingTestMixerDone();
+    motorTimingOutputStart(1);
+    motorTimingOutputComplete();
+    EXPECT_EQ(0, testStatus().completed);
+
+    motorTimingTestPidDone();
+    motorTimingTestMixerDone();
+    motorTimingOutputStart(1);
+    motorTimingOutputComplete();
+    EXPECT_EQ(1, testStatus().completed);
+}
+
+TEST_F(MotorTimingTest, RunWithoutTransferCompleteTimesOut)
+{
+    EXPECT_TRUE(motorTimingTestStart(2));
+    EXPECT_FLOAT_EQ(100.0f, motorTimingTestImpulse());
+    EXPECT_FLOAT_EQ(-100.0f, motorTimingTestImpulse());
+    motorTimingTestPidDone();
+    motorTimingTestMixerDone();
+    motorTimingOutputStart(1);
+
+    // still waiting for the transfer complete
+    advanceUs(10000);
+    EXPECT_FLOAT_EQ(0.0f, motorTimingTestImpulse());
+    EXPECT_EQ(0, testStatus().timedOut);
+
+    advanceUs(1);
+    EXPECT_FLOAT_EQ(0.0f, motorTimingTestImpulse());
+    motorTimingTestStatus_t status = testStatus();
+    EXPECT_EQ(1, status.timedOut);
+    EXPECT_EQ(0, status.completed);
+    EXPECT_EQ(1, status.runsLeft);
+
+    // a late transfer complete does not count for the run that timed out
+    motorTimingOutputComplete();
+    EXPECT_EQ(0, testStatus().completed);
+
+    // the next impulse keeps the interval to the last one
+    advanceUs(9998);
+    EXPECT_FLOAT_EQ(0.0f, motorTimingTestImpulse());
+    advanceUs(1);
+    EXPECT_FLOAT_EQ(100.0f, motorTimingTestImpulse());
+    EXPECT_FLOAT_EQ(-100.0f, motorTimingTestImpulse());
+}
+
+TEST_F(MotorTimingTest, ArmingEndsTest)
+{
+    ENABLE_ARMING_FLAG(ARMED);
+    EXPECT_FALSE(motorTimingTestStart(1));
+
+    DISABLE_ARMING_FLAG(ARMED);
+    EXPECT_TRUE(motorTimingTestStart(5));
+    EXPECT_FLOAT_EQ(100.0f, motorTimingTestImpulse());
+    EXPECT_FLOAT_EQ(-100.0f, motorTimingTestImpulse());
+    motorTimingTestPidDone();
+    motorTimingTestMixerDone();
+    motorTimingOutputStart(1);
+    motorTimingOutputComplete();
+    EXPECT_EQ(4, testStatus().runsLeft);
+
+    ENABLE_ARMING_FLAG(ARMED);
+    advanceUs(20000);
+    EXPECT_FLOAT_EQ(0.0f, motorTimingTestImpulse());
+    EXPECT_EQ(0, testStatus().runsLeft);
+}
@@ -26,6 +26,7 @@ extern "C" {
     #include "build/debug.h"
 
     #include "blackbox/blackbox.h"
+    #include "blackbox/blackbox_io.h"
 
     #include "pg/pg.h"
     #include "pg/pg_ids.h"
@@ -50,9 +51,12 @@ extern "C" {
     #include "io/osd.h"
 
     #include "sensors/battery.h"
+    #include "sensors/sensors.h"
 
     #include "rx/rx.h"
 
+    #include "scheduler/scheduler.h"
+
     void osdRefresh(timeUs_t currentTimeUs);
     void osdFormatTime(char * buff, osd_timer_precision_e precision, timeUs_t time);
     void osdFormatTimer(char *buff, bool showSymbol, int timerIndex);
@@ -60,6 +64,7 @@ extern "C" {
 
     uint16_t rssi;
     attitudeEulerAngles_t attitude;
+    const attitudeEulerAngles_t *getAttitude(void) { return &attitude; }
     pidProfile_t *currentPidProfile;
     int16_t debug[DEBUG16_VALUE_COUNT];
     int16_t rcData[MAX_SUPPORTED_RC_CHANNEL_COUNT];
@@ -639,6 +644,90 @@ TEST(OsdTest, TestElementMahDrawn)
     displayPortTestBufferSubstring(1, 11, "1042%c", SYM_MAH);
 }
 
+/*
+ * Tests that a refresh only writes the elements that changed, and blanks what a moved element left behind.
+ */
+TEST(OsdTest, TestElementRedrawnOnlyWhenChanged)
+{
+    // given
+    osdConfigMutable()->item_pos[OSD_MAH_DRAWN] = OSD_POS(1, 11) | VISIBLE_FLAG;
+    simulationMahDrawn = 246;
+    displayClearScreen(&testDisplayPort);
+    osdRefresh(simulationTime);
+    displayPortTestBufferSubstring(1, 11, " 246%c", SYM_MAH);
+
+    // when
+    testDisplayPortBuffer[11 * UNITTEST_DISPLAYPORT_COLS + 1] = 'X';
+    osdRefresh(simulationTime);
+
+    // then
+    displayPortTestBufferSubstring(1, 11, "X246%c", SYM_MAH);
+
+    // when
+    simulationMahDrawn = 1042;
+    osdRefresh(simulationTime);
+
+    // then
+    displayPortTestBufferSubstring(1, 11, "1042%c", SYM_MAH);
+
+    // when
+    osdConfigMutable()->item_pos[OSD_MAH_DRAWN] = OSD_POS(1, 12) | VISIBLE_FLAG;
+    osdRefresh(simulationTime);
+
+    // then
+    displayPortTestBufferSubstring(1, 11, "     ");
+    displayPortTestBufferSubstring(1, 12, "1042%c", SYM_MAH);
+
+    // when
+    osdConfigMutable()->item_pos[OSD_MAH_DRAWN] = OSD_POS(1, 12);
+    osdRefresh(simulationTime);
+
+    // then
+    displayPortTestBufferSubstring(1, 12, "     ");
+}
+
+/*
+ * Tests that the artificial horizon is only redrawn when the attitude moves it by a step.
+ */
+TEST(OsdTest, TestArtificialHorizonRedrawnOnlyWhenAttitudeChanges)
+{
+    // given
+    sensorsSet(SENSOR_ACC);
+    osdConfigMutable()->ahMaxPitch = 20;
+    osdConfigMutable()->ahMaxRoll = 40;
+    osdConfigMutable()->item_pos[OSD_ARTIFICIAL_HORIZON] = OSD_POS(14, 2) | VISIBLE_FLAG;
+    attitude.values.roll = 0;
+    attitude.values.pitch = 0;
+    displayClearScreen(&testDisplayPort);
+    osdRefresh(simulationTime);
+    displayPortTestBufferSubstring(10, 6, "%c%c%c%c%c%c%c%c%c",
+        SYM_AH_BAR9_0 + 5, SYM_AH_BAR9_0 + 5, SYM_AH_BAR9_0 + 5, SYM_AH_BAR9_0 + 5, SYM_AH_BAR9_0 + 5,
+        SYM_AH_BAR9_0 + 5, SYM_AH_BAR9_0 + 5, SYM_AH_BAR9_0 + 5, SYM_AH_BAR9_0 + 5);
+
+    // when
+    testDisplayPortBuffer[6 * UNITTEST_DISPLAYPORT_COLS + 18] = 'X';
+    attitude.values.roll = 10;
+    osdRefresh(simulationTime);
+
+    // then
+    displayPortTestBufferSubstring(18, 6, "X");
+
+    // when
+    attitude.values.roll = 160;
+    osdRefresh(simulationTime);
+
+    // then
+    displayPortTestBufferSubstring(18, 6, " ");
+    displayPortTestBufferSubstring(18, 5, "%c", SYM_AH_BAR9_0 + 4);
+    displayPortTestBufferSubstring(10, 7, "%c", SYM_AH_BAR9_0 + 6);
+
+    // cleanup
+    osdConfigMutable()->item_pos[OSD_ARTIFICIAL_HORIZON] = OSD_POS(14, 2);
+    attitude.values.roll = 0;
+    osdRefresh(simulationTime);
+    sensorsClear(SENSOR_ACC);
+}
+
 /*
  * Tests the instantaneous electrical power OSD element.
  */
@@ -964,6 +1053,12 @@ extern "C" {
         return false;
     }
 
+    timeDelta_t schedulerGetRemainingTimeUs(void) {
+        return SCHEDULER_TIME_UNLIMITED;
+    }
+
+    void schedulerYield(void) {}
+
     bool isAirmodeActive() {
         return false;
     }
@@ -1000,6 +1095,10 @@ extern "C" {
         return simulationMahDrawn;
     }
 
+    int32_t getBatteryRemainingTime() {
+        return -1;
+    }
+
     int32_t getEstimatedAltitude() {
         return simulationAltitude;
     }
@@ -1012,6 +1111,10 @@ extern "C" {
         return 0;
     }
 
+    void blackboxDeviceGetStats(blackboxDeviceStats_t *stats) {
+        memset(stats, 0, sizeof(*stats));
+    }
+
     bool isSerialTransmitBufferEmpty(const serialPort_t *) {
         return false;
     }
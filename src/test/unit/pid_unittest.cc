@@ -63,11 +63,13 @@ extern "C" {
 
     gyro_t gyro;
     attitudeEulerAngles_t attitude;
+    const attitudeEulerAngles_t *getAttitude(void) { return &attitude; }
 
     float getThrottlePIDAttenuation(void) { return simulatedThrottlePIDAttenuation; }
     float getMotorMixRange(void) { return simulatedMotorMixRange; }
     float getSetpointRate(int axis) { return simulatedSetpointRate[axis]; }
     bool mixerIsOutputSaturated(int, float) { return simulateMixerSaturated; }
+    void mixerInitProfile(const pidProfile_t *) { }
     float getRcDeflectionAbs(int axis) { return ABS(simulatedRcDeflection[axis]); }
     void systemBeep(bool) { }
     bool gyroOverflowDetected(void) { return false; }
@@ -458,6 +460,72 @@ TEST(pidControllerTest, testCrashRecoveryMode) {
     // Add additional verifications
 }
 
+TEST(pidControllerTest, testProcessDenomChange) {
+    resetTest();
+
+    EXPECT_EQ(pidConfig()->pid_process_denom, pidGetProcessDenom());
+    EXPECT_EQ(gyro.targetLooptime * pidConfig()->pid_process_denom, targetPidLooptime);
+
+    pidSetProcessDenom(pidProfile, 4);
+    EXPECT_EQ(4, pidGetProcessDenom());
+    EXPECT_EQ(gyro.targetLooptime * 4, targetPidLooptime);
+
+    // PID loop keeps running at the new rate
+    pidController(pidProfile, &rollAndPitchTrims, currentTestTime());
+    EXPECT_FLOAT_EQ(0, pidData[FD_ROLL].Sum);
+
+    pidSetProcessDenom(pidProfile, MAX_PID_PROCESS_DENOM + 1);
+    EXPECT_EQ(MAX_PID_PROCESS_DENOM, pidGetProcessDenom());
+
+    // pidInit returns to the configured rate
+    pidInit(pidProfile);
+    EXPECT_EQ(pidConfig()->pid_process_denom, pidGetProcessDenom());
+    EXPECT_EQ(gyro.targetLooptime * pidConfig()->pid_process_denom, targetPidLooptime);
+}
+
+TEST(pidControllerTest, testProcessDenomChangeKeepsState) {
+    resetTest();
+    ENABLE_ARMING_FLAG(ARMED);
+    pidStabilisationState(PID_STABILISATION_ON);
+
+    gyro.gyroADCf[FD_ROLL] = 100;
+    pidController(pidProfile, &rollAndPitchTrims, currentTestTime());
+    pidController(pidProfile, &rollAndPitchTrims, currentTestTime());
+    const float rollI = pidData[FD_ROLL].I;
+    EXPECT_NE(0, rollI);
+
+    // changing the rate in flight does not reset the I term
+    pidSetProcessDenom(pidProfile, 2);
+    EXPECT_FLOAT_EQ(rollI, pidData[FD_ROLL].I);
+
+    // and the D term carries on from the last gyro rate, without a kick
+    pidController(pidProfile, &rollAndPitchTrims, currentTestTime());
+    EXPECT_FLOAT_EQ(0, pidData[FD_ROLL].D);
+}
+
+TEST(pidControllerTest, testProfileSwitch) {
+    resetTest();
+    ENABLE_ARMING_FLAG(ARMED);
+    pidStabilisationState(PID_STABILISATION_ON);
+
+    // the other profile doubles the roll P
+    pidProfile_t *otherProfile = pidProfilesMutable(0);
+    *otherProfile = *pidProfile;
+    otherProfile->pid[PID_ROLL].P = pidProfile->pid[PID_ROLL].P * 2;
+
+    gyro.gyroADCf[FD_ROLL] = 100;
+    pidController(pidProfile, &rollAndPitchTrims, currentTestTime());
+    const float rollP = pidData[FD_ROLL].P;
+    ASSERT_NEAR(-128.1, rollP, calculateTolerance(-128.1));
+
+    // the new coefficients are only taken by the next PID loop
+    pidPrepareProfile(otherProfile);
+    EXPECT_FLOAT_EQ(rollP, pidData[FD_ROLL].P);
+
+    pidController(otherProfile, &rollAndPitchTrims, currentTestTime());
+    EXPECT_FLOAT_EQ(2 * rollP, pidData[FD_ROLL].P);
+}
+
 TEST(pidControllerTest, pidSetpointTransition) {
 // TODO
 }
@@ -27,10 +27,12 @@
 #define U_ID_2 2
 
 #define NOINLINE
+#define ALWAYS_INLINE inline
 #define FAST_CODE
 #define FAST_CODE_NOINLINE
 #define FAST_RAM_ZERO_INIT
 #define FAST_RAM
+#define DMA_RAM
 
 #define MAX_PROFILE_COUNT 3
 #define USE_MAG
@@ -104,6 +106,8 @@ typedef struct
     void* test;
 } ADC_TypeDef;
 
+extern uint32_t SystemCoreClock;
+
 #define WS2811_DMA_TC_FLAG (void *)1
 #define WS2811_DMA_HANDLER_IDENTIFER 0
 #define NVIC_PriorityGroup_2 0x500
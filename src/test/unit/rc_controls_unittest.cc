@@ -141,6 +141,7 @@ TEST_F(RcControlsModesTest, updateActivatedModesUsingValidAuxConfigurationAndRXV
     modeActivationConditionsMutable(6)->auxChannelIndex = AUX7 - NON_AUX_CHANNEL_COUNT;
     modeActivationConditionsMutable(6)->range.startStep = CHANNEL_VALUE_TO_STEP(925);
     modeActivationConditionsMutable(6)->range.endStep = CHANNEL_VALUE_TO_STEP(950);
+    analyzeModeActivationConditions();
 
     EXPECT_EQ(1, modeActivationConditions(6)->range.startStep);
     EXPECT_EQ(2, modeActivationConditions(6)->range.endStep);
@@ -697,7 +698,7 @@ extern "C" {
 void saveConfigAndNotify(void) {}
 void initRcProcessing(void) {}
 void changePidProfile(uint8_t) {}
-void pidInitConfig(const pidProfile_t *) {}
+void pidPrepareProfile(const pidProfile_t *) {}
 void accSetCalibrationCycles(uint16_t) {}
 void gyroStartCalibration(bool isFirstArmingCalibration)
 {
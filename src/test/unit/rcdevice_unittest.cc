@@ -271,6 +271,7 @@ TEST(RCDeviceTest, TestWifiModeChangeWithDeviceUnready)
     modeActivationConditionsMutable(2)->modeId = BOXCAMERA3;
     modeActivationConditionsMutable(2)->range.startStep = CHANNEL_VALUE_TO_STEP(1300);
     modeActivationConditionsMutable(2)->range.endStep = CHANNEL_VALUE_TO_STEP(1600);
+    analyzeModeActivationConditions();
 
     // make the binded mode inactive
     rcData[modeActivationConditions(0)->auxChannelIndex + NON_AUX_CHANNEL_COUNT] = 1800;
@@ -331,6 +332,7 @@ TEST(RCDeviceTest, TestWifiModeChangeWithDeviceReady)
     modeActivationConditionsMutable(2)->modeId = BOXCAMERA3;
     modeActivationConditionsMutable(2)->range.startStep = CHANNEL_VALUE_TO_STEP(1900);
     modeActivationConditionsMutable(2)->range.endStep = CHANNEL_VALUE_TO_STEP(2100);
+    analyzeModeActivationConditions();
 
     rcData[modeActivationConditions(0)->auxChannelIndex + NON_AUX_CHANNEL_COUNT] = 1700;
     rcData[modeActivationConditions(1)->auxChannelIndex + NON_AUX_CHANNEL_COUNT] = 2000;
@@ -389,6 +391,7 @@ TEST(RCDeviceTest, TestWifiModeChangeCombine)
     modeActivationConditionsMutable(2)->modeId = BOXCAMERA3;
     modeActivationConditionsMutable(2)->range.startStep = CHANNEL_VALUE_TO_STEP(1900);
     modeActivationConditionsMutable(2)->range.endStep = CHANNEL_VALUE_TO_STEP(2100);
+    analyzeModeActivationConditions();
 
     // // make the binded mode inactive
     rcData[modeActivationConditions(0)->auxChannelIndex + NON_AUX_CHANNEL_COUNT] = 1700;
@@ -628,6 +631,47 @@ TEST(RCDeviceTest, Test5KeyOSDCableSimulationProtocol)
     clearResponseBuff();
 }
 
+static int pipelinedResponses;
+
+static void countPipelinedResponse(rcdeviceResponseParseContext_t *ctx)
+{
+    if (ctx->result == RCDEVICE_RESP_SUCCESS) {
+        pipelinedResponses++;
+    }
+}
+
+TEST(RCDeviceTest, TestPipelinedResponses)
+{
+    watingResponseQueue.headPos = 0;
+    watingResponseQueue.tailPos = 0;
+    watingResponseQueue.itemCount = 0;
+    memset(&testData, 0, sizeof(testData));
+    testData.isRunCamSplitOpenPortSupported = true;
+    testData.isRunCamSplitPortConfigurated = true;
+    testData.isAllowBufferReadWrite = true;
+    uint8_t responseData[] = { 0xCC, 0x01, 0x37, 0x00, 0xBD };
+    addResponseData(responseData, sizeof(responseData), true);
+    rcdeviceInit();
+    rcdeviceReceive(millis());
+    testData.millis += minTimeout;
+    EXPECT_EQ(true, camDevice->isReady);
+    EXPECT_EQ(0, runcamDeviceWaitingResponses());
+    clearResponseBuff();
+
+    // both responses are in the rx buffer behind a stray byte
+    uint8_t responses[] = { 0x55, 0xCC, 0xA5, 0xCC, 0xA5 };
+    addResponseData(responses, sizeof(responses), true);
+    pipelinedResponses = 0;
+    runcamDeviceSimulate5KeyOSDCableButtonPress(camDevice, RCDEVICE_PROTOCOL_5KEY_SIMULATION_SET, countPipelinedResponse);
+    runcamDeviceSimulate5KeyOSDCableButtonRelease(camDevice, countPipelinedResponse);
+    EXPECT_EQ(2, runcamDeviceWaitingResponses());
+
+    rcdeviceReceive(millis());
+    EXPECT_EQ(2, pipelinedResponses);
+    EXPECT_EQ(0, runcamDeviceWaitingResponses());
+    clearResponseBuff();
+}
+
 TEST(RCDeviceTest, Test5KeyOSDCableSimulationWithout5KeyFeatureSupport)
 {
     // test simulation without device init
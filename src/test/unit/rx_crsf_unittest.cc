@@ -51,6 +51,7 @@ extern "C" {
     extern uint32_t crsfChannelData[CRSF_MAX_CHANNEL];
 
     uint32_t dummyTimeUs;
+    extern uint16_t lastRssiValue;
 
     PG_REGISTER(rxConfig_t, rxConfig, PG_RX_CONFIG, 0);
 }
@@ -277,10 +278,45 @@ TEST(CrossFireTest, TestCrsfDataReceive)
     EXPECT_EQ(crc, crsfFrame.frame.payload[CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE]);
 }
 
+TEST(CrossFireTest, TestCrsfLinkStatistics)
+{
+    crsfLinkStatistics_t linkStatistics;
+    EXPECT_FALSE(crsfGetLinkStatistics(&linkStatistics, 0));
+
+    uint8_t frame[CRSF_FRAME_LINK_STATISTICS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_NON_PAYLOAD] = {
+        CRSF_ADDRESS_FLIGHT_CONTROLLER, CRSF_FRAME_LINK_STATISTICS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC, CRSF_FRAMETYPE_LINK_STATISTICS,
+        60, 62, 0, 8, 0, 4, 2, 70, 100, 10, 0
+    };
+    for (int lq = 50; lq <= 100; lq += 50) {
+        frame[5] = lq;
+        frame[sizeof(frame) - 1] = crc8_dvb_s2_update(0, &frame[2], sizeof(frame) - 3);
+        dummyTimeUs += 10000;
+        for (unsigned ii = 0; ii < sizeof(frame); ++ii) {
+            crsfDataReceive(frame[ii]);
+        }
+    }
+
+    EXPECT_TRUE(crsfGetLinkStatistics(&linkStatistics, 0));
+    EXPECT_EQ(60, linkStatistics.uplinkRssi1);
+    EXPECT_EQ(100, linkStatistics.uplinkLinkQuality);
+    EXPECT_EQ(8, linkStatistics.uplinkSnr);
+    EXPECT_TRUE(crsfGetLinkStatistics(&linkStatistics, 1));
+    EXPECT_EQ(50, linkStatistics.uplinkLinkQuality);
+    EXPECT_FALSE(crsfGetLinkStatistics(&linkStatistics, 2));
+
+    // the RX task turns the latest link quality into the RSSI
+    crsfFrameStatus();
+    EXPECT_EQ(RSSI_MAX_VALUE, lastRssiValue);
+}
+
 // STUBS
 
 extern "C" {
 
+uint16_t lastRssiValue;
+rssiSource_e rssiSource;
+void setRssi(uint16_t rssiValue, rssiSource_e) { lastRssiValue = rssiValue; }
+
 int16_t debug[DEBUG16_VALUE_COUNT];
 uint32_t micros(void) {return dummyTimeUs;}
 serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, void *, uint32_t, portMode_e, portOptions_e) {return NULL;}
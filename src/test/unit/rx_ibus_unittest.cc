@@ -79,11 +79,12 @@ typedef struct serialPortStub_s {
 
 static serialPort_t serialTestInstance;
 static serialPortConfig_t serialTestInstanceConfig = {
-    .identifier = SERIAL_PORT_DUMMY_IDENTIFIER,
-    .functionMask = 0
+    .functionMask = 0,
+    .identifier = SERIAL_PORT_DUMMY_IDENTIFIER
 };
 
 static serialReceiveCallbackPtr stub_serialRxCallback;
+static serialReceiveFrameCallbackPtr stub_serialRxFrameCallback;
 static serialPortConfig_t *findSerialPortConfig_stub_retval;
 static bool openSerial_called = false;
 static serialPortStub_t serialWriteStub;
@@ -130,6 +131,12 @@ serialPort_t *openSerialPort(
     return &serialTestInstance;
 }
 
+void serialSetRxFrameCallback(serialPort_t *instance, serialReceiveFrameCallbackPtr rxFrameCallback)
+{
+    EXPECT_EQ(instance, &serialTestInstance);
+    stub_serialRxFrameCallback = rxFrameCallback;
+}
+
 void serialWrite(serialPort_t *instance, uint8_t ch)
 {
     EXPECT_EQ(instance, &serialTestInstance);
@@ -144,6 +151,7 @@ void serialTestResetPort()
 {
     openSerial_called = false;
     stub_serialRxCallback = NULL;
+    stub_serialRxFrameCallback = NULL;
     portIsShared = false;
     serialExpectedMode = MODE_RX;
     serialExpectedOptions = SERIAL_UNIDIR;
@@ -304,6 +312,53 @@ TEST_F(IbusRxProtocollUnitTest, Test_IA6B_OnePacketReceived)
 }
 
 
+TEST_F(IbusRxProtocollUnitTest, Test_IA6B_OnePacketReceivedAsFrame)
+{
+    uint8_t packet[] = {0x20, 0x00, //length and reserved (unknown) bits
+                        0x00, 0x00, 0x01, 0x00, 0x02, 0x00, 0x03, 0x00, 0x04, 0x00, //channel 1..5
+                        0x05, 0x00, 0x06, 0x00, 0x07, 0x00, 0x08, 0x00, 0x09, 0x00, //channel 6..10
+                        0x0a, 0x00, 0x0b, 0x00, 0x0c, 0x00, 0x0d, 0x00,             //channel 11..14
+                        0x84, 0xff}; //checksum
+
+    ASSERT_FALSE(NULL == stub_serialRxFrameCallback);
+
+    //DMA delivers the frame in two runs, the IDLE line ends the frame
+    stub_serialRxFrameCallback(packet, 10, false, NULL);
+    EXPECT_EQ(RX_FRAME_PENDING, rxRuntimeConfig.rcFrameStatusFn(&rxRuntimeConfig));
+    stub_serialRxFrameCallback(&packet[10], sizeof(packet) - 10, true, NULL);
+
+    //report frame complete once
+    EXPECT_EQ(RX_FRAME_COMPLETE, rxRuntimeConfig.rcFrameStatusFn(&rxRuntimeConfig));
+    EXPECT_EQ(RX_FRAME_PENDING, rxRuntimeConfig.rcFrameStatusFn(&rxRuntimeConfig));
+
+    //check that channel values have been updated
+    for (int i=0; i<14; i++) {
+        ASSERT_EQ(i, rxRuntimeConfig.rcReadRawFn(&rxRuntimeConfig, i));
+    }
+}
+
+
+TEST_F(IbusRxProtocollUnitTest, Test_IA6B_OverlongFrameDropped)
+{
+    uint8_t packet[] = {0x20, 0x00, //length and reserved (unknown) bits
+                        0x00, 0x00, 0x01, 0x00, 0x02, 0x00, 0x03, 0x00, 0x04, 0x00, //channel 1..5
+                        0x05, 0x00, 0x06, 0x00, 0x07, 0x00, 0x08, 0x00, 0x09, 0x00, //channel 6..10
+                        0x0a, 0x00, 0x0b, 0x00, 0x0c, 0x00, 0x0d, 0x00,             //channel 11..14
+                        0x84, 0xff, //checksum
+                        0x20}; //start of a frame that ran into this one
+
+    ASSERT_FALSE(NULL == stub_serialRxFrameCallback);
+
+    //a frame that does not end on the IDLE line is dropped as a whole
+    stub_serialRxFrameCallback(packet, sizeof(packet), true, NULL);
+    EXPECT_EQ(RX_FRAME_PENDING, rxRuntimeConfig.rcFrameStatusFn(&rxRuntimeConfig));
+
+    //and the next frame is received again
+    stub_serialRxFrameCallback(packet, sizeof(packet) - 1, true, NULL);
+    EXPECT_EQ(RX_FRAME_COMPLETE, rxRuntimeConfig.rcFrameStatusFn(&rxRuntimeConfig));
+}
+
+
 TEST_F(IbusRxProtocollUnitTest, Test_IA6B_OnePacketReceivedWithBadCrc)
 {
     uint8_t packet[] = {0x20, 0x00, //length and reserved (unknown) bits
@@ -318,7 +373,8 @@ TEST_F(IbusRxProtocollUnitTest, Test_IA6B_OnePacketReceivedWithBadCrc)
         stub_serialRxCallback(packet[i], NULL);
     }
 
-    //no frame complete
+    //no frame complete, the checksum error is reported once
+    EXPECT_EQ(RX_FRAME_CRC_ERROR, rxRuntimeConfig.rcFrameStatusFn(&rxRuntimeConfig));
     EXPECT_EQ(RX_FRAME_PENDING, rxRuntimeConfig.rcFrameStatusFn(&rxRuntimeConfig));
 
     //check that channel values have not been updated
@@ -400,7 +456,8 @@ TEST_F(IbusRxProtocollUnitTest, Test_IA6_OnePacketReceivedBadCrc)
         stub_serialRxCallback(packet[i], NULL);
     }
 
-    //no frame complete
+    //no frame complete, the checksum error is reported once
+    EXPECT_EQ(RX_FRAME_CRC_ERROR, rxRuntimeConfig.rcFrameStatusFn(&rxRuntimeConfig));
     EXPECT_EQ(RX_FRAME_PENDING, rxRuntimeConfig.rcFrameStatusFn(&rxRuntimeConfig));
 
     //check that channel values have not been updated
@@ -41,6 +41,8 @@ extern "C" {
 
     bool isPulseValid(uint16_t pulseDuration);
 
+    extern rxRuntimeConfig_t rxRuntimeConfig;
+
     PG_RESET_TEMPLATE(featureConfig_t, featureConfig,
         .enabledFeatures = 0
     );
@@ -193,6 +195,150 @@ TEST(RxTest, TestInvalidFlightChannels)
 }
 #endif
 
+static uint8_t testFrameStatus;
+
+static uint8_t testFrameStatusFn(rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    UNUSED(rxRuntimeConfig);
+    return testFrameStatus;
+}
+
+#ifdef USE_RX_LINK_STATS
+
+TEST(RxTest, TestLinkStats)
+{
+    // given
+    memset(&testData, 0, sizeof(testData));
+    rxInit();
+    rxRuntimeConfig.rcFrameStatusFn = testFrameStatusFn;
+    rxRuntimeConfig.rcFrameCompleteUsFn = NULL;
+
+    timeUs_t currentTimeUs = 1000;
+    rxLinkStats_t linkStats;
+
+    // when no period has completed
+    testFrameStatus = RX_FRAME_PENDING;
+    rxUpdateCheck(currentTimeUs, 0);
+
+    // then
+    EXPECT_FALSE(rxGetLinkStats(&linkStats, 0));
+
+    // when 99 frames arrive 10ms apart, two of them dropped, with a CRC error in between
+    for (int i = 0; i < 99; i++) {
+        currentTimeUs += 10000;
+        if (i == 60 || i == 61) {
+            testFrameStatus = RX_FRAME_COMPLETE | RX_FRAME_DROPPED;
+        } else {
+            testFrameStatus = RX_FRAME_COMPLETE;
+        }
+        rxUpdateCheck(currentTimeUs, 0);
+        if (i == 50) {
+            testFrameStatus = RX_FRAME_CRC_ERROR;
+            rxUpdateCheck(currentTimeUs + 5000, 0);
+        }
+    }
+    // and the period ends
+    currentTimeUs += 10000;
+    testFrameStatus = RX_FRAME_PENDING;
+    rxUpdateCheck(currentTimeUs, 0);
+
+    // then
+    ASSERT_TRUE(rxGetLinkStats(&linkStats, 0));
+    EXPECT_EQ(99, linkStats.frames);
+    EXPECT_EQ(2, linkStats.droppedFrames);
+    EXPECT_EQ(0, linkStats.failsafeFrames);
+    EXPECT_EQ(1, linkStats.crcErrors);
+    EXPECT_EQ(10000, linkStats.intervalMinUs);
+    EXPECT_EQ(10000, linkStats.intervalMaxUs);
+    EXPECT_EQ(10000, linkStats.intervalAvgUs);
+    EXPECT_FALSE(rxGetLinkStats(&linkStats, 1));
+
+    // when the link is lost for a period
+    currentTimeUs += RX_LINK_STATS_PERIOD_US;
+    rxUpdateCheck(currentTimeUs, 0);
+
+    // then the previous period moves down the history
+    ASSERT_TRUE(rxGetLinkStats(&linkStats, 0));
+    EXPECT_EQ(0, linkStats.frames);
+    EXPECT_EQ(0, linkStats.intervalAvgUs);
+    EXPECT_EQ(UINT16_MAX, linkStats.intervalMaxUs);
+    ASSERT_TRUE(rxGetLinkStats(&linkStats, 1));
+    EXPECT_EQ(99, linkStats.frames);
+
+    // when frames come back after two more seconds without the task running
+    currentTimeUs += 2 * RX_LINK_STATS_PERIOD_US + 10000;
+    testFrameStatus = RX_FRAME_COMPLETE;
+    rxUpdateCheck(currentTimeUs, 0);
+    currentTimeUs += 10000;
+    rxUpdateCheck(currentTimeUs, 0);
+    currentTimeUs += RX_LINK_STATS_PERIOD_US - 20000;
+    testFrameStatus = RX_FRAME_PENDING;
+    rxUpdateCheck(currentTimeUs, 0);
+
+    // then each missed second is stored as its own empty period
+    ASSERT_TRUE(rxGetLinkStats(&linkStats, 0));
+    EXPECT_EQ(2, linkStats.frames);
+    EXPECT_EQ(10000, linkStats.intervalMinUs);
+    EXPECT_EQ(UINT16_MAX, linkStats.intervalMaxUs);
+    ASSERT_TRUE(rxGetLinkStats(&linkStats, 1));
+    EXPECT_EQ(0, linkStats.frames);
+    ASSERT_TRUE(rxGetLinkStats(&linkStats, 2));
+    EXPECT_EQ(0, linkStats.frames);
+    ASSERT_TRUE(rxGetLinkStats(&linkStats, 3));
+    EXPECT_EQ(0, linkStats.frames);
+    ASSERT_TRUE(rxGetLinkStats(&linkStats, 4));
+    EXPECT_EQ(99, linkStats.frames);
+}
+#endif
+
+#ifdef USE_RX_LATE_FRAME_DETECTION
+static timeUs_t receiveFrames(timeUs_t currentTimeUs, timeDelta_t intervalUs, int count)
+{
+    for (int i = 0; i < count; i++) {
+        currentTimeUs += intervalUs;
+        testFrameStatus = RX_FRAME_COMPLETE;
+        rxUpdateCheck(currentTimeUs, 0);
+    }
+    testFrameStatus = RX_FRAME_PENDING;
+    return currentTimeUs;
+}
+
+TEST(RxTest, TestLateFrameDetection)
+{
+    // given
+    memset(&testData, 0, sizeof(testData));
+    rxInit();
+    rxRuntimeConfig.rcFrameStatusFn = testFrameStatusFn;
+    rxRuntimeConfig.rcFrameCompleteUsFn = NULL;
+    rxRuntimeConfig.rcFrameTimeUsFn = NULL;
+
+    // when a 150Hz link has run for a while
+    timeUs_t currentTimeUs = receiveFrames(10000000, 6667, 100);
+
+    // then the signal is lost after a few missed frames
+    rxUpdateCheck(currentTimeUs + 15000, 0);
+    EXPECT_TRUE(rxIsReceivingSignal());
+    rxUpdateCheck(currentTimeUs + 30000, 0);
+    EXPECT_FALSE(rxIsReceivingSignal());
+
+    // when the frame rate drops to 55Hz
+    currentTimeUs = receiveFrames(currentTimeUs + 30000, 18000, 2);
+
+    // then the longer interval is tolerated straight away
+    rxUpdateCheck(currentTimeUs + 50000, 0);
+    EXPECT_TRUE(rxIsReceivingSignal());
+
+    // when the link is slow
+    currentTimeUs = receiveFrames(currentTimeUs + 50000, 30000, 100);
+
+    // then the signal is not held longer than the fixed delay
+    rxUpdateCheck(currentTimeUs + 90000, 0);
+    EXPECT_TRUE(rxIsReceivingSignal());
+    rxUpdateCheck(currentTimeUs + 101000, 0);
+    EXPECT_FALSE(rxIsReceivingSignal());
+}
+#endif
+
 // STUBS
 
 extern "C" {
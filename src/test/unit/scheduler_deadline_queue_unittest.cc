@@ -0,0 +1,345 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "build/debug.h"
+    #include "scheduler/scheduler.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+const int TEST_PID_LOOP_TIME = 650;
+const int TEST_UPDATE_ACCEL_TIME = 192;
+const int TEST_HANDLE_SERIAL_TIME = 30;
+const int TEST_UPDATE_BATTERY_TIME = 1;
+const int TEST_UPDATE_RX_CHECK_TIME = 34;
+const int TEST_UPDATE_RX_MAIN_TIME = 1;
+const int TEST_IMU_UPDATE_TIME = 5;
+const int TEST_DISPATCH_TIME = 1;
+
+#define TASK_PERIOD_HZ(hz) (1000000 / (hz))
+
+extern "C" {
+    cfTask_t * unittest_scheduler_selectedTask;
+    uint8_t unittest_scheduler_selectedTaskDynPrio;
+    uint16_t unittest_scheduler_waitingTasks;
+
+    // set up micros() to simulate time
+    uint32_t simulatedTime = 0;
+    uint32_t micros(void) { return simulatedTime; }
+
+    int16_t debug[DEBUG16_VALUE_COUNT];
+    uint8_t debugMode;
+
+    // sleeps until an interrupt that comes after the simulated time
+    uint32_t idleSleepTime = 0;
+    int idleSleepCount = 0;
+    void systemIdleSleep(void) { simulatedTime += idleSleepTime; idleSleepCount++; }
+
+    // set up tasks to take a simulated representative time to execute
+    void taskMain(timeUs_t) {}
+    void taskMainPidLoop(timeUs_t) { simulatedTime += TEST_PID_LOOP_TIME; }
+    void taskUpdateAccelerometer(timeUs_t) { simulatedTime += TEST_UPDATE_ACCEL_TIME; }
+    void taskHandleSerial(timeUs_t) { simulatedTime += TEST_HANDLE_SERIAL_TIME; }
+    void taskUpdateBatteryVoltage(timeUs_t) { simulatedTime += TEST_UPDATE_BATTERY_TIME; }
+    bool rxUpdateCheck(timeUs_t, timeDelta_t) { simulatedTime += TEST_UPDATE_RX_CHECK_TIME; return false; }
+    void taskUpdateRxMain(timeUs_t) { simulatedTime += TEST_UPDATE_RX_MAIN_TIME; }
+    void imuUpdateAttitude(timeUs_t) { simulatedTime += TEST_IMU_UPDATE_TIME; }
+    void dispatchProcess(timeUs_t) { simulatedTime += TEST_DISPATCH_TIME; }
+
+    extern int taskQueueSize;
+    extern taskHeap_t taskHeap[];
+    extern cfTask_t *eventTaskQueue[];
+    extern int eventTaskQueueSize;
+
+    extern void queueClear(void);
+
+    // initialised in task id order, so that this also builds with compilers lacking array designators in C++
+    cfTask_t cfTasks[TASK_COUNT] = {
+        { "SYSTEM", NULL, NULL, taskSystemLoad, TASK_PERIOD_HZ(10), TASK_PRIORITY_MEDIUM_HIGH },            // TASK_SYSTEM
+        { "SYSTEM", "UPDATE", NULL, taskMain, TASK_PERIOD_HZ(1000), TASK_PRIORITY_MEDIUM_HIGH },            // TASK_MAIN
+        { "PID", "GYRO", NULL, taskMainPidLoop, 1000, TASK_PRIORITY_REALTIME },                             // TASK_GYROPID
+        { "ACCEL", NULL, NULL, taskUpdateAccelerometer, 10000, TASK_PRIORITY_MEDIUM },                      // TASK_ACCEL
+        { "ATTITUDE", NULL, NULL, imuUpdateAttitude, TASK_PERIOD_HZ(100), TASK_PRIORITY_MEDIUM },           // TASK_ATTITUDE
+        { "RX", NULL, rxUpdateCheck, taskUpdateRxMain, TASK_PERIOD_HZ(50), TASK_PRIORITY_HIGH },            // TASK_RX
+        { "SERIAL", NULL, NULL, taskHandleSerial, TASK_PERIOD_HZ(100), TASK_PRIORITY_LOW },                 // TASK_SERIAL
+        { "DISPATCH", NULL, NULL, dispatchProcess, TASK_PERIOD_HZ(1000), TASK_PRIORITY_HIGH },              // TASK_DISPATCH
+        { "BATTERY_VOLTAGE", NULL, NULL, taskUpdateBatteryVoltage, TASK_PERIOD_HZ(50), TASK_PRIORITY_MEDIUM }, // TASK_BATTERY_VOLTAGE
+    };
+}
+
+static void disableAllTasks(void)
+{
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+    }
+}
+
+static void expectHeapOrdered(const taskHeap_t *heap)
+{
+    for (int ii = 1; ii < heap->count; ++ii) {
+        const cfTask_t *parent = heap->task[(ii - 1) / 2];
+        const cfTask_t *child = heap->task[ii];
+        EXPECT_LE(parent->lastExecutedAt + parent->desiredPeriod, child->lastExecutedAt + child->desiredPeriod);
+    }
+    for (int ii = 0; ii < heap->count; ++ii) {
+        EXPECT_EQ(ii, heap->task[ii]->heapIndex);
+    }
+}
+
+TEST(SchedulerDeadlineQueueUnittest, TestQueueAddKeepsTasksPerPriority)
+{
+    queueClear();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        cfTasks[taskId].lastExecutedAt = 0;
+    }
+
+    setTaskEnabled(TASK_SYSTEM, true);
+    setTaskEnabled(TASK_GYROPID, true);
+    setTaskEnabled(TASK_RX, true);
+    setTaskEnabled(TASK_SERIAL, true);
+    setTaskEnabled(TASK_ACCEL, true);
+    setTaskEnabled(TASK_BATTERY_VOLTAGE, true);
+    EXPECT_EQ(6, taskQueueSize);
+
+    // event driven tasks are not kept in the heaps
+    EXPECT_EQ(1, eventTaskQueueSize);
+    EXPECT_EQ(&cfTasks[TASK_RX], eventTaskQueue[0]);
+    EXPECT_EQ(0, taskHeap[TASK_PRIORITY_HIGH].count);
+
+    EXPECT_EQ(1, taskHeap[TASK_PRIORITY_REALTIME].count);
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], taskHeap[TASK_PRIORITY_REALTIME].task[0]);
+    EXPECT_EQ(1, taskHeap[TASK_PRIORITY_MEDIUM_HIGH].count);
+    EXPECT_EQ(1, taskHeap[TASK_PRIORITY_LOW].count);
+
+    // TASK_ACCEL (100Hz in this test) is due before TASK_BATTERY_VOLTAGE (50Hz)
+    EXPECT_EQ(2, taskHeap[TASK_PRIORITY_MEDIUM].count);
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], taskHeap[TASK_PRIORITY_MEDIUM].task[0]);
+
+    setTaskEnabled(TASK_ACCEL, false);
+    EXPECT_EQ(1, taskHeap[TASK_PRIORITY_MEDIUM].count);
+    EXPECT_EQ(&cfTasks[TASK_BATTERY_VOLTAGE], taskHeap[TASK_PRIORITY_MEDIUM].task[0]);
+
+    setTaskEnabled(TASK_RX, false);
+    EXPECT_EQ(0, eventTaskQueueSize);
+}
+
+TEST(SchedulerDeadlineQueueUnittest, TestRescheduleReordersHeap)
+{
+    queueClear();
+    cfTasks[TASK_ACCEL].lastExecutedAt = 0;
+    cfTasks[TASK_ATTITUDE].lastExecutedAt = 0;
+    cfTasks[TASK_BATTERY_VOLTAGE].lastExecutedAt = 0;
+    setTaskEnabled(TASK_ACCEL, true);
+    setTaskEnabled(TASK_ATTITUDE, true);
+    setTaskEnabled(TASK_BATTERY_VOLTAGE, true);
+    expectHeapOrdered(&taskHeap[TASK_PRIORITY_MEDIUM]);
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], taskHeap[TASK_PRIORITY_MEDIUM].task[0]);
+
+    rescheduleTask(TASK_ATTITUDE, 500);
+    EXPECT_EQ(&cfTasks[TASK_ATTITUDE], taskHeap[TASK_PRIORITY_MEDIUM].task[0]);
+    expectHeapOrdered(&taskHeap[TASK_PRIORITY_MEDIUM]);
+
+    rescheduleTask(TASK_ATTITUDE, TASK_PERIOD_HZ(25));
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], taskHeap[TASK_PRIORITY_MEDIUM].task[0]);
+    expectHeapOrdered(&taskHeap[TASK_PRIORITY_MEDIUM]);
+
+    rescheduleTask(TASK_ATTITUDE, TASK_PERIOD_HZ(100));
+}
+
+TEST(SchedulerDeadlineQueueUnittest, TestScheduleEmptyQueue)
+{
+    queueClear();
+    simulatedTime = 4000;
+    scheduler();
+    EXPECT_EQ(NULL, unittest_scheduler_selectedTask);
+}
+
+TEST(SchedulerDeadlineQueueUnittest, TestTwoTasks)
+{
+    schedulerInit();
+    disableAllTasks();
+
+    // set it up so that TASK_ACCEL ran just before TASK_GYROPID
+    static const uint32_t startTime = 4000;
+    simulatedTime = startTime;
+    cfTasks[TASK_GYROPID].lastExecutedAt = simulatedTime;
+    cfTasks[TASK_ACCEL].lastExecutedAt = cfTasks[TASK_GYROPID].lastExecutedAt - TEST_UPDATE_ACCEL_TIME;
+    setTaskEnabled(TASK_ACCEL, true);
+    setTaskEnabled(TASK_GYROPID, true);
+
+    scheduler();
+    EXPECT_EQ(static_cast<cfTask_t*>(0), unittest_scheduler_selectedTask);
+
+    simulatedTime += 500;
+    scheduler();
+    EXPECT_EQ(static_cast<cfTask_t*>(0), unittest_scheduler_selectedTask);
+    EXPECT_EQ(0, unittest_scheduler_waitingTasks);
+
+    // TASK_GYROPID desiredPeriod has elapsed
+    simulatedTime += 500;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], unittest_scheduler_selectedTask);
+    EXPECT_EQ(1, unittest_scheduler_waitingTasks);
+    EXPECT_EQ(5000 + TEST_PID_LOOP_TIME, simulatedTime);
+    EXPECT_EQ(TEST_PID_LOOP_TIME, cfTasks[TASK_GYROPID].totalExecutionTime);
+
+    simulatedTime += 1000 - TEST_PID_LOOP_TIME;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], unittest_scheduler_selectedTask);
+
+    scheduler();
+    EXPECT_EQ(static_cast<cfTask_t*>(0), unittest_scheduler_selectedTask);
+    EXPECT_EQ(0, unittest_scheduler_waitingTasks);
+
+    // TASK_GYROPID and TASK_ACCEL desiredPeriods have elapsed, TASK_GYROPID should run first
+    simulatedTime = startTime + 10500;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], unittest_scheduler_selectedTask);
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+}
+
+TEST(SchedulerDeadlineQueueUnittest, TestOverdueTasksOfSamePriorityRunInDeadlineOrder)
+{
+    schedulerInit();
+    disableAllTasks();
+
+    simulatedTime = 100000;
+    cfTasks[TASK_ACCEL].lastExecutedAt = simulatedTime - 15000;          // due 5000us ago
+    cfTasks[TASK_ATTITUDE].lastExecutedAt = simulatedTime - 12000;       // due 2000us ago
+    cfTasks[TASK_BATTERY_VOLTAGE].lastExecutedAt = simulatedTime - 30000; // due 10000us ago
+    setTaskEnabled(TASK_ACCEL, true);
+    setTaskEnabled(TASK_ATTITUDE, true);
+    setTaskEnabled(TASK_BATTERY_VOLTAGE, true);
+
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_BATTERY_VOLTAGE], unittest_scheduler_selectedTask);
+    expectHeapOrdered(&taskHeap[TASK_PRIORITY_MEDIUM]);
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+    expectHeapOrdered(&taskHeap[TASK_PRIORITY_MEDIUM]);
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ATTITUDE], unittest_scheduler_selectedTask);
+    scheduler();
+    EXPECT_EQ(static_cast<cfTask_t*>(0), unittest_scheduler_selectedTask);
+}
+
+TEST(SchedulerDeadlineQueueUnittest, TestHigherPriorityLevelWins)
+{
+    schedulerInit();
+    disableAllTasks();
+
+    simulatedTime = 100000;
+    cfTasks[TASK_SERIAL].lastExecutedAt = simulatedTime - TASK_PERIOD_HZ(100);
+    cfTasks[TASK_DISPATCH].lastExecutedAt = simulatedTime - TASK_PERIOD_HZ(1000);
+    setTaskEnabled(TASK_SERIAL, true);
+    setTaskEnabled(TASK_DISPATCH, true);
+
+    // both are one period late, the higher static priority is chosen
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_DISPATCH], unittest_scheduler_selectedTask);
+    EXPECT_EQ(2, unittest_scheduler_waitingTasks);
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_SERIAL], unittest_scheduler_selectedTask);
+}
+
+TEST(SchedulerDeadlineQueueUnittest, TestEveryWaitingTaskAges)
+{
+    schedulerInit();
+    disableAllTasks();
+
+    // TASK_ACCEL is due first, but TASK_ATTITUDE (rescheduled to 1kHz) has missed more of its periods
+    simulatedTime = 100000;
+    rescheduleTask(TASK_ATTITUDE, 1000);
+    cfTasks[TASK_ACCEL].lastExecutedAt = simulatedTime - 15000;          // due 5000us ago, 1 period old
+    cfTasks[TASK_ATTITUDE].lastExecutedAt = simulatedTime - 4000;        // due 3000us ago, 4 periods old
+    cfTasks[TASK_BATTERY_VOLTAGE].lastExecutedAt = simulatedTime - 1000; // not due
+    setTaskEnabled(TASK_ACCEL, true);
+    setTaskEnabled(TASK_ATTITUDE, true);
+    setTaskEnabled(TASK_BATTERY_VOLTAGE, true);
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], taskHeap[TASK_PRIORITY_MEDIUM].task[0]);
+
+    // as with the plain queue, the task with the highest dynamic priority runs, not the head of the heap
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ATTITUDE], unittest_scheduler_selectedTask);
+    EXPECT_EQ(2, unittest_scheduler_waitingTasks);
+    EXPECT_EQ(4, cfTasks[TASK_ATTITUDE].taskAgeCycles);
+    EXPECT_EQ(1, cfTasks[TASK_ACCEL].taskAgeCycles);
+    expectHeapOrdered(&taskHeap[TASK_PRIORITY_MEDIUM]);
+
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+    EXPECT_EQ(1, unittest_scheduler_waitingTasks);
+    expectHeapOrdered(&taskHeap[TASK_PRIORITY_MEDIUM]);
+
+    rescheduleTask(TASK_ATTITUDE, TASK_PERIOD_HZ(100));
+}
+
+TEST(SchedulerDeadlineQueueUnittest, TestIdleSleepRecordsWakeupLatency)
+{
+    schedulerInit();
+    disableAllTasks();
+    schedulerEnableIdleSleep(1000);
+    debugMode = DEBUG_IDLE_SLEEP;
+    memset(debug, 0, sizeof(debug));
+
+    simulatedTime = 100000;
+    cfTasks[TASK_ACCEL].lastExecutedAt = simulatedTime;
+    setTaskEnabled(TASK_ACCEL, true);
+
+    // another interrupt ends the sleep early
+    idleSleepCount = 0;
+    idleSleepTime = 400;
+    scheduler();
+    EXPECT_EQ(NULL, unittest_scheduler_selectedTask);
+    EXPECT_EQ(1, idleSleepCount);
+    EXPECT_EQ(400, debug[0]);
+    EXPECT_EQ(-600, debug[1]);
+    EXPECT_EQ(0, debug[3]);
+
+    // the wakeup interrupt arrives a little late, within the margin
+    idleSleepTime = 1000 + SCHEDULER_IDLE_SLEEP_MARGIN_US / 2;
+    scheduler();
+    EXPECT_EQ(SCHEDULER_IDLE_SLEEP_MARGIN_US / 2, debug[1]);
+    EXPECT_EQ(SCHEDULER_IDLE_SLEEP_MARGIN_US / 2, debug[2]);
+    EXPECT_EQ(0, debug[3]);
+
+    // TASK_ACCEL is due just after the margin, a wakeup later than that keeps it waiting
+    cfTasks[TASK_ACCEL].lastExecutedAt = simulatedTime + 1000 + SCHEDULER_IDLE_SLEEP_MARGIN_US + 5 - 10000;
+    idleSleepTime = 1000 + 2 * SCHEDULER_IDLE_SLEEP_MARGIN_US;
+    scheduler();
+    EXPECT_EQ(3, idleSleepCount);
+    EXPECT_EQ(2 * SCHEDULER_IDLE_SLEEP_MARGIN_US, debug[1]);
+    EXPECT_EQ(2 * SCHEDULER_IDLE_SLEEP_MARGIN_US, debug[2]);
+    EXPECT_EQ(1, debug[3]);
+
+    // no sleep when a task becomes due before the wakeup interval and the margin have passed
+    cfTasks[TASK_ACCEL].lastExecutedAt = simulatedTime + 1000 + SCHEDULER_IDLE_SLEEP_MARGIN_US - 1 - 10000;
+    scheduler();
+    EXPECT_EQ(3, idleSleepCount);
+
+    schedulerEnableIdleSleep(0);
+    debugMode = DEBUG_NONE;
+}
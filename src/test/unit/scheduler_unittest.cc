@@ -16,6 +16,7 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 
 extern "C" {
     #include "platform.h"
@@ -48,7 +49,13 @@ extern "C" {
 
     // set up tasks to take a simulated representative time to execute
     void taskMainPidLoop(timeUs_t) { simulatedTime += TEST_PID_LOOP_TIME; }
-    void taskUpdateAccelerometer(timeUs_t) { simulatedTime += TEST_UPDATE_ACCEL_TIME; }
+    bool accelerometerTaskYields = false;
+    void taskUpdateAccelerometer(timeUs_t) {
+        simulatedTime += TEST_UPDATE_ACCEL_TIME;
+        if (accelerometerTaskYields) {
+            schedulerYield();
+        }
+    }
     void taskHandleSerial(timeUs_t) { simulatedTime += TEST_HANDLE_SERIAL_TIME; }
     void taskUpdateBatteryVoltage(timeUs_t) { simulatedTime += TEST_UPDATE_BATTERY_TIME; }
     bool rxUpdateCheck(timeUs_t, timeDelta_t) { simulatedTime += TEST_UPDATE_RX_CHECK_TIME; return false; }
@@ -230,6 +237,29 @@ TEST(SchedulerUnittest, TestQueueAddAndRemove)
     EXPECT_EQ(deadBeefPtr, taskQueueArray[TASK_COUNT + 1]); // no accidental overwrites past end of queue
 }
 
+TEST(SchedulerUnittest, TestQueueContains)
+{
+    queueClear();
+    EXPECT_FALSE(queueContains(&cfTasks[TASK_ACCEL]));
+
+    EXPECT_TRUE(queueAdd(&cfTasks[TASK_ACCEL]));
+    EXPECT_TRUE(queueContains(&cfTasks[TASK_ACCEL]));
+    EXPECT_FALSE(queueContains(&cfTasks[TASK_GYROPID]));
+    // a task is only queued once
+    EXPECT_FALSE(queueAdd(&cfTasks[TASK_ACCEL]));
+    EXPECT_EQ(1, taskQueueSize);
+
+    EXPECT_TRUE(queueRemove(&cfTasks[TASK_ACCEL]));
+    EXPECT_FALSE(queueContains(&cfTasks[TASK_ACCEL]));
+    EXPECT_FALSE(queueRemove(&cfTasks[TASK_ACCEL]));
+
+    // queueClear() forgets every queued task
+    queueAdd(&cfTasks[TASK_ACCEL]);
+    queueClear();
+    EXPECT_FALSE(queueContains(&cfTasks[TASK_ACCEL]));
+    EXPECT_EQ(0, taskQueueSize);
+}
+
 TEST(SchedulerUnittest, TestQueueArray)
 {
     // test there are no "out by one" errors or buffer overruns when items are added and removed
@@ -393,3 +423,195 @@ TEST(SchedulerUnittest, TestTwoTasks)
     scheduler();
     EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
 }
+
+TEST(SchedulerUnittest, TestTaskHistogramPercentile)
+{
+    taskHistogram_t histogram;
+    memset(&histogram, 0, sizeof(histogram));
+    EXPECT_EQ(0, taskHistogramPercentile(&histogram, 500));
+
+    histogram.bucket[3] = 90;  // 4..7us
+    histogram.bucket[6] = 9;   // 32..63us
+    histogram.bucket[10] = 1;  // 512..1023us
+    EXPECT_EQ(7, taskHistogramPercentile(&histogram, 500));
+    EXPECT_EQ(7, taskHistogramPercentile(&histogram, 900));
+    EXPECT_EQ(63, taskHistogramPercentile(&histogram, 990));
+    EXPECT_EQ(1023, taskHistogramPercentile(&histogram, 999));
+}
+
+TEST(SchedulerUnittest, TestTaskHistogramRecording)
+{
+    schedulerInit();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+    }
+    setTaskEnabled(TASK_GYROPID, true);
+    schedulerResetTaskStatistics(TASK_GYROPID);
+    simulatedTime = 20000;
+    cfTasks[TASK_GYROPID].lastExecutedAt = simulatedTime - 1000 - 20; // started 20us late
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], unittest_scheduler_selectedTask);
+
+    taskHistogram_t executionTime;
+    taskHistogram_t startLatency;
+    EXPECT_TRUE(getTaskHistograms(TASK_GYROPID, &executionTime, &startLatency));
+    EXPECT_EQ(1, executionTime.bucket[10]); // TEST_PID_LOOP_TIME of 650us
+    EXPECT_EQ(1, startLatency.bucket[5]);   // 16..31us
+    EXPECT_EQ(1023, taskHistogramPercentile(&executionTime, 500));
+    EXPECT_EQ(31, taskHistogramPercentile(&startLatency, 999));
+    EXPECT_FALSE(getTaskHistograms(TASK_COUNT, &executionTime, &startLatency));
+}
+
+TEST(SchedulerUnittest, TestInterruptTask)
+{
+    schedulerInit();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+    }
+    setTaskEnabled(TASK_GYROPID, true);
+    setTaskEnabled(TASK_ACCEL, true);
+    schedulerResetTaskStatistics(TASK_GYROPID);
+    schedulerSetInterruptTask(TASK_GYROPID);
+    EXPECT_FALSE(queueContains(&cfTasks[TASK_GYROPID]));
+
+    cfTaskInfo_t taskInfo;
+    getTaskInfo(TASK_GYROPID, &taskInfo);
+    EXPECT_TRUE(taskInfo.isEnabled);
+
+    // scheduler() no longer runs the task, even when it is overdue
+    simulatedTime = 100000;
+    cfTasks[TASK_GYROPID].lastExecutedAt = simulatedTime - 5000;
+    cfTasks[TASK_ACCEL].lastExecutedAt = simulatedTime - 20000;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+
+    // the interrupt runs it and keeps its timing up to date
+    const timeUs_t previousExecutionAt = cfTasks[TASK_GYROPID].lastExecutedAt;
+    const timeUs_t interruptAt = simulatedTime + 100;
+    simulatedTime = interruptAt;
+    schedulerExecuteInterruptTask(interruptAt);
+    EXPECT_EQ(interruptAt, cfTasks[TASK_GYROPID].lastExecutedAt);
+    EXPECT_EQ(interruptAt - previousExecutionAt, (timeUs_t)cfTasks[TASK_GYROPID].taskLatestDeltaTime);
+    EXPECT_EQ(TEST_PID_LOOP_TIME, cfTasks[TASK_GYROPID].maxExecutionTime);
+
+    // TASK_NONE hands it back to the scheduler
+    schedulerSetInterruptTask(TASK_NONE);
+    EXPECT_TRUE(queueContains(&cfTasks[TASK_GYROPID]));
+}
+
+TEST(SchedulerUnittest, TestRemainingTime)
+{
+    schedulerInit();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+    }
+    EXPECT_EQ(SCHEDULER_TIME_UNLIMITED, schedulerGetRemainingTimeUs());
+
+    setTaskEnabled(TASK_GYROPID, true);
+    setTaskEnabled(TASK_ACCEL, true);
+    simulatedTime = 200000;
+    cfTasks[TASK_GYROPID].lastExecutedAt = simulatedTime - 600; // due in 400us
+    EXPECT_EQ(400, schedulerGetRemainingTimeUs());
+    simulatedTime += 500;
+    EXPECT_EQ(-100, schedulerGetRemainingTimeUs());
+}
+
+TEST(SchedulerUnittest, TestYield)
+{
+    schedulerInit();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+    }
+    setTaskEnabled(TASK_ACCEL, true);
+    simulatedTime = 300000;
+    cfTasks[TASK_ACCEL].lastExecutedAt = simulatedTime - cfTasks[TASK_ACCEL].desiredPeriod;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+
+    // without yielding the task waits for its period
+    scheduler();
+    EXPECT_EQ(NULL, unittest_scheduler_selectedTask);
+
+    // a task that yields is run again at the next opportunity
+    cfTasks[TASK_ACCEL].lastExecutedAt = simulatedTime - cfTasks[TASK_ACCEL].desiredPeriod;
+    accelerometerTaskYields = true;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+    accelerometerTaskYields = false;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+    scheduler();
+    EXPECT_EQ(NULL, unittest_scheduler_selectedTask);
+}
+
+TEST(SchedulerUnittest, TestSchedulerTrace)
+{
+    schedulerInit();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+    }
+    setTaskEnabled(TASK_GYROPID, true);
+    simulatedTime = 400000;
+    cfTasks[TASK_GYROPID].lastExecutedAt = simulatedTime - cfTasks[TASK_GYROPID].desiredPeriod - 15; // 15us late
+
+    const uint32_t sequence = schedulerTraceSequence();
+    schedulerTraceEntry_t entry;
+    EXPECT_FALSE(schedulerTraceRead(sequence, &entry));
+    scheduler();
+    EXPECT_EQ(sequence + 1, schedulerTraceSequence());
+    EXPECT_TRUE(schedulerTraceRead(sequence, &entry));
+    EXPECT_EQ(TASK_GYROPID, entry.taskId);
+    EXPECT_EQ(400000, entry.startedAt);
+    EXPECT_EQ(TEST_PID_LOOP_TIME, entry.executionTime);
+    EXPECT_EQ(15, entry.lateness);
+
+    // old entries are overwritten
+    for (unsigned i = 0; i < SCHEDULER_TRACE_SIZE; i++) {
+        simulatedTime += cfTasks[TASK_GYROPID].desiredPeriod;
+        scheduler();
+    }
+    EXPECT_FALSE(schedulerTraceRead(sequence, &entry));
+    EXPECT_TRUE(schedulerTraceRead(sequence + 1, &entry));
+}
+
+TEST(SchedulerUnittest, TestTaskChaining)
+{
+    schedulerInit();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+    }
+    setTaskEnabled(TASK_GYROPID, true);
+    setTaskEnabled(TASK_ACCEL, true);
+    const timeDelta_t pidLoopPeriod = cfTasks[TASK_GYROPID].desiredPeriod;
+    const timeDelta_t accelPeriod = cfTasks[TASK_ACCEL].desiredPeriod;
+
+    schedulerChainTask(TASK_ACCEL, TASK_GYROPID, 2);
+    EXPECT_TRUE(queueContains(&cfTasks[TASK_ACCEL]));
+    EXPECT_EQ(pidLoopPeriod * 2, cfTasks[TASK_ACCEL].desiredPeriod);
+
+    // a chained task does not run on its own, however overdue it is
+    simulatedTime = 300000;
+    cfTasks[TASK_GYROPID].lastExecutedAt = simulatedTime - pidLoopPeriod;
+    cfTasks[TASK_ACCEL].lastExecutedAt = simulatedTime - 100000;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], unittest_scheduler_selectedTask);
+    scheduler();
+    EXPECT_EQ(NULL, unittest_scheduler_selectedTask);
+
+    // it runs straight after every second execution of the task it is chained to
+    cfTasks[TASK_GYROPID].lastExecutedAt = simulatedTime - pidLoopPeriod;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_GYROPID], unittest_scheduler_selectedTask);
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+    scheduler();
+    EXPECT_EQ(NULL, unittest_scheduler_selectedTask);
+
+    // TASK_NONE makes it time driven again
+    schedulerChainTask(TASK_ACCEL, TASK_NONE, 0);
+    EXPECT_TRUE(queueContains(&cfTasks[TASK_ACCEL]));
+    cfTasks[TASK_ACCEL].lastExecutedAt = simulatedTime - 100000;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+    rescheduleTask(TASK_ACCEL, accelPeriod);
+}
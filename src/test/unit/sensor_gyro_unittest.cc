@@ -27,11 +27,13 @@ extern "C" {
     #include "build/build_config.h"
     #include "build/debug.h"
     #include "common/axis.h"
+    #include "common/filter.h"
     #include "common/maths.h"
     #include "common/utils.h"
     #include "drivers/accgyro/accgyro_fake.h"
     #include "drivers/accgyro/accgyro_mpu.h"
     #include "drivers/sensor.h"
+    #include "fc/runtime_config.h"
     #include "io/beeper.h"
     #include "pg/pg.h"
     #include "pg/pg_ids.h"
@@ -44,6 +46,9 @@ extern "C" {
     struct gyroSensor_s;
     STATIC_UNIT_TESTED void performGyroCalibration(struct gyroSensor_s *gyroSensor, uint8_t gyroMovementCalibrationThreshold);
     STATIC_UNIT_TESTED bool fakeGyroRead(gyroDev_t *gyro);
+    STATIC_UNIT_TESTED void gyroFifoDecimate(gyroDev_t *gyroDev);
+    STATIC_UNIT_TESTED float gyroVoteAxis(const float sample[][XYZ_AXIS_COUNT], int axis, float outlierThreshold);
+    STATIC_UNIT_TESTED void gyroUpdateHealth(const float sample[][XYZ_AXIS_COUNT], float outlierThreshold);
 
     uint8_t debugMode;
     int16_t debug[DEBUG16_VALUE_COUNT];
@@ -53,6 +58,7 @@ extern "C" {
 #include "gtest/gtest.h"
 extern gyroSensor_s * const gyroSensorPtr;
 extern gyroDev_t * const gyroDevPtr;
+extern gyroDev_t * const gyroDev2Ptr;
 
 
 TEST(SensorGyro, Detect)
@@ -111,6 +117,45 @@ TEST(SensorGyro, Calibrate)
     EXPECT_EQ(7, gyroDevPtr->gyroZero[Z]);
 }
 
+TEST(SensorGyro, FastCalibrate)
+{
+    pgResetAll();
+    gyroConfigMutable()->gyro_fast_calibration = true;
+    gyroInit();
+    static const int gyroMovementCalibrationThreshold = 32;
+
+    // a still gyro with a little noise finishes well before the configured duration
+    gyroStartCalibration(false);
+    int cycles = 0;
+    while (!isGyroCalibrationComplete()) {
+        const int noise = (cycles % 2) ? 1 : -1;
+        fakeGyroSet(gyroDevPtr, 5 + noise, 6 - noise, 7 + noise);
+        gyroDevPtr->readFn(gyroDevPtr);
+        performGyroCalibration(gyroSensorPtr, gyroMovementCalibrationThreshold);
+        cycles++;
+    }
+    const int stillCycles = cycles;
+    EXPECT_LT(stillCycles, (gyroConfig()->gyroCalibrationDuration * 10000) / (int)gyroFilterLooptime() / 2);
+    EXPECT_NEAR(5, gyroDevPtr->gyroZero[X], 0.01f);
+    EXPECT_NEAR(6, gyroDevPtr->gyroZero[Y], 0.01f);
+    EXPECT_NEAR(7, gyroDevPtr->gyroZero[Z], 0.01f);
+
+    // moving the model in the middle only costs the windows it was moved in
+    gyroStartCalibration(false);
+    cycles = 0;
+    while (!isGyroCalibrationComplete()) {
+        const int movement = (cycles > stillCycles / 2 && cycles < stillCycles / 2 + 10) ? 500 : 0;
+        fakeGyroSet(gyroDevPtr, 5 + movement, 6, 7);
+        gyroDevPtr->readFn(gyroDevPtr);
+        performGyroCalibration(gyroSensorPtr, gyroMovementCalibrationThreshold);
+        cycles++;
+    }
+    EXPECT_LT(cycles, 2 * stillCycles);
+    EXPECT_FLOAT_EQ(5, gyroDevPtr->gyroZero[X]);
+    EXPECT_FLOAT_EQ(6, gyroDevPtr->gyroZero[Y]);
+    EXPECT_FLOAT_EQ(7, gyroDevPtr->gyroZero[Z]);
+}
+
 TEST(SensorGyro, Update)
 {
     pgResetAll();
@@ -150,6 +195,310 @@ TEST(SensorGyro, Update)
     EXPECT_FLOAT_EQ(90 * gyroDevPtr->scale, gyro.gyroADCf[Z]);
 }
 
+TEST(SensorGyro, ReconfigureFilters)
+{
+    pgResetAll();
+    gyroConfigMutable()->gyro_lowpass_type = FILTER_PT1;
+    gyroConfigMutable()->gyro_lowpass_hz = 100;
+    gyroConfigMutable()->gyro_lowpass2_hz = 0;
+    gyroConfigMutable()->gyro_soft_notch_hz_1 = 0;
+    gyroConfigMutable()->gyro_soft_notch_hz_2 = 0;
+    gyroInit();
+    gyroDevPtr->readFn = fakeGyroRead;
+    gyroStartCalibration(false);
+    timeUs_t currentTimeUs = 0;
+    while (!isGyroCalibrationComplete()) {
+        fakeGyroSet(gyroDevPtr, 5, 6, 7);
+        gyroUpdate(currentTimeUs);
+    }
+    for (int i = 0; i < 1000; i++) {
+        fakeGyroSet(gyroDevPtr, 105, 6, 7);
+        gyroUpdate(currentTimeUs);
+    }
+    EXPECT_NEAR(100 * gyroDevPtr->scale, gyro.gyroADCf[X], 0.01f);
+
+    // a new cutoff takes over from the settled output instead of starting again from zero
+    gyroConfigMutable()->gyro_lowpass_hz = 200;
+    EXPECT_TRUE(gyroReconfigureFilters());
+    fakeGyroSet(gyroDevPtr, 105, 6, 7);
+    gyroUpdate(currentTimeUs);
+    EXPECT_NEAR(100 * gyroDevPtr->scale, gyro.gyroADCf[X], 0.01f);
+
+    // the next step goes through the new cutoff
+    const float gain200 = pt1FilterGain(200, gyroFilterLooptime() * 1e-6f);
+    fakeGyroSet(gyroDevPtr, 205, 6, 7);
+    gyroUpdate(currentTimeUs);
+    float expected = (100 + gain200 * 100) * gyroDevPtr->scale;
+    EXPECT_NEAR(expected, gyro.gyroADCf[X], 0.01f);
+
+    // refused while armed, the loop keeps the filters it has
+    gyroConfigMutable()->gyro_lowpass_hz = 50;
+    ENABLE_ARMING_FLAG(ARMED);
+    EXPECT_FALSE(gyroReconfigureFilters());
+    fakeGyroSet(gyroDevPtr, 205, 6, 7);
+    gyroUpdate(currentTimeUs);
+    expected += gain200 * (200 * gyroDevPtr->scale - expected);
+    EXPECT_NEAR(expected, gyro.gyroADCf[X], 0.01f);
+    DISABLE_ARMING_FLAG(ARMED);
+}
+
+TEST(SensorGyro, SampleRing)
+{
+    pgResetAll();
+    gyroConfigMutable()->gyro_lowpass_hz = 0;
+    gyroConfigMutable()->gyro_lowpass2_hz = 0;
+    gyroInit();
+    gyroDevPtr->readFn = fakeGyroRead;
+    gyroStartCalibration(false);
+    timeUs_t currentTimeUs = 0;
+    while (!isGyroCalibrationComplete()) {
+        fakeGyroSet(gyroDevPtr, 5, 6, 7);
+        gyroUpdate(currentTimeUs);
+    }
+
+    gyroSampleReader_t reader;
+    gyroSampleReaderInit(&reader, gyroSampleRing());
+    gyroSample_t samples[GYRO_SAMPLE_RING_SIZE];
+    EXPECT_EQ(0u, gyroSampleRead(&reader, samples, GYRO_SAMPLE_RING_SIZE));
+
+    for (int i = 0; i < 3; i++) {
+        currentTimeUs += 125;
+        fakeGyroSet(gyroDevPtr, 5 + i, 6, 7);
+        gyroUpdate(currentTimeUs);
+    }
+    // read in two batches
+    EXPECT_EQ(2u, gyroSampleRead(&reader, samples, 2));
+    EXPECT_EQ(125u, samples[0].timeUs);
+    EXPECT_FLOAT_EQ(0, samples[0].raw[X]);
+    EXPECT_FLOAT_EQ(1, samples[1].raw[X]);
+    EXPECT_FLOAT_EQ(gyroDevPtr->scale, samples[1].filtered[X]);
+    EXPECT_EQ(1u, gyroSampleRead(&reader, samples, 2));
+    EXPECT_EQ(375u, samples[0].timeUs);
+    EXPECT_FLOAT_EQ(2, samples[0].raw[X]);
+    EXPECT_EQ(0u, reader.missedCount);
+
+    // a reader that falls behind loses the oldest samples and resumes with the newest
+    const int written = GYRO_SAMPLE_RING_SIZE + 5;
+    for (int i = 0; i < written; i++) {
+        currentTimeUs += 125;
+        fakeGyroSet(gyroDevPtr, 5, 6, 7);
+        gyroUpdate(currentTimeUs);
+    }
+    const unsigned count = gyroSampleRead(&reader, samples, GYRO_SAMPLE_RING_SIZE);
+    EXPECT_EQ((unsigned)written, count + reader.missedCount);
+    EXPECT_EQ(currentTimeUs, samples[count - 1].timeUs);
+    EXPECT_EQ(0u, gyroSampleRead(&reader, samples, GYRO_SAMPLE_RING_SIZE));
+}
+
+TEST(SensorGyro, YawSpinCheckInterval)
+{
+    pgResetAll();
+    gyroConfigMutable()->gyro_lowpass_hz = 0;
+    gyroConfigMutable()->gyro_lowpass2_hz = 0;
+    gyroConfigMutable()->yaw_spin_threshold = 500;
+    gyroConfigMutable()->gyro_overflow_check_us = 1000;
+    gyroInit();
+    gyroDevPtr->readFn = fakeGyroRead;
+    gyroStartCalibration(false);
+    // later than the previous tests, the sensor state is kept between them
+    timeUs_t currentTimeUs = 1000000;
+    while (!isGyroCalibrationComplete()) {
+        fakeGyroSet(gyroDevPtr, 0, 0, 0);
+        gyroUpdate(currentTimeUs);
+    }
+
+    // a single sample above the threshold is held until the next check
+    const int16_t spinRaw = 1000 / gyroDevPtr->scale;
+    currentTimeUs += 125;
+    fakeGyroSet(gyroDevPtr, 0, 0, spinRaw);
+    gyroUpdate(currentTimeUs);
+    timeUs_t detectedTimeUs = currentTimeUs;
+    while (!gyroYawSpinDetected() && cmpTimeUs(currentTimeUs, detectedTimeUs) < 5000) {
+        currentTimeUs += 125;
+        fakeGyroSet(gyroDevPtr, 0, 0, 0);
+        gyroUpdate(currentTimeUs);
+    }
+    EXPECT_TRUE(gyroYawSpinDetected());
+    EXPECT_LE(cmpTimeUs(currentTimeUs, detectedTimeUs), 1000 + 125);
+
+    // recovery still needs 20ms of low yaw rates
+    detectedTimeUs = currentTimeUs;
+    while (gyroYawSpinDetected() && cmpTimeUs(currentTimeUs, detectedTimeUs) < 50000) {
+        currentTimeUs += 125;
+        fakeGyroSet(gyroDevPtr, 0, 0, 0);
+        gyroUpdate(currentTimeUs);
+    }
+    EXPECT_FALSE(gyroYawSpinDetected());
+    EXPECT_GT(cmpTimeUs(currentTimeUs, detectedTimeUs), 20000);
+}
+
+static int eepromWriteCount;
+
+TEST(SensorGyro, TemperatureCompensation)
+{
+    pgResetAll();
+    gyroConfigMutable()->gyro_lowpass_hz = 0;
+    gyroConfigMutable()->gyro_lowpass2_hz = 0;
+    gyroTempCompConfigMutable()->enabled = true;
+    gyroInit();
+    gyroDevPtr->readFn = fakeGyroRead;
+    // nothing learned yet, so the gyro has to be calibrated
+    EXPECT_FALSE(gyroTempCompSetZero());
+    gyroStartCalibration(false);
+    timeUs_t currentTimeUs = 10000000;
+    gyroDevPtr->temperature = 20;
+    while (!isGyroCalibrationComplete()) {
+        fakeGyroSet(gyroDevPtr, 5, 6, 7);
+        gyroUpdate(currentTimeUs);
+    }
+
+    // learn one second of still samples at 20C, and one at 25C after the zero offset of X drifted
+    eepromWriteCount = 0;
+    gyroTempCompUpdate(currentTimeUs);
+    for (int second = 0; second < 2; second++) {
+        for (int i = 0; i < 1000; i++) {
+            currentTimeUs += 1000;
+            fakeGyroSet(gyroDevPtr, second ? 9 : 5, 6, 7);
+            gyroUpdate(currentTimeUs);
+        }
+        gyroTempCompUpdate(currentTimeUs);
+        gyroDevPtr->temperature = 25;
+    }
+    // the table is only stored with an explicit save
+    EXPECT_EQ(0, eepromWriteCount);
+    EXPECT_EQ((1 << 2) | (1 << 3), gyroTempCompConfig()->learnedMask);
+    EXPECT_EQ(9 * GYRO_TEMP_COMP_SCALE, gyroTempCompConfig()->bias[3][X]);
+
+    // the drift is compensated without calibrating again
+    currentTimeUs += 1000;
+    fakeGyroSet(gyroDevPtr, 9, 6, 7);
+    gyroUpdate(currentTimeUs);
+    EXPECT_FLOAT_EQ(0, gyro.gyroADCf[X]);
+    EXPECT_FLOAT_EQ(0, gyro.gyroADCf[Y]);
+
+    // half way between the points the zero offset is interpolated
+    gyroDevPtr->temperature = 22;
+    EXPECT_TRUE(gyroTempCompSetZero());
+    EXPECT_FLOAT_EQ(5 + 4 * 2 / 5.0f, gyroDevPtr->gyroZero[X]);
+    EXPECT_FLOAT_EQ(6, gyroDevPtr->gyroZero[Y]);
+    // outside the learned points it is not
+    gyroDevPtr->temperature = 30;
+    EXPECT_FALSE(gyroTempCompSetZero());
+}
+
+TEST(SensorGyro, FifoDecimate)
+{
+    gyroDev_t dev;
+    memset(&dev, 0, sizeof(dev));
+
+    // no samples read, the raw values are left alone
+    dev.gyroADCRaw[X] = 3;
+    gyroFifoDecimate(&dev);
+    EXPECT_EQ(3, dev.gyroADCRaw[X]);
+
+    const int16_t samples[4][XYZ_AXIS_COUNT] = {
+        { 10, -10, 1000 },
+        { 11, -11, 2000 },
+        { 12, -12, -500 },
+        { 12, -12, 0 },
+    };
+    memcpy(dev.gyroADCRawFifo, samples, sizeof(samples));
+    dev.fifoSampleCount = 4;
+    gyroFifoDecimate(&dev);
+    EXPECT_EQ(11, dev.gyroADCRaw[X]);     // 11.25
+    EXPECT_EQ(-11, dev.gyroADCRaw[Y]);    // -11.25
+    EXPECT_EQ(625, dev.gyroADCRaw[Z]);
+
+    dev.fifoSampleCount = 1;
+    gyroFifoDecimate(&dev);
+    EXPECT_EQ(10, dev.gyroADCRaw[X]);
+    EXPECT_EQ(-10, dev.gyroADCRaw[Y]);
+    EXPECT_EQ(1000, dev.gyroADCRaw[Z]);
+}
+
+// Feeds one fused sample of both gyros through the vote and the health scores, as gyroFuse() does
+static void gyroVoteSample(uint32_t timeUs, float gyro1, float gyro2)
+{
+    const float sample[2][XYZ_AXIS_COUNT] = { { gyro1, 0, 0 }, { gyro2, 0, 0 } };
+    gyroDevPtr->sampleTimeUs = timeUs;
+    gyroDev2Ptr->sampleTimeUs = timeUs;
+    gyroDevPtr->gyroADCRaw[X] = gyro1;
+    gyroDev2Ptr->gyroADCRaw[X] = gyro2;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyro.gyroADCf[axis] = gyroVoteAxis(sample, axis, 100);
+    }
+    gyroUpdateHealth(sample, 100);
+}
+
+TEST(SensorGyro, VoteAxis)
+{
+    pgResetAll();
+    gyroInit();
+    const float sample[2][XYZ_AXIS_COUNT] = { { 10, 10, -40 }, { 20, 300, 240 } };
+
+    // two gyros that agree are averaged
+    EXPECT_FLOAT_EQ(15, gyroVoteAxis(sample, X, 100));
+    // further apart than the threshold the one closer to the last output is followed
+    gyro.gyroADCf[Y] = 0;
+    EXPECT_FLOAT_EQ(10, gyroVoteAxis(sample, Y, 100));
+    gyro.gyroADCf[Z] = 200;
+    EXPECT_FLOAT_EQ(240, gyroVoteAxis(sample, Z, 100));
+    // without a threshold they are always averaged
+    EXPECT_FLOAT_EQ(155, gyroVoteAxis(sample, Y, 0));
+}
+
+TEST(SensorGyro, HealthTwoGyrosDisagreeing)
+{
+    pgResetAll();
+    gyroInit();
+    debugMode = DEBUG_DUAL_GYRO_DIFF;
+
+    // the vote follows gyro 1, but with two gyros it can't tell which one is wrong, so neither is left out
+    gyro.gyroADCf[X] = 0;
+    for (int i = 0; i < 5000; i++) {
+        gyroVoteSample(i * 125, i & 7, 500 + (i & 7));
+    }
+    EXPECT_FLOAT_EQ(7, gyro.gyroADCf[X]);
+    EXPECT_EQ(0, debug[3]);
+    debugMode = DEBUG_NONE;
+}
+
+TEST(SensorGyro, HealthStuckGyro)
+{
+    pgResetAll();
+    gyroInit();
+    debugMode = DEBUG_DUAL_GYRO_DIFF;
+
+    // gyro 2 stops updating and is left out, the score needs 250 stuck samples to get there
+    uint32_t timeUs = 0;
+    for (int i = 0; i < 300; i++) {
+        gyroVoteSample(timeUs += 125, i & 7, 3);
+    }
+    EXPECT_EQ(1 << 1, debug[3]);
+    // the vote now follows gyro 1 alone
+    gyroVoteSample(timeUs += 125, 5, 3);
+    EXPECT_FLOAT_EQ(5, gyro.gyroADCf[X]);
+
+    // the last gyro in the vote is kept even when it gets stuck as well
+    for (int i = 0; i < 300; i++) {
+        gyroVoteSample(timeUs += 125, 5, 3);
+    }
+    EXPECT_EQ(1 << 1, debug[3]);
+
+    // loops without a new sample don't count as stuck
+    for (int i = 0; i < 500; i++) {
+        gyroVoteSample(timeUs, 5 + (i & 7), 3 + (i & 7));
+    }
+    EXPECT_EQ(1 << 1, debug[3]);
+
+    // gyro 2 is taken back once it has been good for long enough
+    for (int i = 0; i < 1000 && debug[3]; i++) {
+        gyroVoteSample(timeUs += 125, i & 7, i & 7);
+    }
+    EXPECT_EQ(0, debug[3]);
+    debugMode = DEBUG_NONE;
+}
+
 // STUBS
 
 extern "C" {
@@ -160,5 +509,8 @@ uint8_t detectedSensors[] = { GYRO_NONE, ACC_NONE };
 timeDelta_t getGyroUpdateRate(void) {return gyro.targetLooptime;}
 void sensorsSet(uint32_t) {}
 void schedulerResetTaskStatistics(cfTaskId_e) {}
-int getArmingDisableFlags(void) {return 0;}
+armingDisableFlags_e getArmingDisableFlags(void) {return (armingDisableFlags_e)0;}
+uint8_t armingFlags = 0;
+void writeEEPROM(void) {eepromWriteCount++;}
+void spiBusSetInstance(busDevice_t *, SPI_TypeDef *) {}
 }
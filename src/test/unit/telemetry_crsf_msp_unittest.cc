@@ -221,7 +221,10 @@ TEST(CrossFireMSPTest, WriteResponseTest)
 
 }
 
-void testSendMspResponse(uint8_t *payload) {
+uint8_t payloadOutputSize;
+
+void testSendMspResponse(uint8_t *payload, uint8_t payloadSize) {
+    payloadOutputSize = payloadSize;
     sbuf_t *plOut = sbufInit(&payloadOutputBuf, payloadOutput, payloadOutput + 64);
     sbufWriteData(plOut, payload, *payload + 64);
     sbufSwitchToReader(&payloadOutputBuf, payloadOutput);
@@ -243,14 +246,19 @@ TEST(CrossFireMSPTest, SendMspReply) {
         EXPECT_EQ(ii, sbufReadU8(&payloadOutputBuf));
     }
     EXPECT_EQ(0x71, sbufReadU8(&payloadOutputBuf)); // CRC
+    EXPECT_EQ(1 + 1 + 30 + 1, payloadOutputSize); // last chunk is not padded to the frame size
 }
 
 // STUBS
 
 extern "C" {
 
+rssiSource_e rssiSource;
+void setRssi(uint16_t, rssiSource_e) {}
+
     gpsSolutionData_t gpsSol;
     attitudeEulerAngles_t attitude = { { 0, 0, 0 } };
+    const attitudeEulerAngles_t *getAttitude(void) { return &attitude; }
 
     uint32_t micros(void) {return dummyTimeUs;}
     serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, void *, uint32_t, portMode_e, portOptions_e) {return NULL;}
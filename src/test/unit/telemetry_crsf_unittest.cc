@@ -68,6 +68,7 @@ extern "C" {
     int32_t testmAhDrawn = 0;
 
     serialPort_t *telemetrySharedPort;
+    extern attitudeEulerAngles_t attitude;
     PG_REGISTER(batteryConfig_t, batteryConfig, PG_BATTERY_CONFIG, 0);
     PG_REGISTER(telemetryConfig_t, telemetryConfig, PG_TELEMETRY_CONFIG, 0);
     PG_REGISTER(systemConfig_t, systemConfig, PG_SYSTEM_CONFIG, 0);
@@ -277,6 +278,10 @@ TEST(TelemetryCrsfTest, TestFlightMode)
 
 extern "C" {
 
+rssiSource_e rssiSource;
+void setRssi(uint16_t, rssiSource_e) {}
+void serialSetBaudRate(serialPort_t *, uint32_t) {}
+
 int16_t debug[DEBUG16_VALUE_COUNT];
 
 const uint32_t baudRates[] = {0, 9600, 19200, 38400, 57600, 115200, 230400, 250000, 400000}; // see baudRate_e
@@ -285,6 +290,7 @@ uint16_t batteryWarningVoltage;
 uint8_t useHottAlarmSoundPeriod (void) { return 0; }
 
 attitudeEulerAngles_t attitude = { { 0, 0, 0 } };     // absolute angle inclination in multiple of 0.1 degree    180 deg = 1800
+const attitudeEulerAngles_t *getAttitude(void) { return &attitude; }
 
 uint16_t GPS_distanceToHome;        // distance to home point in meters
 gpsSolutionData_t gpsSol;
@@ -237,6 +237,12 @@ void closeSerialPort(serialPort_t *serialPort)
     UNUSED(serialPort);
 }
 
+void softSerialSetTxGap(serialPort_t *instance, uint8_t bits)
+{
+    UNUSED(instance);
+    UNUSED(bits);
+}
+
 serialPortConfig_t *findSerialPortConfig(serialPortFunction_e function)
 {
     UNUSED(function);
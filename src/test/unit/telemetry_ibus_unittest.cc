@@ -51,6 +51,7 @@ extern "C" {
     telemetryConfig_t telemetryConfig_System;
     batteryConfig_s batteryConfig_System;
     attitudeEulerAngles_t attitude = EULER_INITIALIZE;
+    const attitudeEulerAngles_t *getAttitude(void) { return &attitude; }
     acc_t acc;
     baro_t baro;
     gpsSolutionData_t gpsSol;
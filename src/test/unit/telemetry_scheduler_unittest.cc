@@ -0,0 +1,84 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+extern "C" {
+#include "platform.h"
+#include "common/utils.h"
+#include "telemetry/telemetry_scheduler.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+TEST(TelemetrySchedulerTest, NoSensors)
+{
+    telemetryScheduler_t scheduler;
+    telemetrySchedulerInit(&scheduler, NULL, NULL, 0);
+
+    EXPECT_EQ(-1, telemetrySchedulerNextSensor(&scheduler, 1000));
+}
+
+TEST(TelemetrySchedulerTest, DueSensorsByPriority)
+{
+    const telemetrySensor_t sensors[] = { { 100, 1 }, { 100, 3 }, { 100, 2 } };
+    timeMs_t sentAtMs[ARRAYLEN(sensors)];
+    telemetryScheduler_t scheduler;
+    telemetrySchedulerInit(&scheduler, sensors, sentAtMs, ARRAYLEN(sensors));
+
+    EXPECT_EQ(1, telemetrySchedulerNextSensor(&scheduler, 1000));
+    EXPECT_EQ(2, telemetrySchedulerNextSensor(&scheduler, 1010));
+    EXPECT_EQ(0, telemetrySchedulerNextSensor(&scheduler, 1020));
+}
+
+TEST(TelemetrySchedulerTest, DueSensorBeforeHigherPriority)
+{
+    const telemetrySensor_t sensors[] = { { 1000, 255 }, { 100, 1 } };
+    timeMs_t sentAtMs[ARRAYLEN(sensors)];
+    telemetryScheduler_t scheduler;
+    telemetrySchedulerInit(&scheduler, sensors, sentAtMs, ARRAYLEN(sensors));
+
+    EXPECT_EQ(0, telemetrySchedulerNextSensor(&scheduler, 5000));
+    // the high priority sensor was just sent, the low priority one is due
+    EXPECT_EQ(1, telemetrySchedulerNextSensor(&scheduler, 5010));
+}
+
+TEST(TelemetrySchedulerTest, SensorRates)
+{
+    const telemetrySensor_t sensors[] = { { 20, 3 }, { 200, 1 }, { 1000, 1 } };
+    timeMs_t sentAtMs[ARRAYLEN(sensors)];
+    telemetryScheduler_t scheduler;
+    telemetrySchedulerInit(&scheduler, sensors, sentAtMs, ARRAYLEN(sensors));
+
+    // one slot every 10ms for 10s
+    unsigned sent[ARRAYLEN(sensors)] = { 0 };
+    for (timeMs_t now = 1000; now < 11000; now += 10) {
+        const int sensor = telemetrySchedulerNextSensor(&scheduler, now);
+        ASSERT_GE(sensor, 0);
+        sent[sensor]++;
+    }
+
+    // every sensor keeps up with its interval, the spare slots go to the fast one
+    EXPECT_GE(sent[0], 10000u / 20);
+    EXPECT_GE(sent[1], 10000u / 200 - 1);
+    EXPECT_GE(sent[2], 10000u / 1000 - 1);
+    EXPECT_EQ(1000u, sent[0] + sent[1] + sent[2]);
+}
@@ -0,0 +1,104 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <limits.h>
+
+extern "C" {
+    #include "common/typeconversion.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+TEST(TypeConversionTest, Ui2aDecimal)
+{
+    char buf[12];
+    const uint32_t values[] = { 0, 7, 10, 99, 100, 101, 999, 1000, 65535, 1234567, 999999999, 1000000000, UINT32_MAX };
+    for (unsigned i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        char expected[12];
+        const int expectedLength = snprintf(expected, sizeof(expected), "%u", (unsigned)values[i]);
+        EXPECT_EQ(expectedLength, ui2aDecimal(values[i], buf));
+        EXPECT_STREQ(expected, buf);
+    }
+}
+
+TEST(TypeConversionTest, I2aDecimal)
+{
+    char buf[12];
+    const int32_t values[] = { 0, -1, 9, -10, 4711, -32768, INT32_MAX, INT32_MIN };
+    for (unsigned i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        char expected[12];
+        const int expectedLength = snprintf(expected, sizeof(expected), "%d", (int)values[i]);
+        EXPECT_EQ(expectedLength, i2aDecimal(values[i], buf));
+        EXPECT_STREQ(expected, buf);
+
+        i2a(values[i], buf);
+        EXPECT_STREQ(expected, buf);
+    }
+}
+
+TEST(TypeConversionTest, I2aPadded)
+{
+    char buf[16];
+
+    EXPECT_EQ(buf + 3, i2aPadded(5, 3, ' ', buf));
+    EXPECT_STREQ("  5", buf);
+    EXPECT_EQ(buf + 3, i2aPadded(5, 3, '0', buf));
+    EXPECT_STREQ("005", buf);
+    EXPECT_EQ(buf + 3, i2aPadded(-5, 3, ' ', buf));
+    EXPECT_STREQ(" -5", buf);
+    // the sign goes before the zeros
+    EXPECT_EQ(buf + 3, i2aPadded(-5, 3, '0', buf));
+    EXPECT_STREQ("-05", buf);
+    // wider numbers are not cut
+    EXPECT_EQ(buf + 5, i2aPadded(12345, 3, ' ', buf));
+    EXPECT_STREQ("12345", buf);
+    EXPECT_EQ(buf + 1, i2aPadded(0, 0, ' ', buf));
+    EXPECT_STREQ("0", buf);
+
+    // appending
+    char *p = i2aPadded(7, 2, '0', buf);
+    *p++ = ':';
+    i2aPadded(3, 2, '0', p);
+    EXPECT_STREQ("07:03", buf);
+}
+
+TEST(TypeConversionTest, Ui2aHex)
+{
+    char buf[12];
+
+    ui2a(0, 16, 0, buf);
+    EXPECT_STREQ("0", buf);
+    ui2a(0xbeef, 16, 0, buf);
+    EXPECT_STREQ("beef", buf);
+    ui2a(0xbeef, 16, 1, buf);
+    EXPECT_STREQ("BEEF", buf);
+    ui2a(0x80000000, 16, 0, buf);
+    EXPECT_STREQ("80000000", buf);
+    ui2a(UINT32_MAX, 16, 1, buf);
+    EXPECT_STREQ("FFFFFFFF", buf);
+
+    // other bases keep the generic conversion
+    ui2a(5, 2, 0, buf);
+    EXPECT_STREQ("101", buf);
+}
@@ -33,7 +33,7 @@ extern "C" {
 extern "C" {
 STATIC_UNIT_TESTED extern uint16_t dmaBufferOffset;
 
-STATIC_UNIT_TESTED void fastUpdateLEDDMABuffer(rgbColor24bpp_t *color);
+STATIC_UNIT_TESTED void fastUpdateLEDDMABuffer(ledStripFormatRGB_e ledFormat, rgbColor24bpp_t *color);
 STATIC_UNIT_TESTED void updateLEDDMABuffer(uint8_t componentValue);
 }
 
@@ -50,7 +50,7 @@ TEST(WS2812, updateDMABuffer) {
     updateLEDDMABuffer(color1.rgb.r);
     updateLEDDMABuffer(color1.rgb.b);
 #else
-    fastUpdateLEDDMABuffer(&color1);
+    fastUpdateLEDDMABuffer(LED_GRB, &color1);
 #endif
 
     // then
@@ -90,10 +90,65 @@ TEST(WS2812, updateDMABuffer) {
     byteIndex++;
 }
 
+TEST(WS2812, updateStripEncodesOnlyChangedLeds) {
+    // given
+    BIT_COMPARE_1 = 2;
+    BIT_COMPARE_0 = 1;
+    const hsvColor_t black = { 0, 0, 0 };
+    setStripColor(&black);
+
+    // when
+    ws2811LedDataTransferInProgress = 0;
+    ws2811UpdateStrip(LED_GRB);
+
+    // then
+    for (int i = 0; i < WS2811_DATA_BUFFER_SIZE; i++) {
+        EXPECT_EQ(BIT_COMPARE_0, ledStripDMABuffer[i]);
+    }
+
+    // given
+    const hsvColor_t blue = { 0, 0, 0xff };
+    setLedHsv(1, &blue);
+    // marks buffer contents that must not be encoded again
+    ledStripDMABuffer[0] = 0;
+
+    // when
+    ws2811LedDataTransferInProgress = 0;
+    ws2811UpdateStrip(LED_GRB);
+
+    // then
+    EXPECT_EQ(0, ledStripDMABuffer[0]);
+    for (int i = 0; i < 16; i++) {
+        EXPECT_EQ(BIT_COMPARE_0, ledStripDMABuffer[WS2811_BITS_PER_LED + i]);
+    }
+    for (int i = 16; i < WS2811_BITS_PER_LED; i++) {
+        EXPECT_EQ(BIT_COMPARE_1, ledStripDMABuffer[WS2811_BITS_PER_LED + i]);
+    }
+
+    // when nothing changed
+    ws2811LedDataTransferInProgress = 0;
+    ws2811UpdateStrip(LED_GRB);
+
+    // then no transfer is started
+    EXPECT_EQ(0, ws2811LedDataTransferInProgress);
+
+    // when the bit timing changes everything is encoded again
+    BIT_COMPARE_0 = 3;
+    ws2811LedDataTransferInProgress = 0;
+    ws2811UpdateStrip(LED_GRB);
+
+    // then
+    EXPECT_EQ(3, ledStripDMABuffer[0]);
+}
+
 extern "C" {
 rgbColor24bpp_t* hsvToRgb24(const hsvColor_t *c) {
-    UNUSED(c);
-    return NULL;
+    // the value is used as blue, which is enough to tell colours apart
+    static rgbColor24bpp_t rgb;
+    rgb.rgb.r = 0;
+    rgb.rgb.g = 0;
+    rgb.rgb.b = c->v;
+    return &rgb;
 }
 
 void ws2811LedStripHardwareInit(ioTag_t ioTag) {
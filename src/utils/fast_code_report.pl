@@ -0,0 +1,160 @@
+#!/usr/bin/perl
+use warnings;
+use strict;
+
+# This script reports what a target has placed in its fast memories, the ITCM RAM for code
+# (FAST_CODE) and the CCM or DTCM RAM for data (FAST_RAM), against the size of those memories.
+#
+# Given a profile it also ranks the functions that are not in ITCM yet by profiled time per
+# byte and picks the hottest set that fits into the free ITCM, as candidates for FAST_CODE.
+# The functions are built with LTO, which merges their sections, so the placement itself has
+# to be done with the FAST_CODE attribute rather than by the linker.
+#
+# usage: fast_code_report.pl <linker script> <elf> <nm> [<profile>]
+#
+# The profile is either the flat profile of a SITL build made with GPROF=yes,
+#   gprof -b -p obj/main/betaflight_SITL.elf gmon.out > profile.txt
+# or a list with one function name per line, hottest first.
+
+my ($ld_script, $elf, $nm, $profile) = @ARGV;
+die "usage: $0 <linker script> <elf> <nm> [<profile>]\n" unless defined $nm;
+
+my %size_units = ('' => 1, 'K' => 1024, 'M' => 1024 * 1024);
+
+# memory regions and aliases from the target's linker script
+my %regions;
+my %aliases;
+open(my $ld, '<', $ld_script) or die "can't open $ld_script: $!\n";
+while (<$ld>) {
+    if (/^\s*(\w+)\s*\([\w!]+\)\s*:\s*ORIGIN\s*=\s*\w+\s*,\s*LENGTH\s*=\s*(\d+)\s*([KM]?)/) {
+        $regions{$1} = $2 * $size_units{$3};
+    } elsif (/REGION_ALIAS\s*\(\s*"(\w+)"\s*,\s*(\w+)\s*\)/) {
+        $aliases{$1} = $2;
+    }
+}
+close($ld);
+
+sub region_size
+{
+    my ($name) = @_;
+    $name = $aliases{$name} if exists $aliases{$name};
+    return $regions{$name};
+}
+
+# symbols from the elf, address and size
+my %symbols;
+open(my $syms, '-|', $nm, '-S', '--defined-only', $elf) or die "can't run $nm: $!\n";
+while (<$syms>) {
+    if (/^([0-9a-fA-F]+)\s+(?:([0-9a-fA-F]+)\s+)?(\w)\s+(\S+)$/) {
+        $symbols{$4} = { addr => hex($1), size => defined $2 ? hex($2) : 0, type => $3 };
+    }
+}
+close($syms);
+
+sub symbols_between
+{
+    my ($start, $end) = @_;
+    return () unless exists $symbols{$start} && exists $symbols{$end};
+    my ($from, $to) = ($symbols{$start}{addr}, $symbols{$end}{addr});
+    return grep { $symbols{$_}{size} > 0 && $symbols{$_}{addr} >= $from && $symbols{$_}{addr} < $to } keys %symbols;
+}
+
+sub used_between
+{
+    my ($start, $end) = @_;
+    return 0 unless exists $symbols{$start} && exists $symbols{$end};
+    return $symbols{$end}{addr} - $symbols{$start}{addr};
+}
+
+sub report_usage
+{
+    my ($label, $used, $size) = @_;
+    if (defined $size) {
+        printf("%-14s %7d of %7d bytes (%d%%), %d free\n", $label, $used, $size, $used * 100 / $size, $size - $used);
+    } else {
+        printf("%-14s %7d bytes\n", $label, $used);
+    }
+}
+
+print "Fast memory usage\n";
+
+my $itcm_size = region_size('ITCM_RAM');
+my $tcm_used = used_between('tcm_code_start', 'tcm_code_end');
+my %in_tcm = map { $_ => 1 } symbols_between('tcm_code_start', 'tcm_code_end');
+if (defined $itcm_size) {
+    report_usage('FAST_CODE', $tcm_used, $itcm_size);
+}
+
+my $fastram_used = used_between('_sfastram_data', '_efastram_data') + used_between('_sfastram_bss', '_efastram_bss');
+if (exists $symbols{'_sfastram_data'}) {
+    report_usage('FAST_RAM', $fastram_used, region_size('FASTRAM'));
+}
+
+exit 0 unless defined $profile;
+
+if (!defined $itcm_size) {
+    print "No ITCM RAM on this target, FAST_CODE has no effect\n";
+    exit 0;
+}
+
+# profiled weight per function
+my %weight;
+open(my $prof, '<', $profile) or die "can't open $profile: $!\n";
+my @listed;
+while (<$prof>) {
+    if (/^\s*[\d.]+\s+[\d.]+\s+([\d.]+)\s+(?:\d+\s+[\d.]+\s+[\d.]+\s+)?([A-Za-z_]\w*)\s*$/) {
+        $weight{$2} += $1;
+    } elsif (/^\s*([A-Za-z_]\w*)\s*$/) {
+        push(@listed, $1);
+    }
+}
+close($prof);
+for my $i (0 .. $#listed) {
+    $weight{$listed[$i]} //= scalar(@listed) - $i;
+}
+
+my $total_weight = 0;
+$total_weight += $_ for values %weight;
+die "no functions in $profile\n" unless $total_weight > 0;
+
+my $placed_weight = 0;
+my @candidates;
+my @not_found;
+for my $name (keys %weight) {
+    next unless $weight{$name} > 0;
+    if ($in_tcm{$name}) {
+        $placed_weight += $weight{$name};
+    } elsif (exists $symbols{$name} && $symbols{$name}{type} =~ /^[tT]$/ && $symbols{$name}{size} > 0) {
+        push(@candidates, $name);
+    } else {
+        push(@not_found, $name);
+    }
+}
+
+printf("Profiled time in FAST_CODE now: %.1f%%\n", $placed_weight * 100 / $total_weight);
+
+# greedy by weight per byte, with a few bytes of alignment per function
+my $free = $itcm_size - $tcm_used;
+my $picked_weight = 0;
+my @picked;
+for my $name (sort { $weight{$b} / $symbols{$b}{size} <=> $weight{$a} / $symbols{$a}{size} || $a cmp $b } @candidates) {
+    my $size = ($symbols{$name}{size} + 3) & ~3;
+    next if $size > $free;
+    $free -= $size;
+    $picked_weight += $weight{$name};
+    push(@picked, $name);
+}
+
+if (@picked) {
+    print "Candidates for FAST_CODE, within the free ITCM:\n";
+    for my $name (@picked) {
+        printf("    %-40s %6d bytes %5.1f%%\n", $name, $symbols{$name}{size}, $weight{$name} * 100 / $total_weight);
+    }
+    printf("Profiled time in FAST_CODE with them: %.1f%%, %d bytes left\n", ($placed_weight + $picked_weight) * 100 / $total_weight, $free);
+} else {
+    print "No further function of the profile fits into the free ITCM\n";
+}
+
+if (@not_found) {
+    printf("%d profiled functions are inlined or not built for this target\n", scalar(@not_found));
+}